@@ -0,0 +1,30 @@
+#include "realdata.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    benchmark::Initialize(&argc, argv);
+
+    // Benchmarks on the files of a real archive are only run when one is given
+    if (const char* bsa = std::getenv("OPENMW_BENCHMARK_BSA"))
+    {
+        try
+        {
+            registerRealDataBenchmarks(bsa);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to load " << bsa << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <components/detournavigator/navigatorimpl.hpp>
+
+#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    using namespace DetourNavigator;
+
+    Settings makeSettings()
+    {
+        Settings settings;
+        settings.mEnableWriteRecastMeshToFile = false;
+        settings.mEnableWriteNavMeshToFile = false;
+        settings.mEnableRecastMeshFileNameRevision = false;
+        settings.mEnableNavMeshFileNameRevision = false;
+        settings.mBorderSize = 16;
+        settings.mCellHeight = 0.2f;
+        settings.mCellSize = 0.2f;
+        settings.mDetailSampleDist = 6;
+        settings.mDetailSampleMaxError = 1;
+        settings.mMaxClimb = 34;
+        settings.mMaxSimplificationError = 1.3f;
+        settings.mMaxSlope = 49;
+        settings.mRecastScaleFactor = 0.017647058823529415f;
+        settings.mSwimHeightScale = 0.89999997615814208984375f;
+        settings.mMaxEdgeLen = 12;
+        settings.mMaxNavMeshQueryNodes = 2048;
+        settings.mMaxVertsPerPoly = 6;
+        settings.mRegionMergeSize = 20;
+        settings.mRegionMinSize = 8;
+        settings.mTileSize = 64;
+        settings.mAsyncNavMeshUpdaterThreads = 1;
+        settings.mAsyncPathFinderThreads = 1;
+        settings.mMaxNavMeshTilesCacheSize = 0;
+        settings.mMaxPolygonPathSize = 1024;
+        settings.mMaxSmoothPathSize = 1024;
+        settings.mTrianglesPerChunk = 256;
+        settings.mMaxPolys = 4096;
+        settings.mMaxTilesNumber = 512;
+        return settings;
+    }
+
+    /// Rolling terrain of one exterior cell
+    struct Terrain
+    {
+        static const int sSize = 65;
+        std::vector<btScalar> mHeights;
+        btHeightfieldTerrainShape mShape;
+
+        Terrain()
+            : mHeights(makeHeights())
+            , mShape(sSize, sSize, mHeights.data(), 1, -512, 512, 2, PHY_FLOAT, false)
+        {
+            mShape.setLocalScaling(btVector3(128, 128, 1));
+        }
+
+        static float getHeight(int x, int y)
+        {
+            return 256 * std::sin(x * 0.2f) * std::cos(y * 0.15f);
+        }
+
+        /// Height of the terrain at the position, the heightfield is centered at the origin.
+        static float getHeight(float x, float y)
+        {
+            return getHeight(static_cast<int>(std::round(x / 128 + sSize / 2)),
+                             static_cast<int>(std::round(y / 128 + sSize / 2)));
+        }
+
+        static std::vector<btScalar> makeHeights()
+        {
+            std::vector<btScalar> heights(sSize * sSize);
+            for (int y = 0; y < sSize; ++y)
+                for (int x = 0; x < sSize; ++x)
+                    heights[y * sSize + x] = getHeight(x, y);
+            return heights;
+        }
+    };
+
+    const osg::Vec3f sAgentHalfExtents(29, 29, 66);
+
+    void generateNavMeshTiles(benchmark::State& state)
+    {
+        const Settings settings = makeSettings();
+        Terrain terrain;
+
+        for (auto _ : state)
+        {
+            NavigatorImpl navigator(settings);
+            navigator.addAgent(sAgentHalfExtents);
+            navigator.addObject(ObjectId(&terrain.mShape), terrain.mShape, btTransform::getIdentity());
+            navigator.update(osg::Vec3f(0, 0, 0));
+            navigator.wait();
+        }
+    }
+
+    void findPath(benchmark::State& state)
+    {
+        const Settings settings = makeSettings();
+        Terrain terrain;
+
+        NavigatorImpl navigator(settings);
+        navigator.addAgent(sAgentHalfExtents);
+        navigator.addObject(ObjectId(&terrain.mShape), terrain.mShape, btTransform::getIdentity());
+        navigator.update(osg::Vec3f(0, 0, 0));
+        navigator.wait();
+
+        const osg::Vec3f start(-3000, 3000, Terrain::getHeight(-3000.f, 3000.f));
+        const osg::Vec3f end(3000, -3000, Terrain::getHeight(3000.f, -3000.f));
+        const float stepSize = 28.333332061767578125f;
+        std::vector<osg::Vec3f> path;
+
+        for (auto _ : state)
+        {
+            path.clear();
+            try
+            {
+                navigator.findPath(sAgentHalfExtents, stepSize, start, end, Flag_walk, std::back_inserter(path));
+            }
+            catch (const std::exception& e)
+            {
+                state.SkipWithError(e.what());
+                break;
+            }
+            benchmark::DoNotOptimize(path.data());
+        }
+    }
+}
+
+BENCHMARK(generateNavMeshTiles)->Unit(benchmark::kMillisecond);
+BENCHMARK(findPath)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,85 @@
+#include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/esm/loadnpc.hpp>
+#include <components/esm/loadstat.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+namespace
+{
+    /// Content file with as many NPCs and statics as the given number each.
+    std::string makeEsmFile(int count)
+    {
+        std::ostringstream stream;
+        ESM::ESMWriter writer;
+        writer.setFormat(0);
+        writer.setRecordCount(2 * count);
+        writer.save(stream);
+
+        for (int i = 0; i < count; ++i)
+        {
+            ESM::NPC npc;
+            npc.blank();
+            npc.mId = "benchmark_npc_" + std::to_string(i);
+            npc.mName = "Benchmark NPC";
+            npc.mRace = "Dark Elf";
+            npc.mClass = "Guard";
+            npc.mHead = "b_n_dark elf_m_head_01";
+            npc.mHair = "b_n_dark elf_m_hair_01";
+            writer.startRecord(ESM::NPC::sRecordId);
+            npc.save(writer);
+            writer.endRecord(ESM::NPC::sRecordId);
+
+            ESM::Static object;
+            object.mId = "benchmark_static_" + std::to_string(i);
+            object.mModel = "x\\ex_hlaalu_bridge_01.nif";
+            writer.startRecord(ESM::Static::sRecordId);
+            object.save(writer);
+            writer.endRecord(ESM::Static::sRecordId);
+        }
+
+        writer.close();
+        return stream.str();
+    }
+
+    void loadEsmRecords(benchmark::State& state)
+    {
+        const std::string data = makeEsmFile(static_cast<int>(state.range(0)));
+        ToUTF8::Utf8Encoder encoder(ToUTF8::WINDOWS_1252);
+
+        for (auto _ : state)
+        {
+            ESM::ESMReader reader;
+            reader.setEncoder(&encoder);
+            reader.open(Files::IStreamPtr(new std::istringstream(data)), "benchmark.esp");
+
+            while (reader.hasMoreRecs())
+            {
+                const ESM::NAME name = reader.getRecName();
+                reader.getRecHeader();
+                bool isDeleted = false;
+                if (name.intval == ESM::REC_NPC_)
+                {
+                    ESM::NPC npc;
+                    npc.load(reader, isDeleted);
+                    benchmark::DoNotOptimize(npc.mId.data());
+                }
+                else if (name.intval == ESM::REC_STAT)
+                {
+                    ESM::Static object;
+                    object.load(reader, isDeleted);
+                    benchmark::DoNotOptimize(object.mId.data());
+                }
+                else
+                    reader.skipRecord();
+            }
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+        state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+    }
+}
+
+BENCHMARK(loadEsmRecords)->Arg(1000)->Arg(10000);
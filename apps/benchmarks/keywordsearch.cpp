@@ -0,0 +1,47 @@
+#include "apps/openmw/mwdialogue/keywordsearch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef MWDialogue::KeywordSearch<std::string, int> Search;
+
+    void seedKeywords(Search& search)
+    {
+        // Topics look like this, with many sharing their first words
+        const char* const words[] = {"vivec", "the", "dwemer", "ruins", "latest", "rumors", "little", "advice",
+                                     "someone", "in", "particular", "services", "great", "house", "redoran"};
+        int value = 0;
+        for (const char* first : words)
+        {
+            search.seed(first, value++);
+            for (const char* second : words)
+                search.seed(std::string(first) + " " + second, value++);
+        }
+    }
+
+    void highlightKeywords(benchmark::State& state)
+    {
+        Search search;
+        seedKeywords(search);
+
+        std::string text;
+        while (text.size() < 4096)
+            text += "I have heard the latest rumors about the dwemer ruins near Vivec, but little advice for someone "
+                    "in particular who seeks the services of Great House Redoran. ";
+
+        std::vector<Search::Match> matches;
+        for (auto _ : state)
+        {
+            matches.clear();
+            search.highlightKeywords(text.begin(), text.end(), matches);
+            benchmark::DoNotOptimize(matches.data());
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+    }
+}
+
+BENCHMARK(highlightKeywords);
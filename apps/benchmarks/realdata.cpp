@@ -0,0 +1,131 @@
+#include "realdata.hpp"
+
+#include <components/bsa/bsa_file.hpp>
+#include <components/nif/niffile.hpp>
+#include <components/nifosg/nifloader.hpp>
+#include <components/resource/imagemanager.hpp>
+#include <components/vfs/bsaarchive.hpp>
+#include <components/vfs/manager.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <osg/Node>
+
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Enough models to average over different kinds of meshes while keeping an iteration short
+    constexpr std::size_t sMaxModels = 200;
+
+    struct RealData
+    {
+        Bsa::BSAFile mBsa;
+        VFS::Manager mVfs {false};
+        std::vector<std::string> mFileNames;
+        std::vector<std::string> mModels;
+        std::unique_ptr<Resource::ImageManager> mImageManager;
+
+        explicit RealData(const std::string& bsaPath)
+        {
+            mBsa.open(bsaPath);
+            for (const auto& file : mBsa.getList())
+                mFileNames.emplace_back(file.name);
+            if (mFileNames.empty())
+                throw std::runtime_error("the archive contains no files");
+
+            mVfs.addArchive(new VFS::BsaArchive(bsaPath));
+            mVfs.buildIndex();
+            for (const auto& file : mVfs.getIndex())
+            {
+                const std::string& name = file.first;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".nif") == 0)
+                    mModels.push_back(name);
+                if (mModels.size() == sMaxModels)
+                    break;
+            }
+
+            mImageManager.reset(new Resource::ImageManager(&mVfs));
+        }
+    };
+
+    void findInBsa(benchmark::State& state, RealData& data)
+    {
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(data.mBsa.exists(data.mFileNames[i].c_str()));
+            i = (i + 1) % data.mFileNames.size();
+        }
+    }
+
+    void readFromBsa(benchmark::State& state, RealData& data)
+    {
+        std::size_t i = 0;
+        std::vector<char> buffer;
+        for (auto _ : state)
+        {
+            const Files::IStreamPtr stream = data.mBsa.getFile(data.mFileNames[i].c_str());
+            buffer.assign(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+            benchmark::DoNotOptimize(buffer.data());
+            i = (i + 1) % data.mFileNames.size();
+        }
+    }
+
+    void parseNif(benchmark::State& state, RealData& data)
+    {
+        if (data.mModels.empty())
+        {
+            state.SkipWithError("the archive contains no models");
+            return;
+        }
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const std::string& name = data.mModels[i];
+            Nif::NIFFile file(data.mVfs.getNormalized(name), name);
+            benchmark::DoNotOptimize(&file);
+            i = (i + 1) % data.mModels.size();
+        }
+    }
+
+    void convertNifToOsg(benchmark::State& state, RealData& data)
+    {
+        if (data.mModels.empty())
+        {
+            state.SkipWithError("the archive contains no models");
+            return;
+        }
+        std::vector<Nif::NIFFilePtr> files;
+        for (const auto& name : data.mModels)
+            files.push_back(std::make_shared<Nif::NIFFile>(data.mVfs.getNormalized(name), name));
+        // Load the textures once, so only the conversion is measured and not the image decoding
+        for (const auto& file : files)
+            NifOsg::Loader::load(file, data.mImageManager.get());
+
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            const osg::ref_ptr<osg::Node> node = NifOsg::Loader::load(files[i], data.mImageManager.get());
+            benchmark::DoNotOptimize(node.get());
+            i = (i + 1) % files.size();
+        }
+    }
+}
+
+void registerRealDataBenchmarks(const std::string& bsaPath)
+{
+    // Shared by the benchmarks and kept until the process exits
+    RealData* const data = new RealData(bsaPath);
+
+    benchmark::RegisterBenchmark("findInBsa", [=] (benchmark::State& state) { findInBsa(state, *data); });
+    benchmark::RegisterBenchmark("readFromBsa", [=] (benchmark::State& state) { readFromBsa(state, *data); });
+    benchmark::RegisterBenchmark("parseNif", [=] (benchmark::State& state) { parseNif(state, *data); })
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("convertNifToOsg", [=] (benchmark::State& state) { convertNifToOsg(state, *data); })
+        ->Unit(benchmark::kMicrosecond);
+}
@@ -0,0 +1,10 @@
+#ifndef OPENMW_BENCHMARKS_REALDATA_H
+#define OPENMW_BENCHMARKS_REALDATA_H
+
+#include <string>
+
+/// Register the benchmarks reading the files of the given BSA archive, i.e. Morrowind.bsa.
+/// @throw std::runtime_error if the archive can't be opened
+void registerRealDataBenchmarks(const std::string& bsaPath);
+
+#endif
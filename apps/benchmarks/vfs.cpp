@@ -0,0 +1,83 @@
+#include <components/vfs/archive.hpp>
+#include <components/vfs/manager.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    struct TestFile : VFS::File
+    {
+        Files::IStreamPtr open() override
+        {
+            return Files::IStreamPtr(new std::istringstream());
+        }
+    };
+
+    struct TestArchive : VFS::Archive
+    {
+        std::vector<std::string> mNames;
+        std::vector<TestFile> mFiles;
+
+        TestArchive(const std::vector<std::string>& names)
+            : mNames(names)
+            , mFiles(names.size())
+        {
+        }
+
+        void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char)) override
+        {
+            for (std::size_t i = 0; i < mNames.size(); ++i)
+            {
+                std::string name = mNames[i];
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &mFiles[i];
+            }
+        }
+    };
+
+    // About as many files as there are in Morrowind.bsa
+    std::vector<std::string> makeNames()
+    {
+        std::vector<std::string> names;
+        for (int i = 0; i < 6000; ++i)
+            names.push_back("Meshes\\x\\Ex_Hlaalu_Bridge_" + std::to_string(i) + ".NIF");
+        return names;
+    }
+
+    void getFromVfsManager(benchmark::State& state)
+    {
+        const std::vector<std::string> names = makeNames();
+        VFS::Manager manager(false);
+        manager.addArchive(new TestArchive(names));
+        manager.buildIndex();
+
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(manager.get(names[i]));
+            i = (i + 1) % names.size();
+        }
+    }
+
+    void existsInVfsManager(benchmark::State& state)
+    {
+        const std::vector<std::string> names = makeNames();
+        VFS::Manager manager(false);
+        manager.addArchive(new TestArchive(names));
+        manager.buildIndex();
+
+        std::size_t i = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(manager.exists(names[i]));
+            i = (i + 1) % names.size();
+        }
+    }
+}
+
+BENCHMARK(getFromVfsManager);
+BENCHMARK(existsInVfsManager);
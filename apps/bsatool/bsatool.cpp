@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 #include <boost/program_options.hpp>
@@ -7,6 +12,7 @@
 #include <boost/filesystem/fstream.hpp>
 
 #include <components/bsa/bsa_file.hpp>
+#include <components/bsa/bsa_writer.hpp>
 
 #define BSATOOL_VERSION 1.1
 
@@ -20,9 +26,11 @@ struct Arguments
     std::string filename;
     std::string extractfile;
     std::string outdir;
+    std::string orderfile;
 
     bool longformat;
     bool fullpath;
+    unsigned int threads;
 };
 
 void replaceAll(std::string& str, const std::string& needle, const std::string& substitute)
@@ -43,8 +51,10 @@ bool parseOptions (int argc, char** argv, Arguments &info)
             "      List the files presents in the input archive.\n\n"
             "  bsatool extract [-f] archivefile [file_to_extract] [output_directory]\n"
             "      Extract a file from the input archive.\n\n"
-            "  bsatool extractall archivefile [output_directory]\n"
+            "  bsatool extractall [-j threads] archivefile [output_directory]\n"
             "      Extract all files from the input archive.\n\n"
+            "  bsatool create [-o order_file] archivefile source_directory\n"
+            "      Create an archive from all files in the source directory.\n\n"
             "Allowed options");
 
     desc.add_options()
@@ -53,6 +63,11 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         ("long,l", "Include extra information in archive listing.")
         ("full-path,f", "Create directory hierarchy on file extraction "
          "(always true for extractall).")
+        ("threads,j", bpo::value<unsigned int>(), "Number of files extracted at the same time "
+         "by extractall (default: number of hardware threads).")
+        ("order,o", bpo::value<std::string>(), "File listing archive paths one per line, e.g. the meshes "
+         "and textures used by each cell. On create, their data is stored first and in this order, "
+         "so files used together are read in one go.")
         ;
 
     // input-file is hidden and used as a positional argument
@@ -104,7 +119,7 @@ bool parseOptions (int argc, char** argv, Arguments &info)
     }
 
     info.mode = variables["mode"].as<std::string>();
-    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall"))
+    if (!(info.mode == "list" || info.mode == "extract" || info.mode == "extractall" || info.mode == "create"))
     {
         std::cout << std::endl << "ERROR: invalid mode \"" << info.mode << "\"\n\n"
             << desc << std::endl;
@@ -135,18 +150,36 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         if (variables["input-file"].as< std::vector<std::string> >().size() > 2)
             info.outdir = variables["input-file"].as< std::vector<std::string> >()[2];
     }
+    else if (info.mode == "create")
+    {
+        if (variables["input-file"].as< std::vector<std::string> >().size() < 2)
+        {
+            std::cout << "\nERROR: source directory unspecified\n\n"
+                << desc << std::endl;
+            return false;
+        }
+        info.outdir = variables["input-file"].as< std::vector<std::string> >()[1];
+    }
     else if (variables["input-file"].as< std::vector<std::string> >().size() > 1)
         info.outdir = variables["input-file"].as< std::vector<std::string> >()[1];
 
     info.longformat = variables.count("long") != 0;
     info.fullpath = variables.count("full-path") != 0;
 
+    info.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (variables.count("threads"))
+        info.threads = std::max(1u, variables["threads"].as<unsigned int>());
+
+    if (variables.count("order"))
+        info.orderfile = variables["order"].as<std::string>();
+
     return true;
 }
 
 int list(Bsa::BSAFile& bsa, Arguments& info);
 int extract(Bsa::BSAFile& bsa, Arguments& info);
 int extractAll(Bsa::BSAFile& bsa, Arguments& info);
+int create(Arguments& info);
 
 int main(int argc, char** argv)
 {
@@ -156,9 +189,12 @@ int main(int argc, char** argv)
         if(!parseOptions (argc, argv, info))
             return 1;
 
+        if (info.mode == "create")
+            return create(info);
+
         // Open file
         Bsa::BSAFile bsa;
-        bsa.open(info.filename);
+        bsa.open(info.filename, true);
 
         if (info.mode == "list")
             return list(bsa, info);
@@ -253,20 +289,25 @@ int extract(Bsa::BSAFile& bsa, Arguments& info)
 int extractAll(Bsa::BSAFile& bsa, Arguments& info)
 {
     // Get the list of files present in the archive
-    Bsa::BSAFile::FileList list = bsa.getList();
-
-    // Iter on the list
-    for(Bsa::BSAFile::FileList::iterator it = list.begin(); it != list.end(); ++it) {
-        const char* archivePath = it->name;
+    const Bsa::BSAFile::FileList& list = bsa.getList();
 
-        std::string extractPath (archivePath);
+    // Create the directory hierarchy first, so the threads only write files
+    std::vector<bfs::path> targets;
+    targets.reserve(list.size());
+    std::set<bfs::path> directories;
+    for (const Bsa::BSAFile::FileStruct& file : list)
+    {
+        std::string extractPath (file.name);
         replaceAll(extractPath, "\\", "/");
 
         // Get the target path (the path the file will be extracted to)
         bfs::path target (info.outdir);
         target /= extractPath;
+        targets.push_back(target);
+
+        if (!directories.insert(target.parent_path()).second)
+            continue;
 
-        // Create the directory hierarchy
         bfs::create_directories(target.parent_path());
 
         bfs::file_status s = bfs::status(target.parent_path());
@@ -275,17 +316,114 @@ int extractAll(Bsa::BSAFile& bsa, Arguments& info)
             std::cout << "ERROR: " << target.parent_path() << " is not a directory." << std::endl;
             return 3;
         }
+    }
+
+    std::atomic<std::size_t> next (0);
+    std::mutex mutex; // for the output and errors
+    std::string error;
+
+    auto extractFiles = [&] ()
+    {
+        for (std::size_t i = next++; i < list.size(); i = next++)
+        {
+            try
+            {
+                Files::IStreamPtr data = bsa.getFile(&list[i]);
+                bfs::ofstream out(targets[i], std::ios::binary);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error.empty())
+                        return;
+                    std::cout << "Extracting " << targets[i] << std::endl;
+                }
+
+                // Write the file to disk
+                if (list[i].fileSize > 0)
+                    out << data->rdbuf();
+                out.close();
+
+                if (!out)
+                    throw std::runtime_error("failed to write " + targets[i].string());
+            }
+            catch (const std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (error.empty())
+                    error = e.what();
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const std::size_t numThreads = std::min<std::size_t>(info.threads, list.size());
+    for (std::size_t i = 1; i < numThreads; ++i)
+        threads.emplace_back(extractFiles);
+
+    extractFiles();
 
-        // Get a stream for the file to extract
-        // (inefficient because getFile iter on the list again)
-        Files::IStreamPtr data = bsa.getFile(archivePath);
-        bfs::ofstream out(target, std::ios::binary);
+    for (std::thread& thread : threads)
+        thread.join();
 
-        // Write the file to disk
-        std::cout << "Extracting " << target << std::endl;
-        out << data->rdbuf();
-        out.close();
+    if (!error.empty())
+    {
+        std::cout << "ERROR: " << error << std::endl;
+        return 3;
     }
 
     return 0;
 }
+
+int create(Arguments& info)
+{
+    bfs::path source (info.outdir);
+    if (!bfs::is_directory(source))
+    {
+        std::cout << "ERROR: " << source << " is not a directory." << std::endl;
+        return 3;
+    }
+
+    Bsa::BSAWriter writer;
+    std::size_t count = 0;
+
+    for (bfs::recursive_directory_iterator it (source), end; it != end; ++it)
+    {
+        if (!bfs::is_regular_file(it->status()))
+            continue;
+
+        std::string name = it->path().string().substr(source.string().size());
+        replaceAll(name, "/", "\\");
+        name.erase(0, name.find_first_not_of('\\'));
+
+        writer.addFile(name, it->path());
+        ++count;
+    }
+
+    if (!info.orderfile.empty())
+    {
+        bfs::ifstream order (info.orderfile);
+        if (!order.is_open())
+        {
+            std::cout << "ERROR: failed to open " << info.orderfile << std::endl;
+            return 3;
+        }
+
+        std::vector<std::string> names;
+        std::string line;
+        while (std::getline(order, line))
+        {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (!line.empty())
+                names.push_back(line);
+        }
+
+        writer.setDataOrder(names);
+    }
+
+    std::cout << "Creating " << info.filename << " from " << count << " files" << std::endl;
+    writer.save(info.filename);
+
+    return 0;
+}
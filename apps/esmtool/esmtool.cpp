@@ -14,6 +14,7 @@
 #include <components/esm/records.hpp>
 
 #include "record.hpp"
+#include "rawrecords.hpp"
 
 #define ESMTOOL_VERSION 1.2
 
@@ -57,6 +58,7 @@ struct Arguments
     bool plain_given;
 
     std::string mode;
+    std::string format;
     std::string encoding;
     std::string filename;
     std::string outname;
@@ -71,7 +73,7 @@ struct Arguments
 
 bool parseOptions (int argc, char** argv, Arguments &info)
 {
-    bpo::options_description desc("Inspect and extract from Morrowind ES files (ESM, ESP, ESS)\nSyntax: esmtool [options] mode infile [outfile]\nAllowed modes:\n  dump\t Dumps all readable data from the input file.\n  clone\t Clones the input file to the output file.\n  comp\t Compares the given files.\n\nAllowed options");
+    bpo::options_description desc("Inspect and extract from Morrowind ES files (ESM, ESP, ESS)\nSyntax: esmtool [options] mode infile [outfile]\nAllowed modes:\n  dump\t Dumps all readable data from the input file.\n  clone\t Clones the input file to the output file.\n  comp\t Compares the given files.\n  diff\t Lists the records that differ between the given files.\n\nAllowed options");
 
     desc.add_options()
         ("help,h", "print help message.")
@@ -87,6 +89,9 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         ("plain,p", "Print contents of dialogs, books and scripts. "
          "(skipped by default)"
          "Only affects dump mode.")
+        ("format,f", bpo::value<std::string>(),
+         "Dump the records as they are read without parsing them, as json or csv, "
+         "with hashes of their subrecords. Only affects dump mode.")
         ("quiet,q", "Supress all record information. Useful for speed tests.")
         ("loadcells,C", "Browse through contents of all cells.")
 
@@ -152,9 +157,18 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         info.types = variables["type"].as< std::vector<std::string> >();
     if (variables.count("name") > 0)
         info.name = variables["name"].as<std::string>();
+    if (variables.count("format") > 0)
+    {
+        info.format = variables["format"].as<std::string>();
+        if (info.format != "json" && info.format != "csv")
+        {
+            std::cout << "ERROR: invalid format \"" << info.format << "\"" << std::endl;
+            return false;
+        }
+    }
 
     info.mode = variables["mode"].as<std::string>();
-    if (!(info.mode == "dump" || info.mode == "clone" || info.mode == "comp"))
+    if (!(info.mode == "dump" || info.mode == "clone" || info.mode == "comp" || info.mode == "diff"))
     {
         std::cout << std::endl << "ERROR: invalid mode \"" << info.mode << "\"" << std::endl << std::endl
                   << desc << finalText << std::endl;
@@ -192,7 +206,11 @@ bool parseOptions (int argc, char** argv, Arguments &info)
         std::cout << info.encoding << " is not a valid encoding option." << std::endl;
         info.encoding = "win1252";
     }
-    std::cout << ToUTF8::encodingUsingMessage(info.encoding) << std::endl;
+    // Keep the standard output machine readable
+    if (info.mode == "diff" || !info.format.empty())
+        std::cerr << ToUTF8::encodingUsingMessage(info.encoding) << std::endl;
+    else
+        std::cout << ToUTF8::encodingUsingMessage(info.encoding) << std::endl;
 
     return true;
 }
@@ -201,8 +219,10 @@ void printRaw(ESM::ESMReader &esm);
 void loadCell(ESM::Cell &cell, ESM::ESMReader &esm, Arguments& info);
 
 int load(Arguments& info);
+int dump(Arguments& info);
 int clone(Arguments& info);
 int comp(Arguments& info);
+int diff(Arguments& info);
 
 int main(int argc, char**argv)
 {
@@ -213,11 +233,13 @@ int main(int argc, char**argv)
             return 1;
 
         if (info.mode == "dump")
-            return load(info);
+            return info.format.empty() ? load(info) : dump(info);
         else if (info.mode == "clone")
             return clone(info);
         else if (info.mode == "comp")
             return comp(info);
+        else if (info.mode == "diff")
+            return diff(info);
         else
         {
             std::cout << "Invalid or no mode specified, dying horribly. Have a nice day." << std::endl;
@@ -416,6 +438,17 @@ int load(Arguments& info)
     return 0;
 }
 
+int dump(Arguments& info)
+{
+    ToUTF8::Utf8Encoder encoder (ToUTF8::calculateEncoding(info.encoding));
+    EsmTool::RawRecordReader reader(info.filename, encoder);
+
+    EsmTool::dumpRecords(reader, info.format == "json" ? EsmTool::DumpFormat::Json : EsmTool::DumpFormat::Csv,
+        info.types, info.name, std::cout);
+
+    return 0;
+}
+
 #include <iomanip>
 
 int clone(Arguments& info)
@@ -551,3 +584,19 @@ int comp(Arguments& info)
 
     return 0;
 }
+
+int diff(Arguments& info)
+{
+    if (info.filename.empty() || info.outname.empty())
+    {
+        std::cerr << "You need to specify two input files" << std::endl;
+        return 2;
+    }
+
+    ToUTF8::Utf8Encoder encoder (ToUTF8::calculateEncoding(info.encoding));
+    size_t differences = EsmTool::diffRecords(info.filename, info.outname, encoder, std::cout);
+
+    std::cerr << differences << " records differ" << std::endl;
+
+    return differences == 0 ? 0 : 1;
+}
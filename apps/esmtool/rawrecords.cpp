@@ -0,0 +1,320 @@
+#include "rawrecords.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+
+#include <components/esm/defs.hpp>
+#include <components/misc/keyhasher.hpp>
+#include <components/misc/stringops.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace
+{
+    int32_t getInt(const std::vector<char>& data, size_t index)
+    {
+        int32_t value = 0;
+        if (data.size() >= (index + 1) * sizeof(value))
+            std::memcpy(&value, data.data() + index * sizeof(value), sizeof(value));
+        return value;
+    }
+
+    std::string formatGrid(int32_t x, int32_t y)
+    {
+        std::ostringstream stream;
+        stream << "(" << x << ", " << y << ")";
+        return stream.str();
+    }
+
+    void writeJsonString(const std::string& text, std::ostream& out)
+    {
+        out << '"';
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\r': out << "\\r"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char escaped[7];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                        out << escaped;
+                    }
+                    else
+                        out << c;
+            }
+        }
+        out << '"';
+    }
+
+    void writeCsvString(const std::string& text, std::ostream& out)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string::npos)
+        {
+            out << text;
+            return;
+        }
+
+        out << '"';
+        for (char c : text)
+        {
+            if (c == '"')
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    }
+
+    void writeJson(const EsmTool::RawRecord& record, bool first, std::ostream& out)
+    {
+        out << (first ? "\n" : ",\n") << "{\"type\": ";
+        writeJsonString(record.mType.toString(), out);
+        out << ", \"id\": ";
+        writeJsonString(record.mId, out);
+        out << ", \"flags\": " << record.mFlags << ", \"offset\": " << record.mOffset << ", \"size\": " << record.mSize
+            << ", \"hash\": \"" << record.mHash << "\", \"subrecords\": [";
+
+        for (size_t i = 0; i < record.mSubRecords.size(); ++i)
+        {
+            const EsmTool::RawSubRecord& subRecord = record.mSubRecords[i];
+            if (i > 0)
+                out << ", ";
+            out << "{\"name\": ";
+            writeJsonString(subRecord.mName.toString(), out);
+            out << ", \"size\": " << subRecord.mSize << ", \"hash\": \"" << subRecord.mHash << "\"}";
+        }
+
+        out << "]}";
+    }
+
+    void writeCsv(const EsmTool::RawRecord& record, std::ostream& out)
+    {
+        writeCsvString(record.mType.toString(), out);
+        out << ',';
+        writeCsvString(record.mId, out);
+        out << ',' << record.mFlags << ',' << record.mOffset << ',' << record.mSize << ','
+            << record.mSubRecords.size() << ',' << record.mHash << '\n';
+    }
+
+    std::string getKey(const EsmTool::RawRecord& record, std::unordered_map<std::string, size_t>& occurrences)
+    {
+        std::string key = record.mType.toString() + " '" + record.mId + "'";
+
+        // Records with the same key are matched in the order they appear in
+        size_t occurrence = occurrences[key]++;
+        if (occurrence > 0)
+        {
+            std::ostringstream stream;
+            stream << key << " #" << occurrence + 1;
+            return stream.str();
+        }
+
+        return key;
+    }
+}
+
+namespace EsmTool
+{
+    RawRecordReader::RawRecordReader(const std::string& filename, ToUTF8::Utf8Encoder& encoder)
+        : mEncoder(encoder)
+    {
+        mReader.openRaw(filename);
+    }
+
+    std::string RawRecordReader::getString() const
+    {
+        size_t size = std::find(mBuffer.begin(), mBuffer.end(), '\0') - mBuffer.begin();
+        return mEncoder.getUtf8(mBuffer.data(), size);
+    }
+
+    bool RawRecordReader::next(RawRecord& record)
+    {
+        if (!mReader.hasMoreRecs())
+            return false;
+
+        record.mOffset = mReader.getFileOffset();
+        record.mType = mReader.getRecName();
+        mReader.getRecHeader(record.mFlags);
+        record.mId.clear();
+        record.mSubRecords.clear();
+
+        // Most records are identified by their NAME, the others by the subrecords below
+        const char* idName = "NAME";
+        bool isIndex = false;
+        switch (record.mType.intval)
+        {
+            case ESM::REC_INFO: idName = "INAM"; break;
+            case ESM::REC_SKIL:
+            case ESM::REC_MGEF: idName = "INDX"; isIndex = true; break;
+            case ESM::REC_LAND: idName = "INTV"; break;
+            default: break;
+        }
+
+        bool hasId = false;
+        bool hasGrid = false;
+        int32_t gridX = 0;
+        int32_t gridY = 0;
+
+        Misc::KeyHasher recordHash;
+
+        while (mReader.hasMoreSubs())
+        {
+            mReader.getSubName();
+            mReader.getSubHeader();
+
+            RawSubRecord subRecord;
+            subRecord.mName = mReader.retSubName();
+            subRecord.mSize = mReader.getSubSize();
+
+            mBuffer.resize(subRecord.mSize);
+            if (subRecord.mSize > 0)
+                mReader.getExact(mBuffer.data(), subRecord.mSize);
+
+            Misc::KeyHasher hash;
+            hash.add(mBuffer.data(), mBuffer.size());
+            subRecord.mHash = hash.getKey();
+
+            recordHash.add(subRecord.mName.intval);
+            recordHash.add(subRecord.mSize);
+            recordHash.add(mBuffer.data(), mBuffer.size());
+
+            if (!hasId && subRecord.mName == idName)
+            {
+                hasId = true;
+                if (record.mType.intval == ESM::REC_LAND)
+                    record.mId = formatGrid(getInt(mBuffer, 0), getInt(mBuffer, 1));
+                else if (isIndex)
+                    record.mId = std::to_string(getInt(mBuffer, 0));
+                else
+                    record.mId = getString();
+            }
+
+            if (!hasGrid && subRecord.mName == "DATA")
+            {
+                // Exterior cells and pathgrids are only told apart by their coordinates
+                if (record.mType.intval == ESM::REC_CELL && !(getInt(mBuffer, 0) & 1))
+                {
+                    hasGrid = true;
+                    gridX = getInt(mBuffer, 1);
+                    gridY = getInt(mBuffer, 2);
+                }
+                else if (record.mType.intval == ESM::REC_PGRD)
+                {
+                    hasGrid = true;
+                    gridX = getInt(mBuffer, 0);
+                    gridY = getInt(mBuffer, 1);
+                }
+            }
+
+            record.mSubRecords.push_back(subRecord);
+        }
+
+        if (hasGrid)
+            record.mId += (record.mId.empty() ? "" : " ") + formatGrid(gridX, gridY);
+
+        record.mSize = mReader.getFileOffset() - record.mOffset;
+        record.mHash = recordHash.getKey();
+
+        return true;
+    }
+
+    void dumpRecords(RawRecordReader& reader, DumpFormat format, const std::vector<std::string>& types,
+        const std::string& name, std::ostream& out)
+    {
+        if (format == DumpFormat::Json)
+            out << '[';
+        else
+            out << "type,id,flags,offset,size,subrecords,hash\n";
+
+        bool first = true;
+        RawRecord record;
+        while (reader.next(record))
+        {
+            if (!types.empty() && std::find(types.begin(), types.end(), record.mType.toString()) == types.end())
+                continue;
+
+            if (!name.empty() && !Misc::StringUtils::ciEqual(name, record.mId))
+                continue;
+
+            if (format == DumpFormat::Json)
+                writeJson(record, first, out);
+            else
+                writeCsv(record, out);
+
+            first = false;
+        }
+
+        if (format == DumpFormat::Json)
+            out << "\n]\n";
+
+        out.flush();
+    }
+
+    size_t diffRecords(const std::string& first, const std::string& second, ToUTF8::Utf8Encoder& encoder,
+        std::ostream& out)
+    {
+        struct Entry
+        {
+            std::string mHash;
+            bool mMatched;
+        };
+
+        std::unordered_map<std::string, Entry> entries;
+        std::vector<std::string> keys; // in the order of the first file
+        std::unordered_map<std::string, size_t> occurrences;
+        RawRecord record;
+
+        RawRecordReader firstReader(first, encoder);
+        while (firstReader.next(record))
+        {
+            std::string key = getKey(record, occurrences);
+            entries[key] = Entry {record.mHash, false};
+            keys.push_back(key);
+        }
+
+        size_t differences = 0;
+        occurrences.clear();
+
+        RawRecordReader secondReader(second, encoder);
+        while (secondReader.next(record))
+        {
+            std::string key = getKey(record, occurrences);
+            std::unordered_map<std::string, Entry>::iterator entry = entries.find(key);
+
+            if (entry == entries.end())
+            {
+                out << "added   " << key << '\n';
+                ++differences;
+                continue;
+            }
+
+            entry->second.mMatched = true;
+
+            if (entry->second.mHash != record.mHash)
+            {
+                out << "changed " << key << '\n';
+                ++differences;
+            }
+        }
+
+        for (const std::string& key : keys)
+        {
+            if (!entries[key].mMatched)
+            {
+                out << "removed " << key << '\n';
+                ++differences;
+            }
+        }
+
+        out.flush();
+        return differences;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef OPENMW_ESMTOOL_RAWRECORDS_H
+#define OPENMW_ESMTOOL_RAWRECORDS_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <components/esm/esmreader.hpp>
+
+namespace ToUTF8
+{
+    class Utf8Encoder;
+}
+
+namespace EsmTool
+{
+    struct RawSubRecord
+    {
+        ESM::NAME mName;
+        uint32_t mSize;
+        std::string mHash;
+    };
+
+    struct RawRecord
+    {
+        ESM::NAME mType;
+        uint32_t mFlags;
+        size_t mOffset;
+        size_t mSize; // including the record header
+        std::string mId; // empty for records without an ID
+        std::string mHash; // of the names and data of all subrecords
+        std::vector<RawSubRecord> mSubRecords;
+    };
+
+    /// @brief Reads the records of a file one at a time without parsing them, so only the
+    /// current record is kept in memory.
+    class RawRecordReader
+    {
+    public:
+        RawRecordReader(const std::string& filename, ToUTF8::Utf8Encoder& encoder);
+
+        /// @return false at the end of the file
+        bool next(RawRecord& record);
+
+    private:
+        ESM::ESMReader mReader;
+        ToUTF8::Utf8Encoder& mEncoder;
+        std::vector<char> mBuffer;
+
+        std::string getString() const;
+    };
+
+    enum class DumpFormat
+    {
+        Json,
+        Csv
+    };
+
+    /// Write the records of the file to @a out as they are read.
+    /// @param types Only records of these types, all if empty
+    /// @param name Only records with this ID (case insensitive), all if empty
+    void dumpRecords(RawRecordReader& reader, DumpFormat format, const std::vector<std::string>& types,
+        const std::string& name, std::ostream& out);
+
+    /// Compare the records of two files by the hashes of their subrecords, matching them by type and ID.
+    /// Only the hashes of the first file are kept in memory.
+    /// @return Number of records that were added, removed or changed
+    size_t diffRecords(const std::string& first, const std::string& second, ToUTF8::Utf8Encoder& encoder,
+        std::ostream& out);
+}
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <thread>
 
 #include <osgDB/WriteFile>
 
@@ -17,11 +18,11 @@
 namespace
 {
 
-    void convertImage(char* data, int size, int width, int height, GLenum pf, const std::string& out)
+    void convertImage(const std::vector<unsigned int>& data, int width, int height, GLenum pf, const std::string& out)
     {
         osg::ref_ptr<osg::Image> image (new osg::Image);
         image->allocateImage(width, height, 1, pf, GL_UNSIGNED_BYTE);
-        memcpy(image->data(), data, size);
+        memcpy(image->data(), &data[0], data.size()*sizeof(unsigned int));
         image->flipVertical();
 
         osgDB::writeImageFile(*image, out);
@@ -114,11 +115,21 @@ namespace ESSImport
 
         // to match openmw size
         // FIXME: filtering?
-        mGlobalMapImage->scaleImage(maph.size*2, maph.size*2, 1, GL_UNSIGNED_BYTE);
+        // Scaled while the rest of the file is read
+        osg::ref_ptr<osg::Image> image = mGlobalMapImage;
+        int size = maph.size*2;
+        mScaleGlobalMap = std::async(std::launch::async, [image, size] {
+            image->scaleImage(size, size, 1, GL_UNSIGNED_BYTE);
+        });
     }
 
-    void ConvertFMAP::write(ESM::ESMWriter &esm)
+    void ConvertFMAP::prepareWrite()
     {
+        if (!mGlobalMapImage)
+            return;
+
+        mScaleGlobalMap.get();
+
         int numcells = mGlobalMapImage->s() / 18; // NB truncating, doesn't divide perfectly
                                                        // with the 512x512 map the game has by default
         int cellSize = mGlobalMapImage->s()/numcells;
@@ -130,61 +141,81 @@ namespace ESSImport
         mContext->mGlobalMapState.mBounds.mMinY = -(numcells-1)/2;
         mContext->mGlobalMapState.mBounds.mMaxY = numcells/2;
 
-        osg::ref_ptr<osg::Image> image2 (new osg::Image);
-        int width = cellSize*numcells;
-        int height = cellSize*numcells;
-        std::vector<unsigned char> data;
-        data.resize(width*height*4, 0);
+        // The explored cells and bounds are not changed anymore, so the image can be composed and encoded
+        // while the other records are written
+        osg::ref_ptr<osg::Image> globalMapImage = mGlobalMapImage;
+        const Context* context = mContext;
+        mGlobalMapData = std::async(std::launch::async, [globalMapImage, context, numcells, cellSize] {
+            const ESM::GlobalMap::Bounds& bounds = context->mGlobalMapState.mBounds;
 
-        image2->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
-        memcpy(image2->data(), &data[0], data.size());
+            osg::ref_ptr<osg::Image> image2 (new osg::Image);
+            int width = cellSize*numcells;
+            int height = cellSize*numcells;
+            std::vector<unsigned char> data;
+            data.resize(width*height*4, 0);
 
-        for (std::set<std::pair<int, int> >::const_iterator it = mContext->mExploredCells.begin(); it != mContext->mExploredCells.end(); ++it)
-        {
-            if (it->first > mContext->mGlobalMapState.mBounds.mMaxX
-                    || it->first < mContext->mGlobalMapState.mBounds.mMinX
-                    || it->second > mContext->mGlobalMapState.mBounds.mMaxY
-                    || it->second < mContext->mGlobalMapState.mBounds.mMinY)
-            {
-                // out of bounds, I think this could happen, since the original engine had a fixed-size map
-                continue;
-            }
+            image2->allocateImage(width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+            memcpy(image2->data(), &data[0], data.size());
 
-            int imageLeftSrc = mGlobalMapImage->s()/2;
-            int imageTopSrc = mGlobalMapImage->t()/2;
-            imageLeftSrc += it->first * cellSize;
-            imageTopSrc -= it->second * cellSize;
-            int imageLeftDst = width/2;
-            int imageTopDst = height/2;
-            imageLeftDst += it->first * cellSize;
-            imageTopDst -= it->second * cellSize;
-            for (int x=0; x<cellSize; ++x)
-                for (int y=0; y<cellSize; ++y)
+            for (std::set<std::pair<int, int> >::const_iterator it = context->mExploredCells.begin(); it != context->mExploredCells.end(); ++it)
+            {
+                if (it->first > bounds.mMaxX
+                        || it->first < bounds.mMinX
+                        || it->second > bounds.mMaxY
+                        || it->second < bounds.mMinY)
                 {
-                    unsigned int col = *(unsigned int*)mGlobalMapImage->data(imageLeftSrc+x, imageTopSrc+y, 0);
-                    *(unsigned int*)image2->data(imageLeftDst+x, imageTopDst+y, 0) = col;
+                    // out of bounds, I think this could happen, since the original engine had a fixed-size map
+                    continue;
                 }
-        }
 
-        std::stringstream ostream;
-        osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("png");
-        if (!readerwriter)
-        {
-            std::cerr << "Error: can't write global map image, no png readerwriter found" << std::endl;
-            return;
-        }
+                int imageLeftSrc = globalMapImage->s()/2;
+                int imageTopSrc = globalMapImage->t()/2;
+                imageLeftSrc += it->first * cellSize;
+                imageTopSrc -= it->second * cellSize;
+                int imageLeftDst = width/2;
+                int imageTopDst = height/2;
+                imageLeftDst += it->first * cellSize;
+                imageTopDst -= it->second * cellSize;
+                for (int x=0; x<cellSize; ++x)
+                    for (int y=0; y<cellSize; ++y)
+                    {
+                        unsigned int col = *(unsigned int*)globalMapImage->data(imageLeftSrc+x, imageTopSrc+y, 0);
+                        *(unsigned int*)image2->data(imageLeftDst+x, imageTopDst+y, 0) = col;
+                    }
+            }
 
-        image2->flipVertical();
+            std::stringstream ostream;
+            osgDB::ReaderWriter* readerwriter = osgDB::Registry::instance()->getReaderWriterForExtension("png");
+            if (!readerwriter)
+            {
+                std::cerr << "Error: can't write global map image, no png readerwriter found" << std::endl;
+                return std::vector<char>();
+            }
 
-        osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*image2, ostream);
-        if (!result.success())
-        {
-            std::cerr << "Error: can't write global map image: " << result.message() << " code " << result.status() << std::endl;
+            image2->flipVertical();
+
+            osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*image2, ostream);
+            if (!result.success())
+            {
+                std::cerr << "Error: can't write global map image: " << result.message() << " code " << result.status() << std::endl;
+                return std::vector<char>();
+            }
+
+            std::string outData = ostream.str();
+            return std::vector<char>(outData.begin(), outData.end());
+        });
+    }
+
+    void ConvertFMAP::write(ESM::ESMWriter &esm)
+    {
+        if (!mGlobalMapData.valid())
             return;
-        }
 
-        std::string outData = ostream.str();
-        mContext->mGlobalMapState.mImageData = std::vector<char>(outData.begin(), outData.end());
+        std::vector<char> imageData = mGlobalMapData.get();
+        if (imageData.empty())
+            return;
+
+        mContext->mGlobalMapState.mImageData.swap(imageData);
 
         esm.startRecord(ESM::REC_GMAP);
         mContext->mGlobalMapState.save(esm);
@@ -254,7 +285,15 @@ namespace ESSImport
                 std::ostringstream filename;
                 filename << "fog_" << cell.mData.mX << "_" << cell.mData.mY << ".tga";
 
-                convertImage((char*)&newcell.mFogOfWar[0], newcell.mFogOfWar.size()*4, 16, 16, GL_RGBA, filename.str());
+                // Written in the background while the rest of the file is read, with one pending image per core
+                if (mFogImageWrites.size() >= std::max(1u, std::thread::hardware_concurrency()))
+                {
+                    mFogImageWrites.front().get();
+                    mFogImageWrites.pop_front();
+                }
+
+                mFogImageWrites.push_back(std::async(std::launch::async, convertImage, newcell.mFogOfWar,
+                    16, 16, GL_RGBA, filename.str()));
             }
         }
 
@@ -449,6 +488,13 @@ namespace ESSImport
             it->save(esm);
             esm.endRecord(ESM::REC_MARK);
         }
+
+        // The fog textures are separate files, so they only need to be finished by the end of the import
+        while (!mFogImageWrites.empty())
+        {
+            mFogImageWrites.front().get();
+            mFogImageWrites.pop_front();
+        }
     }
 
     void ConvertPROJ::read(ESM::ESMReader& esm)
@@ -1,6 +1,8 @@
 #ifndef OPENMW_ESSIMPORT_CONVERTER_H
 #define OPENMW_ESSIMPORT_CONVERTER_H
 
+#include <deque>
+#include <future>
 #include <limits>
 
 #include <osg/Image>
@@ -63,6 +65,13 @@ public:
     {
     }
 
+    /// Called for all converters after the input file has been read in completely, before
+    /// any of them is written. Converters may start expensive work here that does not depend
+    /// on the output of other converters, so it runs in the background while those are written.
+    virtual void prepareWrite()
+    {
+    }
+
     /// Called after the input file has been read in completely, which may be necessary
     /// if the conversion process relies on information in other records
     virtual void write(ESM::ESMWriter& esm)
@@ -331,10 +340,13 @@ class ConvertFMAP : public Converter
 {
 public:
     virtual void read(ESM::ESMReader &esm);
+    virtual void prepareWrite();
     virtual void write(ESM::ESMWriter &esm);
 
 private:
     osg::ref_ptr<osg::Image> mGlobalMapImage;
+    std::future<void> mScaleGlobalMap;
+    std::future<std::vector<char> > mGlobalMapData; // empty if the image could not be encoded
 };
 
 class ConvertCell : public Converter
@@ -356,6 +368,8 @@ private:
 
     std::vector<ESM::CustomMarker> mMarkers;
 
+    std::deque<std::future<void> > mFogImageWrites;
+
     void writeCell(const Cell& cell, ESM::ESMWriter &esm);
 };
 
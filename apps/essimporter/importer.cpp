@@ -1,5 +1,6 @@
 #include "importer.hpp"
 
+#include <future>
 #include <iomanip>
 
 #include <boost/filesystem/fstream.hpp>
@@ -36,12 +37,13 @@
 namespace
 {
 
-    void writeScreenshot(const ESM::Header& fileHeader, ESM::SavedGame& out)
+    /// @return the screenshot encoded as jpg, empty on failure
+    std::vector<char> convertScreenshot(const ESM::Header& fileHeader)
     {
         if (fileHeader.mSCRS.size() != 128*128*4)
         {
             std::cerr << "Error: unexpected screenshot size " << std::endl;
-            return;
+            return std::vector<char>();
         }
 
         osg::ref_ptr<osg::Image> image (new osg::Image);
@@ -69,18 +71,18 @@ namespace
         if (!readerwriter)
         {
             std::cerr << "Error: can't write screenshot: no jpg readerwriter found" << std::endl;
-            return;
+            return std::vector<char>();
         }
 
         osgDB::ReaderWriter::WriteResult result = readerwriter->writeImage(*image, ostream);
         if (!result.success())
         {
             std::cerr << "Error: can't write screenshot: " << result.message() << " code " << result.status() << std::endl;
-            return;
+            return std::vector<char>();
         }
 
         std::string data = ostream.str();
-        out.mScreenshot = std::vector<char>(data.begin(), data.end());
+        return std::vector<char>(data.begin(), data.end());
     }
 
 }
@@ -266,6 +268,9 @@ namespace ESSImport
         const ESM::Header& header = esm.getHeader();
         context.mPlayerCellName = header.mGameData.mCurrentCell.toString();
 
+        // Only depends on the header, so it is encoded while the records are read
+        std::future<std::vector<char> > screenshot = std::async(std::launch::async, convertScreenshot, std::cref(header));
+
         const unsigned int recREFR = ESM::FourCC<'R','E','F','R'>::value;
         const unsigned int recPCDT = ESM::FourCC<'P','C','D','T'>::value;
         const unsigned int recFMAP = ESM::FourCC<'F','M','A','P'>::value;
@@ -345,6 +350,12 @@ namespace ESSImport
             }
         }
 
+        for (std::map<unsigned int, std::shared_ptr<Converter> >::const_iterator it = converters.begin();
+             it != converters.end(); ++it)
+        {
+            it->second->prepareWrite();
+        }
+
         ESM::ESMWriter writer;
 
         writer.setFormat (ESM::SavedGame::sCurrentFormat);
@@ -382,7 +393,7 @@ namespace ESSImport
         profile.mPlayerLevel = context.mPlayerBase.mNpdt.mLevel;
         profile.mPlayerName = header.mGameData.mPlayerName.toString();
 
-        writeScreenshot(header, profile);
+        profile.mScreenshot = screenshot.get();
 
         writer.startRecord (ESM::REC_SAVE);
         profile.save (writer);
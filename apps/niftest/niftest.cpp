@@ -1,8 +1,16 @@
 ///Program to test .nif files both on the FileSystem and in BSA archives.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <components/nif/niffile.hpp>
 #include <components/files/constrainedfilestream.hpp>
@@ -43,33 +51,44 @@ bool isBSA(const std::string & filename)
     return hasExtension(filename,"bsa");
 }
 
-/// Check all the nif files in a given VFS::Archive
+/// A nif file to parse, either from a VFS or from the file system when there is no manager
+struct Job
+{
+    std::shared_ptr<VFS::Manager> mManager;
+    std::string mName;
+    std::string mPath; ///< for reports
+};
+
+struct Result
+{
+    bool mParsed = false;
+    double mMilliseconds = 0;
+    std::size_t mRecords = 0;
+    std::size_t mControllers = 0;
+};
+
+/// Collect all the nif files in a given VFS::Archive
 /// \note Takes ownership!
 /// \note Can not read a bsa file inside of a bsa file.
-void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
+void readVFS(VFS::Archive* anArchive, std::vector<Job>& jobs, std::string archivePath = "")
 {
-    VFS::Manager myManager(true);
-    myManager.addArchive(anArchive);
-    myManager.buildIndex();
+    std::shared_ptr<VFS::Manager> myManager = std::make_shared<VFS::Manager>(true);
+    myManager->addArchive(anArchive);
+    myManager->buildIndex();
 
-    std::map<std::string, VFS::File*> files=myManager.getIndex();
-    for(std::map<std::string, VFS::File*>::const_iterator it=files.begin(); it!=files.end(); ++it)
+    for(const std::string& name : myManager->getRecursiveDirectoryIterator(""))
     {
-        std::string name = it->first;
 
         try{
             if(isNIF(name))
             {
-            //           std::cout << "Decoding: " << name << std::endl;
-                Nif::NIFFile temp_nif(myManager.get(name),archivePath+name);
+                jobs.push_back(Job {myManager, name, archivePath+name});
             }
             else if(isBSA(name))
             {
                 if(!archivePath.empty() && !isBSA(archivePath))
                 {
-//                     std::cout << "Reading BSA File: " << name << std::endl;
-                    readVFS(new VFS::BsaArchive(archivePath+name),archivePath+name+"/");
-//                     std::cout << "Done with BSA File: " << name << std::endl;
+                    readVFS(new VFS::BsaArchive(archivePath+name), jobs, archivePath+name+"/");
                 }
             }
         }
@@ -80,7 +99,136 @@ void readVFS(VFS::Archive* anArchive,std::string archivePath = "")
     }
 }
 
-bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
+void parse(const Job& job, Result& result)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Files::IStreamPtr stream = job.mManager ? job.mManager->get(job.mName)
+        : Files::openConstrainedFileStream(job.mName.c_str());
+    Nif::NIFFile nif(stream, job.mPath);
+
+    result.mMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.mRecords = nif.numRecords();
+    for (std::size_t i = 0; i < nif.numRecords(); ++i)
+    {
+        const Nif::Record* record = nif.getRecord(i);
+        if (record && record->recName.find("Controller") != std::string::npos)
+            ++result.mControllers;
+    }
+    result.mParsed = true;
+}
+
+/// Parse the files on several threads, reporting errors as they occur
+void parseAll(const std::vector<Job>& jobs, std::vector<Result>& results, unsigned int threads)
+{
+    results.assign(jobs.size(), Result());
+
+    std::atomic<std::size_t> next (0);
+    std::mutex mutex;
+
+    auto parseFiles = [&] ()
+    {
+        for (std::size_t i = next++; i < jobs.size(); i = next++)
+        {
+            try
+            {
+                parse(jobs[i], results[i]);
+            }
+            catch (std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < std::min<std::size_t>(threads, jobs.size()); ++i)
+        workers.emplace_back(parseFiles);
+
+    parseFiles();
+
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+/// Values above the mean by more than three standard deviations
+struct OutlierLimit
+{
+    double mLimit = 0;
+
+    template <class Function>
+    OutlierLimit(const std::vector<Result>& results, Function value)
+    {
+        std::size_t count = 0;
+        double sum = 0;
+        double sumOfSquares = 0;
+        for (const Result& result : results)
+        {
+            if (!result.mParsed)
+                continue;
+            ++count;
+            sum += value(result);
+            sumOfSquares += value(result) * value(result);
+        }
+
+        // Too few files to tell what is unusual
+        if (count < 10)
+        {
+            mLimit = std::numeric_limits<double>::max();
+            return;
+        }
+
+        const double mean = sum / count;
+        mLimit = mean + 3 * std::sqrt(std::max(0.0, sumOfSquares / count - mean * mean));
+    }
+};
+
+/// Write the parse time of each file as CSV, flagging outliers
+void reportTimings(const std::vector<Job>& jobs, const std::vector<Result>& results)
+{
+    const OutlierLimit time (results, [] (const Result& result) { return result.mMilliseconds; });
+    const OutlierLimit records (results, [] (const Result& result) { return static_cast<double>(result.mRecords); });
+    const OutlierLimit controllers (results,
+        [] (const Result& result) { return static_cast<double>(result.mControllers); });
+
+    std::size_t parsed = 0;
+    std::size_t outliers = 0;
+    double total = 0;
+
+    std::cout << "file,milliseconds,records,controllers,flags\n";
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        const Result& result = results[i];
+        if (!result.mParsed)
+            continue;
+
+        ++parsed;
+        total += result.mMilliseconds;
+
+        std::string flags;
+        if (result.mMilliseconds > time.mLimit)
+            flags += " slow";
+        if (result.mRecords > records.mLimit)
+            flags += " records";
+        if (result.mControllers > controllers.mLimit)
+            flags += " controllers";
+        if (!flags.empty())
+        {
+            ++outliers;
+            flags.erase(0, 1);
+        }
+
+        std::cout << '"' << jobs[i].mPath << "\"," << result.mMilliseconds << ',' << result.mRecords << ','
+            << result.mControllers << ',' << flags << '\n';
+    }
+
+    std::cout.flush();
+    std::cerr << "Parsed " << parsed << " of " << jobs.size() << " files in " << total << " ms of parse time, "
+        << outliers << " outliers" << std::endl;
+}
+
+bool parseOptions (int argc, char** argv, std::vector<std::string>& files, bool& timings, unsigned int& threads)
 {
     bpo::options_description desc("Ensure that OpenMW can use the provided NIF and BSA files\n\n"
         "Usages:\n"
@@ -89,6 +237,10 @@ bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
         "Allowed options");
     desc.add_options()
         ("help,h", "print help message.")
+        ("timings,t", "print the parse time, number of records and number of controllers of each file as csv, "
+         "flagging values far above the average.")
+        ("threads,j", bpo::value<unsigned int>(), "number of files parsed at the same time "
+         "(default: number of hardware threads).")
         ("input-file", bpo::value< std::vector<std::string> >(), "input file")
         ;
 
@@ -108,6 +260,10 @@ bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
             std::cout << desc << std::endl;
             return false;
         }
+        timings = variables.count("timings") != 0;
+        threads = std::max(1u, std::thread::hardware_concurrency());
+        if (variables.count("threads"))
+            threads = std::max(1u, variables["threads"].as<unsigned int>());
         if (variables.count("input-file"))
         {
             files = variables["input-file"].as< std::vector<std::string> >();
@@ -129,10 +285,13 @@ bool parseOptions (int argc, char** argv, std::vector<std::string>& files)
 int main(int argc, char **argv)
 {
     std::vector<std::string> files;
-    if(!parseOptions (argc, argv, files))
+    bool timings = false;
+    unsigned int threads = 1;
+    if(!parseOptions (argc, argv, files, timings, threads))
         return 1;
 
-//     std::cout << "Reading Files" << std::endl;
+    std::vector<Job> jobs;
+
     for(std::vector<std::string>::const_iterator it=files.begin(); it!=files.end(); ++it)
     {
         std::string name = *it;
@@ -141,18 +300,15 @@ int main(int argc, char **argv)
         {
             if(isNIF(name))
             {
-                //std::cout << "Decoding: " << name << std::endl;
-                Nif::NIFFile temp_nif(Files::openConstrainedFileStream(name.c_str()),name);
+                jobs.push_back(Job {nullptr, name, name});
              }
              else if(isBSA(name))
              {
-//                 std::cout << "Reading BSA File: " << name << std::endl;
-                readVFS(new VFS::BsaArchive(name));
+                readVFS(new VFS::BsaArchive(name), jobs);
              }
              else if(bfs::is_directory(bfs::path(name)))
              {
-//                 std::cout << "Reading All Files in: " << name << std::endl;
-                readVFS(new VFS::FileSystemArchive(name),name);
+                readVFS(new VFS::FileSystemArchive(name), jobs, name);
              }
              else
              {
@@ -164,5 +320,12 @@ int main(int argc, char **argv)
             std::cerr << "ERROR, an exception has occurred:  " << e.what() << std::endl;
         }
      }
+
+     std::vector<Result> results;
+     parseAll(jobs, results, threads);
+
+     if (timings)
+         reportTimings(jobs, results);
+
      return 0;
 }
@@ -86,6 +86,17 @@ void CSMDoc::Loader::load()
             return;
         }
 
+        if (iter->second.mFile==0)
+        {
+            // read the content files ahead on worker threads while the earlier ones are merged
+            std::vector<std::pair<boost::filesystem::path, bool> > files;
+
+            for (int i=0; i<size; ++i)
+                files.push_back (std::make_pair (document->getContentFiles()[i], i!=editedIndex));
+
+            document->getData().startParsing (files);
+        }
+
         if (iter->second.mFile<size)
         {
             boost::filesystem::path path = document->getContentFiles()[iter->second.mFile];
@@ -120,6 +131,7 @@ void CSMDoc::Loader::load()
 
     if (done)
     {
+        document->getData().stopParsing();
         mDocuments.erase (iter);
         emit documentLoaded (document);
     }
@@ -1,5 +1,6 @@
 #include "operation.hpp"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -10,6 +11,17 @@
 #include "state.hpp"
 #include "stage.hpp"
 
+struct CSMDoc::Operation::StageResult
+{
+    Messages mMessages;
+    std::string mError;
+    std::atomic<bool> mDone;
+
+    StageResult (Message::Severity defaultSeverity)
+    : mMessages (defaultSeverity), mDone (false)
+    {}
+};
+
 void CSMDoc::Operation::prepareStages()
 {
     mCurrentStage = mStages.begin();
@@ -29,13 +41,16 @@ CSMDoc::Operation::Operation (int type, bool ordered, bool finalAlways)
 : mType (type), mStages(std::vector<std::pair<Stage *, int> >()), mCurrentStage(mStages.begin()),
   mCurrentStep(0), mCurrentStepTotal(0), mTotalSteps(0), mOrdered (ordered),
   mFinalAlways (finalAlways), mError(false), mConnected (false), mPrepared (false),
-  mDefaultSeverity (Message::Severity_Error)
+  mDefaultSeverity (Message::Severity_Error), mConcurrent (false), mNextStage (0), mConcurrentSteps (0),
+  mConcurrentAbort (false), mNextReportedStage (0)
 {
     mTimer = new QTimer (this);
 }
 
 CSMDoc::Operation::~Operation()
 {
+    stopConcurrentStages();
+
     for (std::vector<std::pair<Stage *, int> >::iterator iter (mStages.begin()); iter!=mStages.end(); ++iter)
         delete iter->first;
 }
@@ -44,6 +59,8 @@ void CSMDoc::Operation::run()
 {
     mTimer->stop();
 
+    stopConcurrentStages();
+
     if (!mConnected)
     {
         connect (mTimer, SIGNAL (timeout()), this, SLOT (executeStage()));
@@ -77,6 +94,12 @@ void CSMDoc::Operation::abort()
 
     mError = true;
 
+    if (mConcurrent)
+    {
+        mConcurrentAbort = true;
+        return;
+    }
+
     if (mFinalAlways)
     {
         if (mStages.begin()!=mStages.end() && mCurrentStage!=--mStages.end())
@@ -95,6 +118,15 @@ void CSMDoc::Operation::executeStage()
     {
         prepareStages();
         mPrepared = true;
+
+        if (!mOrdered && !mFinalAlways && mStages.size()>1)
+            startConcurrentStages();
+    }
+
+    if (mConcurrent)
+    {
+        reportConcurrentStages();
+        return;
     }
 
     Messages messages (mDefaultSeverity);
@@ -132,6 +164,111 @@ void CSMDoc::Operation::executeStage()
         operationDone();
 }
 
+void CSMDoc::Operation::startConcurrentStages()
+{
+    mResults.clear();
+    for (std::size_t i = 0; i<mStages.size(); ++i)
+        mResults.emplace_back (new StageResult (mDefaultSeverity));
+
+    mNextStage = 0;
+    mConcurrentSteps = 0;
+    mConcurrentAbort = false;
+    mNextReportedStage = 0;
+    mConcurrent = true;
+
+    const std::size_t numThreads = std::max (std::min (static_cast<std::size_t> (std::thread::hardware_concurrency()),
+        mStages.size()), static_cast<std::size_t> (1));
+
+    for (std::size_t i = 0; i<numThreads; ++i)
+        mThreads.emplace_back (&Operation::executeConcurrentStages, this);
+
+    // The timer only reports the progress from now on
+    mTimer->start (50);
+}
+
+void CSMDoc::Operation::executeConcurrentStages()
+{
+    while (!mConcurrentAbort)
+    {
+        const std::size_t index = mNextStage++;
+
+        if (index>=mStages.size())
+            return;
+
+        Stage& stage = *mStages[index].first;
+        StageResult& result = *mResults[index];
+
+        for (int step = 0; step<mStages[index].second && !mConcurrentAbort; ++step)
+        {
+            try
+            {
+                stage.perform (step, result.mMessages);
+            }
+            catch (const std::exception& e)
+            {
+                result.mError = e.what();
+                mConcurrentAbort = true;
+            }
+
+            ++mConcurrentSteps;
+        }
+
+        result.mDone = true;
+    }
+}
+
+void CSMDoc::Operation::reportConcurrentStages()
+{
+    const bool aborted = mConcurrentAbort;
+    const bool finished = aborted || mNextReportedStage==mResults.size() ||
+        std::all_of (mResults.begin()+mNextReportedStage, mResults.end(),
+            [] (const std::unique_ptr<StageResult>& result) { return result->mDone.load(); });
+
+    if (finished)
+        stopConcurrentStages();
+
+    emit progress (mConcurrentSteps, mTotalSteps ? mTotalSteps : 1, mType);
+
+    // Stages are reported one after another, so the messages are in the same order as with sequential execution
+    for (; mNextReportedStage<mResults.size() && mResults[mNextReportedStage]->mDone; ++mNextReportedStage)
+    {
+        const StageResult& result = *mResults[mNextReportedStage];
+
+        if (!result.mError.empty())
+        {
+            emit reportMessage (Message (CSMWorld::UniversalId(), result.mError, "", Message::Severity_SeriousError), mType);
+            mError = true;
+        }
+
+        for (Messages::Iterator iter (result.mMessages.begin()); iter!=result.mMessages.end(); ++iter)
+            emit reportMessage (*iter, mType);
+    }
+
+    if (finished)
+    {
+        if (aborted)
+            mError = true;
+
+        mConcurrent = false;
+        mResults.clear();
+        operationDone();
+    }
+}
+
+void CSMDoc::Operation::stopConcurrentStages()
+{
+    if (mThreads.empty())
+        return;
+
+    // Running stages finish their current step
+    mConcurrentAbort = true;
+
+    for (std::thread& thread : mThreads)
+        thread.join();
+
+    mThreads.clear();
+}
+
 void CSMDoc::Operation::operationDone()
 {
     mTimer->stop();
@@ -1,8 +1,11 @@
 #ifndef CSM_DOC_OPERATION_H
 #define CSM_DOC_OPERATION_H
 
+#include <atomic>
 #include <vector>
 #include <map>
+#include <memory>
+#include <thread>
 
 #include <QObject>
 #include <QTimer>
@@ -37,12 +40,34 @@ namespace CSMDoc
             bool mPrepared;
             Message::Severity mDefaultSeverity;
 
+            // Stages of an unordered operation are executed concurrently, each by one of the threads
+            struct StageResult;
+            bool mConcurrent;
+            std::vector<std::unique_ptr<StageResult> > mResults;
+            std::vector<std::thread> mThreads;
+            std::atomic<std::size_t> mNextStage;
+            std::atomic<int> mConcurrentSteps;
+            std::atomic<bool> mConcurrentAbort;
+            std::size_t mNextReportedStage;
+
             void prepareStages();
 
+            void startConcurrentStages();
+
+            /// Executed by each thread, until all stages are taken or the operation is aborted.
+            void executeConcurrentStages();
+
+            /// Report progress and the messages of finished stages, in the order of the stages.
+            void reportConcurrentStages();
+
+            void stopConcurrentStages();
+
         public:
 
             Operation (int type, bool ordered, bool finalAlways = false);
-            ///< \param ordered Stages must be executed in the given order.
+            ///< \param ordered Stages must be executed in the given order. Otherwise they are executed
+            /// concurrently, so their perform functions must not modify data shared with other stages. Messages are
+            /// still reported in the order of the stages.
             /// \param finalAlways Execute last stage even if an error occurred during earlier stages.
 
             virtual ~Operation();
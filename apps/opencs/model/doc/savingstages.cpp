@@ -1,5 +1,8 @@
 #include "savingstages.hpp"
 
+#include <algorithm>
+#include <sstream>
+
 #include <boost/filesystem.hpp>
 
 #include <QUndoStack>
@@ -11,6 +14,12 @@
 
 #include "document.hpp"
 
+namespace
+{
+    // Small enough to give progress reports while saving large collections
+    const std::size_t sChunkSize = 64;
+}
+
 CSMDoc::OpenSaveStage::OpenSaveStage (Document& document, SavingState& state, bool projectFile)
 : mDocument (document), mState (state), mProjectFile (projectFile)
 {}
@@ -81,6 +90,132 @@ void CSMDoc::WriteHeaderStage::perform (int stage, Messages& messages)
 }
 
 
+CSMDoc::ConcurrentWriteStage::ConcurrentWriteStage (SavingState& state)
+: mState (state), mNextChunk (0), mAbort (false), mVersion (0)
+{}
+
+CSMDoc::ConcurrentWriteStage::~ConcurrentWriteStage()
+{
+    stopThreads();
+}
+
+void CSMDoc::ConcurrentWriteStage::startThreads()
+{
+    mVersion = mState.getWriter().getVersion();
+    mNextChunk = 0;
+    mAbort = false;
+
+    std::size_t threads = std::max (1u, std::thread::hardware_concurrency());
+    threads = std::min (threads, mChunks.size());
+
+    for (std::size_t i=0; i<threads; ++i)
+        mThreads.emplace_back (&ConcurrentWriteStage::writeChunks, this);
+}
+
+void CSMDoc::ConcurrentWriteStage::stopThreads()
+{
+    mAbort = true;
+
+    for (std::vector<std::thread>::iterator iter (mThreads.begin()); iter!=mThreads.end(); ++iter)
+        iter->join();
+
+    mThreads.clear();
+}
+
+void CSMDoc::ConcurrentWriteStage::writeChunks()
+{
+    // The encoder keeps a conversion buffer, so each thread needs its own
+    ToUTF8::Utf8Encoder encoder (mState.getEncoding());
+
+    while (!mAbort)
+    {
+        std::size_t index = mNextChunk++;
+
+        if (index>=mChunks.size())
+            return;
+
+        Chunk& chunk = mChunks[index];
+
+        try
+        {
+            std::ostringstream stream;
+
+            ESM::ESMWriter writer;
+            writer.setEncoder (&encoder);
+            writer.setVersion (mVersion);
+            writer.saveRecords (stream);
+
+            std::size_t end = std::min ((index+1) * sChunkSize, mRecords.size());
+
+            for (std::size_t i=index * sChunkSize; i<end && !mAbort; ++i)
+                write (mRecords[i], writer);
+
+            writer.close();
+            chunk.mBuffer = stream.str();
+        }
+        catch (...)
+        {
+            chunk.mError = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock (mMutex);
+            chunk.mDone = true;
+        }
+
+        mChunkDone.notify_all();
+    }
+}
+
+int CSMDoc::ConcurrentWriteStage::setup()
+{
+    // left running if the previous save was aborted
+    stopThreads();
+
+    mRecords.clear();
+    mChunks.clear();
+
+    int size = getSize();
+
+    for (int i=0; i<size; ++i)
+        if (isWritten (i))
+            mRecords.push_back (i);
+
+    Chunk chunk;
+    chunk.mDone = false;
+    mChunks.resize ((mRecords.size() + sChunkSize - 1) / sChunkSize, chunk);
+
+    return static_cast<int> (mChunks.size());
+}
+
+void CSMDoc::ConcurrentWriteStage::perform (int stage, Messages& messages)
+{
+    // The header has to be written before the version of the writer is known
+    if (stage==0)
+        startThreads();
+
+    Chunk& chunk = mChunks[stage];
+
+    {
+        std::unique_lock<std::mutex> lock (mMutex);
+        mChunkDone.wait (lock, [&chunk] { return chunk.mDone; });
+    }
+
+    if (static_cast<std::size_t> (stage+1)==mChunks.size())
+        stopThreads();
+
+    if (chunk.mError)
+    {
+        stopThreads();
+        std::rethrow_exception (chunk.mError);
+    }
+
+    mState.getWriter().write (chunk.mBuffer.data(), chunk.mBuffer.size());
+
+    std::string().swap (chunk.mBuffer);
+}
+
+
 CSMDoc::WriteDialogueCollectionStage::WriteDialogueCollectionStage (Document& document,
     SavingState& state, bool journal)
 : mState (state),
@@ -173,17 +308,24 @@ void CSMDoc::WriteDialogueCollectionStage::perform (int stage, Messages& message
 
 
 CSMDoc::WriteRefIdCollectionStage::WriteRefIdCollectionStage (Document& document, SavingState& state)
-: mDocument (document), mState (state)
+: ConcurrentWriteStage (state), mDocument (document)
 {}
 
-int CSMDoc::WriteRefIdCollectionStage::setup()
+int CSMDoc::WriteRefIdCollectionStage::getSize() const
 {
     return mDocument.getData().getReferenceables().getSize();
 }
 
-void CSMDoc::WriteRefIdCollectionStage::perform (int stage, Messages& messages)
+bool CSMDoc::WriteRefIdCollectionStage::isWritten (int index) const
+{
+    const CSMWorld::RecordBase& record = mDocument.getData().getReferenceables().getRecord (index);
+
+    return record.isModified() || record.mState == CSMWorld::RecordBase::State_Deleted;
+}
+
+void CSMDoc::WriteRefIdCollectionStage::write (int index, ESM::ESMWriter& writer) const
 {
-    mDocument.getData().getReferenceables().save (stage, mState.getWriter());
+    mDocument.getData().getReferenceables().save (index, writer);
 }
 
 
@@ -407,53 +549,59 @@ void CSMDoc::WritePathgridCollectionStage::perform (int stage, Messages& message
 
 CSMDoc::WriteLandCollectionStage::WriteLandCollectionStage (Document& document,
     SavingState& state)
-: mDocument (document), mState (state)
+: ConcurrentWriteStage (state), mDocument (document)
 {}
 
-int CSMDoc::WriteLandCollectionStage::setup()
+int CSMDoc::WriteLandCollectionStage::getSize() const
 {
     return mDocument.getData().getLand().getSize();
 }
 
-void CSMDoc::WriteLandCollectionStage::perform (int stage, Messages& messages)
+bool CSMDoc::WriteLandCollectionStage::isWritten (int index) const
 {
-    ESM::ESMWriter& writer = mState.getWriter();
-    const CSMWorld::Record<CSMWorld::Land>& land =
-        mDocument.getData().getLand().getRecord (stage);
+    const CSMWorld::Record<CSMWorld::Land>& land = mDocument.getData().getLand().getRecord (index);
 
-    if (land.isModified() || land.mState == CSMWorld::RecordBase::State_Deleted)
-    {
-        CSMWorld::Land record = land.get();
-        writer.startRecord (record.sRecordId);
-        record.save (writer, land.mState == CSMWorld::RecordBase::State_Deleted);
-        writer.endRecord (record.sRecordId);
-    }
+    return land.isModified() || land.mState == CSMWorld::RecordBase::State_Deleted;
+}
+
+void CSMDoc::WriteLandCollectionStage::write (int index, ESM::ESMWriter& writer) const
+{
+    const CSMWorld::Record<CSMWorld::Land>& land = mDocument.getData().getLand().getRecord (index);
+
+    CSMWorld::Land record = land.get();
+    writer.startRecord (record.sRecordId);
+    record.save (writer, land.mState == CSMWorld::RecordBase::State_Deleted);
+    writer.endRecord (record.sRecordId);
 }
 
 
 CSMDoc::WriteLandTextureCollectionStage::WriteLandTextureCollectionStage (Document& document,
     SavingState& state)
-: mDocument (document), mState (state)
+: ConcurrentWriteStage (state), mDocument (document)
 {}
 
-int CSMDoc::WriteLandTextureCollectionStage::setup()
+int CSMDoc::WriteLandTextureCollectionStage::getSize() const
 {
     return mDocument.getData().getLandTextures().getSize();
 }
 
-void CSMDoc::WriteLandTextureCollectionStage::perform (int stage, Messages& messages)
+bool CSMDoc::WriteLandTextureCollectionStage::isWritten (int index) const
 {
-    ESM::ESMWriter& writer = mState.getWriter();
     const CSMWorld::Record<CSMWorld::LandTexture>& landTexture =
-        mDocument.getData().getLandTextures().getRecord (stage);
+        mDocument.getData().getLandTextures().getRecord (index);
 
-    if (landTexture.isModified() || landTexture.mState == CSMWorld::RecordBase::State_Deleted)
-    {
-        CSMWorld::LandTexture record = landTexture.get();
-        writer.startRecord (record.sRecordId);
-        record.save (writer, landTexture.mState == CSMWorld::RecordBase::State_Deleted);
-        writer.endRecord (record.sRecordId);
-    }
+    return landTexture.isModified() || landTexture.mState == CSMWorld::RecordBase::State_Deleted;
+}
+
+void CSMDoc::WriteLandTextureCollectionStage::write (int index, ESM::ESMWriter& writer) const
+{
+    const CSMWorld::Record<CSMWorld::LandTexture>& landTexture =
+        mDocument.getData().getLandTextures().getRecord (index);
+
+    CSMWorld::LandTexture record = landTexture.get();
+    writer.startRecord (record.sRecordId);
+    record.save (writer, landTexture.mState == CSMWorld::RecordBase::State_Deleted);
+    writer.endRecord (record.sRecordId);
 }
 
 
@@ -1,6 +1,14 @@
 #ifndef CSM_DOC_SAVINGSTAGES_H
 #define CSM_DOC_SAVINGSTAGES_H
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "stage.hpp"
 
 #include "../world/record.hpp"
@@ -63,17 +71,52 @@ namespace CSMDoc
     };
 
 
-    template<class CollectionT>
-    class WriteCollectionStage : public Stage
+    /// \brief Base for stages writing records that do not depend on each other
+    ///
+    /// The records to write are collected during setup and split into chunks. The chunks are
+    /// written into separate buffers by a set of threads, each step appends the buffer of one
+    /// chunk to the file, so the records end up in the same order as when written sequentially.
+    class ConcurrentWriteStage : public Stage
     {
-            const CollectionT& mCollection;
+            struct Chunk
+            {
+                std::string mBuffer;
+                bool mDone;
+                std::exception_ptr mError;
+            };
+
             SavingState& mState;
-            CSMWorld::Scope mScope;
+            std::vector<int> mRecords;
+            std::vector<Chunk> mChunks;
+            std::vector<std::thread> mThreads;
+            std::atomic<std::size_t> mNextChunk;
+            std::atomic<bool> mAbort;
+            std::mutex mMutex;
+            std::condition_variable mChunkDone;
+            unsigned int mVersion;
+
+            void startThreads();
+
+            void stopThreads();
+
+            /// Executed by each thread, until all chunks are taken or the stage is stopped.
+            void writeChunks();
+
+        protected:
+
+            virtual int getSize() const = 0;
+
+            /// Does the record need to be written?
+            virtual bool isWritten (int index) const = 0;
+
+            /// \note Called concurrently from several threads.
+            virtual void write (int index, ESM::ESMWriter& writer) const = 0;
 
         public:
 
-            WriteCollectionStage (const CollectionT& collection, SavingState& state,
-                CSMWorld::Scope scope = CSMWorld::Scope_Content);
+            ConcurrentWriteStage (SavingState& state);
+
+            virtual ~ConcurrentWriteStage();
 
             virtual int setup();
             ///< \return number of steps
@@ -82,36 +125,61 @@ namespace CSMDoc
             ///< Messages resulting from this stage will be appended to \a messages.
     };
 
+
+    template<class CollectionT>
+    class WriteCollectionStage : public ConcurrentWriteStage
+    {
+            const CollectionT& mCollection;
+            CSMWorld::Scope mScope;
+
+        protected:
+
+            virtual int getSize() const;
+
+            virtual bool isWritten (int index) const;
+
+            virtual void write (int index, ESM::ESMWriter& writer) const;
+
+        public:
+
+            WriteCollectionStage (const CollectionT& collection, SavingState& state,
+                CSMWorld::Scope scope = CSMWorld::Scope_Content);
+    };
+
     template<class CollectionT>
     WriteCollectionStage<CollectionT>::WriteCollectionStage (const CollectionT& collection,
         SavingState& state, CSMWorld::Scope scope)
-    : mCollection (collection), mState (state), mScope (scope)
+    : ConcurrentWriteStage (state), mCollection (collection), mScope (scope)
     {}
 
     template<class CollectionT>
-    int WriteCollectionStage<CollectionT>::setup()
+    int WriteCollectionStage<CollectionT>::getSize() const
     {
         return mCollection.getSize();
     }
 
     template<class CollectionT>
-    void WriteCollectionStage<CollectionT>::perform (int stage, Messages& messages)
+    bool WriteCollectionStage<CollectionT>::isWritten (int index) const
     {
-        if (CSMWorld::getScopeFromId (mCollection.getRecord (stage).get().mId)!=mScope)
-            return;
-
-        ESM::ESMWriter& writer = mState.getWriter();
-        CSMWorld::RecordBase::State state = mCollection.getRecord (stage).mState;
-        typename CollectionT::ESXRecord record = mCollection.getRecord (stage).get();
-
-        if (state == CSMWorld::RecordBase::State_Modified ||
-            state == CSMWorld::RecordBase::State_ModifiedOnly ||
-            state == CSMWorld::RecordBase::State_Deleted)
-        {
-            writer.startRecord (record.sRecordId);
-            record.save (writer, state == CSMWorld::RecordBase::State_Deleted);
-            writer.endRecord (record.sRecordId);
-        }
+        const CSMWorld::Record<typename CollectionT::ESXRecord>& record = mCollection.getRecord (index);
+
+        if (CSMWorld::getScopeFromId (record.get().mId)!=mScope)
+            return false;
+
+        return record.mState == CSMWorld::RecordBase::State_Modified ||
+            record.mState == CSMWorld::RecordBase::State_ModifiedOnly ||
+            record.mState == CSMWorld::RecordBase::State_Deleted;
+    }
+
+    template<class CollectionT>
+    void WriteCollectionStage<CollectionT>::write (int index, ESM::ESMWriter& writer) const
+    {
+        CSMWorld::RecordBase::State state = mCollection.getRecord (index).mState;
+        typename CollectionT::ESXRecord record = mCollection.getRecord (index).get();
+
+        writer.startRecord (record.sRecordId);
+        record.save (writer, state == CSMWorld::RecordBase::State_Deleted);
+        writer.endRecord (record.sRecordId);
     }
 
 
@@ -133,20 +201,21 @@ namespace CSMDoc
     };
 
 
-    class WriteRefIdCollectionStage : public Stage
+    class WriteRefIdCollectionStage : public ConcurrentWriteStage
     {
             Document& mDocument;
-            SavingState& mState;
 
-        public:
+        protected:
 
-            WriteRefIdCollectionStage (Document& document, SavingState& state);
+            virtual int getSize() const;
 
-            virtual int setup();
-            ///< \return number of steps
+            virtual bool isWritten (int index) const;
 
-            virtual void perform (int stage, Messages& messages);
-            ///< Messages resulting from this stage will be appended to \a messages.
+            virtual void write (int index, ESM::ESMWriter& writer) const;
+
+        public:
+
+            WriteRefIdCollectionStage (Document& document, SavingState& state);
     };
 
 
@@ -200,37 +269,39 @@ namespace CSMDoc
     };
 
 
-    class WriteLandCollectionStage : public Stage
+    class WriteLandCollectionStage : public ConcurrentWriteStage
     {
             Document& mDocument;
-            SavingState& mState;
 
-        public:
+        protected:
 
-            WriteLandCollectionStage (Document& document, SavingState& state);
+            virtual int getSize() const;
 
-            virtual int setup();
-            ///< \return number of steps
+            virtual bool isWritten (int index) const;
 
-            virtual void perform (int stage, Messages& messages);
-            ///< Messages resulting from this stage will be appended to \a messages.
+            virtual void write (int index, ESM::ESMWriter& writer) const;
+
+        public:
+
+            WriteLandCollectionStage (Document& document, SavingState& state);
     };
 
 
-    class WriteLandTextureCollectionStage : public Stage
+    class WriteLandTextureCollectionStage : public ConcurrentWriteStage
     {
             Document& mDocument;
-            SavingState& mState;
 
-        public:
+        protected:
 
-            WriteLandTextureCollectionStage (Document& document, SavingState& state);
+            virtual int getSize() const;
 
-            virtual int setup();
-            ///< \return number of steps
+            virtual bool isWritten (int index) const;
 
-            virtual void perform (int stage, Messages& messages);
-            ///< Messages resulting from this stage will be appended to \a messages.
+            virtual void write (int index, ESM::ESMWriter& writer) const;
+
+        public:
+
+            WriteLandTextureCollectionStage (Document& document, SavingState& state);
     };
 
     class CloseSaveStage : public Stage
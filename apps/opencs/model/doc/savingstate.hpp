@@ -22,6 +22,7 @@ namespace CSMDoc
             Operation& mOperation;
             boost::filesystem::path mPath;
             boost::filesystem::path mTmpPath;
+            ToUTF8::FromType mEncoding;
             ToUTF8::Utf8Encoder mEncoder;
             boost::filesystem::ofstream mStream;
             ESM::ESMWriter mWriter;
@@ -47,6 +48,9 @@ namespace CSMDoc
 
             ESM::ESMWriter& getWriter();
 
+            /// Encoding of the writer, for writers used by other threads (the encoder is not thread safe)
+            ToUTF8::FromType getEncoding() const;
+
             bool isProjectFile() const;
             ///< Currently saving project file? (instead of content file)
 
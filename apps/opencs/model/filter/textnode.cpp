@@ -3,13 +3,12 @@
 #include <sstream>
 #include <stdexcept>
 
-#include <QRegExp>
-
 #include "../world/columns.hpp"
 #include "../world/idtablebase.hpp"
 
+/// \todo make pattern syntax configurable
 CSMFilter::TextNode::TextNode (int columnId, const std::string& text)
-: mColumnId (columnId), mText (text)
+: mColumnId (columnId), mText (text), mRegExp (QString::fromUtf8 (mText.c_str()), Qt::CaseInsensitive)
 {}
 
 bool CSMFilter::TextNode::test (const CSMWorld::IdTableBase& table, int row,
@@ -53,10 +52,7 @@ bool CSMFilter::TextNode::test (const CSMWorld::IdTableBase& table, int row,
     else
         return false;
 
-    /// \todo make pattern syntax configurable
-    QRegExp regExp (QString::fromUtf8 (mText.c_str()), Qt::CaseInsensitive);
-
-    return regExp.exactMatch (string);
+    return mRegExp.exactMatch (string);
 }
 
 std::vector<int> CSMFilter::TextNode::getReferencedColumns() const
@@ -1,6 +1,8 @@
 #ifndef CSM_FILTER_TEXTNODE_H
 #define CSM_FILTER_TEXTNODE_H
 
+#include <QRegExp>
+
 #include "leafnode.hpp"
 
 namespace CSMFilter
@@ -9,6 +11,7 @@ namespace CSMFilter
     {
             int mColumnId;
             std::string mText;
+            QRegExp mRegExp; // compiled once instead of for every tested row
 
         public:
 
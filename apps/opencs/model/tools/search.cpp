@@ -141,6 +141,16 @@ CSMTools::Search::Search (Type type, bool caseSensitive, int value)
         throw std::logic_error ("invalid search parameter (int)");
 }
 
+CSMTools::Search::Type CSMTools::Search::getType() const
+{
+    return mType;
+}
+
+const std::string& CSMTools::Search::getText() const
+{
+    return mText;
+}
+
 void CSMTools::Search::configure (const CSMWorld::IdTableBase *model)
 {
     mColumns.clear();
@@ -74,6 +74,10 @@ namespace CSMTools
 
             Search (Type type, bool caseSensitive, int value);
 
+            Type getType() const;
+
+            const std::string& getText() const;
+
             // Configure search for the specified model.
             void configure (const CSMWorld::IdTableBase *model);
 
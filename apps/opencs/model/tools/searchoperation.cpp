@@ -18,8 +18,12 @@ CSMTools::SearchOperation::SearchOperation (CSMDoc::Document& document)
 
     for (std::vector<CSMWorld::UniversalId::Type>::const_iterator iter (types.begin());
         iter!=types.end(); ++iter)
-        appendStage (new SearchStage (&dynamic_cast<CSMWorld::IdTableBase&> (
-            *document.getData().getTableModel (*iter))));
+    {
+        QAbstractItemModel *model = document.getData().getTableModel (*iter);
+
+        appendStage (new SearchStage (&dynamic_cast<CSMWorld::IdTableBase&> (*model),
+            document.getData().getTextIndex (model)));
+    }
 
     setDefaultSeverity (CSMDoc::Message::Severity_Info);
 }
@@ -1,11 +1,14 @@
 #include "searchstage.hpp"
 
+#include <algorithm>
+
 #include "../world/idtablebase.hpp"
+#include "../world/textindex.hpp"
 
 #include "searchoperation.hpp"
 
-CSMTools::SearchStage::SearchStage (const CSMWorld::IdTableBase *model)
-: mModel (model), mOperation (0)
+CSMTools::SearchStage::SearchStage (const CSMWorld::IdTableBase *model, CSMWorld::TextIndex *index)
+: mModel (model), mIndex (index), mOperation (0), mIndexed (false)
 {}
 
 int CSMTools::SearchStage::setup()
@@ -14,13 +17,40 @@ int CSMTools::SearchStage::setup()
         mSearch = mOperation->getSearch();
 
     mSearch.configure (mModel);
-        
+
+    mRows.clear();
+    mIndexed = false;
+
+    // Regular expressions and record states still need to look at every row
+    if (mIndex && (mSearch.getType()==Search::Type_Text || mSearch.getType()==Search::Type_Id))
+    {
+        std::vector<std::string> ids;
+
+        if (mIndex->find (mSearch.getText(), ids))
+        {
+            mIndexed = true;
+
+            for (std::vector<std::string>::const_iterator iter (ids.begin()); iter!=ids.end(); ++iter)
+            {
+                int row = mModel->getModelIndex (*iter, 0).row();
+
+                if (row!=-1)
+                    mRows.push_back (row);
+            }
+
+            // keep the messages in the order of the table
+            std::sort (mRows.begin(), mRows.end());
+
+            return mRows.size();
+        }
+    }
+
     return mModel->rowCount();
 }
 
 void CSMTools::SearchStage::perform (int stage, CSMDoc::Messages& messages)
 {
-    mSearch.searchRow (mModel, stage, messages);
+    mSearch.searchRow (mModel, mIndexed ? mRows[stage] : stage, messages);
 }
 
 void CSMTools::SearchStage::setOperation (const SearchOperation *operation)
@@ -1,6 +1,8 @@
 #ifndef CSM_TOOLS_SEARCHSTAGE_H
 #define CSM_TOOLS_SEARCHSTAGE_H
 
+#include <vector>
+
 #include "../doc/stage.hpp"
 
 #include "search.hpp"
@@ -8,6 +10,7 @@
 namespace CSMWorld
 {
     class IdTableBase;
+    class TextIndex;
 }
 
 namespace CSMTools
@@ -17,12 +20,17 @@ namespace CSMTools
     class SearchStage : public CSMDoc::Stage
     {
             const CSMWorld::IdTableBase *mModel;
+            CSMWorld::TextIndex *mIndex;
             Search mSearch;
             const SearchOperation *mOperation;
+            std::vector<int> mRows; // rows found in the index, only used if mIndexed
+            bool mIndexed;
 
         public:
 
-            SearchStage (const CSMWorld::IdTableBase *model);
+            /// \param index Used to look up the rows which may contain the text of a text or ID
+            /// search. May be 0.
+            SearchStage (const CSMWorld::IdTableBase *model, CSMWorld::TextIndex *index = 0);
 
             virtual int setup();
             ///< \return number of steps
@@ -8,6 +8,7 @@
 #include <stdexcept>
 #include <string>
 #include <functional>
+#include <unordered_map>
 
 #include <QVariant>
 
@@ -84,17 +85,36 @@ namespace CSMWorld
 
         private:
 
+            typedef std::unordered_map<std::string, int, Misc::StringUtils::CiHash,
+                Misc::StringUtils::CiEqual> IndexMap;
+
             std::vector<Record<ESXRecordT> > mRecords;
-            std::map<std::string, int> mIndex;
+            // Records are indexed by keys that stay the same when other rows are inserted or removed,
+            // so only the rows of the keys need to be updated.
+            std::vector<int> mRowKeys; // key of each row
+            std::vector<int> mKeyRows; // row of each key, -1 for unused keys
+            std::vector<int> mFreeKeys;
+            IndexMap mIndex;
+            std::map<std::string, int> mSortedIndex; // lower case ID -> key
             std::vector<Column<ESXRecordT> *> mColumns;
 
             // not implemented
             Collection (const Collection&);
             Collection& operator= (const Collection&);
 
+            void updateKeyRows (int index);
+            ///< Update the rows of the keys of the rows starting at \a index.
+
+            void removeKey (int index);
+            ///< Remove the record in row \a index from the indices, without removing the row.
+
         protected:
 
             const std::map<std::string, int>& getIdMap() const;
+            ///< Lower case IDs in sorted order, mapped to keys (see getKeyRow).
+
+            int getKeyRow (int key) const;
+            ///< Return the row of the record with the key \a key from getIdMap.
 
             const std::vector<Record<ESXRecordT> >& getRecords() const;
 
@@ -204,10 +224,44 @@ namespace CSMWorld
             NestableColumn *getNestableColumn (int column) const;
     };
 
+    template<typename ESXRecordT, typename IdAccessorT>
+    void Collection<ESXRecordT, IdAccessorT>::updateKeyRows (int index)
+    {
+        int size = static_cast<int> (mRowKeys.size());
+
+        for (int i=index; i<size; ++i)
+            mKeyRows[mRowKeys[i]] = i;
+    }
+
+    template<typename ESXRecordT, typename IdAccessorT>
+    void Collection<ESXRecordT, IdAccessorT>::removeKey (int index)
+    {
+        int key = mRowKeys[index];
+        std::string id = IdAccessorT().getId (mRecords[index].get());
+
+        typename IndexMap::iterator iter = mIndex.find (id);
+        if (iter!=mIndex.end() && iter->second==key)
+            mIndex.erase (iter);
+
+        std::map<std::string, int>::iterator iter2 =
+            mSortedIndex.find (Misc::StringUtils::lowerCase (id));
+        if (iter2!=mSortedIndex.end() && iter2->second==key)
+            mSortedIndex.erase (iter2);
+
+        mKeyRows[key] = -1;
+        mFreeKeys.push_back (key);
+    }
+
     template<typename ESXRecordT, typename IdAccessorT>
     const std::map<std::string, int>& Collection<ESXRecordT, IdAccessorT>::getIdMap() const
     {
-        return mIndex;
+        return mSortedIndex;
+    }
+
+    template<typename ESXRecordT, typename IdAccessorT>
+    int Collection<ESXRecordT, IdAccessorT>::getKeyRow (int key) const
+    {
+        return mKeyRows.at (key);
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -232,20 +286,21 @@ namespace CSMWorld
 
             // reorder records
             std::vector<Record<ESXRecordT> > buffer (size);
+            std::vector<int> keys (size);
 
             for (int i=0; i<size; ++i)
             {
                 buffer[newOrder[i]] = mRecords [baseIndex+i];
                 buffer[newOrder[i]].setModified (buffer[newOrder[i]].get());
+                keys[newOrder[i]] = mRowKeys[baseIndex+i];
             }
 
             std::copy (buffer.begin(), buffer.end(), mRecords.begin()+baseIndex);
+            std::copy (keys.begin(), keys.end(), mRowKeys.begin()+baseIndex);
 
             // adjust index
-            for (std::map<std::string, int>::iterator iter (mIndex.begin()); iter!=mIndex.end();
-                 ++iter)
-                if (iter->second>=baseIndex && iter->second<baseIndex+size)
-                    iter->second = newOrder.at (iter->second-baseIndex)+baseIndex;
+            for (int i=baseIndex; i<baseIndex+size; ++i)
+                mKeyRows[mRowKeys[i]] = i;
         }
 
         return true;
@@ -340,7 +395,7 @@ namespace CSMWorld
     {
         std::string id = Misc::StringUtils::lowerCase (IdAccessorT().getId (record));
 
-        std::map<std::string, int>::iterator iter = mIndex.find (id);
+        typename IndexMap::iterator iter = mIndex.find (id);
 
         if (iter==mIndex.end())
         {
@@ -352,7 +407,7 @@ namespace CSMWorld
         }
         else
         {
-            mRecords[iter->second].setModified (record);
+            mRecords[mKeyRows[iter->second]].setModified (record);
         }
     }
 
@@ -430,41 +485,42 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     void  Collection<ESXRecordT, IdAccessorT>::purge()
     {
-        int i = 0;
+        // compact the remaining records in a single pass instead of removing the rows one by one
+        int size = static_cast<int> (mRecords.size());
+        int target = 0;
 
-        while (i<static_cast<int> (mRecords.size()))
+        for (int i=0; i<size; ++i)
         {
             if (mRecords[i].isErased())
-                removeRows (i, 1);
-            else
-                ++i;
+            {
+                removeKey (i);
+                continue;
+            }
+
+            if (target!=i)
+            {
+                mRecords[target] = mRecords[i];
+                mRowKeys[target] = mRowKeys[i];
+                mKeyRows[mRowKeys[target]] = target;
+            }
+
+            ++target;
         }
+
+        mRecords.erase (mRecords.begin()+target, mRecords.end());
+        mRowKeys.resize (target);
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
     void Collection<ESXRecordT, IdAccessorT>::removeRows (int index, int count)
     {
-        mRecords.erase (mRecords.begin()+index, mRecords.begin()+index+count);
+        for (int i=index; i<index+count; ++i)
+            removeKey (i);
 
-        typename std::map<std::string, int>::iterator iter = mIndex.begin();
+        mRecords.erase (mRecords.begin()+index, mRecords.begin()+index+count);
+        mRowKeys.erase (mRowKeys.begin()+index, mRowKeys.begin()+index+count);
 
-        while (iter!=mIndex.end())
-        {
-            if (iter->second>=index)
-            {
-                if (iter->second>=index+count)
-                {
-                    iter->second -= count;
-                    ++iter;
-                }
-                else
-                {
-                    mIndex.erase (iter++);
-                }
-            }
-            else
-                ++iter;
-        }
+        updateKeyRows (index);
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -485,14 +541,12 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     int Collection<ESXRecordT, IdAccessorT>::searchId (const std::string& id) const
     {
-        std::string id2 = Misc::StringUtils::lowerCase(id);
-
-        std::map<std::string, int>::const_iterator iter = mIndex.find (id2);
+        typename IndexMap::const_iterator iter = mIndex.find (id);
 
         if (iter==mIndex.end())
             return -1;
 
-        return iter->second;
+        return mKeyRows[iter->second];
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
@@ -522,11 +576,13 @@ namespace CSMWorld
     {
         std::vector<std::string> ids;
 
-        for (typename std::map<std::string, int>::const_iterator iter = mIndex.begin();
-            iter!=mIndex.end(); ++iter)
+        for (std::map<std::string, int>::const_iterator iter = mSortedIndex.begin();
+            iter!=mSortedIndex.end(); ++iter)
         {
-            if (listDeleted || !mRecords[iter->second].isDeleted())
-                ids.push_back (IdAccessorT().getId (mRecords[iter->second].get()));
+            const Record<ESXRecordT>& record = mRecords[mKeyRows[iter->second]];
+
+            if (listDeleted || !record.isDeleted())
+                ids.push_back (IdAccessorT().getId (record.get()));
         }
 
         return ids;
@@ -554,18 +610,28 @@ namespace CSMWorld
 
         const Record<ESXRecordT>& record2 = dynamic_cast<const Record<ESXRecordT>&> (record);
 
-        mRecords.insert (mRecords.begin()+index, record2);
+        int key;
 
-        if (index<static_cast<int> (mRecords.size())-1)
+        if (mFreeKeys.empty())
+        {
+            key = static_cast<int> (mKeyRows.size());
+            mKeyRows.push_back (index);
+        }
+        else
         {
-            for (std::map<std::string, int>::iterator iter (mIndex.begin()); iter!=mIndex.end();
-                ++iter)
-                 if (iter->second>=index)
-                     ++(iter->second);
+            key = mFreeKeys.back();
+            mFreeKeys.pop_back();
         }
 
-        mIndex.insert (std::make_pair (Misc::StringUtils::lowerCase (IdAccessorT().getId (
-            record2.get())), index));
+        mRecords.insert (mRecords.begin()+index, record2);
+        mRowKeys.insert (mRowKeys.begin()+index, key);
+
+        updateKeyRows (index);
+
+        std::string id = IdAccessorT().getId (record2.get());
+
+        mIndex.insert (std::make_pair (id, key));
+        mSortedIndex.insert (std::make_pair (Misc::StringUtils::lowerCase (id), key));
     }
 
     template<typename ESXRecordT, typename IdAccessorT>
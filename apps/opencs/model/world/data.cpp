@@ -2,6 +2,8 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
 
 #include <QAbstractItemModel>
 
@@ -12,6 +14,7 @@
 
 #include <components/resource/scenemanager.hpp>
 #include <components/sceneutil/shadow.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/shader/shadermanager.hpp>
 #include <components/vfs/manager.hpp>
 #include <components/vfs/registerarchives.hpp>
@@ -24,6 +27,87 @@
 #include "resourcesmanager.hpp"
 #include "resourcetable.hpp"
 #include "nestedcoladapterimp.hpp"
+#include "textindex.hpp"
+
+namespace
+{
+    struct ParsedRecord
+    {
+        virtual ~ParsedRecord() {}
+    };
+
+    template<typename RecordT>
+    struct ParsedRecordImp : public ParsedRecord
+    {
+        RecordT mRecord;
+        bool mIsDeleted;
+
+        ParsedRecordImp() : mIsDeleted (false) {}
+    };
+
+    template<typename CollectionT>
+    std::unique_ptr<ParsedRecord> parseRecord (const CollectionT& collection, ESM::ESMReader& reader)
+    {
+        std::unique_ptr<ParsedRecordImp<typename CollectionT::ESXRecord> > record (
+            new ParsedRecordImp<typename CollectionT::ESXRecord>);
+
+        collection.loadRecord (record->mRecord, reader, record->mIsDeleted);
+
+        return std::move (record);
+    }
+
+    template<typename RecordT>
+    std::unique_ptr<ParsedRecord> parseRefIdRecord (ESM::ESMReader& reader)
+    {
+        std::unique_ptr<ParsedRecordImp<RecordT> > record (new ParsedRecordImp<RecordT>);
+
+        record->mRecord.load (reader, record->mIsDeleted);
+
+        return std::move (record);
+    }
+
+    template<typename CollectionT>
+    void loadRecord (CollectionT& collection, ESM::ESMReader& reader, bool base, ParsedRecord *parsed)
+    {
+        typedef ParsedRecordImp<typename CollectionT::ESXRecord> Parsed;
+
+        if (Parsed *record = dynamic_cast<Parsed *> (parsed))
+        {
+            reader.skipRecord();
+            collection.loadParsed (record->mRecord, record->mIsDeleted, base);
+        }
+        else
+            collection.load (reader, base);
+    }
+
+    template<typename RecordT>
+    void loadRefIdRecord (CSMWorld::RefIdCollection& collection, ESM::ESMReader& reader, bool base,
+        CSMWorld::UniversalId::Type type, ParsedRecord *parsed)
+    {
+        if (ParsedRecordImp<RecordT> *record = dynamic_cast<ParsedRecordImp<RecordT> *> (parsed))
+        {
+            reader.skipRecord();
+            collection.loadParsed (record->mRecord, record->mIsDeleted, base, type);
+        }
+        else
+            collection.load (reader, base, type);
+    }
+}
+
+struct CSMWorld::Data::ParsedFile
+{
+    boost::filesystem::path mPath;
+    int mReaderIndex;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mFinished;
+    bool mFailed;
+    // One entry per record of the file, empty for records that are read during loading
+    std::vector<std::unique_ptr<ParsedRecord> > mRecords;
+
+    ParsedFile() : mReaderIndex (0), mFinished (false), mFailed (false) {}
+};
 
 void CSMWorld::Data::addModel (QAbstractItemModel *model, UniversalId::Type type, bool update)
 {
@@ -35,6 +119,9 @@ void CSMWorld::Data::addModel (QAbstractItemModel *model, UniversalId::Type type
     if (type2!=UniversalId::Type_None)
         mModelIndex.insert (std::make_pair (type2, model));
 
+    if (IdTableBase *table = dynamic_cast<IdTableBase *> (model))
+        mTextIndices[model].reset (new TextIndex (*table));
+
     if (update)
     {
         connect (model, SIGNAL (dataChanged (const QModelIndex&, const QModelIndex&)),
@@ -69,7 +156,7 @@ CSMWorld::Data::Data (ToUTF8::FromType encoding, bool fsStrict, const Files::Pat
     const std::vector<std::string>& archives, const boost::filesystem::path& resDir)
 : mEncoder (encoding), mPathgrids (mCells), mRefs (mCells),
   mReader (0), mDialogue (0), mReaderIndex(1),
-  mFsStrict(fsStrict), mDataPaths(dataPaths), mArchives(archives)
+  mFsStrict(fsStrict), mDataPaths(dataPaths), mArchives(archives), mParsedRecord (0), mStopParsing (false)
 {
     mVFS.reset(new VFS::Manager(mFsStrict));
     VFS::registerArchives(mVFS.get(), Files::Collections(mDataPaths, !mFsStrict), mArchives, true);
@@ -81,12 +168,19 @@ CSMWorld::Data::Data (ToUTF8::FromType encoding, bool fsStrict, const Files::Pat
     Shader::ShaderManager::DefineMap shadowDefines = SceneUtil::ShadowManager::getShadowsDisabledDefines();
     defines["forcePPL"] = "0";
     defines["clamp"] = "1";
+    defines["gpuSkinning"] = "0";
+    defines["gpuMorphing"] = "0";
+    defines["objectInstancing"] = "0";
+    defines["terrainHeightmap"] = "0";
+    defines["clusteredLighting"] = "0";
     for (const auto& define : shadowDefines)
         defines[define.first] = define.second;
     mResourceSystem->getSceneManager()->getShaderManager().setGlobalDefines(defines);
 
     mResourceSystem->getSceneManager()->setShaderPath((resDir / "shaders").string());
 
+    mWorkQueue = new SceneUtil::WorkQueue (2);
+
     int index = 0;
 
     mGlobals.addColumn (new StringIdColumn<ESM::Global>);
@@ -606,6 +700,8 @@ CSMWorld::Data::Data (ToUTF8::FromType encoding, bool fsStrict, const Files::Pat
 
 CSMWorld::Data::~Data()
 {
+    stopParsing();
+
     for (std::vector<QAbstractItemModel *>::iterator iter (mModels.begin()); iter!=mModels.end(); ++iter)
         delete *iter;
 
@@ -622,6 +718,11 @@ std::shared_ptr<const Resource::ResourceSystem> CSMWorld::Data::getResourceSyste
     return mResourceSystem;
 }
 
+SceneUtil::WorkQueue* CSMWorld::Data::getWorkQueue()
+{
+    return mWorkQueue.get();
+}
+
 const CSMWorld::IdCollection<ESM::Global>& CSMWorld::Data::getGlobals() const
 {
     return mGlobals;
@@ -941,6 +1042,17 @@ QAbstractItemModel *CSMWorld::Data::getTableModel (const CSMWorld::UniversalId&
     return iter->second;
 }
 
+CSMWorld::TextIndex *CSMWorld::Data::getTextIndex (const QAbstractItemModel *model)
+{
+    std::map<const QAbstractItemModel *, std::unique_ptr<TextIndex> >::iterator iter =
+        mTextIndices.find (model);
+
+    if (iter==mTextIndices.end())
+        return 0;
+
+    return iter->second.get();
+}
+
 const CSMWorld::ActorAdapter* CSMWorld::Data::getActorAdapter() const
 {
     return mActorAdapter.get();
@@ -972,6 +1084,28 @@ int CSMWorld::Data::startLoading (const boost::filesystem::path& path, bool base
 
     mContentFileNames.insert(std::make_pair(path.filename().string(), mReader->getIndex()));
 
+    mParsed.reset();
+    mParsedRecord = 0;
+
+    for (std::vector<std::shared_ptr<ParsedFile> >::iterator iter (mParsedFiles.begin());
+        iter!=mParsedFiles.end(); ++iter)
+    {
+        if ((*iter)->mPath==path && (*iter)->mReaderIndex==mReader->getIndex())
+        {
+            std::shared_ptr<ParsedFile> file = *iter;
+            mParsedFiles.erase (iter);
+
+            std::unique_lock<std::mutex> lock (file->mMutex);
+            file->mCondition.wait (lock, [&file] { return file->mFinished; });
+
+            // otherwise the file is read as usual, which reports the error
+            if (!file->mFailed)
+                mParsed = file;
+
+            break;
+        }
+    }
+
     mBase = base;
     mProject = project;
 
@@ -1067,6 +1201,12 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
 
         mDialogue = 0;
 
+        if (mParsed)
+        {
+            std::vector<std::unique_ptr<ParsedRecord> >().swap (mParsed->mRecords);
+            mParsed.reset();
+        }
+
         loadFallbackEntries();
 
         return true;
@@ -1075,31 +1215,37 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
     ESM::NAME n = mReader->getRecName();
     mReader->getRecHeader();
 
+    ParsedRecord *parsed = 0;
+    std::size_t parsedIndex = mParsedRecord++;
+
+    if (mParsed && parsedIndex<mParsed->mRecords.size())
+        parsed = mParsed->mRecords[parsedIndex].get();
+
     bool unhandledRecord = false;
 
     switch (n.intval)
     {
-        case ESM::REC_GLOB: mGlobals.load (*mReader, mBase); break;
-        case ESM::REC_GMST: mGmsts.load (*mReader, mBase); break;
-        case ESM::REC_SKIL: mSkills.load (*mReader, mBase); break;
-        case ESM::REC_CLAS: mClasses.load (*mReader, mBase); break;
-        case ESM::REC_FACT: mFactions.load (*mReader, mBase); break;
-        case ESM::REC_RACE: mRaces.load (*mReader, mBase); break;
-        case ESM::REC_SOUN: mSounds.load (*mReader, mBase); break;
-        case ESM::REC_SCPT: mScripts.load (*mReader, mBase); break;
-        case ESM::REC_REGN: mRegions.load (*mReader, mBase); break;
-        case ESM::REC_BSGN: mBirthsigns.load (*mReader, mBase); break;
-        case ESM::REC_SPEL: mSpells.load (*mReader, mBase); break;
-        case ESM::REC_ENCH: mEnchantments.load (*mReader, mBase); break;
-        case ESM::REC_BODY: mBodyParts.load (*mReader, mBase); break;
-        case ESM::REC_SNDG: mSoundGens.load (*mReader, mBase); break;
-        case ESM::REC_MGEF: mMagicEffects.load (*mReader, mBase); break;
+        case ESM::REC_GLOB: loadRecord (mGlobals, *mReader, mBase, parsed); break;
+        case ESM::REC_GMST: loadRecord (mGmsts, *mReader, mBase, parsed); break;
+        case ESM::REC_SKIL: loadRecord (mSkills, *mReader, mBase, parsed); break;
+        case ESM::REC_CLAS: loadRecord (mClasses, *mReader, mBase, parsed); break;
+        case ESM::REC_FACT: loadRecord (mFactions, *mReader, mBase, parsed); break;
+        case ESM::REC_RACE: loadRecord (mRaces, *mReader, mBase, parsed); break;
+        case ESM::REC_SOUN: loadRecord (mSounds, *mReader, mBase, parsed); break;
+        case ESM::REC_SCPT: loadRecord (mScripts, *mReader, mBase, parsed); break;
+        case ESM::REC_REGN: loadRecord (mRegions, *mReader, mBase, parsed); break;
+        case ESM::REC_BSGN: loadRecord (mBirthsigns, *mReader, mBase, parsed); break;
+        case ESM::REC_SPEL: loadRecord (mSpells, *mReader, mBase, parsed); break;
+        case ESM::REC_ENCH: loadRecord (mEnchantments, *mReader, mBase, parsed); break;
+        case ESM::REC_BODY: loadRecord (mBodyParts, *mReader, mBase, parsed); break;
+        case ESM::REC_SNDG: loadRecord (mSoundGens, *mReader, mBase, parsed); break;
+        case ESM::REC_MGEF: loadRecord (mMagicEffects, *mReader, mBase, parsed); break;
         case ESM::REC_PGRD: mPathgrids.load (*mReader, mBase); break;
-        case ESM::REC_SSCR: mStartScripts.load (*mReader, mBase); break;
+        case ESM::REC_SSCR: loadRecord (mStartScripts, *mReader, mBase, parsed); break;
 
-        case ESM::REC_LTEX: mLandTextures.load (*mReader, mBase); break;
+        case ESM::REC_LTEX: loadRecord (mLandTextures, *mReader, mBase, parsed); break;
 
-        case ESM::REC_LAND: mLand.load(*mReader, mBase); break;
+        case ESM::REC_LAND: loadRecord (mLand, *mReader, mBase, parsed); break;
 
         case ESM::REC_CELL:
         {
@@ -1116,29 +1262,66 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
             break;
         }
 
-        case ESM::REC_ACTI: mReferenceables.load (*mReader, mBase, UniversalId::Type_Activator); break;
-        case ESM::REC_ALCH: mReferenceables.load (*mReader, mBase, UniversalId::Type_Potion); break;
-        case ESM::REC_APPA: mReferenceables.load (*mReader, mBase, UniversalId::Type_Apparatus); break;
-        case ESM::REC_ARMO: mReferenceables.load (*mReader, mBase, UniversalId::Type_Armor); break;
-        case ESM::REC_BOOK: mReferenceables.load (*mReader, mBase, UniversalId::Type_Book); break;
-        case ESM::REC_CLOT: mReferenceables.load (*mReader, mBase, UniversalId::Type_Clothing); break;
-        case ESM::REC_CONT: mReferenceables.load (*mReader, mBase, UniversalId::Type_Container); break;
-        case ESM::REC_CREA: mReferenceables.load (*mReader, mBase, UniversalId::Type_Creature); break;
-        case ESM::REC_DOOR: mReferenceables.load (*mReader, mBase, UniversalId::Type_Door); break;
-        case ESM::REC_INGR: mReferenceables.load (*mReader, mBase, UniversalId::Type_Ingredient); break;
+        case ESM::REC_ACTI:
+            loadRefIdRecord<ESM::Activator> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Activator, parsed); break;
+        case ESM::REC_ALCH:
+            loadRefIdRecord<ESM::Potion> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Potion, parsed); break;
+        case ESM::REC_APPA:
+            loadRefIdRecord<ESM::Apparatus> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Apparatus, parsed); break;
+        case ESM::REC_ARMO:
+            loadRefIdRecord<ESM::Armor> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Armor, parsed); break;
+        case ESM::REC_BOOK:
+            loadRefIdRecord<ESM::Book> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Book, parsed); break;
+        case ESM::REC_CLOT:
+            loadRefIdRecord<ESM::Clothing> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Clothing, parsed); break;
+        case ESM::REC_CONT:
+            loadRefIdRecord<ESM::Container> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Container, parsed); break;
+        case ESM::REC_CREA:
+            loadRefIdRecord<ESM::Creature> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Creature, parsed); break;
+        case ESM::REC_DOOR:
+            loadRefIdRecord<ESM::Door> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Door, parsed); break;
+        case ESM::REC_INGR:
+            loadRefIdRecord<ESM::Ingredient> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Ingredient, parsed); break;
         case ESM::REC_LEVC:
-            mReferenceables.load (*mReader, mBase, UniversalId::Type_CreatureLevelledList); break;
+            loadRefIdRecord<ESM::CreatureLevList> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_CreatureLevelledList, parsed); break;
         case ESM::REC_LEVI:
-            mReferenceables.load (*mReader, mBase, UniversalId::Type_ItemLevelledList); break;
-        case ESM::REC_LIGH: mReferenceables.load (*mReader, mBase, UniversalId::Type_Light); break;
-        case ESM::REC_LOCK: mReferenceables.load (*mReader, mBase, UniversalId::Type_Lockpick); break;
+            loadRefIdRecord<ESM::ItemLevList> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_ItemLevelledList, parsed); break;
+        case ESM::REC_LIGH:
+            loadRefIdRecord<ESM::Light> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Light, parsed); break;
+        case ESM::REC_LOCK:
+            loadRefIdRecord<ESM::Lockpick> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Lockpick, parsed); break;
         case ESM::REC_MISC:
-            mReferenceables.load (*mReader, mBase, UniversalId::Type_Miscellaneous); break;
-        case ESM::REC_NPC_: mReferenceables.load (*mReader, mBase, UniversalId::Type_Npc); break;
-        case ESM::REC_PROB: mReferenceables.load (*mReader, mBase, UniversalId::Type_Probe); break;
-        case ESM::REC_REPA: mReferenceables.load (*mReader, mBase, UniversalId::Type_Repair); break;
-        case ESM::REC_STAT: mReferenceables.load (*mReader, mBase, UniversalId::Type_Static); break;
-        case ESM::REC_WEAP: mReferenceables.load (*mReader, mBase, UniversalId::Type_Weapon); break;
+            loadRefIdRecord<ESM::Miscellaneous> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Miscellaneous, parsed); break;
+        case ESM::REC_NPC_:
+            loadRefIdRecord<ESM::NPC> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Npc, parsed); break;
+        case ESM::REC_PROB:
+            loadRefIdRecord<ESM::Probe> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Probe, parsed); break;
+        case ESM::REC_REPA:
+            loadRefIdRecord<ESM::Repair> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Repair, parsed); break;
+        case ESM::REC_STAT:
+            loadRefIdRecord<ESM::Static> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Static, parsed); break;
+        case ESM::REC_WEAP:
+            loadRefIdRecord<ESM::Weapon> (mReferenceables, *mReader, mBase,
+                UniversalId::Type_Weapon, parsed); break;
 
         case ESM::REC_DIAL:
         {
@@ -1238,9 +1421,148 @@ bool CSMWorld::Data::continueLoading (CSMDoc::Messages& messages)
         mReader->skipRecord();
     }
 
+    if (parsed)
+        mParsed->mRecords[parsedIndex].reset();
+
     return false;
 }
 
+void CSMWorld::Data::startParsing (const std::vector<std::pair<boost::filesystem::path, bool> >& files)
+{
+    stopParsing();
+    mStopParsing = false;
+
+    // predict the reader indices startLoading will use
+    int readerIndex = mReaderIndex;
+
+    for (std::vector<std::pair<boost::filesystem::path, bool> >::const_iterator iter (files.begin());
+        iter!=files.end(); ++iter)
+    {
+        std::shared_ptr<ParsedFile> file (new ParsedFile);
+        file->mPath = iter->first;
+        file->mReaderIndex = iter->second ? readerIndex++ : 0;
+        mParsedFiles.push_back (file);
+    }
+
+    if (mParsedFiles.empty())
+        return;
+
+    // Files are taken in load order, so the first ones are ready first while the loader merges them
+    std::vector<std::shared_ptr<ParsedFile> > parsedFiles (mParsedFiles);
+    std::shared_ptr<std::atomic<std::size_t> > next (new std::atomic<std::size_t> (0));
+    ToUTF8::FromType encoding = mEncoder.getSourceEncoding();
+
+    std::size_t threads = std::min<std::size_t> (std::max (1u, std::thread::hardware_concurrency()),
+        parsedFiles.size());
+
+    for (std::size_t i=0; i<threads; ++i)
+        mParseThreads.emplace_back ([this, parsedFiles, next, encoding] ()
+        {
+            // encoders are not thread safe
+            ToUTF8::Utf8Encoder encoder (encoding);
+
+            for (std::size_t index = (*next)++; index<parsedFiles.size(); index = (*next)++)
+                parseFile (*parsedFiles[index], encoder);
+        });
+}
+
+void CSMWorld::Data::stopParsing()
+{
+    mStopParsing = true;
+
+    for (std::vector<std::thread>::iterator iter (mParseThreads.begin()); iter!=mParseThreads.end(); ++iter)
+        iter->join();
+
+    mParseThreads.clear();
+    mParsedFiles.clear();
+}
+
+void CSMWorld::Data::parseFile (ParsedFile& file, ToUTF8::Utf8Encoder& encoder) const
+{
+    std::vector<std::unique_ptr<ParsedRecord> > records;
+    bool failed = true;
+
+    try
+    {
+        ESM::ESMReader reader;
+        reader.setEncoder (&encoder);
+        reader.setIndex (file.mReaderIndex);
+        reader.open (file.mPath.string());
+
+        while (reader.hasMoreRecs() && !mStopParsing)
+        {
+            ESM::NAME n = reader.getRecName();
+            reader.getRecHeader();
+
+            std::unique_ptr<ParsedRecord> record;
+
+            // Cells, references, path grids, dialogues and infos depend on earlier records and
+            // are read during loading
+            switch (n.intval)
+            {
+                case ESM::REC_GLOB: record = parseRecord (mGlobals, reader); break;
+                case ESM::REC_GMST: record = parseRecord (mGmsts, reader); break;
+                case ESM::REC_SKIL: record = parseRecord (mSkills, reader); break;
+                case ESM::REC_CLAS: record = parseRecord (mClasses, reader); break;
+                case ESM::REC_FACT: record = parseRecord (mFactions, reader); break;
+                case ESM::REC_RACE: record = parseRecord (mRaces, reader); break;
+                case ESM::REC_SOUN: record = parseRecord (mSounds, reader); break;
+                case ESM::REC_SCPT: record = parseRecord (mScripts, reader); break;
+                case ESM::REC_REGN: record = parseRecord (mRegions, reader); break;
+                case ESM::REC_BSGN: record = parseRecord (mBirthsigns, reader); break;
+                case ESM::REC_SPEL: record = parseRecord (mSpells, reader); break;
+                case ESM::REC_ENCH: record = parseRecord (mEnchantments, reader); break;
+                case ESM::REC_BODY: record = parseRecord (mBodyParts, reader); break;
+                case ESM::REC_SNDG: record = parseRecord (mSoundGens, reader); break;
+                case ESM::REC_MGEF: record = parseRecord (mMagicEffects, reader); break;
+                case ESM::REC_SSCR: record = parseRecord (mStartScripts, reader); break;
+                case ESM::REC_LTEX: record = parseRecord (mLandTextures, reader); break;
+                case ESM::REC_LAND: record = parseRecord (mLand, reader); break;
+
+                case ESM::REC_ACTI: record = parseRefIdRecord<ESM::Activator> (reader); break;
+                case ESM::REC_ALCH: record = parseRefIdRecord<ESM::Potion> (reader); break;
+                case ESM::REC_APPA: record = parseRefIdRecord<ESM::Apparatus> (reader); break;
+                case ESM::REC_ARMO: record = parseRefIdRecord<ESM::Armor> (reader); break;
+                case ESM::REC_BOOK: record = parseRefIdRecord<ESM::Book> (reader); break;
+                case ESM::REC_CLOT: record = parseRefIdRecord<ESM::Clothing> (reader); break;
+                case ESM::REC_CONT: record = parseRefIdRecord<ESM::Container> (reader); break;
+                case ESM::REC_CREA: record = parseRefIdRecord<ESM::Creature> (reader); break;
+                case ESM::REC_DOOR: record = parseRefIdRecord<ESM::Door> (reader); break;
+                case ESM::REC_INGR: record = parseRefIdRecord<ESM::Ingredient> (reader); break;
+                case ESM::REC_LEVC: record = parseRefIdRecord<ESM::CreatureLevList> (reader); break;
+                case ESM::REC_LEVI: record = parseRefIdRecord<ESM::ItemLevList> (reader); break;
+                case ESM::REC_LIGH: record = parseRefIdRecord<ESM::Light> (reader); break;
+                case ESM::REC_LOCK: record = parseRefIdRecord<ESM::Lockpick> (reader); break;
+                case ESM::REC_MISC: record = parseRefIdRecord<ESM::Miscellaneous> (reader); break;
+                case ESM::REC_NPC_: record = parseRefIdRecord<ESM::NPC> (reader); break;
+                case ESM::REC_PROB: record = parseRefIdRecord<ESM::Probe> (reader); break;
+                case ESM::REC_REPA: record = parseRefIdRecord<ESM::Repair> (reader); break;
+                case ESM::REC_STAT: record = parseRefIdRecord<ESM::Static> (reader); break;
+                case ESM::REC_WEAP: record = parseRefIdRecord<ESM::Weapon> (reader); break;
+
+                default: break;
+            }
+
+            if (!record)
+                reader.skipRecord();
+
+            records.push_back (std::move (record));
+        }
+
+        failed = mStopParsing;
+    }
+    catch (const std::exception&)
+    {
+        // the file is read again during loading, which reports the problem
+    }
+
+    std::lock_guard<std::mutex> lock (file.mMutex);
+    file.mRecords.swap (records);
+    file.mFailed = failed;
+    file.mFinished = true;
+    file.mCondition.notify_all();
+}
+
 bool CSMWorld::Data::hasId (const std::string& id) const
 {
     return
@@ -1,7 +1,10 @@
 #ifndef CSM_WOLRD_DATA_H
 #define CSM_WOLRD_DATA_H
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include <boost/filesystem/path.hpp>
@@ -9,6 +12,8 @@
 #include <QObject>
 #include <QModelIndex>
 
+#include <osg/ref_ptr>
+
 #include <components/esm/loadglob.hpp>
 #include <components/esm/loadgmst.hpp>
 #include <components/esm/loadskil.hpp>
@@ -61,6 +66,11 @@ namespace VFS
     class Manager;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace Fallback
 {
     class Map;
@@ -76,6 +86,7 @@ namespace CSMWorld
 {
     class ResourcesManager;
     class Resources;
+    class TextIndex;
 
     class Data : public QObject
     {
@@ -114,6 +125,7 @@ namespace CSMWorld
             std::unique_ptr<ActorAdapter> mActorAdapter;
             std::vector<QAbstractItemModel *> mModels;
             std::map<UniversalId::Type, QAbstractItemModel *> mModelIndex;
+            std::map<const QAbstractItemModel *, std::unique_ptr<TextIndex> > mTextIndices;
             ESM::ESMReader *mReader;
             const ESM::Dialogue *mDialogue; // last loaded dialogue
             bool mBase;
@@ -127,15 +139,27 @@ namespace CSMWorld
             std::unique_ptr<VFS::Manager> mVFS;
             ResourcesManager mResourcesManager;
             std::shared_ptr<Resource::ResourceSystem> mResourceSystem;
+            osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue; // destroyed first, its items use the resource system
 
             std::vector<std::shared_ptr<ESM::ESMReader> > mReaders;
 
             std::map<std::string, int> mContentFileNames;
 
+            struct ParsedFile;
+
+            std::vector<std::shared_ptr<ParsedFile> > mParsedFiles; // files parsed ahead, not loaded yet
+            std::shared_ptr<ParsedFile> mParsed; // file being loaded, if it was parsed ahead
+            std::size_t mParsedRecord;
+            std::vector<std::thread> mParseThreads;
+            std::atomic<bool> mStopParsing;
+
             // not implemented
             Data (const Data&);
             Data& operator= (const Data&);
 
+            void parseFile (ParsedFile& file, ToUTF8::Utf8Encoder& encoder) const;
+            ///< Read the records of \a file that don't depend on other records. Called on a worker thread.
+
             void addModel (QAbstractItemModel *model, UniversalId::Type type,
                 bool update = true);
 
@@ -160,6 +184,9 @@ namespace CSMWorld
 
             std::shared_ptr<const Resource::ResourceSystem> getResourceSystem() const;
 
+            /// Queue for loading models and terrain of the scene views in the background
+            SceneUtil::WorkQueue* getWorkQueue();
+
             const IdCollection<ESM::Global>& getGlobals() const;
 
             IdCollection<ESM::Global>& getGlobals();
@@ -285,6 +312,10 @@ namespace CSMWorld
             /// \note The returned table may either be the model for the ID itself or the model that
             /// contains the record specified by the ID.
 
+            TextIndex *getTextIndex (const QAbstractItemModel *model);
+            ///< Returns the word index used for searching \a model or 0, if \a model is not a
+            /// table of records.
+
             const ActorAdapter* getActorAdapter() const;
 
             ActorAdapter* getActorAdapter();
@@ -302,6 +333,16 @@ namespace CSMWorld
             bool continueLoading (CSMDoc::Messages& messages);
             ///< \return Finished?
 
+            void startParsing (const std::vector<std::pair<boost::filesystem::path, bool> >& files);
+            ///< Read the records of \a files that don't depend on other records on worker threads, so
+            /// that continueLoading only has to add them.
+            ///
+            /// \param files The content files in the order they will be loaded in and whether they
+            /// will be loaded as base.
+
+            void stopParsing();
+            ///< Stop the worker threads and discard the records that haven't been loaded.
+
             bool hasId (const std::string& id) const;
 
             std::vector<std::string> getIds (bool listDeleted = true) const;
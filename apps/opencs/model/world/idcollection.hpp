@@ -12,13 +12,21 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT = IdAccessor<ESXRecordT> >
     class IdCollection : public Collection<ESXRecordT, IdAccessorT>
     {
-            virtual void loadRecord (ESXRecordT& record, ESM::ESMReader& reader, bool& isDeleted);
-
         public:
 
+            virtual void loadRecord (ESXRecordT& record, ESM::ESMReader& reader, bool& isDeleted) const;
+            ///< Read a record without adding it to the collection.
+            ///
+            /// \note May be called from another thread, as long as the collection is not destroyed.
+
             /// \return Index of loaded record (-1 if no record was loaded)
             int load (ESM::ESMReader& reader, bool base);
 
+            /// Add a record read by loadRecord.
+            ///
+            /// \return Index of loaded record (-1 if no record was loaded)
+            int loadParsed (const ESXRecordT& record, bool isDeleted, bool base);
+
             /// \param index Index at which the record can be found.
             /// Special values: -2 index unknown, -1 record does not exist yet and therefore
             /// does not have an index
@@ -35,14 +43,14 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     void IdCollection<ESXRecordT, IdAccessorT>::loadRecord (ESXRecordT& record,
                                                             ESM::ESMReader& reader,
-                                                            bool& isDeleted)
+                                                            bool& isDeleted) const
     {
         record.load (reader, isDeleted);
     }
 
     template<>
     inline void IdCollection<Land, IdAccessor<Land> >::loadRecord (Land& record,
-        ESM::ESMReader& reader, bool& isDeleted)
+        ESM::ESMReader& reader, bool& isDeleted) const
     {
         record.load (reader, isDeleted);
 
@@ -64,6 +72,13 @@ namespace CSMWorld
 
         loadRecord (record, reader, isDeleted);
 
+        return loadParsed (record, isDeleted, base);
+    }
+
+    template<typename ESXRecordT, typename IdAccessorT>
+    int IdCollection<ESXRecordT, IdAccessorT>::loadParsed (const ESXRecordT& record, bool isDeleted,
+        bool base)
+    {
         std::string id = IdAccessorT().getId (record);
         int index = this->searchId (id);
 
@@ -54,6 +54,7 @@ CSMWorld::IdTableProxyModel::IdTableProxyModel (QObject *parent)
       mSourceModel(nullptr)
 {
     setSortCaseSensitivity (Qt::CaseInsensitive);
+    setDynamicSortFilter (true);
 }
 
 QModelIndex CSMWorld::IdTableProxyModel::getModelIndex (const std::string& id, int column) const
@@ -125,9 +126,12 @@ void CSMWorld::IdTableProxyModel::refreshFilter()
     invalidateFilter();
 }
 
+// The filter only depends on the columns of the tested row, so the dynamic filtering of
+// QSortFilterProxyModel, which only tests inserted and changed rows, keeps the model up to date.
+// Re-testing every row on each change made editing large tables slow.
+
 void CSMWorld::IdTableProxyModel::sourceRowsInserted(const QModelIndex &parent, int /*start*/, int end)
 {
-    refreshFilter();
     if (!parent.isValid())
     {
         emit rowAdded(getRecordId(end).toUtf8().constData());
@@ -136,10 +140,8 @@ void CSMWorld::IdTableProxyModel::sourceRowsInserted(const QModelIndex &parent,
 
 void CSMWorld::IdTableProxyModel::sourceRowsRemoved(const QModelIndex &/*parent*/, int /*start*/, int /*end*/)
 {
-    refreshFilter();
 }
 
 void CSMWorld::IdTableProxyModel::sourceDataChanged(const QModelIndex &/*topLeft*/, const QModelIndex &/*bottomRight*/)
 {
-    refreshFilter();
 }
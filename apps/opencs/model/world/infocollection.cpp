@@ -151,7 +151,7 @@ CSMWorld::InfoCollection::Range CSMWorld::InfoCollection::getTopicRange (const s
     for (; iter!=getIdMap().end(); ++iter)
     {
         std::string testTopicId =
-            Misc::StringUtils::lowerCase (getRecord (iter->second).get().mTopicId);
+            Misc::StringUtils::lowerCase (getRecord (getKeyRow (iter->second)).get().mTopicId);
 
         if (testTopicId==topic2)
             break;
@@ -165,7 +165,7 @@ CSMWorld::InfoCollection::Range CSMWorld::InfoCollection::getTopicRange (const s
     if (iter==getIdMap().end())
         return Range (getRecords().end(), getRecords().end());
 
-    RecordConstIterator begin = getRecords().begin()+iter->second;
+    RecordConstIterator begin = getRecords().begin()+getKeyRow (iter->second);
 
     while (begin != getRecords().begin())
     {
@@ -197,18 +197,19 @@ void CSMWorld::InfoCollection::removeDialogueInfos(const std::string& dialogueId
     std::map<std::string, int>::const_iterator end = getIdMap().end();
     for (; current != end; ++current)
     {
-        Record<Info> record = getRecord(current->second);
+        int index = getKeyRow(current->second);
+        Record<Info> record = getRecord(index);
 
         if (Misc::StringUtils::ciEqual(dialogueId, record.get().mTopicId))
         {
             if (record.mState == RecordBase::State_ModifiedOnly)
             {
-                erasedRecords.push_back(current->second);
+                erasedRecords.push_back(index);
             }
             else
             {
                 record.mState = RecordBase::State_Deleted;
-                setRecord(current->second, record);
+                setRecord(index, record);
             }
         }
         else
@@ -105,6 +105,13 @@ namespace CSMWorld
 
             void load (ESM::ESMReader& reader, bool base, UniversalId::Type type);
 
+            /// Add a record of \a type that has already been read.
+            template<typename RecordT>
+            void loadParsed (const RecordT& record, bool isDeleted, bool base, UniversalId::Type type)
+            {
+                mData.loadParsed (record, isDeleted, base, type);
+            }
+
             virtual int getAppendIndex (const std::string& id, UniversalId::Type type) const;
             ///< \param type Will be ignored, unless the collection supports multiple record types
 
@@ -179,7 +179,11 @@ void CSMWorld::RefIdData::load (ESM::ESMReader& reader, bool base, CSMWorld::Uni
     if (found == mRecordContainers.end())
         throw std::logic_error ("Invalid Referenceable ID type");
 
-    int index = found->second->load(reader, base);
+    finishLoading (found->second->load(reader, base), base, type);
+}
+
+void CSMWorld::RefIdData::finishLoading (int index, bool base, CSMWorld::UniversalId::Type type)
+{
     if (index != -1)
     {
         LocalIndex localIndex = LocalIndex(index, type);
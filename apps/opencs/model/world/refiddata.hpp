@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <map>
+#include <stdexcept>
 
 #include <components/esm/loadacti.hpp>
 #include <components/esm/loadalch.hpp>
@@ -79,6 +80,12 @@ namespace CSMWorld
         virtual int load (ESM::ESMReader& reader, bool base);
         ///< \return index of a loaded record or -1 if no record was loaded
 
+        int load (const RecordT& record, bool isDeleted, bool base, int index);
+        ///< Add a record that has already been read.
+        ///
+        /// \param index Index of the record with the same ID (-1 if there is none)
+        /// \return index of a loaded record or -1 if no record was loaded
+
         virtual void erase (int index, int count);
 
         virtual std::string getId (int index) const;
@@ -143,9 +150,15 @@ namespace CSMWorld
             }
         }
 
+        return load (record, isDeleted, base, index==numRecords ? -1 : index);
+    }
+
+    template<typename RecordT>
+    int RefIdDataContainer<RecordT>::load (const RecordT& record, bool isDeleted, bool base, int index)
+    {
         if (isDeleted)
         {
-            if (index == numRecords)
+            if (index == -1)
             {
                 // deleting a record that does not exist
                 // ignore it for now
@@ -159,8 +172,9 @@ namespace CSMWorld
         }
         else
         {
-            if (index == numRecords)
+            if (index == -1)
             {
+                index = getSize();
                 appendRecord(record.mId, base);
                 if (base)
                 {
@@ -254,6 +268,9 @@ namespace CSMWorld
 
             std::string getRecordId(const LocalIndex &index) const;
 
+            void finishLoading (int index, bool base, UniversalId::Type type);
+            ///< Update the index after a record has been loaded into the container of \a type.
+
         public:
 
             RefIdData();
@@ -279,6 +296,10 @@ namespace CSMWorld
 
             void load (ESM::ESMReader& reader, bool base, UniversalId::Type type);
 
+            template<typename RecordT>
+            void loadParsed (const RecordT& record, bool isDeleted, bool base, UniversalId::Type type);
+            ///< Add a record of \a type that has already been read.
+
             int getSize() const;
 
             std::vector<std::string> getIds (bool listDeleted = true) const;
@@ -312,6 +333,28 @@ namespace CSMWorld
 
             void copyTo (int index, RefIdData& target) const;
     };
+
+    template<typename RecordT>
+    void RefIdData::loadParsed (const RecordT& record, bool isDeleted, bool base, UniversalId::Type type)
+    {
+        std::map<UniversalId::Type, RefIdDataContainerBase *>::iterator found =
+            mRecordContainers.find (type);
+
+        if (found == mRecordContainers.end())
+            throw std::logic_error ("Invalid Referenceable ID type");
+
+        RefIdDataContainer<RecordT>& container = dynamic_cast<RefIdDataContainer<RecordT>&> (*found->second);
+
+        // Look the record up in the index instead of searching the container
+        int index = -1;
+        std::map<std::string, LocalIndex>::const_iterator iter =
+            mIndex.find (Misc::StringUtils::lowerCase (record.mId));
+
+        if (iter != mIndex.end() && iter->second.second == type)
+            index = iter->second.first;
+
+        finishLoading (container.load (record, isDeleted, base, index), base, type);
+    }
 }
 
 #endif
@@ -22,10 +22,8 @@ void CSMWorld::Resources::recreate(const VFS::Manager* vfs, const char * const *
 
     int baseSize = mBaseDirectory.size();
 
-    const std::map<std::string, VFS::File*>& index = vfs->getIndex();
-    for (std::map<std::string, VFS::File*>::const_iterator it = index.begin(); it != index.end(); ++it)
+    for (const std::string& filepath : vfs->getRecursiveDirectoryIterator(""))
     {
-        std::string filepath = it->first;
         if (static_cast<int> (filepath.size())<baseSize+1 ||
             filepath.substr (0, baseSize)!=mBaseDirectory ||
             (filepath[baseSize]!='/' && filepath[baseSize]!='\\'))
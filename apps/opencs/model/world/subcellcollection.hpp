@@ -20,7 +20,7 @@ namespace CSMWorld
     {
             const IdCollection<Cell>& mCells;
 
-            virtual void loadRecord (ESXRecordT& record, ESM::ESMReader& reader, bool& isDeleted);
+            virtual void loadRecord (ESXRecordT& record, ESM::ESMReader& reader, bool& isDeleted) const;
 
         public:
 
@@ -30,7 +30,7 @@ namespace CSMWorld
     template<typename ESXRecordT, typename IdAccessorT>
     void SubCellCollection<ESXRecordT, IdAccessorT>::loadRecord (ESXRecordT& record,
                                                                  ESM::ESMReader& reader,
-                                                                 bool& isDeleted)
+                                                                 bool& isDeleted) const
     {
         record.load (reader, isDeleted, mCells);
     }
@@ -0,0 +1,346 @@
+#include "textindex.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "columnbase.hpp"
+#include "idtablebase.hpp"
+
+namespace
+{
+    bool isWordChar (QChar c)
+    {
+        return c.isLetterOrNumber() || c==QLatin1Char ('_');
+    }
+
+    struct Word
+    {
+        std::string mText;
+        bool mAtStart; // preceded by a non-word character, i.e. the word must start a token
+        bool mAtEnd; // followed by a non-word character, i.e. the word must end a token
+    };
+
+    void splitWords (const QString& text, std::vector<Word>& words)
+    {
+        int size = text.size();
+
+        for (int i=0; i<size;)
+        {
+            if (!isWordChar (text[i]))
+            {
+                ++i;
+                continue;
+            }
+
+            int begin = i;
+
+            while (i<size && isWordChar (text[i]))
+                ++i;
+
+            Word word;
+            word.mText = text.mid (begin, i-begin).toUtf8().constData();
+            word.mAtStart = begin>0;
+            word.mAtEnd = i<size;
+            words.push_back (word);
+        }
+    }
+
+    bool matches (const std::string& token, const Word& word)
+    {
+        if (token.size()<word.mText.size())
+            return false;
+
+        if (word.mAtStart && word.mAtEnd)
+            return token==word.mText;
+
+        if (word.mAtStart)
+            return token.compare (0, word.mText.size(), word.mText)==0;
+
+        if (word.mAtEnd)
+            return token.compare (token.size()-word.mText.size(), word.mText.size(), word.mText)==0;
+
+        return token.find (word.mText)!=std::string::npos;
+    }
+
+    template<typename T>
+    void insertSorted (std::vector<T>& container, T value)
+    {
+        typename std::vector<T>::iterator iter =
+            std::lower_bound (container.begin(), container.end(), value);
+
+        if (iter==container.end() || *iter!=value)
+            container.insert (iter, value);
+    }
+
+    template<typename T>
+    void eraseSorted (std::vector<T>& container, T value)
+    {
+        typename std::vector<T>::iterator iter =
+            std::lower_bound (container.begin(), container.end(), value);
+
+        if (iter!=container.end() && *iter==value)
+            container.erase (iter);
+    }
+}
+
+CSMWorld::TextIndex::TextIndex (IdTableBase& model)
+: mModel (model), mBuilt (false), mIdColumn (-1)
+{
+    connect (&model, SIGNAL (dataChanged (const QModelIndex&, const QModelIndex&)),
+        this, SLOT (dataChanged (const QModelIndex&, const QModelIndex&)));
+    connect (&model, SIGNAL (rowsInserted (const QModelIndex&, int, int)),
+        this, SLOT (rowsInserted (const QModelIndex&, int, int)));
+    connect (&model, SIGNAL (rowsAboutToBeRemoved (const QModelIndex&, int, int)),
+        this, SLOT (rowsAboutToBeRemoved (const QModelIndex&, int, int)));
+    connect (&model, SIGNAL (modelReset()), this, SLOT (invalidate()));
+}
+
+void CSMWorld::TextIndex::build()
+{
+    clear();
+
+    int columns = mModel.columnCount();
+
+    for (int i=0; i<columns; ++i)
+    {
+        ColumnBase::Display display = static_cast<ColumnBase::Display> (
+            mModel.headerData (i, Qt::Horizontal, ColumnBase::Role_Display).toInt());
+
+        if (ColumnBase::isText (display) || ColumnBase::isId (display) || ColumnBase::isScript (display))
+            mColumns.push_back (i);
+    }
+
+    mIdColumn = mModel.findColumnIndex (Columns::ColumnId_Id);
+
+    if (mIdColumn!=-1)
+    {
+        int rows = mModel.rowCount();
+
+        for (int i=0; i<rows; ++i)
+            indexRow (i);
+    }
+
+    mBuilt = true;
+}
+
+void CSMWorld::TextIndex::clear()
+{
+    mColumns.clear();
+    mTokens.clear();
+    mTokenIndex.clear();
+    mPostings.clear();
+    mHandles.clear();
+    mIds.clear();
+    mRowTokens.clear();
+    mFreeHandles.clear();
+}
+
+void CSMWorld::TextIndex::indexRow (int row)
+{
+    std::string id = mModel.data (mModel.index (row, mIdColumn)).toString().toUtf8().constData();
+
+    std::vector<Word> words;
+
+    for (std::vector<int>::const_iterator iter (mColumns.begin()); iter!=mColumns.end(); ++iter)
+        splitWords (mModel.data (mModel.index (row, *iter)).toString().toLower(), words);
+
+    std::vector<std::uint32_t> tokens;
+    tokens.reserve (words.size());
+
+    for (std::vector<Word>::const_iterator iter (words.begin()); iter!=words.end(); ++iter)
+        tokens.push_back (getToken (iter->mText));
+
+    std::sort (tokens.begin(), tokens.end());
+    tokens.erase (std::unique (tokens.begin(), tokens.end()), tokens.end());
+
+    Handle handle;
+
+    std::unordered_map<std::string, Handle>::const_iterator iter = mHandles.find (id);
+
+    if (iter!=mHandles.end())
+    {
+        handle = iter->second;
+
+        const std::vector<std::uint32_t>& oldTokens = mRowTokens[handle];
+
+        for (std::vector<std::uint32_t>::const_iterator iter2 (oldTokens.begin());
+            iter2!=oldTokens.end(); ++iter2)
+            eraseSorted (mPostings[*iter2], handle);
+    }
+    else
+    {
+        if (mFreeHandles.empty())
+        {
+            handle = static_cast<Handle> (mIds.size());
+            mIds.push_back (id);
+            mRowTokens.push_back (std::vector<std::uint32_t>());
+        }
+        else
+        {
+            handle = mFreeHandles.back();
+            mFreeHandles.pop_back();
+            mIds[handle] = id;
+        }
+
+        mHandles.insert (std::make_pair (id, handle));
+    }
+
+    // New handles are mostly the largest ones, so this is usually an append
+    for (std::vector<std::uint32_t>::const_iterator iter2 (tokens.begin()); iter2!=tokens.end(); ++iter2)
+        insertSorted (mPostings[*iter2], handle);
+
+    mRowTokens[handle].swap (tokens);
+}
+
+void CSMWorld::TextIndex::removeRow (const std::string& id)
+{
+    std::unordered_map<std::string, Handle>::iterator iter = mHandles.find (id);
+
+    if (iter==mHandles.end())
+        return;
+
+    Handle handle = iter->second;
+    mHandles.erase (iter);
+
+    std::vector<std::uint32_t>& tokens = mRowTokens[handle];
+
+    for (std::vector<std::uint32_t>::const_iterator iter2 (tokens.begin()); iter2!=tokens.end(); ++iter2)
+        eraseSorted (mPostings[*iter2], handle);
+
+    tokens.clear();
+    mIds[handle].clear();
+    mFreeHandles.push_back (handle);
+}
+
+std::uint32_t CSMWorld::TextIndex::getToken (const std::string& token)
+{
+    std::unordered_map<std::string, std::uint32_t>::const_iterator iter = mTokenIndex.find (token);
+
+    if (iter!=mTokenIndex.end())
+        return iter->second;
+
+    std::uint32_t index = static_cast<std::uint32_t> (mTokens.size());
+    mTokens.push_back (token);
+    mPostings.push_back (std::vector<Handle>());
+    mTokenIndex.insert (std::make_pair (token, index));
+    return index;
+}
+
+bool CSMWorld::TextIndex::find (const std::string& text, std::vector<std::string>& ids)
+{
+    QString search = QString::fromUtf8 (text.c_str());
+
+    // Case folding of non-ASCII characters does not always map to toLower, so the index could
+    // miss matches
+    for (int i=0; i<search.size(); ++i)
+        if (search[i].unicode()>=0x80)
+            return false;
+
+    std::vector<Word> words;
+    splitWords (search.toLower(), words);
+
+    if (words.empty())
+        return false;
+
+    std::lock_guard<std::mutex> lock (mMutex);
+
+    if (!mBuilt)
+        build();
+
+    if (mIdColumn==-1)
+        return false;
+
+    std::vector<Handle> result;
+
+    for (std::vector<Word>::const_iterator iter (words.begin()); iter!=words.end(); ++iter)
+    {
+        std::vector<Handle> handles;
+
+        if (iter->mAtStart && iter->mAtEnd)
+        {
+            std::unordered_map<std::string, std::uint32_t>::const_iterator token =
+                mTokenIndex.find (iter->mText);
+
+            if (token!=mTokenIndex.end())
+                handles = mPostings[token->second];
+        }
+        else
+        {
+            for (std::size_t i=0; i<mTokens.size(); ++i)
+                if (!mPostings[i].empty() && matches (mTokens[i], *iter))
+                    handles.insert (handles.end(), mPostings[i].begin(), mPostings[i].end());
+
+            std::sort (handles.begin(), handles.end());
+            handles.erase (std::unique (handles.begin(), handles.end()), handles.end());
+        }
+
+        if (iter==words.begin())
+            result.swap (handles);
+        else
+        {
+            std::vector<Handle> intersection;
+            std::set_intersection (result.begin(), result.end(), handles.begin(), handles.end(),
+                std::back_inserter (intersection));
+            result.swap (intersection);
+        }
+
+        if (result.empty())
+            break;
+    }
+
+    for (std::vector<Handle>::const_iterator iter (result.begin()); iter!=result.end(); ++iter)
+        ids.push_back (mIds[*iter]);
+
+    return true;
+}
+
+void CSMWorld::TextIndex::dataChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    // nested columns are not indexed
+    if (topLeft.parent().isValid())
+        return;
+
+    std::lock_guard<std::mutex> lock (mMutex);
+
+    if (!mBuilt || mIdColumn==-1)
+        return;
+
+    for (int i=topLeft.row(); i<=bottomRight.row(); ++i)
+        indexRow (i);
+}
+
+void CSMWorld::TextIndex::rowsInserted (const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid())
+        return;
+
+    std::lock_guard<std::mutex> lock (mMutex);
+
+    if (!mBuilt || mIdColumn==-1)
+        return;
+
+    for (int i=start; i<=end; ++i)
+        indexRow (i);
+}
+
+void CSMWorld::TextIndex::rowsAboutToBeRemoved (const QModelIndex& parent, int start, int end)
+{
+    if (parent.isValid())
+        return;
+
+    std::lock_guard<std::mutex> lock (mMutex);
+
+    if (!mBuilt || mIdColumn==-1)
+        return;
+
+    for (int i=start; i<=end; ++i)
+        removeRow (mModel.data (mModel.index (i, mIdColumn)).toString().toUtf8().constData());
+}
+
+void CSMWorld::TextIndex::invalidate()
+{
+    std::lock_guard<std::mutex> lock (mMutex);
+
+    clear();
+    mBuilt = false;
+}
@@ -0,0 +1,81 @@
+#ifndef CSM_WOLRD_TEXTINDEX_H
+#define CSM_WOLRD_TEXTINDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QObject>
+
+class QModelIndex;
+
+namespace CSMWorld
+{
+    class IdTableBase;
+
+    /// \brief Index of the words in the text, ID and script columns of a table
+    ///
+    /// The index is built on first use and then kept up to date through the signals of the table,
+    /// so a search for a text only has to look at the rows containing the words of the text.
+    ///
+    /// \note find() may be called from other threads than the one the table lives in.
+    class TextIndex : public QObject
+    {
+            Q_OBJECT
+
+            typedef std::uint32_t Handle;
+
+            IdTableBase& mModel;
+            std::mutex mMutex;
+            bool mBuilt;
+            std::vector<int> mColumns;
+            int mIdColumn;
+
+            std::vector<std::string> mTokens;
+            std::unordered_map<std::string, std::uint32_t> mTokenIndex;
+            std::vector<std::vector<Handle> > mPostings; // sorted handles of the rows for each token
+
+            std::unordered_map<std::string, Handle> mHandles;
+            std::vector<std::string> mIds;
+            std::vector<std::vector<std::uint32_t> > mRowTokens; // sorted tokens of the row for each handle
+            std::vector<Handle> mFreeHandles;
+
+            void build();
+
+            void clear();
+
+            void indexRow (int row);
+
+            void removeRow (const std::string& id);
+
+            std::uint32_t getToken (const std::string& token);
+
+            // not implemented
+            TextIndex (const TextIndex&);
+            TextIndex& operator= (const TextIndex&);
+
+        public:
+
+            TextIndex (IdTableBase& model);
+
+            /// Append the IDs of all rows which may contain \a text, ignoring case.
+            ///
+            /// \return Could the rows be narrowed down? If not, nothing is appended and all rows
+            /// need to be searched (e.g. \a text contains no word).
+            bool find (const std::string& text, std::vector<std::string>& ids);
+
+        private slots:
+
+            void dataChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight);
+
+            void rowsInserted (const QModelIndex& parent, int start, int end);
+
+            void rowsAboutToBeRemoved (const QModelIndex& parent, int start, int end);
+
+            void invalidate();
+    };
+}
+
+#endif
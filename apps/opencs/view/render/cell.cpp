@@ -5,10 +5,14 @@
 #include <osg/Geometry>
 #include <osg/Group>
 
+#include <atomic>
+#include <limits>
+
 #include <components/misc/stringops.hpp>
 #include <components/esm/loadcell.hpp>
 #include <components/esm/loadland.hpp>
 #include <components/sceneutil/pathgridutil.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/terrain/terraingrid.hpp>
 
 #include "../../model/world/idtable.hpp"
@@ -52,6 +56,46 @@ namespace CSVRender
                 container->getCell()->updateLand();
             }
     };
+
+    class CellCullCallback : public osg::NodeCallback
+    {
+        public:
+
+            virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+            {
+                CellNodeContainer* container = static_cast<CellNodeContainer*>(node->getUserData());
+                container->getCell()->updateLoadPriority(nv->getEyePoint());
+                traverse(node, nv);
+            }
+    };
+
+    /// Builds the terrain of a cell into the cache of the terrain, so loading the cell later is quick
+    class TerrainLoadItem : public SceneUtil::WorkItem
+    {
+        public:
+
+            TerrainLoadItem(Terrain::World& terrain, int x, int y)
+            : mTerrain(terrain), mView(terrain.createView()), mX(x), mY(y), mAbort(false)
+            {}
+
+            virtual void doWork()
+            {
+                if (!mAbort)
+                    mTerrain.cacheCell(mView.get(), mX, mY);
+            }
+
+            virtual void abort()
+            {
+                mAbort = true;
+            }
+
+        private:
+
+            Terrain::World& mTerrain;
+            osg::ref_ptr<Terrain::View> mView;
+            int mX, mY;
+            std::atomic<bool> mAbort;
+    };
 }
 
 bool CSVRender::Cell::removeObject (const std::string& id)
@@ -105,11 +149,22 @@ bool CSVRender::Cell::addObjects (int start, int end)
 
 void CSVRender::Cell::updateLand()
 {
+    if (mLandLoad)
+    {
+        if (!mLandLoad->isDone())
+            return;
+
+        mLandLoad = nullptr;
+    }
+
     if (!mUpdateLand || mLandDeleted)
         return;
 
     mUpdateLand = false;
 
+    bool cached = mLandCached;
+    mLandCached = false;
+
     // Cell is deleted
     if (mDeleted)
     {
@@ -129,7 +184,9 @@ void CSVRender::Cell::updateLand()
             if (mTerrain)
             {
                 mTerrain->unloadCell(mCoordinates.getX(), mCoordinates.getY());
-                mTerrain->clearAssociatedCaches();
+
+                if (!cached)
+                    mTerrain->clearAssociatedCaches();
             }
             else
             {
@@ -152,6 +209,45 @@ void CSVRender::Cell::updateLand()
     unloadLand();
 }
 
+bool CSVRender::Cell::startLandLoad()
+{
+    SceneUtil::WorkQueue* workQueue = mData.getWorkQueue();
+
+    if (!workQueue || mDeleted)
+        return false;
+
+    const CSMWorld::IdCollection<CSMWorld::Land>& land = mData.getLand();
+    int landIndex = land.searchId(mId);
+    if (landIndex == -1 || land.getRecord(landIndex).isDeleted())
+        return false;
+
+    const ESM::Land& esmLand = land.getRecord(landIndex).get();
+
+    if (!esmLand.getLandData (ESM::Land::DATA_VHGT))
+        return false;
+
+    mTerrain.reset(new Terrain::TerrainGrid(mCellNode, mCellNode,
+        mData.getResourceSystem().get(), mTerrainStorage, Mask_Terrain));
+
+    mLandLoad = new TerrainLoadItem(*mTerrain, esmLand.mX, esmLand.mY);
+    // prioritised by the distance to the camera once the cell is culled
+    mLandLoad->setPriority(std::numeric_limits<float>::max());
+    workQueue->addWorkItem(mLandLoad);
+
+    mLandCached = true;
+    return true;
+}
+
+void CSVRender::Cell::updateLoadPriority (const osg::Vec3f& eyePoint)
+{
+    if (!mLandLoad || mLandLoad->isDone())
+        return;
+
+    const float cellSize = ESM::Land::REAL_SIZE;
+    osg::Vec3f center((mCoordinates.getX() + 0.5f) * cellSize, (mCoordinates.getY() + 0.5f) * cellSize, 0.f);
+    mLandLoad->setPriority((eyePoint - center).length());
+}
+
 void  CSVRender::Cell::unloadLand()
 {
     if (mTerrain)
@@ -164,7 +260,7 @@ void  CSVRender::Cell::unloadLand()
 CSVRender::Cell::Cell (CSMWorld::Data& data, osg::Group* rootNode, const std::string& id,
     bool deleted)
 : mData (data), mId (Misc::StringUtils::lowerCase (id)), mDeleted (deleted), mSubMode (0),
-  mSubModeElementMask (0), mUpdateLand(true), mLandDeleted(false)
+  mSubModeElementMask (0), mUpdateLand(true), mLandDeleted(false), mLandCached(false)
 {
     std::pair<CSMWorld::CellCoordinates, bool> result = CSMWorld::CellCoordinates::fromId (id);
 
@@ -176,6 +272,7 @@ CSVRender::Cell::Cell (CSMWorld::Data& data, osg::Group* rootNode, const std::st
     mCellNode = new osg::Group;
     mCellNode->setUserData(new CellNodeContainer(this));
     mCellNode->setUpdateCallback(new CellNodeCallback);
+    mCellNode->setCullCallback(new CellCullCallback);
     rootNode->addChild(mCellNode);
 
     setCellMarker();
@@ -189,7 +286,8 @@ CSVRender::Cell::Cell (CSMWorld::Data& data, osg::Group* rootNode, const std::st
 
         addObjects (0, rows-1);
 
-        updateLand();
+        if (!startLandLoad())
+            updateLand();
 
         mPathgrid.reset(new Pathgrid(mData, mCellNode, mId, mCoordinates));
         mCellWater.reset(new CellWater(mData, mCellNode, mId, mCoordinates));
@@ -198,6 +296,14 @@ CSVRender::Cell::Cell (CSMWorld::Data& data, osg::Group* rootNode, const std::st
 
 CSVRender::Cell::~Cell()
 {
+    if (mLandLoad)
+    {
+        // the item uses the terrain, which is destroyed with the cell
+        mLandLoad->abort();
+        mLandLoad->setPriority(-std::numeric_limits<float>::max());
+        mLandLoad->waitTillDone();
+    }
+
     for (std::map<std::string, Object *>::iterator iter (mObjects.begin());
         iter!=mObjects.end(); ++iter)
         delete iter->second;
@@ -385,11 +491,13 @@ void CSVRender::Cell::pathgridRemoved()
 void CSVRender::Cell::landDataChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight)
 {
     mUpdateLand = true;
+    mLandCached = false;
 }
 
 void CSVRender::Cell::landAboutToBeRemoved (const QModelIndex& parent, int start, int end)
 {
     mLandDeleted = true;
+    mLandCached = false;
     unloadLand();
 }
 
@@ -397,21 +505,25 @@ void CSVRender::Cell::landAdded (const QModelIndex& parent, int start, int end)
 {
     mUpdateLand = true;
     mLandDeleted = false;
+    mLandCached = false;
 }
 
 void CSVRender::Cell::landTextureChanged (const QModelIndex& topLeft, const QModelIndex& bottomRight)
 {
     mUpdateLand = true;
+    mLandCached = false;
 }
 
 void CSVRender::Cell::landTextureAboutToBeRemoved (const QModelIndex& parent, int start, int end)
 {
     mUpdateLand = true;
+    mLandCached = false;
 }
 
 void CSVRender::Cell::landTextureAdded (const QModelIndex& parent, int start, int end)
 {
     mUpdateLand = true;
+    mLandCached = false;
 }
 
 void CSVRender::Cell::reloadAssets()
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include <osg/ref_ptr>
+#include <osg/Vec3f>
 
 #include "../../model/world/cellcoordinates.hpp"
 #include "terrainstorage.hpp"
@@ -41,6 +42,7 @@ namespace CSVRender
     class CellBorder;
     class CellMarker;
     class CellWater;
+    class TerrainLoadItem;
 
     class Cell
     {
@@ -60,6 +62,8 @@ namespace CSVRender
             unsigned int mSubModeElementMask;
             bool mUpdateLand, mLandDeleted;
             TerrainStorage *mTerrainStorage;
+            osg::ref_ptr<TerrainLoadItem> mLandLoad;
+            bool mLandCached; // terrain of the current land is in the cache of mTerrain
 
             /// Ignored if cell does not have an object with the given ID.
             ///
@@ -78,6 +82,14 @@ namespace CSVRender
             void updateLand();
             void unloadLand();
 
+            /// Build the terrain on the work queue, it's added to the scene by updateLand() once done.
+            ///
+            /// \return Has the terrain been queued?
+            bool startLandLoad();
+
+            /// Let terrain closer to \a eyePoint be loaded first.
+            void updateLoadPriority (const osg::Vec3f& eyePoint);
+
         public:
 
             enum Selection
@@ -173,6 +185,7 @@ namespace CSVRender
             void reset (unsigned int elementMask);
 
             friend class CellNodeCallback;
+            friend class CellCullCallback;
     };
 }
 
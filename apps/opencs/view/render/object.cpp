@@ -3,9 +3,13 @@
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <limits>
 
 #include <osg/Depth>
 #include <osg/Group>
+#include <osg/NodeCallback>
+#include <osg/NodeVisitor>
+#include <osg/observer_ptr>
 #include <osg/PositionAttitudeTransform>
 
 #include <osg/ShapeDrawable>
@@ -29,6 +33,7 @@
 #include <components/resource/scenemanager.hpp>
 #include <components/sceneutil/lightutil.hpp>
 #include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "actor.hpp"
 #include "mask.hpp"
@@ -54,6 +59,117 @@ namespace
         return geode;
     }
 
+    osg::ref_ptr<osg::Geode> createPlaceholder()
+    {
+        osg::ref_ptr<osg::Box> shape(new osg::Box(osg::Vec3f(0,0,0), 20.f));
+        osg::ref_ptr<osg::ShapeDrawable> shapedrawable(new osg::ShapeDrawable);
+        shapedrawable->setShape(shape);
+        shapedrawable->setColor(osg::Vec4f(0.5f, 0.5f, 0.5f, 1.f));
+
+        osg::ref_ptr<osg::Geode> geode (new osg::Geode);
+        geode->addDrawable(shapedrawable);
+        return geode;
+    }
+
+    /// Loads a model into the cache of the scene manager
+    class ModelLoadItem : public SceneUtil::WorkItem
+    {
+        public:
+
+            ModelLoadItem (Resource::SceneManager* sceneManager, const std::string& path)
+            : mSceneManager (sceneManager), mPath (path)
+            {}
+
+            virtual void doWork()
+            {
+                try
+                {
+                    mSceneManager->getTemplate (mPath);
+                }
+                catch (const std::exception&)
+                {
+                    // reported when the instance is created
+                }
+            }
+
+        private:
+
+            Resource::SceneManager* mSceneManager;
+            std::string mPath;
+    };
+
+    /// Replaces the placeholder by the model once it is loaded
+    class ModelLoadCallback : public osg::NodeCallback
+    {
+        public:
+
+            ModelLoadCallback (ModelLoadItem* item, Resource::SceneManager* sceneManager,
+                const std::string& path, osg::Node* placeholder)
+            : mItem (item), mSceneManager (sceneManager), mPath (path), mPlaceholder (placeholder)
+            {}
+
+            virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+            {
+                if (mItem->isDone())
+                {
+                    osg::ref_ptr<ModelLoadCallback> keepAlive (this);
+                    osg::Group* group = node->asGroup();
+
+                    group->removeChild (mPlaceholder);
+
+                    try
+                    {
+                        mSceneManager->getInstance (mPath, group);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        Log(Debug::Error) << e.what();
+                    }
+
+                    node->removeUpdateCallback (this);
+                    if (mPriorityCallback)
+                        node->removeCullCallback (mPriorityCallback);
+
+                    traverse (node, nv);
+                    return;
+                }
+
+                traverse (node, nv);
+            }
+
+            void setPriorityCallback (osg::NodeCallback* callback)
+            {
+                mPriorityCallback = callback;
+            }
+
+        private:
+
+            osg::ref_ptr<ModelLoadItem> mItem;
+            Resource::SceneManager* mSceneManager;
+            std::string mPath;
+            osg::ref_ptr<osg::Node> mPlaceholder;
+            osg::observer_ptr<osg::NodeCallback> mPriorityCallback;
+    };
+
+    /// Loads visible models closer to the camera first
+    class ModelPriorityCallback : public osg::NodeCallback
+    {
+        public:
+
+            ModelPriorityCallback (ModelLoadItem* item) : mItem (item) {}
+
+            virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+            {
+                // the eye point is in the local coordinates of the object
+                mItem->setPriority (nv->getEyePoint().length());
+
+                traverse (node, nv);
+            }
+
+        private:
+
+            osg::ref_ptr<ModelLoadItem> mItem;
+    };
 }
 
 
@@ -76,9 +192,25 @@ void CSVRender::Object::clear()
 {
 }
 
-void CSVRender::Object::update()
+void CSVRender::Object::cancelModelLoad()
+{
+    if (mModelLoadCallback)
+    {
+        mBaseNode->removeUpdateCallback (mModelLoadCallback);
+        mModelLoadCallback = nullptr;
+    }
+
+    if (mModelPriorityCallback)
+    {
+        mBaseNode->removeCullCallback (mModelPriorityCallback);
+        mModelPriorityCallback = nullptr;
+    }
+}
+
+void CSVRender::Object::update (bool async)
 {
     clear();
+    cancelModelLoad();
 
     const CSMWorld::RefIdCollection& referenceables = mData.getReferenceables();
     const int TypeIndex = referenceables.findColumnIndex(CSMWorld::Columns::ColumnId_RecordType);
@@ -124,7 +256,31 @@ void CSVRender::Object::update()
         else if (!model.empty())
         {
             std::string path = "meshes\\" + model;
-            mResourceSystem->getSceneManager()->getInstance(path, mBaseNode);
+            Resource::SceneManager* sceneManager = mResourceSystem->getSceneManager();
+            SceneUtil::WorkQueue* workQueue = mData.getWorkQueue();
+
+            if (async && workQueue)
+            {
+                osg::ref_ptr<ModelLoadItem> item (new ModelLoadItem (sceneManager, path));
+                // prioritised by the distance to the camera once the placeholder is visible
+                item->setPriority (std::numeric_limits<float>::max());
+
+                osg::ref_ptr<osg::Node> placeholder = createPlaceholder();
+                mBaseNode->addChild (placeholder);
+
+                osg::ref_ptr<ModelLoadCallback> loadCallback (
+                    new ModelLoadCallback (item, sceneManager, path, placeholder));
+                mModelPriorityCallback = new ModelPriorityCallback (item);
+                loadCallback->setPriorityCallback (mModelPriorityCallback);
+                mModelLoadCallback = loadCallback;
+
+                mBaseNode->addUpdateCallback (mModelLoadCallback);
+                mBaseNode->addCullCallback (mModelPriorityCallback);
+
+                workQueue->addWorkItem (item);
+            }
+            else
+                sceneManager->getInstance(path, mBaseNode);
         }
         else
         {
@@ -442,7 +598,7 @@ CSVRender::Object::Object (CSMWorld::Data& data, osg::Group* parentNode,
     }
 
     adjustTransform();
-    update();
+    update (true);
     updateMarker();
 }
 
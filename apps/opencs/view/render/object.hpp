@@ -20,6 +20,7 @@ namespace osg
     class PositionAttitudeTransform;
     class Group;
     class Node;
+    class NodeCallback;
     class Geode;
 }
 
@@ -101,6 +102,8 @@ namespace CSVRender
             int mSubMode;
             float mMarkerTransparency;
             std::unique_ptr<Actor> mActor;
+            osg::ref_ptr<osg::NodeCallback> mModelLoadCallback;
+            osg::ref_ptr<osg::NodeCallback> mModelPriorityCallback;
 
             /// Not implemented
             Object (const Object&);
@@ -112,8 +115,12 @@ namespace CSVRender
             void clear();
 
             /// Update model
+            /// @param async Load the model on the work queue and show a placeholder until it is loaded
             /// @note Make sure adjustTransform() was called first so world space particles get positioned correctly
-            void update();
+            void update (bool async = false);
+
+            /// Stop waiting for a model loaded on the work queue
+            void cancelModelLoad();
 
             /// Adjust position, orientation and scale
             void adjustTransform();
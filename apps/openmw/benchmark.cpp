@@ -0,0 +1,163 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <osg/Math>
+#include <osg/Stats>
+
+#include "mwbase/environment.hpp"
+#include "mwbase/world.hpp"
+
+#include "mwworld/ptr.hpp"
+#include "mwworld/refdata.hpp"
+
+namespace
+{
+    double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0;
+        const std::size_t index = static_cast<std::size_t>(std::ceil(percentile / 100 * sorted.size()));
+        return sorted[std::min(std::max<std::size_t>(index, 1), sorted.size()) - 1];
+    }
+}
+
+namespace OMW
+{
+    Benchmark::Benchmark(const boost::filesystem::path& pathFile, double timeStep)
+        : mTimeStep(timeStep)
+        , mTime(0)
+        , mNextPoint(0)
+    {
+        boost::filesystem::ifstream stream(pathFile);
+        if (!stream)
+            throw std::runtime_error("Failed to open benchmark path " + pathFile.string());
+
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream lineStream(line);
+            BenchmarkPathPoint point;
+            lineStream >> point.mTime >> point.mPosition.x() >> point.mPosition.y() >> point.mPosition.z()
+                       >> point.mRotationX >> point.mRotationZ;
+            if (lineStream.fail())
+                throw std::runtime_error("Invalid benchmark path line \"" + line + "\" in " + pathFile.string());
+            if (!mPath.empty() && point.mTime < mPath.back().mTime)
+                throw std::runtime_error("Benchmark path times must not decrease in " + pathFile.string());
+            mPath.push_back(point);
+        }
+
+        if (mPath.empty())
+            throw std::runtime_error("Benchmark path " + pathFile.string() + " is empty");
+    }
+
+    bool Benchmark::update()
+    {
+        if (mTime > mPath.back().mTime)
+            return false;
+
+        while (mNextPoint < mPath.size() && mPath[mNextPoint].mTime <= mTime)
+            ++mNextPoint;
+
+        BenchmarkPathPoint point = mPath.back();
+        if (mNextPoint == 0)
+            point = mPath.front();
+        else if (mNextPoint < mPath.size())
+        {
+            const BenchmarkPathPoint& from = mPath[mNextPoint - 1];
+            const BenchmarkPathPoint& to = mPath[mNextPoint];
+            const float factor = static_cast<float>((mTime - from.mTime) / (to.mTime - from.mTime));
+            point.mPosition = from.mPosition + (to.mPosition - from.mPosition) * factor;
+            point.mRotationX = from.mRotationX + (to.mRotationX - from.mRotationX) * factor;
+            // Turn the short way around
+            float rotationZ = to.mRotationZ - from.mRotationZ;
+            rotationZ -= std::round(rotationZ / (2 * osg::PI)) * 2 * osg::PI;
+            point.mRotationZ = from.mRotationZ + rotationZ * factor;
+        }
+
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        const MWWorld::Ptr player = world->getPlayerPtr();
+        world->moveObject(player, point.mPosition.x(), point.mPosition.y(), point.mPosition.z());
+        world->rotateObject(world->getPlayerPtr(), point.mRotationX, 0, point.mRotationZ);
+
+        mTime += mTimeStep;
+        return true;
+    }
+
+    void Benchmark::frameFinished(double duration, unsigned int frameNumber, const osg::Stats& viewerStats,
+                                  const osg::Stats* cameraStats)
+    {
+        mFrameDurations.push_back(duration);
+
+        addTime(viewerStats, frameNumber, "script_time_taken", "Script");
+        addTime(viewerStats, frameNumber, "mechanics_time_taken", "Mechanics");
+        addTime(viewerStats, frameNumber, "physics_time_taken", "Physics");
+        addTime(viewerStats, frameNumber, "world_time_taken", "World");
+        addTime(viewerStats, frameNumber, "Event traversal time taken", "Event");
+        addTime(viewerStats, frameNumber, "Update traversal time taken", "Update");
+        if (cameraStats)
+        {
+            addTime(*cameraStats, frameNumber, "Cull traversal time taken", "Cull");
+            addTime(*cameraStats, frameNumber, "Draw traversal time taken", "Draw");
+            addTime(*cameraStats, frameNumber, "GPU draw time taken", "GPU");
+        }
+    }
+
+    void Benchmark::addTime(const osg::Stats& stats, unsigned int frameNumber, const std::string& attribute,
+                            const std::string& name)
+    {
+        double value = 0;
+        if (!stats.getAttribute(frameNumber, attribute, value))
+            return;
+        Time& time = mTimes[name];
+        time.mTotal += value;
+        ++time.mCount;
+    }
+
+    void Benchmark::writeReport(std::ostream& stream) const
+    {
+        std::vector<double> sorted = mFrameDurations;
+        std::sort(sorted.begin(), sorted.end());
+
+        double total = 0;
+        for (const double duration : sorted)
+            total += duration;
+
+        stream << std::fixed << std::setprecision(3);
+        stream << "Frames: " << sorted.size() << '\n';
+        stream << "Frame time (ms): mean " << (sorted.empty() ? 0 : total / sorted.size() * 1000)
+               << " p50 " << getPercentile(sorted, 50) * 1000
+               << " p90 " << getPercentile(sorted, 90) * 1000
+               << " p99 " << getPercentile(sorted, 99) * 1000
+               << " max " << (sorted.empty() ? 0 : sorted.back() * 1000) << '\n';
+        stream << "Mean subsystem time (ms):";
+        for (const auto& time : mTimes)
+            stream << ' ' << time.first << ' ' << time.second.mTotal / time.second.mCount * 1000;
+        stream << '\n';
+    }
+
+    BenchmarkRecorder::BenchmarkRecorder(const boost::filesystem::path& pathFile)
+        : mStream(pathFile, std::ios::trunc)
+        , mTime(0)
+    {
+        if (!mStream)
+            throw std::runtime_error("Failed to create benchmark path " + pathFile.string());
+        mStream << "# time x y z rotation-x rotation-z\n" << std::setprecision(9);
+    }
+
+    void BenchmarkRecorder::update(double dt)
+    {
+        const MWWorld::Ptr player = MWBase::Environment::get().getWorld()->getPlayerPtr();
+        const float* position = player.getRefData().getPosition().pos;
+        const float* rotation = player.getRefData().getPosition().rot;
+        mStream << mTime << ' ' << position[0] << ' ' << position[1] << ' ' << position[2]
+                << ' ' << rotation[0] << ' ' << rotation[2] << '\n';
+        mTime += dt;
+    }
+}
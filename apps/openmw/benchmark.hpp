@@ -0,0 +1,85 @@
+#ifndef OPENMW_BENCHMARK_H
+#define OPENMW_BENCHMARK_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <osg/Vec3f>
+
+namespace osg
+{
+    class Stats;
+}
+
+namespace OMW
+{
+    /// @brief Point of a player path, in the format read by Benchmark and written by BenchmarkRecorder
+    /// @par A path file has a line per point with the time in seconds, the position and the rotation around the x
+    /// and z axes in radians, separated by spaces. Lines starting with # are ignored.
+    struct BenchmarkPathPoint
+    {
+        double mTime;
+        osg::Vec3f mPosition;
+        float mRotationX;
+        float mRotationZ;
+    };
+
+    /// @brief Moves the player along a recorded path with a fixed time step and measures the frames
+    class Benchmark
+    {
+    public:
+        /// @throw std::runtime_error if the path can't be read
+        Benchmark(const boost::filesystem::path& pathFile, double timeStep);
+
+        double getTimeStep() const { return mTimeStep; }
+
+        /// Move the player to where the path is at the current time.
+        /// @return False once the end of the path is reached.
+        bool update();
+
+        /// @param duration Time spent on the frame in seconds.
+        /// @param frameNumber Number of a recent frame, whose traversal times are available.
+        void frameFinished(double duration, unsigned int frameNumber, const osg::Stats& viewerStats,
+                           const osg::Stats* cameraStats);
+
+        /// Write frame duration percentiles and the average time of each subsystem.
+        void writeReport(std::ostream& stream) const;
+
+    private:
+        void addTime(const osg::Stats& stats, unsigned int frameNumber, const std::string& attribute,
+                     const std::string& name);
+
+        std::vector<BenchmarkPathPoint> mPath;
+        double mTimeStep;
+        double mTime;
+        std::size_t mNextPoint;
+
+        std::vector<double> mFrameDurations;
+
+        struct Time
+        {
+            double mTotal = 0;
+            unsigned int mCount = 0;
+        };
+        std::map<std::string, Time> mTimes;
+    };
+
+    /// @brief Writes the path of the player for Benchmark
+    class BenchmarkRecorder
+    {
+    public:
+        /// @throw std::runtime_error if the file can't be created
+        BenchmarkRecorder(const boost::filesystem::path& pathFile);
+
+        void update(double dt);
+
+    private:
+        boost::filesystem::ofstream mStream;
+        double mTime;
+    };
+}
+
+#endif
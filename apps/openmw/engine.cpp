@@ -1,6 +1,10 @@
 #include "engine.hpp"
+#include "benchmark.hpp"
+#include "hitchrecorder.hpp"
 
+#include <algorithm>
 #include <iomanip>
+#include <sstream>
 
 #include <boost/filesystem/fstream.hpp>
 
@@ -11,6 +15,7 @@
 #include <SDL.h>
 
 #include <components/debug/debuglog.hpp>
+#include <components/debug/trace.hpp>
 
 #include <components/misc/rng.hpp>
 
@@ -27,6 +32,7 @@
 #include <components/compiler/extensions0.hpp>
 
 #include <components/sceneutil/workqueue.hpp>
+#include <components/nifosg/nifloader.hpp>
 
 #include <components/files/configurationmanager.hpp>
 
@@ -66,6 +72,21 @@ namespace
         if (ret != 0)
             Log(Debug::Error) << "SDL error: " << SDL_GetError();
     }
+
+    osgViewer::ViewerBase::ThreadingModel getThreadingModel(const std::string& name)
+    {
+        if (name == "SingleThreaded")
+            return osgViewer::ViewerBase::SingleThreaded;
+        if (name == "CullDrawThreadPerContext")
+            return osgViewer::ViewerBase::CullDrawThreadPerContext;
+        if (name == "DrawThreadPerContext")
+            return osgViewer::ViewerBase::DrawThreadPerContext;
+        if (name == "CullThreadPerCameraDrawThreadPerContext")
+            return osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext;
+        if (name != "AutomaticSelection")
+            Log(Debug::Warning) << "Warning: unknown viewer threading model '" << name << "', using AutomaticSelection";
+        return osgViewer::ViewerBase::AutomaticSelection;
+    }
 }
 
 void OMW::Engine::executeLocalScripts()
@@ -76,9 +97,14 @@ void OMW::Engine::executeLocalScripts()
     std::pair<std::string, MWWorld::Ptr> script;
     while (localScripts.getNext(script))
     {
-        MWScript::InterpreterContext interpreterContext (
-            &script.second.getRefData().getLocals(), script.second);
-        mEnvironment.getScriptManager()->run (script.first, interpreterContext);
+        MWScript::Locals& locals = script.second.getRefData().getLocals();
+        if (mSkipIdleLocalScripts && locals.isIdle())
+            continue;
+
+        MWScript::InterpreterContext interpreterContext (&locals, script.second);
+        const bool idle = mEnvironment.getScriptManager()->run (script.first, interpreterContext);
+        if (mSkipIdleLocalScripts && idle)
+            locals.setIdle();
     }
 }
 
@@ -101,7 +127,10 @@ bool OMW::Engine::frame(float frametime)
 
         // sound
         if (mUseSound)
+        {
+            const Debug::TraceZone zone("Sound");
             mEnvironment.getSoundManager()->update(frametime);
+        }
 
         // Main menu opened? Then scripts are also paused.
         bool paused = mEnvironment.getWindowManager()->containsMode(MWGui::GM_MainMenu);
@@ -119,6 +148,8 @@ bool OMW::Engine::frame(float frametime)
             {
                 if (mEnvironment.getWorld()->getScriptsEnabled())
                 {
+                    const Debug::TraceZone zone("Scripts");
+
                     // local scripts
                     executeLocalScripts();
 
@@ -143,6 +174,7 @@ bool OMW::Engine::frame(float frametime)
         if (mEnvironment.getStateManager()->getState()!=
             MWBase::StateManager::State_NoGame)
         {
+            const Debug::TraceZone zone("Mechanics");
             mEnvironment.getMechanicsManager()->update(frametime,
                 guiActive);
         }
@@ -161,6 +193,7 @@ bool OMW::Engine::frame(float frametime)
         if (mEnvironment.getStateManager()->getState()!=
             MWBase::StateManager::State_NoGame)
         {
+            const Debug::TraceZone zone("Physics");
             mEnvironment.getWorld()->updatePhysics(frametime, guiActive);
         }
         osg::Timer_t afterPhysicsTick = osg::Timer::instance()->tick();
@@ -170,12 +203,16 @@ bool OMW::Engine::frame(float frametime)
         if (mEnvironment.getStateManager()->getState()!=
             MWBase::StateManager::State_NoGame)
         {
+            const Debug::TraceZone zone("World");
             mEnvironment.getWorld()->update(frametime, guiActive);
         }
         osg::Timer_t afterWorldTick = osg::Timer::instance()->tick();
 
         // update GUI
-        mEnvironment.getWindowManager()->onFrame(frametime);
+        {
+            const Debug::TraceZone zone("Gui");
+            mEnvironment.getWindowManager()->onFrame(frametime);
+        }
 
         unsigned int frameNumber = mViewer->getFrameStamp()->getFrameNumber();
         osg::Stats* stats = mViewer->getViewerStats();
@@ -203,6 +240,8 @@ bool OMW::Engine::frame(float frametime)
             stats->setAttribute(frameNumber, "WorkThread", mWorkQueue->getNumActiveThreads());
 
             mEnvironment.getWorld()->getNavigator()->reportStats(frameNumber, *stats);
+
+            mEnvironment.getWorld()->reportStats(frameNumber, *stats);
         }
 
     }
@@ -228,10 +267,13 @@ OMW::Engine::Engine(Files::ConfigurationManager& configurationManager)
   , mGrab(true)
   , mExportFonts(false)
   , mRandomSeed(0)
+  , mBenchmarkTimeStep(0)
+  , mHiddenWindow(false)
   , mScriptContext (0)
   , mFSStrict (false)
   , mScriptBlacklistUse (true)
   , mNewGame (false)
+  , mSkipIdleLocalScripts (false)
   , mCfgMgr(configurationManager)
 {
     MWClass::registerClasses();
@@ -256,6 +298,8 @@ OMW::Engine::~Engine()
     delete mScriptContext;
     mScriptContext = nullptr;
 
+    mHitchRecorder.reset();
+
     mWorkQueue = nullptr;
 
     mViewer = nullptr;
@@ -357,7 +401,8 @@ void OMW::Engine::createWindow(Settings::Manager& settings)
         pos_y = SDL_WINDOWPOS_UNDEFINED_DISPLAY(screen);
     }
 
-    Uint32 flags = SDL_WINDOW_OPENGL|SDL_WINDOW_SHOWN|SDL_WINDOW_RESIZABLE;
+    Uint32 flags = SDL_WINDOW_OPENGL|SDL_WINDOW_RESIZABLE;
+    flags |= mHiddenWindow ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN;
     if(fullscreen)
         flags |= SDL_WINDOW_FULLSCREEN;
 
@@ -463,6 +508,8 @@ void OMW::Engine::setWindowIcon()
 
 void OMW::Engine::prepareEngine (Settings::Manager & settings)
 {
+    mSkipIdleLocalScripts = Settings::Manager::getBool("skip idle local scripts", "Game");
+
     mEnvironment.setStateManager (
         new MWState::StateManager (mCfgMgr.getUserDataPath() / "saves", mContentFiles.at (0)));
 
@@ -483,6 +530,12 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
         Settings::Manager::getString("texture mipmap", "General"),
         Settings::Manager::getInt("anisotropy", "General")
     );
+    NifOsg::Loader::setCompactVertexColors(Settings::Manager::getBool("compact vertex colors", "General"));
+    if (Settings::Manager::getBool("model disk cache", "Cells"))
+        mResourceSystem->getSceneManager()->setDiskCachePath((mCfgMgr.getUserDataPath() / "modelcache").string());
+    if (Settings::Manager::getBool("program binary cache", "Shaders"))
+        mResourceSystem->getSceneManager()->getShaderManager().setProgramBinaryCachePath((mCfgMgr.getUserDataPath() / "shadercache").string(),
+            static_cast<std::uint64_t>(std::max(0, Settings::Manager::getInt("program binary cache size", "Shaders"))));
 
     int numThreads = Settings::Manager::getInt("preload num threads", "Cells");
     if (numThreads <= 0)
@@ -553,7 +606,7 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     mEnvironment.setWindowManager (window);
 
     // Create sound system
-    mEnvironment.setSoundManager (new MWSound::SoundManager(mVFS.get(), mUseSound));
+    mEnvironment.setSoundManager (new MWSound::SoundManager(mVFS.get(), mWorkQueue.get(), mUseSound));
 
     if (!mSkipMenu)
     {
@@ -565,7 +618,7 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     // Create the world
     mEnvironment.setWorld( new MWWorld::World (mViewer, rootNode, mResourceSystem.get(), mWorkQueue.get(),
         mFileCollections, mContentFiles, mEncoder, mActivationDistanceOverride, mCellName,
-        mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string()));
+        mStartupScript, mResDir.string(), mCfgMgr.getUserDataPath().string(), mCfgMgr.getCachePath().string()));
     mEnvironment.getWorld()->setupPlayer();
     input->setPlayer(&mEnvironment.getWorld()->getPlayer());
 
@@ -615,17 +668,21 @@ void OMW::Engine::prepareEngine (Settings::Manager & settings)
     }
 }
 
-class WriteScreenshotToFileOperation : public osgViewer::ScreenCaptureHandler::CaptureOperation
+class WriteScreenshotToFileWorkItem : public SceneUtil::WorkItem
 {
 public:
-    WriteScreenshotToFileOperation(const std::string& screenshotPath, const std::string& screenshotFormat)
-        : mScreenshotPath(screenshotPath)
+    WriteScreenshotToFileWorkItem(osg::ref_ptr<osg::Image> image, const std::string& screenshotPath,
+            const std::string& screenshotFormat)
+        : mImage(std::move(image))
+        , mScreenshotPath(screenshotPath)
         , mScreenshotFormat(screenshotFormat)
     {
     }
 
-    virtual void operator()(const osg::Image& image, const unsigned int context_id)
+    virtual void doWork()
     {
+        const osg::Image& image = *mImage;
+
         // Count screenshots.
         int shotCount = 0;
 
@@ -658,9 +715,43 @@ public:
         }
     }
 
+private:
+    osg::ref_ptr<osg::Image> mImage;
+    std::string mScreenshotPath;
+    std::string mScreenshotFormat;
+};
+
+class WriteScreenshotToFileOperation : public osgViewer::ScreenCaptureHandler::CaptureOperation
+{
+public:
+    WriteScreenshotToFileOperation(const std::string& screenshotPath, const std::string& screenshotFormat)
+        : mScreenshotPath(screenshotPath)
+        , mScreenshotFormat(screenshotFormat)
+        , mWorkQueue(new SceneUtil::WorkQueue(1))
+    {
+    }
+
+    ~WriteScreenshotToFileOperation()
+    {
+        // The queue handles the items in order, so the last one is done after all the others
+        if (mLastItem)
+            mLastItem->waitTillDone();
+    }
+
+    virtual void operator()(const osg::Image& image, const unsigned int context_id)
+    {
+        // Encoding takes tens of milliseconds, write a copy of the image in the background instead of stalling the frame.
+        // A single thread writes the screenshots one after another, so each of them finds the next unused file name.
+        mLastItem = new WriteScreenshotToFileWorkItem(new osg::Image(image, osg::CopyOp::DEEP_COPY_ALL),
+            mScreenshotPath, mScreenshotFormat);
+        mWorkQueue->addWorkItem(mLastItem);
+    }
+
 private:
     std::string mScreenshotPath;
     std::string mScreenshotFormat;
+    osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+    osg::ref_ptr<SceneUtil::WorkItem> mLastItem;
 };
 
 // Initialise and enter main loop.
@@ -687,6 +778,7 @@ void OMW::Engine::go()
     // Setup viewer
     mViewer = new osgViewer::Viewer;
     mViewer->setReleaseContextAtEndOfFrameHint(false);
+    mViewer->setThreadingModel(getThreadingModel(Settings::Manager::getString("viewer threading model", "General")));
 
 #if OSG_VERSION_GREATER_OR_EQUAL(3,5,5)
     // Do not try to outsmart the OS thread scheduler (see bug #4785).
@@ -745,17 +837,62 @@ void OMW::Engine::go()
         mEnvironment.getWindowManager()->executeInConsole(mStartupScript);
     }
 
+    std::unique_ptr<Benchmark> benchmark;
+    if (!mBenchmarkPath.empty())
+    {
+        if (mEnvironment.getStateManager()->getState() != MWBase::StateManager::State_Running)
+            throw std::runtime_error("The benchmark needs a game to be running, use --load-savegame or --skip-menu");
+
+        benchmark.reset(new Benchmark(mBenchmarkPath, mBenchmarkTimeStep));
+
+        mViewer->getViewerStats()->collectStats("event", true);
+        mViewer->getViewerStats()->collectStats("update", true);
+        if (osg::Stats* cameraStats = mViewer->getCamera()->getStats())
+        {
+            cameraStats->collectStats("rendering", true);
+            cameraStats->collectStats("gpu", true);
+        }
+    }
+
+    std::unique_ptr<BenchmarkRecorder> benchmarkRecorder;
+    if (!mBenchmarkRecordPath.empty())
+        benchmarkRecorder.reset(new BenchmarkRecorder(mBenchmarkRecordPath));
+
+    const float hitchLogThreshold = settings.getFloat("hitch log threshold", "General");
+    if (hitchLogThreshold > 0.f)
+        mHitchRecorder.reset(new HitchRecorder(mCfgMgr.getLogPath() / "openmw-hitches.log", hitchLogThreshold / 1000.0,
+                                               mResourceSystem.get(), mWorkQueue.get()));
+
     // Start the main rendering loop
     osg::Timer frameTimer;
     double simulationTime = 0.0;
+    Debug::Trace::setThreadName("Main");
     while (!mViewer->done() && !mEnvironment.getStateManager()->hasQuitRequest())
     {
         double dt = frameTimer.time_s();
         frameTimer.setStartTick();
         dt = std::min(dt, 0.2);
 
+        if (benchmark)
+        {
+            dt = benchmark->getTimeStep();
+            if (!benchmark->update())
+                break;
+        }
+
+        if (mHitchRecorder)
+            mHitchRecorder->frameStarted();
+
+        const Debug::TraceZone frameZone("Frame");
+
         mViewer->advance(simulationTime);
 
+        // Apply the actor movement that was solved while the previous frame was rendered
+        {
+            const Debug::TraceZone zone("Finish async physics");
+            mEnvironment.getWorld()->finishAsyncPhysics();
+        }
+
         if (!frame(dt))
         {
             OpenThreads::Thread::microSleep(5000);
@@ -763,19 +900,51 @@ void OMW::Engine::go()
         }
         else
         {
-            mViewer->eventTraversal();
-            mViewer->updateTraversal();
+            {
+                const Debug::TraceZone zone("Event and update traversals");
+                mViewer->eventTraversal();
+                mViewer->updateTraversal();
+            }
 
             mEnvironment.getWorld()->updateWindowManager();
 
-            mViewer->renderingTraversals();
+            mEnvironment.getWorld()->startAsyncPhysics();
+
+            {
+                const Debug::TraceZone zone("Rendering traversals");
+                mViewer->renderingTraversals();
+            }
 
             bool guiActive = mEnvironment.getWindowManager()->isGuiMode();
             if (!guiActive)
                 simulationTime += dt;
+
+            const unsigned int frameNumber = mViewer->getFrameStamp()->getFrameNumber();
+
+            if (mHitchRecorder)
+                mHitchRecorder->frameFinished(frameNumber);
+
+            if (benchmarkRecorder)
+                benchmarkRecorder->update(dt);
+
+            // The traversal times of the frame drawn in parallel are only complete a frame later
+            if (benchmark && frameNumber >= 2)
+                benchmark->frameFinished(frameTimer.time_s(), frameNumber - 2, *mViewer->getViewerStats(),
+                                         mViewer->getCamera()->getStats());
         }
 
-        mEnvironment.limitFrameRate(frameTimer.time_s());
+        if (!benchmark)
+            mEnvironment.limitFrameRate(frameTimer.time_s());
+    }
+
+    if (benchmark)
+    {
+        const boost::filesystem::path reportPath = mCfgMgr.getLogPath() / "openmw-benchmark.log";
+        std::ostringstream report;
+        benchmark->writeReport(report);
+        boost::filesystem::ofstream reportFile(reportPath);
+        reportFile << report.str();
+        Log(Debug::Info) << "Benchmark finished, wrote " << reportPath << ":\n" << report.str();
     }
 
     // Save user settings
@@ -848,3 +1017,19 @@ void OMW::Engine::setRandomSeed(unsigned int seed)
 {
     mRandomSeed = seed;
 }
+
+void OMW::Engine::setBenchmark(const std::string& pathFile, double timeStep)
+{
+    mBenchmarkPath = pathFile;
+    mBenchmarkTimeStep = timeStep;
+}
+
+void OMW::Engine::setBenchmarkRecording(const std::string& pathFile)
+{
+    mBenchmarkRecordPath = pathFile;
+}
+
+void OMW::Engine::setHiddenWindow(bool hidden)
+{
+    mHiddenWindow = hidden;
+}
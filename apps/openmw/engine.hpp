@@ -67,6 +67,8 @@ struct SDL_Window;
 
 namespace OMW
 {
+    class HitchRecorder;
+
     /// \brief Main engine class, that brings together all the components of OpenMW
     class Engine
     {
@@ -74,6 +76,7 @@ namespace OMW
             std::unique_ptr<VFS::Manager> mVFS;
             std::unique_ptr<Resource::ResourceSystem> mResourceSystem;
             osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+            std::unique_ptr<HitchRecorder> mHitchRecorder;
             MWBase::Environment mEnvironment;
             ToUTF8::FromType mEncoding;
             ToUTF8::Utf8Encoder* mEncoder;
@@ -101,6 +104,11 @@ namespace OMW
             bool mExportFonts;
             unsigned int mRandomSeed;
 
+            std::string mBenchmarkPath;
+            double mBenchmarkTimeStep;
+            std::string mBenchmarkRecordPath;
+            bool mHiddenWindow;
+
             Compiler::Extensions mExtensions;
             Compiler::Context *mScriptContext;
 
@@ -110,6 +118,7 @@ namespace OMW
             std::vector<std::string> mScriptBlacklist;
             bool mScriptBlacklistUse;
             bool mNewGame;
+            bool mSkipIdleLocalScripts;
 
             osg::Timer_t mStartTick;
 
@@ -203,6 +212,17 @@ namespace OMW
 
             void setRandomSeed(unsigned int seed);
 
+            /// Move the player along the path in \a pathFile with a fixed time step, then write a report of the frame
+            /// durations to openmw-benchmark.log and quit. Requires a game to be loaded or started on launch.
+            /// @note See OMW::BenchmarkPathPoint for the path format.
+            void setBenchmark(const std::string& pathFile, double timeStep);
+
+            /// Write the path of the player to \a pathFile, for setBenchmark.
+            void setBenchmarkRecording(const std::string& pathFile);
+
+            /// Create the window without showing it.
+            void setHiddenWindow(bool hidden);
+
         private:
             Files::ConfigurationManager& mCfgMgr;
     };
@@ -0,0 +1,139 @@
+#include "hitchrecorder.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+#include <components/debug/debuglog.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/shader/shadermanager.hpp>
+
+namespace
+{
+    // Frames listed before the slow one
+    constexpr std::size_t sHistorySize = 60;
+
+    double toMilliseconds(Debug::Trace::Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+namespace OMW
+{
+    HitchRecorder::HitchRecorder(const boost::filesystem::path& logPath, double threshold,
+                                 Resource::ResourceSystem* resourceSystem, const SceneUtil::WorkQueue* workQueue)
+        : mLogPath(logPath)
+        , mThreshold(threshold)
+        , mResourceSystem(resourceSystem)
+        , mWorkQueue(workQueue)
+    {
+        Debug::Trace::setEnabled(true);
+        getCounters(mFrameEndCounters);
+    }
+
+    void HitchRecorder::frameStarted()
+    {
+        mFrameStart = Debug::Trace::Clock::now();
+        // The counters from the end of the last finished frame, so skipped frames count towards the next one
+        mFrameStartCounters = mFrameEndCounters;
+    }
+
+    void HitchRecorder::frameFinished(unsigned int frameNumber)
+    {
+        const Debug::Trace::Clock::time_point frameEnd = Debug::Trace::Clock::now();
+        const double duration = std::chrono::duration<double>(frameEnd - mFrameStart).count();
+
+        getCounters(mFrameEndCounters);
+
+        if (duration > mThreshold)
+            writeReport(frameNumber, duration, frameEnd);
+
+        mFrameDurations.push_back(duration);
+        if (mFrameDurations.size() > sHistorySize)
+            mFrameDurations.pop_front();
+    }
+
+    void HitchRecorder::getCounters(Counters& counters)
+    {
+        counters.mCacheMisses.clear();
+        mResourceSystem->getCacheMisses(counters.mCacheMisses);
+        counters.mNumPrograms = mResourceSystem->getSceneManager()->getShaderManager().getNumPrograms();
+    }
+
+    void HitchRecorder::writeReport(unsigned int frameNumber, double duration, Debug::Trace::Clock::time_point frameEnd)
+    {
+        if (!mStream.is_open())
+        {
+            mStream.open(mLogPath, std::ios::trunc);
+            if (!mStream)
+            {
+                Log(Debug::Warning) << "Failed to open hitch log " << mLogPath;
+                return;
+            }
+            Log(Debug::Info) << "Writing frames longer than " << mThreshold * 1000 << " ms to " << mLogPath;
+        }
+
+        mStream << std::fixed << std::setprecision(2);
+        mStream << "Frame " << frameNumber << " took " << duration * 1000 << " ms\n";
+
+        mStream << "  Previous frames (ms):";
+        for (const double previous : mFrameDurations)
+            mStream << ' ' << previous * 1000;
+        mStream << '\n';
+
+        mStream << "  Work queue items: " << mWorkQueue->getNumItems()
+                << ", active threads: " << mWorkQueue->getNumActiveThreads() << '\n';
+
+        mStream << "  Cache misses:";
+        bool anyMisses = false;
+        for (std::size_t i = 0; i < mFrameEndCounters.mCacheMisses.size(); ++i)
+        {
+            const auto& misses = mFrameEndCounters.mCacheMisses[i];
+            // Resource managers may be added during the frame
+            unsigned int before = 0;
+            for (const auto& startMisses : mFrameStartCounters.mCacheMisses)
+            {
+                if (startMisses.first == misses.first)
+                    before = startMisses.second;
+            }
+            if (misses.second > before)
+            {
+                mStream << ' ' << misses.first << ' ' << misses.second - before;
+                anyMisses = true;
+            }
+        }
+        if (!anyMisses)
+            mStream << " none";
+        mStream << '\n';
+
+        mStream << "  Shader programs created: " << mFrameEndCounters.mNumPrograms - mFrameStartCounters.mNumPrograms << '\n';
+
+        std::vector<Debug::Trace::RecordedZone> zones;
+        Debug::Trace::getZones(mFrameStart, zones);
+        std::sort(zones.begin(), zones.end(), [] (const Debug::Trace::RecordedZone& lhs, const Debug::Trace::RecordedZone& rhs)
+        {
+            return lhs.mStart < rhs.mStart;
+        });
+
+        std::map<std::string, std::size_t> zoneCounts;
+        for (const Debug::Trace::RecordedZone& zone : zones)
+            ++zoneCounts[zone.mName];
+        const auto loadedCells = zoneCounts.find("Load cell");
+        mStream << "  Cells loaded: " << (loadedCells == zoneCounts.end() ? 0 : loadedCells->second) << '\n';
+
+        // Zones started before the frame are shown with a negative start
+        mStream << "  Zones (start ms, duration ms, thread, name):\n";
+        for (const Debug::Trace::RecordedZone& zone : zones)
+        {
+            if (zone.mStart > frameEnd)
+                continue;
+            mStream << "    " << std::setw(8) << toMilliseconds(zone.mStart - mFrameStart)
+                    << ' ' << std::setw(8) << toMilliseconds(zone.mEnd - zone.mStart)
+                    << ' ' << zone.mThread << ": " << zone.mName << '\n';
+        }
+        mStream << std::endl;
+    }
+}
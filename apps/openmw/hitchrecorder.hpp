@@ -0,0 +1,63 @@
+#ifndef OPENMW_HITCHRECORDER_H
+#define OPENMW_HITCHRECORDER_H
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <components/debug/trace.hpp>
+
+namespace Resource
+{
+    class ResourceSystem;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace OMW
+{
+    /// @brief Writes a report of each frame that takes longer than a threshold
+    /// @par The report lists the zones recorded by Debug::Trace during the frame, the recent frame durations and the
+    /// resources loaded during the frame. Tracing is enabled for as long as the recorder exists.
+    class HitchRecorder
+    {
+    public:
+        /// @param threshold Frame duration in seconds.
+        HitchRecorder(const boost::filesystem::path& logPath, double threshold,
+                      Resource::ResourceSystem* resourceSystem, const SceneUtil::WorkQueue* workQueue);
+
+        void frameStarted();
+
+        void frameFinished(unsigned int frameNumber);
+
+    private:
+        struct Counters
+        {
+            std::vector<std::pair<const char*, unsigned int> > mCacheMisses;
+            std::size_t mNumPrograms;
+        };
+
+        void getCounters(Counters& counters);
+
+        void writeReport(unsigned int frameNumber, double duration, Debug::Trace::Clock::time_point frameEnd);
+
+        boost::filesystem::path mLogPath;
+        double mThreshold;
+        Resource::ResourceSystem* mResourceSystem;
+        const SceneUtil::WorkQueue* mWorkQueue;
+
+        std::deque<double> mFrameDurations;
+        Debug::Trace::Clock::time_point mFrameStart;
+        Counters mFrameStartCounters;
+        Counters mFrameEndCounters;
+
+        boost::filesystem::ofstream mStream;
+    };
+}
+
+#endif
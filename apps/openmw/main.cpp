@@ -138,6 +138,18 @@ bool parseOptions (int argc, char** argv, OMW::Engine& engine, Files::Configurat
         ("random-seed", bpo::value <unsigned int> ()
             ->default_value(Misc::Rng::generateDefaultSeed()),
             "seed value for random number generator")
+
+        ("benchmark", bpo::value<Files::EscapeHashString>()->default_value(""),
+            "move the player along the path in the file with a fixed time step, write the frame times to openmw-benchmark.log "
+            "and quit. Uses random seed 0 unless given")
+
+        ("benchmark-timestep", bpo::value<double>()->default_value(1.0 / 60.0), "time step of --benchmark in seconds")
+
+        ("benchmark-record", bpo::value<Files::EscapeHashString>()->default_value(""),
+            "write the path of the player to the file, for --benchmark")
+
+        ("hidden-window", bpo::value<bool>()->implicit_value(true)
+            ->default_value(false), "create the window without showing it")
     ;
 
     bpo::parsed_options valid_opts = bpo::command_line_parser(argc, argv)
@@ -237,7 +249,16 @@ bool parseOptions (int argc, char** argv, OMW::Engine& engine, Files::Configurat
     engine.setSoundUsage(!variables["no-sound"].as<bool>());
     engine.setActivationDistanceOverride (variables["activate-dist"].as<int>());
     engine.enableFontExport(variables["export-fonts"].as<bool>());
-    engine.setRandomSeed(variables["random-seed"].as<unsigned int>());
+    const std::string benchmark = variables["benchmark"].as<Files::EscapeHashString>().toStdString();
+    engine.setBenchmark(benchmark, variables["benchmark-timestep"].as<double>());
+    engine.setBenchmarkRecording(variables["benchmark-record"].as<Files::EscapeHashString>().toStdString());
+    engine.setHiddenWindow(variables["hidden-window"].as<bool>());
+
+    // Benchmark runs should be comparable
+    if (!benchmark.empty() && variables["random-seed"].defaulted())
+        engine.setRandomSeed(0);
+    else
+        engine.setRandomSeed(variables["random-seed"].as<unsigned int>());
 
     return true;
 }
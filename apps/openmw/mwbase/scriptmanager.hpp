@@ -1,6 +1,7 @@
 #ifndef GAME_MWBASE_SCRIPTMANAGER_H
 #define GAME_MWBASE_SCRIPTMANAGER_H
 
+#include <iosfwd>
 #include <string>
 
 namespace Interpreter
@@ -35,13 +36,18 @@ namespace MWBase
 
             virtual ~ScriptManager() {}
 
-            virtual void run (const std::string& name, Interpreter::Context& interpreterContext) = 0;
+            virtual bool run (const std::string& name, Interpreter::Context& interpreterContext) = 0;
             ///< Run the script with the given name (compile first, if not compiled yet)
+            /// \return Did the script only read its own locals, so running it again does the same while they don't
+            /// change?
 
             virtual bool compile (const std::string& name) = 0;
             ///< Compile script with the given namen
             /// \return Success?
 
+            virtual void precompile (const std::string& name) = 0;
+            ///< Compile script with the given name, if not compiled yet, so running it later doesn't stall.
+
             virtual std::pair<int, int> compileAll() = 0;
             ///< Compile all scripts
             /// \return count, success
@@ -50,6 +56,12 @@ namespace MWBase
             ///< Return locals for script \a name.
 
             virtual MWScript::GlobalScripts& getGlobalScripts() = 0;
+
+            virtual void setProfiling (bool enabled) = 0;
+            ///< Record the time taken by each script while enabled. Enabling discards earlier records.
+
+            virtual void writeProfile (std::ostream& stream) const = 0;
+            ///< Write the recorded runs and time of each script as CSV, slowest first.
    };
 }
 
@@ -143,6 +143,9 @@ namespace MWBase
                                        PlayMode mode=PlayMode::Normal, float offset=0) = 0;
             ///< Play a 3D sound at \a initialPos. If the sound should be moving, it must be updated using Sound::setPosition.
 
+            virtual void preloadSound(const std::string& soundId) = 0;
+            ///< Decode the given sound in the background, so it does not need to be loaded when it is played.
+
             virtual void stopSound(Sound *sound) = 0;
             ///< Stop the given sound from playing
 
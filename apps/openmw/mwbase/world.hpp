@@ -21,6 +21,7 @@ namespace osg
     class Matrixf;
     class Quat;
     class Image;
+    class Stats;
 }
 
 namespace Loading
@@ -373,6 +374,15 @@ namespace MWBase
             virtual void update (float duration, bool paused) = 0;
             virtual void updatePhysics (float duration, bool paused) = 0;
 
+            virtual void startAsyncPhysics () = 0;
+            ///< If the "async physics" setting is enabled, solve the actor movement queued during the last
+            /// updatePhysics call on the physics thread. The physics system must not be used until
+            /// finishAsyncPhysics is called, so this is meant to be called right before rendering the frame.
+
+            virtual void finishAsyncPhysics () = 0;
+            ///< Move the actors according to the movement solved since startAsyncPhysics. Does nothing if
+            /// no movement was started.
+
             virtual void updateWindowManager () = 0;
 
             virtual MWWorld::Ptr placeObject (const MWWorld::ConstPtr& object, float cursorX, float cursorY, int amount) = 0;
@@ -447,6 +457,9 @@ namespace MWBase
             virtual bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) = 0;
             ///< get Line of Sight (morrowind stupid implementation)
 
+            virtual void getLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& actors, std::vector<bool>& out) = 0;
+            ///< get Line of Sight for several pairs of actors at once, the physics system may check them in parallel
+
             virtual float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false) = 0;
 
             virtual void enableActorCollision(const MWWorld::Ptr& actor, bool enable) = 0;
@@ -604,11 +617,21 @@ namespace MWBase
             /// \param ptr object to export scene graph for (if empty, export entire scene graph)
             virtual std::string exportSceneGraph(const MWWorld::Ptr& ptr) = 0;
 
+            /// Write the zones recorded by Debug::Trace to a file and return the filename.
+            virtual std::string exportTrace() = 0;
+
+            /// Return a report of the estimated memory used by resource caches, textures, navigation meshes and
+            /// loaded cells, one line per subsystem.
+            virtual std::string getMemoryStats() = 0;
+
             /// Preload VFX associated with this effect list
             virtual void preloadEffects(const ESM::EffectList* effectList) = 0;
 
             virtual DetourNavigator::Navigator* getNavigator() const = 0;
 
+            /// Report the physics system statistics to the stats overlay.
+            virtual void reportStats(unsigned int frameNumber, osg::Stats& stats) const = 0;
+
             virtual void updateActorPath(const MWWorld::ConstPtr& actor, const std::deque<osg::Vec3f>& path,
                     const osg::Vec3f& halfExtents, const osg::Vec3f& start, const osg::Vec3f& end) const = 0;
 
@@ -6,6 +6,7 @@
 #include "../mwmechanics/levelledlist.hpp"
 
 #include "../mwworld/customdata.hpp"
+#include "../mwworld/manualref.hpp"
 #include "../mwmechanics/creaturestats.hpp"
 
 namespace MWClass
@@ -1,5 +1,9 @@
 #include "filter.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <map>
+
 #include <components/compiler/locals.hpp>
 
 #include "../mwbase/environment.hpp"
@@ -21,6 +25,87 @@
 
 #include "selectwrapper.hpp"
 
+namespace
+{
+    typedef std::vector<std::pair<std::size_t, const ESM::DialInfo*> > IndexedInfos;
+
+    /// Infos of a topic partitioned by their conditions on the speaker's ID and faction, which rule out most infos
+    /// of big topics before the other conditions are tested. Infos are listed with their position in the topic,
+    /// so merged partitions keep the order of the topic.
+    struct InfoIndex
+    {
+        std::map<std::string, IndexedInfos> mByActor;
+        // Infos without actor
+        std::map<std::string, IndexedInfos> mByFaction;
+        // Infos without actor and faction
+        IndexedInfos mOthers;
+    };
+
+    const InfoIndex& getInfoIndex (const ESM::Dialogue& dialogue)
+    {
+        // Dialogues are not changed after the content files are loaded
+        static std::map<const ESM::Dialogue*, InfoIndex> indices;
+
+        std::map<const ESM::Dialogue*, InfoIndex>::const_iterator found = indices.find(&dialogue);
+        if (found != indices.end())
+            return found->second;
+
+        InfoIndex& index = indices[&dialogue];
+        std::size_t position = 0;
+        for (const ESM::DialInfo& info : dialogue.mInfo)
+        {
+            const auto entry = std::make_pair(position++, &info);
+            if (!info.mActor.empty())
+                index.mByActor[Misc::StringUtils::lowerCase(info.mActor)].push_back(entry);
+            else if (!info.mFactionLess && !info.mFaction.empty())
+                index.mByFaction[Misc::StringUtils::lowerCase(info.mFaction)].push_back(entry);
+            else
+                index.mOthers.push_back(entry);
+        }
+        return index;
+    }
+
+    const IndexedInfos& findInfos (const std::map<std::string, IndexedInfos>& infos, const std::string& id)
+    {
+        static const IndexedInfos empty;
+        if (id.empty())
+            return empty;
+        std::map<std::string, IndexedInfos>::const_iterator found = infos.find(Misc::StringUtils::lowerCase(id));
+        return found != infos.end() ? found->second : empty;
+    }
+
+    IndexedInfos mergeInfos (const IndexedInfos& left, const IndexedInfos& right)
+    {
+        IndexedInfos result;
+        result.reserve(left.size() + right.size());
+        std::merge(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(result),
+            [] (const IndexedInfos::value_type& a, const IndexedInfos::value_type& b) { return a.first < b.first; });
+        return result;
+    }
+}
+
+std::vector<const ESM::DialInfo *> MWDialogue::Filter::getCandidates (const ESM::Dialogue& dialogue) const
+{
+    const InfoIndex& index = getInfoIndex(dialogue);
+    const IndexedInfos& byActor = findInfos(index.mByActor, mActor.getCellRef().getRefId());
+
+    IndexedInfos candidates;
+    // Creatures must not have topics aside of those specific to their id
+    if (mActor.getTypeName() != typeid (ESM::NPC).name())
+        candidates = byActor;
+    else
+    {
+        const IndexedInfos& byFaction = findInfos(index.mByFaction, mActor.getClass().getPrimaryFaction(mActor));
+        candidates = mergeInfos(mergeInfos(byActor, byFaction), index.mOthers);
+    }
+
+    std::vector<const ESM::DialInfo *> infos;
+    infos.reserve(candidates.size());
+    for (const auto& candidate : candidates)
+        infos.push_back(candidate.second);
+    return infos;
+}
+
 bool MWDialogue::Filter::testActor (const ESM::DialInfo& info) const
 {
     bool isCreature = (mActor.getTypeName() != typeid (ESM::NPC).name());
@@ -629,10 +714,10 @@ const ESM::DialInfo* MWDialogue::Filter::search (const ESM::Dialogue& dialogue,
 std::vector<const ESM::DialInfo *> MWDialogue::Filter::listAll (const ESM::Dialogue& dialogue) const
 {
     std::vector<const ESM::DialInfo *> infos;
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin(); iter!=dialogue.mInfo.end(); ++iter)
+    for (const ESM::DialInfo* info : getCandidates (dialogue))
     {
-        if (testActor (*iter))
-            infos.push_back(&*iter);
+        if (testActor (*info))
+            infos.push_back(info);
     }
     return infos;
 }
@@ -645,13 +730,12 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
     bool infoRefusal = false;
 
     // Iterate over topic responses to find a matching one
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    for (const ESM::DialInfo* info : getCandidates (dialogue))
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (*info) && testPlayer (*info) && testSelectStructs (*info))
         {
-            if (testDisposition (*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+            if (testDisposition (*info, invertDisposition)) {
+                infos.push_back(info);
                 if (!searchAll)
                     break;
             }
@@ -670,10 +754,9 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
         const ESM::Dialogue& infoRefusalDialogue = *dialogues.find ("Info Refusal");
 
-        for (ESM::Dialogue::InfoContainer::const_iterator iter = infoRefusalDialogue.mInfo.begin();
-            iter!=infoRefusalDialogue.mInfo.end(); ++iter)
-            if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter) && testDisposition(*iter, invertDisposition)) {
-                infos.push_back(&*iter);
+        for (const ESM::DialInfo* info : getCandidates (infoRefusalDialogue))
+            if (testActor (*info) && testPlayer (*info) && testSelectStructs (*info) && testDisposition(*info, invertDisposition)) {
+                infos.push_back(info);
                 if (!searchAll)
                     break;
             }
@@ -684,10 +767,9 @@ std::vector<const ESM::DialInfo *> MWDialogue::Filter::list (const ESM::Dialogue
 
 bool MWDialogue::Filter::responseAvailable (const ESM::Dialogue& dialogue) const
 {
-    for (ESM::Dialogue::InfoContainer::const_iterator iter = dialogue.mInfo.begin();
-        iter!=dialogue.mInfo.end(); ++iter)
+    for (const ESM::DialInfo* info : getCandidates (dialogue))
     {
-        if (testActor (*iter) && testPlayer (*iter) && testSelectStructs (*iter))
+        if (testActor (*info) && testPlayer (*info) && testSelectStructs (*info))
             return true;
     }
 
@@ -21,6 +21,10 @@ namespace MWDialogue
             int mChoice;
             bool mTalkedToPlayer;
 
+            std::vector<const ESM::DialInfo *> getCandidates (const ESM::Dialogue& dialogue) const;
+            ///< Infos of \a dialogue whose actor and faction conditions don't rule out the actor, in the order of
+            /// the dialogue. These conditions still need to be tested with testActor.
+
             bool testActor (const ESM::DialInfo& info) const;
             ///< Is this the right actor for this \a info?
 
@@ -30,13 +30,17 @@ public:
     {
         if (keyword.empty())
             return;
-        seed_impl  (/*std::move*/ (keyword), /*std::move*/ (value), 0, mRoot);
+        seed_impl  (keyword, value, 0, mRoot);
+        mKeywords.push_back (std::make_pair (/*std::move*/ (keyword), /*std::move*/ (value)));
+        mNodes.clear ();
     }
 
     void clear ()
     {
         mRoot.mChildren.clear ();
         mRoot.mKeyword.clear ();
+        mKeywords.clear ();
+        mNodes.clear ();
     }
 
     bool containsKeyword (string_t keyword, value_t& value)
@@ -75,86 +79,50 @@ public:
 
     void highlightKeywords (Point beg, Point end, std::vector<Match>& out)
     {
-        std::vector<Match> matches;
+        if (mNodes.empty ())
+            buildAutomaton ();
+
+        // A single pass over the text finds all keywords, keep the longest one starting at each word start
+        std::vector<int> longest (end - beg, -1);
+        std::size_t state = 0;
         for (Point i = beg; i != end; ++i)
         {
-            // check if previous character marked start of new word
-            if (i != beg)
-            {
-                Point prev = i;
-                --prev;
-                if(isalpha(*prev))
-                    continue;
-            }
-
-
-            // check first character
-            typename Entry::childen_t::iterator candidate = mRoot.mChildren.find (Misc::StringUtils::toLower (*i));
-
-            // no match, on to next character
-            if (candidate == mRoot.mChildren.end ())
-                continue;
-
-            // see how far the match goes
-            Point j = i;
-
-            // some keywords might be longer variations of other keywords, so we definitely need a list of candidates
-            // the first element in the pair is length of the match, i.e. depth from the first character on
-            std::vector< typename std::pair<int, typename Entry::childen_t::iterator> > candidates;
-
-            while ((j + 1) != end)
+            const char_t ch = Misc::StringUtils::toLower (*i);
+            while (state != 0 && mNodes[state].mNext.find (ch) == mNodes[state].mNext.end ())
+                state = mNodes[state].mFail;
+            typename Node::next_t::const_iterator next = mNodes[state].mNext.find (ch);
+            if (next != mNodes[state].mNext.end ())
+                state = next->second;
+
+            for (std::size_t node = mNodes[state].mKeyword != -1 ? state : mNodes[state].mOutput; node != 0;
+                 node = mNodes[node].mOutput)
             {
-                typename Entry::childen_t::iterator next = candidate->second.mChildren.find (Misc::StringUtils::toLower (*++j));
-
-                if (next == candidate->second.mChildren.end ())
-                {
-                    if (candidate->second.mKeyword.size() > 0)
-                        candidates.push_back(std::make_pair((j-i), candidate));
-                    break;
-                }
+                const std::size_t length = mNodes[node].mDepth;
+                const std::size_t start = (i - beg) + 1 - length;
 
-                candidate = next;
+                // check if previous character marked start of new word
+                if (start != 0 && isalpha (*(beg + start - 1)))
+                    continue;
 
-                if (candidate->second.mKeyword.size() > 0)
-                    candidates.push_back(std::make_pair((j-i), candidate));
+                if (longest[start] == -1 || mNodes[longest[start]].mDepth < length)
+                    longest[start] = static_cast<int> (node);
             }
+        }
 
-            if (candidates.empty())
-                continue; // didn't match enough to disambiguate, on to next character
-
-            // shorter candidates will be added to the vector first. however, we want to check against longer candidates first
-            std::reverse(candidates.begin(), candidates.end());
-
-            for (typename std::vector< std::pair<int, typename Entry::childen_t::iterator> >::iterator it = candidates.begin();
-                 it != candidates.end(); ++it)
-            {
-                candidate = it->second;
-                // try to match the rest of the keyword
-                Point k = i + it->first;
-                typename string_t::const_iterator t = candidate->second.mKeyword.begin () + (k - i);
-
-
-                while (k != end && t != candidate->second.mKeyword.end ())
-                {
-                    if (Misc::StringUtils::toLower (*k) != Misc::StringUtils::toLower (*t))
-                        break;
-
-                    ++k, ++t;
-                }
-
-                // didn't match full keyword, try the next candidate
-                if (t != candidate->second.mKeyword.end ())
-                    continue;
+        // found keywords might still overlap with longer keywords that start somewhere _within_ them
+        // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
+        std::vector<Match> matches;
+        for (std::size_t start = 0; start < longest.size (); ++start)
+        {
+            if (longest[start] == -1)
+                continue;
 
-                // found a keyword, but there might still be longer keywords that start somewhere _within_ this keyword
-                // we will resolve these overlapping keywords later, choosing the longest one in case of conflict
-                Match match;
-                match.mValue = candidate->second.mValue;
-                match.mBeg = i;
-                match.mEnd = k;
-                matches.push_back(match);
-                break;
-            }
+            const Node& node = mNodes[longest[start]];
+            Match match;
+            match.mValue = mKeywords[node.mKeyword].second;
+            match.mBeg = beg + start;
+            match.mEnd = match.mBeg + node.mDepth;
+            matches.push_back (match);
         }
 
         // resolve overlapping keywords
@@ -201,6 +169,74 @@ public:
 
 private:
 
+    typedef typename string_t::value_type char_t;
+
+    /// Node of the Aho-Corasick automaton for highlightKeywords, working on lower case characters
+    struct Node
+    {
+        typedef std::map <char_t, std::size_t> next_t;
+
+        next_t mNext;
+        // Node of the longest proper suffix of this node's string that is also in the automaton
+        std::size_t mFail = 0;
+        // Next node on the chain of fail links that ends a keyword, 0 if none
+        std::size_t mOutput = 0;
+        // Index of the keyword ending at this node, -1 if none
+        int mKeyword = -1;
+        std::size_t mDepth = 0;
+    };
+
+    void buildAutomaton ()
+    {
+        mNodes.assign (1, Node ());
+
+        for (std::size_t keyword = 0; keyword < mKeywords.size (); ++keyword)
+        {
+            std::size_t node = 0;
+            for (char_t ch : mKeywords[keyword].first)
+            {
+                ch = Misc::StringUtils::toLower (ch);
+                typename Node::next_t::const_iterator next = mNodes[node].mNext.find (ch);
+                if (next != mNodes[node].mNext.end ())
+                {
+                    node = next->second;
+                    continue;
+                }
+
+                const std::size_t child = mNodes.size ();
+                mNodes[node].mNext[ch] = child;
+                Node added;
+                added.mDepth = mNodes[node].mDepth + 1;
+                mNodes.push_back (added);
+                node = child;
+            }
+            mNodes[node].mKeyword = static_cast<int> (keyword);
+        }
+
+        // Fail links in breadth first order, so the links of shorter strings are known
+        std::vector<std::size_t> queue (1, 0);
+        for (std::size_t i = 0; i < queue.size (); ++i)
+        {
+            const Node& parent = mNodes[queue[i]];
+            for (typename Node::next_t::const_iterator it = parent.mNext.begin (); it != parent.mNext.end (); ++it)
+            {
+                std::size_t fail = parent.mFail;
+                while (fail != 0 && mNodes[fail].mNext.find (it->first) == mNodes[fail].mNext.end ())
+                    fail = mNodes[fail].mFail;
+                typename Node::next_t::const_iterator next = mNodes[fail].mNext.find (it->first);
+                if (next != mNodes[fail].mNext.end () && next->second != it->second)
+                    fail = next->second;
+                else
+                    fail = 0;
+
+                Node& child = mNodes[it->second];
+                child.mFail = fail;
+                child.mOutput = mNodes[fail].mKeyword != -1 ? fail : mNodes[fail].mOutput;
+                queue.push_back (it->second);
+            }
+        }
+    }
+
     struct Entry
     {
         typedef std::map <wchar_t, Entry> childen_t;
@@ -249,6 +285,10 @@ private:
     }
 
     Entry mRoot;
+
+    std::vector<std::pair<string_t, value_t> > mKeywords;
+    // Built on demand from mKeywords, empty if outdated
+    std::vector<Node> mNodes;
 };
 
 }
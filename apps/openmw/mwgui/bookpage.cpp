@@ -248,6 +248,18 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
     Book::Content const * mCurrentContent;
     Alignment mCurrentAlignment;
 
+    struct Checkpoint
+    {
+        size_t mSections;
+        size_t mContents;
+        size_t mStyles;
+        MyGUI::IntRect mRect;
+        Book::Content const * mCurrentContent;
+        Alignment mCurrentAlignment;
+    };
+
+    Checkpoint mCheckpoint;
+
     Typesetter (size_t width, size_t height) :
         mPageWidth (width), mPageHeight(height),
         mSection (nullptr), mLine (nullptr), mRun (nullptr),
@@ -255,6 +267,7 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
         mCurrentAlignment (AlignLeft)
     {
         mBook = std::make_shared <Book> ();
+        setCheckpoint ();
     }
 
     virtual ~Typesetter ()
@@ -390,6 +403,8 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
 
         add_partial_text();
 
+        mBook->mPages.clear ();
+
         std::vector <Alignment>::iterator sa = mSectionAlignment.begin ();
         for (Sections::iterator i = mBook->mSections.begin (); i != mBook->mSections.end (); ++i, ++sa)
         {
@@ -478,6 +493,38 @@ struct TypesetBookImpl::Typesetter : BookTypesetter
         return mBook;
     }
 
+    void setCheckpoint ()
+    {
+        sectionBreak (0);
+
+        mCheckpoint.mSections = mBook->mSections.size ();
+        mCheckpoint.mContents = mBook->mContents.size ();
+        mCheckpoint.mStyles = mBook->mStyles.size ();
+        mCheckpoint.mRect = mBook->mRect;
+        mCheckpoint.mCurrentContent = mCurrentContent;
+        mCheckpoint.mCurrentAlignment = mCurrentAlignment;
+    }
+
+    void truncate ()
+    {
+        mPartialWhitespace.clear ();
+        mPartialWord.clear ();
+        mRun = nullptr;
+        mLine = nullptr;
+        mSection = nullptr;
+
+        mBook->mPages.clear ();
+        mBook->mSections.resize (mCheckpoint.mSections);
+        mSectionAlignment.resize (mCheckpoint.mSections);
+        while (mBook->mContents.size () > mCheckpoint.mContents)
+            mBook->mContents.pop_back ();
+        while (mBook->mStyles.size () > mCheckpoint.mStyles)
+            mBook->mStyles.pop_back ();
+        mBook->mRect = mCheckpoint.mRect;
+        mCurrentContent = mCheckpoint.mCurrentContent;
+        mCurrentAlignment = mCheckpoint.mCurrentAlignment;
+    }
+
     void writeImpl (StyleImpl * style, Utf8Stream::Point _begin, Utf8Stream::Point _end)
     {
         Utf8Stream stream (_begin, _end);
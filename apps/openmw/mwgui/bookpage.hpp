@@ -144,7 +144,17 @@ namespace MWGui
         virtual void write (Style * Style, size_t Begin, size_t End) = 0;
 
         /// Finalize the document layout, and return a pointer to it.
+        /// @note The typesetter may be used again after truncate, which changes the returned document.
         virtual TypesetBook::Ptr complete () = 0;
+
+        /// Remember the current end of the document, followed by a section break.
+        virtual void setCheckpoint () = 0;
+
+        /// Remove everything written after the last checkpoint, or everything if there is none, so that
+        /// a changing tail of the document can be typeset again without its unchanged beginning.
+        /// @note Styles and content blocks created after the checkpoint become invalid, books
+        /// completed before must not be shown while the document is changed.
+        virtual void truncate () = 0;
     };
 
     /// An interface to the BookPage widget.
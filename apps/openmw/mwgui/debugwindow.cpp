@@ -7,6 +7,24 @@
 
 #include <LinearMath/btQuickprof.h>
 
+#include <sstream>
+
+#include "../mwbase/environment.hpp"
+#include "../mwbase/scriptmanager.hpp"
+
+namespace
+{
+    void setEditText(MyGUI::EditBox* edit, const std::string& text)
+    {
+        if (edit->isTextSelection()) // pause updating while user is trying to copy text
+            return;
+
+        size_t previousPos = edit->getVScrollPosition();
+        edit->setCaption(text);
+        edit->setVScrollPosition(std::min(previousPos, edit->getVScrollRange()-1));
+    }
+}
+
 #ifndef BT_NO_PROFILE
 
 namespace
@@ -93,15 +111,29 @@ namespace MWGui
         mBulletProfilerEdit = item->createWidgetReal<MyGUI::EditBox>
                 ("LogEdit", MyGUI::FloatCoord(0,0,1,1), MyGUI::Align::Stretch);
 
+        // Comma separated, so it can be copied to a spreadsheet
+        item = mTabControl->addItem("Script Profiler");
+        mScriptProfilerEdit = item->createWidgetReal<MyGUI::EditBox>
+                ("LogEdit", MyGUI::FloatCoord(0,0,1,1), MyGUI::Align::Stretch);
+
         MyGUI::IntSize viewSize = MyGUI::RenderManager::getInstance().getViewSize();
         mMainWidget->setSize(viewSize);
 
 
     }
 
+    void DebugWindow::onOpen()
+    {
+        MWBase::Environment::get().getScriptManager()->setProfiling(true);
+    }
+
+    void DebugWindow::onClose()
+    {
+        MWBase::Environment::get().getScriptManager()->setProfiling(false);
+    }
+
     void DebugWindow::onFrame(float dt)
     {
-#ifndef BT_NO_PROFILE
         if (!isVisible())
             return;
 
@@ -112,16 +144,15 @@ namespace MWGui
             return;
         timer = 1;
 
+#ifndef BT_NO_PROFILE
         std::stringstream stream;
         bulletDumpAll(stream);
-
-        if (mBulletProfilerEdit->isTextSelection()) // pause updating while user is trying to copy text
-            return;
-
-        size_t previousPos = mBulletProfilerEdit->getVScrollPosition();
-        mBulletProfilerEdit->setCaption(stream.str());
-        mBulletProfilerEdit->setVScrollPosition(std::min(previousPos, mBulletProfilerEdit->getVScrollRange()-1));
+        setEditText(mBulletProfilerEdit, stream.str());
 #endif
+
+        std::stringstream scriptStream;
+        MWBase::Environment::get().getScriptManager()->writeProfile(scriptStream);
+        setEditText(mScriptProfilerEdit, scriptStream.str());
     }
 
 }
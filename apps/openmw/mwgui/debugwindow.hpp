@@ -13,10 +13,14 @@ namespace MWGui
 
         void onFrame(float dt);
 
+        void onOpen() override;
+        void onClose() override;
+
     private:
         MyGUI::TabControl* mTabControl;
 
         MyGUI::EditBox* mBulletProfilerEdit;
+        MyGUI::EditBox* mScriptProfilerEdit;
     };
 
 }
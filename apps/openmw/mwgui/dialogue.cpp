@@ -269,6 +269,8 @@ namespace MWGui
         : WindowBase("openmw_dialogue_window.layout")
         , mIsCompanion(false)
         , mGoodbye(false)
+        , mTypesetHistory(0)
+        , mHistoryTypesetterWidth(0)
         , mPersuasionDialog(new ResponseCallback(this))
         , mCallback(new ResponseCallback(this))
         , mGreetingCallback(new ResponseCallback(this, false))
@@ -418,6 +420,8 @@ namespace MWGui
         bool sameActor = (mPtr == actor);
         if (!sameActor)
         {
+            mHistory->showPage(TypesetBook::Ptr(), 0);
+            mHistoryTypesetter.reset();
             for (DialogueText* text : mHistoryContents)
                 delete text;
             mHistoryContents.clear();
@@ -492,6 +496,7 @@ namespace MWGui
             mDeleteLater.push_back(linkPair.second);
         mTopicLinks.clear();
         mKeywordSearch.clear();
+        mHistoryTypesetter.reset();
 
         int services = mPtr.getClass().getServices(mPtr);
 
@@ -560,10 +565,23 @@ namespace MWGui
             mScrollBar->setVisible(true);
         }
 
-        BookTypesetter::Ptr typesetter = BookTypesetter::create (mHistory->getWidth(), std::numeric_limits<int>::max());
+        if (!mHistoryTypesetter || mHistory->getWidth() != mHistoryTypesetterWidth)
+        {
+            mHistoryTypesetter = BookTypesetter::create (mHistory->getWidth(), std::numeric_limits<int>::max());
+            mHistoryTypesetterWidth = mHistory->getWidth();
+            mTypesetHistory = 0;
+        }
+        else
+        {
+            // The shown book is changed in place, only the choices after the history are typeset again
+            mHistory->showPage(TypesetBook::Ptr(), 0);
+            mHistoryTypesetter->truncate();
+        }
+        BookTypesetter::Ptr typesetter = mHistoryTypesetter;
 
-        for (DialogueText* text : mHistoryContents)
-            text->write(typesetter, &mKeywordSearch, mTopicLinks);
+        for (; mTypesetHistory < mHistoryContents.size(); ++mTypesetHistory)
+            mHistoryContents[mTypesetHistory]->write(typesetter, &mKeywordSearch, mTopicLinks);
+        typesetter->setCheckpoint();
 
         BookTypesetter::Style* body = typesetter->createStyle("", MyGUI::Colour::White, false);
 
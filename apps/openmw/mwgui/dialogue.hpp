@@ -171,6 +171,12 @@ namespace MWGui
 
         KeywordSearchT mKeywordSearch;
 
+        // Typesetter holding the history up to mTypesetHistory, so that new responses are laid out on their own.
+        // Reset when the width or the topic links change.
+        BookTypesetter::Ptr mHistoryTypesetter;
+        size_t mTypesetHistory;
+        int mHistoryTypesetterWidth;
+
         BookPage* mHistory;
         Gui::MWList*   mTopicsList;
         MyGUI::ScrollBar* mScrollBar;
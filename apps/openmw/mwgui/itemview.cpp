@@ -1,5 +1,6 @@
 #include "itemview.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 #include <MyGUI_FactoryManager.h>
@@ -9,6 +10,8 @@
 #include <MyGUI_ScrollView.h>
 #include <MyGUI_Button.h>
 
+#include <components/debug/debuglog.hpp>
+
 #include "../mwworld/class.hpp"
 
 #include "itemmodel.hpp"
@@ -20,11 +23,22 @@ namespace MWGui
 ItemView::ItemView()
     : mModel(nullptr)
     , mScrollView(nullptr)
+    , mDragArea(nullptr)
+    , mRows(1)
 {
 }
 
 ItemView::~ItemView()
 {
+    try
+    {
+        MyGUI::Gui::getInstance().eventFrameStart -= MyGUI::newDelegate(this, &ItemView::onFrameStart);
+    }
+    catch(const MyGUI::Exception& e)
+    {
+        Log(Debug::Error) << "Error in the destructor: " << e.what();
+    }
+
     delete mModel;
 }
 
@@ -48,41 +62,29 @@ void ItemView::initialiseOverride()
         throw std::runtime_error("Item view needs a scroll view");
 
     mScrollView->setCanvasAlign(MyGUI::Align::Left | MyGUI::Align::Top);
+
+    MyGUI::Gui::getInstance().eventFrameStart += MyGUI::newDelegate(this, &ItemView::onFrameStart);
 }
 
 void ItemView::layoutWidgets()
 {
-    if (!mScrollView->getChildCount())
+    if (!mDragArea)
         return;
 
-    int x = 0;
-    int y = 0;
-    MyGUI::Widget* dragArea = mScrollView->getChildAt(0);
     int maxHeight = mScrollView->getHeight();
+    const int itemCount = static_cast<int>(mModel->getItemCount());
 
     int rows = maxHeight/42;
     rows = std::max(rows, 1);
-    bool showScrollbar = int(std::ceil(dragArea->getChildCount()/float(rows))) > mScrollView->getWidth()/42;
+    bool showScrollbar = int(std::ceil(itemCount/float(rows))) > mScrollView->getWidth()/42;
     if (showScrollbar)
         maxHeight -= 18;
 
-    for (unsigned int i=0; i<dragArea->getChildCount(); ++i)
-    {
-        MyGUI::Widget* w = dragArea->getChildAt(i);
-
-        w->setPosition(x, y);
-
-        y += 42;
-
-        if (y > maxHeight-42 && i < dragArea->getChildCount()-1)
-        {
-            x += 42;
-            y = 0;
-        }
-    }
-    x += 42;
+    // Items are laid out in columns from top to bottom
+    mRows = std::max(maxHeight/42, 1);
+    const int columns = std::max((itemCount + mRows - 1) / mRows, 1);
 
-    MyGUI::IntSize size = MyGUI::IntSize(std::max(mScrollView->getSize().width, x), mScrollView->getSize().height);
+    MyGUI::IntSize size = MyGUI::IntSize(std::max(mScrollView->getSize().width, columns * 42), mScrollView->getSize().height);
 
     // Canvas size must be expressed with VScroll disabled, otherwise MyGUI would expand the scroll area when the scrollbar is hidden
     mScrollView->setVisibleVScroll(false);
@@ -90,33 +92,51 @@ void ItemView::layoutWidgets()
     mScrollView->setCanvasSize(size);
     mScrollView->setVisibleVScroll(true);
     mScrollView->setVisibleHScroll(true);
-    dragArea->setSize(size);
+    mDragArea->setSize(size);
+
+    updateVisibleWidgets();
 }
 
-void ItemView::update()
+void ItemView::updateVisibleWidgets()
 {
-    while (mScrollView->getChildCount())
-        MyGUI::Gui::getInstance().destroyWidget(mScrollView->getChildAt(0));
+    mViewOffset = mScrollView->getViewOffset();
 
-    if (!mModel)
-        return;
+    const int itemCount = static_cast<int>(mModel->getItemCount());
+    const int firstColumn = std::max(-mViewOffset.left / 42, 0);
+    const int lastColumn = (-mViewOffset.left + mScrollView->getWidth()) / 42;
+    const int first = std::min(firstColumn * mRows, itemCount);
+    const int end = std::min((lastColumn + 1) * mRows, itemCount);
 
-    mModel->update();
-
-    MyGUI::Widget* dragArea = mScrollView->createWidget<MyGUI::Widget>("",0,0,mScrollView->getWidth(),mScrollView->getHeight(),
-                                                                       MyGUI::Align::Stretch);
-    dragArea->setNeedMouseFocus(true);
-    dragArea->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedBackground);
-    dragArea->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
-
-    for (ItemModel::ModelIndex i=0; i<static_cast<int>(mModel->getItemCount()); ++i)
+    while (static_cast<int>(mItemWidgets.size()) < end - first)
     {
-        const ItemStack& item = mModel->getItem(i);
-
-        ItemWidget* itemWidget = dragArea->createWidget<ItemWidget>("MW_ItemIcon",
+        ItemWidget* itemWidget = mDragArea->createWidget<ItemWidget>("MW_ItemIcon",
             MyGUI::IntCoord(0, 0, 42, 42), MyGUI::Align::Default);
         itemWidget->setUserString("ToolTipType", "ItemModelIndex");
-        itemWidget->setUserData(std::make_pair(i, mModel));
+        itemWidget->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedItem);
+        itemWidget->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
+        mItemWidgets.push_back(itemWidget);
+    }
+
+    for (size_t i = 0; i < mItemWidgets.size(); ++i)
+    {
+        ItemWidget* itemWidget = mItemWidgets[i];
+        const ItemModel::ModelIndex index = first + static_cast<int>(i);
+        if (index >= end)
+        {
+            itemWidget->setVisible(false);
+            continue;
+        }
+
+        itemWidget->setVisible(true);
+        itemWidget->setPosition((index / mRows) * 42, (index % mRows) * 42);
+
+        const std::pair<ItemModel::ModelIndex, ItemModel*>* assigned
+            = itemWidget->getUserData<std::pair<ItemModel::ModelIndex, ItemModel*> >(false);
+        if (assigned && assigned->first == index && assigned->second == mModel)
+            continue;
+
+        const ItemStack& item = mModel->getItem(index);
+        itemWidget->setUserData(std::make_pair(index, mModel));
         ItemWidget::ItemState state = ItemWidget::None;
         if (item.mType == ItemStack::Type_Barter)
             state = ItemWidget::Barter;
@@ -124,10 +144,32 @@ void ItemView::update()
             state = ItemWidget::Equip;
         itemWidget->setItem(item.mBase, state);
         itemWidget->setCount(item.mCount);
-
-        itemWidget->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedItem);
-        itemWidget->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
     }
+}
+
+void ItemView::onFrameStart(float dt)
+{
+    if (mDragArea && mScrollView->getViewOffset() != mViewOffset)
+        updateVisibleWidgets();
+}
+
+void ItemView::update()
+{
+    while (mScrollView->getChildCount())
+        MyGUI::Gui::getInstance().destroyWidget(mScrollView->getChildAt(0));
+    mDragArea = nullptr;
+    mItemWidgets.clear();
+
+    if (!mModel)
+        return;
+
+    mModel->update();
+
+    mDragArea = mScrollView->createWidget<MyGUI::Widget>("",0,0,mScrollView->getWidth(),mScrollView->getHeight(),
+                                                         MyGUI::Align::Stretch);
+    mDragArea->setNeedMouseFocus(true);
+    mDragArea->eventMouseButtonClick += MyGUI::newDelegate(this, &ItemView::onSelectedBackground);
+    mDragArea->eventMouseWheel += MyGUI::newDelegate(this, &ItemView::onMouseWheelMoved);
 
     layoutWidgets();
 }
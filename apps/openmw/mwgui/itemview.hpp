@@ -1,12 +1,15 @@
 #ifndef MWGUI_ITEMVIEW_H
 #define MWGUI_ITEMVIEW_H
 
+#include <vector>
+
 #include <MyGUI_Widget.h>
 
 #include "itemmodel.hpp"
 
 namespace MWGui
 {
+    class ItemWidget;
 
     class ItemView : public MyGUI::Widget
     {
@@ -37,6 +40,11 @@ namespace MWGui
 
         void layoutWidgets();
 
+        /// Only the item widgets in the visible columns exist, they are reassigned when scrolling
+        void updateVisibleWidgets();
+
+        void onFrameStart(float dt);
+
         virtual void setSize(const MyGUI::IntSize& _value);
         virtual void setCoord(const MyGUI::IntCoord& _value);
 
@@ -46,6 +54,11 @@ namespace MWGui
 
         ItemModel* mModel;
         MyGUI::ScrollView* mScrollView;
+        MyGUI::Widget* mDragArea;
+
+        std::vector<ItemWidget*> mItemWidgets;
+        int mRows;
+        MyGUI::IntPoint mViewOffset;
 
     };
 
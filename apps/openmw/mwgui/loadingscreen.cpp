@@ -12,7 +12,11 @@
 #include <components/misc/rng.hpp>
 #include <components/debug/debuglog.hpp>
 #include <components/myguiplatform/myguitexture.hpp>
+#include <components/resource/imagemanager.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
 #include <components/settings/settings.hpp>
+#include <components/shader/shadermanager.hpp>
 #include <components/vfs/manager.hpp>
 
 #include "../mwbase/environment.hpp"
@@ -27,18 +31,21 @@
 namespace MWGui
 {
 
-    LoadingScreen::LoadingScreen(const VFS::Manager* vfs, osgViewer::Viewer* viewer)
+    LoadingScreen::LoadingScreen(Resource::ResourceSystem* resourceSystem, osgViewer::Viewer* viewer)
         : WindowBase("openmw_loading_screen.layout")
-        , mVFS(vfs)
+        , mResourceSystem(resourceSystem)
         , mViewer(viewer)
         , mTargetFrameRate(120.0)
+        , mIdleFrameRate(10.0)
         , mLastWallpaperChangeTime(0.0)
         , mLastRenderTime(0.0)
         , mLoadingOnTime(0.0)
         , mImportantLabel(false)
         , mVisible(false)
         , mProgress(0)
+        , mChanged(true)
         , mShowWallpaper(true)
+        , mPrecompileShaders(Settings::Manager::getBool("precompile shaders", "Shaders"))
     {
         mMainWidget->setSize(MyGUI::RenderManager::getInstance().getViewSize());
 
@@ -62,35 +69,23 @@ namespace MWGui
 
     void LoadingScreen::findSplashScreens()
     {
-        const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-        std::string pattern = "Splash/";
-        mVFS->normalizeFilename(pattern);
-
         /* priority given to the left */
         std::list<std::string> supported_extensions = {".tga", ".dds", ".ktx", ".png", ".bmp", ".jpeg", ".jpg"};
 
-        auto found = index.lower_bound(pattern);
-        while (found != index.end())
+        for (const std::string& name : mResourceSystem->getVFS()->getRecursiveDirectoryIterator("Splash/"))
         {
-            const std::string& name = found->first;
-            if (name.size() >= pattern.size() && name.substr(0, pattern.size()) == pattern)
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos)
             {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos)
+                for(auto const extension: supported_extensions)
                 {
-                    for(auto const extension: supported_extensions)
+                    if (name.compare(pos, name.size() - pos, extension) == 0)
                     {
-                        if (name.compare(pos, name.size() - pos, extension) == 0)
-                        {
-                            mSplashScreens.push_back(found->first);
-                            break;  /* based on priority */
-                        }
+                        mSplashScreens.push_back(name);
+                        break;  /* based on priority */
                     }
                 }
             }
-            else
-                break;
-            ++found;
         }
         if (mSplashScreens.empty())
             Log(Debug::Warning) << "Warning: no splash screens found!";
@@ -99,6 +94,7 @@ namespace MWGui
     void LoadingScreen::setLabel(const std::string &label, bool important, bool center)
     {
         mImportantLabel = important;
+        mChanged = true;
 
         mLoadingText->setCaptionWithReplacing(label);
         int padding = mLoadingBox->getWidth() - mLoadingText->getWidth();
@@ -169,6 +165,12 @@ namespace MWGui
         // We are already using node masks to avoid the scene from being updated/rendered, but node masks don't work for computeBound()
         mViewer->getSceneData()->setComputeBoundingSphereCallback(new DontComputeBoundCallback);
 
+        // the scene is hidden anyway, so load textures right away instead of showing placeholders after loading
+        mResourceSystem->getImageManager()->setAsyncDecodingSuspended(true);
+        // and link the shaders of the loaded objects before they are shown
+        if (mPrecompileShaders)
+            mResourceSystem->getSceneManager()->getShaderManager().setPrecompilePrograms(true);
+
         mVisible = visible;
         mLoadingBox->setVisible(mVisible);
         setVisible(true);
@@ -210,6 +212,9 @@ namespace MWGui
         mViewer->getSceneData()->setComputeBoundingSphereCallback(nullptr);
         mViewer->getSceneData()->dirtyBound();
 
+        mResourceSystem->getImageManager()->setAsyncDecodingSuspended(false);
+        mResourceSystem->getSceneManager()->getShaderManager().setPrecompilePrograms(false);
+
         //std::cout << "loading took " << mTimer.time_m() - mLoadingOnTime << std::endl;
         setVisible(false);
 
@@ -219,6 +224,7 @@ namespace MWGui
 
     void LoadingScreen::changeWallpaper ()
     {
+        mChanged = true;
         if (!mSplashScreens.empty())
         {
             std::string const & randomSplash = mSplashScreens.at(Misc::Rng::rollDice(mSplashScreens.size()));
@@ -239,6 +245,7 @@ namespace MWGui
         mProgressBar->setScrollPosition(0);
         mProgressBar->setTrackSize(0);
         mProgress = 0;
+        mChanged = true;
     }
 
     void LoadingScreen::setProgress (size_t value)
@@ -250,6 +257,7 @@ namespace MWGui
         mProgress = value;
         mProgressBar->setScrollPosition(0);
         mProgressBar->setTrackSize(static_cast<int>(value / (float)(mProgressBar->getScrollRange()) * mProgressBar->getLineSize()));
+        mChanged = true;
         draw();
     }
 
@@ -259,7 +267,12 @@ namespace MWGui
         size_t value = mProgress + increase;
         value = std::min(value, mProgressBar->getScrollRange()-1);
         mProgress = value;
-        mProgressBar->setTrackSize(static_cast<int>(value / (float)(mProgressBar->getScrollRange()) * mProgressBar->getLineSize()));
+        const int trackSize = static_cast<int>(value / (float)(mProgressBar->getScrollRange()) * mProgressBar->getLineSize());
+        if (trackSize != mProgressBar->getTrackSize())
+        {
+            mProgressBar->setTrackSize(trackSize);
+            mChanged = true;
+        }
         draw();
     }
 
@@ -268,6 +281,10 @@ namespace MWGui
         if ( mTimer.time_m() <= mLastRenderTime + (1.0/getTargetFrameRate()) * 1000.0)
             return false;
 
+        // the same picture is rendered again only to keep the window responsive, the loading doesn't need to wait for it often
+        if (!mChanged && mLastRenderTime > mLoadingOnTime && mTimer.time_m() <= mLastRenderTime + (1.0/mIdleFrameRate) * 1000.0)
+            return false;
+
         // the minimal delay before a loading screen shows
         const float initialDelay = 0.05;
 
@@ -358,6 +375,7 @@ namespace MWGui
         mViewer->getCamera()->setCullMask(oldCullMask);
 
         mLastRenderTime = mTimer.time_m();
+        mChanged = false;
     }
 
 }
@@ -1,5 +1,7 @@
 #include "mapwindow.hpp"
 
+#include <algorithm>
+
 #include <osg/Texture2D>
 
 #include <MyGUI_ScrollView.h>
@@ -856,8 +858,26 @@ namespace MWGui
 
     void MapWindow::cellExplored(int x, int y)
     {
+        const CellId cell(x, y);
+        if (std::find(mPendingExploredCells.begin(), mPendingExploredCells.end(), cell) == mPendingExploredCells.end())
+            mPendingExploredCells.push_back(cell);
+    }
+
+    void MapWindow::updateExploredCells()
+    {
+        // The local map of a cell may wait a few frames to be rendered
+        for (auto it = mPendingExploredCells.begin(); it != mPendingExploredCells.end();)
+        {
+            if (mLocalMapRender->isRenderPending(it->first, it->second))
+            {
+                ++it;
+                continue;
+            }
+            mGlobalMapRender->exploreCell(it->first, it->second, mLocalMapRender->getMapTexture(it->first, it->second));
+            it = mPendingExploredCells.erase(it);
+        }
+
         mGlobalMapRender->cleanupCameras();
-        mGlobalMapRender->exploreCell(x, y, mLocalMapRender->getMapTexture(x, y));
     }
 
     void MapWindow::onFrame(float dt)
@@ -1023,6 +1043,7 @@ namespace MWGui
     void MapWindow::clear()
     {
         mMarkers.clear();
+        mPendingExploredCells.clear();
 
         mGlobalMapRender->clear();
         mChanged = true;
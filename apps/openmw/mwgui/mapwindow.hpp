@@ -222,6 +222,10 @@ namespace MWGui
         // reveals this cell's map on the global map
         void cellExplored(int x, int y);
 
+        /// Reveals the explored cells whose local map has been rendered. Should be called every frame, after
+        /// MWRender::LocalMap::cleanupCameras.
+        void updateExploredCells();
+
         void setGlobalMapPlayerPosition (float worldX, float worldY);
         void setGlobalMapPlayerDir(const float x, const float y);
 
@@ -269,6 +273,7 @@ namespace MWGui
         // Markers on global map
         typedef std::pair<int, int> CellId;
         std::set<CellId> mMarkers;
+        std::vector<CellId> mPendingExploredCells;
 
         MyGUI::Button* mEventBoxGlobal;
         MyGUI::Button* mEventBoxLocal;
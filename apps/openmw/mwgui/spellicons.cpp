@@ -65,6 +65,8 @@ namespace MWGui
 
         int w=2;
 
+        static const Settings::SettingValue<bool> showEffectDuration("show effect duration", "Game");
+
         for (auto& effectInfoPair : effects)
         {
             const int effectId = effectInfoPair.first;
@@ -137,7 +139,7 @@ namespace MWGui
                             MWBase::Environment::get().getWindowManager()->getGameSettingString("spoint", "") );
                     }
                 }
-                if (effectInfo.mRemainingTime > -1 && Settings::Manager::getBool("show effect duration","Game"))
+                if (effectInfo.mRemainingTime > -1 && showEffectDuration.get())
                     sourcesDescription += MWGui::ToolTips::getDurationString(effectInfo.mRemainingTime, " #{sDuration}");
 
                 addNewLine = true;
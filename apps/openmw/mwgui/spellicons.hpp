@@ -1,6 +1,7 @@
 #ifndef MWGUI_SPELLICONS_H
 #define MWGUI_SPELLICONS_H
 
+#include <map>
 #include <string>
 #include <vector>
 
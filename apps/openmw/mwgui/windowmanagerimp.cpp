@@ -248,7 +248,7 @@ namespace MWGui
         mKeyboardNavigation->setEnabled(keyboardNav);
         Gui::ImageButton::setDefaultNeedKeyFocus(keyboardNav);
 
-        mLoadingScreen = new LoadingScreen(mResourceSystem->getVFS(), mViewer);
+        mLoadingScreen = new LoadingScreen(mResourceSystem, mViewer);
         mWindows.push_back(mLoadingScreen);
 
         //set up the hardware cursor manager
@@ -1021,7 +1021,10 @@ namespace MWGui
         mToolTips->onFrame(frameDuration);
 
         if (mLocalMapRender)
+        {
             mLocalMapRender->cleanupCameras();
+            mMap->updateExploredCells();
+        }
 
         if (!gameRunning)
             return;
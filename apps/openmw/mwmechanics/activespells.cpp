@@ -1,5 +1,7 @@
 #include "activespells.hpp"
 
+#include <limits>
+
 #include <components/misc/rng.hpp>
 #include <components/misc/stringops.hpp>
 
@@ -17,10 +19,20 @@ namespace MWMechanics
         bool rebuild = false;
 
         MWWorld::TimeStamp now = MWBase::Environment::get().getWorld()->getTimeStamp();
+        const float timeScale = MWBase::Environment::get().getWorld()->getTimeScaleFactor();
+
+        // Changed spells or durations may expire earlier than the known end times
+        if (mSpellsChanged || timeScale != mTimeScale)
+        {
+            mNextExpiry = now;
+            mTimeScale = timeScale;
+        }
 
         // Erase no longer active spells and effects
-        if (mLastUpdate!=now)
+        if (mLastUpdate!=now && mNextExpiry<=now)
         {
+            mNextExpiry = MWWorld::TimeStamp(0, std::numeric_limits<int>::max());
+
             TContainer::iterator iter (mSpells.begin());
             while (iter!=mSpells.end())
             {
@@ -35,22 +47,26 @@ namespace MWMechanics
                     for (std::vector<ActiveEffect>::iterator effectIt = effects.begin(); effectIt != effects.end();)
                     {
                         MWWorld::TimeStamp start = iter->second.mTimeStamp;
-                        MWWorld::TimeStamp end = start + static_cast<double>(effectIt->mDuration)*MWBase::Environment::get().getWorld()->getTimeScaleFactor()/(60*60);
+                        MWWorld::TimeStamp end = start + static_cast<double>(effectIt->mDuration)*timeScale/(60*60);
                         if (end <= now)
                         {
                             effectIt = effects.erase(effectIt);
                             rebuild = true;
                         }
                         else
+                        {
+                            if (end < mNextExpiry)
+                                mNextExpiry = end;
                             ++effectIt;
+                        }
                     }
                     ++iter;
                 }
             }
-
-            mLastUpdate = now;
         }
 
+        mLastUpdate = now;
+
         if (mSpellsChanged)
         {
             mSpellsChanged = false;
@@ -89,6 +105,8 @@ namespace MWMechanics
     ActiveSpells::ActiveSpells()
         : mSpellsChanged (false)
         , mLastUpdate (MWBase::Environment::get().getWorld()->getTimeStamp())
+        , mNextExpiry (mLastUpdate)
+        , mTimeScale (MWBase::Environment::get().getWorld()->getTimeScaleFactor())
     {}
 
     const MagicEffects& ActiveSpells::getMagicEffects() const
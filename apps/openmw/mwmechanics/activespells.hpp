@@ -50,6 +50,9 @@ namespace MWMechanics
             mutable MagicEffects mEffects;
             mutable bool mSpellsChanged;
             mutable MWWorld::TimeStamp mLastUpdate;
+            /// Earliest end time of the active effects, nothing needs to be erased before it
+            mutable MWWorld::TimeStamp mNextExpiry;
+            mutable float mTimeScale;
 
             void update() const;
             
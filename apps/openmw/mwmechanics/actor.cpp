@@ -5,6 +5,7 @@
 namespace MWMechanics
 {
     Actor::Actor(const MWWorld::Ptr &ptr, MWRender::Animation *animation)
+        : mIndex(0)
     {
         mCharacterController.reset(new CharacterController(ptr, animation));
     }
@@ -18,4 +19,14 @@ namespace MWMechanics
     {
         return mCharacterController.get();
     }
+
+    std::size_t Actor::getIndex() const
+    {
+        return mIndex;
+    }
+
+    void Actor::setIndex(std::size_t index)
+    {
+        mIndex = index;
+    }
 }
@@ -1,6 +1,7 @@
 #ifndef OPENMW_MECHANICS_ACTOR_H
 #define OPENMW_MECHANICS_ACTOR_H
 
+#include <cstddef>
 #include <memory>
 
 namespace MWRender
@@ -27,8 +28,13 @@ namespace MWMechanics
 
         CharacterController* getCharacterController();
 
+        /// Position of this actor's per-frame data in the dense storage of MWMechanics::Actors
+        std::size_t getIndex() const;
+        void setIndex(std::size_t index);
+
     private:
         std::unique_ptr<CharacterController> mCharacterController;
+        std::size_t mIndex;
     };
 
 }
@@ -1,5 +1,8 @@
 #include "actors.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
 
@@ -146,6 +149,11 @@ namespace MWMechanics
     static const int GREETING_SHOULD_END = 10;
     static const float DECELERATE_DISTANCE = 512.f;
 
+    // Size of the grid cells used to look up nearby actors. For the lookups done between two grid updates,
+    // actors may have moved a bit, so the grid cells are searched with a margin.
+    static const float ACTOR_GRID_CELL_SIZE = 1024.f;
+    static const float ACTOR_GRID_MARGIN = 256.f;
+
     class GetStuntedMagickaDuration : public MWMechanics::EffectSourceVisitor
     {
     public:
@@ -356,15 +364,11 @@ namespace MWMechanics
         calculateRestoration(ptr, duration);
     }
 
-    void Actors::updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
-                                    MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance)
+    void Actors::updateHeadTracking(const MWWorld::Ptr& actor, MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance)
     {
         if (!actor.getRefData().getBaseNode())
             return;
 
-        if (targetActor.getClass().getCreatureStats(targetActor).isDead())
-            return;
-
         static const float fMaxHeadTrackDistance = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
                 .find("fMaxHeadTrackDistance")->mValue.getFloat();
         static const float fInteriorHeadTrackMult = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
@@ -375,26 +379,77 @@ namespace MWMechanics
             maxDistance *= fInteriorHeadTrackMult;
 
         const osg::Vec3f actor1Pos(actor.getRefData().getPosition().asVec3());
-        const osg::Vec3f actor2Pos(targetActor.getRefData().getPosition().asVec3());
-        float sqrDist = (actor1Pos - actor2Pos).length2();
-
-        if (sqrDist > maxDistance*maxDistance)
-            return;
-
-        // stop tracking when target is behind the actor
         osg::Vec3f actorDirection = actor.getRefData().getBaseNode()->getAttitude() * osg::Vec3f(0,1,0);
-        osg::Vec3f targetDirection(actor2Pos - actor1Pos);
         actorDirection.z() = 0;
-        targetDirection.z() = 0;
         actorDirection.normalize();
-        targetDirection.normalize();
-        if (std::acos(actorDirection * targetDirection) < osg::DegreesToRadians(90.f)
-            && sqrDist <= sqrHeadTrackDistance
-            && MWBase::Environment::get().getWorld()->getLOS(actor, targetActor) // check LOS and awareness last as it's the most expensive function
-            && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(targetActor, actor))
+
+        // Find the targets in front of the actor and in range first, so the lines of sight that are checked
+        // in any case can be checked in one batch, which the physics system can spread across threads
+        std::vector<MWWorld::Ptr> neighbors;
+        getObjectsInRange(actor1Pos, maxDistance, neighbors);
+
+        std::vector<std::pair<MWWorld::Ptr, float> > candidates;
+        for (const MWWorld::Ptr& targetActor : neighbors)
         {
-            sqrHeadTrackDistance = sqrDist;
-            headTrackTarget = targetActor;
+            if (targetActor == actor)
+                continue;
+
+            if (targetActor.getClass().getCreatureStats(targetActor).isDead())
+                continue;
+
+            const osg::Vec3f actor2Pos(targetActor.getRefData().getPosition().asVec3());
+            float sqrDist = (actor1Pos - actor2Pos).length2();
+
+            if (sqrDist > maxDistance*maxDistance)
+                continue;
+
+            // stop tracking when target is behind the actor
+            osg::Vec3f targetDirection(actor2Pos - actor1Pos);
+            targetDirection.z() = 0;
+            targetDirection.normalize();
+            if (!(std::acos(actorDirection * targetDirection) < osg::DegreesToRadians(90.f)))
+                continue;
+
+            candidates.push_back(std::make_pair(targetActor, sqrDist));
+        }
+
+        if (candidates.empty())
+            return;
+
+        // A target that is not farther than any target before it passes the distance check whatever the result
+        // of the checks before it, so its line of sight is needed anyway. The line of sight to other targets
+        // depends on the awareness checks before them and is only checked once it is needed.
+        std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> > lineOfSightQueries;
+        std::vector<int> lineOfSightIndices(candidates.size(), -1);
+        float minSqrDist = sqrHeadTrackDistance;
+        for (size_t i=0; i<candidates.size(); ++i)
+        {
+            if (candidates[i].second > minSqrDist)
+                continue;
+            minSqrDist = candidates[i].second;
+            lineOfSightIndices[i] = static_cast<int>(lineOfSightQueries.size());
+            lineOfSightQueries.push_back(std::make_pair(actor, candidates[i].first));
+        }
+
+        MWBase::World* world = MWBase::Environment::get().getWorld();
+        std::vector<bool> lineOfSight;
+        world->getLOS(lineOfSightQueries, lineOfSight);
+
+        // The awareness check is random, so it must be done for the same targets and in the same order as before
+        for (size_t i=0; i<candidates.size(); ++i)
+        {
+            const MWWorld::Ptr& targetActor = candidates[i].first;
+            const float sqrDist = candidates[i].second;
+            if (sqrDist > sqrHeadTrackDistance)
+                continue;
+
+            const bool hasLineOfSight = lineOfSightIndices[i] >= 0 ? lineOfSight[lineOfSightIndices[i]]
+                                                                   : world->getLOS(actor, targetActor);
+            if (hasLineOfSight && MWBase::Environment::get().getMechanicsManager()->awarenessCheck(targetActor, actor))
+            {
+                sqrHeadTrackDistance = sqrDist;
+                headTrackTarget = targetActor;
+            }
         }
     }
 
@@ -578,9 +633,7 @@ namespace MWMechanics
 
         // Get actors allied with actor1. Includes those following or escorting actor1, actors following or escorting those actors, (recursive)
         // and any actor currently being followed or escorted by actor1
-        std::set<MWWorld::Ptr> allies1;
-
-        getActorsSidingWith(actor1, allies1, cachedAllies);
+        const std::set<MWWorld::Ptr>& allies1 = getActorsSidingWith(actor1, cachedAllies);
 
         // If an ally of actor1 has been attacked by actor2 or has attacked actor2, start combat between actor1 and actor2
         for (const MWWorld::Ptr &ally : allies1)
@@ -602,8 +655,7 @@ namespace MWMechanics
                 aggressive = true;
         }
 
-        std::set<MWWorld::Ptr> playerAllies;
-        getActorsSidingWith(MWMechanics::getPlayer(), playerAllies, cachedAllies);
+        const std::set<MWWorld::Ptr>& playerAllies = getActorsSidingWith(MWMechanics::getPlayer(), cachedAllies);
 
         bool isPlayerFollowerOrEscorter = playerAllies.find(actor1) != playerAllies.end();
 
@@ -614,9 +666,7 @@ namespace MWMechanics
             // Check that actor2 is in combat with actor1
             if (actor2.getClass().getCreatureStats(actor2).getAiSequence().isInCombat(actor1))
             {
-                std::set<MWWorld::Ptr> allies2;
-
-                getActorsSidingWith(actor2, allies2, cachedAllies);
+                const std::set<MWWorld::Ptr>& allies2 = getActorsSidingWith(actor2, cachedAllies);
 
                 // Check that an ally of actor2 is also in combat with actor1
                 for (const MWWorld::Ptr &ally2 : allies2)
@@ -1361,6 +1411,14 @@ namespace MWMechanics
     Actors::Actors()
     {
         mTimerDisposeSummonsCorpses = 0.2f; // We should add a delay between summoned creature death and its corpse despawning
+        mActorGridDirty = true;
+        mHasRemovedActorData = false;
+
+        mAiLodDistance = std::max(0.f, Settings::Manager::getFloat("ai lod distance", "Game"));
+        mAiLodMaxInterval = static_cast<unsigned int>(std::max(1, Settings::Manager::getInt("ai lod max interval", "Game")));
+        mAiLodFrame = 0;
+        mAnimationLodDistance = std::max(0.f, Settings::Manager::getFloat("animation lod distance", "Game"));
+        mAnimationLodMaxInterval = static_cast<unsigned int>(std::max(1, Settings::Manager::getInt("animation lod max interval", "Game")));
 
         updateProcessingRange();
     }
@@ -1394,9 +1452,11 @@ namespace MWMechanics
         MWRender::Animation *anim = MWBase::Environment::get().getWorld()->getAnimation(ptr);
         if (!anim)
             return;
-        mActors.insert(std::make_pair(ptr, new Actor(ptr, anim)));
+        Actor* actor = new Actor(ptr, anim);
+        mActors.insert(std::make_pair(ptr, actor));
+        addActorData(ptr, actor);
 
-        CharacterController* ctrl = mActors[ptr]->getCharacterController();
+        CharacterController* ctrl = actor->getCharacterController();
         if (updateImmediately)
             ctrl->update(0);
 
@@ -1409,6 +1469,158 @@ namespace MWMechanics
         updateVisibility(ptr, ctrl);
     }
 
+    void Actors::addActorData(const MWWorld::Ptr& ptr, Actor* actor)
+    {
+        actor->setIndex(mActorPtrs.size());
+        mActorPtrs.push_back(ptr);
+        mActorObjects.push_back(actor);
+        mActorControllers.push_back(actor->getCharacterController());
+        mActorSqrDistances.push_back(0.f);
+        mActorFlags.push_back(0);
+        mActorAiDuration.push_back(0.f);
+        mActorAiMovement.push_back(AiMovement());
+
+        const MWWorld::Ptr player = MWBase::Environment::get().getWorld()->getPlayerPtr();
+        updateActorData(actor->getIndex(), player, player.getRefData().getPosition().asVec3());
+
+        mActorGridDirty = true;
+    }
+
+    void Actors::removeActorData(Actor* actor)
+    {
+        // Leave an empty slot, so the order of the remaining actors is kept and a loop over the arrays
+        // does not skip the next actor when one is removed during the update
+        const std::size_t index = actor->getIndex();
+        mActorPtrs[index] = MWWorld::Ptr();
+        mActorObjects[index] = nullptr;
+        mActorControllers[index] = nullptr;
+        mActorFlags[index] = 0;
+        mHasRemovedActorData = true;
+
+        mActorGridDirty = true;
+    }
+
+    void Actors::compactActorData()
+    {
+        if (!mHasRemovedActorData)
+            return;
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
+        {
+            if (!mActorObjects[i])
+                continue;
+
+            if (count != i)
+            {
+                mActorPtrs[count] = mActorPtrs[i];
+                mActorObjects[count] = mActorObjects[i];
+                mActorControllers[count] = mActorControllers[i];
+                mActorSqrDistances[count] = mActorSqrDistances[i];
+                mActorFlags[count] = mActorFlags[i];
+                mActorAiDuration[count] = mActorAiDuration[i];
+                mActorAiMovement[count] = mActorAiMovement[i];
+                mActorObjects[count]->setIndex(count);
+            }
+            ++count;
+        }
+
+        mActorPtrs.resize(count);
+        mActorObjects.resize(count);
+        mActorControllers.resize(count);
+        mActorSqrDistances.resize(count);
+        mActorFlags.resize(count);
+        mActorAiDuration.resize(count);
+        mActorAiMovement.resize(count);
+
+        mHasRemovedActorData = false;
+        mActorGridDirty = true;
+    }
+
+    void Actors::updateActorData(std::size_t index, const MWWorld::Ptr& player, const osg::Vec3f& playerPos)
+    {
+        const MWWorld::Ptr& ptr = mActorPtrs[index];
+        mActorSqrDistances[index] = (playerPos - ptr.getRefData().getPosition().asVec3()).length2();
+
+        unsigned char flags = 0;
+        if (ptr == player)
+            flags |= Flag_Player;
+        if (mActorSqrDistances[index] <= mActorsProcessingRange*mActorsProcessingRange)
+            flags |= Flag_InProcessingRange;
+        mActorFlags[index] = flags;
+    }
+
+    void Actors::updateActorData()
+    {
+        compactActorData();
+
+        const MWWorld::Ptr player = getPlayer();
+        const osg::Vec3f playerPos = player.getRefData().getPosition().asVec3();
+        for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
+            updateActorData(i, player, playerPos);
+
+        // Actors have moved since the grid was built
+        mActorGridDirty = true;
+    }
+
+    bool Actors::shouldUpdateAi(std::size_t index) const
+    {
+        if (mAiLodDistance <= 0.f || (mActorFlags[index] & Flag_Player))
+            return true;
+
+        const MWWorld::Ptr& ptr = mActorPtrs[index];
+        if (ptr.getClass().getCreatureStats(ptr).getAiSequence().isInCombat())
+            return true;
+
+        const float distance = std::sqrt(mActorSqrDistances[index]);
+        const unsigned int interval = std::min(mAiLodMaxInterval, 1 + static_cast<unsigned int>(distance / mAiLodDistance));
+
+        // Stagger the updates of actors with the same interval over the frames
+        return (mAiLodFrame + index) % interval == 0;
+    }
+
+    unsigned int Actors::getAnimationUpdateInterval(std::size_t index) const
+    {
+        if (mAnimationLodDistance <= 0.f || (mActorFlags[index] & Flag_Player))
+            return 1;
+
+        const float distance = std::sqrt(mActorSqrDistances[index]);
+        return std::min(mAnimationLodMaxInterval, 1 + static_cast<unsigned int>(distance / mAnimationLodDistance));
+    }
+
+    void Actors::storeAiMovement(std::size_t index, float aiDuration, float duration)
+    {
+        const MWWorld::Ptr& ptr = mActorPtrs[index];
+        Movement& movement = ptr.getClass().getMovementSettings(ptr);
+        AiMovement& stored = mActorAiMovement[index];
+
+        // Jumps are not repeated
+        stored.mPosition[0] = movement.mPosition[0];
+        stored.mPosition[1] = movement.mPosition[1];
+
+        // The AI turned the actor for all the frames since its last update. Spread the turn over
+        // the frames until the next update instead of applying it at once.
+        for (int i = 0; i < 3; ++i)
+        {
+            stored.mRotationRate[i] = aiDuration > 0.f ? movement.mRotation[i] / aiDuration : 0.f;
+            if (aiDuration > duration)
+                movement.mRotation[i] = stored.mRotationRate[i] * duration;
+        }
+    }
+
+    void Actors::replayAiMovement(std::size_t index, float duration)
+    {
+        // The character controller resets the movement every frame, so repeat the one of the last AI update
+        const MWWorld::Ptr& ptr = mActorPtrs[index];
+        Movement& movement = ptr.getClass().getMovementSettings(ptr);
+        const AiMovement& stored = mActorAiMovement[index];
+
+        movement.mPosition[0] = stored.mPosition[0];
+        movement.mPosition[1] = stored.mPosition[1];
+        for (int i = 0; i < 3; ++i)
+            movement.mRotation[i] = stored.mRotationRate[i] * duration;
+    }
+
     void Actors::updateVisibility (const MWWorld::Ptr& ptr, CharacterController* ctrl)
     {
         MWWorld::Ptr player = MWMechanics::getPlayer();
@@ -1442,6 +1654,7 @@ namespace MWMechanics
         PtrActorMap::iterator iter = mActors.find(ptr);
         if(iter != mActors.end())
         {
+            removeActorData(iter->second);
             delete iter->second;
             mActors.erase(iter);
         }
@@ -1496,6 +1709,8 @@ namespace MWMechanics
 
             actor->updatePtr(ptr);
             mActors.insert(std::make_pair(ptr, actor));
+            mActorPtrs[actor->getIndex()] = ptr;
+            mActorGridDirty = true;
         }
     }
 
@@ -1506,6 +1721,7 @@ namespace MWMechanics
         {
             if((iter->first.isInCell() && iter->first.getCell()==cellStore) && iter->first != ignore)
             {
+                removeActorData(iter->second);
                 delete iter->second;
                 mActors.erase(iter++);
             }
@@ -1523,14 +1739,18 @@ namespace MWMechanics
 
         if (aiActive)
         {
-            for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
             {
-                if (iter->first == player) continue;
+                if (!mActorObjects[i])
+                    continue;
 
-                bool inProcessingRange = (playerPos - iter->first.getRefData().getPosition().asVec3()).length2() <= mActorsProcessingRange*mActorsProcessingRange;
+                const MWWorld::Ptr& ptr = mActorPtrs[i];
+                if (ptr == player) continue;
+
+                bool inProcessingRange = (playerPos - ptr.getRefData().getPosition().asVec3()).length2() <= mActorsProcessingRange*mActorsProcessingRange;
                 if (inProcessingRange)
                 {
-                    MWMechanics::CreatureStats& stats = iter->first.getClass().getCreatureStats(iter->first);
+                    MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats(ptr);
                     if (!stats.isDead() && stats.getAiSequence().isInCombat())
                     {
                         hasHostiles = true;
@@ -1579,11 +1799,14 @@ namespace MWMechanics
             bool showTorches = world->useTorches();
 
             MWWorld::Ptr player = getPlayer();
-            const osg::Vec3f playerPos = player.getRefData().getPosition().asVec3();
+
+            updateActorData();
+            ++mAiLodFrame;
 
             /// \todo move update logic to Actor class where appropriate
 
             std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> > cachedAllies; // will be filled as engageCombat iterates
+            std::vector<MWWorld::Ptr> neighbors; // reused for each actor
 
             bool aiActive = MWBase::Environment::get().getMechanicsManager()->isAIActive();
             int attackedByPlayerId = player.getClass().getCreatureStats(player).getHitAttemptActorId();
@@ -1596,36 +1819,39 @@ namespace MWMechanics
             }
 
              // AI and magic effects update
-            for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
             {
-                bool isPlayer = iter->first == player;
-                CharacterController* ctrl = iter->second->getCharacterController();
+                if (!mActorObjects[i])
+                    continue;
+
+                // Copy the handle since the arrays may be reallocated when actors are added during the update
+                const MWWorld::Ptr ptr = mActorPtrs[i];
+                bool isPlayer = (mActorFlags[i] & Flag_Player) != 0;
+                CharacterController* ctrl = mActorControllers[i];
 
-                float distSqr = (playerPos - iter->first.getRefData().getPosition().asVec3()).length2();
                 // AI processing is only done within given distance to the player.
-                bool inProcessingRange = distSqr <= mActorsProcessingRange*mActorsProcessingRange;
+                bool inProcessingRange = (mActorFlags[i] & Flag_InProcessingRange) != 0;
 
                 if (isPlayer)
                     ctrl->setAttackingOrSpell(world->getPlayer().getAttackingOrSpell());
 
                 // If dead or no longer in combat, no longer store any actors who attempted to hit us. Also remove for the player.
-                if (iter->first != player && (iter->first.getClass().getCreatureStats(iter->first).isDead()
-                    || !iter->first.getClass().getCreatureStats(iter->first).getAiSequence().isInCombat()
+                if (ptr != player && (ptr.getClass().getCreatureStats(ptr).isDead()
+                    || !ptr.getClass().getCreatureStats(ptr).getAiSequence().isInCombat()
                     || !inProcessingRange))
                 {
-                    iter->first.getClass().getCreatureStats(iter->first).setHitAttemptActorId(-1);
-                    if (player.getClass().getCreatureStats(player).getHitAttemptActorId() == iter->first.getClass().getCreatureStats(iter->first).getActorId())
+                    ptr.getClass().getCreatureStats(ptr).setHitAttemptActorId(-1);
+                    if (player.getClass().getCreatureStats(player).getHitAttemptActorId() == ptr.getClass().getCreatureStats(ptr).getActorId())
                         player.getClass().getCreatureStats(player).setHitAttemptActorId(-1);
                 }
 
                 // For dead actors we need to remove looping spell particles
-                if (iter->first.getClass().getCreatureStats(iter->first).isDead())
+                if (ptr.getClass().getCreatureStats(ptr).isDead())
                     ctrl->updateContinuousVfx();
                 else
                 {
                     bool cellChanged = world->hasCellChanged();
-                    MWWorld::Ptr actor = iter->first; // make a copy of the map key to avoid it being invalidated when the player teleports
-                    updateActor(actor, duration);
+                    updateActor(ptr, duration);
 
                     // Looping magic VFX update
                     // Note: we need to do this before any of the animations are updated.
@@ -1639,18 +1865,42 @@ namespace MWMechanics
                         return; // for now abort update of the old cell when cell changes by teleportation magic effect
                                 // a better solution might be to apply cell changes at the end of the frame
                     }
+                    // Distant actors run their AI less often and catch up on the skipped time when they do
+                    float aiDuration = 0.f;
+                    bool updateAi = false;
                     if (aiActive && inProcessingRange)
                     {
-                        if (timerUpdateAITargets == 0)
+                        mActorAiDuration[i] += duration;
+                        if (shouldUpdateAi(i))
                         {
-                            if (!isPlayer)
-                                adjustCommandedActor(iter->first);
+                            aiDuration = mActorAiDuration[i];
+                            mActorAiDuration[i] = 0.f;
+                            updateAi = true;
+                        }
+                    }
+                    else
+                    {
+                        mActorAiDuration[i] = 0.f;
+                        mActorAiMovement[i] = AiMovement();
+                    }
 
-                            for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
+                    if (aiActive && inProcessingRange)
+                    {
+                        if (timerUpdateAITargets == 0)
+                        {
+                            if (!isPlayer) // player is not AI-controlled
                             {
-                                if (it->first == iter->first || isPlayer) // player is not AI-controlled
-                                    continue;
-                                engageCombat(iter->first, it->first, cachedAllies, it->first == player);
+                                adjustCommandedActor(ptr);
+
+                                // engageCombat ignores actors out of the processing range anyway
+                                neighbors.clear();
+                                getObjectsInRange(ptr.getRefData().getPosition().asVec3(), mActorsProcessingRange, neighbors);
+                                for (const MWWorld::Ptr& neighbor : neighbors)
+                                {
+                                    if (neighbor == ptr)
+                                        continue;
+                                    engageCombat(ptr, neighbor, cachedAllies, neighbor == player);
+                                }
                             }
                         }
                         if (timerUpdateHeadTrack == 0)
@@ -1658,7 +1908,7 @@ namespace MWMechanics
                             float sqrHeadTrackDistance = std::numeric_limits<float>::max();
                             MWWorld::Ptr headTrackTarget;
 
-                            MWMechanics::CreatureStats& stats = iter->first.getClass().getCreatureStats(iter->first);
+                            MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats(ptr);
                             bool firstPersonPlayer = isPlayer && world->isFirstPerson();
 
                             // 1. Unconsious actor can not track target
@@ -1669,43 +1919,44 @@ namespace MWMechanics
                                 !stats.getAiSequence().hasPackage(AiPackage::TypeIdPursue) &&
                                 !firstPersonPlayer)
                             {
-                                for(PtrActorMap::iterator it(mActors.begin()); it != mActors.end(); ++it)
-                                {
-                                    if (it->first == iter->first)
-                                        continue;
-                                    updateHeadTracking(iter->first, it->first, headTrackTarget, sqrHeadTrackDistance);
-                                }
+                                updateHeadTracking(ptr, headTrackTarget, sqrHeadTrackDistance);
                             }
 
                             ctrl->setHeadTrackTarget(headTrackTarget);
                         }
 
-                        if (iter->first.getClass().isNpc() && iter->first != player)
-                            updateCrimePursuit(iter->first, duration);
+                        if (updateAi && ptr.getClass().isNpc() && ptr != player)
+                            updateCrimePursuit(ptr, aiDuration);
 
-                        if (iter->first != player)
+                        if (ptr != player)
                         {
-                            CreatureStats &stats = iter->first.getClass().getCreatureStats(iter->first);
-                            if (isConscious(iter->first))
+                            CreatureStats &stats = ptr.getClass().getCreatureStats(ptr);
+                            if (isConscious(ptr))
                             {
-                                stats.getAiSequence().execute(iter->first, *ctrl, duration);
-                                updateGreetingState(iter->first, timerUpdateHello > 0);
-                                playIdleDialogue(iter->first);
-                                updateMovementSpeed(iter->first);
+                                if (updateAi)
+                                {
+                                    stats.getAiSequence().execute(ptr, *ctrl, aiDuration);
+                                    updateGreetingState(ptr, timerUpdateHello > 0);
+                                    storeAiMovement(i, aiDuration, duration);
+                                }
+                                else
+                                    replayAiMovement(i, duration);
+                                playIdleDialogue(ptr);
+                                updateMovementSpeed(ptr);
                             }
                         }
                     }
 
-                    if(iter->first.getClass().isNpc())
+                    if(ptr.getClass().isNpc())
                     {
                         // We can not update drowning state for actors outside of AI distance - they can not resurface to breathe
                         if (inProcessingRange)
-                            updateDrowning(iter->first, duration, ctrl->isKnockedOut(), isPlayer);
+                            updateDrowning(ptr, duration, ctrl->isKnockedOut(), isPlayer);
 
-                        calculateNpcStatModifiers(iter->first, duration);
+                        calculateNpcStatModifiers(ptr, duration);
 
                         if (timerUpdateEquippedLight == 0)
-                            updateEquippedLight(iter->first, updateEquippedLightInterval, showTorches);
+                            updateEquippedLight(ptr, updateEquippedLightInterval, showTorches);
                     }
                 }
             }
@@ -1716,46 +1967,53 @@ namespace MWMechanics
             timerUpdateHello += duration;
             mTimerDisposeSummonsCorpses += duration;
 
+            // Actors may have been moved or teleported by the updates above
+            updateActorData();
+
             // Animation/movement update
             CharacterController* playerCharacter = nullptr;
-            for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
             {
-                const float dist = (playerPos - iter->first.getRefData().getPosition().asVec3()).length();
-                bool isPlayer = iter->first == player;
-                bool inRange = isPlayer || dist <= mActorsProcessingRange;
+                if (!mActorObjects[i])
+                    continue;
+
+                const MWWorld::Ptr ptr = mActorPtrs[i];
+                bool isPlayer = (mActorFlags[i] & Flag_Player) != 0;
+                bool inRange = isPlayer || (mActorFlags[i] & Flag_InProcessingRange) != 0;
                 int activeFlag = 1; // Can be changed back to '2' to keep updating bounding boxes off screen (more accurate, but slower)
                 if (isPlayer)
                     activeFlag = 2;
                 int active = inRange ? activeFlag : 0;
 
-                CharacterController* ctrl = iter->second->getCharacterController();
+                CharacterController* ctrl = mActorControllers[i];
                 ctrl->setActive(active);
+                ctrl->setAnimationUpdateInterval(getAnimationUpdateInterval(i), static_cast<unsigned int>(i));
 
                 if (!inRange)
                 {
-                    iter->first.getRefData().getBaseNode()->setNodeMask(0);
-                    world->setActorCollisionMode(iter->first, false, false);
+                    ptr.getRefData().getBaseNode()->setNodeMask(0);
+                    world->setActorCollisionMode(ptr, false, false);
                     continue;
                 }
                 else if (!isPlayer)
-                    iter->first.getRefData().getBaseNode()->setNodeMask(MWRender::Mask_Actor);
+                    ptr.getRefData().getBaseNode()->setNodeMask(MWRender::Mask_Actor);
 
-                const bool isDead = iter->first.getClass().getCreatureStats(iter->first).isDead();
-                if (!isDead && iter->first.getClass().getCreatureStats(iter->first).isParalyzed())
+                const bool isDead = ptr.getClass().getCreatureStats(ptr).isDead();
+                if (!isDead && ptr.getClass().getCreatureStats(ptr).isParalyzed())
                     ctrl->skipAnim();
 
                 // Handle player last, in case a cell transition occurs by casting a teleportation spell
                 // (would invalidate the iterator)
-                if (iter->first == getPlayer())
+                if (isPlayer)
                 {
                     playerCharacter = ctrl;
                     continue;
                 }
 
-                world->setActorCollisionMode(iter->first, true, !iter->first.getClass().getCreatureStats(iter->first).isDeathAnimationFinished());
+                world->setActorCollisionMode(ptr, true, !ptr.getClass().getCreatureStats(ptr).isDeathAnimationFinished());
                 ctrl->update(duration);
 
-                updateVisibility(iter->first, ctrl);
+                updateVisibility(ptr, ctrl);
             }
 
             if (playerCharacter)
@@ -1764,10 +2022,13 @@ namespace MWMechanics
                 playerCharacter->setVisibility(1.f);
             }
 
-            for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+            for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
             {
-                const MWWorld::Class &cls = iter->first.getClass();
-                CreatureStats &stats = cls.getCreatureStats(iter->first);
+                if (!mActorObjects[i])
+                    continue;
+
+                const MWWorld::Ptr& ptr = mActorPtrs[i];
+                CreatureStats &stats = ptr.getClass().getCreatureStats(ptr);
 
                 //KnockedOutOneFrameLogic
                 //Used for "OnKnockedOut" command
@@ -1813,38 +2074,42 @@ namespace MWMechanics
 
     void Actors::killDeadActors()
     {
-        for(PtrActorMap::iterator iter(mActors.begin()); iter != mActors.end(); ++iter)
+        for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
         {
-            const MWWorld::Class &cls = iter->first.getClass();
-            CreatureStats &stats = cls.getCreatureStats(iter->first);
+            if (!mActorObjects[i])
+                continue;
+
+            const MWWorld::Ptr ptr = mActorPtrs[i];
+            const MWWorld::Class &cls = ptr.getClass();
+            CreatureStats &stats = cls.getCreatureStats(ptr);
 
             if(!stats.isDead())
                 continue;
 
-            MWBase::Environment::get().getWorld()->removeActorPath(iter->first);
-            CharacterController::KillResult killResult = iter->second->getCharacterController()->kill();
+            MWBase::Environment::get().getWorld()->removeActorPath(ptr);
+            CharacterController::KillResult killResult = mActorControllers[i]->kill();
             if (killResult == CharacterController::Result_DeathAnimStarted)
             {
                 // Play dying words
                 // Note: It's not known whether the soundgen tags scream, roar, and moan are reliable
                 // for NPCs since some of the npc death animation files are missing them.
-                MWBase::Environment::get().getDialogueManager()->say(iter->first, "hit");
+                MWBase::Environment::get().getDialogueManager()->say(ptr, "hit");
 
                 // Apply soultrap
-                if (iter->first.getTypeName() == typeid(ESM::Creature).name())
+                if (ptr.getTypeName() == typeid(ESM::Creature).name())
                 {
-                    SoulTrap soulTrap (iter->first);
+                    SoulTrap soulTrap (ptr);
                     stats.getActiveSpells().visitEffectSources(soulTrap);
                 }
 
-                calculateCreatureStatModifiers(iter->first, 0);
+                calculateCreatureStatModifiers(ptr, 0);
 
-                if (cls.isEssential(iter->first))
+                if (cls.isEssential(ptr))
                     MWBase::Environment::get().getWindowManager()->messageBox("#{sKilledEssential}");
             }
             else if (killResult == CharacterController::Result_DeathAnimJustFinished)
             {
-                notifyDied(iter->first);
+                notifyDied(ptr);
 
                 // Reset magic effects and recalculate derived effects
                 // One case where we need this is to make sure bound items are removed upon death
@@ -1854,9 +2119,9 @@ namespace MWMechanics
                 // Make sure spell effects are removed
                 purgeSpellEffects(stats.getActorId());
 
-                calculateCreatureStatModifiers(iter->first, 0);
+                calculateCreatureStatModifiers(ptr, 0);
 
-                if( iter->first == getPlayer())
+                if( ptr == getPlayer())
                 {
                     //player's death animation is over
                     MWBase::Environment::get().getStateManager()->askLoadRecent();
@@ -1864,11 +2129,11 @@ namespace MWMechanics
                 else
                 {
                     // NPC death animation is over, disable actor collision
-                    MWBase::Environment::get().getWorld()->enableActorCollision(iter->first, false);
+                    MWBase::Environment::get().getWorld()->enableActorCollision(ptr, false);
                 }
 
                 // Play Death Music if it was the player dying
-                if(iter->first == getPlayer())
+                if(ptr == getPlayer())
                     MWBase::Environment::get().getSoundManager()->streamMusic("Special/MW_Death.mp3");
             }
         }
@@ -2094,20 +2359,96 @@ namespace MWMechanics
             iter->second->getCharacterController()->persistAnimationState();
     }
 
+    void Actors::updateActorGrid()
+    {
+        if (!mActorGridDirty)
+            return;
+
+        for (ActorGrid::iterator it = mActorGrid.begin(); it != mActorGrid.end(); ++it)
+            it->second.clear();
+
+        for (std::size_t i = 0; i < mActorPtrs.size(); ++i)
+        {
+            if (!mActorObjects[i])
+                continue;
+
+            const osg::Vec3f pos = mActorPtrs[i].getRefData().getPosition().asVec3();
+            ActorGridIndex index(static_cast<int>(std::floor(pos.x() / ACTOR_GRID_CELL_SIZE)),
+                                 static_cast<int>(std::floor(pos.y() / ACTOR_GRID_CELL_SIZE)));
+            mActorGrid[index].push_back(i);
+        }
+
+        // Keep the cells that are still used to avoid reallocating them every frame
+        for (ActorGrid::iterator it = mActorGrid.begin(); it != mActorGrid.end();)
+        {
+            if (it->second.empty())
+                mActorGrid.erase(it++);
+            else
+                ++it;
+        }
+
+        mActorGridDirty = false;
+    }
+
+    void Actors::getActorGridCandidates(const osg::Vec3f& position, float radius, std::vector<std::size_t>& out)
+    {
+        updateActorGrid();
+
+        const float searchRadius = radius + ACTOR_GRID_MARGIN;
+        const int minX = static_cast<int>(std::floor((position.x() - searchRadius) / ACTOR_GRID_CELL_SIZE));
+        const int maxX = static_cast<int>(std::floor((position.x() + searchRadius) / ACTOR_GRID_CELL_SIZE));
+        const int minY = static_cast<int>(std::floor((position.y() - searchRadius) / ACTOR_GRID_CELL_SIZE));
+        const int maxY = static_cast<int>(std::floor((position.y() + searchRadius) / ACTOR_GRID_CELL_SIZE));
+
+        // For large radii, walking the occupied cells is cheaper than looking up every cell in range
+        if (static_cast<size_t>(maxX - minX + 1) * static_cast<size_t>(maxY - minY + 1) > mActorGrid.size())
+        {
+            for (ActorGrid::const_iterator it = mActorGrid.begin(); it != mActorGrid.end(); ++it)
+            {
+                if (it->first.first >= minX && it->first.first <= maxX && it->first.second >= minY && it->first.second <= maxY)
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+            return;
+        }
+
+        for (int x = minX; x <= maxX; ++x)
+        {
+            for (int y = minY; y <= maxY; ++y)
+            {
+                ActorGrid::const_iterator it = mActorGrid.find(ActorGridIndex(x, y));
+                if (it != mActorGrid.end())
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+
     void Actors::getObjectsInRange(const osg::Vec3f& position, float radius, std::vector<MWWorld::Ptr>& out)
     {
-        for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+        std::vector<std::size_t>& candidates = mActorGridCandidates;
+        candidates.clear();
+        getActorGridCandidates(position, radius, candidates);
+
+        // Return the actors in the order of mActors, since callers may roll dice for each of them
+        std::sort(candidates.begin(), candidates.end(),
+            [this] (std::size_t lhs, std::size_t rhs) { return mActorPtrs[lhs] < mActorPtrs[rhs]; });
+
+        for (std::size_t candidate : candidates)
         {
-            if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
-                out.push_back(iter->first);
+            const MWWorld::Ptr& ptr = mActorPtrs[candidate];
+            if ((ptr.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+                out.push_back(ptr);
         }
     }
 
     bool Actors::isAnyObjectInRange(const osg::Vec3f& position, float radius)
     {
-        for (PtrActorMap::iterator iter = mActors.begin(); iter != mActors.end(); ++iter)
+        std::vector<std::size_t>& candidates = mActorGridCandidates;
+        candidates.clear();
+        getActorGridCandidates(position, radius, candidates);
+
+        for (std::size_t candidate : candidates)
         {
-            if ((iter->first.getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
+            if ((mActorPtrs[candidate].getRefData().getPosition().asVec3() - position).length2() <= radius*radius)
                 return true;
         }
 
@@ -2215,6 +2556,18 @@ namespace MWMechanics
         }
     }
 
+    const std::set<MWWorld::Ptr>& Actors::getActorsSidingWith(const MWWorld::Ptr &actor, std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >& cachedAllies)
+    {
+        std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >::const_iterator search = cachedAllies.find(actor);
+        if (search == cachedAllies.end())
+        {
+            std::set<MWWorld::Ptr> allies;
+            getActorsSidingWith(actor, allies, cachedAllies);
+            search = cachedAllies.find(actor);
+        }
+        return search->second;
+    }
+
     std::list<int> Actors::getActorsFollowingIndices(const MWWorld::Ptr &actor)
     {
         std::list<int> list;
@@ -2323,6 +2676,16 @@ namespace MWMechanics
             it->second = nullptr;
         }
         mActors.clear();
+        mActorPtrs.clear();
+        mActorObjects.clear();
+        mActorControllers.clear();
+        mActorSqrDistances.clear();
+        mActorFlags.clear();
+        mActorAiDuration.clear();
+        mActorAiMovement.clear();
+        mHasRemovedActorData = false;
+        mActorGrid.clear();
+        mActorGridDirty = true;
         mDeathCount.clear();
     }
 
@@ -7,17 +7,16 @@
 #include <list>
 #include <map>
 
+#include <osg/Vec3f>
+
+#include "../mwworld/ptr.hpp"
+
 namespace ESM
 {
     class ESMReader;
     class ESMWriter;
 }
 
-namespace osg
-{
-    class Vec3f;
-}
-
 namespace Loading
 {
     class Listener;
@@ -25,7 +24,6 @@ namespace Loading
 
 namespace MWWorld
 {
-    class Ptr;
     class CellStore;
 }
 
@@ -125,8 +123,8 @@ namespace MWMechanics
             void updateGreetingState(const MWWorld::Ptr& actor, bool turnOnly);
             void turnActorToFacePlayer(const MWWorld::Ptr& actor, const osg::Vec3f& dir);
 
-            void updateHeadTracking(const MWWorld::Ptr& actor, const MWWorld::Ptr& targetActor,
-                                            MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance);
+            /// Find the nearest actor \a actor can see and that is in front of it, if it is nearer than \a sqrHeadTrackDistance.
+            void updateHeadTracking(const MWWorld::Ptr& actor, MWWorld::Ptr& headTrackTarget, float& sqrHeadTrackDistance);
 
             void rest(double hours, bool sleep);
             ///< Update actors while the player is waiting or sleeping.
@@ -173,6 +171,8 @@ namespace MWMechanics
             void getActorsSidingWith(const MWWorld::Ptr &actor, std::set<MWWorld::Ptr>& out);
             /// Recursive version of getActorsSidingWith that takes, adds to and returns a cache of actors mapped to their allies
             void getActorsSidingWith(const MWWorld::Ptr &actor, std::set<MWWorld::Ptr>& out, std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >& cachedAllies);
+            /// Get the allies of \a actor from \a cachedAllies, adding them to the cache first if needed. Avoids copying the cached set.
+            const std::set<MWWorld::Ptr>& getActorsSidingWith(const MWWorld::Ptr &actor, std::map<const MWWorld::Ptr, const std::set<MWWorld::Ptr> >& cachedAllies);
 
             /// Get the list of AiFollow::mFollowIndex for all actors following this target
             std::list<int> getActorsFollowingIndices(const MWWorld::Ptr& actor);
@@ -195,9 +195,83 @@ namespace MWMechanics
             bool isAttackingOrSpell(const MWWorld::Ptr& ptr) const;
 
     private:
+        enum ActorFlags
+        {
+            Flag_Player = 1 << 0,
+            Flag_InProcessingRange = 1 << 1
+        };
+
         void updateVisibility (const MWWorld::Ptr& ptr, CharacterController* ctrl);
 
+        void addActorData(const MWWorld::Ptr& ptr, Actor* actor);
+        ///< Append an actor to the per-frame data arrays
+
+        void removeActorData(Actor* actor);
+        ///< Leave an empty slot for an actor in the per-frame data arrays, see compactActorData()
+
+        void compactActorData();
+        ///< Remove the empty slots from the per-frame data arrays, keeping the order of the actors.
+        /// @note Must not be called while looping over the arrays.
+
+        void updateActorData(std::size_t index, const MWWorld::Ptr& player, const osg::Vec3f& playerPos);
+        ///< Refresh the position, distance to the player and flags of an actor
+        void updateActorData();
+        ///< Refresh the per-frame data of all actors
+
+        bool shouldUpdateAi(std::size_t index) const;
+        ///< Check if the AI of an actor is due to be updated in this frame, depending on its distance to the player
+
+        void storeAiMovement(std::size_t index, float aiDuration, float duration);
+        ///< Remember the movement the AI of an actor asked for, to repeat it until its next AI update
+
+        void replayAiMovement(std::size_t index, float duration);
+        ///< Repeat the movement of the last AI update of an actor in a frame its AI is skipped
+
+        unsigned int getAnimationUpdateInterval(std::size_t index) const;
+        ///< Number of frames between two skeleton updates of an actor, depending on its distance to the player
+
+        /// Sort active actors into grid cells by position, if any were added or removed or moved since the last update.
+        void updateActorGrid();
+
+        /// Add indices of actors that may be within \a radius of \a position to \a out, without checking the exact distance.
+        void getActorGridCandidates(const osg::Vec3f& position, float radius, std::vector<std::size_t>& out);
+
+        struct AiMovement
+        {
+            float mPosition[2];
+            float mRotationRate[3]; // radians per second
+
+            AiMovement()
+            {
+                mPosition[0] = mPosition[1] = 0.f;
+                mRotationRate[0] = mRotationRate[1] = mRotationRate[2] = 0.f;
+            }
+        };
+
+        typedef std::pair<int, int> ActorGridIndex;
+        typedef std::map<ActorGridIndex, std::vector<std::size_t> > ActorGrid;
+
+        // mActors is used to look up actors. The per-frame loops walk the data below instead, which is kept
+        // as structure of arrays and indexed by Actor::getIndex(). Removed actors leave a slot with a null
+        // Actor until the next compactActorData(), loops skip those.
         PtrActorMap mActors;
+        std::vector<MWWorld::Ptr> mActorPtrs;
+        std::vector<Actor*> mActorObjects;
+        std::vector<CharacterController*> mActorControllers;
+        std::vector<float> mActorSqrDistances; // squared distance to the player
+        std::vector<unsigned char> mActorFlags;
+        std::vector<float> mActorAiDuration; // time passed since the last AI update
+        std::vector<AiMovement> mActorAiMovement; // movement of the last AI update
+        bool mHasRemovedActorData;
+
+        float mAiLodDistance;
+        unsigned int mAiLodMaxInterval;
+        unsigned int mAiLodFrame;
+        float mAnimationLodDistance;
+        unsigned int mAnimationLodMaxInterval;
+        ActorGrid mActorGrid;
+        bool mActorGridDirty;
+        std::vector<std::size_t> mActorGridCandidates; // reused by the range queries to avoid allocating each call
         float mTimerDisposeSummonsCorpses;
         float mActorsProcessingRange;
 
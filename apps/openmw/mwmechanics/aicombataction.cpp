@@ -20,6 +20,13 @@
 #include "spellpriority.hpp"
 #include "weapontype.hpp"
 
+namespace
+{
+    // Only these items are rated, skipping the others saves rating calls for every item of large inventories
+    const int sMagicItemTypes = MWWorld::ContainerStore::Type_Armor | MWWorld::ContainerStore::Type_Book
+        | MWWorld::ContainerStore::Type_Clothing | MWWorld::ContainerStore::Type_Weapon;
+}
+
 namespace MWMechanics
 {
     float suggestCombatRange(int rangeTypes)
@@ -160,7 +167,7 @@ namespace MWMechanics
         {
             MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (MWWorld::ContainerStoreIterator it = store.begin(MWWorld::ContainerStore::Type_Potion); it != store.end(); ++it)
             {
                 float rating = ratePotion(*it, actor);
                 if (rating > bestActionRating)
@@ -171,7 +178,7 @@ namespace MWMechanics
                 }
             }
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (MWWorld::ContainerStoreIterator it = store.begin(sMagicItemTypes); it != store.end(); ++it)
             {
                 float rating = rateMagicItem(*it, actor, enemy);
                 if (rating > bestActionRating)
@@ -188,7 +195,7 @@ namespace MWMechanics
             MWWorld::Ptr bestBolt;
             float bestBoltRating = rateAmmo(actor, enemy, bestBolt, ESM::Weapon::Bolt);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (MWWorld::ContainerStoreIterator it = store.begin(MWWorld::ContainerStore::Type_Weapon); it != store.end(); ++it)
             {
                 float rating = rateWeapon(*it, actor, enemy, -1, bestArrowRating, bestBoltRating);
                 if (rating > bestActionRating)
@@ -244,7 +251,7 @@ namespace MWMechanics
         {
             MWWorld::InventoryStore& store = actor.getClass().getInventoryStore(actor);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (MWWorld::ContainerStoreIterator it = store.begin(sMagicItemTypes); it != store.end(); ++it)
             {
                 float rating = rateMagicItem(*it, actor, enemy);
                 if (rating > bestActionRating)
@@ -257,7 +264,7 @@ namespace MWMechanics
 
             float bestBoltRating = rateAmmo(actor, enemy, ESM::Weapon::Bolt);
 
-            for (MWWorld::ContainerStoreIterator it = store.begin(); it != store.end(); ++it)
+            for (MWWorld::ContainerStoreIterator it = store.begin(MWWorld::ContainerStore::Type_Weapon); it != store.end(); ++it)
             {
                 float rating = rateWeapon(*it, actor, enemy, -1, bestArrowRating, bestBoltRating);
                 if (rating > bestActionRating)
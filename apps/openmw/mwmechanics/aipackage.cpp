@@ -33,7 +33,9 @@ MWMechanics::AiPackage::AiPackage() :
     mRotateOnTheRunChecks(0),
     mIsShortcutting(false),
     mShortcutProhibited(false),
-    mShortcutFailPos()
+    mShortcutFailPos(),
+    mLineOfSightClear(false),
+    mLineOfSightReuses(-1)
 {
 }
 
@@ -92,6 +94,7 @@ void MWMechanics::AiPackage::reset()
     mIsShortcutting = false;
     mShortcutProhibited = false;
     mShortcutFailPos = osg::Vec3f();
+    mLineOfSightReuses = -1;
 
     mPathFinder.clearPath();
     mObstacleCheck.clear();
@@ -120,6 +123,15 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const osg::Vec3f&
     const float distToTarget = distance(position, dest);
     const bool isDestReached = (distToTarget <= destTolerance);
 
+    // Switch to the path searched in background as soon as it is found
+    if (mPathFinder.isAsyncPathPending() && mPathFinder.updateAsyncPath(actor, getPathGridGraph(actor.getCell())))
+    {
+        mRotateOnTheRunChecks = 3;
+
+        if (!mPathFinder.getPath().empty() && distance(dest, mPathFinder.getPath().back()) > 100)
+            mPathFinder.addPointToPath(dest);
+    }
+
     if (!isDestReached && mTimer > AI_REACTION_TIME)
     {
         if (actor.getClass().isBipedal(actor))
@@ -138,7 +150,7 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const osg::Vec3f&
             if (wasShortcutting || doesPathNeedRecalc(dest, actor)) // if need to rebuild path
             {
                 const auto pathfindingHalfExtents = world->getPathfindingHalfExtents(actor);
-                mPathFinder.buildPath(actor, position, dest, actor.getCell(), getPathGridGraph(actor.getCell()),
+                mPathFinder.buildPathAsync(actor, position, dest, actor.getCell(), getPathGridGraph(actor.getCell()),
                     pathfindingHalfExtents, getNavigatorFlags(actor));
                 mRotateOnTheRunChecks = 3;
 
@@ -184,6 +196,13 @@ bool MWMechanics::AiPackage::pathTo(const MWWorld::Ptr& actor, const osg::Vec3f&
         return true;
     }
 
+    // Wait for the first path to be found
+    if (mPathFinder.getPath().empty())
+    {
+        actor.getClass().getMovementSettings(actor).mPosition[1] = 0;
+        return false;
+    }
+
     world->updateActorPath(actor, mPathFinder.getPath(), halfExtents, position, dest);
 
     if (mRotateOnTheRunChecks == 0
@@ -296,9 +315,7 @@ bool MWMechanics::AiPackage::shortcutPath(const osg::Vec3f& startPoint, const os
     if (!mShortcutProhibited || (mShortcutFailPos - startPoint).length() >= PATHFIND_SHORTCUT_RETRY_DIST)
     {
         // check if target is clearly visible
-        isPathClear = !MWBase::Environment::get().getWorld()->castRay(
-            startPoint.x(), startPoint.y(), startPoint.z(),
-            endPoint.x(), endPoint.y(), endPoint.z());
+        isPathClear = isLineOfSightClear(startPoint, endPoint);
 
         if (destInLOS != nullptr) *destInLOS = isPathClear;
 
@@ -319,6 +336,30 @@ bool MWMechanics::AiPackage::shortcutPath(const osg::Vec3f& startPoint, const os
     return false;
 }
 
+bool MWMechanics::AiPackage::isLineOfSightClear(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint)
+{
+    // With checks every AI_REACTION_TIME, a result is used for one second at most, so opened doors and moved objects
+    // are noticed soon enough
+    static const int maxReuses = 3;
+    static const float maxOffset = 16.f;
+
+    if (mLineOfSightReuses >= 0 && mLineOfSightReuses < maxReuses
+            && (startPoint - mLineOfSightStart).length2() <= maxOffset * maxOffset
+            && (endPoint - mLineOfSightEnd).length2() <= maxOffset * maxOffset)
+    {
+        ++mLineOfSightReuses;
+        return mLineOfSightClear;
+    }
+
+    mLineOfSightStart = startPoint;
+    mLineOfSightEnd = endPoint;
+    mLineOfSightReuses = 0;
+    mLineOfSightClear = !MWBase::Environment::get().getWorld()->castRay(
+        startPoint.x(), startPoint.y(), startPoint.z(),
+        endPoint.x(), endPoint.y(), endPoint.z());
+    return mLineOfSightClear;
+}
+
 bool MWMechanics::AiPackage::checkWayIsClearForActor(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint, const MWWorld::Ptr& actor)
 {
     if (canActorMoveByZAxis(actor))
@@ -122,6 +122,10 @@ namespace MWMechanics
             bool shortcutPath(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint, const MWWorld::Ptr& actor,
                               bool *destInLOS, bool isPathClear);
 
+            /// Check if nothing blocks the line from the start point to the end point. The result of the last check is
+            /// reused a few times while neither point moved noticeably, e.g. for an actor stuck behind a wall.
+            bool isLineOfSightClear(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint);
+
             /// Check if the way to the destination is clear, taking into account actor speed
             bool checkWayIsClearForActor(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint, const MWWorld::Ptr& actor);
 
@@ -150,6 +154,12 @@ namespace MWMechanics
             bool mShortcutProhibited; // shortcutting may be prohibited after unsuccessful attempt
             osg::Vec3f mShortcutFailPos; // position of last shortcut fail
 
+            // last line of sight check of isLineOfSightClear
+            osg::Vec3f mLineOfSightStart;
+            osg::Vec3f mLineOfSightEnd;
+            bool mLineOfSightClear;
+            int mLineOfSightReuses; // negative if there is no result to reuse
+
         private:
             bool isNearInactiveCell(osg::Vec3f position);
     };
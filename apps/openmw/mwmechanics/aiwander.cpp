@@ -766,12 +766,14 @@ namespace MWMechanics
             // mAllowedNodes for this actor with pathgrid point indexes based on mDistance
             // and if the point is connected to the closest current point
             // NOTE: mPoints and mAllowedNodes are in local coordinates
+            const PathgridGraph& pathgridGraph = getPathGridGraph(cellStore);
+            std::vector<int> pointsInRange;
+            pathgridGraph.getPointsInRange(npcPos, static_cast<float>(mDistance), pointsInRange);
+
             int pointIndex = 0;
-            for(unsigned int counter = 0; counter < pathgrid->mPoints.size(); counter++)
+            for (int counter : pointsInRange)
             {
-                osg::Vec3f nodePos(PathFinder::makeOsgVec3(pathgrid->mPoints[counter]));
-                if((npcPos - nodePos).length2() <= mDistance * mDistance &&
-                   getPathGridGraph(cellStore).isPointConnected(closestPointIndex, counter))
+                if (pathgridGraph.isPointConnected(closestPointIndex, counter))
                 {
                     storage.mAllowedNodes.push_back(pathgrid->mPoints[counter]);
                     pointIndex = counter;
@@ -1619,7 +1619,8 @@ bool CharacterController::updateWeaponState(CharacterState& idle)
                 {
                     if(mPtr == getPlayer())
                     {
-                        if (Settings::Manager::getBool("best attack", "Game"))
+                        static const Settings::SettingValue<bool> bestAttack("best attack", "Game");
+                        if (bestAttack.get())
                         {
                             if (isWeapon)
                             {
@@ -2375,9 +2376,7 @@ void CharacterController::update(float duration, bool animationOnly)
 
 void CharacterController::persistAnimationState()
 {
-    ESM::AnimationState& state = mPtr.getRefData().getAnimationState();
-
-    state.mScriptedAnims.clear();
+    ESM::AnimationState::ScriptedAnimations scriptedAnims;
     for (AnimationQueue::const_iterator iter = mAnimQueue.begin(); iter != mAnimQueue.end(); ++iter)
     {
         if (!iter->mPersist)
@@ -2399,13 +2398,19 @@ void CharacterController::persistAnimationState()
             anim.mTime = 0.f;
         }
 
-        state.mScriptedAnims.push_back(anim);
+        scriptedAnims.push_back(anim);
     }
+
+    // Most actors have no scripted animations, don't allocate the state for them
+    const MWWorld::RefData& refData = mPtr.getRefData();
+    if (!scriptedAnims.empty() || !refData.getAnimationState().empty())
+        mPtr.getRefData().getAnimationState().mScriptedAnims = std::move(scriptedAnims);
 }
 
 void CharacterController::unpersistAnimationState()
 {
-    const ESM::AnimationState& state = mPtr.getRefData().getAnimationState();
+    const MWWorld::RefData& refData = mPtr.getRefData();
+    const ESM::AnimationState& state = refData.getAnimationState();
 
     if (!state.mScriptedAnims.empty())
     {
@@ -2804,6 +2809,11 @@ void CharacterController::setActive(int active)
     mAnimation->setActive(active);
 }
 
+void CharacterController::setAnimationUpdateInterval(unsigned int interval, unsigned int phase)
+{
+    mAnimation->setUpdateInterval(interval, phase);
+}
+
 void CharacterController::setHeadTrackTarget(const MWWorld::ConstPtr &target)
 {
     mHeadTrackTarget = target;
@@ -156,7 +156,8 @@ namespace MWMechanics
         bool isMagical = flags & ESM::Weapon::Magical;
         bool isEnchanted = !weapon.getClass().getEnchantment(weapon).empty();
 
-        return !isSilver && !isMagical && (!isEnchanted || !Settings::Manager::getBool("enchanted weapons are magical", "Game"));
+        static const Settings::SettingValue<bool> enchantedWeaponsAreMagical("enchanted weapons are magical", "Game");
+        return !isSilver && !isMagical && (!isEnchanted || !enchantedWeaponsAreMagical.get());
     }
 
     void resistNormalWeapon(const MWWorld::Ptr &actor, const MWWorld::Ptr& attacker, const MWWorld::Ptr &weapon, float &damage)
@@ -225,7 +226,8 @@ namespace MWMechanics
             damage += attack[0] + ((attack[1] - attack[0]) * attackStrength);
 
             adjustWeaponDamage(damage, weapon, attacker);
-            if (weapon == projectile || Settings::Manager::getBool("only appropriate ammunition bypasses resistance", "Game") || isNormalWeapon(weapon))
+            static const Settings::SettingValue<bool> onlyAppropriateAmmunition("only appropriate ammunition bypasses resistance", "Game");
+            if (weapon == projectile || onlyAppropriateAmmunition.get() || isNormalWeapon(weapon))
                 resistNormalWeapon(victim, attacker, projectile, damage);
             applyWerewolfDamageMult(victim, projectile, damage);
 
@@ -414,7 +416,8 @@ namespace MWMechanics
         // 0 = Do not factor strength into hand-to-hand combat.
         // 1 = Factor into werewolf hand-to-hand combat.
         // 2 = Ignore werewolves.
-        int factorStrength = Settings::Manager::getInt("strength influences hand to hand", "Game");
+        static const Settings::SettingValue<int> strengthInfluencesHandToHand("strength influences hand to hand", "Game");
+        int factorStrength = strengthInfluencesHandToHand.get();
         if (factorStrength == 1 || (factorStrength == 2 && !isWerewolf)) {
             damage *= attacker.getClass().getCreatureStats(attacker).getAttribute(ESM::Attribute::Strength).getModified() / 40.0f;
         }
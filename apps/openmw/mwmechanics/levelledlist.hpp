@@ -1,12 +1,13 @@
 #ifndef OPENMW_MECHANICS_LEVELLEDLIST_H
 #define OPENMW_MECHANICS_LEVELLEDLIST_H
 
+#include <algorithm>
+
 #include <components/debug/debuglog.hpp>
 #include <components/misc/rng.hpp>
 
 #include "../mwworld/ptr.hpp"
 #include "../mwworld/esmstore.hpp"
-#include "../mwworld/manualref.hpp"
 #include "../mwworld/class.hpp"
 
 #include "../mwbase/world.hpp"
@@ -29,7 +30,6 @@ namespace MWMechanics
         if (Misc::Rng::roll0to99() < levItem->mChanceNone)
             return std::string();
 
-        std::vector<std::string> candidates;
         int highestLevel = 0;
         for (std::vector<ESM::LevelledListBase::LevelItem>::const_iterator it = items.begin(); it != items.end(); ++it)
         {
@@ -42,42 +42,40 @@ namespace MWMechanics
         if (creature)
             allLevels = levItem->mFlags & ESM::CreatureLevList::AllLevels;
 
-        std::pair<int, std::string> highest = std::make_pair(-1, "");
-        for (std::vector<ESM::LevelledListBase::LevelItem>::const_iterator it = items.begin(); it != items.end(); ++it)
+        const auto isCandidate = [&] (const ESM::LevelledListBase::LevelItem& levelItem)
         {
-            if (playerLevel >= it->mLevel
-                    && (allLevels || it->mLevel == highestLevel))
-            {
-                candidates.push_back(it->mId);
-                if (it->mLevel >= highest.first)
-                    highest = std::make_pair(it->mLevel, it->mId);
-            }
-        }
-        if (candidates.empty())
+            return playerLevel >= levelItem.mLevel && (allLevels || levelItem.mLevel == highestLevel);
+        };
+
+        // Counted first and picked by index, so no candidate list has to be built
+        const std::size_t numCandidates = std::count_if(items.begin(), items.end(), isCandidate);
+        if (numCandidates == 0)
             return std::string();
-        std::string item = candidates[Misc::Rng::rollDice(candidates.size())];
+        std::size_t index = Misc::Rng::rollDice(numCandidates);
+        std::vector<ESM::LevelledListBase::LevelItem>::const_iterator candidate = items.begin();
+        for (;; ++candidate)
+        {
+            if (isCandidate(*candidate) && index-- == 0)
+                break;
+        }
+        const std::string& item = candidate->mId;
+
+        const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
 
         // Vanilla doesn't fail on nonexistent items in levelled lists
-        if (!MWBase::Environment::get().getWorld()->getStore().find(Misc::StringUtils::lowerCase(item)))
+        const int type = store.find(Misc::StringUtils::lowerCase(item));
+        if (!type)
         {
             Log(Debug::Warning) << "Warning: ignoring nonexistent item '" << item << "' in levelled list '" << levItem->mId << "'";
             return std::string();
         }
 
-        // Is this another levelled item or a real item?
-        MWWorld::ManualRef ref (MWBase::Environment::get().getWorld()->getStore(), item, 1);
-        if (ref.getPtr().getTypeName() != typeid(ESM::ItemLevList).name()
-                && ref.getPtr().getTypeName() != typeid(ESM::CreatureLevList).name())
-        {
-            return item;
-        }
-        else
-        {
-            if (ref.getPtr().getTypeName() == typeid(ESM::ItemLevList).name())
-                return getLevelledItem(ref.getPtr().get<ESM::ItemLevList>()->mBase, false);
-            else
-                return getLevelledItem(ref.getPtr().get<ESM::CreatureLevList>()->mBase, true);
-        }
+        // Is this another levelled item or a real item? The record type tells, no need to create an object.
+        if (type == ESM::REC_LEVI)
+            return getLevelledItem(store.get<ESM::ItemLevList>().find(item), false);
+        else if (type == ESM::REC_LEVC)
+            return getLevelledItem(store.get<ESM::CreatureLevList>().find(item), true);
+        return item;
     }
 
 }
@@ -1,5 +1,6 @@
 #include "magiceffects.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <components/esm/effectlist.hpp>
@@ -84,41 +85,77 @@ namespace MWMechanics
         return *this;
     }
 
+    bool operator== (const EffectKey& left, const EffectKey& right)
+    {
+        return left.mId == right.mId && left.mArg == right.mArg;
+    }
+
+    MagicEffects::Collection::iterator MagicEffects::find (const EffectKey& key)
+    {
+        Collection::iterator iter = std::lower_bound (mCollection.begin(), mCollection.end(), key,
+            [] (const Collection::value_type& effect, const EffectKey& key) { return effect.first < key; });
+        return iter != mCollection.end() && iter->first == key ? iter : mCollection.end();
+    }
+
+    MagicEffects::Collection::const_iterator MagicEffects::find (const EffectKey& key) const
+    {
+        Collection::const_iterator iter = std::lower_bound (mCollection.begin(), mCollection.end(), key,
+            [] (const Collection::value_type& effect, const EffectKey& key) { return effect.first < key; });
+        return iter != mCollection.end() && iter->first == key ? iter : mCollection.end();
+    }
+
+    EffectParam& MagicEffects::getOrAdd (const EffectKey& key)
+    {
+        Collection::iterator iter = std::lower_bound (mCollection.begin(), mCollection.end(), key,
+            [] (const Collection::value_type& effect, const EffectKey& key) { return effect.first < key; });
+        if (iter == mCollection.end() || !(iter->first == key))
+            iter = mCollection.insert (iter, std::make_pair (key, EffectParam()));
+        return iter->second;
+    }
+
     void MagicEffects::remove(const EffectKey &key)
     {
-        mCollection.erase(key);
+        Collection::iterator iter = find (key);
+        if (iter != mCollection.end())
+            mCollection.erase (iter);
     }
 
     void MagicEffects::add (const EffectKey& key, const EffectParam& param)
     {
-        Collection::iterator iter = mCollection.find (key);
-
-        if (iter==mCollection.end())
-        {
-            mCollection.insert (std::make_pair (key, param));
-        }
-        else
-        {
-            iter->second += param;
-        }
+        getOrAdd (key) += param;
     }
 
     void MagicEffects::modifyBase(const EffectKey &key, int diff)
     {
-        mCollection[key].modifyBase(diff);
+        getOrAdd (key).modifyBase(diff);
     }
 
     void MagicEffects::setModifiers(const MagicEffects &effects)
     {
-        for (Collection::iterator it = mCollection.begin(); it != mCollection.end(); ++it)
-        {
-            it->second.setModifier(effects.get(it->first).getModifier());
-        }
-
-        for (Collection::const_iterator it = effects.begin(); it != effects.end(); ++it)
+        // Merge both sorted collections, effects only present here lose their modifier
+        Collection result;
+        result.reserve (mCollection.size() + effects.mCollection.size());
+        Collection::const_iterator own = mCollection.begin();
+        Collection::const_iterator other = effects.mCollection.begin();
+        while (own != mCollection.end() || other != effects.mCollection.end())
         {
-            mCollection[it->first].setModifier(it->second.getModifier());
+            if (other == effects.mCollection.end() || (own != mCollection.end() && own->first < other->first))
+            {
+                result.push_back (*own++);
+                result.back().second.setModifier (0);
+            }
+            else if (own == mCollection.end() || other->first < own->first)
+            {
+                result.emplace_back (other->first, EffectParam());
+                result.back().second.setModifier ((other++)->second.getModifier());
+            }
+            else
+            {
+                result.push_back (*own++);
+                result.back().second.setModifier ((other++)->second.getModifier());
+            }
         }
+        mCollection.swap (result);
     }
 
     MagicEffects& MagicEffects::operator+= (const MagicEffects& effects)
@@ -130,22 +167,33 @@ namespace MWMechanics
             return *this;
         }
 
-        for (Collection::const_iterator iter (effects.begin()); iter!=effects.end(); ++iter)
-        {
-            Collection::iterator result = mCollection.find (iter->first);
+        if (effects.mCollection.empty())
+            return *this;
 
-            if (result!=mCollection.end())
-                result->second += iter->second;
+        Collection result;
+        result.reserve (mCollection.size() + effects.mCollection.size());
+        Collection::const_iterator own = mCollection.begin();
+        Collection::const_iterator other = effects.mCollection.begin();
+        while (own != mCollection.end() || other != effects.mCollection.end())
+        {
+            if (other == effects.mCollection.end() || (own != mCollection.end() && own->first < other->first))
+                result.push_back (*own++);
+            else if (own == mCollection.end() || other->first < own->first)
+                result.push_back (*other++);
             else
-                mCollection.insert (*iter);
+            {
+                result.push_back (*own++);
+                result.back().second += (other++)->second;
+            }
         }
+        mCollection.swap (result);
 
         return *this;
     }
 
     EffectParam MagicEffects::get (const EffectKey& key) const
     {
-        Collection::const_iterator iter = mCollection.find (key);
+        Collection::const_iterator iter = find (key);
 
         if (iter==mCollection.end())
         {
@@ -161,30 +209,28 @@ namespace MWMechanics
     {
         MagicEffects result;
 
-        // adding/changing
-        for (Collection::const_iterator iter (now.begin()); iter!=now.end(); ++iter)
+        // Both collections are sorted, so all changes are found in one pass
+        Collection::const_iterator before = prev.mCollection.begin();
+        Collection::const_iterator after = now.mCollection.begin();
+        while (before != prev.mCollection.end() || after != now.mCollection.end())
         {
-            Collection::const_iterator other = prev.mCollection.find (iter->first);
-
-            if (other==prev.end())
+            if (after == now.mCollection.end() || (before != prev.mCollection.end() && before->first < after->first))
+            {
+                // removing
+                result.mCollection.emplace_back (before->first, EffectParam() - before->second);
+                ++before;
+            }
+            else if (before == prev.mCollection.end() || after->first < before->first)
             {
                 // adding
-                result.add (iter->first, iter->second);
+                result.mCollection.push_back (*after++);
             }
             else
             {
                 // changing
-                result.add (iter->first, iter->second - other->second);
-            }
-        }
-
-        // removing
-        for (Collection::const_iterator iter (prev.begin()); iter!=prev.end(); ++iter)
-        {
-            Collection::const_iterator other = now.mCollection.find (iter->first);
-            if (other==now.end())
-            {
-                result.add (iter->first, EffectParam() - iter->second);
+                result.mCollection.emplace_back (after->first, after->second - before->second);
+                ++before;
+                ++after;
             }
         }
 
@@ -208,7 +254,7 @@ namespace MWMechanics
     {
         for (std::map<int, int>::const_iterator it = state.mEffects.begin(); it != state.mEffects.end(); ++it)
         {
-            mCollection[EffectKey(it->first)].setBase(it->second);
+            getOrAdd(EffectKey(it->first)).setBase(it->second);
         }
     }
 }
@@ -1,8 +1,9 @@
 #ifndef GAME_MWMECHANICS_MAGICEFFECTS_H
 #define GAME_MWMECHANICS_MAGICEFFECTS_H
 
-#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace ESM
 {
@@ -27,6 +28,7 @@ namespace MWMechanics
     };
 
     bool operator< (const EffectKey& left, const EffectKey& right);
+    bool operator== (const EffectKey& left, const EffectKey& right);
 
     struct EffectParam
     {
@@ -84,12 +86,20 @@ namespace MWMechanics
     {
         public:
 
-            typedef std::map<EffectKey, EffectParam> Collection;
+            /// Sorted by key. Usually holds only a few effects, which are looked up often and merged with each other
+            /// every frame, so a sorted vector is faster than a map and cheaper to copy.
+            /// @note Adding or removing effects invalidates iterators.
+            typedef std::vector<std::pair<EffectKey, EffectParam> > Collection;
 
         private:
 
             Collection mCollection;
 
+            Collection::iterator find (const EffectKey& key);
+            Collection::const_iterator find (const EffectKey& key) const;
+
+            EffectParam& getOrAdd (const EffectKey& key);
+
         public:
 
             Collection::const_iterator begin() const { return mCollection.begin(); }
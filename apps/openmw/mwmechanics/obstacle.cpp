@@ -48,6 +48,17 @@ namespace MWMechanics
             const MWWorld::LiveCellRef<ESM::Door>& ref = *it;
 
             osg::Vec3f doorPos(ref.mData.getPosition().asVec3());
+            doorPos.z() = 0;
+
+            // Door is not close enough. Checked first, since it rules out most doors of the cell for the price of a few
+            // multiplications
+            if ((pos - doorPos).length2() > minDist*minDist)
+                continue;
+
+            // Allow 60 degrees angle between actor and door, the cosine is compared to avoid computing the angle
+            const float cosAngle = actorDir * (doorPos - pos) / (actorDir.length() * (doorPos - pos).length());
+            if (cosAngle < 0.5f)
+                continue;
 
             // FIXME: cast
             const MWWorld::Ptr doorPtr = MWWorld::Ptr(&const_cast<MWWorld::LiveCellRef<ESM::Door> &>(ref), actor.getCell());
@@ -58,18 +69,6 @@ namespace MWMechanics
             if (doorState != MWWorld::DoorState::Idle || doorRot != 0)
                 continue; // the door is already opened/opening
 
-            doorPos.z() = 0;
-
-            float angle = std::acos(actorDir * (doorPos - pos) / (actorDir.length() * (doorPos - pos).length()));
-
-            // Allow 60 degrees angle between actor and door
-            if (angle < -osg::PI / 3 || angle > osg::PI / 3)
-                continue;
-
-            // Door is not close enough
-            if ((pos - doorPos).length2() > minDist*minDist)
-                continue;
-
             return doorPtr; // found, stop searching
         }
 
@@ -1,5 +1,6 @@
 #include "pathfinding.hpp"
 
+#include <chrono>
 #include <iterator>
 #include <limits>
 
@@ -335,6 +336,66 @@ namespace MWMechanics
         mConstructed = true;
     }
 
+    void PathFinder::buildPathAsync(const MWWorld::ConstPtr& actor, const osg::Vec3f& startPoint, const osg::Vec3f& endPoint,
+        const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph, const osg::Vec3f& halfExtents,
+        const DetourNavigator::Flags flags)
+    {
+        const auto navigator = MWBase::Environment::get().getWorld()->getNavigator();
+        if (navigator->getSettings().mAsyncPathFinderThreads == 0
+            || actor.getClass().isPureWaterCreature(actor) || actor.getClass().isPureFlyingCreature(actor))
+        {
+            mAsyncPath = std::shared_future<std::deque<osg::Vec3f>>();
+            buildPath(actor, startPoint, endPoint, cell, pathgridGraph, halfExtents, flags);
+            return;
+        }
+
+        if (isAsyncPathPending())
+            return;
+
+        mAsyncPath = navigator->findPathAsync(halfExtents, getPathStepSize(actor), startPoint, endPoint, flags);
+        mAsyncPathStart = startPoint;
+        mAsyncPathEnd = endPoint;
+        mAsyncPathCell = cell;
+    }
+
+    bool PathFinder::updateAsyncPath(const MWWorld::ConstPtr& actor, const PathgridGraph& pathgridGraph)
+    {
+        if (!isAsyncPathPending() || mAsyncPath.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        std::deque<osg::Vec3f> path;
+        try
+        {
+            path = mAsyncPath.get();
+        }
+        catch (const std::exception& exception)
+        {
+            Log(Debug::Debug) << "Build path by navigator exception: \"" << exception.what()
+                << "\" for \"" << actor.getClass().getName(actor) << "\" (" << actor.getBase()
+                << ") from " << mAsyncPathStart << " to " << mAsyncPathEnd;
+        }
+
+        mAsyncPath = std::shared_future<std::deque<osg::Vec3f>>();
+
+        // The path was searched for the cell the actor has left meanwhile. Reaching the end of the old path then
+        // does not complete it, so a new one is searched for.
+        if (mAsyncPathCell != actor.getCell())
+        {
+            if (mPath.empty())
+                mConstructed = false;
+            return false;
+        }
+
+        mPath = std::move(path);
+        mCell = mAsyncPathCell;
+
+        if (mPath.empty())
+            buildPathByPathgridImpl(mAsyncPathStart, mAsyncPathEnd, pathgridGraph, std::back_inserter(mPath));
+
+        mConstructed = true;
+        return true;
+    }
+
     void PathFinder::buildPathByNavigatorImpl(const MWWorld::ConstPtr& actor, const osg::Vec3f& startPoint,
         const osg::Vec3f& endPoint, const osg::Vec3f& halfExtents, const DetourNavigator::Flags flags,
         std::back_insert_iterator<std::deque<osg::Vec3f>> out)
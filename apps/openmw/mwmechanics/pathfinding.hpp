@@ -3,6 +3,7 @@
 
 #include <deque>
 #include <cassert>
+#include <future>
 #include <iterator>
 
 #include <components/detournavigator/flags.hpp>
@@ -74,6 +75,7 @@ namespace MWMechanics
             PathFinder()
                 : mConstructed(false)
                 , mCell(nullptr)
+                , mAsyncPathCell(nullptr)
             {
             }
 
@@ -82,6 +84,8 @@ namespace MWMechanics
                 mConstructed = false;
                 mPath.clear();
                 mCell = nullptr;
+                mAsyncPath = std::shared_future<std::deque<osg::Vec3f>>();
+                mAsyncPathCell = nullptr;
             }
 
             void buildStraightPath(const osg::Vec3f& endPoint);
@@ -99,12 +103,29 @@ namespace MWMechanics
             void buildPathByNavMeshToNextPoint(const MWWorld::ConstPtr& actor, const osg::Vec3f& halfExtents,
                 const DetourNavigator::Flags flags, const float pointTolerance);
 
+            /// Like buildPath, but the path over navmesh is searched in background if the navigator has threads
+            /// for it. The current path is kept until the new one is found, see updateAsyncPath.
+            /// \note Does nothing while the previous search is still running.
+            void buildPathAsync(const MWWorld::ConstPtr& actor, const osg::Vec3f& startPoint, const osg::Vec3f& endPoint,
+                const MWWorld::CellStore* cell, const PathgridGraph& pathgridGraph, const osg::Vec3f& halfExtents,
+                const DetourNavigator::Flags flags);
+
+            /// Replace the current path by the one searched since the last buildPathAsync call, if it is found.
+            /// \return true if the path was replaced
+            bool updateAsyncPath(const MWWorld::ConstPtr& actor, const PathgridGraph& pathgridGraph);
+
+            bool isAsyncPathPending() const
+            {
+                return mAsyncPath.valid();
+            }
+
             /// Remove front point if exist and within tolerance
             void update(const osg::Vec3f& position, const float pointTolerance, const float destinationTolerance);
 
+            /// A path is not completed while a new one is searched for, even if the actor reached the end of the old one
             bool checkPathCompleted() const
             {
-                return mConstructed && mPath.empty();
+                return mConstructed && mPath.empty() && !isAsyncPathPending();
             }
 
             /// In radians
@@ -198,6 +219,11 @@ namespace MWMechanics
 
             const MWWorld::CellStore* mCell;
 
+            std::shared_future<std::deque<osg::Vec3f>> mAsyncPath;
+            osg::Vec3f mAsyncPathStart;
+            osg::Vec3f mAsyncPathEnd;
+            const MWWorld::CellStore* mAsyncPathCell;
+
             void buildPathByPathgridImpl(const osg::Vec3f& startPoint, const osg::Vec3f& endPoint,
                 const PathgridGraph& pathgridGraph, std::back_insert_iterator<std::deque<osg::Vec3f>> out);
 
@@ -1,5 +1,11 @@
 #include "pathgrid.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
 #include "../mwbase/world.hpp"
 #include "../mwbase/environment.hpp"
 
@@ -45,6 +51,20 @@ namespace
         //return distance(a, b);
         return manhattan(a, b);
     }
+
+    // Pathgrids with up to this many points get a table of next points for all pairs of points
+    const int sMaxNextPointsTableSize = 256;
+
+    // Maximum number of searched paths remembered per pathgrid
+    const std::size_t sMaxCachedPaths = 1024;
+
+    // Size of the squares the points are sorted into for range queries, a quarter of an exterior cell
+    const float sPointBucketSize = 2048.f;
+
+    std::pair<int, int> getBucket(float x, float y)
+    {
+        return std::make_pair(static_cast<int>(std::floor(x / sPointBucketSize)), static_cast<int>(std::floor(y / sPointBucketSize)));
+    }
 }
 
 namespace MWMechanics
@@ -127,6 +147,8 @@ namespace MWMechanics
             //mGraph[mPathgrid->mEdges[i].mV1].edges.push_back(neighbour);
         }
         buildConnectedPoints();
+        buildNextPoints();
+        buildPointBuckets();
         mIsGraphConstructed = true;
         return true;
     }
@@ -215,11 +237,105 @@ namespace MWMechanics
         }
     }
 
+    /*
+     * For small pathgrids, run Dijkstra's algorithm from every point and
+     * remember the first point of each shortest path, so aStarSearch only
+     * needs to follow the table instead of searching.
+     */
+    void PathgridGraph::buildNextPoints()
+    {
+        const int size = static_cast<int>(mGraph.size());
+        if (size == 0 || size > sMaxNextPointsTableSize)
+            return;
+
+        mNextPoints.assign(size * size, -1);
+
+        typedef std::pair<float, int> QueueEntry; // cost, point index
+        std::vector<float> cost(size);
+        std::vector<short> firstPoint(size);
+        for (int start = 0; start < size; ++start)
+        {
+            std::fill(cost.begin(), cost.end(), std::numeric_limits<float>::max());
+            std::fill(firstPoint.begin(), firstPoint.end(), -1);
+            std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+            cost[start] = 0;
+            queue.push(QueueEntry(0, start));
+            while (!queue.empty())
+            {
+                const QueueEntry entry = queue.top();
+                queue.pop();
+                const int current = entry.second;
+                if (entry.first > cost[current])
+                    continue; // outdated entry
+
+                for (const ConnectedPoint& edge : mGraph[current].edges)
+                {
+                    const float newCost = cost[current] + edge.cost;
+                    if (newCost < cost[edge.index])
+                    {
+                        cost[edge.index] = newCost;
+                        firstPoint[edge.index] = current == start ? static_cast<short>(edge.index) : firstPoint[current];
+                        queue.push(QueueEntry(newCost, edge.index));
+                    }
+                }
+            }
+
+            std::copy(firstPoint.begin(), firstPoint.end(), mNextPoints.begin() + start * size);
+        }
+    }
+
     bool PathgridGraph::isPointConnected(const int start, const int end) const
     {
         return (mGraph[start].componentId == mGraph[end].componentId);
     }
 
+    void PathgridGraph::buildPointBuckets()
+    {
+        for (int i = 0; i < static_cast<int>(mPathgrid->mPoints.size()); ++i)
+        {
+            const ESM::Pathgrid::Point& point = mPathgrid->mPoints[i];
+            mPointBuckets[getBucket(static_cast<float>(point.mX), static_cast<float>(point.mY))].push_back(i);
+        }
+    }
+
+    void PathgridGraph::getPointsInRange(const osg::Vec3f& center, float radius, std::vector<int>& points) const
+    {
+        const std::size_t firstPoint = points.size();
+        const float radius2 = radius * radius;
+        const auto addPoints = [&] (const std::vector<int>& bucket)
+        {
+            for (int index : bucket)
+            {
+                const ESM::Pathgrid::Point& point = mPathgrid->mPoints[index];
+                const osg::Vec3f position(static_cast<float>(point.mX), static_cast<float>(point.mY), static_cast<float>(point.mZ));
+                if ((center - position).length2() <= radius2)
+                    points.push_back(index);
+            }
+        };
+
+        const std::pair<int, int> min = getBucket(center.x() - radius, center.y() - radius);
+        const std::pair<int, int> max = getBucket(center.x() + radius, center.y() + radius);
+        const double numBuckets = (max.first - static_cast<double>(min.first) + 1) * (max.second - static_cast<double>(min.second) + 1);
+        if (numBuckets > mPointBuckets.size())
+        {
+            for (PointBuckets::const_iterator it = mPointBuckets.begin(); it != mPointBuckets.end(); ++it)
+                addPoints(it->second);
+        }
+        else
+        {
+            for (int x = min.first; x <= max.first; ++x)
+                for (int y = min.second; y <= max.second; ++y)
+                {
+                    PointBuckets::const_iterator found = mPointBuckets.find(std::make_pair(x, y));
+                    if (found != mPointBuckets.end())
+                        addPoints(found->second);
+                }
+        }
+
+        std::sort(points.begin() + firstPoint, points.end());
+    }
+
     void PathgridGraph::getNeighbouringPoints(const int index, ESM::Pathgrid::PointList &nodes) const
     {
         for(int i = 0; i < static_cast<int> (mGraph[index].edges.size()); i++)
@@ -230,6 +346,44 @@ namespace MWMechanics
         }
     }
 
+    /*
+     * Small pathgrids have a table of next points, so the path is read from
+     * it. Paths in larger pathgrids are searched with searchPath once for
+     * each start/goal pair and then returned from mPathCache.
+     */
+    std::deque<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start, const int goal) const
+    {
+        if(!isPointConnected(start, goal))
+            return std::deque<ESM::Pathgrid::Point>(); // there is no path, return an empty path
+
+        if (!mNextPoints.empty())
+        {
+            const int size = static_cast<int>(mGraph.size());
+            std::deque<ESM::Pathgrid::Point> path;
+            path.push_back(mPathgrid->mPoints[start]);
+            for (int current = start; current != goal;)
+            {
+                current = mNextPoints[current * size + goal];
+                if (current == -1)
+                    return std::deque<ESM::Pathgrid::Point>();
+                path.push_back(mPathgrid->mPoints[current]);
+            }
+            return path;
+        }
+
+        const std::pair<int, int> key(start, goal);
+        PathCache::const_iterator found = mPathCache.find(key);
+        if (found != mPathCache.end())
+            return found->second;
+
+        if (mPathCache.size() >= sMaxCachedPaths)
+            mPathCache.clear();
+
+        std::deque<ESM::Pathgrid::Point> path = searchPath(start, goal);
+        mPathCache.insert(std::make_pair(key, path));
+        return path;
+    }
+
     /*
      * NOTE: Based on buildPath2(), please check git history if interested
      *       Should consider using a 3rd party library version (e.g. boost)
@@ -252,18 +406,11 @@ namespace MWMechanics
      *   gScore - past accumulated costs vector indexed by point index
      *   fScore - future estimated costs vector indexed by point index
      *
-     * TODO: An intersting exercise might be to cache the paths created for a
-     *       start/goal pair.  To cache the results the paths need to be in
-     *       pathgrid points form (currently they are converted to world
-     *       coordinates).  Essentially trading speed w/ memory.
+     * The results are cached by aStarSearch.
      */
-    std::deque<ESM::Pathgrid::Point> PathgridGraph::aStarSearch(const int start, const int goal) const
+    std::deque<ESM::Pathgrid::Point> PathgridGraph::searchPath(const int start, const int goal) const
     {
         std::deque<ESM::Pathgrid::Point> path;
-        if(!isPointConnected(start, goal))
-        {
-            return path; // there is no path, return an empty path
-        }
 
         int graphSize = static_cast<int> (mGraph.size());
         std::vector<float> gScore (graphSize, -1);
@@ -2,6 +2,10 @@
 #define GAME_MWMECHANICS_PATHGRID_H
 
 #include <deque>
+#include <map>
+#include <vector>
+
+#include <osg/Vec3f>
 
 #include <components/esm/loadpgrd.hpp>
 
@@ -30,6 +34,10 @@ namespace MWMechanics
             // from start point) both start and end are pathgrid point indexes
             bool isPointConnected(const int start, const int end) const;
 
+            // put the indexes of the points within radius of center into "points",
+            // in ascending order, center is in the coordinates of the points
+            void getPointsInRange(const osg::Vec3f& center, float radius, std::vector<int>& points) const;
+
             // get neighbouring nodes for index node and put them to "nodes" vector
             void getNeighbouringPoints(const int index, ESM::Pathgrid::PointList &nodes) const;
 
@@ -38,9 +46,13 @@ namespace MWMechanics
             // cells) coordinates
             //
             // NOTE: if start equals end an empty path is returned
+            //
+            // Paths of small pathgrids are read from a table of next points built
+            // on load, paths of larger pathgrids are searched once and cached.
             std::deque<ESM::Pathgrid::Point> aStarSearch(const int start, const int end) const;
 
         private:
+            std::deque<ESM::Pathgrid::Point> searchPath(const int start, const int goal) const;
 
             const ESM::Cell *mCell;
             const ESM::Pathgrid *mPathgrid;
@@ -79,6 +91,21 @@ namespace MWMechanics
             // methods used to calculate connected components
             void recursiveStrongConnect(int v);
             void buildConnectedPoints();
+
+            // mNextPoints[start * size + goal] is the point after start on the
+            // shortest path from start to goal, or -1 if there is none. Only
+            // built for pathgrids with few enough points.
+            std::vector<short> mNextPoints;
+            void buildNextPoints();
+
+            // Indexes of the points in each square of the XY plane, so every actor
+            // looking for the points near it doesn't have to go through all of them
+            typedef std::map<std::pair<int, int>, std::vector<int> > PointBuckets;
+            PointBuckets mPointBuckets;
+            void buildPointBuckets();
+
+            typedef std::map<std::pair<int, int>, std::deque<ESM::Pathgrid::Point> > PathCache;
+            mutable PathCache mPathCache;
     };
 }
 
@@ -608,7 +608,8 @@ namespace MWMechanics
                                     ActiveSpells::ActiveEffect effect_ = effect;
                                     effect_.mMagnitude *= -1;
                                     absorbEffects.push_back(effect_);
-                                    if (reflected && Settings::Manager::getBool("classic reflected absorb spells behavior", "Game"))
+                                    static const Settings::SettingValue<bool> classicReflectedAbsorb("classic reflected absorb spells behavior", "Game");
+                                    if (reflected && classicReflectedAbsorb.get())
                                         target.getClass().getCreatureStats(target).getActiveSpells().addSpell("", true,
                                             absorbEffects, mSourceName, caster.getClass().getCreatureStats(caster).getActorId());
                                     else
@@ -1067,13 +1068,26 @@ namespace MWMechanics
 
     void CastSpell::playSpellCastingEffects(const std::vector<ESM::ENAMstruct>& effects)
     {
+        static const std::string schools[] = {
+            "alteration", "conjuration", "destruction", "illusion", "mysticism", "restoration"
+        };
+
         const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
+        MWBase::SoundManager *sndMgr = MWBase::Environment::get().getSoundManager();
         std::vector<std::string> addedEffects;
         for (std::vector<ESM::ENAMstruct>::const_iterator iter = effects.begin(); iter != effects.end(); ++iter)
         {
             const ESM::MagicEffect *effect;
             effect = store.get<ESM::MagicEffect>().find(iter->mEffectID);
 
+            // The sounds played when the spell is released are decoded during the casting animation
+            const std::string& school = schools[effect->mData.mSchool];
+            if (iter->mRange == ESM::RT_Target)
+                sndMgr->preloadSound(!effect->mBoltSound.empty() ? effect->mBoltSound : school + " bolt");
+            if (iter->mArea > 0)
+                sndMgr->preloadSound(!effect->mAreaSound.empty() ? effect->mAreaSound : school + " area");
+            sndMgr->preloadSound(!effect->mHitSound.empty() ? effect->mHitSound : school + " hit");
+
             MWRender::Animation* animation = MWBase::Environment::get().getWorld()->getAnimation(mCaster);
 
             const ESM::Static* castStatic;
@@ -1108,13 +1122,8 @@ namespace MWMechanics
             if (animation && !mCaster.getClass().isActor())
                 animation->addSpellCastGlow(effect);
 
-            static const std::string schools[] = {
-                "alteration", "conjuration", "destruction", "illusion", "mysticism", "restoration"
-            };
-
             addedEffects.push_back("meshes\\" + castStatic->mModel);
 
-            MWBase::SoundManager *sndMgr = MWBase::Environment::get().getSoundManager();
             if(!effect->mCastSound.empty())
                 sndMgr->playSound3D(mCaster, effect->mCastSound, 1.0f, 1.0f);
             else
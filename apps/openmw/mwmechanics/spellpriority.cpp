@@ -108,10 +108,8 @@ namespace MWMechanics
     {
         const CreatureStats& stats = actor.getClass().getCreatureStats(actor);
 
-        float successChance = MWMechanics::getSpellSuccessChance(spell, actor);
-        if (successChance == 0.f)
-            return 0.f;
-
+        // Checked first, since most spells of an actor are usually abilities, diseases or powers that can't be cast
+        // in combat, and the success chance goes through every effect of the spell
         if (spell->mData.mType != ESM::Spell::ST_Spell)
             return 0.f;
 
@@ -124,6 +122,10 @@ namespace MWMechanics
                 return 0.f;
         }
 
+        float successChance = MWMechanics::getSpellSuccessChance(spell, actor);
+        if (successChance == 0.f)
+            return 0.f;
+
         // Spells don't stack, so early out if the spell is still active on the target
         int types = getRangeTypes(spell->mEffects);
         if ((types & Self) && stats.getActiveSpells().isSpellActive(spell->mId))
@@ -136,10 +138,11 @@ namespace MWMechanics
 
     float rateMagicItem(const MWWorld::Ptr &ptr, const MWWorld::Ptr &actor, const MWWorld::Ptr& enemy)
     {
-        if (ptr.getClass().getEnchantment(ptr).empty())
+        const std::string enchantmentId = ptr.getClass().getEnchantment(ptr);
+        if (enchantmentId.empty())
             return 0.f;
 
-        const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().find(ptr.getClass().getEnchantment(ptr));
+        const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().find(enchantmentId);
 
         // Spells don't stack, so early out if the spell is still active on the target
         int types = getRangeTypes(enchantment->mEffects);
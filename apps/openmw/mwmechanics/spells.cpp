@@ -136,14 +136,16 @@ namespace MWMechanics
             if (mPermanentSpellEffects.find(spell) != mPermanentSpellEffects.end())
             {
                 MagicEffects & effects = mPermanentSpellEffects[spell];
-                for (MagicEffects::Collection::const_iterator effectIt = effects.begin(); effectIt != effects.end();)
+                std::vector<EffectKey> harmfulEffects;
+                for (MagicEffects::Collection::const_iterator effectIt = effects.begin(); effectIt != effects.end(); ++effectIt)
                 {
                     const ESM::MagicEffect * magicEffect = MWBase::Environment::get().getWorld()->getStore().get<ESM::MagicEffect>().find(effectIt->first.mId);
                     if (magicEffect->mData.mFlags & ESM::MagicEffect::Harmful)
-                        effects.remove((effectIt++)->first);
-                    else
-                        ++effectIt;
+                        harmfulEffects.push_back(effectIt->first);
                 }
+                // Removing invalidates the iterators
+                for (const EffectKey& key : harmfulEffects)
+                    effects.remove(key);
             }
             mCorprusSpells.erase(corprusIt);
         }
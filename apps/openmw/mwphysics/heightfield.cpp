@@ -29,6 +29,7 @@ namespace MWPhysics
         mCollisionObject->setWorldTransform(transform);
 
         mHoldObject = holdObject;
+        mHeights = heights;
     }
 
     HeightField::~HeightField()
@@ -51,4 +52,9 @@ namespace MWPhysics
     {
         return mShape;
     }
+
+    bool HeightField::isCreatedFrom(const float* heights, const osg::Object* holdObject) const
+    {
+        return mHeights == heights && mHoldObject == holdObject;
+    }
 }
@@ -23,10 +23,14 @@ namespace MWPhysics
         const btCollisionObject* getCollisionObject() const;
         const btHeightfieldTerrainShape* getShape() const;
 
+        /// Return true if this heightfield was created from the given height data, so it can be reused for it.
+        bool isCreatedFrom(const float* heights, const osg::Object* holdObject) const;
+
     private:
         btHeightfieldTerrainShape* mShape;
         btCollisionObject* mCollisionObject;
         osg::ref_ptr<const osg::Object> mHoldObject;
+        const float* mHeights;
 
         void operator=(const HeightField&);
         HeightField(const HeightField&);
@@ -38,7 +38,17 @@ namespace MWPhysics
 
     void Object::setScale(float scale)
     {
-        mShapeInstance->setLocalScaling(btVector3(scale, scale, scale));
+        const btVector3 scaling(scale, scale, scale);
+        if (mShapeInstance->isShared())
+        {
+            if (mShapeInstance->getCollisionShape()->getLocalScaling() == scaling)
+                return;
+
+            // Used by other objects with the old scale
+            mShapeInstance = mShapeInstance->getSource()->makeInstance();
+            mCollisionObject->setCollisionShape(mShapeInstance->getCollisionShape());
+        }
+        mShapeInstance->setLocalScaling(scaling);
     }
 
     void Object::setRotation(const btQuaternion& quat)
@@ -76,14 +86,15 @@ namespace MWPhysics
         return !mShapeInstance->mAnimatedShapes.empty();
     }
 
-    void Object::animateCollisionShapes(btCollisionWorld* collisionWorld)
+    bool Object::animateCollisionShapes(btCollisionWorld* collisionWorld)
     {
         if (mShapeInstance->mAnimatedShapes.empty())
-            return;
+            return false;
 
         assert (mShapeInstance->getCollisionShape()->isCompound());
 
         btCompoundShape* compound = static_cast<btCompoundShape*>(mShapeInstance->getCollisionShape());
+        bool changed = false;
         for (std::map<int, int>::const_iterator it = mShapeInstance->mAnimatedShapes.begin(); it != mShapeInstance->mAnimatedShapes.end(); ++it)
         {
             int recIndex = it->first;
@@ -100,7 +111,7 @@ namespace MWPhysics
 
                     // Remove nonexistent nodes from animated shapes map and early out
                     mShapeInstance->mAnimatedShapes.erase(recIndex);
-                    return;
+                    return changed;
                 }
                 osg::NodePath nodePath = visitor.mFoundPath;
                 nodePath.erase(nodePath.begin());
@@ -120,9 +131,16 @@ namespace MWPhysics
             // Note: we can not apply scaling here for now since we treat scaled shapes
             // as new shapes (btScaledBvhTriangleMeshShape) with 1.0 scale for now
             if (!(transform == compound->getChildTransform(shapeIndex)))
+            {
                 compound->updateChildTransform(shapeIndex, transform);
+                changed = true;
+            }
         }
 
-        collisionWorld->updateSingleAabb(mCollisionObject.get());
+        // Most animated shapes are idle most of the time, don't touch the broadphase for them
+        if (changed)
+            collisionWorld->updateSingleAabb(mCollisionObject.get());
+
+        return changed;
     }
 }
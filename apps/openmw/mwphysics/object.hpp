@@ -35,7 +35,10 @@ namespace MWPhysics
         bool isSolid() const;
         void setSolid(bool solid);
         bool isAnimated() const;
-        void animateCollisionShapes(btCollisionWorld* collisionWorld);
+        /// Sync the transforms of the animated child shapes with the scene graph. Only updates the AABB of the
+        /// collision object if any of them changed.
+        /// @return true if any animated shape moved
+        bool animateCollisionShapes(btCollisionWorld* collisionWorld);
 
     private:
         std::unique_ptr<btCollisionObject> mCollisionObject;
@@ -1,6 +1,12 @@
 #include "physicssystem.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 #include <osg/Group>
+#include <osg/Stats>
+#include <osg/Timer>
 
 #include <BulletCollision/CollisionShapes/btConeShape.h>
 #include <BulletCollision/CollisionShapes/btSphereShape.h>
@@ -10,6 +16,7 @@
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
 #include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <LinearMath/btAabbUtil2.h>
 
 #include <LinearMath/btQuickprof.h>
 
@@ -21,6 +28,8 @@
 #include <components/misc/constants.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
+#include <components/sceneutil/workqueue.hpp>
+#include <components/settings/settings.hpp>
 #include <components/misc/convert.hpp>
 
 #include <components/nifosg/particle.hpp> // FindRecIndexVisitor
@@ -269,9 +278,40 @@ namespace MWPhysics
             }
         }
 
+        /// Apply the side effects of a jump requested through the movement settings of \a ptr.
+        /// Modifies game state outside of the physics system, so it must run on the main thread.
+        static void applyJump(const MWWorld::Ptr &ptr)
+        {
+            const bool isPlayer = (ptr == MWMechanics::getPlayer());
+            // Advance acrobatics and set flag for GetPCJumping
+            if (isPlayer)
+            {
+                ptr.getClass().skillUsageSucceeded(ptr, ESM::Skill::Acrobatics, 0);
+                MWBase::Environment::get().getWorld()->getPlayer().setJumping(true);
+            }
+
+            // Decrease fatigue
+            if (!isPlayer || !MWBase::Environment::get().getWorld()->getGodModeState())
+            {
+                const MWWorld::Store<ESM::GameSetting> &gmst = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
+                const float fFatigueJumpBase = gmst.find("fFatigueJumpBase")->mValue.getFloat();
+                const float fFatigueJumpMult = gmst.find("fFatigueJumpMult")->mValue.getFloat();
+                const float normalizedEncumbrance = std::min(1.f, ptr.getClass().getNormalizedEncumbrance(ptr));
+                const float fatigueDecrease = fFatigueJumpBase + normalizedEncumbrance * fFatigueJumpMult;
+                MWMechanics::DynamicStat<float> fatigue = ptr.getClass().getCreatureStats(ptr).getFatigue();
+                fatigue.setCurrent(fatigue.getCurrent() - fatigueDecrease);
+                ptr.getClass().getCreatureStats(ptr).setFatigue(fatigue);
+            }
+            ptr.getClass().getMovementSettings(ptr).mPosition[2] = 0;
+        }
+
+        /// @param standingOn Set to the object the actor ended up standing on, if any. Left unchanged otherwise.
+        /// @param numIterations Incremented by the number of solver iterations performed.
+        /// @note Safe to call for different actors in parallel, as long as setConcurrentTracing is enabled, the collision
+        /// world and the collision objects are not modified meanwhile and jumps were dealt with by applyJump beforehand.
         static osg::Vec3f move(osg::Vec3f position, const MWWorld::Ptr &ptr, Actor* physicActor, const osg::Vec3f &movement, float time,
                                   bool isFlying, float waterlevel, float slowFall, const btCollisionWorld* collisionWorld,
-                               std::map<MWWorld::Ptr, MWWorld::Ptr>& standingCollisionTracker)
+                               MWWorld::Ptr& standingOn, unsigned int& numIterations)
         {
             const ESM::Position& refpos = ptr.getRefData().getPosition();
             // Early-out for totally static creatures
@@ -328,29 +368,7 @@ namespace MWPhysics
                 velocity = osg::Vec3f(0,0,1) * 25;
 
             if (ptr.getClass().getMovementSettings(ptr).mPosition[2])
-            {
-                const bool isPlayer = (ptr == MWMechanics::getPlayer());
-                // Advance acrobatics and set flag for GetPCJumping
-                if (isPlayer)
-                {
-                    ptr.getClass().skillUsageSucceeded(ptr, ESM::Skill::Acrobatics, 0);
-                    MWBase::Environment::get().getWorld()->getPlayer().setJumping(true);
-                }
-
-                // Decrease fatigue
-                if (!isPlayer || !MWBase::Environment::get().getWorld()->getGodModeState())
-                {
-                    const MWWorld::Store<ESM::GameSetting> &gmst = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>();
-                    const float fFatigueJumpBase = gmst.find("fFatigueJumpBase")->mValue.getFloat();
-                    const float fFatigueJumpMult = gmst.find("fFatigueJumpMult")->mValue.getFloat();
-                    const float normalizedEncumbrance = std::min(1.f, ptr.getClass().getNormalizedEncumbrance(ptr));
-                    const float fatigueDecrease = fFatigueJumpBase + normalizedEncumbrance * fFatigueJumpMult;
-                    MWMechanics::DynamicStat<float> fatigue = ptr.getClass().getCreatureStats(ptr).getFatigue();
-                    fatigue.setCurrent(fatigue.getCurrent() - fatigueDecrease);
-                    ptr.getClass().getCreatureStats(ptr).setFatigue(fatigue);
-                }
-                ptr.getClass().getMovementSettings(ptr).mPosition[2] = 0;
-            }
+                applyJump(ptr);
 
             // Now that we have the effective movement vector, apply wind forces to it
             if (MWBase::Environment::get().getWorld()->isInStorm())
@@ -373,6 +391,7 @@ namespace MWPhysics
             float remainingTime = time;
             for(int iterations = 0; iterations < sMaxIterations && remainingTime > 0.01f; ++iterations)
             {
+                ++numIterations;
                 osg::Vec3f nextpos = newPosition + velocity * remainingTime;
 
                 // If not able to fly, don't allow to swim up into the air
@@ -465,12 +484,12 @@ namespace MWPhysics
                 if(tracer.mFraction < 1.0f
                         && tracer.mHitObject->getBroadphaseHandle()->m_collisionFilterGroup != CollisionType_Actor)
                 {
-                    const btCollisionObject* standingOn = tracer.mHitObject;
-                    PtrHolder* ptrHolder = static_cast<PtrHolder*>(standingOn->getUserPointer());
+                    const btCollisionObject* standingOnObject = tracer.mHitObject;
+                    PtrHolder* ptrHolder = static_cast<PtrHolder*>(standingOnObject->getUserPointer());
                     if (ptrHolder)
-                        standingCollisionTracker[ptr] = ptrHolder->getPtr();
+                        standingOn = ptrHolder->getPtr();
 
-                    if (standingOn->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Water)
+                    if (standingOnObject->getBroadphaseHandle()->m_collisionFilterGroup == CollisionType_Water)
                         physicActor->setWalkingOnWater(true);
                     if (!isFlying)
                         newPosition.z() = tracer.mEndPos.z() + sGroundOffset;
@@ -523,24 +542,61 @@ namespace MWPhysics
     };
 
 
+    /// Runs a share of a parallel job, like the actor movement of one physics step, on one of the movement worker threads.
+    class ParallelWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        ParallelWorkItem(const std::function<void()>& job)
+            : mJob(job)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mJob();
+        }
+
+    private:
+        std::function<void()> mJob;
+    };
+
+
     // ---------------------------------------------------------------
 
 
     PhysicsSystem::PhysicsSystem(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> parentNode)
-        : mShapeManager(new Resource::BulletShapeManager(resourceSystem->getVFS(), resourceSystem->getSceneManager(), resourceSystem->getNifFileManager()))
+        : mOptimizeBroadphase(Settings::Manager::getBool("optimize broadphase", "Physics"))
+        , mBroadphaseDirty(false)
+        , mShapeManager(new Resource::BulletShapeManager(resourceSystem->getVFS(), resourceSystem->getSceneManager(), resourceSystem->getNifFileManager()))
         , mResourceSystem(resourceSystem)
         , mDebugDrawEnabled(false)
+        , mMovementThreads(1)
+        , mAsyncSteps(0)
+        , mAsyncMovementTime(0.0)
         , mTimeAccum(0.0f)
         , mWaterHeight(0)
         , mWaterEnabled(false)
         , mParentNode(parentNode)
         , mPhysicsDt(1.f / 60.f)
+        , mMaxPhysicsSteps(20)
+        , mAnimatedObjectDistance(0.f)
+        , mFrameNumber(0)
+        , mNumActorsSolved(0)
+        , mNumIterations(0)
+        , mStepSimulationTime(0.0)
+        , mMovementTime(0.0)
+        , mLineOfSightCacheFrames(0)
+        , mLineOfSightCacheDistance(0.f)
     {
         mResourceSystem->addResourceManager(mShapeManager.get());
 
         mCollisionConfiguration = new btDefaultCollisionConfiguration();
         mDispatcher = new btCollisionDispatcher(mCollisionConfiguration);
         mBroadphase = new btDbvtBroadphase();
+        // Overlapping pairs are only needed by dynamics and ghost objects, which we don't use.
+        // By default they would be searched for every time an actor's AABB is updated.
+        if (mOptimizeBroadphase)
+            mBroadphase->m_deferedcollide = true;
 
         mCollisionWorld = new btCollisionWorld(mDispatcher, mBroadphase, mCollisionConfiguration);
 
@@ -548,21 +604,48 @@ namespace MWPhysics
         // Should a "static" object ever be moved, we have to update its AABB manually using DynamicsWorld::updateSingleAabb.
         mCollisionWorld->setForceUpdateAllAabbs(false);
 
+        float physFramerate = Settings::Manager::getFloat("physics framerate", "Physics");
+        if (physFramerate > 0)
+            mPhysicsDt = 1.f / physFramerate;
+        else
+            Log(Debug::Warning) << "Warning: ignoring invalid physics framerate (" << physFramerate << " FPS).";
+
         // Check if a user decided to override a physics system FPS
         const char* env = getenv("OPENMW_PHYSICS_FPS");
         if (env)
         {
-            float physFramerate = std::atof(env);
+            physFramerate = std::atof(env);
             if (physFramerate > 0)
             {
                 mPhysicsDt = 1.f / physFramerate;
                 Log(Debug::Warning) << "Warning: using custom physics framerate (" << physFramerate << " FPS).";
             }
         }
+
+        mMaxPhysicsSteps = std::max(1, Settings::Manager::getInt("max physics steps", "Physics"));
+
+        mAnimatedObjectDistance = Settings::Manager::getFloat("animated object distance", "Physics");
+
+        mLineOfSightCacheFrames = Settings::Manager::getInt("line of sight cache frames", "Physics");
+        mLineOfSightCacheDistance = Settings::Manager::getFloat("line of sight cache distance", "Physics");
+
+        mMovementThreads = std::max(1, Settings::Manager::getInt("actor movement threads", "Physics"));
+        if (mMovementThreads > 1)
+        {
+            // The main thread takes a share of the work as well
+            mMovementWorkQueue = new SceneUtil::WorkQueue(mMovementThreads - 1);
+            Log(Debug::Info) << "Solving actor movement on " << mMovementThreads << " threads";
+        }
+
+        if (Settings::Manager::getBool("async physics", "Physics"))
+            mAsyncWorkQueue = new SceneUtil::WorkQueue(1);
     }
 
     PhysicsSystem::~PhysicsSystem()
     {
+        if (mAsyncMovement)
+            mAsyncMovement->waitTillDone();
+
         mResourceSystem->removeResourceManager(mShapeManager.get());
 
         if (mWaterCollisionObject.get())
@@ -574,6 +657,9 @@ namespace MWPhysics
             delete it->second;
         }
 
+        for (DetachedHeightFields::iterator it = mDetachedHeightFields.begin(); it != mDetachedHeightFields.end(); ++it)
+            delete it->second;
+
         for (ObjectMap::iterator it = mObjects.begin(); it != mObjects.end(); ++it)
         {
             mCollisionWorld->removeCollisionObject(it->second->getCollisionObject());
@@ -813,6 +899,13 @@ namespace MWPhysics
     };
 
     PhysicsSystem::RayResult PhysicsSystem::castRay(const osg::Vec3f &from, const osg::Vec3f &to, const MWWorld::ConstPtr& ignore, std::vector<MWWorld::Ptr> targets, int mask, int group) const
+    {
+        syncSkippedAnimatedObjects(from, to, 0.f);
+        return castRayUnsynced(from, to, ignore, targets, mask, group);
+    }
+
+    PhysicsSystem::RayResult PhysicsSystem::castRayUnsynced(const osg::Vec3f &from, const osg::Vec3f &to, const MWWorld::ConstPtr& ignore,
+                                                            const std::vector<MWWorld::Ptr>& targets, int mask, int group) const
     {
         btVector3 btFrom = Misc::Convert::toBullet(from);
         btVector3 btTo = Misc::Convert::toBullet(to);
@@ -835,7 +928,7 @@ namespace MWPhysics
 
         if (!targets.empty())
         {
-            for (MWWorld::Ptr& target : targets)
+            for (const MWWorld::Ptr& target : targets)
             {
                 const Actor* actor = getActor(target);
                 if (actor)
@@ -847,7 +940,7 @@ namespace MWPhysics
         resultCallback.m_collisionFilterGroup = group;
         resultCallback.m_collisionFilterMask = mask;
 
-        mCollisionWorld->rayTest(btFrom, btTo, resultCallback);
+        rayTest(mCollisionWorld, btFrom, btTo, resultCallback);
 
         RayResult result;
         result.mHit = resultCallback.hasHit();
@@ -861,7 +954,13 @@ namespace MWPhysics
         return result;
     }
 
-    PhysicsSystem::RayResult PhysicsSystem::castSphere(const osg::Vec3f &from, const osg::Vec3f &to, float radius)
+    PhysicsSystem::RayResult PhysicsSystem::castSphere(const osg::Vec3f &from, const osg::Vec3f &to, float radius) const
+    {
+        syncSkippedAnimatedObjects(from, to, radius);
+        return castSphereUnsynced(from, to, radius);
+    }
+
+    PhysicsSystem::RayResult PhysicsSystem::castSphereUnsynced(const osg::Vec3f &from, const osg::Vec3f &to, float radius) const
     {
         btCollisionWorld::ClosestConvexResultCallback callback(Misc::Convert::toBullet(from), Misc::Convert::toBullet(to));
         callback.m_collisionFilterGroup = 0xff;
@@ -873,7 +972,7 @@ namespace MWPhysics
         btTransform from_ (btrot, Misc::Convert::toBullet(from));
         btTransform to_ (btrot, Misc::Convert::toBullet(to));
 
-        mCollisionWorld->convexSweepTest(&shape, from_, to_, callback);
+        convexSweepTest(mCollisionWorld, &shape, from_, to_, callback);
 
         RayResult result;
         result.mHit = callback.hasHit();
@@ -885,6 +984,99 @@ namespace MWPhysics
         return result;
     }
 
+    void PhysicsSystem::castRays(const std::vector<RayQuery>& queries, std::vector<RayResult>& results) const
+    {
+        for (const RayQuery& query : queries)
+            syncSkippedAnimatedObjects(query.mFrom, query.mTo, query.mRadius);
+
+        results.resize(queries.size());
+        runParallel(queries.size(), [&] (size_t index)
+        {
+            const RayQuery& query = queries[index];
+            if (query.mRadius > 0.f)
+                results[index] = castSphereUnsynced(query.mFrom, query.mTo, query.mRadius);
+            else
+                results[index] = castRayUnsynced(query.mFrom, query.mTo, query.mIgnore, query.mTargets, query.mMask, query.mGroup);
+        });
+    }
+
+    void PhysicsSystem::syncSkippedAnimatedObjects(const osg::Vec3f& from, const osg::Vec3f& to, float radius) const
+    {
+        if (mSkippedAnimatedObjects.empty())
+            return;
+
+        const btVector3 margin(radius, radius, radius);
+        btVector3 queryMin = Misc::Convert::toBullet(from);
+        btVector3 queryMax = queryMin;
+        queryMin.setMin(Misc::Convert::toBullet(to));
+        queryMax.setMax(Misc::Convert::toBullet(to));
+        queryMin -= margin;
+        queryMax += margin;
+
+        bool changed = false;
+        for (std::vector<Object*>::iterator it = mSkippedAnimatedObjects.begin(); it != mSkippedAnimatedObjects.end();)
+        {
+            const btCollisionObject* object = (*it)->getCollisionObject();
+            btVector3 aabbMin, aabbMax;
+            object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+            if (TestAabbAgainstAabb2(queryMin, queryMax, aabbMin, aabbMax))
+            {
+                changed |= (*it)->animateCollisionShapes(mCollisionWorld);
+                it = mSkippedAnimatedObjects.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        if (changed)
+            clearLineOfSightCache();
+    }
+
+    void PhysicsSystem::getLinesOfSight(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& actors, std::vector<bool>& results) const
+    {
+        results.assign(actors.size(), false);
+
+        std::vector<RayQuery> queries;
+        std::vector<size_t> queryIndices;
+        for (size_t i=0; i<actors.size(); ++i)
+        {
+            const Actor* physactor1 = getActor(actors[i].first);
+            const Actor* physactor2 = getActor(actors[i].second);
+            if (!physactor1 || !physactor2)
+                continue;
+
+            const RayQuery query = getLineOfSightQuery(physactor1, physactor2);
+            bool lineOfSight;
+            if (getCachedLineOfSight(physactor1, physactor2, query, lineOfSight))
+            {
+                results[i] = lineOfSight;
+                continue;
+            }
+
+            queryIndices.push_back(i);
+            queries.push_back(query);
+        }
+
+        std::vector<RayResult> rayResults;
+        castRays(queries, rayResults);
+
+        for (size_t i=0; i<queries.size(); ++i)
+        {
+            const size_t index = queryIndices[i];
+            results[index] = !rayResults[i].mHit;
+            cacheLineOfSight(getActor(actors[index].first), getActor(actors[index].second), queries[i], results[index]);
+        }
+    }
+
+    PhysicsSystem::RayQuery PhysicsSystem::getLineOfSightQuery(const Actor* physactor1, const Actor* physactor2)
+    {
+        RayQuery query;
+        query.mFrom = physactor1->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.9); // eye level
+        query.mTo = physactor2->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.9);
+        query.mMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Door;
+        return query;
+    }
+
     bool PhysicsSystem::getLineOfSight(const MWWorld::ConstPtr &actor1, const MWWorld::ConstPtr &actor2) const
     {
         const Actor* physactor1 = getActor(actor1);
@@ -893,14 +1085,60 @@ namespace MWPhysics
         if (!physactor1 || !physactor2)
             return false;
 
-        osg::Vec3f pos1 (physactor1->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor1->getHalfExtents().z() * 0.9)); // eye level
-        osg::Vec3f pos2 (physactor2->getCollisionObjectPosition() + osg::Vec3f(0,0,physactor2->getHalfExtents().z() * 0.9));
+        const RayQuery query = getLineOfSightQuery(physactor1, physactor2);
 
-        RayResult result = castRay(pos1, pos2, MWWorld::ConstPtr(), std::vector<MWWorld::Ptr>(), CollisionType_World|CollisionType_HeightMap|CollisionType_Door);
+        bool lineOfSight;
+        if (getCachedLineOfSight(physactor1, physactor2, query, lineOfSight))
+            return lineOfSight;
+
+        RayResult result = castRay(query.mFrom, query.mTo, query.mIgnore, std::vector<MWWorld::Ptr>(), query.mMask, query.mGroup);
+        cacheLineOfSight(physactor1, physactor2, query, !result.mHit);
 
         return !result.mHit;
     }
 
+    bool PhysicsSystem::getCachedLineOfSight(const Actor* physactor1, const Actor* physactor2, const RayQuery& query, bool& result) const
+    {
+        if (mLineOfSightCacheFrames <= 0)
+            return false;
+
+        const std::lock_guard<std::mutex> lock(mLineOfSightCacheMutex);
+
+        LineOfSightCache::const_iterator found = mLineOfSightCache.find(std::make_pair(physactor1, physactor2));
+        if (found == mLineOfSightCache.end())
+            return false;
+
+        const LineOfSightEntry& entry = found->second;
+        const float maxDistance2 = mLineOfSightCacheDistance * mLineOfSightCacheDistance;
+        if (mFrameNumber - entry.mFrame >= static_cast<unsigned int>(mLineOfSightCacheFrames)
+                || (entry.mFrom - query.mFrom).length2() > maxDistance2
+                || (entry.mTo - query.mTo).length2() > maxDistance2)
+            return false;
+
+        result = entry.mResult;
+        return true;
+    }
+
+    void PhysicsSystem::cacheLineOfSight(const Actor* physactor1, const Actor* physactor2, const RayQuery& query, bool result) const
+    {
+        if (mLineOfSightCacheFrames <= 0)
+            return;
+
+        const std::lock_guard<std::mutex> lock(mLineOfSightCacheMutex);
+
+        LineOfSightEntry& entry = mLineOfSightCache[std::make_pair(physactor1, physactor2)];
+        entry.mFrom = query.mFrom;
+        entry.mTo = query.mTo;
+        entry.mFrame = mFrameNumber;
+        entry.mResult = result;
+    }
+
+    void PhysicsSystem::clearLineOfSightCache() const
+    {
+        const std::lock_guard<std::mutex> lock(mLineOfSightCacheMutex);
+        mLineOfSightCache.clear();
+    }
+
     bool PhysicsSystem::isOnGround(const MWWorld::Ptr &actor)
     {
         Actor* physactor = getActor(actor);
@@ -1010,11 +1248,30 @@ namespace MWPhysics
 
     void PhysicsSystem::addHeightField (const float* heights, int x, int y, float triSize, float sqrtVerts, float minH, float maxH, const osg::Object* holdObject)
     {
-        HeightField *heightfield = new HeightField(heights, x, y, triSize, sqrtVerts, minH, maxH, holdObject);
-        mHeightFields[std::make_pair(x,y)] = heightfield;
+        const std::pair<int, int> cell(x, y);
+
+        // Reattach the heightfield of a recently unloaded cell if its land data is still the same
+        HeightField *heightfield = nullptr;
+        for (DetachedHeightFields::iterator it = mDetachedHeightFields.begin(); it != mDetachedHeightFields.end(); ++it)
+        {
+            if (it->first != cell)
+                continue;
+            if (it->second->isCreatedFrom(heights, holdObject))
+                heightfield = it->second;
+            else
+                delete it->second;
+            mDetachedHeightFields.erase(it);
+            break;
+        }
+
+        if (!heightfield)
+            heightfield = new HeightField(heights, x, y, triSize, sqrtVerts, minH, maxH, holdObject);
+        mHeightFields[cell] = heightfield;
 
         mCollisionWorld->addCollisionObject(heightfield->getCollisionObject(), CollisionType_HeightMap,
             CollisionType_Actor|CollisionType_Projectile);
+        mBroadphaseDirty = true;
+        clearLineOfSightCache();
     }
 
     void PhysicsSystem::removeHeightField (int x, int y)
@@ -1023,8 +1280,17 @@ namespace MWPhysics
         if(heightfield != mHeightFields.end())
         {
             mCollisionWorld->removeCollisionObject(heightfield->second->getCollisionObject());
-            delete heightfield->second;
+
+            // Keep it around for a while, the player often goes back to the cell they just left
+            mDetachedHeightFields.push_back(*heightfield);
+            if (mDetachedHeightFields.size() > sMaxDetachedHeightFields)
+            {
+                delete mDetachedHeightFields.front().second;
+                mDetachedHeightFields.pop_front();
+            }
+
             mHeightFields.erase(heightfield);
+            clearLineOfSightCache();
         }
     }
 
@@ -1038,7 +1304,7 @@ namespace MWPhysics
 
     void PhysicsSystem::addObject (const MWWorld::Ptr& ptr, const std::string& mesh, int collisionType)
     {
-        osg::ref_ptr<Resource::BulletShapeInstance> shapeInstance = mShapeManager->getInstance(mesh);
+        osg::ref_ptr<Resource::BulletShapeInstance> shapeInstance = mShapeManager->getSharedInstance(mesh, ptr.getCellRef().getScale());
         if (!shapeInstance || !shapeInstance->getCollisionShape())
             return;
 
@@ -1050,6 +1316,8 @@ namespace MWPhysics
 
         mCollisionWorld->addCollisionObject(obj->getCollisionObject(), collisionType,
                                            CollisionType_Actor|CollisionType_HeightMap|CollisionType_Projectile);
+        mBroadphaseDirty = true;
+        clearLineOfSightCache();
     }
 
     void PhysicsSystem::remove(const MWWorld::Ptr &ptr)
@@ -1063,9 +1331,13 @@ namespace MWPhysics
                 mUnrefQueue->push(found->second->getShapeInstance());
 
             mAnimatedObjects.erase(found->second);
+            mSkippedAnimatedObjects.erase(std::remove(mSkippedAnimatedObjects.begin(), mSkippedAnimatedObjects.end(), found->second),
+                                          mSkippedAnimatedObjects.end());
 
             delete found->second;
             mObjects.erase(found);
+            mBroadphaseDirty = true;
+            clearLineOfSightCache();
         }
 
         ActorMap::iterator foundActor = mActors.find(ptr);
@@ -1073,6 +1345,8 @@ namespace MWPhysics
         {
             delete foundActor->second;
             mActors.erase(foundActor);
+            // The cache is keyed by Actor pointers, which may be reused by new actors
+            clearLineOfSightCache();
         }
     }
 
@@ -1147,6 +1421,7 @@ namespace MWPhysics
             float scale = ptr.getCellRef().getScale();
             found->second->setScale(scale);
             mCollisionWorld->updateSingleAabb(found->second->getCollisionObject());
+            clearLineOfSightCache();
             return;
         }
         ActorMap::iterator foundActor = mActors.find(ptr);
@@ -1165,6 +1440,7 @@ namespace MWPhysics
         {
             found->second->setRotation(Misc::Convert::toBullet(ptr.getRefData().getBaseNode()->getAttitude()));
             mCollisionWorld->updateSingleAabb(found->second->getCollisionObject());
+            clearLineOfSightCache();
             return;
         }
         ActorMap::iterator foundActor = mActors.find(ptr);
@@ -1186,6 +1462,7 @@ namespace MWPhysics
         {
             found->second->setOrigin(Misc::Convert::toBullet(ptr.getRefData().getPosition().asVec3()));
             mCollisionWorld->updateSingleAabb(found->second->getCollisionObject());
+            clearLineOfSightCache();
             return;
         }
         ActorMap::iterator foundActor = mActors.find(ptr);
@@ -1252,112 +1529,360 @@ namespace MWPhysics
         mStandingCollisions.clear();
     }
 
-    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    bool PhysicsSystem::prepareMovement(const MWWorld::Ptr& ptr, const osg::Vec3f& movement, ActorMovement& out)
     {
-        mMovementResults.clear();
+        ActorMap::iterator foundActor = mActors.find(ptr);
+        if (foundActor == mActors.end()) // actor was already removed from the scene
+            return false;
+        Actor* physicActor = foundActor->second;
+
+        const MWBase::World *world = MWBase::Environment::get().getWorld();
+
+        float waterlevel = -std::numeric_limits<float>::max();
+        const MWWorld::CellStore *cell = ptr.getCell();
+        if(cell->getCell()->hasWater())
+            waterlevel = cell->getWaterLevel();
+
+        const MWMechanics::MagicEffects& effects = ptr.getClass().getCreatureStats(ptr).getMagicEffects();
+
+        bool waterCollision = false;
+        if (cell->getCell()->hasWater() && effects.get(ESM::MagicEffect::WaterWalking).getMagnitude())
+        {
+            if (!world->isUnderwater(ptr.getCell(), osg::Vec3f(ptr.getRefData().getPosition().asVec3())))
+                waterCollision = true;
+            else if (physicActor->getCollisionMode() && canMoveToWaterSurface(ptr, waterlevel))
+            {
+                const osg::Vec3f actorPosition = physicActor->getPosition();
+                physicActor->setPosition(osg::Vec3f(actorPosition.x(), actorPosition.y(), waterlevel));
+                waterCollision = true;
+            }
+        }
+        physicActor->setCanWaterWalk(waterCollision);
+
+        out.mActor = physicActor;
+        out.mPtr = ptr;
+        out.mMovement = movement;
+        out.mWaterlevel = waterlevel;
+        // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
+        out.mSlowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+        out.mFlying = world->isFlying(ptr);
+        out.mSwimming = world->isSwimming(ptr);
+        out.mWasOnGround = physicActor->getOnGround();
+        out.mPosition = physicActor->getPosition();
+        out.mOldHeight = out.mPosition.z();
+        out.mPositionChanged = false;
+        out.mStandingOn = MWWorld::Ptr();
+        out.mIterations = 0;
+        return true;
+    }
+
+    void PhysicsSystem::solveMovement(ActorMovement& movement)
+    {
+        movement.mPosition = MovementSolver::move(movement.mPosition, movement.mPtr, movement.mActor, movement.mMovement, mPhysicsDt,
+                                                  movement.mFlying, movement.mWaterlevel, movement.mSlowFall, mCollisionWorld, movement.mStandingOn,
+                                                  movement.mIterations);
+    }
+
+    void PhysicsSystem::commitMovementStep(ActorMovement& movement)
+    {
+        if (movement.mPosition != movement.mActor->getPosition())
+            movement.mPositionChanged = true;
+        movement.mActor->setPosition(movement.mPosition); // always set even if unchanged to make sure interpolation is correct
+    }
+
+    void PhysicsSystem::finishMovement(const ActorMovement& movement, int numSteps)
+    {
+        Actor* physicActor = movement.mActor;
+        const MWWorld::Ptr& ptr = movement.mPtr;
+
+        if (movement.mPositionChanged)
+            mCollisionWorld->updateSingleAabb(physicActor->getCollisionObject());
+
+        if (!movement.mStandingOn.isEmpty())
+            mStandingCollisions[ptr] = movement.mStandingOn;
+
+        mNumActorsSolved += numSteps;
+        mNumIterations += movement.mIterations;
+
+        float interpolationFactor = mTimeAccum / mPhysicsDt;
+        osg::Vec3f interpolated = movement.mPosition * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
+
+        float heightDiff = movement.mPosition.z() - movement.mOldHeight;
+
+        MWMechanics::CreatureStats& stats = ptr.getClass().getCreatureStats(ptr);
+        bool isStillOnGround = (numSteps > 0 && movement.mWasOnGround && physicActor->getOnGround());
+        if (isStillOnGround || movement.mFlying || movement.mSwimming || movement.mSlowFall < 1)
+            stats.land(ptr == MWMechanics::getPlayer() && (movement.mFlying || movement.mSwimming));
+        else if (heightDiff < 0)
+            stats.addToFallHeight(-heightDiff);
 
+        mMovementResults.push_back(std::make_pair(ptr, interpolated));
+    }
+
+    int PhysicsSystem::advanceTime(float dt)
+    {
         mTimeAccum += dt;
 
-        const int maxAllowedSteps = 20;
         int numSteps = mTimeAccum / (mPhysicsDt);
-        numSteps = std::min(numSteps, maxAllowedSteps);
+        numSteps = std::min(numSteps, mMaxPhysicsSteps);
 
         mTimeAccum -= numSteps * mPhysicsDt;
 
+        // When the step limit is hit, let the simulation fall behind instead of carrying the remainder over,
+        // so the next frames don't have to catch up and the interpolation factor stays below 1
+        mTimeAccum = std::min(mTimeAccum, mPhysicsDt);
+
         if (numSteps)
         {
             // Collision events should be available on every frame
             mStandingCollisions.clear();
         }
+        return numSteps;
+    }
 
-        const MWWorld::Ptr player = MWMechanics::getPlayer();
-        const MWBase::World *world = MWBase::Environment::get().getWorld();
-        PtrVelocityList::iterator iter = mMovementQueue.begin();
-        for(;iter != mMovementQueue.end();++iter)
+    void PhysicsSystem::prepareMovements(int numSteps)
+    {
+        mActorMovements.clear();
+        for (PtrVelocityList::iterator iter = mMovementQueue.begin(); iter != mMovementQueue.end(); ++iter)
         {
-            ActorMap::iterator foundActor = mActors.find(iter->first);
-            if (foundActor == mActors.end()) // actor was already removed from the scene
-                continue;
-            Actor* physicActor = foundActor->second;
-
-            float waterlevel = -std::numeric_limits<float>::max();
-            const MWWorld::CellStore *cell = iter->first.getCell();
-            if(cell->getCell()->hasWater())
-                waterlevel = cell->getWaterLevel();
+            mActorMovements.emplace_back();
+            if (!prepareMovement(iter->first, iter->second, mActorMovements.back()))
+                mActorMovements.pop_back();
+        }
 
-            const MWMechanics::MagicEffects& effects = iter->first.getClass().getCreatureStats(iter->first).getMagicEffects();
+        // Jumps have side effects outside of the physics system, deal with them before any other thread is involved
+        for (ActorMovement& movement : mActorMovements)
+        {
+            const MWWorld::Ptr& ptr = movement.mPtr;
+            if (numSteps > 0 && ptr.getClass().isMobile(ptr) && movement.mActor->getCollisionMode()
+                    && ptr.getClass().getMovementSettings(ptr).mPosition[2])
+                MovementSolver::applyJump(ptr);
+        }
+    }
 
-            bool waterCollision = false;
-            if (cell->getCell()->hasWater() && effects.get(ESM::MagicEffect::WaterWalking).getMagnitude())
+    void PhysicsSystem::runParallel(size_t count, const std::function<void(size_t)>& function) const
+    {
+        std::atomic<size_t> next(0);
+        auto job = [count, &function, &next] ()
+        {
+            setConcurrentTracing(true);
+            for (size_t index = next++; index < count; index = next++)
+                function(index);
+            setConcurrentTracing(false);
+        };
+
+        std::vector<osg::ref_ptr<ParallelWorkItem> > items;
+        if (mMovementWorkQueue && count > 1)
+        {
+            const size_t numItems = std::min<size_t>(mMovementThreads - 1, count - 1);
+            for (size_t item=0; item<numItems; ++item)
             {
-                if (!world->isUnderwater(iter->first.getCell(), osg::Vec3f(iter->first.getRefData().getPosition().asVec3())))
-                    waterCollision = true;
-                else if (physicActor->getCollisionMode() && canMoveToWaterSurface(iter->first, waterlevel))
-                {
-                    const osg::Vec3f actorPosition = physicActor->getPosition();
-                    physicActor->setPosition(osg::Vec3f(actorPosition.x(), actorPosition.y(), waterlevel));
-                    waterCollision = true;
-                }
+                items.push_back(new ParallelWorkItem(job));
+                mMovementWorkQueue->addWorkItem(items.back());
             }
-            physicActor->setCanWaterWalk(waterCollision);
+        }
+
+        job();
 
-            // Slow fall reduces fall speed by a factor of (effect magnitude / 200)
-            float slowFall = 1.f - std::max(0.f, std::min(1.f, effects.get(ESM::MagicEffect::SlowFall).getMagnitude() * 0.005f));
+        for (osg::ref_ptr<ParallelWorkItem>& item : items)
+            item->waitTillDone();
+    }
 
-            bool flying = world->isFlying(iter->first);
-            bool swimming = world->isSwimming(iter->first);
+    void PhysicsSystem::solveMovementSteps(int numSteps)
+    {
+        for (int i=0; i<numSteps; ++i)
+        {
+            // Every actor is solved against the collision world as it was at the start of the step.
+            // The results are written back afterwards in queue order, so they don't depend on the number of threads.
+            runParallel(mActorMovements.size(), [this] (size_t index) { solveMovement(mActorMovements[index]); });
 
-            bool wasOnGround = physicActor->getOnGround();
-            osg::Vec3f position = physicActor->getPosition();
-            float oldHeight = position.z();
-            bool positionChanged = false;
-            for (int i=0; i<numSteps; ++i)
+            for (ActorMovement& movement : mActorMovements)
+                commitMovementStep(movement);
+        }
+    }
+
+    const PtrVelocityList& PhysicsSystem::applyQueuedMovement(float dt)
+    {
+        const osg::Timer_t start = osg::Timer::instance()->tick();
+        mMovementResults.clear();
+
+        const int numSteps = advanceTime(dt);
+
+        if (mMovementWorkQueue && mMovementQueue.size() > 1)
+        {
+            prepareMovements(numSteps);
+            solveMovementSteps(numSteps);
+
+            for (const ActorMovement& movement : mActorMovements)
+                finishMovement(movement, numSteps);
+        }
+        else
+        {
+            ActorMovement movement;
+            for (PtrVelocityList::iterator iter = mMovementQueue.begin(); iter != mMovementQueue.end(); ++iter)
             {
-                position = MovementSolver::move(position, physicActor->getPtr(), physicActor, iter->second, mPhysicsDt,
-                                                flying, waterlevel, slowFall, mCollisionWorld, mStandingCollisions);
-                if (position != physicActor->getPosition())
-                    positionChanged = true;
-                physicActor->setPosition(position); // always set even if unchanged to make sure interpolation is correct
+                if (!prepareMovement(iter->first, iter->second, movement))
+                    continue;
+
+                for (int i=0; i<numSteps; ++i)
+                {
+                    solveMovement(movement);
+                    commitMovementStep(movement);
+                }
+
+                finishMovement(movement, numSteps);
             }
-            if (positionChanged)
-                mCollisionWorld->updateSingleAabb(physicActor->getCollisionObject());
+        }
 
-            float interpolationFactor = mTimeAccum / mPhysicsDt;
-            osg::Vec3f interpolated = position * interpolationFactor + physicActor->getPreviousPosition() * (1.f - interpolationFactor);
+        mMovementQueue.clear();
 
-            float heightDiff = position.z() - oldHeight;
+        mMovementTime += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
 
-            MWMechanics::CreatureStats& stats = iter->first.getClass().getCreatureStats(iter->first);
-            bool isStillOnGround = (numSteps > 0 && wasOnGround && physicActor->getOnGround());
-            if (isStillOnGround || flying || swimming || slowFall < 1)
-                stats.land(iter->first == player && (flying || swimming));
-            else if (heightDiff < 0)
-                stats.addToFallHeight(-heightDiff);
+        return mMovementResults;
+    }
 
-            mMovementResults.push_back(std::make_pair(iter->first, interpolated));
-        }
+    bool PhysicsSystem::isAsyncMovementEnabled() const
+    {
+        return mAsyncWorkQueue.valid();
+    }
+
+    void PhysicsSystem::startQueuedMovement(float dt)
+    {
+        // Should have been done by the caller already, but two solves must never overlap
+        finishQueuedMovement();
 
+        mAsyncSteps = advanceTime(dt);
+        prepareMovements(mAsyncSteps);
         mMovementQueue.clear();
 
+        mAsyncMovement = new ParallelWorkItem([this] ()
+        {
+            const osg::Timer_t start = osg::Timer::instance()->tick();
+            solveMovementSteps(mAsyncSteps);
+            mAsyncMovementTime = osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
+        });
+        mAsyncWorkQueue->addWorkItem(mAsyncMovement);
+    }
+
+    const PtrVelocityList& PhysicsSystem::finishQueuedMovement()
+    {
+        mMovementResults.clear();
+        if (mAsyncMovement)
+        {
+            mAsyncMovement->waitTillDone();
+            mAsyncMovement = nullptr;
+            mMovementTime += mAsyncMovementTime;
+
+            for (const ActorMovement& movement : mActorMovements)
+                finishMovement(movement, mAsyncSteps);
+            mActorMovements.clear();
+        }
         return mMovementResults;
     }
 
     void PhysicsSystem::stepSimulation(float dt)
     {
-        for (Object* animatedObject :  mAnimatedObjects)
-            animatedObject->animateCollisionShapes(mCollisionWorld);
+        const osg::Timer_t start = osg::Timer::instance()->tick();
+
+        {
+            const std::lock_guard<std::mutex> lock(mLineOfSightCacheMutex);
+            ++mFrameNumber;
+            for (LineOfSightCache::iterator it = mLineOfSightCache.begin(); it != mLineOfSightCache.end();)
+            {
+                if (mFrameNumber - it->second.mFrame >= static_cast<unsigned int>(mLineOfSightCacheFrames))
+                    it = mLineOfSightCache.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        bool animatedShapesChanged = false;
+
+        // The broadphase trees are only balanced incrementally when inserting objects, which gives poor trees
+        // after loading cells with thousands of objects. Rebuild them completely instead, it's cheap compared to
+        // sweeping every actor through a degenerate tree for each step.
+        if (mOptimizeBroadphase && mBroadphaseDirty)
+        {
+            mBroadphase->optimize();
+            mBroadphaseDirty = false;
+        }
+
+        mSkippedAnimatedObjects.clear();
+        if (mAnimatedObjectDistance > 0.f)
+        {
+            // Animated shapes that no actor can touch don't need to be synced with the scene graph,
+            // unless a ray or projectile could hit them before the next step
+            std::vector<btVector3> actorPositions;
+            actorPositions.reserve(mActors.size());
+            for (const auto& actor : mActors)
+                actorPositions.push_back(Misc::Convert::toBullet(actor.second->getCollisionObjectPosition()));
+
+            const btVector3 margin(mAnimatedObjectDistance, mAnimatedObjectDistance, mAnimatedObjectDistance);
+            for (Object* animatedObject : mAnimatedObjects)
+            {
+                const btCollisionObject* object = animatedObject->getCollisionObject();
+                btVector3 aabbMin, aabbMax;
+                object->getCollisionShape()->getAabb(object->getWorldTransform(), aabbMin, aabbMax);
+                aabbMin -= margin;
+                aabbMax += margin;
+
+                const bool nearActor = std::any_of(actorPositions.begin(), actorPositions.end(), [&] (const btVector3& position)
+                {
+                    return position.x() >= aabbMin.x() && position.y() >= aabbMin.y() && position.z() >= aabbMin.z()
+                        && position.x() <= aabbMax.x() && position.y() <= aabbMax.y() && position.z() <= aabbMax.z();
+                });
+                if (nearActor)
+                    animatedShapesChanged |= animatedObject->animateCollisionShapes(mCollisionWorld);
+                else
+                    mSkippedAnimatedObjects.push_back(animatedObject);
+            }
+        }
+        else
+        {
+            for (Object* animatedObject :  mAnimatedObjects)
+                animatedShapesChanged |= animatedObject->animateCollisionShapes(mCollisionWorld);
+        }
+
+        if (animatedShapesChanged)
+            clearLineOfSightCache();
 
 #ifndef BT_NO_PROFILE
         CProfileManager::Reset();
         CProfileManager::Increment_Frame_Counter();
 #endif
+
+        mStepSimulationTime += osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick());
     }
 
     void PhysicsSystem::updateAnimatedCollisionShape(const MWWorld::Ptr& object)
     {
         ObjectMap::iterator found = mObjects.find(object);
-        if (found != mObjects.end())
-            found->second->animateCollisionShapes(mCollisionWorld);
+        if (found != mObjects.end() && found->second->animateCollisionShapes(mCollisionWorld))
+            clearLineOfSightCache();
+    }
+
+    void PhysicsSystem::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        stats.setAttribute(frameNumber, "Physics Actors", mActors.size());
+        stats.setAttribute(frameNumber, "Physics Objects", mObjects.size());
+        stats.setAttribute(frameNumber, "Physics Heightmaps", mHeightFields.size());
+        stats.setAttribute(frameNumber, "Physics Pairs", mBroadphase->getOverlappingPairCache()->getNumOverlappingPairs());
+
+        // The counters below cover everything since the last report
+        const TraceCounters traces = takeTraceCounters();
+        stats.setAttribute(frameNumber, "Physics Sweeps", traces.mSweepTests);
+        stats.setAttribute(frameNumber, "Physics Rays", traces.mRayTests);
+        stats.setAttribute(frameNumber, "Physics Solved", mNumActorsSolved);
+        stats.setAttribute(frameNumber, "Physics Iterations", mNumIterations);
+        // Average solver iterations per actor and step, in hundredths as the overlay shows integers only
+        stats.setAttribute(frameNumber, "Physics Avg Iter %", mNumActorsSolved ? 100.0 * mNumIterations / mNumActorsSolved : 0.0);
+        stats.setAttribute(frameNumber, "Physics Step us", mStepSimulationTime * 1000000.0);
+        stats.setAttribute(frameNumber, "Physics Move us", mMovementTime * 1000000.0);
+
+        mNumActorsSolved = 0;
+        mNumIterations = 0;
+        mStepSimulationTime = 0.0;
+        mMovementTime = 0.0;
     }
 
     void PhysicsSystem::debugDraw()
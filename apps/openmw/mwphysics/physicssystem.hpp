@@ -2,8 +2,11 @@
 #define OPENMW_MWPHYSICS_PHYSICSSYSTEM_H
 
 #include <memory>
+#include <mutex>
+#include <functional>
 #include <map>
 #include <set>
+#include <deque>
 #include <algorithm>
 
 #include <osg/Quat>
@@ -17,6 +20,7 @@ namespace osg
 {
     class Group;
     class Object;
+    class Stats;
 }
 
 namespace MWRender
@@ -33,10 +37,12 @@ namespace Resource
 namespace SceneUtil
 {
     class UnrefQueue;
+    class WorkQueue;
+    class WorkItem;
 }
 
 class btCollisionWorld;
-class btBroadphaseInterface;
+class btDbvtBroadphase;
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btCollisionObject;
@@ -124,7 +130,28 @@ namespace MWPhysics
                     std::vector<MWWorld::Ptr> targets = std::vector<MWWorld::Ptr>(),
                     int mask = CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door, int group=0xff) const;
 
-            RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius);
+            RayResult castSphere(const osg::Vec3f& from, const osg::Vec3f& to, float radius) const;
+
+            struct RayQuery
+            {
+                osg::Vec3f mFrom;
+                osg::Vec3f mTo;
+                /// Traced as a sphere of this radius with castSphere if > 0, else as a ray with castRay.
+                float mRadius = 0.f;
+                /// castRay parameters, not used by sphere queries.
+                MWWorld::ConstPtr mIgnore;
+                std::vector<MWWorld::Ptr> mTargets;
+                int mMask = CollisionType_World|CollisionType_HeightMap|CollisionType_Actor|CollisionType_Door;
+                int mGroup = 0xff;
+            };
+
+            /// Evaluate a batch of queries, spread across the "actor movement threads" if there is more than one.
+            /// @param results Receives one result per query, in the same order.
+            void castRays(const std::vector<RayQuery>& queries, std::vector<RayResult>& results) const;
+
+            /// Batched version of getLineOfSight for pairs of actors.
+            /// @param results Receives, for each pair, whether the first actor can see the second one.
+            void getLinesOfSight(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& actors, std::vector<bool>& results) const;
 
             /// Return true if actor1 can see actor2.
             bool getLineOfSight(const MWWorld::ConstPtr& actor1, const MWWorld::ConstPtr& actor2) const;
@@ -153,6 +180,19 @@ namespace MWPhysics
             /// Apply all queued movements, then clear the list.
             const PtrVelocityList& applyQueuedMovement(float dt);
 
+            /// Whether the queued movement should be solved in the background with startQueuedMovement, see the
+            /// "async physics" setting.
+            bool isAsyncMovementEnabled() const;
+
+            /// Start solving all queued movements on the physics thread, then clear the list.
+            /// @note Jumps are applied right away. Until finishQueuedMovement is called, the physics system
+            /// must not be used in any way, as the collision world is being read and actors are being moved.
+            void startQueuedMovement(float dt);
+
+            /// Wait for the movement started by startQueuedMovement and return its results, like applyQueuedMovement does.
+            /// Returns an empty list if no movement was started.
+            const PtrVelocityList& finishQueuedMovement();
+
             /// Clear the queued movements list without applying.
             void clearQueuedMovement();
 
@@ -181,6 +221,8 @@ namespace MWPhysics
 
             void updateAnimatedCollisionShape(const MWWorld::Ptr& object);
 
+            void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
             template <class Function>
             void forEachAnimatedObject(Function&& function) const
             {
@@ -191,9 +233,61 @@ namespace MWPhysics
 
             void updateWater();
 
+            static RayQuery getLineOfSightQuery(const Actor* physactor1, const Actor* physactor2);
+            bool getCachedLineOfSight(const Actor* physactor1, const Actor* physactor2, const RayQuery& query, bool& result) const;
+            void cacheLineOfSight(const Actor* physactor1, const Actor* physactor2, const RayQuery& query, bool result) const;
+            /// Called when any collision object that blocks the line of sight is added, removed or moved
+            void clearLineOfSightCache() const;
+
+            /// Sync the collision shapes of the animated objects that stepSimulation skipped and that a query
+            /// from \a from to \a to with \a radius could hit, so rays and projectiles don't pass through stale shapes.
+            /// @note Not thread safe, must be called before the queries are spread across threads.
+            void syncSkippedAnimatedObjects(const osg::Vec3f& from, const osg::Vec3f& to, float radius) const;
+
+            RayResult castRayUnsynced(const osg::Vec3f &from, const osg::Vec3f &to, const MWWorld::ConstPtr& ignore,
+                    const std::vector<MWWorld::Ptr>& targets, int mask, int group) const;
+            RayResult castSphereUnsynced(const osg::Vec3f& from, const osg::Vec3f& to, float radius) const;
+
+            /// Movement state of a single queued actor during applyQueuedMovement.
+            struct ActorMovement
+            {
+                Actor* mActor;
+                MWWorld::Ptr mPtr;
+                osg::Vec3f mMovement;
+                float mWaterlevel;
+                float mSlowFall;
+                bool mFlying;
+                bool mSwimming;
+                bool mWasOnGround;
+                float mOldHeight;
+                osg::Vec3f mPosition;
+                bool mPositionChanged;
+                MWWorld::Ptr mStandingOn;
+                unsigned int mIterations;
+            };
+
+            /// @return false if \a ptr has no physics actor anymore.
+            bool prepareMovement(const MWWorld::Ptr& ptr, const osg::Vec3f& movement, ActorMovement& out);
+            /// Solve one physics step without modifying the collision world.
+            void solveMovement(ActorMovement& movement);
+            void commitMovementStep(ActorMovement& movement);
+            void finishMovement(const ActorMovement& movement, int numSteps);
+            /// Add the frame duration to the accumulator. @return The number of physics steps to run.
+            int advanceTime(float dt);
+            /// Fill mActorMovements from the movement queue and apply the jumps.
+            void prepareMovements(int numSteps);
+            /// Call \a function for each index below \a count, spread across the movement worker threads and this thread.
+            /// Traces made by \a function are safe to run concurrently, see setConcurrentTracing.
+            void runParallel(size_t count, const std::function<void(size_t)>& function) const;
+            /// Solve all of mActorMovements, spreading each physics step across the movement worker threads.
+            /// Doesn't touch anything outside of the physics system, so it may run on the physics thread.
+            void solveMovementSteps(int numSteps);
+
             osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
-            btBroadphaseInterface* mBroadphase;
+            btDbvtBroadphase* mBroadphase;
+            bool mOptimizeBroadphase;
+            bool mBroadphaseDirty;
             btDefaultCollisionConfiguration* mCollisionConfiguration;
             btCollisionDispatcher* mDispatcher;
             btCollisionWorld* mCollisionWorld;
@@ -212,6 +306,11 @@ namespace MWPhysics
             typedef std::map<std::pair<int, int>, HeightField*> HeightFieldMap;
             HeightFieldMap mHeightFields;
 
+            // Heightfields of recently unloaded cells, oldest first
+            typedef std::deque<std::pair<std::pair<int, int>, HeightField*> > DetachedHeightFields;
+            DetachedHeightFields mDetachedHeightFields;
+            static const size_t sMaxDetachedHeightFields = 16;
+
             bool mDebugDrawEnabled;
 
             // Tracks standing collisions happening during a single frame. <actor handle, collided handle>
@@ -225,6 +324,15 @@ namespace MWPhysics
             PtrVelocityList mMovementQueue;
             PtrVelocityList mMovementResults;
 
+            std::vector<ActorMovement> mActorMovements;
+            int mMovementThreads;
+            osg::ref_ptr<SceneUtil::WorkQueue> mMovementWorkQueue;
+
+            osg::ref_ptr<SceneUtil::WorkQueue> mAsyncWorkQueue;
+            osg::ref_ptr<SceneUtil::WorkItem> mAsyncMovement;
+            int mAsyncSteps;
+            double mAsyncMovementTime;
+
             float mTimeAccum;
 
             float mWaterHeight;
@@ -238,6 +346,36 @@ namespace MWPhysics
             osg::ref_ptr<osg::Group> mParentNode;
 
             float mPhysicsDt;
+            int mMaxPhysicsSteps;
+
+            // Animated collision shapes further than this from all actors are not updated, 0 to update all of them
+            float mAnimatedObjectDistance;
+            // The animated objects stepSimulation skipped, they are synced once a query could hit them
+            mutable std::vector<Object*> mSkippedAnimatedObjects;
+
+            // Incremented by stepSimulation
+            unsigned int mFrameNumber;
+
+            // Profiling counters, reset by reportStats
+            mutable unsigned int mNumActorsSolved;
+            mutable unsigned int mNumIterations;
+            mutable double mStepSimulationTime;
+            mutable double mMovementTime;
+
+            // Line of sight results, reused for a few frames as long as neither actor nor any object moves much.
+            // Guarded by mLineOfSightCacheMutex, since the checks are const and may run on several threads.
+            struct LineOfSightEntry
+            {
+                osg::Vec3f mFrom;
+                osg::Vec3f mTo;
+                unsigned int mFrame;
+                bool mResult;
+            };
+            typedef std::map<std::pair<const Actor*, const Actor*>, LineOfSightEntry> LineOfSightCache;
+            mutable LineOfSightCache mLineOfSightCache;
+            mutable std::mutex mLineOfSightCacheMutex;
+            int mLineOfSightCacheFrames;
+            float mLineOfSightCacheDistance;
 
             PhysicsSystem (const PhysicsSystem&);
             PhysicsSystem& operator= (const PhysicsSystem&);
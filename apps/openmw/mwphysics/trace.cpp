@@ -1,9 +1,13 @@
 #include "trace.h"
 
+#include <atomic>
+
 #include <components/misc/convert.hpp>
 
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
 #include <BulletCollision/CollisionShapes/btConvexShape.h>
+#include <BulletCollision/BroadphaseCollision/btBroadphaseInterface.h>
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 
 #include "collisiontype.hpp"
 #include "actor.hpp"
@@ -48,6 +52,121 @@ protected:
 };
 
 
+namespace
+{
+    thread_local bool sConcurrentTracing = false;
+
+    std::atomic<unsigned int> sNumSweepTests(0);
+    std::atomic<unsigned int> sNumRayTests(0);
+
+    /// Same as btSingleSweepCallback, but gathers candidates with aabbTest, which keeps its traversal stack local.
+    class ConcurrentSweepCallback : public btBroadphaseAabbCallback
+    {
+    public:
+        ConcurrentSweepCallback(const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                                btCollisionWorld::ConvexResultCallback& resultCallback)
+            : mShape(shape), mFrom(from), mTo(to), mResultCallback(resultCallback)
+        {
+        }
+
+        virtual bool process(const btBroadphaseProxy* proxy)
+        {
+            if (mResultCallback.m_closestHitFraction == btScalar(0))
+                return false;
+
+            const btCollisionObject* object = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+            if (mResultCallback.needsCollision(object->getBroadphaseHandle()))
+                btCollisionWorld::objectQuerySingle(mShape, mFrom, mTo, object, object->getCollisionShape(),
+                                                    object->getWorldTransform(), mResultCallback, btScalar(0));
+            return true;
+        }
+
+    private:
+        const btConvexShape* mShape;
+        const btTransform& mFrom;
+        const btTransform& mTo;
+        btCollisionWorld::ConvexResultCallback& mResultCallback;
+    };
+
+    /// Same as btSingleRayCallback, to be used with btDbvt::rayTest, which keeps its traversal stack local.
+    class ConcurrentRayCallback : public btDbvt::ICollide
+    {
+    public:
+        ConcurrentRayCallback(const btVector3& from, const btVector3& to, btCollisionWorld::RayResultCallback& resultCallback)
+            : mFrom(btMatrix3x3::getIdentity(), from), mTo(btMatrix3x3::getIdentity(), to), mResultCallback(resultCallback)
+        {
+        }
+
+        virtual void Process(const btDbvtNode* leaf)
+        {
+            if (mResultCallback.m_closestHitFraction == btScalar(0))
+                return;
+
+            const btBroadphaseProxy* proxy = static_cast<const btBroadphaseProxy*>(leaf->data);
+            btCollisionObject* object = static_cast<btCollisionObject*>(proxy->m_clientObject);
+            if (mResultCallback.needsCollision(object->getBroadphaseHandle()))
+                btCollisionWorld::rayTestSingle(mFrom, mTo, object, object->getCollisionShape(), object->getWorldTransform(), mResultCallback);
+        }
+
+    private:
+        const btTransform mFrom;
+        const btTransform mTo;
+        btCollisionWorld::RayResultCallback& mResultCallback;
+    };
+}
+
+void setConcurrentTracing(bool enabled)
+{
+    sConcurrentTracing = enabled;
+}
+
+TraceCounters takeTraceCounters()
+{
+    TraceCounters counters;
+    counters.mSweepTests = sNumSweepTests.exchange(0);
+    counters.mRayTests = sNumRayTests.exchange(0);
+    return counters;
+}
+
+void rayTest(const btCollisionWorld* world, const btVector3& from, const btVector3& to,
+             btCollisionWorld::RayResultCallback& resultCallback)
+{
+    sNumRayTests.fetch_add(1, std::memory_order_relaxed);
+
+    const btDbvtBroadphase* broadphase = dynamic_cast<const btDbvtBroadphase*>(world->getBroadphase());
+    if (!sConcurrentTracing || !broadphase)
+    {
+        world->rayTest(from, to, resultCallback);
+        return;
+    }
+
+    ConcurrentRayCallback callback(from, to, resultCallback);
+    btDbvt::rayTest(broadphase->m_sets[0].m_root, from, to, callback);
+    btDbvt::rayTest(broadphase->m_sets[1].m_root, from, to, callback);
+}
+
+void convexSweepTest(const btCollisionWorld* world, const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                     btCollisionWorld::ConvexResultCallback& resultCallback)
+{
+    sNumSweepTests.fetch_add(1, std::memory_order_relaxed);
+
+    if (!sConcurrentTracing)
+    {
+        world->convexSweepTest(shape, from, to, resultCallback);
+        return;
+    }
+
+    btVector3 fromMin, fromMax, toMin, toMax;
+    shape->getAabb(from, fromMin, fromMax);
+    shape->getAabb(to, toMin, toMax);
+    fromMin.setMin(toMin);
+    fromMax.setMax(toMax);
+
+    ConcurrentSweepCallback callback(shape, from, to, resultCallback);
+    // aabbTest is only non-const because of its interface, it does not modify the broadphase
+    const_cast<btBroadphaseInterface*>(world->getBroadphase())->aabbTest(fromMin, fromMax, callback);
+}
+
 void ActorTracer::doTrace(const btCollisionObject *actor, const osg::Vec3f& start, const osg::Vec3f& end, const btCollisionWorld* world)
 {
     const btVector3 btstart = Misc::Convert::toBullet(start);
@@ -66,8 +185,7 @@ void ActorTracer::doTrace(const btCollisionObject *actor, const osg::Vec3f& star
 
     const btCollisionShape *shape = actor->getCollisionShape();
     assert(shape->isConvex());
-    world->convexSweepTest(static_cast<const btConvexShape*>(shape),
-                                               from, to, newTraceCallback);
+    convexSweepTest(world, static_cast<const btConvexShape*>(shape), from, to, newTraceCallback);
 
     // Copy the hit data over to our trace results struct:
     if(newTraceCallback.hasHit())
@@ -104,7 +222,7 @@ void ActorTracer::findGround(const Actor* actor, const osg::Vec3f& start, const
     newTraceCallback.m_collisionFilterMask = actor->getCollisionObject()->getBroadphaseHandle()->m_collisionFilterMask;
     newTraceCallback.m_collisionFilterMask &= ~CollisionType_Actor;
 
-    world->convexSweepTest(actor->getConvexShape(), from, to, newTraceCallback);
+    convexSweepTest(world, actor->getConvexShape(), from, to, newTraceCallback);
     if(newTraceCallback.hasHit())
     {
         const btVector3& tracehitnormal = newTraceCallback.m_hitNormalWorld;
@@ -3,8 +3,10 @@
 
 #include <osg/Vec3f>
 
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+
 class btCollisionObject;
-class btCollisionWorld;
+class btConvexShape;
 
 
 namespace MWPhysics
@@ -23,6 +25,28 @@ namespace MWPhysics
         void doTrace(const btCollisionObject *actor, const osg::Vec3f& start, const osg::Vec3f& end, const btCollisionWorld* world);
         void findGround(const Actor* actor, const osg::Vec3f& start, const osg::Vec3f& end, const btCollisionWorld* world);
     };
+
+    /// Make traces issued by the calling thread query the broadphase in a way that is safe while other threads trace
+    /// against the same world. btDbvtBroadphase shares one traversal stack for all sweep tests unless Bullet was built
+    /// with BT_THREADSAFE. The world must not be modified while concurrent traces are running.
+    void setConcurrentTracing(bool enabled);
+
+    struct TraceCounters
+    {
+        unsigned int mSweepTests;
+        unsigned int mRayTests;
+    };
+
+    /// Return the number of sweep and ray tests made through the functions below since the last call, from all threads.
+    TraceCounters takeTraceCounters();
+
+    /// Same as btCollisionWorld::rayTest, but respects setConcurrentTracing.
+    void rayTest(const btCollisionWorld* world, const btVector3& from, const btVector3& to,
+                 btCollisionWorld::RayResultCallback& resultCallback);
+
+    /// Same as btCollisionWorld::convexSweepTest, but respects setConcurrentTracing.
+    void convexSweepTest(const btCollisionWorld* world, const btConvexShape* shape, const btTransform& from, const btTransform& to,
+                         btCollisionWorld::ConvexResultCallback& resultCallback);
 }
 
 #endif
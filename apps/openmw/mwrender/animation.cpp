@@ -258,13 +258,41 @@ namespace
         std::vector<std::pair<osg::Node*, osg::Group*> > mFoundBones;
     };
 
-    class RemoveFinishedCallbackVisitor : public RemoveVisitor
+    /// Removes the transforms of effects, and recycles the effect nodes attached to them.
+    class RemoveEffectVisitor : public RemoveVisitor
+    {
+    public:
+        void removeEffect(osg::Group& group, const MWRender::UpdateVfxCallback& callback)
+        {
+            mToRemove.push_back(std::make_pair(group.asNode(), group.getParent(0)));
+            if (group.getNumChildren() > 0)
+                mEffects.push_back(std::make_pair(callback.mParams.mPoolKey, osg::ref_ptr<osg::Node>(group.getChild(0))));
+        }
+
+        void remove(Resource::SceneManager* sceneManager)
+        {
+            // Detached first, the transforms may be deleted once they are removed
+            for (const auto& effect : mEffects)
+            {
+                effect.second->getParent(0)->removeChild(effect.second);
+                sceneManager->recycleInstance(effect.first, effect.second);
+            }
+            mEffects.clear();
+
+            RemoveVisitor::remove();
+        }
+
+    private:
+        std::vector<std::pair<std::string, osg::ref_ptr<osg::Node> > > mEffects;
+    };
+
+    class RemoveFinishedCallbackVisitor : public RemoveEffectVisitor
     {
     public:
         bool mHasMagicEffects;
 
         RemoveFinishedCallbackVisitor()
-            : RemoveVisitor()
+            : RemoveEffectVisitor()
             , mHasMagicEffects(false)
         {
         }
@@ -286,7 +314,7 @@ namespace
                 if (vfxCallback)
                 {
                     if (vfxCallback->mFinished)
-                        mToRemove.push_back(std::make_pair(group.asNode(), group.getParent(0)));
+                        removeEffect(group, *vfxCallback);
                     else
                         mHasMagicEffects = true;
                 }
@@ -303,20 +331,20 @@ namespace
         }
     };
 
-    class RemoveCallbackVisitor : public RemoveVisitor
+    class RemoveCallbackVisitor : public RemoveEffectVisitor
     {
     public:
         bool mHasMagicEffects;
 
         RemoveCallbackVisitor()
-            : RemoveVisitor()
+            : RemoveEffectVisitor()
             , mHasMagicEffects(false)
             , mEffectId(-1)
         {
         }
 
         RemoveCallbackVisitor(int effectId)
-            : RemoveVisitor()
+            : RemoveEffectVisitor()
             , mHasMagicEffects(false)
             , mEffectId(effectId)
         {
@@ -339,7 +367,7 @@ namespace
                 {
                     bool toRemove = mEffectId < 0 || vfxCallback->mParams.mEffectId == mEffectId;
                     if (toRemove)
-                        mToRemove.push_back(std::make_pair(group.asNode(), group.getParent(0)));
+                        removeEffect(group, *vfxCallback);
                     else
                         mHasMagicEffects = true;
                 }
@@ -655,6 +683,12 @@ namespace MWRender
             mSkeleton->setActive(static_cast<SceneUtil::Skeleton::ActiveType>(active));
     }
 
+    void Animation::setUpdateInterval(unsigned int interval, unsigned int phase)
+    {
+        if (mSkeleton)
+            mSkeleton->setUpdateInterval(interval, phase);
+    }
+
     void Animation::updatePtr(const MWWorld::Ptr &ptr)
     {
         mPtr = ptr;
@@ -701,8 +735,6 @@ namespace MWRender
 
     void Animation::loadAllAnimationsInFolder(const std::string &model, const std::string &baseModel)
     {
-        const std::map<std::string, VFS::File*>& index = mResourceSystem->getVFS()->getIndex();
-
         std::string animationPath = model;
         if (animationPath.find("meshes") == 0)
         {
@@ -710,21 +742,11 @@ namespace MWRender
         }
         animationPath.replace(animationPath.size()-3, 3, "/");
 
-        mResourceSystem->getVFS()->normalizeFilename(animationPath);
-
-        std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(animationPath);
-        while (found != index.end())
+        for (const std::string& name : mResourceSystem->getVFS()->getRecursiveDirectoryIterator(animationPath))
         {
-            const std::string& name = found->first;
-            if (name.size() >= animationPath.size() && name.substr(0, animationPath.size()) == animationPath)
-            {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".kf") == 0)
-                    addSingleAnimSource(name, baseModel);
-            }
-            else
-                break;
-            ++found;
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".kf") == 0)
+                addSingleAnimSource(name, baseModel);
         }
     }
 
@@ -1384,8 +1406,6 @@ namespace MWRender
         if (model.empty())
             return;
 
-        const std::map<std::string, VFS::File*>& index = resourceSystem->getVFS()->getIndex();
-
         std::string animationPath = model;
         if (animationPath.find("meshes") == 0)
         {
@@ -1393,21 +1413,11 @@ namespace MWRender
         }
         animationPath.replace(animationPath.size()-4, 4, "/");
 
-        resourceSystem->getVFS()->normalizeFilename(animationPath);
-
-        std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(animationPath);
-        while (found != index.end())
+        for (const std::string& name : resourceSystem->getVFS()->getRecursiveDirectoryIterator(animationPath))
         {
-            const std::string& name = found->first;
-            if (name.size() >= animationPath.size() && name.substr(0, animationPath.size()) == animationPath)
-            {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".nif") == 0)
-                    loadBonesFromFile(node, name, resourceSystem);
-            }
-            else
-                break;
-            ++found;
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".nif") == 0)
+                loadBonesFromFile(node, name, resourceSystem);
         }
     }
 
@@ -1638,17 +1648,30 @@ namespace MWRender
         }
         parentNode->addChild(trans);
 
-        osg::ref_ptr<osg::Node> node = mResourceSystem->getSceneManager()->getInstance(model, trans);
-        node->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        Resource::SceneManager* sceneManager = mResourceSystem->getSceneManager();
+        params.mPoolKey = getEffectPoolKey(model, texture, "attached effect");
+
+        // Recycled instances were set up for the same texture already
+        osg::ref_ptr<osg::Node> node = sceneManager->takeRecycledInstance(params.mPoolKey);
+        const bool recycled = node != nullptr;
+        if (recycled)
+            sceneManager->attachTo(node, trans);
+        else
+        {
+            node = sceneManager->getInstance(model, trans);
+            node->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+            // FreezeOnCull doesn't work so well with effect particles, that tend to have moving emitters
+            SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
+            node->accept(disableFreezeOnCullVisitor);
+            node->setNodeMask(Mask_Effect);
+
+            overrideFirstRootTexture(texture, mResourceSystem, node);
+        }
 
         SceneUtil::FindMaxControllerLengthVisitor findMaxLengthVisitor;
         node->accept(findMaxLengthVisitor);
 
-        // FreezeOnCull doesn't work so well with effect particles, that tend to have moving emitters
-        SceneUtil::DisableFreezeOnCullVisitor disableFreezeOnCullVisitor;
-        node->accept(disableFreezeOnCullVisitor);
-        node->setNodeMask(Mask_Effect);
-
         params.mMaxControllerLength = findMaxLengthVisitor.getMaxLength();
         params.mLoop = loop;
         params.mEffectId = effectId;
@@ -1661,15 +1684,13 @@ namespace MWRender
 
         // Notify that this animation has attached magic effects
         mHasMagicEffects = true;
-
-        overrideFirstRootTexture(texture, mResourceSystem, node);
     }
 
     void Animation::removeEffect(int effectId)
     {
         RemoveCallbackVisitor visitor(effectId);
         mInsert->accept(visitor);
-        visitor.remove();
+        visitor.remove(mResourceSystem->getSceneManager());
         mHasMagicEffects = visitor.mHasMagicEffects;
     }
 
@@ -1706,7 +1727,7 @@ namespace MWRender
         // transformation nodes with finished callbacks
         RemoveFinishedCallbackVisitor visitor;
         mInsert->accept(visitor);
-        visitor.remove();
+        visitor.remove(mResourceSystem->getSceneManager());
         mHasMagicEffects = visitor.mHasMagicEffects;
     }
 
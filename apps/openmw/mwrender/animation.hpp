@@ -75,6 +75,7 @@ typedef std::shared_ptr<PartHolder> PartHolderPtr;
 struct EffectParams
 {
     std::string mModelName; // Just here so we don't add the same effect twice
+    std::string mPoolKey; // To recycle the effect's node once it's removed
     std::shared_ptr<EffectAnimationTime> mAnimTime;
     float mMaxControllerLength;
     int mEffectId;
@@ -351,6 +352,10 @@ public:
     /// 0 = Inactive, 1 = Active in place, 2 = Active
     void setActive(int active);
 
+    /// Update the object skeleton only once per \a interval frames, if one exists.
+    /// @see SceneUtil::Skeleton::setUpdateInterval
+    void setUpdateInterval(unsigned int interval, unsigned int phase);
+
     osg::Group* getOrCreateObjectRoot();
 
     osg::Group* getObjectRoot();
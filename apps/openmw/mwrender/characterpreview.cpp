@@ -15,8 +15,11 @@
 
 #include <components/debug/debuglog.hpp>
 #include <components/fallback/fallback.hpp>
+#include <components/resource/resourcesystem.hpp>
+#include <components/resource/scenemanager.hpp>
 #include <components/sceneutil/lightmanager.hpp>
 #include <components/sceneutil/shadow.hpp>
+#include <components/shader/shadermanager.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -144,6 +147,8 @@ namespace MWRender
 
         osg::ref_ptr<SceneUtil::LightManager> lightManager = new SceneUtil::LightManager;
         lightManager->setStartLight(1);
+        // Shaders are shared with the scene, so the lights have to be passed the same way
+        lightManager->setClusteredLighting(mResourceSystem->getSceneManager()->getShaderManager().getGlobalDefines()["clusteredLighting"] == "1");
         osg::ref_ptr<osg::StateSet> stateset = lightManager->getOrCreateStateSet();
         stateset->setMode(GL_LIGHTING, osg::StateAttribute::ON);
         stateset->setMode(GL_NORMALIZE, osg::StateAttribute::ON);
@@ -272,9 +277,17 @@ namespace MWRender
         sizeX = std::max(sizeX, 0);
         sizeY = std::max(sizeY, 0);
 
+        const int y = mSizeY - sizeY;
+        const int width = std::min(mSizeX, sizeX);
+        const int height = std::min(mSizeY, sizeY);
+
+        // The pinned inventory sets the same viewport periodically, don't render the same preview again
+        if (mViewport && mViewport->y() == y && mViewport->width() == width && mViewport->height() == height)
+            return;
+
         // NB Camera::setViewport has threading issues
         osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet;
-        mViewport = new osg::Viewport(0, mSizeY-sizeY, std::min(mSizeX, sizeX), std::min(mSizeY, sizeY));
+        mViewport = new osg::Viewport(0, y, width, height);
         stateset->setAttributeAndModes(mViewport);
         mCamera->setStateSet(stateset);
 
@@ -27,13 +27,19 @@ EffectManager::~EffectManager()
 
 void EffectManager::addEffect(const std::string &model, const std::string& textureOverride, const osg::Vec3f &worldPosition, float scale, bool isMagicVFX)
 {
-    osg::ref_ptr<osg::Node> node = mResourceSystem->getSceneManager()->getInstance(model);
-
-    node->setNodeMask(Mask_Effect);
+    Resource::SceneManager* sceneManager = mResourceSystem->getSceneManager();
 
     Effect effect;
+    effect.mPoolKey = getEffectPoolKey(model, textureOverride, isMagicVFX ? "magic effect" : "effect");
     effect.mAnimTime.reset(new EffectAnimationTime);
 
+    osg::ref_ptr<osg::Node> node = sceneManager->takeRecycledInstance(effect.mPoolKey);
+    const bool recycled = node != nullptr;
+    if (!recycled)
+        node = sceneManager->getInstance(model);
+
+    node->setNodeMask(Mask_Effect);
+
     SceneUtil::FindMaxControllerLengthVisitor findMaxLengthVisitor;
     node->accept(findMaxLengthVisitor);
     effect.mMaxControllerLength = findMaxLengthVisitor.getMaxLength();
@@ -46,10 +52,14 @@ void EffectManager::addEffect(const std::string &model, const std::string& textu
     SceneUtil::AssignControllerSourcesVisitor assignVisitor(effect.mAnimTime);
     node->accept(assignVisitor);
 
-    if (isMagicVFX)
-        overrideFirstRootTexture(textureOverride, mResourceSystem, node);
-    else
-        overrideTexture(textureOverride, mResourceSystem, node);
+    // Recycled instances already have the texture
+    if (!recycled)
+    {
+        if (isMagicVFX)
+            overrideFirstRootTexture(textureOverride, mResourceSystem, node);
+        else
+            overrideTexture(textureOverride, mResourceSystem, node);
+    }
 
     mParentNode->addChild(trans);
 
@@ -64,7 +74,7 @@ void EffectManager::update(float dt)
 
         if (it->second.mAnimTime->getTime() >= it->second.mMaxControllerLength)
         {
-            mParentNode->removeChild(it->first);
+            removeEffect(*it);
             mEffects.erase(it++);
         }
         else
@@ -76,9 +86,21 @@ void EffectManager::clear()
 {
     for (EffectMap::iterator it = mEffects.begin(); it != mEffects.end(); ++it)
     {
-        mParentNode->removeChild(it->first);
+        removeEffect(*it);
     }
     mEffects.clear();
 }
 
+void EffectManager::removeEffect(const EffectMap::value_type& effect)
+{
+    mParentNode->removeChild(effect.first);
+
+    if (effect.first->getNumChildren() == 0)
+        return;
+
+    osg::ref_ptr<osg::Node> node = effect.first->getChild(0);
+    effect.first->removeChild(node);
+    mResourceSystem->getSceneManager()->recycleInstance(effect.second.mPoolKey, node);
+}
+
 }
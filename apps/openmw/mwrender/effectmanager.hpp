@@ -44,11 +44,15 @@ namespace MWRender
         {
             float mMaxControllerLength;
             std::shared_ptr<EffectAnimationTime> mAnimTime;
+            std::string mPoolKey;
         };
 
         typedef std::map<osg::ref_ptr<osg::PositionAttitudeTransform>, Effect> EffectMap;
         EffectMap mEffects;
 
+        /// Detach the effect and keep its node to be reused by the next effect of the same model.
+        void removeEffect(const EffectMap::value_type& effect);
+
         osg::ref_ptr<osg::Group> mParentNode;
         Resource::ResourceSystem* mResourceSystem;
 
@@ -1,5 +1,7 @@
 #include "globalmap.hpp"
 
+#include <algorithm>
+
 #include <osg/Image>
 #include <osg/Texture2D>
 #include <osg/Group>
@@ -31,15 +33,17 @@ namespace
 
     // Create a screen-aligned quad with given texture coordinates.
     // Assumes a top-left origin of the sampled image.
-    osg::ref_ptr<osg::Geometry> createTexturedQuad(float leftTexCoord, float topTexCoord, float rightTexCoord, float bottomTexCoord)
+    // The quad covers the given rectangle in normalized device coordinates.
+    osg::ref_ptr<osg::Geometry> createTexturedQuad(float leftTexCoord, float topTexCoord, float rightTexCoord, float bottomTexCoord,
+                                                   float left, float top, float right, float bottom)
     {
         osg::ref_ptr<osg::Geometry> geom = new osg::Geometry;
 
         osg::ref_ptr<osg::Vec3Array> verts = new osg::Vec3Array;
-        verts->push_back(osg::Vec3f(-1, -1, 0));
-        verts->push_back(osg::Vec3f(-1, 1, 0));
-        verts->push_back(osg::Vec3f(1, 1, 0));
-        verts->push_back(osg::Vec3f(1, -1, 0));
+        verts->push_back(osg::Vec3f(left, bottom, 0));
+        verts->push_back(osg::Vec3f(left, top, 0));
+        verts->push_back(osg::Vec3f(right, top, 0));
+        verts->push_back(osg::Vec3f(right, bottom, 0));
 
         geom->setVertexArray(verts);
 
@@ -286,6 +290,13 @@ namespace MWRender
 
     void GlobalMap::requestOverlayTextureUpdate(int x, int y, int width, int height, osg::ref_ptr<osg::Texture2D> texture, bool clear, bool cpuCopy,
                                                 float srcLeft, float srcTop, float srcRight, float srcBottom)
+    {
+        osg::ref_ptr<osg::Camera> camera = createOverlayCamera(x, y, width, height, clear, cpuCopy);
+        if (texture)
+            addOverlayQuad(camera, x, y, width, height, texture, srcLeft, srcTop, srcRight, srcBottom);
+    }
+
+    osg::ref_ptr<osg::Camera> GlobalMap::createOverlayCamera(int x, int y, int width, int height, bool clear, bool cpuCopy)
     {
         osg::ref_ptr<osg::Camera> camera (new osg::Camera);
         camera->setNodeMask(Mask_RenderToTexture);
@@ -328,45 +339,56 @@ namespace MWRender
             mPendingImageDest[camera] = imageDest;
         }
 
-        // Create a quad rendering the updated texture
-        if (texture)
-        {
-            osg::ref_ptr<osg::Geometry> geom = createTexturedQuad(srcLeft, srcTop, srcRight, srcBottom);
-            osg::ref_ptr<osg::Depth> depth = new osg::Depth;
-            depth->setWriteMask(0);
-            osg::StateSet* stateset = geom->getOrCreateStateSet();
-            stateset->setAttribute(depth);
-            stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
-            stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-            stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
-
-            if (mAlphaTexture)
-            {
-                osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
-
-                float x1 = x / static_cast<float>(mWidth);
-                float x2 = (x + width) / static_cast<float>(mWidth);
-                float y1 = y / static_cast<float>(mHeight);
-                float y2 = (y + height) / static_cast<float>(mHeight);
-                texcoords->push_back(osg::Vec2f(x1, y1));
-                texcoords->push_back(osg::Vec2f(x1, y2));
-                texcoords->push_back(osg::Vec2f(x2, y2));
-                texcoords->push_back(osg::Vec2f(x2, y1));
-                geom->setTexCoordArray(1, texcoords, osg::Array::BIND_PER_VERTEX);
-
-                stateset->setTextureAttributeAndModes(1, mAlphaTexture, osg::StateAttribute::ON);
-                osg::ref_ptr<osg::TexEnvCombine> texEnvCombine = new osg::TexEnvCombine;
-                texEnvCombine->setCombine_RGB(osg::TexEnvCombine::REPLACE);
-                texEnvCombine->setSource0_RGB(osg::TexEnvCombine::PREVIOUS);
-                stateset->setTextureAttributeAndModes(1, texEnvCombine);
-            }
-
-            camera->addChild(geom);
-        }
-
         mRoot->addChild(camera);
 
         mActiveCameras.push_back(camera);
+
+        return camera;
+    }
+
+    void GlobalMap::addOverlayQuad(osg::Camera* camera, int x, int y, int width, int height, osg::ref_ptr<osg::Texture2D> texture,
+                                   float srcLeft, float srcTop, float srcRight, float srcBottom)
+    {
+        y = mHeight - y - height; // convert top-left origin to bottom-left
+
+        // Position of the quad within the viewport of the camera
+        const osg::Viewport* viewport = camera->getViewport();
+        float left = (x - static_cast<float>(viewport->x())) / static_cast<float>(viewport->width()) * 2.f - 1.f;
+        float right = (x + width - static_cast<float>(viewport->x())) / static_cast<float>(viewport->width()) * 2.f - 1.f;
+        float bottom = (y - static_cast<float>(viewport->y())) / static_cast<float>(viewport->height()) * 2.f - 1.f;
+        float top = (y + height - static_cast<float>(viewport->y())) / static_cast<float>(viewport->height()) * 2.f - 1.f;
+
+        osg::ref_ptr<osg::Geometry> geom = createTexturedQuad(srcLeft, srcTop, srcRight, srcBottom, left, top, right, bottom);
+        osg::ref_ptr<osg::Depth> depth = new osg::Depth;
+        depth->setWriteMask(0);
+        osg::StateSet* stateset = geom->getOrCreateStateSet();
+        stateset->setAttribute(depth);
+        stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+        stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+
+        if (mAlphaTexture)
+        {
+            osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
+
+            float x1 = x / static_cast<float>(mWidth);
+            float x2 = (x + width) / static_cast<float>(mWidth);
+            float y1 = y / static_cast<float>(mHeight);
+            float y2 = (y + height) / static_cast<float>(mHeight);
+            texcoords->push_back(osg::Vec2f(x1, y1));
+            texcoords->push_back(osg::Vec2f(x1, y2));
+            texcoords->push_back(osg::Vec2f(x2, y2));
+            texcoords->push_back(osg::Vec2f(x2, y1));
+            geom->setTexCoordArray(1, texcoords, osg::Array::BIND_PER_VERTEX);
+
+            stateset->setTextureAttributeAndModes(1, mAlphaTexture, osg::StateAttribute::ON);
+            osg::ref_ptr<osg::TexEnvCombine> texEnvCombine = new osg::TexEnvCombine;
+            texEnvCombine->setCombine_RGB(osg::TexEnvCombine::REPLACE);
+            texEnvCombine->setSource0_RGB(osg::TexEnvCombine::PREVIOUS);
+            stateset->setTextureAttributeAndModes(1, texEnvCombine);
+        }
+
+        camera->addChild(geom);
     }
 
     void GlobalMap::exploreCell(int cellX, int cellY, osg::ref_ptr<osg::Texture2D> localMapTexture)
@@ -382,7 +404,42 @@ namespace MWRender
         if (cellX > mMaxX || cellX < mMinX || cellY > mMaxY || cellY < mMinY)
             return;
 
-        requestOverlayTextureUpdate(originX, mHeight - originY, mCellSize, mCellSize, localMapTexture, false, true);
+        ExploredCell cell;
+        cell.mX = originX;
+        cell.mY = mHeight - originY;
+        cell.mTexture = localMapTexture;
+
+        auto found = std::find_if(mPendingExploredCells.begin(), mPendingExploredCells.end(),
+            [&] (const ExploredCell& pending) { return pending.mX == cell.mX && pending.mY == cell.mY; });
+        if (found != mPendingExploredCells.end())
+            *found = cell;
+        else
+            mPendingExploredCells.push_back(cell);
+    }
+
+    void GlobalMap::updateExploredCells()
+    {
+        if (mPendingExploredCells.empty())
+            return;
+
+        // One camera and one copy back to the CPU for all cells explored since the last update
+        int left = mWidth;
+        int top = mHeight;
+        int right = 0;
+        int bottom = 0;
+        for (const ExploredCell& cell : mPendingExploredCells)
+        {
+            left = std::min(left, cell.mX);
+            top = std::min(top, cell.mY);
+            right = std::max(right, cell.mX + mCellSize);
+            bottom = std::max(bottom, cell.mY + mCellSize);
+        }
+
+        osg::ref_ptr<osg::Camera> camera = createOverlayCamera(left, top, right - left, bottom - top, false, true);
+        for (const ExploredCell& cell : mPendingExploredCells)
+            addOverlayQuad(camera, cell.mX, cell.mY, mCellSize, mCellSize, cell.mTexture, 0.f, 0.f, 1.f, 1.f);
+
+        mPendingExploredCells.clear();
     }
 
     void GlobalMap::clear()
@@ -392,6 +449,7 @@ namespace MWRender
         memset(mOverlayImage->data(), 0, mOverlayImage->getTotalSizeInBytes());
 
         mPendingImageDest.clear();
+        mPendingExploredCells.clear();
 
         // just push a Camera to clear the FBO, instead of setImage()/dirty()
         // easier, since we don't need to worry about synchronizing access :)
@@ -606,6 +664,8 @@ namespace MWRender
             removeCamera(camera);
 
         mCamerasPendingRemoval.clear();
+
+        updateExploredCells();
     }
 
     void GlobalMap::removeCamera(osg::Camera *cam)
@@ -47,6 +47,8 @@ namespace MWRender
 
         void cellTopLeftCornerToImageSpace(int x, int y, float& imageX, float& imageY);
 
+        /// Draws the local map of the cell onto the overlay with the next cleanupCameras. The local map texture should
+        /// have been rendered by then.
         void exploreCell (int cellX, int cellY, osg::ref_ptr<osg::Texture2D> localMapTexture);
 
         /// Clears the overlay
@@ -56,6 +58,7 @@ namespace MWRender
          * Removes cameras that have already been rendered. Should be called every frame to ensure that
          * we do not render the same map more than once. Note, this cleanup is difficult to implement in an
          * automated fashion, since we can't alter the scene graph structure from within an update callback.
+         * Also draws the cells explored since the last call onto the overlay.
          */
         void cleanupCameras();
 
@@ -85,6 +88,15 @@ namespace MWRender
         void requestOverlayTextureUpdate(int x, int y, int width, int height, osg::ref_ptr<osg::Texture2D> texture, bool clear, bool cpuCopy,
                                          float srcLeft = 0.f, float srcTop = 0.f, float srcRight = 1.f, float srcBottom = 1.f);
 
+        /// Create a camera rendering onto the given area of mOverlayTexture, see requestOverlayTextureUpdate.
+        osg::ref_ptr<osg::Camera> createOverlayCamera(int x, int y, int width, int height, bool clear, bool cpuCopy);
+
+        /// Add a quad drawing the texture onto the given area of mOverlayTexture, within the viewport of the camera.
+        void addOverlayQuad(osg::Camera* camera, int x, int y, int width, int height, osg::ref_ptr<osg::Texture2D> texture,
+                            float srcLeft, float srcTop, float srcRight, float srcBottom);
+
+        void updateExploredCells();
+
         int mCellSize;
 
         osg::ref_ptr<osg::Group> mRoot;
@@ -113,6 +125,14 @@ namespace MWRender
 
         std::vector< std::pair<int,int> > mExploredCells;
 
+        struct ExploredCell
+        {
+            int mX, mY; // top-left coordinates on the overlay
+            osg::ref_ptr<osg::Texture2D> mTexture;
+        };
+
+        std::vector<ExploredCell> mPendingExploredCells;
+
         osg::ref_ptr<osg::Texture2D> mBaseTexture;
         osg::ref_ptr<osg::Texture2D> mAlphaTexture;
 
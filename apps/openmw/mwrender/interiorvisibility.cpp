@@ -0,0 +1,475 @@
+#include "interiorvisibility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+
+#include <osg/Drawable>
+#include <osg/Geometry>
+#include <osg/NodeVisitor>
+#include <osg/Transform>
+#include <osg/TriangleFunctor>
+#include <osg/Version>
+
+namespace
+{
+    // Voxels along the largest extent of the cell, limits the memory and time needed for large cells
+    const int sMaxGridSize = 128;
+    const float sMinVoxelSize = 32.f;
+
+    // Empty voxels per region and chunk that lines are tested between
+    const std::size_t sMaxSamples = 32;
+
+    // Empty voxels with solid ones at most this far on both sides along two axes are part of an opening
+    const int sMaxOpeningDistance = 2;
+    // Openings wider than this are split, so the line to their center passes through them from any side
+    const int sMaxOpeningExtent = 4;
+    // Cells with more openings are too cluttered to be tested in reasonable time and are not culled
+    const std::size_t sMaxOpenings = 512;
+
+    typedef std::array<int, 3> Voxel;
+
+    struct GetTrianglesFunctor
+    {
+        GetTrianglesFunctor()
+            : mTriangles(nullptr)
+        {
+        }
+
+#if OSG_MIN_VERSION_REQUIRED(3,5,6)
+        void inline operator()(const osg::Vec3 v1, const osg::Vec3 v2, const osg::Vec3 v3)
+#else
+        void inline operator()(const osg::Vec3 v1, const osg::Vec3 v2, const osg::Vec3 v3, bool _temp)
+#endif
+        {
+            mTriangles->push_back(mMatrix.preMult(v1));
+            mTriangles->push_back(mMatrix.preMult(v2));
+            mTriangles->push_back(mMatrix.preMult(v3));
+        }
+
+        std::vector<osg::Vec3f>* mTriangles;
+        osg::Matrix mMatrix;
+    };
+
+    /// Transparent and alpha tested geometry like windows, grates and plants doesn't hide what is behind it
+    bool isOpaque(const osg::NodePath& path)
+    {
+        for (osg::NodePath::const_iterator it = path.begin(); it != path.end(); ++it)
+        {
+            const osg::StateSet* stateset = (*it)->getStateSet();
+            if (!stateset)
+                continue;
+            if (stateset->getRenderingHint() == osg::StateSet::TRANSPARENT_BIN
+                    || (stateset->getMode(GL_BLEND) & osg::StateAttribute::ON)
+                    || stateset->getAttribute(osg::StateAttribute::ALPHAFUNC))
+                return false;
+        }
+        return true;
+    }
+
+    class OccluderVisitor : public osg::NodeVisitor
+    {
+    public:
+        OccluderVisitor(const osg::Matrix& matrix, std::vector<std::pair<osg::ref_ptr<const osg::Geometry>, osg::Matrix> >& geometries)
+            : osg::NodeVisitor(TRAVERSE_ACTIVE_CHILDREN)
+            , mMatrix(matrix)
+            , mGeometries(geometries)
+        {
+        }
+
+        virtual void apply(osg::Drawable& drawable)
+        {
+            // Skinned and morphed geometry changes its vertices while it is drawn
+            const osg::Geometry* geometry = drawable.asGeometry();
+            if (!geometry || !isOpaque(getNodePath()))
+                return;
+
+            mGeometries.emplace_back(geometry, osg::computeLocalToWorld(getNodePath()) * mMatrix);
+        }
+
+    private:
+        osg::Matrix mMatrix;
+        std::vector<std::pair<osg::ref_ptr<const osg::Geometry>, osg::Matrix> >& mGeometries;
+    };
+
+    class VoxelGrid
+    {
+    public:
+        VoxelGrid(const osg::BoundingBox& bounds)
+            : mOrigin(bounds._min)
+        {
+            const osg::Vec3f extent = bounds._max - bounds._min;
+            const float largest = std::max(extent.x(), std::max(extent.y(), extent.z()));
+            mVoxelSize = std::max(sMinVoxelSize, largest / sMaxGridSize);
+            for (int i=0; i<3; ++i)
+                mSize[i] = std::max(1, static_cast<int>(std::ceil(extent[i] / mVoxelSize)));
+            mSolid.resize(mSize[0] * mSize[1] * mSize[2], false);
+        }
+
+        void markTriangle(const osg::Vec3f& a, const osg::Vec3f& b, const osg::Vec3f& c)
+        {
+            // Sampled at half the voxel size, so no voxel the triangle passes through is skipped
+            const float longest = std::max((b - a).length(), std::max((c - a).length(), (c - b).length()));
+            const int steps = std::max(1, static_cast<int>(std::ceil(longest / (mVoxelSize * 0.5f))));
+            for (int i=0; i<=steps; ++i)
+            {
+                for (int j=0; j<=steps-i; ++j)
+                {
+                    const osg::Vec3f point = a + (b - a) * (i / static_cast<float>(steps)) + (c - a) * (j / static_cast<float>(steps));
+                    Voxel voxel;
+                    if (getVoxel(point, voxel))
+                        mSolid[getIndex(voxel)] = true;
+                }
+            }
+        }
+
+        /// @return Up to sMaxSamples empty voxels within the bounds, picked at random
+        std::vector<Voxel> getSamples(const osg::BoundingBox& bounds) const
+        {
+            Voxel min, max;
+            for (int i=0; i<3; ++i)
+            {
+                min[i] = std::max(0, static_cast<int>(std::floor((bounds._min[i] - mOrigin[i]) / mVoxelSize)));
+                max[i] = std::min(mSize[i] - 1, static_cast<int>(std::floor((bounds._max[i] - mOrigin[i]) / mVoxelSize)));
+            }
+
+            std::vector<Voxel> samples;
+            for (int z=min[2]; z<=max[2]; ++z)
+                for (int y=min[1]; y<=max[1]; ++y)
+                    for (int x=min[0]; x<=max[0]; ++x)
+                    {
+                        const Voxel voxel = {{x, y, z}};
+                        if (!mSolid[getIndex(voxel)])
+                            samples.push_back(voxel);
+                    }
+
+            if (samples.size() > sMaxSamples)
+            {
+                // The same seed gives the same result for the same cell
+                std::minstd_rand random;
+                for (std::size_t i=0; i<sMaxSamples; ++i)
+                    std::swap(samples[i], samples[i + random() % (samples.size() - i)]);
+                samples.resize(sMaxSamples);
+            }
+            return samples;
+        }
+
+        /// @return One empty voxel near the center of each part of the openings of the cell, like door frames, windows
+        /// and holes in walls. The lines between random samples rarely pass through narrow openings.
+        std::vector<Voxel> getOpenings() const
+        {
+            std::vector<bool> opening(mSolid.size(), false);
+            std::vector<Voxel> openingVoxels;
+            for (int z=0; z<mSize[2]; ++z)
+                for (int y=0; y<mSize[1]; ++y)
+                    for (int x=0; x<mSize[0]; ++x)
+                    {
+                        const Voxel voxel = {{x, y, z}};
+                        const std::size_t index = getIndex(voxel);
+                        if (mSolid[index])
+                            continue;
+
+                        int boundedAxes = 0;
+                        for (int axis=0; axis<3; ++axis)
+                            if (isSolidWithin(voxel, axis, -1) && isSolidWithin(voxel, axis, 1))
+                                ++boundedAxes;
+
+                        if (boundedAxes >= 2)
+                        {
+                            opening[index] = true;
+                            openingVoxels.push_back(voxel);
+                        }
+                    }
+
+            std::vector<Voxel> result;
+            std::vector<Voxel> part;
+            for (const Voxel& seed : openingVoxels)
+            {
+                if (!opening[getIndex(seed)])
+                    continue;
+
+                // Flood fill the part of the opening around the seed
+                part.assign(1, seed);
+                opening[getIndex(seed)] = false;
+                for (std::size_t i=0; i<part.size(); ++i)
+                {
+                    for (int dz=-1; dz<=1; ++dz)
+                        for (int dy=-1; dy<=1; ++dy)
+                            for (int dx=-1; dx<=1; ++dx)
+                            {
+                                const Voxel next = {{part[i][0] + dx, part[i][1] + dy, part[i][2] + dz}};
+                                if (!isInside(next) || !opening[getIndex(next)]
+                                        || std::abs(next[0] - seed[0]) > sMaxOpeningExtent
+                                        || std::abs(next[1] - seed[1]) > sMaxOpeningExtent
+                                        || std::abs(next[2] - seed[2]) > sMaxOpeningExtent)
+                                    continue;
+                                opening[getIndex(next)] = false;
+                                part.push_back(next);
+                            }
+                }
+
+                osg::Vec3f center;
+                for (const Voxel& voxel : part)
+                    center += osg::Vec3f(voxel[0], voxel[1], voxel[2]);
+                center /= static_cast<float>(part.size());
+
+                result.push_back(*std::min_element(part.begin(), part.end(), [&] (const Voxel& left, const Voxel& right)
+                {
+                    return (osg::Vec3f(left[0], left[1], left[2]) - center).length2()
+                         < (osg::Vec3f(right[0], right[1], right[2]) - center).length2();
+                }));
+            }
+            return result;
+        }
+
+        bool isLineClear(const Voxel& from, const Voxel& to) const
+        {
+            int longest = 0;
+            for (int i=0; i<3; ++i)
+                longest = std::max(longest, std::abs(to[i] - from[i]));
+
+            const int steps = longest * 2;
+            for (int step=1; step<steps; ++step)
+            {
+                const float t = step / static_cast<float>(steps);
+                Voxel voxel;
+                for (int i=0; i<3; ++i)
+                    voxel[i] = static_cast<int>(std::floor(from[i] + 0.5f + (to[i] - from[i]) * t));
+                if (mSolid[getIndex(voxel)])
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        osg::Vec3f mOrigin;
+        float mVoxelSize;
+        int mSize[3];
+        std::vector<bool> mSolid;
+
+        bool isInside(const Voxel& voxel) const
+        {
+            for (int i=0; i<3; ++i)
+                if (voxel[i] < 0 || voxel[i] >= mSize[i])
+                    return false;
+            return true;
+        }
+
+        /// @return Is there a solid voxel at most sMaxOpeningDistance voxels away from @a voxel in @a direction along @a axis?
+        bool isSolidWithin(const Voxel& voxel, int axis, int direction) const
+        {
+            Voxel next = voxel;
+            for (int distance=1; distance<=sMaxOpeningDistance; ++distance)
+            {
+                next[axis] = voxel[axis] + direction * distance;
+                if (!isInside(next))
+                    return false;
+                if (mSolid[getIndex(next)])
+                    return true;
+            }
+            return false;
+        }
+
+        bool getVoxel(const osg::Vec3f& point, Voxel& voxel) const
+        {
+            for (int i=0; i<3; ++i)
+            {
+                voxel[i] = static_cast<int>(std::floor((point[i] - mOrigin[i]) / mVoxelSize));
+                if (voxel[i] < 0 || voxel[i] >= mSize[i])
+                    return false;
+            }
+            return true;
+        }
+
+        std::size_t getIndex(const Voxel& voxel) const
+        {
+            return (static_cast<std::size_t>(voxel[2]) * mSize[1] + voxel[1]) * mSize[0] + voxel[0];
+        }
+    };
+
+    std::vector<bool> getVisibleOpenings(const VoxelGrid& grid, const std::vector<Voxel>& samples, const std::vector<Voxel>& openings)
+    {
+        std::vector<bool> visible(openings.size(), false);
+        for (std::size_t o=0; o<openings.size(); ++o)
+            for (std::size_t s=0; s<samples.size() && !visible[o]; ++s)
+                visible[o] = grid.isLineClear(samples[s], openings[o]);
+        return visible;
+    }
+
+    bool isAdjacent(const MWRender::ChunkKey& first, const MWRender::ChunkKey& second)
+    {
+        return std::abs(std::get<0>(first) - std::get<0>(second)) <= 1
+            && std::abs(std::get<1>(first) - std::get<1>(second)) <= 1
+            && std::abs(std::get<2>(first) - std::get<2>(second)) <= 1;
+    }
+}
+
+namespace MWRender
+{
+
+    ChunkKey getChunkKey(const osg::Vec3f& position, float chunkSize)
+    {
+        return ChunkKey(static_cast<int>(std::floor(position.x() / chunkSize)),
+                        static_cast<int>(std::floor(position.y() / chunkSize)),
+                        static_cast<int>(std::floor(position.z() / chunkSize)));
+    }
+
+    bool InteriorVisibility::isVisible(const osg::Vec3f& eyePoint, const ChunkKey& chunk) const
+    {
+        std::map<ChunkKey, std::set<ChunkKey> >::const_iterator region = mVisibleChunks.find(getChunkKey(eyePoint, mChunkSize));
+        if (region == mVisibleChunks.end())
+            return true;
+        return region->second.count(chunk) != 0;
+    }
+
+    void ChunkVisibility::set(std::shared_ptr<const InteriorVisibility> visibility)
+    {
+        std::atomic_store(&mVisibility, visibility);
+    }
+
+    bool ChunkVisibility::isVisible(const osg::Vec3f& eyePoint, const ChunkKey& chunk) const
+    {
+        std::shared_ptr<const InteriorVisibility> visibility = std::atomic_load(&mVisibility);
+        return !visibility || visibility->isVisible(eyePoint, chunk);
+    }
+
+    InteriorVisibilityBuilder::InteriorVisibilityBuilder(float chunkSize)
+        : mChunkSize(chunkSize)
+        , mAborted(false)
+    {
+    }
+
+    InteriorVisibilityBuilder::~InteriorVisibilityBuilder()
+    {
+    }
+
+    void InteriorVisibilityBuilder::addOccluder(osg::Node& node, const osg::Matrix& matrix)
+    {
+        // Traversed regardless of the node mask of the root, which is hidden while the object is drawn by instancing
+        OccluderVisitor visitor(matrix, mOccluders);
+        visitor.pushOntoNodePath(&node);
+        node.traverse(visitor);
+        visitor.popFromNodePath();
+    }
+
+    void InteriorVisibilityBuilder::addChunk(const ChunkKey& key, const osg::BoundingBox& bounds)
+    {
+        if (bounds.valid())
+            mChunks.push_back(Chunk {key, bounds});
+    }
+
+    void InteriorVisibilityBuilder::doWork()
+    {
+        std::shared_ptr<InteriorVisibility> result = std::make_shared<InteriorVisibility>();
+        result->mChunkSize = mChunkSize;
+
+        osg::BoundingBox bounds;
+        for (const Chunk& chunk : mChunks)
+        {
+            bounds.expandBy(chunk.mBounds);
+            result->mChunks.insert(chunk.mKey);
+        }
+
+        if (!bounds.valid())
+        {
+            mResult = result;
+            return;
+        }
+
+        VoxelGrid grid(bounds);
+        std::vector<osg::Vec3f> triangles;
+        for (const auto& occluder : mOccluders)
+        {
+            if (mAborted)
+                return;
+
+            osg::TriangleFunctor<GetTrianglesFunctor> functor;
+            functor.mTriangles = &triangles;
+            functor.mMatrix = occluder.second;
+            occluder.first->accept(functor);
+
+            for (std::size_t i=0; i+2<triangles.size(); i+=3)
+                grid.markTriangle(triangles[i], triangles[i+1], triangles[i+2]);
+            triangles.clear();
+        }
+
+        const std::vector<Voxel> openings = grid.getOpenings();
+        if (openings.size() > sMaxOpenings)
+        {
+            // No regions, everything stays visible
+            mResult = result;
+            return;
+        }
+
+        // Which openings the samples of each chunk can see
+        std::vector<std::vector<Voxel> > targets;
+        std::vector<std::vector<bool> > targetOpenings;
+        targets.reserve(mChunks.size());
+        targetOpenings.reserve(mChunks.size());
+        for (const Chunk& chunk : mChunks)
+        {
+            if (mAborted)
+                return;
+            targets.push_back(grid.getSamples(chunk.mBounds));
+            targetOpenings.push_back(getVisibleOpenings(grid, targets.back(), openings));
+        }
+
+        const ChunkKey minKey = getChunkKey(bounds._min, mChunkSize);
+        const ChunkKey maxKey = getChunkKey(bounds._max, mChunkSize);
+        for (int z=std::get<2>(minKey); z<=std::get<2>(maxKey); ++z)
+            for (int y=std::get<1>(minKey); y<=std::get<1>(maxKey); ++y)
+                for (int x=std::get<0>(minKey); x<=std::get<0>(maxKey); ++x)
+                {
+                    if (mAborted)
+                        return;
+
+                    const ChunkKey region (x, y, z);
+                    const osg::BoundingBox regionBounds (osg::Vec3f(x, y, z) * mChunkSize, osg::Vec3f(x+1, y+1, z+1) * mChunkSize);
+
+                    // The camera can't be in a region without empty voxels, unless it clips through walls
+                    const std::vector<Voxel> sources = grid.getSamples(regionBounds.intersect(bounds));
+                    if (sources.empty())
+                        continue;
+
+                    const std::vector<bool> sourceOpenings = getVisibleOpenings(grid, sources, openings);
+
+                    std::set<ChunkKey>& visible = result->mVisibleChunks[region];
+                    for (std::size_t i=0; i<mChunks.size(); ++i)
+                    {
+                        // Too close to be hidden reliably, and chunks without empty voxels can't be tested
+                        if (isAdjacent(region, mChunks[i].mKey) || targets[i].empty())
+                        {
+                            visible.insert(mChunks[i].mKey);
+                            continue;
+                        }
+
+                        // A line through an opening is clear on both sides of it
+                        bool clear = false;
+                        for (std::size_t o=0; o<openings.size() && !clear; ++o)
+                            clear = sourceOpenings[o] && targetOpenings[i][o];
+
+                        for (std::size_t s=0; s<sources.size() && !clear; ++s)
+                            for (std::size_t t=0; t<targets[i].size() && !clear; ++t)
+                                clear = grid.isLineClear(sources[s], targets[i][t]);
+
+                        if (clear)
+                            visible.insert(mChunks[i].mKey);
+                    }
+                }
+
+        mResult = result;
+    }
+
+    void InteriorVisibilityBuilder::abort()
+    {
+        mAborted = true;
+    }
+
+    std::shared_ptr<const InteriorVisibility> InteriorVisibilityBuilder::getResult() const
+    {
+        return mResult;
+    }
+
+}
@@ -0,0 +1,101 @@
+#ifndef OPENMW_MWRENDER_INTERIORVISIBILITY_H
+#define OPENMW_MWRENDER_INTERIORVISIBILITY_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <osg/BoundingBox>
+#include <osg/Matrix>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <components/sceneutil/workqueue.hpp>
+
+namespace osg
+{
+    class Geometry;
+    class Node;
+}
+
+namespace MWRender
+{
+
+    /// Index of a chunk-sized cube of the cell, the same for all objects within it
+    typedef std::tuple<int, int, int> ChunkKey;
+
+    ChunkKey getChunkKey(const osg::Vec3f& position, float chunkSize);
+
+    /// @brief Which object chunks of an interior cell can be seen from each chunk-sized region of the cell
+    struct InteriorVisibility
+    {
+        float mChunkSize;
+
+        /// The chunks the visibility was computed for, cached results are only valid for the same chunks
+        std::set<ChunkKey> mChunks;
+
+        /// Chunks that may be visible from a region, regions without an entry may see all of them
+        std::map<ChunkKey, std::set<ChunkKey> > mVisibleChunks;
+
+        bool isVisible(const osg::Vec3f& eyePoint, const ChunkKey& chunk) const;
+    };
+
+    /// @brief The visibility of a cell shared by the cull callbacks of its chunks, set once it is computed
+    class ChunkVisibility : public osg::Referenced
+    {
+    public:
+        void set(std::shared_ptr<const InteriorVisibility> visibility);
+
+        /// @return true until the visibility is computed
+        bool isVisible(const osg::Vec3f& eyePoint, const ChunkKey& chunk) const;
+
+    private:
+        std::shared_ptr<const InteriorVisibility> mVisibility;
+    };
+
+    /// @brief Computes the InteriorVisibility of a cell in the background
+    ///
+    /// The opaque geometry of the static objects is rasterized into a voxel grid. A region of the cell sees a chunk if it
+    /// is next to it, if a line between empty voxels sampled from both passes through empty voxels only, or if both see
+    /// the same opening, like a door frame or a hole in a wall. Doors and other non-static objects are ignored, so opening
+    /// a door doesn't change the result.
+    class InteriorVisibilityBuilder : public SceneUtil::WorkItem
+    {
+    public:
+        InteriorVisibilityBuilder(float chunkSize);
+        ~InteriorVisibilityBuilder();
+
+        /// Add the opaque geometry of the subgraph, transformed by @a matrix. Its triangles are read in doWork().
+        /// Must be called before the item is queued.
+        void addOccluder(osg::Node& node, const osg::Matrix& matrix);
+
+        /// Must be called before the item is queued.
+        void addChunk(const ChunkKey& key, const osg::BoundingBox& bounds);
+
+        virtual void doWork();
+
+        virtual void abort();
+
+        /// @return nullptr until the work is done
+        std::shared_ptr<const InteriorVisibility> getResult() const;
+
+    private:
+        struct Chunk
+        {
+            ChunkKey mKey;
+            osg::BoundingBox mBounds;
+        };
+
+        float mChunkSize;
+        std::vector<std::pair<osg::ref_ptr<const osg::Geometry>, osg::Matrix> > mOccluders;
+        std::vector<Chunk> mChunks;
+        std::atomic<bool> mAborted;
+        std::shared_ptr<const InteriorVisibility> mResult;
+    };
+
+}
+
+#endif
@@ -29,7 +29,7 @@ osg::ref_ptr<ESMTerrain::LandObject> LandManager::getLand(int x, int y)
         if (!land)
             return nullptr;
         osg::ref_ptr<ESMTerrain::LandObject> landObj (new ESMTerrain::LandObject(land, mLoadFlags));
-        mCache->addEntryToObjectCache(std::make_pair(x,y), landObj.get());
+        mCache->addEntryToObjectCache(std::make_pair(x,y), landObj.get(), 0.0, sizeof(ESMTerrain::LandObject));
         return landObj;
     }
 }
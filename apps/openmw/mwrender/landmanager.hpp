@@ -23,6 +23,8 @@ namespace MWRender
         /// @note Will return nullptr if not found.
         osg::ref_ptr<ESMTerrain::LandObject> getLand(int x, int y);
 
+        virtual const char* getName() const { return "Land"; }
+
         virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
 
     private:
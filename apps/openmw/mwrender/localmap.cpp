@@ -1,6 +1,7 @@
 #include "localmap.hpp"
 
 #include <stdint.h>
+#include <algorithm>
 
 #include <osg/Fog>
 #include <osg/LightModel>
@@ -72,6 +73,7 @@ namespace MWRender
 
 LocalMap::LocalMap(osg::Group* root)
     : mRoot(root)
+    , mMaxRendersPerFrame(std::max(Settings::Manager::getInt("local map renders per frame", "Map"), 1))
     , mMapResolution(Settings::Manager::getInt("local map resolution", "Map"))
     , mMapWorldSize(Constants::CellSizeInUnits)
     , mCellDistance(Settings::Manager::getInt("local map cell distance", "Map"))
@@ -181,6 +183,19 @@ osg::ref_ptr<osg::Camera> LocalMap::createOrthographicCamera(float x, float y, f
     camera->setCullMask(Mask_Scene | Mask_SimpleWater | Mask_Terrain | Mask_Object | Mask_Static);
     camera->setNodeMask(Mask_RenderToTexture);
 
+    camera->setStateSet(getCameraStateSet());
+    camera->addChild(mCameraLightSource);
+    camera->setViewport(0, 0, mMapResolution, mMapResolution);
+    camera->setUpdateCallback(new CameraLocalUpdateCallback(this));
+
+    return camera;
+}
+
+osg::StateSet* LocalMap::getCameraStateSet()
+{
+    if (mCameraStateSet)
+        return mCameraStateSet;
+
     osg::ref_ptr<osg::StateSet> stateset = new osg::StateSet;
     stateset->setAttribute(new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::FILL), osg::StateAttribute::OVERRIDE);
 
@@ -212,12 +227,9 @@ osg::ref_ptr<osg::Camera> LocalMap::createOrthographicCamera(float x, float y, f
 
     SceneUtil::ShadowManager::disableShadowsForStateSet(stateset);
 
-    camera->addChild(lightSource);
-    camera->setStateSet(stateset);
-    camera->setViewport(0, 0, mMapResolution, mMapResolution);
-    camera->setUpdateCallback(new CameraLocalUpdateCallback(this));
-
-    return camera;
+    mCameraLightSource = lightSource;
+    mCameraStateSet = stateset;
+    return mCameraStateSet;
 }
 
 void LocalMap::setupRenderToTexture(osg::ref_ptr<osg::Camera> camera, int x, int y)
@@ -233,8 +245,12 @@ void LocalMap::setupRenderToTexture(osg::ref_ptr<osg::Camera> camera, int x, int
     camera->attach(osg::Camera::COLOR_BUFFER, texture);
 
     camera->addChild(mSceneRoot);
-    mRoot->addChild(camera);
-    mActiveCameras.push_back(camera);
+
+    // A newer request replaces the render of the segment that has not started yet
+    const std::pair<int, int> coords(x, y);
+    mCamerasPendingRender.erase(std::remove_if(mCamerasPendingRender.begin(), mCamerasPendingRender.end(),
+        [&] (const CameraQueue::value_type& pending) { return pending.first == coords; }), mCamerasPendingRender.end());
+    mCamerasPendingRender.emplace_back(coords, camera);
 
     MapSegment& segment = mSegments[std::make_pair(x, y)];
     segment.mMapTexture = texture;
@@ -291,9 +307,14 @@ void LocalMap::removeCell(MWWorld::CellStore *cell)
         std::pair<int, int> coords = std::make_pair(cell->getCell()->getGridX(), cell->getCell()->getGridY());
         mSegments.erase(coords);
         mCurrentGrid.erase(coords);
+        mCamerasPendingRender.erase(std::remove_if(mCamerasPendingRender.begin(), mCamerasPendingRender.end(),
+            [&] (const CameraQueue::value_type& pending) { return pending.first == coords; }), mCamerasPendingRender.end());
     }
     else
+    {
         mSegments.clear();
+        mCamerasPendingRender.clear();
+    }
 }
 
 osg::ref_ptr<osg::Texture2D> LocalMap::getMapTexture(int x, int y)
@@ -314,6 +335,13 @@ osg::ref_ptr<osg::Texture2D> LocalMap::getFogOfWarTexture(int x, int y)
         return found->second.mFogOfWarTexture;
 }
 
+bool LocalMap::isRenderPending(int x, int y) const
+{
+    const std::pair<int, int> coords(x, y);
+    return std::find_if(mCamerasPendingRender.begin(), mCamerasPendingRender.end(),
+        [&] (const CameraQueue::value_type& pending) { return pending.first == coords; }) != mCamerasPendingRender.end();
+}
+
 void LocalMap::removeCamera(osg::Camera *cam)
 {
     cam->removeChildren(0, cam->getNumChildren());
@@ -334,13 +362,19 @@ void LocalMap::markForRemoval(osg::Camera *cam)
 
 void LocalMap::cleanupCameras()
 {
-    if (mCamerasPendingRemoval.empty())
-        return;
-
     for (auto& camera : mCamerasPendingRemoval)
         removeCamera(camera);
 
     mCamerasPendingRemoval.clear();
+
+    // Spread the renders of newly loaded cells over several frames, each of them draws the whole scene
+    for (int i = 0; i < mMaxRendersPerFrame && !mCamerasPendingRender.empty(); ++i)
+    {
+        osg::ref_ptr<osg::Camera> camera = mCamerasPendingRender.front().second;
+        mCamerasPendingRender.pop_front();
+        mRoot->addChild(camera);
+        mActiveCameras.push_back(camera);
+    }
 }
 
 void LocalMap::requestExteriorMap(const MWWorld::CellStore* cell)
@@ -1,6 +1,7 @@
 #ifndef GAME_RENDER_LOCALMAP_H
 #define GAME_RENDER_LOCALMAP_H
 
+#include <deque>
 #include <set>
 #include <vector>
 #include <map>
@@ -26,6 +27,7 @@ namespace osg
     class Camera;
     class Group;
     class Node;
+    class StateSet;
 }
 
 namespace MWRender
@@ -57,6 +59,9 @@ namespace MWRender
 
         osg::ref_ptr<osg::Texture2D> getFogOfWarTexture (int x, int y);
 
+        /// Is the map texture of the segment still waiting for its camera to be added to the scene?
+        bool isRenderPending (int x, int y) const;
+
         void removeCamera(osg::Camera* cam);
 
         /**
@@ -68,6 +73,7 @@ namespace MWRender
          * Removes cameras that have already been rendered. Should be called every frame to ensure that
          * we do not render the same map more than once. Note, this cleanup is difficult to implement in an
          * automated fashion, since we can't alter the scene graph structure from within an update callback.
+         * Also adds the next queued cameras to the scene, up to the number of renders allowed per frame.
          */
         void cleanupCameras();
 
@@ -109,6 +115,11 @@ namespace MWRender
 
         CameraVector mCamerasPendingRemoval;
 
+        // Cameras waiting to be added to the scene, with the segment they render
+        typedef std::deque<std::pair<std::pair<int, int>, osg::ref_ptr<osg::Camera> > > CameraQueue;
+        CameraQueue mCamerasPendingRender;
+        int mMaxRendersPerFrame;
+
         typedef std::set<std::pair<int, int> > Grid;
         Grid mCurrentGrid;
 
@@ -151,6 +162,10 @@ namespace MWRender
         void requestInteriorMap(const MWWorld::CellStore* cell);
 
         osg::ref_ptr<osg::Camera> createOrthographicCamera(float left, float top, float width, float height, const osg::Vec3d& upVector, float zmin, float zmax);
+        /// Lighting and fog shared by all map cameras, so every cell change doesn't set them up again
+        osg::StateSet* getCameraStateSet();
+        osg::ref_ptr<osg::StateSet> mCameraStateSet;
+        osg::ref_ptr<osg::Node> mCameraLightSource;
         void setupRenderToTexture(osg::ref_ptr<osg::Camera> camera, int x, int y);
 
         bool mInterior;
@@ -292,6 +292,7 @@ NpcAnimation::~NpcAnimation()
 NpcAnimation::NpcAnimation(const MWWorld::Ptr& ptr, osg::ref_ptr<osg::Group> parentNode, Resource::ResourceSystem* resourceSystem,
                            bool disableSounds, ViewMode viewMode, float firstPersonFieldOfView)
   : ActorAnimation(ptr, parentNode, resourceSystem),
+    mKeepRemovedParts(false),
     mViewMode(viewMode),
     mShowWeapons(false),
     mShowCarriedLeft(true),
@@ -601,6 +602,9 @@ void NpcAnimation::updateParts()
     bool wasArrowAttached = isArrowAttached();
     mAmmunition.reset();
 
+    // Unchanged equipment and body parts are removed and added again below, keep their nodes to reuse them
+    mKeepRemovedParts = true;
+
     const MWWorld::InventoryStore& inv = mPtr.getClass().getInventoryStore(mPtr);
     for(size_t i = 0;i < slotlistsize && mViewMode != VM_HeadOnly;i++)
     {
@@ -657,7 +661,10 @@ void NpcAnimation::updateParts()
             addOrReplaceIndividualPart(ESM::PRT_Hair, -1,1, mHairModel);
     }
     if(mViewMode == VM_HeadOnly)
+    {
+        discardRemovedParts();
         return;
+    }
 
     if(mPartPriorities[ESM::PRT_Shield] < 1)
     {
@@ -691,6 +698,8 @@ void NpcAnimation::updateParts()
         }
     }
 
+    discardRemovedParts();
+
     if (wasArrowAttached)
         attachArrow();
 }
@@ -742,7 +751,12 @@ void NpcAnimation::removeIndividualPart(ESM::PartReferenceType type)
     mPartPriorities[type] = 0;
     mPartslots[type] = -1;
 
+    if (mKeepRemovedParts && mObjectParts[type] && !mPartMeshes[type].empty())
+        mRemovedParts[type] = RemovedPart {std::move(mObjectParts[type]), mPartMeshes[type], mPartBoneNames[type]};
+
     mObjectParts[type].reset();
+    mPartMeshes[type].clear();
+    mPartBoneNames[type].clear();
     if (!mSoundIds[type].empty() && !mSoundsDisabled)
     {
         MWBase::Environment::get().getSoundManager()->stopSound3D(mPtr, mSoundIds[type]);
@@ -750,6 +764,14 @@ void NpcAnimation::removeIndividualPart(ESM::PartReferenceType type)
     }
 }
 
+void NpcAnimation::discardRemovedParts()
+{
+    mKeepRemovedParts = false;
+
+    for (RemovedPart& removed : mRemovedParts)
+        removed.mPart.reset();
+}
+
 void NpcAnimation::reserveIndividualPart(ESM::PartReferenceType type, int group, int priority)
 {
     if(priority > mPartPriorities[type])
@@ -811,7 +833,20 @@ bool NpcAnimation::addOrReplaceIndividualPart(ESM::PartReferenceType type, int g
 
         // PRT_Hair seems to be the only type that breaks consistency and uses a filter that's different from the attachment bone
         const std::string bonefilter = (type == ESM::PRT_Hair) ? "hair" : bonename;
-        mObjectParts[type] = insertBoundedPart(mesh, bonename, bonefilter, enchantedGlow, glowColor);
+
+        // Glowing parts, weapons and shields get more changes after they are added, they are always recreated
+        const bool reusable = !enchantedGlow && type != ESM::PRT_Weapon && type != ESM::PRT_Shield;
+        RemovedPart& removed = mRemovedParts[type];
+        if (reusable && removed.mPart && removed.mMesh == mesh && removed.mBoneName == bonename)
+            mObjectParts[type] = std::move(removed.mPart);
+        else
+            mObjectParts[type] = insertBoundedPart(mesh, bonename, bonefilter, enchantedGlow, glowColor);
+
+        if (reusable)
+        {
+            mPartMeshes[type] = mesh;
+            mPartBoneNames[type] = bonename;
+        }
     }
     catch (std::exception& e)
     {
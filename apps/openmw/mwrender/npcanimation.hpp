@@ -42,6 +42,21 @@ private:
     PartHolderPtr mObjectParts[ESM::PRT_Count];
     std::string mSoundIds[ESM::PRT_Count];
 
+    // Mesh and bone of the bounded parts that can be reused, empty for the others
+    std::string mPartMeshes[ESM::PRT_Count];
+    std::string mPartBoneNames[ESM::PRT_Count];
+
+    struct RemovedPart
+    {
+        PartHolderPtr mPart;
+        std::string mMesh;
+        std::string mBoneName;
+    };
+
+    // Parts removed by updateParts, kept until it ends to reuse them when the same part is added again
+    RemovedPart mRemovedParts[ESM::PRT_Count];
+    bool mKeepRemovedParts;
+
     const ESM::NPC *mNpc;
     std::string    mHeadModel;
     std::string    mHairModel;
@@ -80,6 +95,7 @@ private:
                                         const std::string &bonefilter, bool enchantedGlow, osg::Vec4f* glowColor=nullptr);
 
     void removeIndividualPart(ESM::PartReferenceType type);
+    void discardRemovedParts();
     void reserveIndividualPart(ESM::PartReferenceType type, int group, int priority);
 
     bool addOrReplaceIndividualPart(ESM::PartReferenceType type, int group, int priority, const std::string &mesh,
@@ -0,0 +1,612 @@
+#include "objectinstancing.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/MatrixTransform>
+
+#include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/optimizer.hpp>
+#include <components/sceneutil/workqueue.hpp>
+
+#include "util.hpp"
+
+namespace
+{
+    struct Part
+    {
+        osg::ref_ptr<osg::Geometry> mGeometry;
+        std::vector<osg::ref_ptr<osg::StateSet>> mStateSets;
+        osg::Matrixf mMatrix;
+    };
+
+    struct InstancesBoundingBoxCallback : osg::Drawable::ComputeBoundingBoxCallback
+    {
+        osg::BoundingBox mBoundingBox;
+
+        InstancesBoundingBoxCallback(const osg::BoundingBox& boundingBox) : mBoundingBox(boundingBox) {}
+
+        virtual osg::BoundingBox computeBound(const osg::Drawable&) const override { return mBoundingBox; }
+    };
+
+    bool hasCallbacks(const osg::StateSet* stateset)
+    {
+        return stateset != nullptr && (stateset->getUpdateCallback() || stateset->getEventCallback());
+    }
+
+    /// Collects geometries of a subgraph together with their transforms and inherited statesets.
+    /// @return false if the subgraph contains anything that can change over time or can't be drawn instanced.
+    bool collectParts(osg::Node& node, osg::Matrixf matrix, bool isRoot, std::vector<osg::ref_ptr<osg::StateSet>>& stateSets,
+                      std::vector<Part>& parts)
+    {
+        // Hidden nodes, e.g. collision shapes
+        if (node.getNodeMask() == 0)
+            return true;
+        if (node.getNodeMask() != ~0u)
+            return false;
+
+        if (node.getUpdateCallback() || node.getEventCallback() || hasCallbacks(node.getStateSet()))
+            return false;
+
+        // Object root has a light list callback which is replaced by one per batch
+        if (osg::Callback* callback = node.getCullCallback())
+        {
+            if (!isRoot || !dynamic_cast<SceneUtil::LightListCallback*>(callback) || callback->getNestedCallback())
+                return false;
+        }
+
+        if (osg::Geometry* geometry = node.asGeometry())
+        {
+            if (node.className() != std::string("Geometry") || geometry->getDrawCallback())
+                return false;
+            parts.push_back(Part {geometry, stateSets, matrix});
+            return true;
+        }
+
+        osg::Group* group = node.asGroup();
+        if (!group)
+            return false;
+
+        if (osg::MatrixTransform* trans = dynamic_cast<osg::MatrixTransform*>(group))
+        {
+            if (trans->getReferenceFrame() != osg::Transform::RELATIVE_RF)
+                return false;
+            matrix = osg::Matrixf(trans->getMatrix()) * matrix;
+        }
+        else if (node.className() != std::string("Group"))
+            return false;
+
+        if (node.getStateSet())
+            stateSets.push_back(node.getStateSet());
+
+        for (unsigned int i = 0; i < group->getNumChildren(); ++i)
+        {
+            if (!collectParts(*group->getChild(i), matrix, false, stateSets, parts))
+                return false;
+        }
+
+        if (node.getStateSet())
+            stateSets.pop_back();
+
+        return true;
+    }
+
+    std::size_t getDataSize(const osg::Geometry& geometry)
+    {
+        std::size_t size = 0;
+
+        osg::Geometry::ArrayList arrays;
+        geometry.getArrayList(arrays);
+        for (const auto& array : arrays)
+            size += array->getTotalDataSize();
+
+        osg::Geometry::DrawElementsList primitives;
+        geometry.getDrawElementsList(primitives);
+        for (const osg::DrawElements* primitive : primitives)
+            size += primitive->getTotalDataSize();
+
+        return size;
+    }
+
+    /// Keeps the data of a merge key referenced, so its pointers can't be reused while the merged group exists.
+    struct MergeSources : osg::Referenced
+    {
+        std::vector<osg::ref_ptr<osg::StateSet>> mStateSets;
+        std::vector<osg::ref_ptr<osg::Geometry>> mGeometries;
+    };
+}
+
+namespace MWRender
+{
+
+    class MergeItem : public SceneUtil::WorkItem
+    {
+    public:
+        struct Source
+        {
+            osg::ref_ptr<osg::Geometry> mGeometry;
+            osg::Matrixf mMatrix;
+        };
+
+        MergeItem(const std::string& key, const std::vector<osg::ref_ptr<osg::StateSet>>& stateSets,
+                  const std::vector<Source>& sources)
+            : mKey(key)
+            , mStateSets(stateSets)
+            , mSources(sources)
+            , mSize(0)
+            , mAborted(false)
+        {
+        }
+
+        virtual void doWork() override
+        {
+            // Keep vertices close to the origin to not lose precision in large exteriors
+            const osg::Vec3f origin = mSources.front().mMatrix.getTrans();
+            const osg::Matrixf toOrigin = osg::Matrixf::translate(-origin);
+
+            osg::ref_ptr<osg::Group> group (new osg::Group);
+            osg::ref_ptr<MergeSources> sources (new MergeSources);
+            sources->mStateSets = mStateSets;
+            for (const Source& source : mSources)
+            {
+                if (mAborted)
+                    return;
+
+                osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry(*source.mGeometry,
+                    osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES));
+                transformGeometry(*geometry, source.mMatrix * toOrigin);
+                group->addChild(geometry);
+                sources->mGeometries.push_back(source.mGeometry);
+            }
+
+            SceneUtil::Optimizer::MergeGeometryVisitor visitor;
+            visitor.mergeGroup(*group);
+
+            if (mAborted)
+                return;
+
+            osg::ref_ptr<osg::MatrixTransform> result (new osg::MatrixTransform(osg::Matrix::translate(origin)));
+            result->setName("Merged Objects");
+            result->setUserData(sources);
+            for (unsigned int i = 0; i < group->getNumChildren(); ++i)
+            {
+                osg::Node* child = group->getChild(i);
+                if (osg::Geometry* geometry = child->asGeometry())
+                    mSize += getDataSize(*geometry);
+
+                // Lights are still picked per merged geometry
+                osg::ref_ptr<osg::Group> lightGroup (new osg::Group);
+                lightGroup->addCullCallback(new SceneUtil::LightListCallback);
+                lightGroup->addChild(child);
+                result->addChild(lightGroup);
+            }
+
+            mResult = result;
+        }
+
+        virtual void abort() override
+        {
+            mAborted = true;
+        }
+
+        const std::string& getKey() const
+        {
+            return mKey;
+        }
+
+        /// Only valid when isDone(), nullptr if aborted.
+        osg::Group* getResult()
+        {
+            return mResult.get();
+        }
+
+        /// Estimated memory used by the result, in bytes.
+        std::size_t getSize() const
+        {
+            return mSize;
+        }
+
+    private:
+        std::string mKey;
+        std::vector<osg::ref_ptr<osg::StateSet>> mStateSets;
+        std::vector<Source> mSources;
+        std::size_t mSize;
+        std::atomic<bool> mAborted;
+        osg::ref_ptr<osg::Group> mResult;
+    };
+
+    namespace
+    {
+        std::string makeMergeKey(const std::vector<osg::ref_ptr<osg::StateSet>>& stateSets, const std::vector<MergeItem::Source>& sources)
+        {
+            std::string key;
+            for (const auto& stateSet : stateSets)
+            {
+                const osg::StateSet* pointer = stateSet.get();
+                key.append(reinterpret_cast<const char*>(&pointer), sizeof(pointer));
+            }
+            for (const MergeItem::Source& source : sources)
+            {
+                const osg::Geometry* pointer = source.mGeometry.get();
+                key.append(reinterpret_cast<const char*>(&pointer), sizeof(pointer));
+                key.append(reinterpret_cast<const char*>(source.mMatrix.ptr()), 16 * sizeof(float));
+            }
+            return key;
+        }
+    }
+
+    MergedObjectsCache::MergedObjectsCache()
+        : Resource::GenericResourceManager<std::string>(nullptr)
+    {
+    }
+
+    osg::ref_ptr<osg::Group> MergedObjectsCache::get(const std::string& key)
+    {
+        return static_cast<osg::Group*>(mCache->getRefFromObjectCache(key).get());
+    }
+
+    void MergedObjectsCache::add(const std::string& key, osg::Group* merged, std::size_t size)
+    {
+        mCache->addEntryToObjectCache(key, merged, 0.0, size);
+    }
+
+    ObjectInstancing::ObjectInstancing(osg::Group* cellNode, MergedObjectsCache* mergedObjectsCache, SceneUtil::WorkQueue* workQueue)
+        : mCellNode(cellNode)
+        , mMergedObjectsCache(workQueue ? mergedObjectsCache : nullptr)
+        , mWorkQueue(workQueue)
+        , mNumPendingMerges(0)
+        , mDirty(false)
+    {
+    }
+
+    ObjectInstancing::~ObjectInstancing()
+    {
+        for (auto& group : mMergeGroups)
+        {
+            if (group.second.mPending)
+                group.second.mPending->abort();
+            if (group.second.mRoot)
+                mCellNode->removeChild(group.second.mRoot);
+        }
+        for (auto& batch : mBatches)
+        {
+            if (batch.second.mRoot)
+                mCellNode->removeChild(batch.second.mRoot);
+        }
+    }
+
+    bool ObjectInstancing::add(const MWWorld::ConstPtr& ptr, osg::Node* baseNode, osg::Group* objectRoot)
+    {
+        if (!baseNode->asTransform() || mObjects.find(ptr) != mObjects.end())
+            return false;
+
+        std::vector<osg::ref_ptr<osg::StateSet>> stateSets;
+        std::vector<Part> parts;
+        if (!collectParts(*objectRoot, osg::Matrixf(), true, stateSets, parts) || parts.empty())
+            return false;
+
+        Object& object = mObjects[ptr];
+        object.mBaseNode = baseNode;
+        object.mObjectRoot = objectRoot;
+        object.mNodeMask = objectRoot->getNodeMask();
+
+        for (const Part& part : parts)
+        {
+            BatchKey key;
+            key.first = part.mGeometry.get();
+            for (const auto& stateSet : part.mStateSets)
+                key.second.push_back(stateSet.get());
+
+            Batch& batch = mBatches[key];
+            if (!batch.mGeometry)
+            {
+                batch.mGeometry = part.mGeometry;
+                batch.mStateSets = part.mStateSets;
+            }
+            batch.mInstances.emplace_back(ptr, part.mMatrix);
+            batch.mDirty = true;
+
+            if (std::find(object.mBatches.begin(), object.mBatches.end(), key) == object.mBatches.end())
+                object.mBatches.push_back(key);
+        }
+
+        objectRoot->setNodeMask(0);
+        mDirty = true;
+        return true;
+    }
+
+    void ObjectInstancing::remove(const MWWorld::ConstPtr& ptr)
+    {
+        auto found = mObjects.find(ptr);
+        if (found == mObjects.end())
+            return;
+
+        for (const BatchKey& key : found->second.mBatches)
+        {
+            Batch& batch = mBatches[key];
+            batch.mInstances.erase(std::remove_if(batch.mInstances.begin(), batch.mInstances.end(),
+                [&] (const std::pair<MWWorld::ConstPtr, osg::Matrixf>& instance) { return instance.first == ptr; }),
+                batch.mInstances.end());
+            batch.mDirty = true;
+        }
+
+        found->second.mObjectRoot->setNodeMask(found->second.mNodeMask);
+        mObjects.erase(found);
+        mDirty = true;
+    }
+
+    void ObjectInstancing::updatePtr(const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& cur)
+    {
+        auto found = mObjects.find(old);
+        if (found == mObjects.end())
+            return;
+
+        Object object = found->second;
+        mObjects.erase(found);
+
+        for (const BatchKey& key : object.mBatches)
+        {
+            for (auto& instance : mBatches[key].mInstances)
+            {
+                if (instance.first == old)
+                    instance.first = cur;
+            }
+        }
+
+        mObjects[cur] = object;
+    }
+
+    void ObjectInstancing::markDirty(const MWWorld::ConstPtr& ptr)
+    {
+        auto found = mObjects.find(ptr);
+        if (found == mObjects.end())
+            return;
+
+        for (const BatchKey& key : found->second.mBatches)
+            mBatches[key].mDirty = true;
+        mDirty = true;
+    }
+
+    void ObjectInstancing::update()
+    {
+        if (mDirty)
+        {
+            mDirty = false;
+
+            for (auto it = mBatches.begin(); it != mBatches.end();)
+            {
+                if (it->second.mDirty)
+                {
+                    markMergeGroupDirty(it->first.second);
+                    rebuild(it->second);
+                }
+
+                if (it->second.mInstances.empty())
+                    it = mBatches.erase(it);
+                else
+                    ++it;
+            }
+
+            if (mMergedObjectsCache)
+            {
+                for (const auto& batch : mBatches)
+                {
+                    if (batch.second.mInstances.size() != 1 || !canMergeGeometry(*batch.second.mGeometry))
+                        continue;
+                    auto group = mMergeGroups.find(batch.first.second);
+                    if (group != mMergeGroups.end() && group->second.mDirty)
+                        group->second.mMembers.push_back(batch.first);
+                }
+
+                for (auto it = mMergeGroups.begin(); it != mMergeGroups.end();)
+                {
+                    if (it->second.mDirty)
+                        merge(it->second);
+
+                    if (!it->second.mRoot && !it->second.mPending)
+                        it = mMergeGroups.erase(it);
+                    else
+                        ++it;
+                }
+            }
+        }
+
+        if (mNumPendingMerges == 0)
+            return;
+
+        for (auto& group : mMergeGroups)
+        {
+            if (!group.second.mPending || !group.second.mPending->isDone())
+                continue;
+
+            osg::ref_ptr<MergeItem> item = group.second.mPending;
+            group.second.mPending = nullptr;
+            --mNumPendingMerges;
+            if (!item->getResult())
+                continue;
+            mMergedObjectsCache->add(item->getKey(), item->getResult(), item->getSize());
+            attachMerged(group.second, item->getResult());
+        }
+    }
+
+    osg::Matrixf ObjectInstancing::getInstanceMatrix(const Instance& instance)
+    {
+        osg::Matrix baseMatrix;
+        mObjects[instance.first].mBaseNode->asTransform()->computeLocalToWorldMatrix(baseMatrix, nullptr);
+        return instance.second * osg::Matrixf(baseMatrix);
+    }
+
+    osg::ref_ptr<osg::Group> ObjectInstancing::createStateSetChain(const Batch& batch, osg::Group*& parent)
+    {
+        osg::ref_ptr<osg::Group> root (new osg::Group);
+        parent = root.get();
+        for (std::size_t i = 0; i < batch.mStateSets.size(); ++i)
+        {
+            if (i != 0)
+            {
+                osg::ref_ptr<osg::Group> group (new osg::Group);
+                parent->addChild(group);
+                parent = group.get();
+            }
+            parent->setStateSet(batch.mStateSets[i]);
+        }
+        return root;
+    }
+
+    void ObjectInstancing::rebuild(Batch& batch)
+    {
+        batch.mDirty = false;
+
+        if (batch.mRoot)
+        {
+            mCellNode->removeChild(batch.mRoot);
+            batch.mRoot = nullptr;
+        }
+
+        if (batch.mInstances.empty())
+            return;
+
+        osg::Group* parent = nullptr;
+        osg::ref_ptr<osg::Group> root = createStateSetChain(batch, parent);
+        root->setName("Instanced Batch");
+
+        const osg::BoundingBox& sourceBox = batch.mGeometry->getBoundingBox();
+        unsigned int nodeMask = 0;
+
+        for (std::size_t first = 0; first < batch.mInstances.size(); first += sMaxInstances)
+        {
+            const std::size_t count = std::min<std::size_t>(batch.mInstances.size() - first, sMaxInstances);
+
+            osg::ref_ptr<osg::Uniform> matrices (new osg::Uniform(osg::Uniform::FLOAT_MAT4, "instanceMatrices", count));
+            osg::BoundingBox box;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const Instance& instance = batch.mInstances[first + i];
+                const osg::Matrixf matrix = getInstanceMatrix(instance);
+                matrices->setElement(i, matrix);
+
+                for (unsigned int corner = 0; corner < 8; ++corner)
+                    box.expandBy(sourceBox.corner(corner) * matrix);
+
+                nodeMask |= mObjects[instance.first].mBaseNode->getNodeMask();
+            }
+
+            osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry(*batch.mGeometry, osg::CopyOp::SHALLOW_COPY));
+            for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i)
+            {
+                osg::ref_ptr<osg::PrimitiveSet> primitiveSet = osg::clone(batch.mGeometry->getPrimitiveSet(i), osg::CopyOp::SHALLOW_COPY);
+                primitiveSet->setNumInstances(count);
+                geometry->setPrimitiveSet(i, primitiveSet);
+            }
+            geometry->setUseDisplayList(false);
+            geometry->setUseVertexBufferObjects(true);
+            geometry->setComputeBoundingBoxCallback(new InstancesBoundingBoxCallback(box));
+            geometry->dirtyBound();
+
+            osg::ref_ptr<osg::Group> chunk (new osg::Group);
+            chunk->getOrCreateStateSet()->addUniform(new osg::Uniform("instancingEnabled", true));
+            chunk->getOrCreateStateSet()->addUniform(matrices);
+            chunk->addCullCallback(new SceneUtil::LightListCallback);
+            chunk->addChild(geometry);
+            parent->addChild(chunk);
+        }
+
+        root->setNodeMask(nodeMask);
+        if (!batch.mMerged)
+            mCellNode->addChild(root);
+        batch.mRoot = root;
+    }
+
+    void ObjectInstancing::markMergeGroupDirty(const StateSetsKey& key)
+    {
+        if (!mMergedObjectsCache)
+            return;
+
+        MergeGroup& group = mMergeGroups[key];
+        if (group.mDirty)
+            return;
+        unmerge(group);
+        group.mDirty = true;
+    }
+
+    void ObjectInstancing::unmerge(MergeGroup& group)
+    {
+        if (group.mPending)
+        {
+            group.mPending->abort();
+            group.mPending = nullptr;
+            --mNumPendingMerges;
+        }
+
+        if (group.mRoot)
+        {
+            mCellNode->removeChild(group.mRoot);
+            group.mRoot = nullptr;
+        }
+
+        for (const BatchKey& key : group.mMembers)
+        {
+            auto found = mBatches.find(key);
+            if (found == mBatches.end() || !found->second.mMerged)
+                continue;
+            found->second.mMerged = false;
+            if (found->second.mRoot)
+                mCellNode->addChild(found->second.mRoot);
+        }
+        group.mMembers.clear();
+    }
+
+    void ObjectInstancing::merge(MergeGroup& group)
+    {
+        group.mDirty = false;
+        if (group.mMembers.size() < 2)
+        {
+            group.mMembers.clear();
+            return;
+        }
+
+        std::vector<MergeItem::Source> sources;
+        for (const BatchKey& key : group.mMembers)
+        {
+            const Batch& batch = mBatches[key];
+            sources.push_back(MergeItem::Source {batch.mGeometry, getInstanceMatrix(batch.mInstances.front())});
+        }
+
+        const Batch& first = mBatches[group.mMembers.front()];
+        const std::string key = makeMergeKey(first.mStateSets, sources);
+        if (osg::ref_ptr<osg::Group> cached = mMergedObjectsCache->get(key))
+        {
+            attachMerged(group, cached);
+            return;
+        }
+
+        group.mPending = new MergeItem(key, first.mStateSets, sources);
+        mWorkQueue->addWorkItem(group.mPending);
+        ++mNumPendingMerges;
+    }
+
+    void ObjectInstancing::attachMerged(MergeGroup& group, osg::Group* merged)
+    {
+        osg::Group* parent = nullptr;
+        osg::ref_ptr<osg::Group> root = createStateSetChain(mBatches[group.mMembers.front()], parent);
+        root->setName("Merged Batch");
+        parent->addChild(merged);
+
+        unsigned int nodeMask = 0;
+        for (const BatchKey& key : group.mMembers)
+        {
+            Batch& batch = mBatches[key];
+            batch.mMerged = true;
+            if (batch.mRoot)
+                mCellNode->removeChild(batch.mRoot);
+            nodeMask |= mObjects[batch.mInstances.front().first].mBaseNode->getNodeMask();
+        }
+
+        root->setNodeMask(nodeMask);
+        mCellNode->addChild(root);
+        group.mRoot = root;
+    }
+
+}
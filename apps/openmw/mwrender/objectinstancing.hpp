@@ -0,0 +1,138 @@
+#ifndef GAME_RENDER_OBJECTINSTANCING_H
+#define GAME_RENDER_OBJECTINSTANCING_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <osg/ref_ptr>
+#include <osg/Matrixf>
+
+#include <components/resource/resourcemanager.hpp>
+
+#include "../mwworld/ptr.hpp"
+
+namespace osg
+{
+    class Geometry;
+    class Group;
+    class Node;
+    class StateSet;
+}
+
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
+namespace MWRender
+{
+
+    class MergeItem;
+
+    /// @brief Caches merged geometry of static objects, so a cell doesn't have to be merged again when it is reloaded.
+    /// @par Keys are made of the source geometries, their transforms and statesets. A cached group keeps its source
+    /// geometries referenced, so a key can't be reused by other geometries while its entry exists.
+    class MergedObjectsCache : public Resource::GenericResourceManager<std::string>
+    {
+    public:
+        MergedObjectsCache();
+
+        osg::ref_ptr<osg::Group> get(const std::string& key);
+
+        void add(const std::string& key, osg::Group* merged, std::size_t size);
+
+        const char* getName() const override { return "Merged Objects"; }
+    };
+
+    /// @brief Draws identical static meshes of a cell with instanced draw calls and merges meshes used only once.
+    /// @par The subgraph of an instanced object stays attached to its base node but is hidden, so the object can be
+    /// restored at any time. Instance transforms are read from the base nodes when a batch is rebuilt,
+    /// so objects may be moved as long as markDirty() is called.
+    /// @par Meshes that are used once in the cell and share the same statesets are merged into a few large geometries
+    /// in the work queue. Until the merge is done they are drawn as instanced batches with a single instance.
+    /// @note Requires shaders for all objects, see instancing_vertex.glsl.
+    class ObjectInstancing
+    {
+    public:
+        /// Maximum number of instances per draw call, must match instancing_vertex.glsl.
+        static const unsigned int sMaxInstances = 64;
+
+        /// @param mergedObjectsCache May be nullptr to disable merging.
+        ObjectInstancing(osg::Group* cellNode, MergedObjectsCache* mergedObjectsCache, SceneUtil::WorkQueue* workQueue);
+        ~ObjectInstancing();
+
+        /// Hide the object subgraph and draw it instanced, if it only consists of static geometry.
+        /// @return Was the object added?
+        bool add(const MWWorld::ConstPtr& ptr, osg::Node* baseNode, osg::Group* objectRoot);
+
+        /// Draw the object with its own subgraph again.
+        void remove(const MWWorld::ConstPtr& ptr);
+
+        /// Update the key of an object, e.g. when it changed cell.
+        void updatePtr(const MWWorld::ConstPtr& old, const MWWorld::ConstPtr& cur);
+
+        /// Update instance transforms of the object on next update().
+        void markDirty(const MWWorld::ConstPtr& ptr);
+
+        /// Rebuild changed batches and attach finished merges.
+        void update();
+
+    private:
+        typedef std::vector<const osg::StateSet*> StateSetsKey;
+        typedef std::pair<const osg::Geometry*, StateSetsKey> BatchKey;
+        typedef std::pair<MWWorld::ConstPtr, osg::Matrixf> Instance;
+
+        struct Batch
+        {
+            osg::ref_ptr<osg::Geometry> mGeometry;
+            // From the object root down to the parent of mGeometry
+            std::vector<osg::ref_ptr<osg::StateSet>> mStateSets;
+            // <object, transform relative to the object base node>
+            std::vector<Instance> mInstances;
+            osg::ref_ptr<osg::Group> mRoot;
+            bool mDirty = true;
+            // Drawn as part of a merged geometry, mRoot is detached
+            bool mMerged = false;
+        };
+
+        /// Single instance batches sharing the same statesets
+        struct MergeGroup
+        {
+            std::vector<BatchKey> mMembers;
+            osg::ref_ptr<osg::Group> mRoot;
+            osg::ref_ptr<MergeItem> mPending;
+            bool mDirty = true;
+        };
+
+        struct Object
+        {
+            osg::ref_ptr<osg::Node> mBaseNode;
+            osg::ref_ptr<osg::Group> mObjectRoot;
+            unsigned int mNodeMask;
+            std::vector<BatchKey> mBatches;
+        };
+
+        osg::ref_ptr<osg::Group> mCellNode;
+        MergedObjectsCache* mMergedObjectsCache;
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        std::map<BatchKey, Batch> mBatches;
+        std::map<StateSetsKey, MergeGroup> mMergeGroups;
+        std::map<MWWorld::ConstPtr, Object> mObjects;
+        std::size_t mNumPendingMerges;
+        bool mDirty;
+
+        osg::Matrixf getInstanceMatrix(const Instance& instance);
+        osg::ref_ptr<osg::Group> createStateSetChain(const Batch& batch, osg::Group*& parent);
+
+        void rebuild(Batch& batch);
+
+        void markMergeGroupDirty(const StateSetsKey& key);
+        void unmerge(MergeGroup& group);
+        void merge(MergeGroup& group);
+        void attachMerged(MergeGroup& group, osg::Group* merged);
+    };
+
+}
+
+#endif
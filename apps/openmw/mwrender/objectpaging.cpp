@@ -0,0 +1,293 @@
+#include "objectpaging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Stats>
+#include <osg/Switch>
+
+#include <components/debug/debuglog.hpp>
+#include <components/esm/esmreader.hpp>
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadstat.hpp>
+#include <components/resource/objectcache.hpp>
+#include <components/resource/scenemanager.hpp>
+#include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/memoryusage.hpp>
+#include <components/sceneutil/optimizer.hpp>
+
+#include "../mwbase/environment.hpp"
+#include "../mwbase/world.hpp"
+#include "../mwworld/esmstore.hpp"
+
+#include "util.hpp"
+#include "vismask.hpp"
+
+namespace
+{
+    typedef std::vector<const osg::StateSet*> StateSetsKey;
+    typedef std::vector<std::pair<osg::ref_ptr<const osg::Geometry>, osg::Matrixf>> Parts;
+
+    bool isInGrid(int x, int y, const osg::Vec4i& grid)
+    {
+        return x >= grid[0] && y >= grid[1] && x <= grid[2] && y <= grid[3];
+    }
+
+    /// Same as adjustRefNum of ESM::Cell, for readers that were not used to load the content file and don't know its masters.
+    void adjustRefNum(ESM::RefNum& refNum, const std::vector<ESM::Header::MasterData>& masters)
+    {
+        const unsigned int local = (refNum.mIndex & 0xff000000) >> 24;
+        if (local && local <= masters.size())
+        {
+            refNum.mIndex &= 0x00ffffff;
+            refNum.mContentFile = masters[local-1].index;
+        }
+    }
+
+    /// Reads the static references of a cell from the content files, so the game state of the cell is not touched.
+    void readStaticRefs(const ESM::Cell& cell, const MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& contentFiles,
+                        std::vector<ESM::ESMReader>& readers, std::map<ESM::RefNum, ESM::CellRef>& refs)
+    {
+        for (std::size_t i = 0; i < cell.mContextList.size(); ++i)
+        {
+            try
+            {
+                const std::size_t index = cell.mContextList[i].index;
+                if (readers.size() <= index)
+                    readers.resize(index + 1);
+                readers[index].setIndex(static_cast<int>(index));
+                cell.restore(readers[index], i);
+
+                ESM::CellRef ref;
+                ref.mRefNum.mContentFile = ESM::RefNum::RefNum_NoContentFile;
+                bool deleted = false;
+                while (cell.getNextRef(readers[index], ref, deleted))
+                {
+                    adjustRefNum(ref.mRefNum, contentFiles[index].getGameFiles());
+
+                    // Moved to a different cell
+                    if (std::find(cell.mMovedRefs.begin(), cell.mMovedRefs.end(), ref.mRefNum) != cell.mMovedRefs.end())
+                        continue;
+
+                    if (!deleted && store.get<ESM::Static>().search(ref.mRefID))
+                        refs[ref.mRefNum] = ref;
+                    else
+                        refs.erase(ref.mRefNum);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                Log(Debug::Error) << "Failed to read references of cell " << cell.getDescription() << " for object paging: " << e.what();
+            }
+        }
+
+        for (const auto& leased : cell.mLeasedRefs)
+        {
+            if (!leased.second && store.get<ESM::Static>().search(leased.first.mRefID))
+                refs[leased.first.mRefNum] = leased.first;
+            else
+                refs.erase(leased.first.mRefNum);
+        }
+    }
+
+    /// Collects static geometries of a subgraph by their inherited statesets, animated parts are left out.
+    void collectParts(const osg::Node& node, osg::Matrixf matrix, StateSetsKey& stateSets, std::map<StateSetsKey, Parts>& parts)
+    {
+        // Hidden nodes, e.g. collision shapes
+        if (node.getNodeMask() == 0)
+            return;
+
+        const osg::StateSet* stateSet = node.getStateSet();
+        if (node.getUpdateCallback() || node.getEventCallback() || node.getCullCallback()
+                || (stateSet && (stateSet->getUpdateCallback() || stateSet->getEventCallback())))
+            return;
+
+        if (const osg::Geometry* geometry = node.asGeometry())
+        {
+            if (node.className() == std::string("Geometry") && !geometry->getDrawCallback())
+                parts[stateSets].emplace_back(geometry, matrix);
+            return;
+        }
+
+        const osg::Group* group = node.asGroup();
+        if (!group)
+            return;
+
+        const osg::Switch* switchNode = dynamic_cast<const osg::Switch*>(group);
+        if (const osg::MatrixTransform* trans = dynamic_cast<const osg::MatrixTransform*>(group))
+        {
+            if (trans->getReferenceFrame() != osg::Transform::RELATIVE_RF)
+                return;
+            matrix = osg::Matrixf(trans->getMatrix()) * matrix;
+        }
+        else if (!switchNode && node.className() != std::string("Group"))
+            return;
+
+        if (stateSet)
+            stateSets.push_back(stateSet);
+
+        for (unsigned int i = 0; i < group->getNumChildren(); ++i)
+        {
+            if (!switchNode || switchNode->getValue(i))
+                collectParts(*group->getChild(i), matrix, stateSets, parts);
+        }
+
+        if (stateSet)
+            stateSets.pop_back();
+    }
+
+    osg::Matrixf getRefMatrix(const ESM::CellRef& ref, const osg::Vec3f& origin)
+    {
+        const ESM::Position& position = ref.mPos;
+        // Same as the rotation of objects in loaded cells
+        const osg::Quat rotation = osg::Quat(position.rot[2], osg::Vec3f(0, 0, -1))
+            * osg::Quat(position.rot[1], osg::Vec3f(0, -1, 0))
+            * osg::Quat(position.rot[0], osg::Vec3f(-1, 0, 0));
+
+        return osg::Matrixf::scale(ref.mScale, ref.mScale, ref.mScale)
+            * osg::Matrixf::rotate(rotation)
+            * osg::Matrixf::translate(position.asVec3() - origin);
+    }
+}
+
+namespace MWRender
+{
+
+    ObjectPaging::ObjectPaging(Resource::SceneManager* sceneManager, float cellWorldSize)
+        : GenericResourceManager<ObjectChunkId>(nullptr)
+        , mSceneManager(sceneManager)
+        , mCellWorldSize(cellWorldSize)
+        , mMinSize(0.01f)
+    {
+    }
+
+    osg::ref_ptr<osg::Node> ObjectPaging::getChunk(float size, const osg::Vec2f& center, const osg::Vec4i& activeGrid)
+    {
+        const ObjectChunkId id = std::make_tuple(center, size, activeGrid);
+        osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(id);
+        if (!obj)
+        {
+            osg::ref_ptr<osg::Node> node = createChunk(size, center, activeGrid);
+            // Includes the geometry shared with the templates, so this is an upper bound
+            mCache->addEntryToObjectCache(id, node.get(), 0.0, SceneUtil::estimateGeometryMemory(*node));
+            obj = node;
+        }
+
+        // Empty chunks are cached as well to not look for objects again
+        osg::ref_ptr<osg::Group> chunk = static_cast<osg::Group*>(obj.get());
+        if (chunk->getNumChildren() == 0)
+            return nullptr;
+        return chunk;
+    }
+
+    osg::ref_ptr<osg::Node> ObjectPaging::createChunk(float size, const osg::Vec2f& center, const osg::Vec4i& activeGrid)
+    {
+        const MWWorld::ESMStore& store = MWBase::Environment::get().getWorld()->getStore();
+        std::vector<ESM::ESMReader>& contentFiles = MWBase::Environment::get().getWorld()->getEsmReader();
+
+        const osg::Vec2f minBound = center - osg::Vec2f(size/2.f, size/2.f);
+        const osg::Vec2f maxBound = center + osg::Vec2f(size/2.f, size/2.f);
+        // Keep vertices close to the origin to not lose precision in large exteriors
+        const osg::Vec3f origin (center.x() * mCellWorldSize, center.y() * mCellWorldSize, 0.f);
+        const float minRadius = size * mCellWorldSize * mMinSize;
+
+        std::vector<ESM::ESMReader> readers;
+        std::map<StateSetsKey, Parts> parts;
+        StateSetsKey stateSets;
+
+        for (int cellX = static_cast<int>(std::floor(minBound.x())); cellX < maxBound.x(); ++cellX)
+        {
+            for (int cellY = static_cast<int>(std::floor(minBound.y())); cellY < maxBound.y(); ++cellY)
+            {
+                if (isInGrid(cellX, cellY, activeGrid))
+                    continue;
+
+                const ESM::Cell* cell = store.get<ESM::Cell>().search(cellX, cellY);
+                if (!cell)
+                    continue;
+
+                std::map<ESM::RefNum, ESM::CellRef> refs;
+                readStaticRefs(*cell, store, contentFiles, readers, refs);
+
+                for (const auto& pair : refs)
+                {
+                    const ESM::CellRef& ref = pair.second;
+
+                    // Nodes smaller than a cell only contain the objects within their bounds
+                    if (size < 1.f)
+                    {
+                        const osg::Vec2f position (
+                            std::min(std::max(ref.mPos.pos[0] / mCellWorldSize, static_cast<float>(cellX)), cellX + 0.999f),
+                            std::min(std::max(ref.mPos.pos[1] / mCellWorldSize, static_cast<float>(cellY)), cellY + 0.999f));
+                        if (position.x() < minBound.x() || position.x() >= maxBound.x()
+                                || position.y() < minBound.y() || position.y() >= maxBound.y())
+                            continue;
+                    }
+
+                    const ESM::Static* stat = store.get<ESM::Static>().search(ref.mRefID);
+                    if (!stat || stat->mModel.empty())
+                        continue;
+
+                    osg::ref_ptr<const osg::Node> node = mSceneManager->getTemplate("meshes\\" + stat->mModel);
+                    if (node->getBound().radius() * ref.mScale < minRadius)
+                        continue;
+
+                    collectParts(*node, getRefMatrix(ref, origin), stateSets, parts);
+                }
+            }
+        }
+
+        osg::ref_ptr<osg::MatrixTransform> chunk (new osg::MatrixTransform(osg::Matrix::translate(origin)));
+        chunk->setName("Object Chunk");
+        chunk->setNodeMask(Mask_Static);
+        chunk->addCullCallback(new SceneUtil::LightListCallback);
+
+        for (const auto& chain : parts)
+        {
+            // Statesets are shared with the templates, the same as for instances of the SceneManager
+            osg::ref_ptr<osg::Group> parent (new osg::Group);
+            chunk->addChild(parent);
+            for (std::size_t i = 0; i < chain.first.size(); ++i)
+            {
+                if (i != 0)
+                {
+                    osg::ref_ptr<osg::Group> group (new osg::Group);
+                    parent->addChild(group);
+                    parent = group;
+                }
+                parent->setStateSet(const_cast<osg::StateSet*>(chain.first[i]));
+            }
+
+            for (const auto& part : chain.second)
+            {
+                if (canMergeGeometry(*part.first))
+                {
+                    osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry(*part.first,
+                        osg::CopyOp::DEEP_COPY_ARRAYS|osg::CopyOp::DEEP_COPY_PRIMITIVES));
+                    transformGeometry(*geometry, part.second);
+                    parent->addChild(geometry);
+                }
+                else
+                {
+                    osg::ref_ptr<osg::MatrixTransform> trans (new osg::MatrixTransform(part.second));
+                    trans->addChild(const_cast<osg::Geometry*>(part.first.get()));
+                    parent->addChild(trans);
+                }
+            }
+
+            SceneUtil::Optimizer::MergeGeometryVisitor visitor;
+            visitor.mergeGroup(*parent);
+        }
+
+        return chunk;
+    }
+
+    void ObjectPaging::reportStats(unsigned int frameNumber, osg::Stats* stats) const
+    {
+        stats->setAttribute(frameNumber, "Object Chunk", mCache->getCacheSize());
+    }
+
+}
@@ -0,0 +1,49 @@
+#ifndef OPENMW_MWRENDER_OBJECTPAGING_H
+#define OPENMW_MWRENDER_OBJECTPAGING_H
+
+#include <tuple>
+
+#include <osg/Vec2f>
+#include <osg/Vec4i>
+
+#include <components/resource/resourcemanager.hpp>
+#include <components/terrain/quadtreeworld.hpp>
+
+namespace Resource
+{
+    class SceneManager;
+}
+
+namespace MWRender
+{
+
+    typedef std::tuple<osg::Vec2f, float, osg::Vec4i> ObjectChunkId; // Center, Size, Active grid
+
+    /// @brief Creates and caches merged static objects of terrain quad tree nodes, to render objects beyond the loaded cells.
+    /// @par Objects are read from the content files, so changes made during the game (e.g. disabled objects) are not
+    /// reflected by the chunks. Only statics are paged, and objects that are small in relation to the chunk size are left out.
+    class ObjectPaging : public Resource::GenericResourceManager<ObjectChunkId>, public Terrain::QuadTreeChunkManager
+    {
+    public:
+        ObjectPaging(Resource::SceneManager* sceneManager, float cellWorldSize);
+
+        osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, const osg::Vec4i& activeGrid) override;
+
+        /// Objects with a bounding radius below this fraction of the chunk size are left out.
+        void setMinSize(float minSize) { mMinSize = minSize; }
+
+        const char* getName() const override { return "Object Chunk"; }
+
+        void reportStats(unsigned int frameNumber, osg::Stats* stats) const override;
+
+    private:
+        osg::ref_ptr<osg::Node> createChunk(float size, const osg::Vec2f& center, const osg::Vec4i& activeGrid);
+
+        Resource::SceneManager* mSceneManager;
+        float mCellWorldSize;
+        float mMinSize;
+    };
+
+}
+
+#endif
@@ -1,43 +1,188 @@
 #include "objects.hpp"
 
+#include <algorithm>
+#include <atomic>
+
+#include <osg/ColorMask>
+#include <osg/Depth>
 #include <osg/Group>
+#include <osg/OcclusionQueryNode>
 #include <osg/UserDataContainer>
 
+#include <osgUtil/CullVisitor>
+
+#include <osgParticle/ParticleProcessor>
+#include <osgParticle/ParticleSystemUpdater>
+
+#include <components/esm/loadcell.hpp>
+#include <components/esm/loadligh.hpp>
+#include <components/esm/loadstat.hpp>
+#include <components/misc/keyhasher.hpp>
+#include <components/resource/resourcesystem.hpp>
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "../mwworld/ptr.hpp"
+#include "../mwworld/cellstore.hpp"
 #include "../mwworld/class.hpp"
 
 #include "animation.hpp"
 #include "npcanimation.hpp"
 #include "creatureanimation.hpp"
+#include "objectinstancing.hpp"
+#include "renderbin.hpp"
 #include "vismask.hpp"
 
+namespace
+{
+    /// Only culls the chunks for the main view. Render to texture cameras like shadows, water reflections and
+    /// the local map draw them unconditionally, their queries would only add draw calls.
+    class OcclusionChunkCullCallback : public osg::NodeCallback
+    {
+    public:
+        OcclusionChunkCullCallback(const MWRender::ChunkKey& key, MWRender::ChunkVisibility* visibility, bool queries)
+            : mKey(key)
+            , mVisibility(visibility)
+            , mQueries(queries)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+            if (cv->getCurrentCamera()->isRenderToTextureCamera())
+            {
+                static_cast<osg::Group*>(node)->osg::Group::traverse(*nv);
+                return;
+            }
+
+            if (mVisibility && !mVisibility->isVisible(cv->getEyePoint(), mKey))
+                return;
+
+            if (mQueries)
+                traverse(node, nv);
+            else
+                static_cast<osg::Group*>(node)->osg::Group::traverse(*nv);
+        }
+
+    private:
+        MWRender::ChunkKey mKey;
+        osg::ref_ptr<MWRender::ChunkVisibility> mVisibility;
+        bool mQueries;
+    };
+
+    /// Records the last frame any camera culled the node it is attached to as a cull callback.
+    class LastCullFrameCallback : public osg::NodeCallback
+    {
+    public:
+        LastCullFrameCallback()
+            : mLastCullFrame(0)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            mLastCullFrame = nv->getTraversalNumber();
+            traverse(node, nv);
+        }
+
+        /// Cameras may be culled in parallel
+        std::atomic<unsigned int> mLastCullFrame;
+    };
+
+    /// Skips the update traversal of a node that wasn't culled in the last frame. The controllers of static models
+    /// depend on the simulation time only, so they catch up as soon as the node is updated again.
+    class SkipUnseenUpdateCallback : public osg::NodeCallback
+    {
+    public:
+        SkipUnseenUpdateCallback(LastCullFrameCallback* cullCallback)
+            : mCullCallback(cullCallback)
+        {
+        }
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            // The update of a frame runs before its cull, so a visible node was culled in the previous frame
+            if (mCullCallback->mLastCullFrame + 1 < nv->getTraversalNumber())
+                return;
+            traverse(node, nv);
+        }
+
+    private:
+        osg::ref_ptr<LastCullFrameCallback> mCullCallback;
+    };
+
+    /// Particle emitters and programs take the time since their last update, skipped updates would cause bursts.
+    class FindParticlesVisitor : public osg::NodeVisitor
+    {
+    public:
+        FindParticlesVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mFound(false)
+        {
+        }
+
+        virtual void apply(osg::Node& node)
+        {
+            if (dynamic_cast<osgParticle::ParticleProcessor*>(&node) || dynamic_cast<osgParticle::ParticleSystemUpdater*>(&node))
+                mFound = true;
+            else
+                traverse(node);
+        }
+
+        bool mFound;
+    };
+}
 
 namespace MWRender
 {
 
 Objects::Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> rootNode, SceneUtil::UnrefQueue* unrefQueue)
-    : mRootNode(rootNode)
+    : mInstancingEnabled(false)
+    , mSkipUnseenStaticUpdates(false)
+    , mRootNode(rootNode)
     , mResourceSystem(resourceSystem)
     , mUnrefQueue(unrefQueue)
+    , mUnloadedCellExpiryDelay(0)
+    , mReferenceTime(0)
+    , mOcclusionChunkSize(0)
+    , mOcclusionQueries(false)
+    , mInteriorVisibility(false)
 {
 }
 
 Objects::~Objects()
 {
+    mUnloadedCells.clear();
+    mCellInstancing.clear();
+    for (CellOcclusionChunkMap::iterator it = mCellOcclusionChunks.begin(); it != mCellOcclusionChunks.end(); ++it)
+    {
+        if (it->second.mVisibilityBuilder)
+            it->second.mVisibilityBuilder->abort();
+    }
+    mCellOcclusionChunks.clear();
     mObjects.clear();
 
+    if (mMergedObjectsCache)
+        mResourceSystem->removeResourceManager(mMergedObjectsCache.get());
+
     for (CellMap::iterator iter = mCellSceneNodes.begin(); iter != mCellSceneNodes.end(); ++iter)
         iter->second->getParent(0)->removeChild(iter->second);
     mCellSceneNodes.clear();
 }
 
-void Objects::insertBegin(const MWWorld::Ptr& ptr)
+void Objects::insertBegin(const MWWorld::Ptr& ptr, bool occludable)
 {
     assert(mObjects.find(ptr) == mObjects.end());
 
+    osg::ref_ptr<SceneUtil::PositionAttitudeTransform> insert (new SceneUtil::PositionAttitudeTransform);
+    insert->getOrCreateUserDataContainer()->addUserObject(new PtrHolder(ptr));
+    attachBaseNode(ptr, insert, occludable);
+}
+
+void Objects::attachBaseNode(const MWWorld::Ptr& ptr, osg::Group* baseNode, bool occludable)
+{
     osg::ref_ptr<osg::Group> cellnode;
 
     CellMap::iterator found = mCellSceneNodes.find(ptr.getCell());
@@ -51,10 +196,11 @@ void Objects::insertBegin(const MWWorld::Ptr& ptr)
     else
         cellnode = found->second;
 
-    osg::ref_ptr<SceneUtil::PositionAttitudeTransform> insert (new SceneUtil::PositionAttitudeTransform);
-    cellnode->addChild(insert);
-
-    insert->getOrCreateUserDataContainer()->addUserObject(new PtrHolder(ptr));
+    SceneUtil::PositionAttitudeTransform* insert = static_cast<SceneUtil::PositionAttitudeTransform*>(baseNode);
+    if (occludable && mOcclusionChunkSize > 0)
+        getOcclusionChunk(ptr, cellnode)->addChild(insert);
+    else
+        cellnode->addChild(insert);
 
     const float *f = ptr.getRefData().getPosition().pos;
 
@@ -68,14 +214,151 @@ void Objects::insertBegin(const MWWorld::Ptr& ptr)
     ptr.getRefData().setBaseNode(insert);
 }
 
+osg::Group* Objects::getOcclusionChunk(const MWWorld::Ptr& ptr, osg::Group* cellNode)
+{
+    // Moving objects only grow the bounding box of their chunk, so it stays correct
+    const osg::Vec3f position (ptr.getRefData().getPosition().asVec3());
+    const ChunkKey key = getChunkKey(position, mOcclusionChunkSize);
+
+    OcclusionChunks& chunks = mCellOcclusionChunks[ptr.getCell()];
+    if (mInteriorVisibility && !chunks.mVisibility && !ptr.getCell()->getCell()->isExterior())
+        chunks.mVisibility = new ChunkVisibility;
+
+    osg::ref_ptr<osg::OcclusionQueryNode>& chunk = chunks.mChunks[key];
+    if (!chunk)
+    {
+        if (!mOcclusionQueryStateSet)
+        {
+            mOcclusionQueryStateSet = new osg::StateSet;
+            mOcclusionQueryStateSet->setAttributeAndModes(new osg::ColorMask(false, false, false, false), osg::StateAttribute::ON);
+            osg::ref_ptr<osg::Depth> depth (new osg::Depth);
+            depth->setWriteMask(false);
+            mOcclusionQueryStateSet->setAttributeAndModes(depth, osg::StateAttribute::ON);
+            // The camera may be inside the box, whose back faces are then the only ones in front of the occluders
+            mOcclusionQueryStateSet->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
+            // After the opaque geometry that does the occluding
+            mOcclusionQueryStateSet->setRenderBinDetails(RenderBin_OcclusionQuery, "RenderBin");
+        }
+
+        chunk = new osg::OcclusionQueryNode;
+        chunk->setName("Occlusion Chunk");
+        chunk->setQueriesEnabled(mOcclusionQueries);
+        chunk->setQueryStateSet(mOcclusionQueryStateSet);
+        // Query every frame and draw the chunk if a single pixel was visible, so hidden objects appear one frame late at most
+        chunk->setQueryFrameCount(1);
+        chunk->setVisibilityThreshold(0);
+        chunk->setCullCallback(new OcclusionChunkCullCallback(key, chunks.mVisibility, mOcclusionQueries));
+        cellNode->addChild(chunk);
+    }
+    return chunk.get();
+}
+
 void Objects::insertModel(const MWWorld::Ptr &ptr, const std::string &mesh, bool animated, bool allowLight)
 {
-    insertBegin(ptr);
-    ptr.getRefData().getBaseNode()->setNodeMask(Mask_Object);
+    const bool isStatic = !animated && ptr.getTypeName() == typeid(ESM::Static).name();
+
+    osg::ref_ptr<Animation> anim;
+    if (isStatic && mUnloadedCellExpiryDelay > 0)
+        anim = takeUnloadedObject(ptr, mesh);
+
+    // Lights would stop lighting the visible geometry around them when their chunk is hidden
+    const bool occludable = ptr.getTypeName() != typeid(ESM::Light).name();
+
+    if (anim)
+    {
+        assert(mObjects.find(ptr) == mObjects.end());
+        attachBaseNode(ptr, anim->getObjectRoot()->getParent(0), occludable);
+        anim->updatePtr(ptr);
+    }
+    else
+    {
+        insertBegin(ptr, occludable);
+        ptr.getRefData().getBaseNode()->setNodeMask(Mask_Object);
+        anim = new ObjectAnimation(ptr, mesh, mResourceSystem, animated, allowLight);
 
-    osg::ref_ptr<ObjectAnimation> anim (new ObjectAnimation(ptr, mesh, mResourceSystem, animated, allowLight));
+        osg::Group* baseNode = ptr.getRefData().getBaseNode();
+        if (isStatic && mSkipUnseenStaticUpdates && baseNode->getNumChildrenRequiringUpdateTraversal() > 0)
+        {
+            FindParticlesVisitor findParticles;
+            baseNode->accept(findParticles);
+            if (!findParticles.mFound)
+            {
+                osg::ref_ptr<LastCullFrameCallback> cullCallback = new LastCullFrameCallback;
+                baseNode->addCullCallback(cullCallback);
+                baseNode->addUpdateCallback(new SkipUnseenUpdateCallback(cullCallback));
+            }
+        }
+    }
 
     mObjects.insert(std::make_pair(ptr, anim));
+
+    if (isStatic && mUnloadedCellExpiryDelay > 0 && anim->getObjectRoot())
+        mReusableModels[ptr] = mesh;
+
+    if (mInstancingEnabled && isStatic)
+        addToInstancing(ptr, anim);
+
+    occluderChanged(ptr);
+}
+
+osg::ref_ptr<Animation> Objects::takeUnloadedObject(const MWWorld::Ptr& ptr, const std::string& model)
+{
+    UnloadedCellMap::iterator cell = mUnloadedCells.find(ptr.getCell());
+    if (cell == mUnloadedCells.end())
+        return nullptr;
+
+    std::map<MWWorld::ConstPtr, UnloadedObject>::iterator found = cell->second.mObjects.find(ptr);
+    if (found == cell->second.mObjects.end())
+        return nullptr;
+
+    osg::ref_ptr<Animation> anim;
+    if (found->second.mModel == model)
+        anim = found->second.mAnimation;
+    else if (mUnrefQueue.get())
+        mUnrefQueue->push(found->second.mAnimation);
+
+    cell->second.mObjects.erase(found);
+    if (cell->second.mObjects.empty())
+        mUnloadedCells.erase(cell);
+    return anim;
+}
+
+void Objects::retainUnloadedObject(const MWWorld::Ptr& ptr, const osg::ref_ptr<Animation>& anim)
+{
+    std::map<MWWorld::ConstPtr, std::string>::iterator model = mReusableModels.find(ptr);
+    if (model == mReusableModels.end())
+        return;
+
+    // Restore the node mask of the object root, which is hidden while it is drawn by instancing
+    CellInstancingMap::iterator instancing = mCellInstancing.find(ptr.getCell());
+    if (instancing != mCellInstancing.end())
+        instancing->second->remove(ptr);
+
+    osg::Node* baseNode = anim->getObjectRoot()->getParent(0);
+    if (baseNode->getNumParents())
+        baseNode->getParent(0)->removeChild(baseNode);
+
+    UnloadedCell& cell = mUnloadedCells[ptr.getCell()];
+    cell.mTime = mReferenceTime;
+    UnloadedObject& object = cell.mObjects[ptr];
+    if (object.mAnimation && mUnrefQueue.get())
+        mUnrefQueue->push(object.mAnimation);
+    object.mModel = model->second;
+    object.mAnimation = anim;
+
+    mReusableModels.erase(model);
+}
+
+void Objects::addToInstancing(const MWWorld::Ptr& ptr, Animation* anim)
+{
+    osg::Group* objectRoot = anim->getObjectRoot();
+    if (!objectRoot)
+        return;
+
+    std::unique_ptr<ObjectInstancing>& instancing = mCellInstancing[ptr.getCell()];
+    if (!instancing)
+        instancing.reset(new ObjectInstancing(mCellSceneNodes[ptr.getCell()], mMergedObjectsCache.get(), mWorkQueue.get()));
+    instancing->add(ptr, ptr.getRefData().getBaseNode(), objectRoot);
 }
 
 void Objects::insertCreature(const MWWorld::Ptr &ptr, const std::string &mesh, bool weaponsShields)
@@ -114,13 +397,20 @@ bool Objects::removeObject (const MWWorld::Ptr& ptr)
     if(!ptr.getRefData().getBaseNode())
         return true;
 
+    CellInstancingMap::iterator instancing = mCellInstancing.find(ptr.getCell());
+    if (instancing != mCellInstancing.end())
+        instancing->second->remove(ptr);
+
     PtrAnimationMap::iterator iter = mObjects.find(ptr);
     if(iter != mObjects.end())
     {
+        occluderChanged(ptr);
+
         if (mUnrefQueue.get())
             mUnrefQueue->push(iter->second);
 
         mObjects.erase(iter);
+        mReusableModels.erase(ptr);
 
         if (ptr.getClass().isActor())
         {
@@ -146,7 +436,9 @@ void Objects::removeCell(const MWWorld::CellStore* store)
         MWWorld::Ptr ptr = iter->second->getPtr();
         if(ptr.getCell() == store)
         {
-            if (mUnrefQueue.get())
+            if (mReusableModels.count(ptr))
+                retainUnloadedObject(ptr, iter->second);
+            else if (mUnrefQueue.get())
                 mUnrefQueue->push(iter->second);
 
             if (ptr.getClass().isNpc() && ptr.getRefData().getCustomData())
@@ -162,6 +454,16 @@ void Objects::removeCell(const MWWorld::CellStore* store)
             ++iter;
     }
 
+    mCellInstancing.erase(store);
+
+    CellOcclusionChunkMap::iterator chunks = mCellOcclusionChunks.find(store);
+    if (chunks != mCellOcclusionChunks.end())
+    {
+        if (chunks->second.mVisibilityBuilder)
+            chunks->second.mVisibilityBuilder->abort();
+        mCellOcclusionChunks.erase(chunks);
+    }
+
     CellMap::iterator cell = mCellSceneNodes.find(store);
     if(cell != mCellSceneNodes.end())
     {
@@ -172,12 +474,36 @@ void Objects::removeCell(const MWWorld::CellStore* store)
     }
 }
 
+void Objects::setUnloadedCellExpiryDelay(double delay)
+{
+    mUnloadedCellExpiryDelay = delay;
+    if (delay <= 0)
+        clearUnloadedCells();
+}
+
+void Objects::clearUnloadedCells()
+{
+    for (UnloadedCellMap::iterator cell = mUnloadedCells.begin(); cell != mUnloadedCells.end(); ++cell)
+    {
+        for (auto& object : cell->second.mObjects)
+        {
+            if (mUnrefQueue.get())
+                mUnrefQueue->push(object.second.mAnimation);
+        }
+    }
+    mUnloadedCells.clear();
+}
+
 void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
 {
     osg::Node* objectNode = cur.getRefData().getBaseNode();
     if (!objectNode)
         return;
 
+    CellInstancingMap::iterator instancing = mCellInstancing.find(old.getCell());
+    if (instancing != mCellInstancing.end())
+        instancing->second->remove(old);
+
     MWWorld::CellStore *newCell = cur.getCell();
 
     osg::Group* cellnode;
@@ -208,6 +534,202 @@ void Objects::updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur)
         mObjects.erase(iter);
         anim->updatePtr(cur);
         mObjects[cur] = anim;
+
+        std::map<MWWorld::ConstPtr, std::string>::iterator model = mReusableModels.find(old);
+        if (model != mReusableModels.end())
+        {
+            const std::string mesh = model->second;
+            mReusableModels.erase(model);
+            mReusableModels[cur] = mesh;
+        }
+
+        if (mInstancingEnabled && cur.getTypeName() == typeid(ESM::Static).name())
+            addToInstancing(cur, anim);
+    }
+}
+
+void Objects::setInstancingEnabled(bool enabled)
+{
+    mInstancingEnabled = enabled;
+}
+
+void Objects::setSkipUnseenStaticUpdates(bool enabled)
+{
+    mSkipUnseenStaticUpdates = enabled;
+}
+
+void Objects::setMergingEnabled(bool enabled, SceneUtil::WorkQueue* workQueue)
+{
+    if (enabled == (mMergedObjectsCache != nullptr))
+        return;
+
+    if (enabled)
+    {
+        mMergedObjectsCache.reset(new MergedObjectsCache);
+        mResourceSystem->addResourceManager(mMergedObjectsCache.get());
+        mWorkQueue = workQueue;
+    }
+    else
+    {
+        mResourceSystem->removeResourceManager(mMergedObjectsCache.get());
+        mMergedObjectsCache.reset();
+        mWorkQueue = nullptr;
+    }
+}
+
+void Objects::setOcclusionCulling(float chunkSize, bool queries, bool interiorVisibility, SceneUtil::WorkQueue* workQueue)
+{
+    mOcclusionChunkSize = (queries || interiorVisibility) ? chunkSize : 0.f;
+    mOcclusionQueries = queries;
+    mInteriorVisibility = interiorVisibility && workQueue;
+    if (interiorVisibility)
+        mWorkQueue = workQueue;
+}
+
+void Objects::buildInteriorVisibility(const MWWorld::CellStore* store)
+{
+    CellOcclusionChunkMap::iterator found = mCellOcclusionChunks.find(store);
+    if (found == mCellOcclusionChunks.end() || !found->second.mVisibility)
+        return;
+
+    OcclusionChunks& chunks = found->second;
+    chunks.mVisibilityRequested = true;
+    chunks.mOccludersChanged = false;
+
+    // Only static objects hide what is behind them, doors may be open
+    std::vector<std::pair<osg::Node*, osg::Matrix> > occluders;
+    std::vector<std::string> occluderKeys;
+    for (PtrAnimationMap::const_iterator it = mObjects.begin(); it != mObjects.end(); ++it)
+    {
+        const MWWorld::ConstPtr& ptr = it->first;
+        if (ptr.getCell() != store || ptr.getTypeName() != typeid(ESM::Static).name() || !it->second->getObjectRoot())
+            continue;
+
+        const osg::Node* baseNode = ptr.getRefData().getBaseNode();
+        if (!baseNode)
+            continue;
+
+        const SceneUtil::PositionAttitudeTransform* transform = static_cast<const SceneUtil::PositionAttitudeTransform*>(baseNode);
+        osg::Matrix matrix;
+        transform->computeLocalToWorldMatrix(matrix, nullptr);
+        occluders.emplace_back(it->second->getObjectRoot(), matrix);
+
+        Misc::KeyHasher occluderHasher;
+        occluderHasher.add(ptr.getCellRef().getRefId());
+        occluderHasher.add(matrix);
+        occluderKeys.push_back(occluderHasher.getKey());
+    }
+
+    // The objects are ordered by their address, which is not the same when the cell is loaded again
+    std::sort(occluderKeys.begin(), occluderKeys.end());
+    Misc::KeyHasher hasher;
+    for (const std::string& key : occluderKeys)
+        hasher.add(key);
+    const std::string cacheKey = store->getCell()->mName + ":" + hasher.getKey();
+
+    std::map<std::string, std::shared_ptr<const InteriorVisibility> >::const_iterator cached
+            = mInteriorVisibilityCache.find(cacheKey);
+    if (cached != mInteriorVisibilityCache.end())
+    {
+        std::set<ChunkKey> keys;
+        for (const auto& chunk : chunks.mChunks)
+            keys.insert(chunk.first);
+
+        if (keys == cached->second->mChunks)
+        {
+            chunks.mVisibility->set(cached->second);
+            return;
+        }
+    }
+
+    osg::ref_ptr<InteriorVisibilityBuilder> builder (new InteriorVisibilityBuilder(mOcclusionChunkSize));
+    for (const auto& chunk : chunks.mChunks)
+    {
+        osg::BoundingBox bounds;
+        bounds.expandBy(chunk.second->getBound());
+        builder->addChunk(chunk.first, bounds);
+    }
+
+    for (const auto& occluder : occluders)
+        builder->addOccluder(*occluder.first, occluder.second);
+
+    chunks.mVisibilityCacheKey = cacheKey;
+    chunks.mVisibilityBuilder = builder;
+    mWorkQueue->addWorkItem(builder);
+}
+
+void Objects::occluderChanged(const MWWorld::ConstPtr& ptr)
+{
+    if (ptr.getTypeName() != typeid(ESM::Static).name())
+        return;
+
+    CellOcclusionChunkMap::iterator found = mCellOcclusionChunks.find(ptr.getCell());
+    if (found == mCellOcclusionChunks.end() || !found->second.mVisibilityRequested)
+        return;
+
+    // Everything stays visible until the visibility is computed again, the removed object may have been a wall
+    OcclusionChunks& chunks = found->second;
+    chunks.mVisibility->set(nullptr);
+    if (chunks.mVisibilityBuilder)
+    {
+        chunks.mVisibilityBuilder->abort();
+        chunks.mVisibilityBuilder = nullptr;
+    }
+    chunks.mOccludersChanged = true;
+    chunks.mOccludersChangedTime = mReferenceTime;
+}
+
+void Objects::transformChanged(const MWWorld::Ptr& ptr)
+{
+    occluderChanged(ptr);
+
+    CellInstancingMap::iterator instancing = mCellInstancing.find(ptr.getCell());
+    if (instancing != mCellInstancing.end())
+        instancing->second->markDirty(ptr);
+}
+
+void Objects::update(double referenceTime)
+{
+    mReferenceTime = referenceTime;
+
+    for (UnloadedCellMap::iterator cell = mUnloadedCells.begin(); cell != mUnloadedCells.end();)
+    {
+        if (referenceTime - cell->second.mTime < mUnloadedCellExpiryDelay)
+        {
+            ++cell;
+            continue;
+        }
+        for (auto& object : cell->second.mObjects)
+        {
+            if (mUnrefQueue.get())
+                mUnrefQueue->push(object.second.mAnimation);
+        }
+        mUnloadedCells.erase(cell++);
+    }
+
+    for (CellInstancingMap::iterator it = mCellInstancing.begin(); it != mCellInstancing.end(); ++it)
+        it->second->update();
+
+    for (CellOcclusionChunkMap::iterator it = mCellOcclusionChunks.begin(); it != mCellOcclusionChunks.end(); ++it)
+    {
+        OcclusionChunks& chunks = it->second;
+        if (!chunks.mVisibilityBuilder || !chunks.mVisibilityBuilder->isDone())
+            continue;
+
+        std::shared_ptr<const InteriorVisibility> visibility = chunks.mVisibilityBuilder->getResult();
+        chunks.mVisibilityBuilder = nullptr;
+        if (!visibility)
+            continue;
+
+        chunks.mVisibility->set(visibility);
+        mInteriorVisibilityCache[chunks.mVisibilityCacheKey] = visibility;
+    }
+
+    // Computed again once scripts stopped changing the objects for a moment, not for every step of a moving object
+    for (CellOcclusionChunkMap::iterator it = mCellOcclusionChunks.begin(); it != mCellOcclusionChunks.end(); ++it)
+    {
+        if (it->second.mOccludersChanged && referenceTime - it->second.mOccludersChangedTime >= 1.0)
+            buildInteriorVisibility(it->first);
     }
 }
 
@@ -2,6 +2,7 @@
 #define GAME_RENDER_OBJECTS_H
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include <osg/ref_ptr>
@@ -9,9 +10,13 @@
 
 #include "../mwworld/ptr.hpp"
 
+#include "interiorvisibility.hpp"
+
 namespace osg
 {
     class Group;
+    class OcclusionQueryNode;
+    class StateSet;
 }
 
 namespace Resource
@@ -27,11 +32,14 @@ namespace MWWorld
 namespace SceneUtil
 {
     class UnrefQueue;
+    class WorkQueue;
 }
 
 namespace MWRender{
 
 class Animation;
+class MergedObjectsCache;
+class ObjectInstancing;
 
 class PtrHolder : public osg::Object
 {
@@ -62,13 +70,81 @@ class Objects{
     CellMap mCellSceneNodes;
     PtrAnimationMap mObjects;
 
+    typedef std::map<const MWWorld::CellStore*, std::unique_ptr<ObjectInstancing> > CellInstancingMap;
+    CellInstancingMap mCellInstancing;
+    bool mInstancingEnabled;
+    bool mSkipUnseenStaticUpdates;
+    std::unique_ptr<MergedObjectsCache> mMergedObjectsCache;
+    osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
     osg::ref_ptr<osg::Group> mRootNode;
 
     Resource::ResourceSystem* mResourceSystem;
 
     osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
 
-    void insertBegin(const MWWorld::Ptr& ptr);
+    /// Static models of an unloaded cell, kept detached from the scene until the cell is loaded again
+    struct UnloadedObject
+    {
+        std::string mModel;
+        osg::ref_ptr<Animation> mAnimation;
+    };
+
+    struct UnloadedCell
+    {
+        double mTime;
+        std::map<MWWorld::ConstPtr, UnloadedObject> mObjects;
+    };
+
+    typedef std::map<const MWWorld::CellStore*, UnloadedCell> UnloadedCellMap;
+    UnloadedCellMap mUnloadedCells;
+    std::map<MWWorld::ConstPtr, std::string> mReusableModels;
+    double mUnloadedCellExpiryDelay;
+    double mReferenceTime;
+
+    /// Objects of a cell grouped by their position, each group drawn only if its bounding box was visible in the last frame
+    /// and it is visible from the region of the camera
+    struct OcclusionChunks
+    {
+        std::map<ChunkKey, osg::ref_ptr<osg::OcclusionQueryNode> > mChunks;
+        osg::ref_ptr<ChunkVisibility> mVisibility;
+        osg::ref_ptr<InteriorVisibilityBuilder> mVisibilityBuilder;
+        /// The key of mVisibilityBuilder's result in mInteriorVisibilityCache
+        std::string mVisibilityCacheKey;
+        /// buildInteriorVisibility() was called for the cell
+        bool mVisibilityRequested = false;
+        /// A static object was added, removed or moved since the visibility was computed
+        bool mOccludersChanged = false;
+        double mOccludersChangedTime = 0.0;
+    };
+
+    typedef std::map<const MWWorld::CellStore*, OcclusionChunks> CellOcclusionChunkMap;
+    CellOcclusionChunkMap mCellOcclusionChunks;
+    float mOcclusionChunkSize;
+    bool mOcclusionQueries;
+    bool mInteriorVisibility;
+    osg::ref_ptr<osg::StateSet> mOcclusionQueryStateSet;
+
+    /// By cell name and the static objects in it, so the visibility of an interior is only computed once
+    /// as long as scripts don't enable, disable or move its static objects
+    std::map<std::string, std::shared_ptr<const InteriorVisibility> > mInteriorVisibilityCache;
+
+    /// Drop the visibility of the cell of \a ptr if it is a static object, it is computed again in the next update.
+    void occluderChanged(const MWWorld::ConstPtr& ptr);
+
+    /// @param occludable Add the object to an occlusion chunk of its cell, if occlusion culling is enabled.
+    void insertBegin(const MWWorld::Ptr& ptr, bool occludable=false);
+
+    void attachBaseNode(const MWWorld::Ptr& ptr, osg::Group* baseNode, bool occludable=false);
+
+    osg::Group* getOcclusionChunk(const MWWorld::Ptr& ptr, osg::Group* cellNode);
+
+    /// @return The animation of \a ptr kept from the last time its cell was unloaded, if it used the same model.
+    osg::ref_ptr<Animation> takeUnloadedObject(const MWWorld::Ptr& ptr, const std::string& model);
+
+    void retainUnloadedObject(const MWWorld::Ptr& ptr, const osg::ref_ptr<Animation>& anim);
+
+    void addToInstancing(const MWWorld::Ptr& ptr, Animation* anim);
 
 public:
     Objects(Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Group> rootNode, SceneUtil::UnrefQueue* unrefQueue);
@@ -89,9 +165,42 @@ public:
 
     void removeCell(const MWWorld::CellStore* store);
 
+    /// Keep the static models of unloaded cells for the given time in seconds, so they are not created again if
+    /// the cell is loaded within that time. 0 disables.
+    void setUnloadedCellExpiryDelay(double delay);
+
+    /// Destroy the models kept from unloaded cells. Must be called before the cells are destroyed.
+    void clearUnloadedCells();
+
     /// Updates containing cell for object rendering data
     void updatePtr(const MWWorld::Ptr &old, const MWWorld::Ptr &cur);
 
+    /// Draw identical static non-animated models of a cell with instanced draw calls, requires shaders.
+    void setInstancingEnabled(bool enabled);
+
+    /// Skip the update traversal of static models that no camera rendered in the last frame, so their controllers
+    /// don't run while nobody sees them. Must be called before any cell is loaded.
+    void setSkipUnseenStaticUpdates(bool enabled);
+
+    /// Merge static models used only once in a cell in the background, requires instancing.
+    /// Must be called before any cell is loaded.
+    void setMergingEnabled(bool enabled, SceneUtil::WorkQueue* workQueue);
+
+    /// Group the objects other than actors and lights into chunks of the given size in each cell. 0 disables.
+    /// @param queries Skip chunks while their bounding box was hidden behind other geometry on the screen in the last frame.
+    /// @param interiorVisibility Skip chunks of interiors that can't be seen from the region of the camera, computed in the
+    /// background by buildInteriorVisibility().
+    /// Must be called before any cell is loaded.
+    void setOcclusionCulling(float chunkSize, bool queries, bool interiorVisibility, SceneUtil::WorkQueue* workQueue);
+
+    /// Start computing which chunks of an interior can be seen from where, call once all of its objects are inserted.
+    void buildInteriorVisibility(const MWWorld::CellStore* store);
+
+    /// Must be called after changing position, rotation or scale of an object.
+    void transformChanged(const MWWorld::Ptr& ptr);
+
+    void update(double referenceTime);
+
 private:
     void operator = (const Objects&);
     Objects(const Objects&);
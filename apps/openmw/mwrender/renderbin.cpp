@@ -0,0 +1,112 @@
+#include "renderbin.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <osg/StateSet>
+
+#include <osgUtil/CullVisitor>
+#include <osgUtil/RenderLeaf>
+#include <osgUtil/RenderStage>
+#include <osgUtil/StateGraph>
+
+namespace
+{
+    typedef std::pair<const osg::StateAttribute*, const osg::StateAttribute*> StateKey; // Program, texture of unit 0
+
+    /// The innermost program and texture of the state sets applied by the state graph.
+    StateKey getStateKey(const osgUtil::StateGraph* stateGraph)
+    {
+        StateKey key (nullptr, nullptr);
+        for (; stateGraph && !(key.first && key.second); stateGraph = stateGraph->_parent)
+        {
+            const osg::StateSet* stateSet = stateGraph->_stateset;
+            if (!stateSet)
+                continue;
+            if (!key.first)
+                key.first = stateSet->getAttribute(osg::StateAttribute::PROGRAM);
+            if (!key.second)
+                key.second = stateSet->getTextureAttribute(0, osg::StateAttribute::TEXTURE);
+        }
+        return key;
+    }
+
+    bool isNearer(const osg::ref_ptr<osgUtil::RenderLeaf>& left, const osg::ref_ptr<osgUtil::RenderLeaf>& right)
+    {
+        return left->_depth < right->_depth;
+    }
+
+    /// Orders the draws of each state graph and the state graphs themselves by their nearest draw.
+    void sortFrontToBack(osgUtil::RenderBin::StateGraphList& stateGraphs)
+    {
+        std::vector<std::pair<float, osgUtil::StateGraph*> > sorted;
+        sorted.reserve(stateGraphs.size());
+        for (osgUtil::StateGraph* stateGraph : stateGraphs)
+        {
+            osgUtil::StateGraph::LeafList& leaves = stateGraph->_leaves;
+            std::stable_sort(leaves.begin(), leaves.end(), isNearer);
+            sorted.emplace_back(leaves.empty() ? 0.f : leaves.front()->_depth, stateGraph);
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [] (const std::pair<float, osgUtil::StateGraph*>& left, const std::pair<float, osgUtil::StateGraph*>& right)
+            { return left.first < right.first; });
+
+        for (std::size_t i = 0; i < sorted.size(); ++i)
+            stateGraphs[i] = sorted[i].second;
+    }
+}
+
+namespace MWRender
+{
+
+    SortOpaqueCallback::SortOpaqueCallback(bool byState, bool frontToBack)
+        : mByState(byState)
+        , mFrontToBack(frontToBack)
+    {
+    }
+
+    void SortOpaqueCallback::sortImplementation(osgUtil::RenderBin* bin)
+    {
+        bin->sortImplementation();
+
+        osgUtil::RenderBin::StateGraphList& stateGraphs = bin->getStateGraphList();
+
+        // The state sort below is stable, so it keeps this order for the draws with the same state
+        if (mFrontToBack)
+            sortFrontToBack(stateGraphs);
+
+        if (!mByState || stateGraphs.size() < 2)
+            return;
+
+        std::vector<std::pair<StateKey, osgUtil::StateGraph*> > sorted;
+        sorted.reserve(stateGraphs.size());
+        for (osgUtil::StateGraph* stateGraph : stateGraphs)
+            sorted.emplace_back(getStateKey(stateGraph), stateGraph);
+
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [] (const std::pair<StateKey, osgUtil::StateGraph*>& left, const std::pair<StateKey, osgUtil::StateGraph*>& right)
+            { return left.first < right.first; });
+
+        for (std::size_t i = 0; i < sorted.size(); ++i)
+            stateGraphs[i] = sorted[i].second;
+    }
+
+    SortOpaqueCullCallback::SortOpaqueCullCallback(bool byState, bool frontToBack)
+        : mSortCallback(new SortOpaqueCallback(byState, frontToBack))
+    {
+    }
+
+    void SortOpaqueCullCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        // Drawables without render bin details go to the render stage itself, which is the opaque default bin
+        osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+        osgUtil::RenderStage* stage = cv->getCurrentRenderStage();
+        if (stage && stage->getSortCallback() != mSortCallback)
+            stage->setSortCallback(mSortCallback);
+
+        traverse(node, nv);
+    }
+
+}
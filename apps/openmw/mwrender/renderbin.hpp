@@ -1,6 +1,10 @@
 #ifndef OPENMW_MWRENDER_RENDERBIN_H
 #define OPENMW_MWRENDER_RENDERBIN_H
 
+#include <osg/NodeCallback>
+
+#include <osgUtil/RenderBin>
+
 namespace MWRender
 {
 
@@ -16,6 +20,37 @@ namespace MWRender
         RenderBin_SunGlare = 13
     };
 
+    /// @brief Orders the draws of an opaque bin.
+    /// @par By state, the state graphs are ordered by their program and first texture, so consecutive draws share the
+    /// most expensive state. Front to back, the nearest draws come first, so the depth test rejects more of the hidden
+    /// fragments before they are shaded. With both, draws are ordered front to back among the same state.
+    /// Draws that are not ordered otherwise keep the order of the cull traversal.
+    /// @note Only meant for bins that are not depth sorted.
+    class SortOpaqueCallback : public osgUtil::RenderBin::SortCallback
+    {
+    public:
+        SortOpaqueCallback(bool byState, bool frontToBack);
+
+        virtual void sortImplementation(osgUtil::RenderBin* bin);
+
+    private:
+        bool mByState;
+        bool mFrontToBack;
+    };
+
+    /// @brief Cull callback that sorts the opaque default bin of the render stages drawing the subgraph with a
+    /// SortOpaqueCallback.
+    class SortOpaqueCullCallback : public osg::NodeCallback
+    {
+    public:
+        SortOpaqueCullCallback(bool byState, bool frontToBack);
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+    private:
+        osg::ref_ptr<SortOpaqueCallback> mSortCallback;
+    };
+
 }
 
 #endif
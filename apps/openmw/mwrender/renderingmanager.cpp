@@ -38,13 +38,17 @@
 #include <components/sceneutil/workqueue.hpp>
 #include <components/sceneutil/unrefqueue.hpp>
 #include <components/sceneutil/writescene.hpp>
+#include <components/sceneutil/memoryusage.hpp>
 #include <components/sceneutil/shadow.hpp>
 
+#include <components/nifosg/particle.hpp>
+
 #include <components/terrain/terraingrid.hpp>
 #include <components/terrain/quadtreeworld.hpp>
 
 #include <components/esm/loadcell.hpp>
 #include <components/fallback/fallback.hpp>
+#include <components/misc/constants.hpp>
 
 #include <components/detournavigator/navigator.hpp>
 
@@ -67,6 +71,8 @@
 #include "util.hpp"
 #include "navmesh.hpp"
 #include "actorspaths.hpp"
+#include "objectpaging.hpp"
+#include "renderbin.hpp"
 
 namespace
 {
@@ -193,9 +199,27 @@ namespace MWRender
         Resource::ResourceSystem* mResourceSystem;
     };
 
+    /// Updates the shader programs before drawing, see ShaderManager::updatePrograms.
+    class UpdateResourcesCallback : public osg::Camera::DrawCallback
+    {
+    public:
+        UpdateResourcesCallback(Shader::ShaderManager* shaderManager)
+            : mShaderManager(shaderManager)
+        {
+        }
+
+        virtual void operator () (osg::RenderInfo& renderInfo) const
+        {
+            mShaderManager->updatePrograms(*renderInfo.getState());
+        }
+
+    private:
+        Shader::ShaderManager* mShaderManager;
+    };
+
     RenderingManager::RenderingManager(osgViewer::Viewer* viewer, osg::ref_ptr<osg::Group> rootNode,
                                        Resource::ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue,
-                                       const std::string& resourcePath, DetourNavigator::Navigator& navigator)
+                                       const std::string& resourcePath, const std::string& userDataPath, DetourNavigator::Navigator& navigator)
         : mViewer(viewer)
         , mRootNode(rootNode)
         , mResourceSystem(resourceSystem)
@@ -226,6 +250,7 @@ namespace MWRender
         resourceSystem->getSceneManager()->setNormalHeightMapPattern(Settings::Manager::getString("normal height map pattern", "Shaders"));
         resourceSystem->getSceneManager()->setAutoUseSpecularMaps(Settings::Manager::getBool("auto use object specular maps", "Shaders"));
         resourceSystem->getSceneManager()->setSpecularMapPattern(Settings::Manager::getString("specular map pattern", "Shaders"));
+        resourceSystem->getSceneManager()->setReducedShaderPermutations(Settings::Manager::getBool("reduce shader permutations", "Shaders"));
 
         osg::ref_ptr<SceneUtil::LightManager> sceneRoot = new SceneUtil::LightManager;
         sceneRoot->setLightingMask(Mask_Lighting);
@@ -244,6 +269,22 @@ namespace MWRender
         if (Settings::Manager::getBool("object shadows", "Shadows"))
             shadowCastingTraversalMask |= (Mask_Object|Mask_Static);
 
+        // Skinning, morphing, instancing and heightmap shader code has to be known before the shadow casting shader is created
+        const bool gpuSkinning = Settings::Manager::getBool("gpu skinning", "Shaders") && resourceSystem->getSceneManager()->getForceShaders();
+        const bool gpuMorphing = Settings::Manager::getBool("gpu morphing", "Shaders") && resourceSystem->getSceneManager()->getForceShaders();
+        const bool objectInstancing = Settings::Manager::getBool("object instancing", "Shaders") && resourceSystem->getSceneManager()->getForceShaders();
+        const bool terrainHeightmap = Settings::Manager::getBool("gpu displacement", "Terrain");
+        resourceSystem->getSceneManager()->setGpuSkinning(gpuSkinning);
+        resourceSystem->getSceneManager()->setGpuMorphing(gpuMorphing);
+        {
+            Shader::ShaderManager::DefineMap vertexDefines = resourceSystem->getSceneManager()->getShaderManager().getGlobalDefines();
+            vertexDefines["gpuSkinning"] = gpuSkinning ? "1" : "0";
+            vertexDefines["gpuMorphing"] = gpuMorphing ? "1" : "0";
+            vertexDefines["objectInstancing"] = objectInstancing ? "1" : "0";
+            vertexDefines["terrainHeightmap"] = terrainHeightmap ? "1" : "0";
+            resourceSystem->getSceneManager()->getShaderManager().setGlobalDefines(vertexDefines);
+        }
+
         mShadowManager.reset(new SceneUtil::ShadowManager(sceneRoot, mRootNode, shadowCastingTraversalMask, indoorShadowCastingTraversalMask, mResourceSystem->getSceneManager()->getShaderManager()));
 
         Shader::ShaderManager::DefineMap shadowDefines = mShadowManager->getShadowDefines();
@@ -255,6 +296,10 @@ namespace MWRender
         globalDefines["forcePPL"] = Settings::Manager::getBool("force per pixel lighting", "Shaders") ? "1" : "0";
         globalDefines["clamp"] = Settings::Manager::getBool("clamp lighting", "Shaders") ? "1" : "0";
 
+        const bool clusteredLighting = Settings::Manager::getBool("clustered lighting", "Shaders") && resourceSystem->getSceneManager()->getForceShaders();
+        globalDefines["clusteredLighting"] = clusteredLighting ? "1" : "0";
+        sceneRoot->setClusteredLighting(clusteredLighting);
+
         // It is unnecessary to stop/start the viewer as no frames are being rendered yet.
         mResourceSystem->getSceneManager()->getShaderManager().setGlobalDefines(globalDefines);
 
@@ -263,6 +308,13 @@ namespace MWRender
         mPathgrid.reset(new Pathgrid(mRootNode));
 
         mObjects.reset(new Objects(mResourceSystem, sceneRoot, mUnrefQueue.get()));
+        mObjects->setInstancingEnabled(objectInstancing);
+        mObjects->setMergingEnabled(objectInstancing && Settings::Manager::getBool("merge static objects", "Shaders"), mWorkQueue.get());
+        mObjects->setUnloadedCellExpiryDelay(Settings::Manager::getFloat("unloaded cell objects expiry delay", "Cells"));
+        mObjects->setSkipUnseenStaticUpdates(Settings::Manager::getBool("skip unseen static updates", "Cells"));
+        mObjects->setOcclusionCulling(std::max(128.f, Settings::Manager::getFloat("occlusion culling chunk size", "Camera")),
+            Settings::Manager::getBool("occlusion culling", "Camera"),
+            Settings::Manager::getBool("precomputed interior visibility", "Camera"), mWorkQueue.get());
 
         if (getenv("OPENMW_DONT_PRECOMPILE") == nullptr)
         {
@@ -273,9 +325,24 @@ namespace MWRender
 
         mResourceSystem->getSceneManager()->setIncrementalCompileOperation(mViewer->getIncrementalCompileOperation());
 
+        Resource::ImageManager* imageManager = mResourceSystem->getImageManager();
+        const bool asyncTextureDecoding = Settings::Manager::getBool("async texture decoding", "General");
+        if (Settings::Manager::getBool("texture streaming", "General"))
+            imageManager->setTextureStreaming(std::max(Settings::Manager::getInt("texture streaming initial size", "General"), 1),
+                static_cast<std::size_t>(std::max(Settings::Manager::getInt("texture streaming budget", "General"), 0)) * 1024 * 1024);
+        if (asyncTextureDecoding || imageManager->getTextureStreamingSize() > 0)
+        {
+            imageManager->setWorkQueue(mWorkQueue.get());
+            imageManager->setAsyncDecoding(asyncTextureDecoding);
+        }
+        mViewer->getCamera()->setPreDrawCallback(new UpdateResourcesCallback(&mResourceSystem->getSceneManager()->getShaderManager()));
+
         mEffectManager.reset(new EffectManager(sceneRoot, mResourceSystem));
 
-        mWater.reset(new Water(mRootNode, sceneRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(), resourcePath));
+        // With a cull thread per camera, the water reflection and refraction cameras are culled in parallel to the main camera
+        const bool rttSlaveCameras = Settings::Manager::getString("viewer threading model", "General") == "CullThreadPerCameraDrawThreadPerContext";
+        mWater.reset(new Water(mRootNode, sceneRoot, mResourceSystem, mViewer->getIncrementalCompileOperation(), resourcePath,
+                               rttSlaveCameras ? mViewer.get() : nullptr));
 
         DLLandFogStart = Settings::Manager::getFloat("distant land fog start", "Fog");
         DLLandFogEnd = Settings::Manager::getFloat("distant land fog end", "Fog");
@@ -305,14 +372,29 @@ namespace MWRender
             const int vertexLodMod = Settings::Manager::getInt("vertex lod mod", "Terrain");
             float maxCompGeometrySize = Settings::Manager::getFloat("max composite geometry size", "Terrain");
             maxCompGeometrySize = std::max(maxCompGeometrySize, 1.f);
-            mTerrain.reset(new Terrain::QuadTreeWorld(
+            Terrain::QuadTreeWorld* quadTreeWorld = new Terrain::QuadTreeWorld(
                 sceneRoot, mRootNode, mResourceSystem, mTerrainStorage, Mask_Terrain, Mask_PreCompile, Mask_Debug,
-                compMapResolution, compMapLevel, lodFactor, vertexLodMod, maxCompGeometrySize));
+                compMapResolution, compMapLevel, lodFactor, vertexLodMod, maxCompGeometrySize);
+            mTerrain.reset(quadTreeWorld);
+
+            if (Settings::Manager::getBool("object paging", "Terrain"))
+            {
+                mObjectPaging.reset(new ObjectPaging(mResourceSystem->getSceneManager(), Constants::CellSizeInUnits));
+                mObjectPaging->setMinSize(Settings::Manager::getFloat("object paging min size", "Terrain"));
+                quadTreeWorld->addChunkManager(mObjectPaging.get());
+                mResourceSystem->addResourceManager(mObjectPaging.get());
+            }
         }
         else
             mTerrain.reset(new Terrain::TerrainGrid(sceneRoot, mRootNode, mResourceSystem, mTerrainStorage, Mask_Terrain, Mask_PreCompile, Mask_Debug));
 
         mTerrain->setTargetFrameRate(Settings::Manager::getFloat("target framerate", "Cells"));
+        mTerrain->setPackBlendmaps(Settings::Manager::getBool("packed blendmaps", "Terrain"));
+        mTerrain->setCompactVertices(Settings::Manager::getBool("compact vertex format", "Terrain"));
+        mTerrain->setGpuDisplacement(terrainHeightmap);
+        if (Settings::Manager::getBool("composite map disk cache", "Terrain"))
+            mTerrain->setCompositeMapDiskCache(userDataPath + "/compositemapcache",
+                static_cast<std::uint64_t>(std::max(0, Settings::Manager::getInt("composite map disk cache size", "Terrain"))));
         mTerrain->setWorkQueue(mWorkQueue.get());
 
         mCamera.reset(new Camera(mViewer->getCamera()));
@@ -352,6 +434,15 @@ namespace MWRender
         mStateUpdater = new StateUpdater;
         sceneRoot->addUpdateCallback(mStateUpdater);
 
+        int particleUpdateThreads = Settings::Manager::getInt("particle update threads", "General");
+        if (particleUpdateThreads > 0)
+            sceneRoot->addUpdateCallback(new NifOsg::ParallelParticleUpdater(particleUpdateThreads));
+
+        const bool sortByState = Settings::Manager::getBool("sort draws by state", "Camera");
+        const bool sortFrontToBack = Settings::Manager::getBool("sort draws front to back", "Camera");
+        if (sortByState || sortFrontToBack)
+            sceneRoot->addCullCallback(new SortOpaqueCullCallback(sortByState, sortFrontToBack));
+
         osg::Camera::CullingMode cullingMode = osg::Camera::DEFAULT_CULLING|osg::Camera::FAR_PLANE_CULLING;
 
         if (!Settings::Manager::getBool("small feature culling", "Camera"))
@@ -379,6 +470,11 @@ namespace MWRender
 
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("near", mNearClip));
         mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("far", mViewDistance));
+        // Enabled by RigGeometry with GPU skinning, MorphGeometry with GPU morphing, instanced batches and displaced terrain only
+        mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("skinningEnabled", false));
+        mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("morphingEnabled", false));
+        mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("instancingEnabled", false));
+        mRootNode->getOrCreateStateSet()->addUniform(new osg::Uniform("heightmapEnabled", false));
 
         mUniformNear = mRootNode->getOrCreateStateSet()->getUniform("near");
         mUniformFar = mRootNode->getOrCreateStateSet()->getUniform("far");
@@ -387,8 +483,15 @@ namespace MWRender
 
     RenderingManager::~RenderingManager()
     {
+        // the image manager holds the work queue while decoding asynchronously
+        mResourceSystem->getImageManager()->setWorkQueue(nullptr);
+        mViewer->getCamera()->setPreDrawCallback(nullptr);
+
         // let background loading thread finish before we delete anything else
         mWorkQueue = nullptr;
+
+        if (mObjectPaging)
+            mResourceSystem->removeResourceManager(mObjectPaging.get());
     }
 
     MWRender::Objects& RenderingManager::getObjects()
@@ -513,6 +616,8 @@ namespace MWRender
 
         if (store->getCell()->isExterior())
             mTerrain->loadCell(store->getCell()->getGridX(), store->getCell()->getGridY());
+        else
+            mObjects->buildInteriorVisibility(store);
     }
     void RenderingManager::removeCell(const MWWorld::CellStore *store)
     {
@@ -639,6 +744,13 @@ namespace MWRender
 
         mUnrefQueue->flush(mWorkQueue.get());
 
+        // Move decoded textures into their placeholders and streamed mip levels into their images while no
+        // cull traversal reads them, see ImageManager::setAsyncDecoding and ImageManager::setTextureStreaming.
+        // Texture data to upload per frame at most, unless a single texture is larger.
+        const std::size_t maxImageBytes = 4 * 1024 * 1024;
+        mResourceSystem->getImageManager()->updateAsyncImages(maxImageBytes);
+        mResourceSystem->getImageManager()->updateStreaming(maxImageBytes);
+
         if (!paused)
         {
             mEffectManager->update(dt);
@@ -648,6 +760,8 @@ namespace MWRender
 
         updateNavMesh();
 
+        mObjects->update(getReferenceTime());
+
         mCamera->update(dt, paused);
 
         osg::Vec3f focal, cameraPos;
@@ -692,16 +806,19 @@ namespace MWRender
         }
 
         ptr.getRefData().getBaseNode()->setAttitude(rot);
+        mObjects->transformChanged(ptr);
     }
 
     void RenderingManager::moveObject(const MWWorld::Ptr &ptr, const osg::Vec3f &pos)
     {
         ptr.getRefData().getBaseNode()->setPosition(pos);
+        mObjects->transformChanged(ptr);
     }
 
     void RenderingManager::scaleObject(const MWWorld::Ptr &ptr, const osg::Vec3f &scale)
     {
         ptr.getRefData().getBaseNode()->setScale(scale);
+        mObjects->transformChanged(ptr);
 
         if (ptr == mCamera->getTrackingPtr()) // update height of camera
             mCamera->processViewChange();
@@ -961,8 +1078,12 @@ namespace MWRender
         rttCamera->setUpdateCallback(new NoTraverseCallback);
         rttCamera->addChild(mSceneRoot);
 
-        rttCamera->addChild(mWater->getReflectionCamera());
-        rttCamera->addChild(mWater->getRefractionCamera());
+        // Slave cameras already render the reflection and refraction of the main view in this frame
+        if (!mWater->hasSlaveCameras())
+        {
+            rttCamera->addChild(mWater->getReflectionCamera());
+            rttCamera->addChild(mWater->getRefractionCamera());
+        }
 
         rttCamera->setCullMask(mViewer->getCamera()->getCullMask() & (~Mask_GUI));
 
@@ -1410,6 +1531,11 @@ namespace MWRender
         SceneUtil::writeScene(node, filename, format);
     }
 
+    std::size_t RenderingManager::estimateTextureMemory(std::size_t& numTextures)
+    {
+        return SceneUtil::estimateTextureMemory(*mViewer->getSceneData(), numTextures);
+    }
+
     LandManager *RenderingManager::getLandManager() const
     {
         return mTerrainStorage->getLandManager();
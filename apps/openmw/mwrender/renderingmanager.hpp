@@ -76,6 +76,7 @@ namespace MWRender
     class Pathgrid;
     class Camera;
     class Water;
+    class ObjectPaging;
     class TerrainStorage;
     class LandManager;
     class NavMesh;
@@ -86,7 +87,7 @@ namespace MWRender
     public:
         RenderingManager(osgViewer::Viewer* viewer, osg::ref_ptr<osg::Group> rootNode,
                          Resource::ResourceSystem* resourceSystem, SceneUtil::WorkQueue* workQueue,
-                         const std::string& resourcePath, DetourNavigator::Navigator& navigator);
+                         const std::string& resourcePath, const std::string& userDataPath, DetourNavigator::Navigator& navigator);
         ~RenderingManager();
 
         MWRender::Objects& getObjects();
@@ -219,6 +220,10 @@ namespace MWRender
 
         void exportSceneGraph(const MWWorld::Ptr& ptr, const std::string& filename, const std::string& format);
 
+        /// Estimate the GPU memory used by the textures of the scene graph, in bytes.
+        /// @param numTextures Set to the number of distinct textures.
+        std::size_t estimateTextureMemory(std::size_t& numTextures);
+
         LandManager* getLandManager() const;
 
         bool toggleBorders();
@@ -263,6 +268,7 @@ namespace MWRender
         std::unique_ptr<Pathgrid> mPathgrid;
         std::unique_ptr<Objects> mObjects;
         std::unique_ptr<Water> mWater;
+        std::unique_ptr<ObjectPaging> mObjectPaging;
         std::unique_ptr<Terrain::World> mTerrain;
         TerrainStorage* mTerrainStorage;
         std::unique_ptr<SkyManager> mSky;
@@ -133,8 +133,12 @@ void RippleSimulation::update(float dt)
 
         osg::Vec3f currentPos (ptr.getRefData().getPosition().asVec3());
 
+        // Most emitters stand still, check the distance first to skip the water and physics queries for them
+        if ((currentPos - emitter.mLastEmitPosition).length2() <= 10 * 10)
+            continue;
+
         bool shouldEmit = (world->isUnderwater(ptr.getCell(), currentPos) && !world->isSubmerged(ptr)) || world->isWalkingOnWater(ptr);
-        if (shouldEmit && (currentPos - emitter.mLastEmitPosition).length() > 10)
+        if (shouldEmit)
         {
             emitter.mLastEmitPosition = currentPos;
 
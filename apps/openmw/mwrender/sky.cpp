@@ -43,6 +43,9 @@
 #include <components/sceneutil/controller.hpp>
 #include <components/sceneutil/visitor.hpp>
 #include <components/sceneutil/shadow.hpp>
+#include <components/settings/settings.hpp>
+#include <components/shader/shadermanager.hpp>
+#include <components/debug/debuglog.hpp>
 
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
@@ -369,11 +372,11 @@ public:
             }
             else if (mMeshType == 2)
             {
-                if (geom->getColorArray())
-                {
-                    osg::Vec4Array* origColors = static_cast<osg::Vec4Array*>(geom->getColorArray());
+                // The NIF loader may store vertex colors as floats or normalized bytes
+                if (const osg::Vec4Array* origColors = dynamic_cast<const osg::Vec4Array*>(geom->getColorArray()))
                     alpha = ((*origColors)[i].x() == 1.f) ? 1.f : 0.f;
-                }
+                else if (const osg::Vec4ubArray* origCompactColors = dynamic_cast<const osg::Vec4ubArray*>(geom->getColorArray()))
+                    alpha = ((*origCompactColors)[i].r() == 255) ? 1.f : 0.f;
                 else
                     alpha = 1.f;
             }
@@ -1107,6 +1110,7 @@ SkyManager::SkyManager(osg::Group* parentNode, Resource::SceneManager* sceneMana
     , mDay(0)
     , mMonth(0)
     , mCloudAnimationTimer(0.f)
+    , mGpuRain(Settings::Manager::getBool("gpu rain", "Shaders"))
     , mRainTimer(0.f)
     , mStormDirection(0,1,0)
     , mClouds()
@@ -1461,15 +1465,19 @@ void SkyManager::createRain()
 
     mRainNode = new osg::Group;
 
-    mRainParticleSystem = new osgParticle::ParticleSystem;
-    osg::Vec3 rainRange = osg::Vec3(mRainDiameter, mRainDiameter, (mRainMinHeight+mRainMaxHeight)/2.f);
+    if (!mGpuRain || !createGpuRain())
+        createCpuRain();
 
-    mRainParticleSystem->setParticleAlignment(osgParticle::ParticleSystem::FIXED);
-    mRainParticleSystem->setAlignVectorX(osg::Vec3f(0.1,0,0));
-    mRainParticleSystem->setAlignVectorY(osg::Vec3f(0,0,1));
+    mRainFader = new RainFader(&mWeatherAlpha);
+    mRainNode->addUpdateCallback(mRainFader);
+    mRainNode->addCullCallback(mUnderwaterSwitch);
+    mRainNode->setNodeMask(Mask_WeatherParticles);
 
-    osg::ref_ptr<osg::StateSet> stateset (mRainParticleSystem->getOrCreateStateSet());
+    mRootNode->addChild(mRainNode);
+}
 
+void SkyManager::setupRainStateSet(osg::StateSet* stateset)
+{
     osg::ref_ptr<osg::Texture2D> raindropTex (new osg::Texture2D(mSceneManager->getImageManager()->getImage("textures/tx_raindrop_01.dds")));
     raindropTex->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
     raindropTex->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
@@ -1479,6 +1487,121 @@ void SkyManager::createRain()
     stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
     stateset->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
     stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+}
+
+bool SkyManager::createGpuRain()
+{
+    Shader::ShaderManager& shaderMgr = mSceneManager->getShaderManager();
+    Shader::ShaderManager::DefineMap defineMap;
+    osg::ref_ptr<osg::Shader> vertexShader (shaderMgr.getShader("rain_vertex.glsl", defineMap, osg::Shader::VERTEX));
+    osg::ref_ptr<osg::Shader> fragmentShader (shaderMgr.getShader("rain_fragment.glsl", defineMap, osg::Shader::FRAGMENT));
+    if (!vertexShader || !fragmentShader)
+    {
+        Log(Debug::Warning) << "Failed to load rain shaders, using particles instead";
+        return false;
+    }
+
+    mRainGeometry = createRainGeometry(0);
+
+    osg::StateSet* stateset = mRainGeometry->getOrCreateStateSet();
+    setupRainStateSet(stateset);
+    // The sky root forbids shaders for everything that doesn't protect its own program
+    stateset->setAttributeAndModes(shaderMgr.getProgram(vertexShader, fragmentShader),
+                                   osg::StateAttribute::ON|osg::StateAttribute::PROTECTED);
+    stateset->addUniform(new osg::Uniform("diffuseMap", 0));
+
+    // The uniforms are changed every frame
+    stateset->setDataVariance(osg::Object::DYNAMIC);
+    mRainRangeUniform = new osg::Uniform("rainRange", osg::Vec3f());
+    mRainOffsetUniform = new osg::Uniform("rainOffset", osg::Vec3f());
+    mRainVelocityUniform = new osg::Uniform("rainVelocity", osg::Vec3f(0, 0, -1));
+    stateset->addUniform(mRainRangeUniform);
+    stateset->addUniform(mRainOffsetUniform);
+    stateset->addUniform(mRainVelocityUniform);
+    mRainOffset = osg::Vec3d();
+
+    mRainNode->addChild(mRainGeometry);
+    return true;
+}
+
+osg::ref_ptr<osg::Geometry> SkyManager::createRainGeometry(int count)
+{
+    // Every vertex of a drop gets the same seed, the position of the drop in the unit box
+    osg::ref_ptr<osg::Vec3Array> seeds (new osg::Vec3Array);
+    osg::ref_ptr<osg::Vec3Array> corners (new osg::Vec3Array);
+    seeds->reserve(count * 4);
+    corners->reserve(count * 4);
+    static const osg::Vec2f quad[4] = { osg::Vec2f(0,0), osg::Vec2f(1,0), osg::Vec2f(1,1), osg::Vec2f(0,1) };
+    for (int i = 0; i < count; ++i)
+    {
+        osg::Vec3f seed (Misc::Rng::rollProbability(), Misc::Rng::rollProbability(), Misc::Rng::rollProbability());
+        float size = 5.f + 10.f * Misc::Rng::rollProbability();
+        for (const osg::Vec2f& corner : quad)
+        {
+            seeds->push_back(seed);
+            corners->push_back(osg::Vec3f(corner, size));
+        }
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry (new osg::Geometry);
+    geometry->setUseDisplayList(false);
+    geometry->setUseVertexBufferObjects(true);
+    geometry->setVertexArray(seeds);
+    geometry->setTexCoordArray(0, corners, osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, count * 4));
+    // The drops are placed in the vertex shader
+    geometry->setCullingActive(false);
+    return geometry;
+}
+
+void SkyManager::setRainDropCount(int count)
+{
+    if (static_cast<int>(mRainGeometry->getVertexArray()->getNumElements()) == count * 4)
+        return;
+
+    // Replace the geometry instead of changing its arrays, the old one may still be drawn
+    osg::ref_ptr<osg::Geometry> geometry = createRainGeometry(count);
+    geometry->setStateSet(mRainGeometry->getStateSet());
+    mRainNode->replaceChild(mRainGeometry, geometry);
+    mRainGeometry = geometry;
+}
+
+void SkyManager::updateRainOffset(float duration)
+{
+    if (!mRainGeometry)
+        return;
+
+    // Stop the drops underwater, like the particles are frozen
+    if (!mUnderwaterSwitch->isUnderwater())
+        mRainOffset += osg::Vec3d(mRainVelocity) * duration;
+
+    // Drops in a fixed place of the world move against the camera. Wrapped by the range, so the shader keeps its precision
+    // far from the origin, which doesn't move the drops since they wrap around at the range anyway.
+    const osg::Vec3f range = osg::Vec3f(mRainDiameter, mRainDiameter, (mRainMinHeight+mRainMaxHeight)/2.f);
+    osg::Vec3d offset = mRainOffset;
+    if (mCamera)
+        offset -= mCamera->getInverseViewMatrix().getTrans();
+    for (int i = 0; i < 3; ++i)
+    {
+        if (range[i] > 0.f)
+        {
+            mRainOffset[i] = std::fmod(mRainOffset[i], static_cast<double>(range[i]));
+            offset[i] = std::fmod(offset[i], static_cast<double>(range[i]));
+        }
+    }
+    mRainOffsetUniform->set(osg::Vec3f(offset));
+}
+
+void SkyManager::createCpuRain()
+{
+    mRainParticleSystem = new osgParticle::ParticleSystem;
+    osg::Vec3 rainRange = osg::Vec3(mRainDiameter, mRainDiameter, (mRainMinHeight+mRainMaxHeight)/2.f);
+
+    mRainParticleSystem->setParticleAlignment(osgParticle::ParticleSystem::FIXED);
+    mRainParticleSystem->setAlignVectorX(osg::Vec3f(0.1,0,0));
+    mRainParticleSystem->setAlignVectorY(osg::Vec3f(0,0,1));
+
+    setupRainStateSet(mRainParticleSystem->getOrCreateStateSet());
 
     osgParticle::Particle& particleTemplate = mRainParticleSystem->getDefaultParticleTemplate();
     particleTemplate.setSizeRange(osgParticle::rangef(5.f, 15.f));
@@ -1518,13 +1641,6 @@ void SkyManager::createRain()
     mRainNode->addChild(emitter);
     mRainNode->addChild(mRainParticleSystem);
     mRainNode->addChild(updater);
-
-    mRainFader = new RainFader(&mWeatherAlpha);
-    mRainNode->addUpdateCallback(mRainFader);
-    mRainNode->addCullCallback(mUnderwaterSwitch);
-    mRainNode->setNodeMask(Mask_WeatherParticles);
-
-    mRootNode->addChild(mRainNode);
 }
 
 void SkyManager::destroyRain()
@@ -1539,6 +1655,10 @@ void SkyManager::destroyRain()
     mRainParticleSystem = nullptr;
     mRainShooter = nullptr;
     mRainFader = nullptr;
+    mRainGeometry = nullptr;
+    mRainRangeUniform = nullptr;
+    mRainOffsetUniform = nullptr;
+    mRainVelocityUniform = nullptr;
 }
 
 SkyManager::~SkyManager()
@@ -1591,6 +1711,7 @@ void SkyManager::update(float duration)
     }
 
     switchUnderwaterRain();
+    updateRainOffset(duration);
 
     if (mIsStorm)
     {
@@ -1638,19 +1759,30 @@ void SkyManager::setMoonColour (bool red)
 
 void SkyManager::updateRainParameters()
 {
+    float angle = -std::atan(mWindSpeed/50.f);
+    osg::Vec3f velocity (0, mRainSpeed*std::sin(angle), -mRainSpeed/std::cos(angle));
+    osg::Vec3 rainRange = osg::Vec3(mRainDiameter, mRainDiameter, (mRainMinHeight+mRainMaxHeight)/2.f);
+    float dropsPerSecond = mRainMaxRaindrops/mRainEntranceSpeed*20;
+
     if (mRainShooter)
     {
-        float angle = -std::atan(mWindSpeed/50.f);
-        mRainShooter->setVelocity(osg::Vec3f(0, mRainSpeed*std::sin(angle), -mRainSpeed/std::cos(angle)));
+        mRainShooter->setVelocity(velocity);
         mRainShooter->setAngle(angle);
 
-        osg::Vec3 rainRange = osg::Vec3(mRainDiameter, mRainDiameter, (mRainMinHeight+mRainMaxHeight)/2.f);
-
         mPlacer->setXRange(-rainRange.x() / 2, rainRange.x() / 2);
         mPlacer->setYRange(-rainRange.y() / 2, rainRange.y() / 2);
         mPlacer->setZRange(-rainRange.z() / 2, rainRange.z() / 2);
 
-        mCounter->setNumberOfParticlesPerSecondToCreate(mRainMaxRaindrops/mRainEntranceSpeed*20);
+        mCounter->setNumberOfParticlesPerSecondToCreate(dropsPerSecond);
+    }
+
+    if (mRainGeometry)
+    {
+        mRainVelocity = velocity;
+        mRainVelocityUniform->set(velocity.length2() > 0.f ? velocity : osg::Vec3f(0, 0, -1));
+        mRainRangeUniform->set(rainRange);
+        // As many drops as there are particles, which live for a second
+        setRainDropCount(static_cast<int>(std::max(0.f, dropsPerSecond)));
     }
 }
 
@@ -6,6 +6,8 @@
 #include <vector>
 
 #include <osg/ref_ptr>
+#include <osg/Vec3d>
+#include <osg/Vec3f>
 #include <osg/Vec4f>
 #include <osg/Uniform>
 
@@ -16,10 +18,12 @@ namespace osg
 
 namespace osg
 {
+    class Geometry;
     class Group;
     class Node;
     class Material;
     class PositionAttitudeTransform;
+    class StateSet;
 }
 
 namespace osgParticle
@@ -186,7 +190,15 @@ namespace MWRender
         ///< no need to call this, automatically done on first enable()
 
         void createRain();
+        void createCpuRain();
+        /// Create the rain as drops animated in the vertex shader from the accumulated movement, or return false if
+        /// the shaders can't be found.
+        bool createGpuRain();
+        void setupRainStateSet(osg::StateSet* stateset);
+        osg::ref_ptr<osg::Geometry> createRainGeometry(int count);
+        void setRainDropCount(int count);
         void destroyRain();
+        void updateRainOffset(float duration);
         void switchUnderwaterRain();
         void updateRainParameters();
 
@@ -229,6 +241,14 @@ namespace MWRender
         osg::ref_ptr<RainShooter> mRainShooter;
         osg::ref_ptr<RainFader> mRainFader;
 
+        bool mGpuRain;
+        osg::ref_ptr<osg::Geometry> mRainGeometry;
+        osg::ref_ptr<osg::Uniform> mRainRangeUniform;
+        osg::ref_ptr<osg::Uniform> mRainOffsetUniform;
+        osg::ref_ptr<osg::Uniform> mRainVelocityUniform;
+        osg::Vec3d mRainOffset;
+        osg::Vec3f mRainVelocity;
+
         bool mCreated;
 
         bool mIsStorm;
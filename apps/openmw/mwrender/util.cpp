@@ -1,5 +1,6 @@
 #include "util.hpp"
 
+#include <osg/Geometry>
 #include <osg/Node>
 #include <osg/ValueObject>
 
@@ -64,4 +65,54 @@ void overrideTexture(const std::string &texture, Resource::ResourceSystem *resou
     node->setStateSet(stateset);
 }
 
+std::string getEffectPoolKey(const std::string& model, const std::string& texture, const char* setup)
+{
+    return std::string(setup) + '|' + model + '|' + texture;
+}
+
+bool canMergeGeometry(const osg::Geometry& geometry)
+{
+    if (geometry.getDataVariance() == osg::Object::DYNAMIC)
+        return false;
+
+    const osg::Array* vertices = geometry.getVertexArray();
+    if (!vertices || vertices->getType() != osg::Array::Vec3ArrayType || vertices->getBinding() != osg::Array::BIND_PER_VERTEX)
+        return false;
+
+    const osg::Array* normals = geometry.getNormalArray();
+    return !normals || (normals->getType() == osg::Array::Vec3ArrayType && normals->getBinding() == osg::Array::BIND_PER_VERTEX);
+}
+
+void transformGeometry(osg::Geometry& geometry, const osg::Matrixf& matrix)
+{
+    osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(geometry.getVertexArray());
+    for (osg::Vec3f& vertex : *vertices)
+        vertex = vertex * matrix;
+    vertices->dirty();
+
+    if (osg::Vec3Array* normals = static_cast<osg::Vec3Array*>(geometry.getNormalArray()))
+    {
+        for (osg::Vec3f& normal : *normals)
+        {
+            normal = osg::Matrixf::transform3x3(normal, matrix);
+            normal.normalize();
+        }
+        normals->dirty();
+    }
+
+    // Generated by the ShaderVisitor
+    if (osg::Vec4Array* tangents = dynamic_cast<osg::Vec4Array*>(geometry.getTexCoordArray(7)))
+    {
+        for (osg::Vec4f& tangent : *tangents)
+        {
+            osg::Vec3f direction = osg::Matrixf::transform3x3(osg::Vec3f(tangent.x(), tangent.y(), tangent.z()), matrix);
+            direction.normalize();
+            tangent = osg::Vec4f(direction, tangent.w());
+        }
+        tangents->dirty();
+    }
+
+    geometry.dirtyBound();
+}
+
 }
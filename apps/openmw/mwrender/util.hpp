@@ -7,6 +7,8 @@
 
 namespace osg
 {
+    class Geometry;
+    class Matrixf;
     class Node;
 }
 
@@ -23,6 +25,17 @@ namespace MWRender
 
     void overrideTexture(const std::string& texture, Resource::ResourceSystem* resourceSystem, osg::ref_ptr<osg::Node> node);
 
+    /// Key of the effect instances of a model that were set up the same way, to recycle them with SceneManager::recycleInstance().
+    /// @param setup Tells apart the ways the callers set up an instance, other than the texture override.
+    std::string getEffectPoolKey(const std::string& model, const std::string& texture, const char* setup);
+
+    /// @return Can the geometry be transformed by transformGeometry() and merged with others?
+    bool canMergeGeometry(const osg::Geometry& geometry);
+
+    /// Transform vertices, normals and generated tangents of a geometry in place.
+    /// @note The arrays must not be shared with other geometries.
+    void transformGeometry(osg::Geometry& geometry, const osg::Matrixf& matrix);
+
     // Node callback to entirely skip the traversal.
     class NoTraverseCallback : public osg::NodeCallback
     {
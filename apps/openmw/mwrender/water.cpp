@@ -10,6 +10,8 @@
 #include <osg/PositionAttitudeTransform>
 #include <osg/ClipNode>
 #include <osg/FrontFace>
+#include <osg/Viewport>
+#include <osg/View>
 
 #include <osgDB/ReadFile>
 
@@ -18,6 +20,9 @@
 
 #include <osgUtil/IncrementalCompileOperation>
 #include <osgUtil/CullVisitor>
+#include <osgViewer/Viewer>
+
+#include <OpenThreads/ScopedLock>
 
 #include <components/debug/debuglog.hpp>
 
@@ -161,8 +166,90 @@ private:
     osg::Plane mPlane;
 };
 
+/// Base of the reflection and refraction cameras. They are children of the scene graph and culled within the cull
+/// traversal of the main camera, or slave cameras of the viewer, which the viewer may cull in their own threads.
+class RTTCamera : public osg::Camera
+{
+public:
+    RTTCamera()
+        : mSlave(false)
+    {
+    }
+
+    /// Set the transformation from the view of the main camera to the view of this camera.
+    void setViewOffset(const osg::Matrix& viewOffset)
+    {
+        mViewOffset = viewOffset;
+        // Applied to the view of the parent camera by the RELATIVE_RF reference frame
+        if (!mSlave)
+            setViewMatrix(viewOffset);
+    }
+
+    /// Prepare to be added as a slave camera. The state of the scene graph above the camera is no longer inherited,
+    /// \a inheritedState replaces it.
+    void setSlave(osg::StateSet* inheritedState)
+    {
+        mSlave = true;
+        setReferenceFrame(osg::Camera::ABSOLUTE_RF);
+        setAllowEventFocus(false);
+
+        osg::ref_ptr<osg::Group> stateNode (new osg::Group);
+        stateNode->setStateSet(inheritedState);
+        for (unsigned int i=0; i<getNumChildren(); ++i)
+            stateNode->addChild(getChild(i));
+        removeChildren(0, getNumChildren());
+        addChild(stateNode);
+    }
+
+    bool isSlave() const
+    {
+        return mSlave;
+    }
+
+    /// Set up a slave camera from the main camera, like the RELATIVE_RF reference frame does for a child camera.
+    /// @note Called by the viewer in the update traversal.
+    void updateSlave(const osg::Camera& mainCamera)
+    {
+        inheritCullSettings(mainCamera, getInheritanceMask());
+        setProjectionMatrix(mainCamera.getProjectionMatrix());
+        mMainViewMatrix = mainCamera.getViewMatrix();
+        setViewMatrix(mViewOffset * mMainViewMatrix);
+    }
+
+    /// View matrix of the main camera at the last updateSlave.
+    const osg::Matrix& getMainViewMatrix() const
+    {
+        return mMainViewMatrix;
+    }
+
+    void setEnabled(bool enabled)
+    {
+        setNodeMask(enabled ? Mask_RenderToTexture : 0);
+        // Slave cameras are culled regardless of the node mask, they skip their traversal instead. The last rendered
+        // textures may still be shown, so they must not be cleared either.
+        if (mSlave)
+            setClearMask(enabled ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : 0);
+    }
+
+private:
+    bool mSlave;
+    osg::Matrix mViewOffset;
+    osg::Matrix mMainViewMatrix;
+};
+
+/// Sets up an RTTCamera that is a slave camera of the viewer.
+class UpdateRTTSlaveCallback : public osg::View::Slave::UpdateSlaveCallback
+{
+public:
+    virtual void updateSlave(osg::View& view, osg::View::Slave& slave)
+    {
+        static_cast<RTTCamera*>(slave._camera.get())->updateSlave(*view.getCamera());
+    }
+};
+
 /// This callback on the Camera has the effect of a RELATIVE_RF_INHERIT_VIEWPOINT transform mode (which does not exist in OSG).
 /// We want to keep the View Point of the parent camera so we will not have to recreate LODs.
+/// @note Must be the cull callback of an RTTCamera.
 class InheritViewPointCallback : public osg::NodeCallback
 {
 public:
@@ -171,13 +258,105 @@ public:
     virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
     {
         osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+        const RTTCamera* camera = static_cast<const RTTCamera*>(node);
+        // Slave cameras are culled even if they are disabled
+        if (camera->getNodeMask() == 0)
+            return;
+
         osg::ref_ptr<osg::RefMatrix> modelViewMatrix = new osg::RefMatrix(*cv->getModelViewMatrix());
         cv->popModelViewMatrix();
+        if (!camera->isSlave())
+        {
+            cv->pushModelViewMatrix(modelViewMatrix, osg::Transform::ABSOLUTE_RF_INHERIT_VIEWPOINT);
+            traverse(node, nv);
+            return;
+        }
+
+        // A slave camera is not culled below the main camera, so push the view of the main camera to inherit its view point
+        cv->pushModelViewMatrix(new osg::RefMatrix(camera->getMainViewMatrix()), osg::Transform::ABSOLUTE_RF);
         cv->pushModelViewMatrix(modelViewMatrix, osg::Transform::ABSOLUTE_RF_INHERIT_VIEWPOINT);
         traverse(node, nv);
+        cv->popModelViewMatrix();
+        cv->popModelViewMatrix();
+        cv->pushModelViewMatrix(modelViewMatrix, osg::Transform::ABSOLUTE_RF);
     }
 };
 
+/// Limits the distance of objects rendered by a camera, by adding a far plane to the culling frustum.
+/// Objects intersecting the plane are still rendered in full. Must be added as a Cull callback of the camera.
+class CullDistanceCallback : public osg::NodeCallback
+{
+public:
+    CullDistanceCallback(float distance)
+        : mDistance(distance)
+    {
+    }
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+
+        osg::Polytope::PlaneList origPlaneList = cv->getProjectionCullingStack().back().getFrustum().getPlaneList();
+
+        // in eye space, keeps everything closer than mDistance along the view direction
+        cv->getProjectionCullingStack().back().getFrustum().add(osg::Plane(0, 0, 1, mDistance));
+
+        traverse(node, nv);
+
+        // undo
+        cv->getProjectionCullingStack().back().getFrustum().set(origPlaneList);
+    }
+
+private:
+    float mDistance;
+};
+
+/// Records whether the water surface passed the culling of the main camera, and the view it was seen from.
+/// The reflection and refraction cameras are set up from this in the next update, so the first frame the water
+/// comes into view still shows the reflection and refraction textures of the last frame they were rendered.
+class WaterCullCallback : public osg::Drawable::CullCallback
+{
+public:
+    WaterCullCallback()
+        : mVisible(false)
+        , mEyeHeight(0.f)
+    {
+    }
+
+    virtual bool cull(osg::NodeVisitor* nv, osg::Drawable* drawable, osg::State*) const
+    {
+        osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+
+        // The cull callback runs before the cull visitor tests the bounding box, so test it here
+        if (drawable->isCullingActive() && cv->isCulled(drawable->getBoundingBox()))
+            return true;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mVisible = true;
+        mViewMatrix = *cv->getCurrentRenderStage()->getInitialViewMatrix();
+        // local to the water node, so this is the height above the water surface
+        mEyeHeight = cv->getEyeLocal().z();
+        return false;
+    }
+
+    /// @return Was the water visible since the last call?
+    bool getAndReset(osg::Matrixd& viewMatrix, float& eyeHeight)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const bool visible = mVisible;
+        mVisible = false;
+        viewMatrix = mViewMatrix;
+        eyeHeight = mEyeHeight;
+        return visible;
+    }
+
+private:
+    mutable OpenThreads::Mutex mMutex;
+    mutable bool mVisible;
+    mutable osg::Matrixd mViewMatrix;
+    mutable float mEyeHeight;
+};
+
 /// Moves water mesh away from the camera slightly if the camera gets too close on the Z axis.
 /// The offset works around graphics artifacts that occurred with the GL_DEPTH_CLAMP when the camera gets extremely close to the mesh (seen on NVIDIA at least).
 /// Must be added as a Cull callback.
@@ -229,7 +408,7 @@ osg::ref_ptr<osg::Image> readPngImage (const std::string& file)
 }
 
 
-class Refraction : public osg::Camera
+class Refraction : public RTTCamera
 {
 public:
     Refraction()
@@ -300,7 +479,7 @@ public:
         const float refractionScale = std::min(1.0f,std::max(0.0f,
             Settings::Manager::getFloat("refraction scale", "Water")));
 
-        setViewMatrix(osg::Matrix::scale(1,1,refractionScale) *
+        setViewOffset(osg::Matrix::scale(1,1,refractionScale) *
             osg::Matrix::translate(0,0,(1.0 - refractionScale) * waterLevel));
 
         mClipCullNode->setPlane(osg::Plane(osg::Vec3d(0,0,-1), osg::Vec3d(0,0, waterLevel)));
@@ -323,7 +502,7 @@ private:
     osg::ref_ptr<osg::Node> mScene;
 };
 
-class Reflection : public osg::Camera
+class Reflection : public RTTCamera
 {
 public:
     Reflection(bool isInterior)
@@ -336,6 +515,10 @@ public:
         setName("ReflectionCamera");
         setCullCallback(new InheritViewPointCallback);
 
+        float reflectionDistance = Settings::Manager::getFloat("reflection distance", "Water");
+        if (reflectionDistance > 0.f)
+            addCullCallback(new CullDistanceCallback(reflectionDistance));
+
         setInterior(isInterior);
         setNodeMask(Mask_RenderToTexture);
 
@@ -381,7 +564,7 @@ public:
 
     void setWaterLevel(float waterLevel)
     {
-        setViewMatrix(osg::Matrix::scale(1,1,-1) * osg::Matrix::translate(0,0,2 * waterLevel));
+        setViewOffset(osg::Matrix::scale(1,1,-1) * osg::Matrix::translate(0,0,2 * waterLevel));
         mClipCullNode->setPlane(osg::Plane(osg::Vec3d(0,0,1), osg::Vec3d(0,0,waterLevel)));
     }
 
@@ -427,15 +610,24 @@ public:
 };
 
 Water::Water(osg::Group *parent, osg::Group* sceneRoot, Resource::ResourceSystem *resourceSystem,
-             osgUtil::IncrementalCompileOperation *ico, const std::string& resourcePath)
+             osgUtil::IncrementalCompileOperation *ico, const std::string& resourcePath, osgViewer::Viewer* slaveViewer)
     : mParent(parent)
     , mSceneRoot(sceneRoot)
+    , mSlaveViewer(slaveViewer)
     , mResourceSystem(resourceSystem)
     , mResourcePath(resourcePath)
     , mEnabled(true)
     , mToggled(true)
     , mTop(0)
     , mInterior(false)
+    , mRTTEnabled(true)
+    , mRenderedLastFrame(false)
+    , mHalfRateWhenStationary(false)
+    , mRTTLodHeight(0.f)
+    , mRTTViewportSize(0)
+    , mRTTTargetFrameTime(0.f)
+    , mRTTFrameTime(0.f)
+    , mRTTFrameTimeScale(1.f)
 {
     mSimulation.reset(new RippleSimulation(mSceneRoot, resourceSystem));
 
@@ -453,12 +645,16 @@ Water::Water(osg::Group *parent, osg::Group* sceneRoot, Resource::ResourceSystem
     createSimpleWaterStateSet(geom2, Fallback::Map::getFloat("Water_Map_Alpha"));
     geom2->setNodeMask(Mask_SimpleWater);
     mWaterNode->addChild(geom2);
+
+    mCullCallback = new WaterCullCallback;
+    mWaterGeom->setCullCallback(mCullCallback);
  
     mSceneRoot->addChild(mWaterNode);
 
     setHeight(mTop);
 
     mRainIntensityUniform = new osg::Uniform("rainIntensity",(float) 0.0);
+    mRTTScaleUniform = new osg::Uniform("rttScale", osg::Vec2f(1.f, 1.f));
 
     updateWaterMaterial();
 
@@ -475,14 +671,12 @@ void Water::updateWaterMaterial()
 {
     if (mReflection)
     {
-        mReflection->removeChildren(0, mReflection->getNumChildren());
-        mParent->removeChild(mReflection);
+        removeRTTCamera(mReflection);
         mReflection = nullptr;
     }
     if (mRefraction)
     {
-        mRefraction->removeChildren(0, mRefraction->getNumChildren());
-        mParent->removeChild(mRefraction);
+        removeRTTCamera(mRefraction);
         mRefraction = nullptr;
     }
 
@@ -491,17 +685,26 @@ void Water::updateWaterMaterial()
         mReflection = new Reflection(mInterior);
         mReflection->setWaterLevel(mTop);
         mReflection->setScene(mSceneRoot);
-        mParent->addChild(mReflection);
+        addRTTCamera(mReflection);
 
         if (Settings::Manager::getBool("refraction", "Water"))
         {
             mRefraction = new Refraction;
             mRefraction->setWaterLevel(mTop);
             mRefraction->setScene(mSceneRoot);
-            mParent->addChild(mRefraction);
+            addRTTCamera(mRefraction);
         }
 
         createShaderWaterStateSet(mWaterGeom, mReflection, mRefraction);
+
+        mHalfRateWhenStationary = Settings::Manager::getBool("half rate when stationary", "Water");
+        mRTTLodHeight = Settings::Manager::getFloat("rtt lod height", "Water");
+        mRTTViewportSize = Settings::Manager::getInt("rtt size", "Water");
+        const float targetFrameRate = Settings::Manager::getFloat("rtt target framerate", "Water");
+        mRTTTargetFrameTime = targetFrameRate > 0.f ? 1.f / targetFrameRate : 0.f;
+        mRTTFrameTime = 0.f;
+        mRTTFrameTimeScale = 1.f;
+        mRTTScaleUniform->set(osg::Vec2f(1.f, 1.f));
     }
     else
         createSimpleWaterStateSet(mWaterGeom, Fallback::Map::getFloat("Water_World_Alpha"));
@@ -509,6 +712,48 @@ void Water::updateWaterMaterial()
     updateVisible();
 }
 
+void Water::addRTTCamera(RTTCamera* camera)
+{
+    if (!mSlaveViewer)
+    {
+        mParent->addChild(camera);
+        return;
+    }
+
+    camera->setSlave(mParent->getOrCreateStateSet());
+    camera->setGraphicsContext(mSlaveViewer->getCamera()->getGraphicsContext());
+
+    // The viewer sets up its cull threads for the cameras it has when the threads are started
+    mSlaveViewer->stopThreading();
+    mSlaveViewer->addSlave(camera, false);
+    mSlaveViewer->findSlaveForCamera(camera)->_updateSlaveCallback = new UpdateRTTSlaveCallback;
+    mSlaveViewer->startThreading();
+}
+
+void Water::removeRTTCamera(RTTCamera* camera)
+{
+    if (!camera->isSlave())
+    {
+        camera->removeChildren(0, camera->getNumChildren());
+        mParent->removeChild(camera);
+        return;
+    }
+
+    mSlaveViewer->stopThreading();
+    const unsigned int index = mSlaveViewer->findSlaveIndexForCamera(camera);
+    if (index < mSlaveViewer->getNumSlaves())
+        mSlaveViewer->removeSlave(index);
+    camera->setGraphicsContext(nullptr);
+    camera->setRenderer(nullptr);
+    camera->removeChildren(0, camera->getNumChildren());
+    mSlaveViewer->startThreading();
+}
+
+bool Water::hasSlaveCameras() const
+{
+    return mSlaveViewer != nullptr;
+}
+
 osg::Camera *Water::getReflectionCamera()
 {
     return mReflection;
@@ -608,6 +853,7 @@ void Water::createShaderWaterStateSet(osg::Node* node, Reflection* reflection, R
     shaderStateset->setMode(GL_CULL_FACE, osg::StateAttribute::OFF);
 
     shaderStateset->addUniform(mRainIntensityUniform.get());
+    shaderStateset->addUniform(mRTTScaleUniform.get());
 
     osg::ref_ptr<osg::Program> program (new osg::Program);
     program->addShader(vertexShader);
@@ -629,14 +875,12 @@ Water::~Water()
 
     if (mReflection)
     {
-        mReflection->removeChildren(0, mReflection->getNumChildren());
-        mParent->removeChild(mReflection);
+        removeRTTCamera(mReflection);
         mReflection = nullptr;
     }
     if (mRefraction)
     {
-        mRefraction->removeChildren(0, mRefraction->getNumChildren());
-        mParent->removeChild(mRefraction);
+        removeRTTCamera(mRefraction);
         mRefraction = nullptr;
     }
 }
@@ -701,6 +945,65 @@ void Water::setHeight(const float height)
 void Water::update(float dt)
 {
     mSimulation->update(dt);
+
+    if (mReflection)
+        updateRTTCameras(dt);
+}
+
+void Water::updateRTTCameras(float dt)
+{
+    osg::Matrixd viewMatrix;
+    float eyeHeight = 0.f;
+    const bool waterVisible = mCullCallback->getAndReset(viewMatrix, eyeHeight);
+
+    // Nothing to reflect or refract if the water surface is not on screen
+    bool render = waterVisible;
+    if (waterVisible)
+    {
+        // The scene still animates, so render every other frame instead of not at all
+        if (mHalfRateWhenStationary && mRenderedLastFrame && viewMatrix == mLastViewMatrix)
+            render = false;
+        mLastViewMatrix = viewMatrix;
+    }
+    mRenderedLastFrame = render;
+
+    if (mRTTTargetFrameTime > 0.f && dt > 0.f)
+    {
+        // Follow the average frame time, single slow frames like cell loading should not drop the resolution
+        mRTTFrameTime = mRTTFrameTime > 0.f ? mRTTFrameTime + (dt - mRTTFrameTime) * 0.1f : dt;
+        if (mRTTFrameTime > mRTTTargetFrameTime * 1.05f)
+            mRTTFrameTimeScale = std::max(0.25f, mRTTFrameTimeScale - 0.02f);
+        else if (mRTTFrameTime < mRTTTargetFrameTime * 0.9f)
+            mRTTFrameTimeScale = std::min(1.f, mRTTFrameTimeScale + 0.01f);
+    }
+
+    if (render && (mRTTLodHeight > 0.f || mRTTTargetFrameTime > 0.f))
+    {
+        const int rttSize = Settings::Manager::getInt("rtt size", "Water");
+        float scale = mRTTFrameTimeScale;
+        if (mRTTLodHeight > 0.f)
+            scale *= std::min(1.f, mRTTLodHeight / std::max(std::abs(eyeHeight), 1.f));
+        scale = std::max(0.25f, scale);
+        // Round to multiples of 16 pixels so the viewport does not change with every small camera movement
+        const int viewportSize = std::max(16, static_cast<int>(rttSize * scale) / 16 * 16);
+        if (viewportSize != mRTTViewportSize)
+        {
+            mRTTViewportSize = viewportSize;
+            // Create new viewports, the old ones may still be in use by the draw traversal
+            mReflection->setViewport(new osg::Viewport(0, 0, viewportSize, viewportSize));
+            if (mRefraction)
+                mRefraction->setViewport(new osg::Viewport(0, 0, viewportSize, viewportSize));
+            // Only the rendered part of the textures may be sampled, keep half a texel away from its border
+            mRTTScaleUniform->set(osg::Vec2f(viewportSize / static_cast<float>(rttSize),
+                                             (viewportSize - 0.5f) / static_cast<float>(rttSize)));
+        }
+    }
+
+    if (render != mRTTEnabled)
+    {
+        mRTTEnabled = render;
+        updateVisible();
+    }
 }
 
 void Water::updateVisible()
@@ -708,9 +1011,9 @@ void Water::updateVisible()
     bool visible = mEnabled && mToggled;
     mWaterNode->setNodeMask(visible ? ~0 : 0);
     if (mRefraction)
-        mRefraction->setNodeMask(visible ? Mask_RenderToTexture : 0);
+        mRefraction->setEnabled(visible && mRTTEnabled);
     if (mReflection)
-        mReflection->setNodeMask(visible ? Mask_RenderToTexture : 0);
+        mReflection->setEnabled(visible && mRTTEnabled);
 }
 
 bool Water::toggle()
@@ -8,6 +8,7 @@
 #include <osg/Vec3f>
 #include <osg/Uniform>
 #include <osg/Camera>
+#include <osg/Matrixd>
 
 #include <components/settings/settings.hpp>
 
@@ -24,6 +25,11 @@ namespace osgUtil
     class IncrementalCompileOperation;
 }
 
+namespace osgViewer
+{
+    class Viewer;
+}
+
 namespace Resource
 {
     class ResourceSystem;
@@ -43,17 +49,21 @@ namespace Fallback
 namespace MWRender
 {
 
+    class RTTCamera;
     class Refraction;
     class Reflection;
     class RippleSimulation;
+    class WaterCullCallback;
 
     /// Water rendering
     class Water
     {
         osg::ref_ptr<osg::Uniform> mRainIntensityUniform;
+        osg::ref_ptr<osg::Uniform> mRTTScaleUniform;
 
         osg::ref_ptr<osg::Group> mParent;
         osg::ref_ptr<osg::Group> mSceneRoot;
+        osgViewer::Viewer* mSlaveViewer;
         osg::ref_ptr<osg::PositionAttitudeTransform> mWaterNode;
         osg::ref_ptr<osg::Geometry> mWaterGeom;
         Resource::ResourceSystem* mResourceSystem;
@@ -63,6 +73,7 @@ namespace MWRender
 
         osg::ref_ptr<Refraction> mRefraction;
         osg::ref_ptr<Reflection> mReflection;
+        osg::ref_ptr<WaterCullCallback> mCullCallback;
 
         const std::string mResourcePath;
 
@@ -71,9 +82,25 @@ namespace MWRender
         float mTop;
         bool mInterior;
 
+        // Culling budget of the reflection and refraction cameras
+        bool mRTTEnabled;
+        bool mRenderedLastFrame;
+        osg::Matrixd mLastViewMatrix;
+        bool mHalfRateWhenStationary;
+        float mRTTLodHeight;
+        int mRTTViewportSize;
+        // Frame time to keep by scaling the reflection and refraction resolution, 0 when disabled
+        float mRTTTargetFrameTime;
+        float mRTTFrameTime;
+        float mRTTFrameTimeScale;
+
         osg::Vec3f getSceneNodeCoordinates(int gridX, int gridY);
         void updateVisible();
 
+        /// Decide whether the reflection and refraction cameras render this frame, and at which resolution.
+        /// @param dt Time since the last frame
+        void updateRTTCameras(float dt);
+
         void createSimpleWaterStateSet(osg::Node* node, float alpha);
 
         /// @param reflection the reflection camera (required)
@@ -82,10 +109,16 @@ namespace MWRender
 
         void updateWaterMaterial();
 
+        void addRTTCamera(RTTCamera* camera);
+        void removeRTTCamera(RTTCamera* camera);
+
     public:
+        /// @param slaveViewer If not null, the reflection and refraction cameras are added to it as slave cameras
+        ///  instead of children of \a parent, so a viewer with a cull thread per camera culls them in parallel to the
+        ///  main camera.
         Water(osg::Group* parent, osg::Group* sceneRoot,
               Resource::ResourceSystem* resourceSystem, osgUtil::IncrementalCompileOperation* ico,
-              const std::string& resourcePath);
+              const std::string& resourcePath, osgViewer::Viewer* slaveViewer = nullptr);
         ~Water();
 
         void listAssetsToPreload(std::vector<std::string>& textures);
@@ -114,6 +147,9 @@ namespace MWRender
         osg::Camera *getReflectionCamera();
         osg::Camera *getRefractionCamera();
 
+        /// Are the reflection and refraction cameras slave cameras of the viewer?
+        bool hasSlaveCameras() const;
+
         void processChangedSettings(const Settings::CategorySettingVector& settings);
 
         osg::Uniform *getRainIntensityUniform();
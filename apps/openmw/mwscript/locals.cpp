@@ -26,7 +26,7 @@ namespace MWScript
         }
     }
 
-    Locals::Locals() : mInitialised (false) {}
+    Locals::Locals() : mInitialised (false), mIdle (false) {}
 
     bool Locals::configure (const ESM::Script& script)
     {
@@ -44,9 +44,23 @@ namespace MWScript
         mFloats.resize (locals.get ('f').size(), 0);
 
         mInitialised = true;
+        mIdle = false;
         return true;
     }
 
+    void Locals::setIdle()
+    {
+        mIdleShorts = mShorts;
+        mIdleLongs = mLongs;
+        mIdleFloats = mFloats;
+        mIdle = true;
+    }
+
+    bool Locals::isIdle() const
+    {
+        return mIdle && mShorts == mIdleShorts && mLongs == mIdleLongs && mFloats == mIdleFloats;
+    }
+
     bool Locals::isEmpty() const
     {
         return (mShorts.empty() && mLongs.empty() && mFloats.empty());
@@ -75,10 +89,9 @@ namespace MWScript
 
         const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
         int index = locals.getIndex(var);
-        char type = locals.getType(var);
         if(index != -1)
         {
-            switch(type)
+            switch(locals.getType(var))
             {
                 case 's':
                     return mShorts.at (index);
@@ -101,10 +114,9 @@ namespace MWScript
 
         const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
         int index = locals.getIndex(var);
-        char type = locals.getType(var);
         if(index != -1)
         {
-            switch(type)
+            switch(locals.getType(var))
             {
                 case 's':
                     return mShorts.at (index);
@@ -127,10 +139,9 @@ namespace MWScript
 
         const Compiler::Locals& locals = MWBase::Environment::get().getScriptManager()->getLocals(script);
         int index = locals.getIndex(var);
-        char type = locals.getType(var);
         if(index != -1)
         {
-            switch(type)
+            switch(locals.getType(var))
             {
                 case 's':
                     mShorts.at (index) = val; break;
@@ -17,6 +17,12 @@ namespace MWScript
     {
             bool mInitialised;
 
+            // Values of the last run that only read these locals, see setIdle
+            bool mIdle;
+            std::vector<Interpreter::Type_Short> mIdleShorts;
+            std::vector<Interpreter::Type_Integer> mIdleLongs;
+            std::vector<Interpreter::Type_Float> mIdleFloats;
+
             void ensure (const std::string& scriptName);
 
         public:
@@ -34,6 +40,13 @@ namespace MWScript
             /// \return Did the state of *this change from uninitialised to initialised?
             bool configure (const ESM::Script& script);
 
+            /// Remember the current values after a run of the script that only read them. Running the script
+            /// again with the same values would do nothing new.
+            void setIdle();
+
+            /// Are the values the same as at the last setIdle?
+            bool isIdle() const;
+
             /// @note var needs to be in lowercase
             ///
             /// \note Locals will be automatically configured first, if necessary
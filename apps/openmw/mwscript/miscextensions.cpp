@@ -5,6 +5,8 @@
 #include <components/compiler/opcodes.hpp>
 #include <components/compiler/locals.hpp>
 
+#include <components/debug/trace.hpp>
+
 #include <components/interpreter/interpreter.hpp>
 #include <components/interpreter/runtime.hpp>
 #include <components/interpreter/opcodes.hpp>
@@ -1378,6 +1380,35 @@ namespace MWScript
                 }
         };
 
+        class OpToggleTrace : public Interpreter::Opcode0
+        {
+            public:
+
+                virtual void execute (Interpreter::Runtime& runtime)
+                {
+                    if (!Debug::Trace::isEnabled())
+                    {
+                        Debug::Trace::setEnabled(true);
+                        runtime.getContext().report ("Trace Recording -> On");
+                        return;
+                    }
+
+                    Debug::Trace::setEnabled(false);
+                    const std::string filename = MWBase::Environment::get().getWorld()->exportTrace();
+                    runtime.getContext().report ("Trace Recording -> Off, wrote '" + filename + "'");
+                }
+        };
+
+        class OpMemStats : public Interpreter::Opcode0
+        {
+            public:
+
+                virtual void execute (Interpreter::Runtime& runtime)
+                {
+                    runtime.getContext().report (MWBase::Environment::get().getWorld()->getMemoryStats());
+                }
+        };
+
         class OpToggleActorsPaths : public Interpreter::Opcode0
         {
             public:
@@ -1528,6 +1559,8 @@ namespace MWScript
             interpreter.installSegment5 (Compiler::Misc::opcodeSetNavMeshNumberToRender, new OpSetNavMeshNumberToRender);
             interpreter.installSegment5 (Compiler::Misc::opcodeRepairedOnMe, new OpRepairedOnMe<ImplicitRef>);
             interpreter.installSegment5 (Compiler::Misc::opcodeRepairedOnMeExplicit, new OpRepairedOnMe<ExplicitRef>);
+            interpreter.installSegment5 (Compiler::Misc::opcodeToggleTrace, new OpToggleTrace);
+            interpreter.installSegment5 (Compiler::Misc::opcodeMemStats, new OpMemStats);
         }
     }
 }
@@ -1,9 +1,14 @@
 #include "scriptmanagerimp.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <sstream>
 #include <exception>
 #include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <thread>
+#include <vector>
 
 #include <components/debug/debuglog.hpp>
 
@@ -27,7 +32,7 @@ namespace MWScript
         const std::vector<std::string>& scriptBlacklist)
     : mErrorHandler(), mStore (store),
       mCompilerContext (compilerContext), mParser (mErrorHandler, mCompilerContext),
-      mOpcodesInstalled (false), mGlobalScripts (store)
+      mOpcodesInstalled (false), mGlobalScripts (store), mWarningsMode (warningsMode), mProfiling (false)
     {
         mErrorHandler.setWarningsMode (warningsMode);
 
@@ -38,48 +43,57 @@ namespace MWScript
         std::sort (mScriptBlacklist.begin(), mScriptBlacklist.end());
     }
 
-    bool ScriptManager::compile (const std::string& name)
+    bool ScriptManager::compile (const ESM::Script& script, Compiler::FileParser& parser,
+        Compiler::StreamErrorHandler& errorHandler, CompiledScript& compiled) const
     {
-        mParser.reset();
-        mErrorHandler.reset();
+        parser.reset();
+        errorHandler.reset();
+        errorHandler.setContext(script.mId);
 
-        if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
+        bool Success = true;
+        try
         {
-            mErrorHandler.setContext(name);
-
-            bool Success = true;
-            try
-            {
-                std::istringstream input (script->mScriptText);
+            std::istringstream input (script.mScriptText);
 
-                Compiler::Scanner scanner (mErrorHandler, input, mCompilerContext.getExtensions());
+            Compiler::Scanner scanner (errorHandler, input, mCompilerContext.getExtensions());
 
-                scanner.scan (mParser);
+            scanner.scan (parser);
 
-                if (!mErrorHandler.isGood())
-                    Success = false;
-            }
-            catch (const Compiler::SourceException&)
-            {
-                // error has already been reported via error handler
-                Success = false;
-            }
-            catch (const std::exception& error)
-            {
-                Log(Debug::Error) << "Error: An exception has been thrown: " << error.what();
+            if (!errorHandler.isGood())
                 Success = false;
-            }
+        }
+        catch (const Compiler::SourceException&)
+        {
+            // error has already been reported via error handler
+            Success = false;
+        }
+        catch (const std::exception& error)
+        {
+            errorHandler.log (Debug::Error, std::string ("Error: An exception has been thrown: ") + error.what());
+            Success = false;
+        }
 
-            if (!Success)
-            {
-                Log(Debug::Error) << "Error: script compiling failed: " << name;
-            }
+        if (!Success)
+        {
+            errorHandler.log (Debug::Error, "Error: script compiling failed: " + script.mId);
+            return false;
+        }
+
+        parser.getCode (compiled.first);
+        compiled.second = parser.getLocals();
+
+        return true;
+    }
+
+    bool ScriptManager::compile (const std::string& name)
+    {
+        if (const ESM::Script *script = mStore.get<ESM::Script>().find (name))
+        {
+            CompiledScript compiled;
 
-            if (Success)
+            if (compile (*script, mParser, mErrorHandler, compiled))
             {
-                std::vector<Interpreter::Type_Code> code;
-                mParser.getCode (code);
-                mScripts.insert (std::make_pair (name, std::make_pair (code, mParser.getLocals())));
+                mScripts.insert (std::make_pair (name, std::move (compiled)));
 
                 return true;
             }
@@ -88,9 +102,8 @@ namespace MWScript
         return false;
     }
 
-    void ScriptManager::run (const std::string& name, Interpreter::Context& interpreterContext)
+    ScriptManager::ScriptCollection::iterator ScriptManager::getCompiled (const std::string& name)
     {
-        // compile script
         ScriptCollection::iterator iter = mScripts.find (name);
 
         if (iter==mScripts.end())
@@ -99,16 +112,34 @@ namespace MWScript
             {
                 // failed -> ignore script from now on.
                 std::vector<Interpreter::Type_Code> empty;
-                mScripts.insert (std::make_pair (name, std::make_pair (empty, Compiler::Locals())));
-                return;
+                return mScripts.insert (std::make_pair (name, std::make_pair (empty, Compiler::Locals()))).first;
             }
 
             iter = mScripts.find (name);
             assert (iter!=mScripts.end());
         }
 
+        return iter;
+    }
+
+    void ScriptManager::precompile (const std::string& name)
+    {
+        getCompiled (name);
+    }
+
+    bool ScriptManager::run (const std::string& name, Interpreter::Context& interpreterContext)
+    {
+        // compile script
+        ScriptCollection::iterator iter = getCompiled (name);
+
+        bool pure = false;
+
         // execute script
         if (!iter->second.first.empty())
+        {
+            const bool profiling = mProfiling;
+            const auto start = profiling ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
             try
             {
                 if (!mOpcodesInstalled)
@@ -117,7 +148,7 @@ namespace MWScript
                     mOpcodesInstalled = true;
                 }
 
-                mInterpreter.run (&iter->second.first[0], iter->second.first.size(), interpreterContext);
+                pure = mInterpreter.run (&iter->second.first[0], iter->second.first.size(), interpreterContext);
             }
             catch (const std::exception& e)
             {
@@ -126,31 +157,86 @@ namespace MWScript
 
                 iter->second.first.clear(); // don't execute again.
             }
+
+            if (profiling && mProfiling)
+            {
+                ScriptProfile& profile = mProfile[name];
+                ++profile.mRuns;
+                profile.mTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        return pure;
     }
 
     std::pair<int, int> ScriptManager::compileAll()
     {
-        int count = 0;
-        int success = 0;
+        std::vector<const ESM::Script*> scripts;
 
-        const MWWorld::Store<ESM::Script>& scripts = mStore.get<ESM::Script>();
+        const MWWorld::Store<ESM::Script>& store = mStore.get<ESM::Script>();
 
-        for (MWWorld::Store<ESM::Script>::iterator iter = scripts.begin();
-            iter != scripts.end(); ++iter)
+        for (MWWorld::Store<ESM::Script>::iterator iter = store.begin(); iter != store.end(); ++iter)
             if (!std::binary_search (mScriptBlacklist.begin(), mScriptBlacklist.end(),
                 Misc::StringUtils::lowerCase (iter->mId)))
+                scripts.push_back (&*iter);
+
+        struct Result
+        {
+            bool mSuccess = false;
+            CompiledScript mCompiled;
+            std::vector<Compiler::StreamErrorHandler::Message> mMessages;
+        };
+
+        std::vector<Result> results (scripts.size());
+        std::atomic<std::size_t> next (0);
+
+        // Each thread has its own parser and error handler, messages are written later in the order of scripts
+        const auto compileScripts = [&]
+        {
+            Compiler::StreamErrorHandler errorHandler;
+            errorHandler.setWarningsMode (mWarningsMode);
+            errorHandler.setBuffered (true);
+            Compiler::FileParser parser (errorHandler, mCompilerContext);
+
+            for (std::size_t i = next++; i < scripts.size(); i = next++)
             {
-                ++count;
+                results[i].mSuccess = compile (*scripts[i], parser, errorHandler, results[i].mCompiled);
+                results[i].mMessages = errorHandler.takeMessages();
+            }
+        };
 
-                if (compile (iter->mId))
-                    ++success;
+        const std::size_t threadsCount = std::min<std::size_t> (scripts.size(),
+            std::max (1u, std::thread::hardware_concurrency()));
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < threadsCount; ++i)
+            threads.emplace_back (compileScripts);
+        compileScripts();
+        for (auto& thread : threads)
+            thread.join();
+
+        int success = 0;
+
+        for (std::size_t i = 0; i < scripts.size(); ++i)
+        {
+            for (const auto& message : results[i].mMessages)
+                Log(message.mLevel) << message.mText;
+
+            if (results[i].mSuccess)
+            {
+                mScripts.insert (std::make_pair (scripts[i]->mId, std::move (results[i].mCompiled)));
+                ++success;
             }
+        }
 
-        return std::make_pair (count, success);
+        return std::make_pair (static_cast<int> (scripts.size()), success);
     }
 
     const Compiler::Locals& ScriptManager::getLocals (const std::string& name)
     {
+        // Called by the compiler context from the threads of compileAll
+        const std::lock_guard<std::mutex> lock (mLocalsMutex);
+
         std::string name2 = Misc::StringUtils::lowerCase (name);
 
         {
@@ -191,4 +277,27 @@ namespace MWScript
     {
         return mGlobalScripts;
     }
+
+    void ScriptManager::setProfiling (bool enabled)
+    {
+        if (enabled && !mProfiling)
+            mProfile.clear();
+        mProfiling = enabled;
+    }
+
+    void ScriptManager::writeProfile (std::ostream& stream) const
+    {
+        std::vector<std::pair<std::string, ScriptProfile> > profiles (mProfile.begin(), mProfile.end());
+        std::sort (profiles.begin(), profiles.end(),
+            [] (const std::pair<std::string, ScriptProfile>& left, const std::pair<std::string, ScriptProfile>& right)
+            { return left.second.mTime > right.second.mTime; });
+
+        stream << "script,runs,total ms,ms per run\n";
+        for (const auto& profile : profiles)
+        {
+            const double time = profile.second.mTime * 1000;
+            stream << profile.first << ',' << profile.second.mRuns << ',' << time << ','
+                << time / profile.second.mRuns << '\n';
+        }
+    }
 }
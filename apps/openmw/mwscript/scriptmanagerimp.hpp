@@ -2,6 +2,7 @@
 #define GAME_SCRIPT_SCRIPTMANAGER_H
 
 #include <map>
+#include <mutex>
 #include <string>
 
 #include <components/compiler/streamerrorhandler.hpp>
@@ -14,6 +15,11 @@
 
 #include "globalscripts.hpp"
 
+namespace ESM
+{
+    class Script;
+}
+
 namespace MWWorld
 {
     class ESMStore;
@@ -48,6 +54,24 @@ namespace MWScript
             GlobalScripts mGlobalScripts;
             std::map<std::string, Compiler::Locals> mOtherLocals;
             std::vector<std::string> mScriptBlacklist;
+            int mWarningsMode;
+            std::mutex mLocalsMutex;
+
+            struct ScriptProfile
+            {
+                unsigned int mRuns = 0;
+                double mTime = 0; // seconds, including scripts run from within the script
+            };
+
+            bool mProfiling;
+            std::map<std::string, ScriptProfile> mProfile;
+
+            bool compile (const ESM::Script& script, Compiler::FileParser& parser,
+                Compiler::StreamErrorHandler& errorHandler, CompiledScript& compiled) const;
+            ///< Compile \a script with the given parser, which may be used by another thread than the main one.
+
+            ScriptCollection::iterator getCompiled (const std::string& name);
+            ///< Compile script with the given name, if not compiled yet. Failed scripts get empty code.
 
         public:
 
@@ -55,21 +79,32 @@ namespace MWScript
                 Compiler::Context& compilerContext, int warningsMode,
                 const std::vector<std::string>& scriptBlacklist);
 
-            virtual void run (const std::string& name, Interpreter::Context& interpreterContext);
+            virtual bool run (const std::string& name, Interpreter::Context& interpreterContext);
             ///< Run the script with the given name (compile first, if not compiled yet)
+            /// \return Did the script only read its own locals, so running it again does the same while they don't
+            /// change?
 
             virtual bool compile (const std::string& name);
             ///< Compile script with the given namen
             /// \return Success?
 
+            virtual void precompile (const std::string& name);
+            ///< Compile script with the given name, if not compiled yet, so running it later doesn't stall.
+
             virtual std::pair<int, int> compileAll();
-            ///< Compile all scripts
+            ///< Compile all scripts, using all hardware threads
             /// \return count, success
 
             virtual const Compiler::Locals& getLocals (const std::string& name);
             ///< Return locals for script \a name.
 
             virtual GlobalScripts& getGlobalScripts();
+
+            virtual void setProfiling (bool enabled);
+            ///< Record the time taken by each script while enabled. Enabling discards earlier records.
+
+            virtual void writeProfile (std::ostream& stream) const;
+            ///< Write the recorded runs and time of each script as CSV, slowest first.
     };
 }
 
@@ -942,11 +942,9 @@ void OpenAL_Output::setHrtf(const std::string &hrtfname, HrtfMode hrtfmode)
 }
 
 
-std::pair<Sound_Handle,size_t> OpenAL_Output::loadSound(const std::string &fname)
+void OpenAL_Output::decodeSound(const std::string &fname, DecodedSound &sound)
 {
-    getALError();
-
-    std::vector<char> data;
+    std::vector<char>& data = sound.mData;
     ALenum format = AL_NONE;
     int srate = 0;
 
@@ -984,10 +982,18 @@ std::pair<Sound_Handle,size_t> OpenAL_Output::loadSound(const std::string &fname
         data.assign(8000, -128);
     }
 
+    sound.mFormat = format;
+    sound.mSampleRate = srate;
+}
+
+std::pair<Sound_Handle,size_t> OpenAL_Output::loadSound(const DecodedSound &sound)
+{
+    getALError();
+
     ALint size;
     ALuint buf = 0;
     alGenBuffers(1, &buf);
-    alBufferData(buf, format, data.data(), data.size(), srate);
+    alBufferData(buf, sound.mFormat, sound.mData.data(), sound.mData.size(), sound.mSampleRate);
     alGetBufferi(buf, AL_SIZE, &size);
     if(getALError() != AL_NO_ERROR)
     {
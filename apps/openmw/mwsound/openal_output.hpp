@@ -66,7 +66,8 @@ namespace MWSound
         virtual std::vector<std::string> enumerateHrtf();
         virtual void setHrtf(const std::string &hrtfname, HrtfMode hrtfmode);
 
-        virtual std::pair<Sound_Handle,size_t> loadSound(const std::string &fname);
+        virtual void decodeSound(const std::string &fname, DecodedSound &sound);
+        virtual std::pair<Sound_Handle,size_t> loadSound(const DecodedSound &sound);
         virtual size_t unloadSound(Sound_Handle data);
 
         virtual bool playSound(Sound *sound, Sound_Handle data, float offset);
@@ -19,6 +19,14 @@ namespace MWSound
     // An opaque handle for the implementation's sound instances.
     typedef void *Sound_Instance;
 
+    /// Sound data ready to be loaded into a buffer
+    struct DecodedSound
+    {
+        std::vector<char> mData;
+        int mFormat = 0;
+        int mSampleRate = 0;
+    };
+
     enum class HrtfMode {
         Disable,
         Enable,
@@ -36,7 +44,9 @@ namespace MWSound
         virtual std::vector<std::string> enumerateHrtf() = 0;
         virtual void setHrtf(const std::string &hrtfname, HrtfMode hrtfmode) = 0;
 
-        virtual std::pair<Sound_Handle,size_t> loadSound(const std::string &fname) = 0;
+        /// @note Thread safe, may be called from a worker thread.
+        virtual void decodeSound(const std::string &fname, DecodedSound &sound) = 0;
+        virtual std::pair<Sound_Handle,size_t> loadSound(const DecodedSound &sound) = 0;
         virtual size_t unloadSound(Sound_Handle data) = 0;
 
         virtual bool playSound(Sound *sound, Sound_Handle data, float offset) = 0;
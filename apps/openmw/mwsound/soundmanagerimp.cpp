@@ -1,6 +1,7 @@
 #include "soundmanagerimp.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <numeric>
 
@@ -8,6 +9,7 @@
 
 #include <components/misc/rng.hpp>
 #include <components/debug/debuglog.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/vfs/manager.hpp>
 
 #include "../mwbase/environment.hpp"
@@ -33,8 +35,77 @@ namespace MWSound
     // For combining PlayMode and Type flags
     inline int operator|(PlayMode a, Type b) { return static_cast<int>(a) | static_cast<int>(b); }
 
-    SoundManager::SoundManager(const VFS::Manager* vfs, bool useSound)
+    class DecodeSoundWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        DecodeSoundWorkItem(Sound_Output& output, const std::string& resourceName)
+            : mClaimed(false)
+            , mOutput(output)
+            , mResourceName(resourceName)
+        {
+        }
+
+        virtual void doWork()
+        {
+            if(claim())
+                mOutput.decodeSound(mResourceName, mSound);
+        }
+
+        /// Returns true if the decoding has not been started yet. It is then skipped, and the output is no
+        /// longer used by this item.
+        bool claim()
+        {
+            return !mClaimed.exchange(true);
+        }
+
+        DecodedSound mSound;
+
+    private:
+        std::atomic<bool> mClaimed;
+        Sound_Output& mOutput;
+        std::string mResourceName;
+    };
+
+    class OpenStreamWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        OpenStreamWorkItem(const DecoderPtr& decoder, const std::string& filename, bool voice)
+            : mDecoder(decoder)
+            , mFileName(filename)
+            , mVoice(voice)
+        {
+        }
+
+        virtual void doWork()
+        {
+            try
+            {
+                // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
+                if(mVoice && !mDecoder->mResourceMgr->exists(mFileName))
+                {
+                    std::string::size_type pos = mFileName.rfind('.');
+                    if(pos != std::string::npos)
+                        mFileName = mFileName.substr(0, pos)+".mp3";
+                }
+                mDecoder->open(mFileName);
+            }
+            catch(std::exception &e)
+            {
+                Log(Debug::Error) << "Failed to load audio from " << mFileName << ": " << e.what();
+                mDecoder = nullptr;
+            }
+        }
+
+        DecoderPtr mDecoder;
+
+    private:
+        std::string mFileName;
+        bool mVoice;
+    };
+
+    SoundManager::SoundManager(const VFS::Manager* vfs, SceneUtil::WorkQueue* workQueue, bool useSound)
         : mVFS(vfs)
+        , mWorkQueue(workQueue)
         , mOutput(new DEFAULT_OUTPUT(*this))
         , mMasterVolume(1.0f)
         , mSFXVolume(1.0f)
@@ -118,6 +189,17 @@ namespace MWSound
 
     SoundManager::~SoundManager()
     {
+        // The work items use the output
+        for(auto& decoding : mDecodingBuffers)
+        {
+            if(!decoding.second->claim())
+                decoding.second->waitTillDone();
+        }
+        mDecodingBuffers.clear();
+        for(auto& opening : mOpeningStreams)
+            opening.second->waitTillDone();
+        mOpeningStreams.clear();
+
         clear();
         for(Sound_Buffer &sfx : *mSoundBuffers)
         {
@@ -181,8 +263,8 @@ namespace MWSound
     }
 
     // Lookup a soundId for its sound data (resource name, local volume,
-    // minRange, and maxRange), and ensure it's ready for use.
-    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    // minRange, and maxRange), without loading it.
+    Sound_Buffer *SoundManager::findSound(const std::string &soundId)
     {
 #ifdef __GNUC__
 #define LIKELY(x) __builtin_expect((bool)(x), true)
@@ -212,62 +294,82 @@ namespace MWSound
 #undef LIKELY
 #undef UNLIKELY
 
+        return sfx;
+    }
+
+    // Lookup a soundId for its sound data (resource name, local volume,
+    // minRange, and maxRange), and ensure it's ready for use.
+    Sound_Buffer *SoundManager::loadSound(const std::string &soundId)
+    {
+        Sound_Buffer *sfx = findSound(soundId);
+        if(!sfx) return nullptr;
+
         if(!sfx->mHandle)
         {
-            size_t size;
-            std::tie(sfx->mHandle, size) = mOutput->loadSound(sfx->mResourceName);
-            if(!sfx->mHandle) return nullptr;
-
-            mBufferCacheSize += size;
-            if(mBufferCacheSize > mBufferCacheMax)
+            DecodedSound sound;
+            auto decoding = mDecodingBuffers.find(sfx);
+            if(decoding != mDecodingBuffers.end())
             {
-                do {
-                    if(mUnusedBuffers.empty())
-                    {
-                        Log(Debug::Warning) << "No unused sound buffers to free, using " << mBufferCacheSize << " bytes!";
-                        break;
-                    }
-                    Sound_Buffer *unused = mUnusedBuffers.back();
-
-                    size = mOutput->unloadSound(unused->mHandle);
-                    mBufferCacheSize -= size;
-                    unused->mHandle = 0;
-
-                    mUnusedBuffers.pop_back();
-                } while(mBufferCacheSize > mBufferCacheMin);
+                // Don't wait for a preload that has not started yet, the queue may be busy. One that has
+                // started is finished soon, so wait for it instead of decoding the sound twice.
+                if(!decoding->second->claim())
+                {
+                    decoding->second->waitTillDone();
+                    sound = std::move(decoding->second->mSound);
+                }
+                mDecodingBuffers.erase(decoding);
             }
-            mUnusedBuffers.push_front(sfx);
+            if(sound.mData.empty())
+                mOutput->decodeSound(sfx->mResourceName, sound);
+
+            if(!loadBuffer(sfx, sound)) return nullptr;
         }
 
         return sfx;
     }
 
-    DecoderPtr SoundManager::loadVoice(const std::string &voicefile)
+    bool SoundManager::loadBuffer(Sound_Buffer *sfx, const DecodedSound &sound)
     {
-        try
+        size_t size;
+        std::tie(sfx->mHandle, size) = mOutput->loadSound(sound);
+        if(!sfx->mHandle) return false;
+
+        mBufferCacheSize += size;
+        if(mBufferCacheSize > mBufferCacheMax)
         {
-            DecoderPtr decoder = getDecoder();
+            do {
+                if(mUnusedBuffers.empty())
+                {
+                    Log(Debug::Warning) << "No unused sound buffers to free, using " << mBufferCacheSize << " bytes!";
+                    break;
+                }
+                Sound_Buffer *unused = mUnusedBuffers.back();
 
-            // Workaround: Bethesda at some point converted some of the files to mp3, but the references were kept as .wav.
-            if(mVFS->exists(voicefile))
-                decoder->open(voicefile);
-            else
-            {
-                std::string file = voicefile;
-                std::string::size_type pos = file.rfind('.');
-                if(pos != std::string::npos)
-                    file = file.substr(0, pos)+".mp3";
-                decoder->open(file);
-            }
+                size = mOutput->unloadSound(unused->mHandle);
+                mBufferCacheSize -= size;
+                unused->mHandle = 0;
 
-            return decoder;
+                mUnusedBuffers.pop_back();
+            } while(mBufferCacheSize > mBufferCacheMin);
         }
-        catch(std::exception &e)
+        mUnusedBuffers.push_front(sfx);
+
+        return true;
+    }
+
+    void SoundManager::updateDecodingBuffers()
+    {
+        for(auto iter = mDecodingBuffers.begin(); iter != mDecodingBuffers.end();)
         {
-            Log(Debug::Error) << "Failed to load audio from " << voicefile << ": " << e.what();
+            if(!iter->second->isDone())
+            {
+                ++iter;
+                continue;
+            }
+            if(!iter->first->mHandle)
+                loadBuffer(iter->first, iter->second->mSound);
+            iter = mDecodingBuffers.erase(iter);
         }
-
-        return nullptr;
     }
 
     Sound *SoundManager::getSoundRef()
@@ -302,7 +404,58 @@ namespace MWSound
         return ret;
     }
 
-    Stream *SoundManager::playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal)
+    void SoundManager::openStream(Stream *stream, const std::string &filename, bool voice)
+    {
+        osg::ref_ptr<OpenStreamWorkItem> item(new OpenStreamWorkItem(getDecoder(), filename, voice));
+        if(!mWorkQueue)
+        {
+            item->doWork();
+            startStream(stream, item->mDecoder);
+            return;
+        }
+        mWorkQueue->addWorkItem(item, true);
+        mOpeningStreams[stream] = item;
+    }
+
+    void SoundManager::startStream(Stream *stream, const DecoderPtr &decoder)
+    {
+        // A stream that fails to start has no handle, it is cleaned up like one that stopped playing
+        if(!decoder)
+            return;
+        const bool getLoudness = stream->getPlayType() == Type::Voice;
+        if(stream->getIs3D())
+            mOutput->streamSound3D(decoder, stream, getLoudness);
+        else
+            mOutput->streamSound(decoder, stream, getLoudness);
+    }
+
+    void SoundManager::updateOpeningStreams()
+    {
+        for(auto iter = mOpeningStreams.begin(); iter != mOpeningStreams.end();)
+        {
+            if(!iter->second->isDone())
+            {
+                ++iter;
+                continue;
+            }
+            startStream(iter->first, iter->second->mDecoder);
+            iter = mOpeningStreams.erase(iter);
+        }
+    }
+
+    bool SoundManager::isStreamPlaying(Stream *stream) const
+    {
+        return mOpeningStreams.count(stream) || mOutput->isStreamPlaying(stream);
+    }
+
+    void SoundManager::finishStream(Stream *stream)
+    {
+        // The work item only holds the decoder, it is dropped once done
+        mOpeningStreams.erase(stream);
+        mOutput->finishStream(stream);
+    }
+
+    Stream *SoundManager::playVoice(const std::string &voicefile, const osg::Vec3f &pos, bool playlocal)
     {
         MWBase::World* world = MWBase::Environment::get().getWorld();
         static const float fAudioMinDistanceMult = world->getStore().get<ESM::GameSetting>().find("fAudioMinDistanceMult")->mValue.getFloat();
@@ -312,25 +465,14 @@ namespace MWSound
         static float minDistance = std::max(fAudioVoiceDefaultMinDistance * fAudioMinDistanceMult, 1.0f);
         static float maxDistance = std::max(fAudioVoiceDefaultMaxDistance * fAudioMaxDistanceMult, minDistance);
 
-        bool played;
         float basevol = volumeFromType(Type::Voice);
         Stream *sound = getStreamRef();
         if(playlocal)
-        {
             sound->init(1.0f, basevol, 1.0f, PlayMode::NoEnv|Type::Voice|Play_2D);
-            played = mOutput->streamSound(decoder, sound, true);
-        }
         else
-        {
             sound->init(pos, 1.0f, basevol, 1.0f, minDistance, maxDistance,
                         PlayMode::Normal|Type::Voice|Play_3D);
-            played = mOutput->streamSound3D(decoder, sound, true);
-        }
-        if(!played)
-        {
-            mUnusedStreams.push_back(sound);
-            return nullptr;
-        }
+        openStream(sound, voicefile, true);
         return sound;
     }
 
@@ -363,7 +505,7 @@ namespace MWSound
     {
         if(mMusic)
         {
-            mOutput->finishStream(mMusic);
+            finishStream(mMusic);
             mUnusedStreams.push_back(mMusic);
             mMusic = nullptr;
         }
@@ -378,13 +520,10 @@ namespace MWSound
 
         stopMusic();
 
-        DecoderPtr decoder = getDecoder();
-        decoder->open(filename);
-
         mMusic = getStreamRef();
         mMusic->init(1.0f, volumeFromType(Type::Music), 1.0f,
                      PlayMode::NoEnv|Type::Music|Play_2D);
-        mOutput->streamSound(decoder, mMusic);
+        openStream(mMusic, filename, false);
     }
 
     void SoundManager::advanceMusic(const std::string& filename)
@@ -434,7 +573,7 @@ namespace MWSound
 
     bool SoundManager::isMusicPlaying()
     {
-        return mMusic && mOutput->isStreamPlaying(mMusic);
+        return mMusic && isStreamPlaying(mMusic);
     }
 
     void SoundManager::playPlaylist(const std::string &playlist)
@@ -445,20 +584,8 @@ namespace MWSound
         if (mMusicFiles.find(playlist) == mMusicFiles.end())
         {
             std::vector<std::string> filelist;
-            const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-
-            std::string pattern = "Music/" + playlist;
-            mVFS->normalizeFilename(pattern);
-
-            std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(pattern);
-            while (found != index.end())
-            {
-                if (found->first.size() >= pattern.size() && found->first.substr(0, pattern.size()) == pattern)
-                    filelist.push_back(found->first);
-                else
-                    break;
-                ++found;
-            }
+            for (const std::string& name : mVFS->getRecursiveDirectoryIterator("Music/" + playlist))
+                filelist.push_back(name);
 
             mMusicFiles[playlist] = filelist;
         }
@@ -478,13 +605,11 @@ namespace MWSound
         if (mMusicFiles.find("Title") == mMusicFiles.end())
         {
             std::vector<std::string> filelist;
-            const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
             // Is there an ini setting for this filename or something?
             std::string filename = "music/special/morrowind title.mp3";
-            auto found = index.find(filename);
-            if (found != index.end())
+            if (mVFS->exists(filename))
             {
-                filelist.emplace_back(found->first);
+                filelist.emplace_back(filename);
                 mMusicFiles["Title"] = filelist;
             }
             else
@@ -509,16 +634,12 @@ namespace MWSound
         std::string voicefile = "Sound/"+filename;
 
         mVFS->normalizeFilename(voicefile);
-        DecoderPtr decoder = loadVoice(voicefile);
-        if (!decoder)
-            return;
 
         MWBase::World *world = MWBase::Environment::get().getWorld();
         const osg::Vec3f pos = world->getActorHeadTransform(ptr).getTrans();
 
         stopSay(ptr);
-        Stream *sound = playVoice(decoder, pos, (ptr == MWMechanics::getPlayer()));
-        if(!sound) return;
+        Stream *sound = playVoice(voicefile, pos, (ptr == MWMechanics::getPlayer()));
 
         mSaySoundsQueue.emplace(ptr, sound);
     }
@@ -543,13 +664,9 @@ namespace MWSound
         std::string voicefile = "Sound/"+filename;
 
         mVFS->normalizeFilename(voicefile);
-        DecoderPtr decoder = loadVoice(voicefile);
-        if (!decoder)
-            return;
 
         stopSay(MWWorld::ConstPtr());
-        Stream *sound = playVoice(decoder, osg::Vec3f(), true);
-        if(!sound) return;
+        Stream *sound = playVoice(voicefile, osg::Vec3f(), true);
 
         mActiveSaySounds.insert(std::make_pair(MWWorld::ConstPtr(), sound));
     }
@@ -559,7 +676,7 @@ namespace MWSound
         SaySoundMap::const_iterator snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
         {
-            if(mOutput->isStreamPlaying(snditer->second))
+            if(isStreamPlaying(snditer->second))
                 return false;
             return true;
         }
@@ -571,7 +688,7 @@ namespace MWSound
         SaySoundMap::const_iterator snditer = mSaySoundsQueue.find(ptr);
         if(snditer != mSaySoundsQueue.end())
         {
-            if(mOutput->isStreamPlaying(snditer->second))
+            if(isStreamPlaying(snditer->second))
                 return true;
             return false;
         }
@@ -579,7 +696,7 @@ namespace MWSound
         snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
         {
-            if(mOutput->isStreamPlaying(snditer->second))
+            if(isStreamPlaying(snditer->second))
                 return true;
             return false;
         }
@@ -592,7 +709,7 @@ namespace MWSound
         SaySoundMap::iterator snditer = mSaySoundsQueue.find(ptr);
         if(snditer != mSaySoundsQueue.end())
         {
-            mOutput->finishStream(snditer->second);
+            finishStream(snditer->second);
             mUnusedStreams.push_back(snditer->second);
             mSaySoundsQueue.erase(snditer);
         }
@@ -600,7 +717,7 @@ namespace MWSound
         snditer = mActiveSaySounds.find(ptr);
         if(snditer != mActiveSaySounds.end())
         {
-            mOutput->finishStream(snditer->second);
+            finishStream(snditer->second);
             mUnusedStreams.push_back(snditer->second);
             mActiveSaySounds.erase(snditer);
         }
@@ -628,7 +745,7 @@ namespace MWSound
 
     void SoundManager::stopTrack(Stream *stream)
     {
-        mOutput->finishStream(stream);
+        finishStream(stream);
         TrackList::iterator iter = std::lower_bound(mActiveTracks.begin(), mActiveTracks.end(), stream);
         if(iter != mActiveTracks.end() && *iter == stream)
             mActiveTracks.erase(iter);
@@ -699,7 +816,7 @@ namespace MWSound
         {
             sound->init(objpos, volume * sfx->mVolume, volumeFromType(type), pitch,
                         sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D);
-            played = mOutput->playSound3D(sound, sfx->mHandle, offset);
+            played = startSound3D(sound, sfx, offset);
         }
         if(!played)
         {
@@ -731,7 +848,7 @@ namespace MWSound
         Sound *sound = getSoundRef();
         sound->init(initialPos, volume * sfx->mVolume, volumeFromType(type), pitch,
                     sfx->mMinDist, sfx->mMaxDist, mode|type|Play_3D);
-        if(!mOutput->playSound3D(sound, sfx->mHandle, offset))
+        if(!startSound3D(sound, sfx, offset))
         {
             mUnusedSounds.push_back(sound);
             return nullptr;
@@ -747,10 +864,72 @@ namespace MWSound
         return sound;
     }
 
+    bool SoundManager::startSound3D(Sound *sound, Sound_Buffer *sfx, float offset)
+    {
+        if(sound->getIsLooping())
+        {
+            // Loops that can't be heard are only tracked, and get a source once the listener is in range
+            if(isOutOfRange(sound) || !mOutput->playSound3D(sound, sfx->mHandle, offset))
+                sound->setVirtual(true);
+            return true;
+        }
+        return mOutput->playSound3D(sound, sfx->mHandle, offset);
+    }
+
+    bool SoundManager::isOutOfRange(const Sound *sound) const
+    {
+        return (sound->getPosition() - mListenerPos).length2() > sound->getMaxDistance()*sound->getMaxDistance();
+    }
+
+    bool SoundManager::updateVirtualSound(Sound *sound, Sound_Buffer *sfx)
+    {
+        if(!sound->getIsLooping() || !sound->getIs3D())
+            return false;
+        if(!sound->getIsVirtual())
+        {
+            if(isOutOfRange(sound))
+            {
+                mOutput->finishSound(sound);
+                sound->setVirtual(true);
+            }
+        }
+        else if(!isOutOfRange(sound) && !(mPausedSoundTypes & sound->getPlayType()))
+        {
+            if(mOutput->playSound3D(sound, sfx->mHandle, 0.0f))
+                sound->setVirtual(false);
+        }
+        return sound->getIsVirtual();
+    }
+
+    bool SoundManager::isSoundPlaying(Sound *sound) const
+    {
+        return sound->getIsVirtual() || mOutput->isSoundPlaying(sound);
+    }
+
+    void SoundManager::finishSound(Sound *sound)
+    {
+        sound->setVirtual(false);
+        mOutput->finishSound(sound);
+    }
+
+    void SoundManager::preloadSound(const std::string& soundId)
+    {
+        if(!mOutput->isInitialized() || !mWorkQueue)
+            return;
+
+        Sound_Buffer *sfx = findSound(Misc::StringUtils::lowerCase(soundId));
+        if(!sfx || sfx->mHandle || mDecodingBuffers.count(sfx))
+            return;
+
+        osg::ref_ptr<DecodeSoundWorkItem> item(new DecodeSoundWorkItem(*mOutput, sfx->mResourceName));
+        mWorkQueue->addWorkItem(item);
+        mDecodingBuffers.emplace(sfx, item);
+    }
+
     void SoundManager::stopSound(Sound *sound)
     {
         if(sound)
-            mOutput->finishSound(sound);
+            finishSound(sound);
     }
 
     void SoundManager::stopSound(Sound_Buffer *sfx, const MWWorld::ConstPtr &ptr)
@@ -761,7 +940,7 @@ namespace MWSound
             for(SoundBufferRefPair &snd : snditer->second)
             {
                 if(snd.second == sfx)
-                    mOutput->finishSound(snd.first);
+                    finishSound(snd.first);
             }
         }
     }
@@ -794,14 +973,14 @@ namespace MWSound
         if(snditer != mActiveSounds.end())
         {
             for(SoundBufferRefPair &snd : snditer->second)
-                mOutput->finishSound(snd.first);
+                finishSound(snd.first);
         }
         SaySoundMap::iterator sayiter = mSaySoundsQueue.find(ptr);
         if(sayiter != mSaySoundsQueue.end())
-            mOutput->finishStream(sayiter->second);
+            finishStream(sayiter->second);
         sayiter = mActiveSaySounds.find(ptr);
         if(sayiter != mActiveSaySounds.end())
-            mOutput->finishStream(sayiter->second);
+            finishStream(sayiter->second);
     }
 
     void SoundManager::stopSound(const MWWorld::CellStore *cell)
@@ -811,20 +990,20 @@ namespace MWSound
             if(!snd.first.isEmpty() && snd.first != MWMechanics::getPlayer() && snd.first.getCell() == cell)
             {
                 for(SoundBufferRefPair &sndbuf : snd.second)
-                    mOutput->finishSound(sndbuf.first);
+                    finishSound(sndbuf.first);
             }
         }
 
         for(SaySoundMap::value_type &snd : mSaySoundsQueue)
         {
             if(!snd.first.isEmpty() && snd.first != MWMechanics::getPlayer() && snd.first.getCell() == cell)
-                mOutput->finishStream(snd.second);
+                finishStream(snd.second);
         }
 
         for(SaySoundMap::value_type &snd : mActiveSaySounds)
         {
             if(!snd.first.isEmpty() && snd.first != MWMechanics::getPlayer() && snd.first.getCell() == cell)
-                mOutput->finishStream(snd.second);
+                finishStream(snd.second);
         }
     }
 
@@ -851,7 +1030,7 @@ namespace MWSound
             Sound_Buffer *sfx = lookupSound(Misc::StringUtils::lowerCase(soundId));
             return std::find_if(snditer->second.cbegin(), snditer->second.cend(),
                 [this,sfx](const SoundBufferRefPair &snd) -> bool
-                { return snd.second == sfx && mOutput->isSoundPlaying(snd.first); }
+                { return snd.second == sfx && isSoundPlaying(snd.first); }
             ) != snditer->second.cend();
         }
         return false;
@@ -988,7 +1167,7 @@ namespace MWSound
         {
             if (volume == 0.0f)
             {
-                mOutput->finishSound(mNearWaterSound);
+                finishSound(mNearWaterSound);
                 mNearWaterSound = nullptr;
             }
             else
@@ -1014,7 +1193,7 @@ namespace MWSound
 
                 if(soundIdChanged)
                 {
-                    mOutput->finishSound(mNearWaterSound);
+                    finishSound(mNearWaterSound);
                     mNearWaterSound = playSound(soundId, volume, 1.0f, Type::Sfx, PlayMode::Loop);
                 }
                 else if (sfx)
@@ -1056,7 +1235,7 @@ namespace MWSound
             env = Env_Underwater;
         else if(mUnderwaterSound)
         {
-            mOutput->finishSound(mUnderwaterSound);
+            finishSound(mUnderwaterSound);
             mUnderwaterSound = nullptr;
         }
 
@@ -1091,13 +1270,13 @@ namespace MWSound
                     if(sound->getDistanceCull())
                     {
                         if((mListenerPos - objpos).length2() > 2000*2000)
-                            mOutput->finishSound(sound);
+                            finishSound(sound);
                     }
                 }
 
-                if(!mOutput->isSoundPlaying(sound))
+                if(!isSoundPlaying(sound))
                 {
-                    mOutput->finishSound(sound);
+                    finishSound(sound);
                     mUnusedSounds.push_back(sound);
                     if(sound == mUnderwaterSound)
                         mUnderwaterSound = nullptr;
@@ -1111,7 +1290,8 @@ namespace MWSound
                 {
                     sound->updateFade(duration);
 
-                    mOutput->updateSound(sound);
+                    if(!updateVirtualSound(sound, sfx))
+                        mOutput->updateSound(sound);
                     ++sndidx;
                 }
             }
@@ -1135,13 +1315,13 @@ namespace MWSound
                 if(sound->getDistanceCull())
                 {
                     if((mListenerPos - pos).length2() > 2000*2000)
-                        mOutput->finishStream(sound);
+                        finishStream(sound);
                 }
             }
 
-            if(!mOutput->isStreamPlaying(sound))
+            if(!isStreamPlaying(sound))
             {
-                mOutput->finishStream(sound);
+                finishStream(sound);
                 mUnusedStreams.push_back(sound);
                 mActiveSaySounds.erase(sayiter++);
             }
@@ -1158,9 +1338,9 @@ namespace MWSound
         for(;trkiter != mActiveTracks.end();++trkiter)
         {
             Stream *sound = *trkiter;
-            if(!mOutput->isStreamPlaying(sound))
+            if(!isStreamPlaying(sound))
             {
-                mOutput->finishStream(sound);
+                finishStream(sound);
                 trkiter = mActiveTracks.erase(trkiter);
             }
             else
@@ -1204,6 +1384,8 @@ namespace MWSound
         if(!mOutput->isInitialized())
             return;
 
+        updateDecodingBuffers();
+        updateOpeningStreams();
         updateSounds(duration);
         if (MWBase::Environment::get().getStateManager()->getState()!=
             MWBase::StateManager::State_NoGame)
@@ -1368,7 +1550,7 @@ namespace MWSound
         {
             for(SoundBufferRefPair &sndbuf : snd.second)
             {
-                mOutput->finishSound(sndbuf.first);
+                finishSound(sndbuf.first);
                 mUnusedSounds.push_back(sndbuf.first);
                 Sound_Buffer *sfx = sndbuf.second;
                 if(sfx->mUses-- == 1)
@@ -1381,21 +1563,21 @@ namespace MWSound
 
         for(SaySoundMap::value_type &snd : mSaySoundsQueue)
         {
-            mOutput->finishStream(snd.second);
+            finishStream(snd.second);
             mUnusedStreams.push_back(snd.second);
         }
         mSaySoundsQueue.clear();
 
         for(SaySoundMap::value_type &snd : mActiveSaySounds)
         {
-            mOutput->finishStream(snd.second);
+            finishStream(snd.second);
             mUnusedStreams.push_back(snd.second);
         }
         mActiveSaySounds.clear();
 
         for(Stream *sound : mActiveTracks)
         {
-            mOutput->finishStream(sound);
+            finishStream(sound);
             mUnusedStreams.push_back(sound);
         }
         mActiveTracks.clear();
@@ -8,6 +8,8 @@
 #include <map>
 #include <unordered_map>
 
+#include <osg/ref_ptr>
+
 #include <components/settings/settings.hpp>
 
 #include <components/fallback/fallback.hpp>
@@ -24,6 +26,11 @@ namespace ESM
     struct Sound;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace MWSound
 {
     class Sound_Output;
@@ -31,6 +38,9 @@ namespace MWSound
     class Sound;
     class Stream;
     class Sound_Buffer;
+    struct DecodedSound;
+    class DecodeSoundWorkItem;
+    class OpenStreamWorkItem;
 
     enum Environment {
         Env_Normal,
@@ -46,6 +56,8 @@ namespace MWSound
     {
         const VFS::Manager* mVFS;
 
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+
         std::unique_ptr<Sound_Output> mOutput;
 
         // Caches available music tracks by <playlist name, (sound files) >
@@ -81,6 +93,11 @@ namespace MWSound
         typedef std::deque<Sound_Buffer*> SoundList;
         SoundList mUnusedBuffers;
 
+        // Buffers being decoded by preloadSound
+        std::unordered_map<Sound_Buffer*, osg::ref_ptr<DecodeSoundWorkItem>> mDecodingBuffers;
+        // Voice and music streams whose decoder is being opened in the background
+        std::unordered_map<Stream*, osg::ref_ptr<OpenStreamWorkItem>> mOpeningStreams;
+
         std::unique_ptr<std::deque<Sound>> mSounds;
         std::vector<Sound*> mUnusedSounds;
 
@@ -115,15 +132,32 @@ namespace MWSound
         Sound_Buffer *insertSound(const std::string &soundId, const ESM::Sound *sound);
 
         Sound_Buffer *lookupSound(const std::string &soundId) const;
+        Sound_Buffer *findSound(const std::string &soundId);
         Sound_Buffer *loadSound(const std::string &soundId);
-
-        // returns a decoder to start streaming, or nullptr if the sound was not found
-        DecoderPtr loadVoice(const std::string &voicefile);
+        bool loadBuffer(Sound_Buffer *sfx, const DecodedSound &sound);
+        void updateDecodingBuffers();
+
+        bool startSound3D(Sound *sound, Sound_Buffer *sfx, float offset);
+        bool isOutOfRange(const Sound *sound) const;
+        /// Releases the source of a looping 3D sound out of range of the listener, and takes one again when in range.
+        /// @return Is the sound virtual, i.e. has no source?
+        bool updateVirtualSound(Sound *sound, Sound_Buffer *sfx);
+        /// Also true for virtual sounds.
+        bool isSoundPlaying(Sound *sound) const;
+        void finishSound(Sound *sound);
 
         Sound *getSoundRef();
         Stream *getStreamRef();
 
-        Stream *playVoice(DecoderPtr decoder, const osg::Vec3f &pos, bool playlocal);
+        /// Open the decoder of an initialized stream on the work queue, the stream starts once it is open.
+        void openStream(Stream *stream, const std::string &filename, bool voice);
+        void startStream(Stream *stream, const DecoderPtr &decoder);
+        void updateOpeningStreams();
+        /// Also true while the stream is still being opened.
+        bool isStreamPlaying(Stream *stream) const;
+        void finishStream(Stream *stream);
+
+        Stream *playVoice(const std::string &voicefile, const osg::Vec3f &pos, bool playlocal);
 
         void streamMusicFull(const std::string& filename);
         void advanceMusic(const std::string& filename);
@@ -149,7 +183,7 @@ namespace MWSound
         ///< Stop the given object from playing given sound buffer.
 
     public:
-        SoundManager(const VFS::Manager* vfs, bool useSound);
+        SoundManager(const VFS::Manager* vfs, SceneUtil::WorkQueue* workQueue, bool useSound);
         virtual ~SoundManager();
 
         virtual void processChangedSettings(const Settings::CategorySettingVector& settings);
@@ -219,6 +253,9 @@ namespace MWSound
         ///< Play a 3D sound at \a initialPos. If the sound should be moving, it must be updated using Sound::setPosition.
         ///< @param offset Number of seconds into the sound to start playback.
 
+        virtual void preloadSound(const std::string& soundId);
+        ///< Decode the given sound in the background, so it does not need to be loaded when it is played.
+
         virtual void stopSound(Sound *sound);
         ///< Stop the given sound from playing
         /// @note no-op if \a sound is null
@@ -1,13 +1,77 @@
 #include "character.hpp"
 
 #include <cctype>
+#include <cstdint>
+#include <map>
 #include <sstream>
 
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 
+#include <components/debug/debuglog.hpp>
 #include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
 #include <components/esm/defs.hpp>
 
+namespace
+{
+    const char* const sIndexFileName = "slots.omwindex";
+
+    struct IndexEntry
+    {
+        std::time_t mTimeStamp;
+        std::uint64_t mSize;
+        ESM::SavedGame mProfile;
+    };
+
+    typedef std::map<std::string, IndexEntry> Index;
+
+    Index readIndex (const boost::filesystem::path& path)
+    {
+        Index index;
+
+        if (!boost::filesystem::exists (path))
+            return index;
+
+        try
+        {
+            ESM::ESMReader reader;
+            reader.open (path.string());
+
+            // The profiles are stored in the current format only
+            if (reader.getFormat()!=ESM::SavedGame::sCurrentFormat)
+                return index;
+
+            while (reader.hasMoreRecs())
+            {
+                const ESM::NAME name = reader.getRecName();
+                reader.getRecHeader();
+
+                if (name!=ESM::REC_SAVE)
+                {
+                    reader.skipRecord();
+                    continue;
+                }
+
+                const std::string fileName = reader.getHNString ("FILE");
+                std::int64_t timeStamp = 0;
+                IndexEntry& entry = index[fileName];
+                reader.getHNT (timeStamp, "MTIM");
+                reader.getHNT (entry.mSize, "SIZE");
+                entry.mTimeStamp = static_cast<std::time_t> (timeStamp);
+                entry.mProfile.load (reader);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to read saved game index " << path << ": " << e.what();
+            index.clear();
+        }
+
+        return index;
+    }
+}
+
 bool MWState::operator< (const Slot& left, const Slot& right)
 {
     return left.mTimeStamp<right.mTimeStamp;
@@ -78,19 +142,46 @@ MWState::Character::Character (const boost::filesystem::path& saves, const std::
     }
     else
     {
+        const Index index = readIndex (mPath / sIndexFileName);
+        std::size_t indexed = 0;
+        bool indexChanged = false;
+
         for (boost::filesystem::directory_iterator iter (mPath);
             iter!=boost::filesystem::directory_iterator(); ++iter)
         {
             boost::filesystem::path slotPath = *iter;
 
+            // Skip the index and files left behind by an interrupted save
+            if (slotPath.filename()==sIndexFileName || slotPath.extension()==".tmp")
+                continue;
+
             try
             {
+                // Files not changed since they were indexed don't need to be opened
+                const Index::const_iterator entry = index.find (slotPath.filename().string());
+                if (entry!=index.end() && entry->second.mTimeStamp==boost::filesystem::last_write_time (slotPath)
+                    && entry->second.mSize==boost::filesystem::file_size (slotPath)
+                    && Misc::StringUtils::ciEqual (entry->second.mProfile.mContentFiles.at (0), game))
+                {
+                    Slot slot;
+                    slot.mPath = slotPath;
+                    slot.mProfile = entry->second.mProfile;
+                    slot.mTimeStamp = entry->second.mTimeStamp;
+                    mSlots.push_back (slot);
+                    ++indexed;
+                    continue;
+                }
+
+                indexChanged = true;
                 addSlot (slotPath, game);
             }
             catch (...) {} // ignoring bad saved game files for now
         }
 
         std::sort (mSlots.begin(), mSlots.end());
+
+        if (indexChanged || indexed!=index.size())
+            writeIndex();
     }
 }
 
@@ -101,6 +192,9 @@ void MWState::Character::cleanup()
         // All slots are gone, no need to keep the empty directory
         if (boost::filesystem::is_directory (mPath))
         {
+            boost::system::error_code error;
+            boost::filesystem::remove (mPath / sIndexFileName, error);
+
             // Extra safety check to make sure the directory is empty (e.g. slots failed to parse header)
             boost::filesystem::directory_iterator it(mPath);
             if (it == boost::filesystem::directory_iterator())
@@ -129,6 +223,8 @@ void MWState::Character::deleteSlot (const Slot *slot)
     boost::filesystem::remove(slot->mPath);
 
     mSlots.erase (mSlots.begin()+index);
+
+    writeIndex();
 }
 
 const MWState::Slot *MWState::Character::updateSlot (const Slot *slot, const ESM::SavedGame& profile)
@@ -181,6 +277,54 @@ ESM::SavedGame MWState::Character::getSignature() const
     return slot.mProfile;
 }
 
+void MWState::Character::writeIndex() const
+{
+    const boost::filesystem::path path = mPath / sIndexFileName;
+
+    try
+    {
+        ESM::ESMWriter writer;
+        writer.setFormat (ESM::SavedGame::sCurrentFormat);
+
+        // all unused
+        writer.setVersion(0);
+        writer.setType(0);
+        writer.setAuthor("");
+        writer.setDescription("");
+
+        boost::filesystem::ofstream stream (path, std::ios::binary);
+        writer.save (stream);
+
+        for (std::vector<Slot>::const_iterator iter (mSlots.begin()); iter!=mSlots.end(); ++iter)
+        {
+            // Slots are written after they are created, these are indexed the next time
+            boost::system::error_code error;
+            const std::time_t timeStamp = boost::filesystem::last_write_time (iter->mPath, error);
+            const std::uintmax_t size = boost::filesystem::file_size (iter->mPath, error);
+            if (error)
+                continue;
+
+            writer.startRecord (ESM::REC_SAVE);
+            writer.writeHNString ("FILE", iter->mPath.filename().string());
+            writer.writeHNT ("MTIM", static_cast<std::int64_t> (timeStamp));
+            writer.writeHNT ("SIZE", static_cast<std::uint64_t> (size));
+            iter->mProfile.save (writer);
+            writer.endRecord (ESM::REC_SAVE);
+        }
+
+        writer.close();
+
+        if (stream.fail())
+            throw std::runtime_error ("write error");
+    }
+    catch (const std::exception& e)
+    {
+        Log(Debug::Warning) << "Failed to write saved game index " << path << ": " << e.what();
+        boost::system::error_code error;
+        boost::filesystem::remove (path, error);
+    }
+}
+
 const boost::filesystem::path& MWState::Character::getPath() const
 {
     return mPath;
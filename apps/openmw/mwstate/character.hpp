@@ -58,6 +58,10 @@ namespace MWState
 
             SlotIterator end() const;
 
+            /// Write the headers of all slots to the index of this character, from which they are read the next time
+            /// instead of opening every saved game. Must be called after a slot file was written.
+            void writeIndex() const;
+
             const boost::filesystem::path& getPath() const;
 
             ESM::SavedGame getSignature() const;
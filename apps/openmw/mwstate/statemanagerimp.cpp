@@ -2,6 +2,7 @@
 
 #include <components/debug/debuglog.hpp>
 
+#include <components/esm/compression.hpp>
 #include <components/esm/esmwriter.hpp>
 #include <components/esm/esmreader.hpp>
 #include <components/esm/cellid.hpp>
@@ -88,10 +89,53 @@ std::map<int, int> MWState::StateManager::buildContentFileIndexMap (const ESM::E
 
 MWState::StateManager::StateManager (const boost::filesystem::path& saves, const std::string& game)
 : mQuitRequest (false), mAskLoadRecent(false), mState (State_NoGame), mCharacterManager (saves, game), mTimePlayed (0)
+, mSaveDone (false), mSaveCharacter (nullptr), mSaveSlot (nullptr)
 {
 
 }
 
+MWState::StateManager::~StateManager()
+{
+    if (mSaveThread.joinable())
+    {
+        mSaveThread.join();
+        if (!mSaveError.empty())
+            Log(Debug::Error) << "Failed to save game: " << mSaveError;
+    }
+}
+
+void MWState::StateManager::finishSave()
+{
+    if (!mSaveThread.joinable())
+        return;
+
+    mSaveThread.join();
+    mSaveDone = false;
+
+    if (mSaveError.empty())
+    {
+        mSaveCharacter->writeIndex();
+        return;
+    }
+
+    std::stringstream error;
+    error << "Failed to save game: " << mSaveError;
+    mSaveError.clear();
+
+    Log(Debug::Error) << error.str();
+
+    std::vector<std::string> buttons;
+    buttons.push_back("#{sOk}");
+    MWBase::Environment::get().getWindowManager()->interactiveMessageBox(error.str(), buttons);
+
+    // If no file was written, clean up the slot
+    if (!boost::filesystem::exists(mSaveSlot->mPath))
+    {
+        mSaveCharacter->deleteSlot(mSaveSlot);
+        mSaveCharacter->cleanup();
+    }
+}
+
 void MWState::StateManager::requestQuit()
 {
     mQuitRequest = true;
@@ -181,6 +225,8 @@ void MWState::StateManager::resumeGame()
 
 void MWState::StateManager::saveGame (const std::string& description, const Slot *slot)
 {
+    finishSave();
+
     MWState::Character* character = getCurrentCharacter();
 
     try
@@ -292,12 +338,40 @@ void MWState::StateManager::saveGame (const std::string& description, const Slot
         if (stream.fail())
             throw std::runtime_error("Write operation failed (memory stream)");
 
-        // All good, write to file
-        boost::filesystem::ofstream filestream (slot->mPath, std::ios::binary);
-        filestream << stream.rdbuf();
+        // All good, write to file without blocking the game
+        mSaveCharacter = character;
+        mSaveSlot = slot;
+        const boost::filesystem::path path = slot->mPath;
+        const int compressionLevel = std::min(Settings::Manager::getInt ("compression level", "Saves"), 9);
+        mSaveThread = std::thread([this, path, compressionLevel, data = stream.str()]
+        {
+            // Write to a temporary file first, so the save game dialog never reads a partially written file
+            boost::filesystem::path tmpPath = path;
+            tmpPath += ".tmp";
+
+            try
+            {
+                boost::filesystem::ofstream filestream (tmpPath, std::ios::binary | std::ios::trunc);
+                if (compressionLevel > 0)
+                    ESM::writeCompressed (filestream, data.data(), data.size(), compressionLevel);
+                else
+                    filestream.write (data.data(), data.size());
+                filestream.close();
+
+                if (filestream.fail())
+                    throw std::runtime_error("Write operation failed (file stream)");
+
+                boost::filesystem::rename (tmpPath, path);
+            }
+            catch (const std::exception& e)
+            {
+                mSaveError = e.what();
+                boost::system::error_code error;
+                boost::filesystem::remove (tmpPath, error);
+            }
 
-        if (filestream.fail())
-            throw std::runtime_error("Write operation failed (file stream)");
+            mSaveDone = true;
+        });
 
         Settings::Manager::setString ("character", "Saves",
             slot->mPath.parent_path().filename().string());
@@ -376,6 +450,8 @@ void MWState::StateManager::loadGame(const std::string& filepath)
 
 void MWState::StateManager::loadGame (const Character *character, const std::string& filepath)
 {
+    finishSave();
+
     try
     {
         cleanup();
@@ -575,6 +651,8 @@ void MWState::StateManager::quickLoad()
 
 void MWState::StateManager::deleteGame(const MWState::Character *character, const MWState::Slot *slot)
 {
+    finishSave();
+
     mCharacterManager.deleteSlot(character, slot);
 }
 
@@ -597,6 +675,9 @@ void MWState::StateManager::update (float duration)
 {
     mTimePlayed += duration;
 
+    if (mSaveDone)
+        finishSave();
+
     // Note: It would be nicer to trigger this from InputManager, i.e. the very beginning of the frame update.
     if (mAskLoadRecent)
     {
@@ -1,7 +1,9 @@
 #ifndef GAME_STATE_STATEMANAGER_H
 #define GAME_STATE_STATEMANAGER_H
 
+#include <atomic>
 #include <map>
+#include <thread>
 
 #include "../mwbase/statemanager.hpp"
 
@@ -19,8 +21,18 @@ namespace MWState
             CharacterManager mCharacterManager;
             double mTimePlayed;
 
+            /// Writes the serialized saved game to disk
+            std::thread mSaveThread;
+            std::atomic<bool> mSaveDone;
+            std::string mSaveError;
+            Character* mSaveCharacter;
+            const Slot* mSaveSlot;
+
         private:
 
+            /// Wait for the saved game being written in the background, report an error if it failed.
+            void finishSave();
+
             void cleanup (bool force = false);
 
             bool verifyProfile (const ESM::SavedGame& profile) const;
@@ -33,6 +45,8 @@ namespace MWState
 
             StateManager (const boost::filesystem::path& saves, const std::string& game);
 
+            virtual ~StateManager();
+
             virtual void requestQuit();
 
             virtual bool hasQuitRequest() const;
@@ -57,6 +71,7 @@ namespace MWState
             ///< Write a saved game to \a slot or create a new slot if \a slot == 0.
             ///
             /// \note Slot must belong to the current character.
+            /// \note The game is serialized immediately, the file is written in the background.
 
             ///Saves a file, using supplied filename, overwritting if needed
             /** This is mostly used for quicksaving and autosaving, for they use the same name over and over again
@@ -2,6 +2,9 @@
 
 #include <atomic>
 #include <limits>
+#include <set>
+
+#include <osg/Stats>
 
 #include <components/debug/debuglog.hpp>
 #include <components/resource/scenemanager.hpp>
@@ -43,21 +46,97 @@ namespace MWWorld
         std::vector<std::string>& mOut;
     };
 
-    /// Worker thread item: preload models in a cell.
+    /// Worker thread item: preload a single model. Shared by all cells requesting the model while it is pending,
+    /// so the models of a cell are spread over all worker threads and each model is loaded only once.
+    class PreloadMeshItem : public SceneUtil::WorkItem
+    {
+    public:
+        PreloadMeshItem(const std::string& mesh, Resource::SceneManager* sceneManager, Resource::BulletShapeManager* bulletShapeManager, Resource::KeyframeManager* keyframeManager, bool preloadInstances)
+            : mMesh(mesh)
+            , mSceneManager(sceneManager)
+            , mBulletShapeManager(bulletShapeManager)
+            , mKeyframeManager(keyframeManager)
+            , mPreloadInstances(preloadInstances)
+            , mNumUsers(0)
+        {
+        }
+
+        /// Number of cells that still need the model.
+        void addUser() { ++mNumUsers; }
+        void removeUser() { --mNumUsers; }
+        int getNumUsers() const { return mNumUsers; }
+
+        /// Preload work to be called from the worker thread.
+        virtual void doWork()
+        {
+            // all cells requesting the model have been aborted
+            if (mNumUsers <= 0)
+                return;
+
+            try
+            {
+                std::string mesh = Misc::ResourceHelpers::correctActorModelPath(mMesh, mSceneManager->getVFS());
+
+                if (mPreloadInstances)
+                {
+                    mPreloadedObjects.push_back(mSceneManager->cacheInstance(mesh));
+                    mPreloadedObjects.push_back(mBulletShapeManager->cacheInstance(mesh));
+                }
+                else
+                {
+                    mPreloadedObjects.push_back(mSceneManager->getTemplate(mesh));
+                    mPreloadedObjects.push_back(mBulletShapeManager->getShape(mesh));
+                }
+
+                size_t slashpos = mesh.find_last_of("/\\");
+                if (slashpos != std::string::npos && slashpos != mesh.size()-1)
+                {
+                    Misc::StringUtils::lowerCaseInPlace(mesh);
+                    if (mesh[slashpos+1] == 'x')
+                    {
+                        std::string kfname = mesh;
+                        if(kfname.size() > 4 && kfname.compare(kfname.size()-4, 4, ".nif") == 0)
+                        {
+                            kfname.replace(kfname.size()-4, 4, ".kf");
+                            mPreloadedObjects.push_back(mKeyframeManager->get(kfname));
+                        }
+
+                    }
+                }
+            }
+            catch (std::exception& e)
+            {
+                // ignore error for now, would spam the log too much
+                // error will be shown when visiting the cell
+            }
+        }
+
+    private:
+        std::string mMesh;
+        Resource::SceneManager* mSceneManager;
+        Resource::BulletShapeManager* mBulletShapeManager;
+        Resource::KeyframeManager* mKeyframeManager;
+        bool mPreloadInstances;
+
+        std::atomic<int> mNumUsers;
+
+        // keep a ref to the loaded objects to make sure they stay loaded as long as a cell needing them is in the preloaded state
+        std::vector<osg::ref_ptr<const osg::Object> > mPreloadedObjects;
+    };
+
+    /// Worker thread item: preload the terrain of a cell and hold the items preloading its models.
     class PreloadItem : public SceneUtil::WorkItem
     {
     public:
+        typedef std::vector<std::string> MeshList;
+
         /// Constructor to be called from the main thread.
-        PreloadItem(MWWorld::CellStore* cell, Resource::SceneManager* sceneManager, Resource::BulletShapeManager* bulletShapeManager, Resource::KeyframeManager* keyframeManager, Terrain::World* terrain, MWRender::LandManager* landManager, bool preloadInstances)
+        PreloadItem(MWWorld::CellStore* cell, Terrain::World* terrain, MWRender::LandManager* landManager)
             : mIsExterior(cell->getCell()->isExterior())
             , mX(cell->getCell()->getGridX())
             , mY(cell->getCell()->getGridY())
-            , mSceneManager(sceneManager)
-            , mBulletShapeManager(bulletShapeManager)
-            , mKeyframeManager(keyframeManager)
             , mTerrain(terrain)
             , mLandManager(landManager)
-            , mPreloadInstances(preloadInstances)
             , mAbort(false)
         {
             mTerrainView = mTerrain->createView();
@@ -82,15 +161,48 @@ namespace MWWorld
             }
         }
 
+        const MeshList& getMeshes() const
+        {
+            return mMeshes;
+        }
+
+        /// To be called from the main thread.
+        void addMeshItem(PreloadMeshItem* item)
+        {
+            item->addUser();
+            mMeshItems.push_back(item);
+        }
+
+        /// Set the priority of this item and of its pending models. To be called from the main thread.
+        /// @note A model shared with other cells is only given a higher priority value when no other cell needs it.
+        void updatePriority(float priority)
+        {
+            setPriority(priority);
+            for (const osg::ref_ptr<PreloadMeshItem>& item : mMeshItems)
+            {
+                if (!item->isDone() && (priority < item->getPriority() || item->getNumUsers() == 1))
+                    item->setPriority(priority);
+            }
+        }
+
+        void waitTillMeshesDone()
+        {
+            for (const osg::ref_ptr<PreloadMeshItem>& item : mMeshItems)
+                item->waitTillDone();
+        }
+
         virtual void abort()
         {
-            mAbort = true;
+            if (mAbort.exchange(true))
+                return;
+            for (const osg::ref_ptr<PreloadMeshItem>& item : mMeshItems)
+                item->removeUser();
         }
 
         /// Preload work to be called from the worker thread.
         virtual void doWork()
         {
-            if (mIsExterior)
+            if (mIsExterior && !mAbort)
             {
                 try
                 {
@@ -101,63 +213,16 @@ namespace MWWorld
                 {
                 }
             }
-
-            for (std::string& mesh: mMeshes)
-            {
-                if (mAbort)
-                    break;
-
-                try
-                {
-                    mesh = Misc::ResourceHelpers::correctActorModelPath(mesh, mSceneManager->getVFS());
-
-                    if (mPreloadInstances)
-                    {
-                        mPreloadedObjects.push_back(mSceneManager->cacheInstance(mesh));
-                        mPreloadedObjects.push_back(mBulletShapeManager->cacheInstance(mesh));
-                    }
-                    else
-                    {
-                        mPreloadedObjects.push_back(mSceneManager->getTemplate(mesh));
-                        mPreloadedObjects.push_back(mBulletShapeManager->getShape(mesh));
-                    }
-
-                    size_t slashpos = mesh.find_last_of("/\\");
-                    if (slashpos != std::string::npos && slashpos != mesh.size()-1)
-                    {
-                        Misc::StringUtils::lowerCaseInPlace(mesh);
-                        if (mesh[slashpos+1] == 'x')
-                        {
-                            std::string kfname = mesh;
-                            if(kfname.size() > 4 && kfname.compare(kfname.size()-4, 4, ".nif") == 0)
-                            {
-                                kfname.replace(kfname.size()-4, 4, ".kf");
-                                mPreloadedObjects.push_back(mKeyframeManager->get(kfname));
-                            }
-
-                        }
-                    }
-                }
-                catch (std::exception& e)
-                {
-                    // ignore error for now, would spam the log too much
-                    // error will be shown when visiting the cell
-                }
-            }
         }
 
     private:
-        typedef std::vector<std::string> MeshList;
         bool mIsExterior;
         int mX;
         int mY;
         MeshList mMeshes;
-        Resource::SceneManager* mSceneManager;
-        Resource::BulletShapeManager* mBulletShapeManager;
-        Resource::KeyframeManager* mKeyframeManager;
+        std::vector<osg::ref_ptr<PreloadMeshItem> > mMeshItems;
         Terrain::World* mTerrain;
         MWRender::LandManager* mLandManager;
-        bool mPreloadInstances;
 
         std::atomic<bool> mAbort;
 
@@ -235,6 +300,9 @@ namespace MWWorld
         , mMaxCacheSize(0)
         , mPreloadInstances(true)
         , mLastResourceCacheUpdate(0.0)
+        , mPreloadHits(0)
+        , mPreloadLate(0)
+        , mPreloadMisses(0)
     {
     }
 
@@ -257,12 +325,16 @@ namespace MWWorld
             it->second.mWorkItem->abort();
 
         for (PreloadMap::iterator it = mPreloadCells.begin(); it != mPreloadCells.end();++it)
+        {
             it->second.mWorkItem->waitTillDone();
+            it->second.mWorkItem->waitTillMeshesDone();
+        }
 
         mPreloadCells.clear();
+        mPendingMeshes.clear();
     }
 
-    void CellPreloader::preload(CellStore *cell, double timestamp)
+    void CellPreloader::preload(CellStore *cell, double timestamp, float priority)
     {
         if (!mWorkQueue)
         {
@@ -278,7 +350,10 @@ namespace MWWorld
         PreloadMap::iterator found = mPreloadCells.find(cell);
         if (found != mPreloadCells.end())
         {
-            // already preloaded, nothing to do other than updating the timestamp
+            // already preloaded, nothing to do other than updating the timestamp and the priority
+            // a cell may be requested several times at once, e.g. as door destination and as part of the grid
+            if (found->second.mTimeStamp != timestamp || priority < found->second.mWorkItem->getPriority())
+                found->second.mWorkItem->updatePriority(priority);
             found->second.mTimeStamp = timestamp;
             return;
         }
@@ -307,17 +382,47 @@ namespace MWWorld
                 return;
         }
 
-        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mTerrain, mLandManager, mPreloadInstances));
+        osg::ref_ptr<PreloadItem> item (new PreloadItem(cell, mTerrain, mLandManager));
+        item->setPriority(priority);
         mWorkQueue->addWorkItem(item);
 
+        std::set<std::string> meshes;
+        for (const std::string& mesh : item->getMeshes())
+        {
+            std::string key = Misc::StringUtils::lowerCase(mesh);
+            if (!meshes.insert(key).second)
+                continue;
+
+            osg::ref_ptr<PreloadMeshItem>& meshItem = mPendingMeshes[key];
+            if (meshItem && !meshItem->isDone())
+            {
+                if (priority < meshItem->getPriority())
+                    meshItem->setPriority(priority);
+            }
+            else
+            {
+                meshItem = new PreloadMeshItem(mesh, mResourceSystem->getSceneManager(), mBulletShapeManager, mResourceSystem->getKeyframeManager(), mPreloadInstances);
+                meshItem->setPriority(priority);
+                mWorkQueue->addWorkItem(meshItem);
+            }
+            item->addMeshItem(meshItem);
+        }
+
         mPreloadCells[cell] = PreloadEntry(timestamp, item);
     }
 
     void CellPreloader::notifyLoaded(CellStore *cell)
     {
         PreloadMap::iterator found = mPreloadCells.find(cell);
-        if (found != mPreloadCells.end())
+        if (found == mPreloadCells.end())
+            ++mPreloadMisses;
+        else
         {
+            if (found->second.mWorkItem && !found->second.mWorkItem->isDone())
+                ++mPreloadLate;
+            else
+                ++mPreloadHits;
+
             // do the deletion in the background thread
             if (found->second.mWorkItem)
             {
@@ -359,6 +464,21 @@ namespace MWWorld
                 }
                 mPreloadCells.erase(it++);
             }
+            else
+            {
+                // cells that are no longer requested, e.g. because the player changed direction, are preloaded last
+                const double threshold = 1.0; // seconds
+                if (it->second.mTimeStamp + threshold < timestamp && it->second.mWorkItem
+                        && it->second.mWorkItem->getPriority() != std::numeric_limits<float>::max())
+                    it->second.mWorkItem->updatePriority(std::numeric_limits<float>::max());
+                ++it;
+            }
+        }
+
+        for (MeshItemMap::iterator it = mPendingMeshes.begin(); it != mPendingMeshes.end();)
+        {
+            if (it->second->isDone())
+                mPendingMeshes.erase(it++);
             else
                 ++it;
         }
@@ -439,4 +559,12 @@ namespace MWWorld
         }
     }
 
+    void CellPreloader::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        stats.setAttribute(frameNumber, "Preload Cells", mPreloadCells.size());
+        stats.setAttribute(frameNumber, "Preload Hits", mPreloadHits);
+        stats.setAttribute(frameNumber, "Preload Late", mPreloadLate);
+        stats.setAttribute(frameNumber, "Preload Misses", mPreloadMisses);
+    }
+
 }
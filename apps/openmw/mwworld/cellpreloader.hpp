@@ -2,10 +2,16 @@
 #define OPENMW_MWWORLD_CELLPRELOADER_H
 
 #include <map>
+#include <string>
 #include <osg/ref_ptr>
 #include <osg/Vec3f>
 #include <components/sceneutil/workqueue.hpp>
 
+namespace osg
+{
+    class Stats;
+}
+
 namespace Resource
 {
     class ResourceSystem;
@@ -32,6 +38,8 @@ namespace MWWorld
 {
     class CellStore;
     class TerrainPreloadItem;
+    class PreloadItem;
+    class PreloadMeshItem;
 
     class CellPreloader
     {
@@ -40,9 +48,12 @@ namespace MWWorld
         ~CellPreloader();
 
         /// Ask a background thread to preload rendering meshes and collision shapes for objects in this cell.
+        /// @param priority Estimated time in seconds until the cell is needed, cells needed sooner are preloaded first.
+        /// Requesting a cell that is still being preloaded again updates its priority.
         /// @note The cell itself must be in State_Loaded or State_Preloaded.
-        void preload(MWWorld::CellStore* cell, double timestamp);
+        void preload(MWWorld::CellStore* cell, double timestamp, float priority = 0.f);
 
+        /// Counts the load as a preload hit if the cell finished preloading, or as a miss otherwise.
         void notifyLoaded(MWWorld::CellStore* cell);
 
         void clear();
@@ -70,6 +81,8 @@ namespace MWWorld
 
         void setTerrainPreloadPositions(const std::vector<osg::Vec3f>& positions);
 
+        void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
     private:
         Resource::ResourceSystem* mResourceSystem;
         Resource::BulletShapeManager* mBulletShapeManager;
@@ -84,9 +97,14 @@ namespace MWWorld
 
         double mLastResourceCacheUpdate;
 
+        // Loaded cells that were preloaded, still being preloaded, or not requested at all
+        unsigned int mPreloadHits;
+        unsigned int mPreloadLate;
+        unsigned int mPreloadMisses;
+
         struct PreloadEntry
         {
-            PreloadEntry(double timestamp, osg::ref_ptr<SceneUtil::WorkItem> workItem)
+            PreloadEntry(double timestamp, osg::ref_ptr<PreloadItem> workItem)
                 : mTimeStamp(timestamp)
                 , mWorkItem(workItem)
             {
@@ -97,13 +115,18 @@ namespace MWWorld
             }
 
             double mTimeStamp;
-            osg::ref_ptr<SceneUtil::WorkItem> mWorkItem;
+            osg::ref_ptr<PreloadItem> mWorkItem;
         };
         typedef std::map<const MWWorld::CellStore*, PreloadEntry> PreloadMap;
 
         // Cells that are currently being preloaded, or have already finished preloading
         PreloadMap mPreloadCells;
 
+        typedef std::map<std::string, osg::ref_ptr<PreloadMeshItem> > MeshItemMap;
+
+        // Models that are still being preloaded, by lower case name, shared by all cells requesting them
+        MeshItemMap mPendingMeshes;
+
         std::vector<osg::ref_ptr<Terrain::View> > mTerrainViews;
         std::vector<osg::Vec3f> mTerrainPreloadPositions;
         osg::ref_ptr<TerrainPreloadItem> mTerrainPreloadItem;
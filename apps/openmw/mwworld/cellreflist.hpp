@@ -3,6 +3,8 @@
 
 #include <list>
 
+#include <components/misc/poolallocator.hpp>
+
 #include "livecellref.hpp"
 
 namespace MWWorld
@@ -12,7 +14,8 @@ namespace MWWorld
     struct CellRefList
     {
         typedef LiveCellRef<X> LiveRef;
-        typedef std::list<LiveRef> List;
+        // The nodes come from a pool, so loading a cell doesn't allocate each reference on its own
+        typedef std::list<LiveRef, Misc::PoolAllocator<LiveRef> > List;
         List mList;
 
         /// Search for the given reference in the given reclist from
@@ -315,6 +315,30 @@ int MWWorld::Cells::countSavedGameRecords() const
     return count;
 }
 
+void MWWorld::Cells::countLoadedReferences(std::size_t& cells, std::size_t& references) const
+{
+    cells = 0;
+    references = 0;
+
+    for (const auto& interior : mInteriors)
+    {
+        if (interior.second.getState() == CellStore::State_Loaded)
+        {
+            ++cells;
+            references += interior.second.count();
+        }
+    }
+
+    for (const auto& exterior : mExteriors)
+    {
+        if (exterior.second.getState() == CellStore::State_Loaded)
+        {
+            ++cells;
+            references += exterior.second.count();
+        }
+    }
+}
+
 void MWWorld::Cells::write (ESM::ESMWriter& writer, Loading::Listener& progress) const
 {
     for (std::map<std::pair<int, int>, CellStore>::iterator iter (mExteriors.begin());
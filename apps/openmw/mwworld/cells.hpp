@@ -77,6 +77,9 @@ namespace MWWorld
 
             int countSavedGameRecords() const;
 
+            /// Count the cells whose references are loaded, and their references including deleted ones.
+            void countLoadedReferences(std::size_t& cells, std::size_t& references) const;
+
             void write (ESM::ESMWriter& writer, Loading::Listener& progress) const;
 
             bool readRecord (ESM::ESMReader& reader, uint32_t type,
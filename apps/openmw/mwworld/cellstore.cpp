@@ -103,9 +103,21 @@ namespace
         }
     }
 
+    typedef std::map<ESM::RefNum, MWWorld::LiveCellRefBase*> ContentRefIndex;
+
+    template<typename T>
+    void indexContentReferences (MWWorld::CellRefList<T>& collection, ContentRefIndex& index)
+    {
+        for (typename MWWorld::CellRefList<T>::List::iterator iter (collection.mList.begin());
+            iter!=collection.mList.end(); ++iter)
+            if (iter->mRef.hasContentFile())
+                index.insert (std::make_pair (iter->mRef.getRefNum(), &*iter));
+    }
+
     template<typename RecordType, typename T>
     void readReferenceCollection (ESM::ESMReader& reader,
-        MWWorld::CellRefList<T>& collection, const ESM::CellRef& cref, const std::map<int, int>& contentFileMap)
+        MWWorld::CellRefList<T>& collection, const ESM::CellRef& cref, const std::map<int, int>& contentFileMap,
+        const ContentRefIndex& contentRefs)
     {
         const MWWorld::ESMStore& esmStore = MWBase::Environment::get().getWorld()->getStore();
 
@@ -135,6 +147,16 @@ namespace
 
         if (state.mRef.mRefNum.hasContentFile())
         {
+            // The reference with the same id has the same type, so it is in this collection
+            const ContentRefIndex::const_iterator found = contentRefs.find (state.mRef.mRefNum);
+            if (found != contentRefs.end() && *found->second->mRef.getRefIdPtr() == state.mRef.mRefID)
+            {
+                // overwrite existing reference
+                static_cast<MWWorld::LiveCellRef<T>*> (found->second)->load (state);
+                return;
+            }
+
+            // References sharing a RefNum are only indexed once
             for (typename MWWorld::CellRefList<T>::List::iterator iter (collection.mList.begin());
                 iter!=collection.mList.end(); ++iter)
                 if (iter->mRef.getRefNum()==state.mRef.mRefNum && *iter->mRef.getRefIdPtr() == state.mRef.mRefID)
@@ -187,7 +209,7 @@ namespace MWWorld
 
         if (const X *ptr = store.search (ref.mRefID))
         {
-            typename std::list<LiveRef>::iterator iter =
+            typename List::iterator iter =
                 std::find(mList.begin(), mList.end(), ref.mRefNum);
 
             LiveRef liveCellRef (ref, ptr);
@@ -329,12 +351,29 @@ namespace MWWorld
     void CellStore::updateMergedRefs()
     {
         mMergedRefs.clear();
+        mMergedRefsByIdUpToDate = false;
         mRechargingItemsUpToDate = false;
         MergeVisitor visitor(mMergedRefs, mMovedHere, mMovedToAnotherCell);
         forEachInternal(visitor);
         visitor.merge();
     }
 
+    const std::vector<LiveCellRefBase*>* CellStore::findMergedRefs(const std::string& id) const
+    {
+        if (!mMergedRefsByIdUpToDate)
+        {
+            mMergedRefsById.clear();
+            for (LiveCellRefBase* ref : mMergedRefs)
+                mMergedRefsById[*ref->mRef.getRefIdPtr()].push_back(ref);
+            mMergedRefsByIdUpToDate = true;
+        }
+
+        const auto found = mMergedRefsById.find(id);
+        if (found == mMergedRefsById.end())
+            return nullptr;
+        return &found->second;
+    }
+
     bool CellStore::movedHere(const MWWorld::Ptr& ptr) const
     {
         if (ptr.isEmpty())
@@ -347,7 +386,7 @@ namespace MWWorld
     }
 
     CellStore::CellStore (const ESM::Cell *cell, const MWWorld::ESMStore& esmStore, std::vector<ESM::ESMReader>& readerList)
-        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0), mRechargingItemsUpToDate(false)
+        : mStore(esmStore), mReader(readerList), mCell (cell), mState (State_Unloaded), mHasState (false), mLastRespawn(0,0), mMergedRefsByIdUpToDate(false), mRechargingItemsUpToDate(false)
     {
         mWaterLevel = cell->mWater;
     }
@@ -383,36 +422,35 @@ namespace MWWorld
         return searchConst (id).isEmpty();
     }
 
-    template <typename PtrType>
-    struct SearchVisitor
+    Ptr CellStore::search (const std::string& id)
     {
-        PtrType mFound;
-        const std::string *mIdToFind;
-        bool operator()(const PtrType& ptr)
+        if (mMergedRefs.empty())
+            return Ptr();
+
+        mHasState = true;
+
+        if (const std::vector<LiveCellRefBase*>* refs = findMergedRefs(id))
         {
-            if (*ptr.getCellRef().getRefIdPtr() == *mIdToFind)
+            for (LiveCellRefBase* ref : *refs)
             {
-                mFound = ptr;
-                return false;
+                if (isAccessible(ref->mData, ref->mRef))
+                    return Ptr(ref, this);
             }
-            return true;
         }
-    };
-
-    Ptr CellStore::search (const std::string& id)
-    {
-        SearchVisitor<MWWorld::Ptr> searchVisitor;
-        searchVisitor.mIdToFind = &id;
-        forEach(searchVisitor);
-        return searchVisitor.mFound;
+        return Ptr();
     }
 
     ConstPtr CellStore::searchConst (const std::string& id) const
     {
-        SearchVisitor<MWWorld::ConstPtr> searchVisitor;
-        searchVisitor.mIdToFind = &id;
-        forEachConst(searchVisitor);
-        return searchVisitor.mFound;
+        if (const std::vector<LiveCellRefBase*>* refs = findMergedRefs(id))
+        {
+            for (const LiveCellRefBase* ref : *refs)
+            {
+                if (isAccessible(ref->mData, ref->mRef))
+                    return ConstPtr(ref, this);
+            }
+        }
+        return ConstPtr();
     }
 
     Ptr CellStore::searchViaActorId (int id)
@@ -761,6 +799,30 @@ namespace MWWorld
     {
         mHasState = true;
 
+        // Looking up the content file references of large cells one by one is slow
+        ContentRefIndex contentRefs;
+        indexContentReferences (mActivators, contentRefs);
+        indexContentReferences (mPotions, contentRefs);
+        indexContentReferences (mAppas, contentRefs);
+        indexContentReferences (mArmors, contentRefs);
+        indexContentReferences (mBooks, contentRefs);
+        indexContentReferences (mClothes, contentRefs);
+        indexContentReferences (mContainers, contentRefs);
+        indexContentReferences (mCreatures, contentRefs);
+        indexContentReferences (mDoors, contentRefs);
+        indexContentReferences (mIngreds, contentRefs);
+        indexContentReferences (mCreatureLists, contentRefs);
+        indexContentReferences (mItemLists, contentRefs);
+        indexContentReferences (mLights, contentRefs);
+        indexContentReferences (mLockpicks, contentRefs);
+        indexContentReferences (mMiscItems, contentRefs);
+        indexContentReferences (mNpcs, contentRefs);
+        indexContentReferences (mProbes, contentRefs);
+        indexContentReferences (mRepairs, contentRefs);
+        indexContentReferences (mStatics, contentRefs);
+        indexContentReferences (mWeapons, contentRefs);
+        indexContentReferences (mBodyParts, contentRefs);
+
         while (reader.isNextSub ("OBJE"))
         {
             unsigned int unused;
@@ -782,107 +844,107 @@ namespace MWWorld
             {
                 case ESM::REC_ACTI:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mActivators, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mActivators, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_ALCH:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mPotions, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mPotions, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_APPA:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mAppas, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mAppas, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_ARMO:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mArmors, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mArmors, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_BOOK:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mBooks, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mBooks, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_CLOT:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mClothes, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mClothes, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_CONT:
 
-                    readReferenceCollection<ESM::ContainerState> (reader, mContainers, cref, contentFileMap);
+                    readReferenceCollection<ESM::ContainerState> (reader, mContainers, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_CREA:
 
-                    readReferenceCollection<ESM::CreatureState> (reader, mCreatures, cref, contentFileMap);
+                    readReferenceCollection<ESM::CreatureState> (reader, mCreatures, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_DOOR:
 
-                    readReferenceCollection<ESM::DoorState> (reader, mDoors, cref, contentFileMap);
+                    readReferenceCollection<ESM::DoorState> (reader, mDoors, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_INGR:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mIngreds, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mIngreds, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_LEVC:
 
-                    readReferenceCollection<ESM::CreatureLevListState> (reader, mCreatureLists, cref, contentFileMap);
+                    readReferenceCollection<ESM::CreatureLevListState> (reader, mCreatureLists, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_LEVI:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mItemLists, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mItemLists, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_LIGH:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mLights, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mLights, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_LOCK:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mLockpicks, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mLockpicks, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_MISC:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mMiscItems, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mMiscItems, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_NPC_:
 
-                    readReferenceCollection<ESM::NpcState> (reader, mNpcs, cref, contentFileMap);
+                    readReferenceCollection<ESM::NpcState> (reader, mNpcs, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_PROB:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mProbes, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mProbes, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_REPA:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mRepairs, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mRepairs, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_STAT:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mStatics, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mStatics, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_WEAP:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mWeapons, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mWeapons, cref, contentFileMap, contentRefs);
                     break;
 
                 case ESM::REC_BODY:
 
-                    readReferenceCollection<ESM::ObjectState> (reader, mBodyParts, cref, contentFileMap);
+                    readReferenceCollection<ESM::ObjectState> (reader, mBodyParts, cref, contentFileMap, contentRefs);
                     break;
 
                 default:
@@ -975,22 +1037,12 @@ namespace MWWorld
     {
         if (mState == State_Loaded)
         {
-            for (CellRefList<ESM::Creature>::List::iterator it (mCreatures.mList.begin()); it!=mCreatures.mList.end(); ++it)
-            {
-                Ptr ptr = getCurrentPtr(&*it);
-                if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-                {
-                    MWBase::Environment::get().getMechanicsManager()->restoreDynamicStats(ptr, hours, true);
-                }
-            }
-            for (CellRefList<ESM::NPC>::List::iterator it (mNpcs.mList.begin()); it!=mNpcs.mList.end(); ++it)
+            const auto restore = [&] (const LiveCellRefBase&, const Ptr& ptr)
             {
-                Ptr ptr = getCurrentPtr(&*it);
-                if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-                {
-                    MWBase::Environment::get().getMechanicsManager()->restoreDynamicStats(ptr, hours, true);
-                }
-            }
+                MWBase::Environment::get().getMechanicsManager()->restoreDynamicStats(ptr, hours, true);
+            };
+            forEachOwnedRef(mCreatures, restore);
+            forEachOwnedRef(mNpcs, restore);
         }
     }
 
@@ -1001,30 +1053,17 @@ namespace MWWorld
 
         if (mState == State_Loaded)
         {
-            for (CellRefList<ESM::Creature>::List::iterator it (mCreatures.mList.begin()); it!=mCreatures.mList.end(); ++it)
+            const auto rechargeContainerStore = [&] (const LiveCellRefBase&, const Ptr& ptr)
             {
-                Ptr ptr = getCurrentPtr(&*it);
-                if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-                {
-                    ptr.getClass().getContainerStore(ptr).rechargeItems(duration);
-                }
-            }
-            for (CellRefList<ESM::NPC>::List::iterator it (mNpcs.mList.begin()); it!=mNpcs.mList.end(); ++it)
+                ptr.getClass().getContainerStore(ptr).rechargeItems(duration);
+            };
+            forEachOwnedRef(mCreatures, rechargeContainerStore);
+            forEachOwnedRef(mNpcs, rechargeContainerStore);
+            forEachOwnedRef(mContainers, [&] (const LiveCellRefBase& ref, const Ptr& ptr)
             {
-                Ptr ptr = getCurrentPtr(&*it);
-                if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-                {
-                    ptr.getClass().getContainerStore(ptr).rechargeItems(duration);
-                }
-            }
-            for (CellRefList<ESM::Container>::List::iterator it (mContainers.mList.begin()); it!=mContainers.mList.end(); ++it)
-            {
-                Ptr ptr = getCurrentPtr(&*it);
-                if (!ptr.isEmpty() && ptr.getRefData().getCustomData() != nullptr && ptr.getRefData().getCount() > 0)
-                {
-                    ptr.getClass().getContainerStore(ptr).rechargeItems(duration);
-                }
-            }
+                if (ptr.getRefData().getCustomData() != nullptr)
+                    rechargeContainerStore(ref, ptr);
+            });
 
             rechargeItems(duration);
         }
@@ -1083,46 +1122,19 @@ namespace MWWorld
     {
         mRechargingItems.clear();
 
-        for (CellRefList<ESM::Weapon>::List::iterator it (mWeapons.mList.begin()); it!=mWeapons.mList.end(); ++it)
-        {
-            Ptr ptr = getCurrentPtr(&*it);
-            if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-            {
-                checkItem(ptr);
-            }
-        }
-        for (CellRefList<ESM::Armor>::List::iterator it (mArmors.mList.begin()); it!=mArmors.mList.end(); ++it)
-        {
-            Ptr ptr = getCurrentPtr(&*it);
-            if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-            {
-                checkItem(ptr);
-            }
-        }
-        for (CellRefList<ESM::Clothing>::List::iterator it (mClothes.mList.begin()); it!=mClothes.mList.end(); ++it)
-        {
-            Ptr ptr = getCurrentPtr(&*it);
-            if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-            {
-                checkItem(ptr);
-            }
-        }
-        for (CellRefList<ESM::Book>::List::iterator it (mBooks.mList.begin()); it!=mBooks.mList.end(); ++it)
-        {
-            Ptr ptr = getCurrentPtr(&*it);
-            if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
-            {
-                checkItem(ptr);
-            }
-        }
+        // The enchantment is read from the record of the known type, no need for the virtual Class::getEnchantment
+        const auto check = [this] (const auto& ref, const Ptr& ptr) { checkItem(ref.mBase->mEnchant, ptr); };
+        forEachOwnedRef(mWeapons, check);
+        forEachOwnedRef(mArmors, check);
+        forEachOwnedRef(mClothes, check);
+        forEachOwnedRef(mBooks, check);
     }
 
-    void MWWorld::CellStore::checkItem(Ptr ptr)
+    void MWWorld::CellStore::checkItem(const std::string& enchantmentId, const Ptr& ptr)
     {
-        if (ptr.getClass().getEnchantment(ptr).empty())
+        if (enchantmentId.empty())
             return;
 
-        std::string enchantmentId = ptr.getClass().getEnchantment(ptr);
         const ESM::Enchantment* enchantment = MWBase::Environment::get().getWorld()->getStore().get<ESM::Enchantment>().search(enchantmentId);
         if (!enchantment)
         {
@@ -7,6 +7,7 @@
 #include <typeinfo>
 #include <map>
 #include <memory>
+#include <unordered_map>
 
 #include "livecellref.hpp"
 #include "cellreflist.hpp"
@@ -109,6 +110,13 @@ namespace MWWorld
             // Merged list of ref's currently in this cell - i.e. with added refs from mMovedHere, removed refs from mMovedToAnotherCell
             std::vector<LiveCellRefBase*> mMergedRefs;
 
+            // mMergedRefs by ref ID, in the same order. Built on demand, as moved and inserted references change it.
+            mutable std::unordered_map<std::string, std::vector<LiveCellRefBase*> > mMergedRefsById;
+            mutable bool mMergedRefsByIdUpToDate;
+
+            /// Merged refs with the given ID, nullptr if there are none.
+            const std::vector<LiveCellRefBase*>* findMergedRefs(const std::string& id) const;
+
             // Get the Ptr for the given ref which originated from this cell (possibly moved to another cell at this point).
             Ptr getCurrentPtr(MWWorld::LiveCellRefBase* ref);
 
@@ -126,7 +134,20 @@ namespace MWWorld
 
             void updateRechargingItems();
             void rechargeItems(float duration);
-            void checkItem(Ptr ptr);
+            void checkItem(const std::string& enchantmentId, const Ptr& ptr);
+
+            /// Call function (LiveCellRef<T>&, const Ptr&) for each reference of the list that wasn't removed, including
+            /// the ones that moved to another cell.
+            template <class T, class Function>
+            void forEachOwnedRef(CellRefList<T>& list, Function&& function)
+            {
+                for (typename CellRefList<T>::List::iterator it (list.mList.begin()); it!=list.mList.end(); ++it)
+                {
+                    Ptr ptr = getCurrentPtr(&*it);
+                    if (!ptr.isEmpty() && ptr.getRefData().getCount() > 0)
+                        function(*it, ptr);
+                }
+            }
 
             // helper function for forEachInternal
             template<class Visitor, class List>
@@ -320,6 +341,19 @@ namespace MWWorld
             /// \return Iteration completed?
             template <class T, class Visitor>
             bool forEachType(Visitor& visitor)
+            {
+                return forEachLiveCellRef<T>([&] (LiveCellRef<T>&, const Ptr& ptr) { return visitor(ptr); });
+            }
+
+            /// Call visitor (LiveCellRef<T>&, const MWWorld::Ptr&) for each reference of given type. Unlike forEachType,
+            /// the visitor gets the record with its static type, so type-specific logic can read it directly instead of
+            /// going through the virtual methods of MWWorld::Class. visitor must return a bool. Returning false will abort
+            /// the iteration.
+            /// \note Do not modify this cell (i.e. remove/add objects) during the forEach, doing this may result in unintended behaviour.
+            /// \attention This function also lists deleted (count 0) objects!
+            /// \return Iteration completed?
+            template <class T, class Visitor>
+            bool forEachLiveCellRef(Visitor&& visitor)
             {
                 if (mState != State_Loaded)
                     return false;
@@ -338,15 +372,15 @@ namespace MWWorld
                         continue;
                     if (!isAccessible(base->mData, base->mRef))
                         continue;
-                    if (!visitor(MWWorld::Ptr(base, this)))
+                    if (!visitor(*it, MWWorld::Ptr(base, this)))
                         return false;
                 }
 
                 for (MovedRefTracker::const_iterator it = mMovedHere.begin(); it != mMovedHere.end(); ++it)
                 {
                     LiveCellRefBase* base = it->first;
-                    if (dynamic_cast<LiveCellRef<T>*>(base))
-                        if (!visitor(MWWorld::Ptr(base, this)))
+                    if (LiveCellRef<T>* ref = dynamic_cast<LiveCellRef<T>*>(base))
+                        if (!visitor(*ref, MWWorld::Ptr(base, this)))
                             return false;
                 }
                 return true;
@@ -375,6 +409,11 @@ namespace MWWorld
 
             void readFog (ESM::ESMReader& reader);
 
+            /// Write the state of all references that differ from the content files.
+            /// @note There is no list of dirty references, the references are not linked to the cell that owns them.
+            /// RefData::setCustomData marks every container, NPC and creature with custom data as changed, and
+            /// their inventories and stats are modified through the class, without going through the cell.
+            /// Skipping an unchanged reference only tests its change flags, the time is spent in saving the rest.
             void writeReferences (ESM::ESMWriter& writer) const;
 
             struct GetCellStoreCallback
@@ -1,5 +1,6 @@
 #include "containerstore.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <typeinfo>
 #include <stdexcept>
@@ -7,6 +8,8 @@
 #include <components/debug/debuglog.hpp>
 #include <components/esm/inventorystate.hpp>
 
+#include <components/misc/stringops.hpp>
+
 #include "../mwbase/environment.hpp"
 #include "../mwbase/world.hpp"
 
@@ -39,26 +42,6 @@ namespace
 
         return sum;
     }
-
-    template<typename T>
-    MWWorld::Ptr searchId (MWWorld::CellRefList<T>& list, const std::string& id,
-        MWWorld::ContainerStore *store)
-    {
-        std::string id2 = Misc::StringUtils::lowerCase (id);
-
-        for (typename MWWorld::CellRefList<T>::List::iterator iter (list.mList.begin());
-             iter!=list.mList.end(); ++iter)
-        {
-            if (Misc::StringUtils::ciEqual(iter->mBase->mId, id2) && iter->mData.getCount())
-            {
-                MWWorld::Ptr ptr (&*iter, 0);
-                ptr.setContainerStore (store);
-                return ptr;
-            }
-        }
-
-        return MWWorld::Ptr();
-    }
 }
 
 template<typename T>
@@ -113,6 +96,26 @@ void MWWorld::ContainerStore::storeStates (const CellRefList<T>& collection,
     }
 }
 
+template<typename T>
+void MWWorld::ContainerStore::addStacks (CellRefList<T>& collection)
+{
+    for (typename CellRefList<T>::List::iterator iter (collection.mList.begin()); iter!=collection.mList.end(); ++iter)
+        mStackIndex.mStacks[Misc::StringUtils::lowerCase(iter->mBase->mId)].push_back(ContainerStoreIterator(this, iter));
+}
+
+MWWorld::ContainerStore::StackIndex::StackIndex()
+    : mUpToDate(false) {}
+
+MWWorld::ContainerStore::StackIndex::StackIndex(const StackIndex&)
+    : mUpToDate(false) {}
+
+MWWorld::ContainerStore::StackIndex& MWWorld::ContainerStore::StackIndex::operator= (const StackIndex&)
+{
+    mStacks.clear();
+    mUpToDate = false;
+    return *this;
+}
+
 const std::string MWWorld::ContainerStore::sGoldId = "gold_001";
 
 MWWorld::ContainerStore::ContainerStore()
@@ -153,22 +156,45 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::end()
     return ContainerStoreIterator (this);
 }
 
+const std::vector<MWWorld::ContainerStoreIterator>& MWWorld::ContainerStore::getStacks (const std::string& id)
+{
+    if (!mStackIndex.mUpToDate)
+    {
+        mStackIndex.mStacks.clear();
+        addStacks (potions);
+        addStacks (appas);
+        addStacks (armors);
+        addStacks (books);
+        addStacks (clothes);
+        addStacks (ingreds);
+        addStacks (lights);
+        addStacks (lockpicks);
+        addStacks (miscItems);
+        addStacks (probes);
+        addStacks (repairs);
+        addStacks (weapons);
+        mStackIndex.mUpToDate = true;
+    }
+
+    static const std::vector<ContainerStoreIterator> empty;
+    const auto found = mStackIndex.mStacks.find(Misc::StringUtils::lowerCase(id));
+    return found == mStackIndex.mStacks.end() ? empty : found->second;
+}
+
 int MWWorld::ContainerStore::count(const std::string &id)
 {
     int total=0;
-    for (MWWorld::ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
-            total += iter->getRefData().getCount();
+    for (const ContainerStoreIterator& iter : getStacks(id))
+        total += iter->getRefData().getCount();
     return total;
 }
 
 int MWWorld::ContainerStore::restockCount(const std::string &id)
 {
     int total=0;
-    for (MWWorld::ContainerStoreIterator iter (begin()); iter!=end(); ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
-            if (iter->getCellRef().getSoul().empty())
-                total += iter->getRefData().getCount();
+    for (const ContainerStoreIterator& iter : getStacks(id))
+        if (iter->getCellRef().getSoul().empty())
+            total += iter->getRefData().getCount();
     return total;
 }
 
@@ -330,8 +356,6 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::add (const Ptr& itemPtr
 
 MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addImp (const Ptr& ptr, int count)
 {
-    int type = getType(ptr);
-
     const MWWorld::ESMStore &esmStore =
         MWBase::Environment::get().getWorld()->getStore();
 
@@ -341,12 +365,12 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addImp (const Ptr& ptr,
     {
         int realCount = count * ptr.getClass().getValue(ptr);
 
-        for (MWWorld::ContainerStoreIterator iter (begin(type)); iter!=end(); ++iter)
+        for (const ContainerStoreIterator& iter : getStacks(MWWorld::ContainerStore::sGoldId))
         {
-            if (Misc::StringUtils::ciEqual((*iter).getCellRef().getRefId(), MWWorld::ContainerStore::sGoldId))
+            if (iter->getRefData().getCount())
             {
                 iter->getRefData().setCount(iter->getRefData().getCount() + realCount);
-                flagAsModified();
+                flagAsModified(*iter, realCount);
                 return iter;
             }
         }
@@ -356,14 +380,14 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addImp (const Ptr& ptr,
     }
 
     // determine whether to stack or not
-    for (MWWorld::ContainerStoreIterator iter (begin(type)); iter!=end(); ++iter)
+    for (const ContainerStoreIterator& iter : getStacks(ptr.getCellRef().getRefId()))
     {
-        if (stacks(*iter, ptr))
+        if (iter->getRefData().getCount() && stacks(*iter, ptr))
         {
             // stack
             iter->getRefData().setCount( iter->getRefData().getCount() + count );
 
-            flagAsModified();
+            flagAsModified(*iter, count);
             return iter;
         }
     }
@@ -393,7 +417,10 @@ MWWorld::ContainerStoreIterator MWWorld::ContainerStore::addNewStack (const Cons
 
     it->getRefData().setCount(count);
 
-    flagAsModified();
+    if (mStackIndex.mUpToDate)
+        mStackIndex.mStacks[Misc::StringUtils::lowerCase(it->getCellRef().getRefId())].push_back(it);
+
+    flagAsModified(*it, count);
     return it;
 }
 
@@ -441,11 +468,11 @@ int MWWorld::ContainerStore::remove(const std::string& itemId, int count, const
 {
     int toRemove = count;
 
-    for (ContainerStoreIterator iter(begin()); iter != end() && toRemove > 0; ++iter)
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), itemId))
-            toRemove -= remove(*iter, toRemove, actor);
-
-    flagAsModified();
+    // Copy, removing items can add new stacks
+    const std::vector<ContainerStoreIterator> stacks = getStacks(itemId);
+    for (std::vector<ContainerStoreIterator>::const_iterator iter (stacks.begin()); iter != stacks.end() && toRemove > 0; ++iter)
+        if ((*iter)->getRefData().getCount())
+            toRemove -= remove(**iter, toRemove, actor);
 
     // number of removed items
     return count - toRemove;
@@ -480,7 +507,7 @@ int MWWorld::ContainerStore::remove(const Ptr& item, int count, const Ptr& actor
         toRemove = 0;
     }
 
-    flagAsModified();
+    flagAsModified(item, -(count - toRemove));
 
     // we should not fire event for InventoryStore yet - it has some custom logic
     if (mListener && !actor.getClass().hasInventoryStore(actor))
@@ -665,6 +692,13 @@ void MWWorld::ContainerStore::flagAsModified()
     mRechargingItemsUpToDate = false;
 }
 
+void MWWorld::ContainerStore::flagAsModified (const ConstPtr& item, int count)
+{
+    if (mWeightUpToDate)
+        mCachedWeight = std::max(0.f, mCachedWeight + count * item.getClass().getWeight(item));
+    mRechargingItemsUpToDate = false;
+}
+
 float MWWorld::ContainerStore::getWeight() const
 {
     if (!mWeightUpToDate)
@@ -739,20 +773,19 @@ MWWorld::Ptr MWWorld::ContainerStore::findReplacement(const std::string& id)
 {
     MWWorld::Ptr item;
     int itemHealth = 1;
-    for (MWWorld::ContainerStoreIterator iter = begin(); iter != end(); ++iter)
+    for (const ContainerStoreIterator& iter : getStacks(id))
     {
+        if (!iter->getRefData().getCount())
+            continue;
         int iterHealth = iter->getClass().hasItemHealth(*iter) ? iter->getClass().getItemHealth(*iter) : 1;
-        if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), id))
+        // Prefer the stack with the lowest remaining uses
+        // Try to get item with zero durability only if there are no other items found
+        if (item.isEmpty() ||
+            (iterHealth > 0 && iterHealth < itemHealth) ||
+            (itemHealth <= 0 && iterHealth > 0))
         {
-            // Prefer the stack with the lowest remaining uses
-            // Try to get item with zero durability only if there are no other items found
-            if (item.isEmpty() ||
-                (iterHealth > 0 && iterHealth < itemHealth) ||
-                (itemHealth <= 0 && iterHealth > 0))
-            {
-                item = *iter;
-                itemHealth = iterHealth;
-            }
+            item = *iter;
+            itemHealth = iterHealth;
         }
     }
 
@@ -761,76 +794,10 @@ MWWorld::Ptr MWWorld::ContainerStore::findReplacement(const std::string& id)
 
 MWWorld::Ptr MWWorld::ContainerStore::search (const std::string& id)
 {
+    for (const ContainerStoreIterator& iter : getStacks(id))
     {
-        Ptr ptr = searchId (potions, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (appas, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (armors, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (books, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (clothes, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (ingreds, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (lights, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (lockpicks, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (miscItems, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (probes, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (repairs, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
-    }
-
-    {
-        Ptr ptr = searchId (weapons, id, this);
-        if (!ptr.isEmpty())
-            return ptr;
+        if (iter->getRefData().getCount())
+            return *iter;
     }
 
     return Ptr();
@@ -896,6 +863,7 @@ void MWWorld::ContainerStore::readState (const ESM::InventoryState& inventory)
 
 
     mLevelledItemMap = inventory.mLevelledItemMap;
+    mStackIndex.mUpToDate = false;
 }
 
 template<class PtrType>
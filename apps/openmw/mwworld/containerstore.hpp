@@ -3,7 +3,9 @@
 
 #include <iterator>
 #include <map>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <components/esm/loadalch.hpp>
 #include <components/esm/loadappa.hpp>
@@ -98,6 +100,25 @@ namespace MWWorld
 
             mutable float mCachedWeight;
             mutable bool mWeightUpToDate;
+
+            /// Stacks by lower case ID, including the empty ones, in the order of iteration.
+            /// Not copied with the store, as the iterators belong to the original.
+            struct StackIndex
+            {
+                std::unordered_map<std::string, std::vector<ContainerStoreIterator> > mStacks;
+                bool mUpToDate;
+
+                StackIndex();
+                StackIndex(const StackIndex&);
+                StackIndex& operator= (const StackIndex&);
+            };
+            StackIndex mStackIndex;
+
+            const std::vector<ContainerStoreIterator>& getStacks (const std::string& id);
+
+            template<typename T>
+            void addStacks (CellRefList<T>& collection);
+
             ContainerStoreIterator addImp (const Ptr& ptr, int count);
             void addInitialItem (const std::string& id, const std::string& owner, int count, bool topLevel=true, const std::string& levItem = "");
             void addInitialItemImp (const MWWorld::Ptr& ptr, const std::string& owner, int count, bool topLevel=true, const std::string& levItem = "");
@@ -190,6 +211,10 @@ namespace MWWorld
 
             virtual void flagAsModified();
 
+            void flagAsModified (const ConstPtr& item, int count);
+            ///< Like flagAsModified(), but keeps the cached weight up to date by adding the weight of \a count
+            /// items (negative for removed items) instead of recalculating it.
+
         public:
 
             virtual bool stacks (const ConstPtr& ptr1, const ConstPtr& ptr2) const;
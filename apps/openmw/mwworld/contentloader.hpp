@@ -1,6 +1,9 @@
 #ifndef CONTENTLOADER_HPP
 #define CONTENTLOADER_HPP
 
+#include <utility>
+#include <vector>
+
 #include <boost/filesystem/path.hpp>
 #include <MyGUI_TextIterator.h>
 
@@ -21,6 +24,14 @@ struct ContentLoader
     {
     }
 
+    typedef std::vector<std::pair<int, boost::filesystem::path> > FileList;
+
+    /// Called with all files and their indices before the first load() call, so that
+    /// loaders can do work that doesn't depend on the load order up front.
+    virtual void prepare(const FileList& files)
+    {
+    }
+
     virtual void load(const boost::filesystem::path& filepath, int& index)
     {
         Log(Debug::Info) << "Loading content file " << filepath.string();
@@ -1,20 +1,92 @@
 #include "esmloader.hpp"
 #include "esmstore.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/debug/debuglog.hpp>
 #include <components/esm/esmreader.hpp>
+#include <components/esm/esmwriter.hpp>
+#include <components/to_utf8/to_utf8.hpp>
+
+namespace
+{
+  // Increase when the layout of the cache or of any cached record changes
+  const int sCacheFormat = 1;
+
+  const unsigned int sCacheKeyRecord = ESM::FourCC<'C','K','E','Y'>::value;
+}
 
 namespace MWWorld
 {
 
 EsmLoader::EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener)
+  ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener, const boost::filesystem::path& cacheFile)
   : ContentLoader(listener)
   , mEsm(readers)
   , mStore(store)
   , mEncoder(encoder)
+  , mCacheFile(cacheFile)
+  , mCacheLoaded(false)
 {
 }
 
+void EsmLoader::prepare(const FileList& files)
+{
+  mFiles = files;
+  mParsed.clear();
+
+  mCacheLoaded = loadCache();
+  if (mCacheLoaded)
+    return;
+
+  mParsed.resize(mEsm.size());
+
+  std::atomic<size_t> next(0);
+  auto worker = [&] ()
+  {
+    // Encoders are not thread safe
+    std::unique_ptr<ToUTF8::Utf8Encoder> encoder;
+    if (mEncoder)
+      encoder.reset(new ToUTF8::Utf8Encoder(mEncoder->getSourceEncoding()));
+
+    for (size_t i = next++; i < files.size(); i = next++)
+    {
+      const int index = files[i].first;
+      if (index < 0 || static_cast<size_t>(index) >= mParsed.size())
+        continue;
+
+      try
+      {
+        ESM::ESMReader reader;
+        reader.setEncoder(encoder.get());
+        reader.setIndex(index);
+        reader.open(files[i].second.string());
+        mStore.parse(reader, mParsed[index]);
+      }
+      catch (const std::exception& e)
+      {
+        // load() reads the file again in order and reports the error properly
+        Log(Debug::Verbose) << "Failed to parse content file " << files[i].second.string() << " ahead of loading: " << e.what();
+        mParsed[index].clear();
+      }
+    }
+  };
+
+  const size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), files.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
 void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
 {
   ContentLoader::load(filepath.filename(), index);
@@ -25,7 +97,134 @@ void EsmLoader::load(const boost::filesystem::path& filepath, int& index)
   lEsm.setGlobalReaderList(&mEsm);
   lEsm.open(filepath.string());
   mEsm[index] = lEsm;
-  mStore.load(mEsm[index], &mListener);
+
+  ParsedRecords* parsed = nullptr;
+  if (static_cast<size_t>(index) < mParsed.size() && !mParsed[index].empty())
+    parsed = &mParsed[index];
+  mStore.load(mEsm[index], &mListener, parsed, mCacheLoaded);
+
+  if (parsed)
+    ParsedRecords().swap(*parsed);
+}
+
+void EsmLoader::writeCache()
+{
+  if (mCacheFile.empty() || mCacheLoaded)
+    return;
+
+  const boost::filesystem::path tempFile = mCacheFile.string() + ".tmp";
+  try
+  {
+    boost::filesystem::create_directories(mCacheFile.parent_path());
+
+    boost::filesystem::ofstream stream(tempFile, std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("Failed to open " + tempFile.string());
+
+    // Strings are cached in UTF-8, the cache is read without an encoder
+    ESM::ESMWriter writer;
+    writer.setFormat(sCacheFormat);
+    writer.save(stream);
+
+    writeCacheKey(writer);
+    mStore.writeStatic(writer);
+    writer.close();
+
+    stream.close();
+    if (stream.fail())
+      throw std::runtime_error("Failed to write " + tempFile.string());
+
+    boost::filesystem::rename(tempFile, mCacheFile);
+    Log(Debug::Info) << "Content cache written to " << mCacheFile.string();
+  }
+  catch (const std::exception& e)
+  {
+    Log(Debug::Warning) << "Failed to write content cache " << mCacheFile.string() << ": " << e.what();
+    boost::system::error_code ec;
+    boost::filesystem::remove(tempFile, ec);
+  }
+}
+
+bool EsmLoader::loadCache()
+{
+  if (mCacheFile.empty() || !boost::filesystem::exists(mCacheFile))
+    return false;
+
+  ESM::ESMReader reader;
+  try
+  {
+    reader.open(mCacheFile.string());
+    if (reader.getFormat() != sCacheFormat || !readCacheKey(reader))
+    {
+      Log(Debug::Info) << "Content cache " << mCacheFile.string() << " is out of date";
+      return false;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    Log(Debug::Warning) << "Failed to read content cache " << mCacheFile.string() << ": " << e.what();
+    return false;
+  }
+
+  try
+  {
+    mStore.loadStatic(reader);
+  }
+  catch (const std::exception& e)
+  {
+    // The store may already contain some of the cached records, which are overwritten by loading the
+    // content files again. Don't write a new cache from that state, the next run will write it.
+    Log(Debug::Warning) << "Failed to read content cache " << mCacheFile.string() << ": " << e.what();
+    reader.close();
+    boost::system::error_code ec;
+    boost::filesystem::remove(mCacheFile, ec);
+    mCacheFile.clear();
+    return false;
+  }
+
+  Log(Debug::Info) << "Loaded records from content cache " << mCacheFile.string();
+  return true;
+}
+
+void EsmLoader::writeCacheKey(ESM::ESMWriter& writer) const
+{
+  writer.startRecord(sCacheKeyRecord);
+  writer.writeHNT("ENCD", mEncoder ? static_cast<int>(mEncoder->getSourceEncoding()) : -1);
+  for (const auto& file : mFiles)
+  {
+    writer.writeHNString("NAME", file.second.string());
+    writer.writeHNT("SIZE", static_cast<uint64_t>(boost::filesystem::file_size(file.second)));
+    writer.writeHNT("TIME", static_cast<int64_t>(boost::filesystem::last_write_time(file.second)));
+  }
+  writer.endRecord(sCacheKeyRecord);
+}
+
+bool EsmLoader::readCacheKey(ESM::ESMReader& reader) const
+{
+  if (!reader.hasMoreRecs() || reader.getRecName().intval != sCacheKeyRecord)
+    return false;
+  reader.getRecHeader();
+
+  int encoding = 0;
+  reader.getHNT(encoding, "ENCD");
+  if (encoding != (mEncoder ? static_cast<int>(mEncoder->getSourceEncoding()) : -1))
+    return false;
+
+  for (const auto& file : mFiles)
+  {
+    if (!reader.hasMoreSubs() || reader.getHNString("NAME") != file.second.string())
+      return false;
+
+    uint64_t size = 0;
+    int64_t time = 0;
+    reader.getHNT(size, "SIZE");
+    reader.getHNT(time, "TIME");
+    if (size != boost::filesystem::file_size(file.second)
+        || time != static_cast<int64_t>(boost::filesystem::last_write_time(file.second)))
+      return false;
+  }
+
+  return !reader.hasMoreSubs();
 }
 
 } /* namespace MWWorld */
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "contentloader.hpp"
+#include "store.hpp"
 
 namespace ToUTF8
 {
@@ -13,6 +14,7 @@ namespace ToUTF8
 namespace ESM
 {
     class ESMReader;
+    class ESMWriter;
 }
 
 namespace MWWorld
@@ -22,15 +24,37 @@ class ESMStore;
 
 struct EsmLoader : public ContentLoader
 {
+    /// @param cacheFile Content cache to use, see writeCache(). Optional.
     EsmLoader(MWWorld::ESMStore& store, std::vector<ESM::ESMReader>& readers,
-      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener);
+      ToUTF8::Utf8Encoder* encoder, Loading::Listener& listener,
+      const boost::filesystem::path& cacheFile = boost::filesystem::path());
+
+    /// Read the records that can be parsed ahead from the content cache if it is up to date. Otherwise
+    /// parse the given files on worker threads, load() then only merges the parsed records in load order.
+    void prepare(const FileList& files);
 
     void load(const boost::filesystem::path& filepath, int& index);
 
+    /// Write the merged records to the content cache, unless they were read from it.
+    /// Must be called after loading all files and before ESMStore::setUp().
+    void writeCache();
+
     private:
+      bool loadCache();
+
+      void writeCacheKey(ESM::ESMWriter& writer) const;
+      bool readCacheKey(ESM::ESMReader& reader) const;
+
       std::vector<ESM::ESMReader>& mEsm;
       MWWorld::ESMStore& mStore;
       ToUTF8::Utf8Encoder* mEncoder;
+
+      boost::filesystem::path mCacheFile;
+      bool mCacheLoaded;
+      FileList mFiles;
+
+      // Result of prepare(), indexed like mEsm
+      std::vector<ParsedRecords> mParsed;
 };
 
 } /* namespace MWWorld */
@@ -26,7 +26,52 @@ static bool isCacheableRecord(int id)
     return false;
 }
 
-void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
+void ESMStore::parse(ESM::ESMReader &esm, ParsedRecords &parsed) const
+{
+    parsed.clear();
+
+    while(esm.hasMoreRecs())
+    {
+        ESM::NAME n = esm.getRecName();
+        esm.getRecHeader();
+
+        std::unique_ptr<StoreBase::ParsedRecord> record;
+        std::map<int, StoreBase *>::const_iterator it = mStores.find(n.intval);
+        if (it != mStores.end())
+            record = it->second->parse(esm);
+
+        if (!record)
+            esm.skipRecord();
+
+        parsed.push_back(std::move(record));
+    }
+}
+
+void ESMStore::writeStatic(ESM::ESMWriter& writer) const
+{
+    for (std::map<int, StoreBase *>::const_iterator it = mStores.begin(); it != mStores.end(); ++it)
+    {
+        if (it->second->canParseAhead())
+            it->second->writeStatic(writer);
+    }
+}
+
+void ESMStore::loadStatic(ESM::ESMReader &esm)
+{
+    while(esm.hasMoreRecs())
+    {
+        ESM::NAME n = esm.getRecName();
+        esm.getRecHeader();
+
+        std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
+        if (it == mStores.end() || !it->second->canParseAhead())
+            esm.fail("Unexpected record: " + n.toString());
+
+        it->second->load(esm);
+    }
+}
+
+void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener, ParsedRecords* parsed, bool skipParsedAhead)
 {
     listener->setProgressRange(1000);
 
@@ -67,11 +112,17 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
     }
 
     // Loop through all records
+    size_t recordIndex = 0;
     while(esm.hasMoreRecs())
     {
         ESM::NAME n = esm.getRecName();
         esm.getRecHeader();
 
+        StoreBase::ParsedRecord* parsedRecord = nullptr;
+        if (parsed && recordIndex < parsed->size())
+            parsedRecord = (*parsed)[recordIndex].get();
+        ++recordIndex;
+
         // Look up the record type.
         std::map<int, StoreBase *>::iterator it = mStores.find(n.intval);
 
@@ -101,8 +152,19 @@ void ESMStore::load(ESM::ESMReader &esm, Loading::Listener* listener)
                 error << "Unknown record: " << n.toString();
                 throw std::runtime_error(error.str());
             }
+        } else if (skipParsedAhead && it->second->canParseAhead()) {
+            esm.skipRecord();
+            dialogue = 0;
         } else {
-            RecordId id = it->second->load(esm);
+            RecordId id;
+            if (parsedRecord)
+            {
+                esm.skipRecord();
+                id = it->second->apply(*parsedRecord);
+            }
+            else
+                id = it->second->load(esm);
+
             if (id.mIsDeleted)
             {
                 it->second->eraseStatic(id.mId);
@@ -161,7 +161,23 @@ namespace MWWorld
             mNpcs.insert(mPlayerTemplate);
         }
 
-        void load(ESM::ESMReader &esm, Loading::Listener* listener);
+        /// Load all records of a content file.
+        /// @param parsed Records parsed ahead by parse(), they are merged in place of reading them again. Optional.
+        /// @param skipParsedAhead Skip all records that could be parsed ahead, because they were already read by loadStatic().
+        void load(ESM::ESMReader &esm, Loading::Listener* listener, ParsedRecords* parsed = nullptr,
+                  bool skipParsedAhead = false);
+
+        /// Parse the records of a content file that don't depend on other records, so
+        /// that load() only has to merge them. Doesn't modify the store.
+        /// @note Thread safe, may be called for several content files in parallel.
+        void parse(ESM::ESMReader &esm, ParsedRecords &parsed) const;
+
+        /// Write the merged records that can be parsed ahead, i.e. everything except cells, lands,
+        /// dialogues and the other records that have to be loaded in order. Must be called before setUp().
+        void writeStatic(ESM::ESMWriter& writer) const;
+
+        /// Read records written by writeStatic(). The content files must then be loaded with skipParsedAhead.
+        void loadStatic(ESM::ESMReader &esm);
 
         template <class T>
         const Store<T> &get() const {
@@ -123,6 +123,7 @@ MWWorld::InventoryStore& MWWorld::InventoryStore::operator= (const InventoryStor
     mMagicEffects = store.mMagicEffects;
     mFirstAutoEquip = store.mFirstAutoEquip;
     mPermanentMagicEffectMagnitudes = store.mPermanentMagicEffectMagnitudes;
+    mSlotEffects.clear();
     mRechargingItemsUpToDate = false;
     ContainerStore::operator= (store);
     mSlots.clear();
@@ -573,13 +574,30 @@ void MWWorld::InventoryStore::updateMagicEffects(const Ptr& actor)
     if (!mInventoryListener)
         return;
 
-    mMagicEffects = MWMechanics::MagicEffects();
-
     if (actor.getClass().getCreatureStats(actor).isDead())
+    {
+        mMagicEffects = MWMechanics::MagicEffects();
+        mSlotEffects.clear();
         return;
+    }
 
-    for (TSlots::const_iterator iter (mSlots.begin()); iter!=mSlots.end(); ++iter)
+    bool changed = mSlotEffects.size() != mSlots.size();
+    if (changed)
+        mSlotEffects.assign(mSlots.size(), SlotEffects());
+
+    for (std::size_t slot = 0; slot < mSlots.size(); ++slot)
     {
+        const TSlots::const_iterator iter = mSlots.begin() + slot;
+        const LiveCellRefBase* item = *iter == end() ? nullptr : (*iter)->getBase();
+
+        // Only the slots with a different item than at the last update need their effects to be calculated again
+        SlotEffects& slotEffects = mSlotEffects[slot];
+        if (slotEffects.mItem == item)
+            continue;
+        changed = true;
+        slotEffects.mItem = item;
+        slotEffects.mEffects = MWMechanics::MagicEffects();
+
         if (*iter==end())
             continue;
 
@@ -647,13 +665,20 @@ void MWWorld::InventoryStore::updateMagicEffects(const Ptr& actor)
                 }
 
                 if (magnitude)
-                    mMagicEffects.add (effect, magnitude);
+                    slotEffects.mEffects.add (effect, magnitude);
 
                 i++;
             }
         }
     }
 
+    if (!changed)
+        return;
+
+    mMagicEffects = MWMechanics::MagicEffects();
+    for (const SlotEffects& slotEffects : mSlotEffects)
+        mMagicEffects += slotEffects.mEffects;
+
     // Now drop expired effects
     for (TEffectMagnitudes::iterator it = mPermanentMagicEffectMagnitudes.begin();
          it != mPermanentMagicEffectMagnitudes.end();)
@@ -729,8 +754,6 @@ int MWWorld::InventoryStore::remove(const std::string& itemId, int count, const
         if (Misc::StringUtils::ciEqual(iter->getCellRef().getRefId(), itemId))
             toRemove -= remove(*iter, toRemove, actor, equipReplacement);
 
-    flagAsModified();
-
     // number of removed items
     return count - toRemove;
 }
@@ -869,6 +892,7 @@ MWWorld::InventoryStoreListener* MWWorld::InventoryStore::getInvListener()
 void MWWorld::InventoryStore::setInvListener(InventoryStoreListener *listener, const Ptr& actor)
 {
     mInventoryListener = listener;
+    mSlotEffects.clear();
     updateMagicEffects(actor);
 }
 
@@ -90,6 +90,16 @@ namespace MWWorld
             typedef std::map<std::string, std::vector<EffectParams> > TEffectMagnitudes;
             TEffectMagnitudes mPermanentMagicEffectMagnitudes;
 
+            // Constant effects of the item in each slot at the last update of mMagicEffects
+            struct SlotEffects
+            {
+                const LiveCellRefBase* mItem;
+                MWMechanics::MagicEffects mEffects;
+
+                SlotEffects() : mItem(nullptr) {}
+            };
+            std::vector<SlotEffects> mSlotEffects;
+
             typedef std::vector<ContainerStoreIterator> TSlots;
 
             TSlots mSlots;
@@ -2,6 +2,9 @@
 
 #include <components/debug/debuglog.hpp>
 
+#include "../mwbase/environment.hpp"
+#include "../mwbase/scriptmanager.hpp"
+
 #include "esmstore.hpp"
 #include "cellstore.hpp"
 #include "class.hpp"
@@ -102,6 +105,9 @@ void MWWorld::LocalScripts::add (const std::string& scriptName, const Ptr& ptr)
                 }
 
             mScripts.push_back (std::make_pair (scriptName, ptr));
+
+            // Scripts are mostly added while loading cells, compile them now rather than on their first run
+            MWBase::Environment::get().getScriptManager()->precompile (scriptName);
         }
         catch (const std::exception& exception)
         {
@@ -45,6 +45,22 @@
 
 namespace
 {
+    MWPhysics::PhysicsSystem::RayQuery getImpactQuery(const osg::Vec3f& from, const osg::Vec3f& to, const MWWorld::Ptr& caster)
+    {
+        MWPhysics::PhysicsSystem::RayQuery query;
+        query.mFrom = from;
+        query.mTo = to;
+        query.mIgnore = caster;
+        query.mMask = 0xff;
+        query.mGroup = MWPhysics::CollisionType_Projectile;
+
+        // For AI actors, get combat targets to use in the ray cast. Only those targets will return a positive hit result.
+        if (!caster.isEmpty() && caster.getClass().isActor() && caster != MWMechanics::getPlayer())
+            caster.getClass().getCreatureStats(caster).getAiSequence().getCombatTargets(query.mTargets);
+
+        return query;
+    }
+
     ESM::EffectList getMagicBoltData(std::vector<std::string>& projectileIDs, std::set<std::string>& sounds, float& speed, std::string& texture, std::string& sourceName, const std::string& id)
     {
         const MWWorld::ESMStore& esmStore = MWBase::Environment::get().getWorld()->getStore();
@@ -379,144 +395,157 @@ namespace MWWorld
 
     void ProjectileManager::moveMagicBolts(float duration)
     {
-        for (std::vector<MagicBoltState>::iterator it = mMagicBolts.begin(); it != mMagicBolts.end();)
+        static float fTargetSpellMaxSpeed = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
+                    .find("fTargetSpellMaxSpeed")->mValue.getFloat();
+
+        // Move all bolts first, so their sweeps can be cast in one batch
+        std::vector<MWPhysics::PhysicsSystem::RayQuery> queries;
+        queries.reserve(mMagicBolts.size());
+        for (MagicBoltState& state : mMagicBolts)
         {
-            osg::Quat orient = it->mNode->getAttitude();
-            static float fTargetSpellMaxSpeed = MWBase::Environment::get().getWorld()->getStore().get<ESM::GameSetting>()
-                        .find("fTargetSpellMaxSpeed")->mValue.getFloat();
-            float speed = fTargetSpellMaxSpeed * it->mSpeed;
+            osg::Quat orient = state.mNode->getAttitude();
+            float speed = fTargetSpellMaxSpeed * state.mSpeed;
             osg::Vec3f direction = orient * osg::Vec3f(0,1,0);
             direction.normalize();
-            osg::Vec3f pos(it->mNode->getPosition());
+            osg::Vec3f pos(state.mNode->getPosition());
             osg::Vec3f newPos = pos + direction * duration * speed;
 
-            for (size_t soundIter = 0; soundIter != it->mSounds.size(); soundIter++)
+            for (size_t soundIter = 0; soundIter != state.mSounds.size(); soundIter++)
             {
-                it->mSounds.at(soundIter)->setPosition(newPos);
+                state.mSounds.at(soundIter)->setPosition(newPos);
             }
 
-            it->mNode->setPosition(newPos);
+            state.mNode->setPosition(newPos);
 
-            update(*it, duration);
+            update(state, duration);
 
-            MWWorld::Ptr caster = it->getCaster();
+            queries.push_back(getImpactQuery(pos, newPos, state.getCaster()));
+        }
 
-            // For AI actors, get combat targets to use in the ray cast. Only those targets will return a positive hit result.
-            std::vector<MWWorld::Ptr> targetActors;
-            if (!caster.isEmpty() && caster.getClass().isActor() && caster != MWMechanics::getPlayer())
-                caster.getClass().getCreatureStats(caster).getAiSequence().getCombatTargets(targetActors);
+        // Check for impact
+        // TODO: use a proper btRigidBody / btGhostObject?
+        std::vector<MWPhysics::PhysicsSystem::RayResult> results;
+        mPhysics->castRays(queries, results);
 
-            // Check for impact
-            // TODO: use a proper btRigidBody / btGhostObject?
-            MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(pos, newPos, caster, targetActors, 0xff, MWPhysics::CollisionType_Projectile);
+        // Hits may launch new bolts, so they are only removed afterwards and the state is not referenced across calls
+        std::vector<size_t> exploded;
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const osg::Vec3f& pos = queries[i].mFrom;
+            const osg::Vec3f& newPos = queries[i].mTo;
+            const MWPhysics::PhysicsSystem::RayResult& result = results[i];
 
-            bool hit = false;
-            if (result.mHit)
-            {
-                hit = true;
-                if (result.mHitObject.isEmpty())
-                {
-                    // terrain
-                }
-                else
-                {
-                    MWMechanics::CastSpell cast(caster, result.mHitObject);
-                    cast.mHitPosition = pos;
-                    cast.mId = it->mSpellId;
-                    cast.mSourceName = it->mSourceName;
-                    cast.mStack = false;
-                    cast.inflict(result.mHitObject, caster, it->mEffects, ESM::RT_Target, false, true);
-                }
-            }
+            bool hit = result.mHit;
 
             // Explodes when hitting water
-            if (MWBase::Environment::get().getWorld()->isUnderwater(MWMechanics::getPlayer().getCell(), newPos))
+            if (!hit && MWBase::Environment::get().getWorld()->isUnderwater(MWMechanics::getPlayer().getCell(), newPos))
                 hit = true;
 
-            if (hit)
-            {
-                MWBase::Environment::get().getWorld()->explodeSpell(pos, it->mEffects, caster, result.mHitObject,
-                                                                    ESM::RT_Target, it->mSpellId, it->mSourceName);
+            if (!hit)
+                continue;
 
-                MWBase::SoundManager *sndMgr = MWBase::Environment::get().getSoundManager();
-                for (size_t soundIter = 0; soundIter != it->mSounds.size(); soundIter++)
-                    sndMgr->stopSound(it->mSounds.at(soundIter));
+            exploded.push_back(i);
 
-                mParent->removeChild(it->mNode);
+            MagicBoltState& state = mMagicBolts[i];
+            MWWorld::Ptr caster = state.getCaster();
+            const std::string spellId = state.mSpellId;
+            const std::string sourceName = state.mSourceName;
+            const ESM::EffectList effects = state.mEffects;
+            cleanupMagicBolt(state);
 
-                it = mMagicBolts.erase(it);
-                continue;
+            if (result.mHit && !result.mHitObject.isEmpty())
+            {
+                MWMechanics::CastSpell cast(caster, result.mHitObject);
+                cast.mHitPosition = pos;
+                cast.mId = spellId;
+                cast.mSourceName = sourceName;
+                cast.mStack = false;
+                cast.inflict(result.mHitObject, caster, effects, ESM::RT_Target, false, true);
             }
-            else
-                ++it;
+
+            MWBase::Environment::get().getWorld()->explodeSpell(pos, effects, caster, result.mHitObject,
+                                                                ESM::RT_Target, spellId, sourceName);
         }
+
+        for (std::vector<size_t>::const_reverse_iterator it = exploded.rbegin(); it != exploded.rend(); ++it)
+            mMagicBolts.erase(mMagicBolts.begin() + *it);
     }
 
     void ProjectileManager::moveProjectiles(float duration)
     {
-        for (std::vector<ProjectileState>::iterator it = mProjectiles.begin(); it != mProjectiles.end();)
+        // Move all projectiles first, so their sweeps can be cast in one batch
+        std::vector<MWPhysics::PhysicsSystem::RayQuery> queries;
+        queries.reserve(mProjectiles.size());
+        for (ProjectileState& state : mProjectiles)
         {
             // gravity constant - must be way lower than the gravity affecting actors, since we're not
             // simulating aerodynamics at all
-            it->mVelocity -= osg::Vec3f(0, 0, Constants::GravityConst * Constants::UnitsPerMeter * 0.1f) * duration;
+            state.mVelocity -= osg::Vec3f(0, 0, Constants::GravityConst * Constants::UnitsPerMeter * 0.1f) * duration;
 
-            osg::Vec3f pos(it->mNode->getPosition());
-            osg::Vec3f newPos = pos + it->mVelocity * duration;
+            osg::Vec3f pos(state.mNode->getPosition());
+            osg::Vec3f newPos = pos + state.mVelocity * duration;
 
             // rotation does not work well for throwing projectiles - their roll angle will depend on shooting direction.
-            if (!it->mThrown)
+            if (!state.mThrown)
             {
                 osg::Quat orient;
-                orient.makeRotate(osg::Vec3f(0,1,0), it->mVelocity);
-                it->mNode->setAttitude(orient);
+                orient.makeRotate(osg::Vec3f(0,1,0), state.mVelocity);
+                state.mNode->setAttitude(orient);
             }
 
-            it->mNode->setPosition(newPos);
+            state.mNode->setPosition(newPos);
 
-            update(*it, duration);
+            update(state, duration);
 
-            MWWorld::Ptr caster = it->getCaster();
+            queries.push_back(getImpactQuery(pos, newPos, state.getCaster()));
+        }
 
-            // For AI actors, get combat targets to use in the ray cast. Only those targets will return a positive hit result.
-            std::vector<MWWorld::Ptr> targetActors;
-            if (!caster.isEmpty() && caster.getClass().isActor() && caster != MWMechanics::getPlayer())
-                caster.getClass().getCreatureStats(caster).getAiSequence().getCombatTargets(targetActors);
+        // Check for impact
+        // TODO: use a proper btRigidBody / btGhostObject?
+        std::vector<MWPhysics::PhysicsSystem::RayResult> results;
+        mPhysics->castRays(queries, results);
 
-            // Check for impact
-            // TODO: use a proper btRigidBody / btGhostObject?
-            MWPhysics::PhysicsSystem::RayResult result = mPhysics->castRay(pos, newPos, caster, targetActors, 0xff, MWPhysics::CollisionType_Projectile);
+        std::vector<size_t> hits;
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const osg::Vec3f& newPos = queries[i].mTo;
+            const MWPhysics::PhysicsSystem::RayResult& result = results[i];
 
             bool underwater = MWBase::Environment::get().getWorld()->isUnderwater(MWMechanics::getPlayer().getCell(), newPos);
 
-            if (result.mHit || underwater)
-            {
-                MWWorld::ManualRef projectileRef(MWBase::Environment::get().getWorld()->getStore(), it->mIdArrow);
+            if (!result.mHit && !underwater)
+                continue;
 
-                // Try to get a Ptr to the bow that was used. It might no longer exist.
-                MWWorld::Ptr bow = projectileRef.getPtr();
-                if (!caster.isEmpty() && it->mIdArrow != it->mBowId)
-                {
-                    MWWorld::InventoryStore& inv = caster.getClass().getInventoryStore(caster);
-                    MWWorld::ContainerStoreIterator invIt = inv.getSlot(MWWorld::InventoryStore::Slot_CarriedRight);
-                    if (invIt != inv.end() && Misc::StringUtils::ciEqual(invIt->getCellRef().getRefId(), it->mBowId))
-                        bow = *invIt;
-                }
+            hits.push_back(i);
 
-                if (caster.isEmpty())
-                    caster = result.mHitObject;
+            ProjectileState& state = mProjectiles[i];
+            MWWorld::Ptr caster = state.getCaster();
+            MWWorld::ManualRef projectileRef(MWBase::Environment::get().getWorld()->getStore(), state.mIdArrow);
+
+            // Try to get a Ptr to the bow that was used. It might no longer exist.
+            MWWorld::Ptr bow = projectileRef.getPtr();
+            if (!caster.isEmpty() && state.mIdArrow != state.mBowId)
+            {
+                MWWorld::InventoryStore& inv = caster.getClass().getInventoryStore(caster);
+                MWWorld::ContainerStoreIterator invIt = inv.getSlot(MWWorld::InventoryStore::Slot_CarriedRight);
+                if (invIt != inv.end() && Misc::StringUtils::ciEqual(invIt->getCellRef().getRefId(), state.mBowId))
+                    bow = *invIt;
+            }
 
-                MWMechanics::projectileHit(caster, result.mHitObject, bow, projectileRef.getPtr(), result.mHit ? result.mHitPos : newPos, it->mAttackStrength);
+            const float attackStrength = state.mAttackStrength;
+            cleanupProjectile(state);
 
-                if (underwater)
-                    mRendering->emitWaterRipple(newPos);
+            if (caster.isEmpty())
+                caster = result.mHitObject;
 
-                mParent->removeChild(it->mNode);
-                it = mProjectiles.erase(it);
-                continue;
-            }
+            MWMechanics::projectileHit(caster, result.mHitObject, bow, projectileRef.getPtr(), result.mHit ? result.mHitPos : newPos, attackStrength);
 
-            ++it;
+            if (underwater)
+                mRendering->emitWaterRipple(newPos);
         }
+
+        for (std::vector<size_t>::const_reverse_iterator it = hits.rbegin(); it != hits.rend(); ++it)
+            mProjectiles.erase(mProjectiles.begin() + *it);
     }
 
     void ProjectileManager::cleanupProjectile(ProjectileManager::ProjectileState& state)
@@ -24,7 +24,7 @@ namespace MWWorld
     void RefData::copy (const RefData& refData)
     {
         mBaseNode = refData.mBaseNode;
-        mLocals = refData.mLocals;
+        mExtraData.reset(refData.mExtraData ? new ExtraData(*refData.mExtraData) : nullptr);
         mEnabled = refData.mEnabled;
         mCount = refData.mCount;
         mPosition = refData.mPosition;
@@ -32,8 +32,6 @@ namespace MWWorld
         mDeletedByContentFile = refData.mDeletedByContentFile;
         mFlags = refData.mFlags;
 
-        mAnimationState = refData.mAnimationState;
-
         mCustomData = refData.mCustomData ? refData.mCustomData->clone() : 0;
     }
 
@@ -46,7 +44,7 @@ namespace MWWorld
     }
 
     RefData::RefData()
-    : mBaseNode(0), mDeletedByContentFile(false), mEnabled (true), mCount (1), mCustomData (0), mChanged(false), mFlags(0)
+    : mBaseNode(0), mCustomData (0), mCount (1), mFlags(0), mDeletedByContentFile(false), mEnabled (true), mChanged(false)
     {
         for (int i=0; i<3; ++i)
         {
@@ -56,22 +54,24 @@ namespace MWWorld
     }
 
     RefData::RefData (const ESM::CellRef& cellRef)
-    : mBaseNode(0), mDeletedByContentFile(false), mEnabled (true),
-      mCount (1), mPosition (cellRef.mPos),
-      mCustomData (0),
-      mChanged(false), mFlags(0) // Loading from ESM/ESP files -> assume unchanged
+    : mBaseNode(0), mCustomData (0), mPosition (cellRef.mPos), mCount (1), mFlags(0),
+      mDeletedByContentFile(false), mEnabled (true),
+      mChanged(false) // Loading from ESM/ESP files -> assume unchanged
     {
     }
 
     RefData::RefData (const ESM::ObjectState& objectState, bool deletedByContentFile)
-    : mBaseNode(0), mDeletedByContentFile(deletedByContentFile),
-      mEnabled (objectState.mEnabled != 0),
-      mCount (objectState.mCount),
+    : mBaseNode(0), mCustomData (0),
       mPosition (objectState.mPosition),
-      mAnimationState(objectState.mAnimationState),
-      mCustomData (0),
-      mChanged(true), mFlags(objectState.mFlags) // Loading from a savegame -> assume changed
+      mCount (objectState.mCount),
+      mFlags(objectState.mFlags),
+      mDeletedByContentFile(deletedByContentFile),
+      mEnabled (objectState.mEnabled != 0),
+      mChanged(true) // Loading from a savegame -> assume changed
     {
+        if (!objectState.mAnimationState.empty())
+            getExtraData().mAnimationState = objectState.mAnimationState;
+
         // "Note that the ActivationFlag_UseEnabled is saved to the reference,
         // which will result in permanently suppressed activation if the reference script is removed.
         // This occurred when removing the animated containers mod, and the fix in MCP is to reset UseEnabled to true on loading a game."
@@ -95,14 +95,15 @@ namespace MWWorld
 
     void RefData::write (ESM::ObjectState& objectState, const std::string& scriptId) const
     {
-        objectState.mHasLocals = mLocals.write (objectState.mLocals, scriptId);
+        objectState.mHasLocals = mExtraData && mExtraData->mLocals.write (objectState.mLocals, scriptId);
 
         objectState.mEnabled = mEnabled;
         objectState.mCount = mCount;
         objectState.mPosition = mPosition;
         objectState.mFlags = mFlags;
 
-        objectState.mAnimationState = mAnimationState;
+        if (mExtraData)
+            objectState.mAnimationState = mExtraData->mAnimationState;
     }
 
     RefData& RefData::operator= (const RefData& refData)
@@ -153,7 +154,8 @@ namespace MWWorld
 
     void RefData::setLocals (const ESM::Script& script)
     {
-        if (mLocals.configure (script) && !mLocals.isEmpty())
+        MWScript::Locals& locals = getLocals();
+        if (locals.configure (script) && !locals.isEmpty())
             mChanged = true;
     }
 
@@ -184,7 +186,7 @@ namespace MWWorld
 
     MWScript::Locals& RefData::getLocals()
     {
-        return mLocals;
+        return getExtraData().mLocals;
     }
 
     bool RefData::isEnabled() const
@@ -240,7 +242,7 @@ namespace MWWorld
 
     bool RefData::hasChanged() const
     {
-        return mChanged || !mAnimationState.empty();
+        return mChanged || (mExtraData && !mExtraData->mAnimationState.empty());
     }
 
     bool RefData::activateByScript()
@@ -273,12 +275,20 @@ namespace MWWorld
 
     const ESM::AnimationState& RefData::getAnimationState() const
     {
-        return mAnimationState;
+        static const ESM::AnimationState empty;
+        return mExtraData ? mExtraData->mAnimationState : empty;
     }
 
     ESM::AnimationState& RefData::getAnimationState()
     {
-        return mAnimationState;
+        return getExtraData().mAnimationState;
+    }
+
+    RefData::ExtraData& RefData::getExtraData()
+    {
+        if (!mExtraData)
+            mExtraData.reset(new ExtraData);
+        return *mExtraData;
     }
 
 }
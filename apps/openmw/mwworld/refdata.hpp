@@ -6,6 +6,7 @@
 
 #include "../mwscript/locals.hpp"
 
+#include <memory>
 #include <string>
 
 namespace SceneUtil
@@ -27,32 +28,40 @@ namespace MWWorld
 
     class RefData
     {
+            /// Data that most references don't use, allocated on demand to keep RefData small
+            struct ExtraData
+            {
+                MWScript::Locals mLocals;
+
+                ESM::AnimationState mAnimationState;
+            };
+
             SceneUtil::PositionAttitudeTransform* mBaseNode;
 
-            MWScript::Locals mLocals;
+            std::unique_ptr<ExtraData> mExtraData;
 
-            /// separate delete flag used for deletion by a content file
-            /// @note not stored in the save game file.
-            bool mDeletedByContentFile;
+            CustomData *mCustomData;
 
-            bool mEnabled;
+            ESM::Position mPosition;
 
             /// 0: deleted
             int mCount;
 
-            ESM::Position mPosition;
+            unsigned int mFlags;
 
-            ESM::AnimationState mAnimationState;
+            /// separate delete flag used for deletion by a content file
+            /// @note not stored in the save game file.
+            bool mDeletedByContentFile;
 
-            CustomData *mCustomData;
+            bool mEnabled;
+
+            bool mChanged;
 
             void copy (const RefData& refData);
 
             void cleanup();
 
-            bool mChanged;
-
-            unsigned int mFlags;
+            ExtraData& getExtraData();
 
         public:
 
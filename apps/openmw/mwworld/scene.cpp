@@ -1,11 +1,14 @@
 #include "scene.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <limits>
 
 #include <BulletCollision/CollisionDispatch/btCollisionObject.h>
 #include <BulletCollision/CollisionShapes/btCompoundShape.h>
 
 #include <components/debug/debuglog.hpp>
+#include <components/debug/trace.hpp>
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/resourcehelpers.hpp>
 #include <components/settings/settings.hpp>
@@ -24,6 +27,7 @@
 
 #include "../mwrender/renderingmanager.hpp"
 #include "../mwrender/landmanager.hpp"
+#include "../mwrender/objects.hpp"
 
 #include "../mwphysics/physicssystem.hpp"
 #include "../mwphysics/actor.hpp"
@@ -201,6 +205,14 @@ namespace
         }
     }
 
+    void clampScale(const MWWorld::Ptr& ptr)
+    {
+        if (ptr.getCellRef().getScale()<0.5)
+            ptr.getCellRef().setScale(0.5);
+        else if (ptr.getCellRef().getScale()>2)
+            ptr.getCellRef().setScale(2);
+    }
+
     struct InsertVisitor
     {
         MWWorld::CellStore& mCell;
@@ -235,12 +247,7 @@ namespace
         for (MWWorld::Ptr& ptr : mToInsert)
         {
             if (mRescale)
-            {
-                if (ptr.getCellRef().getScale()<0.5)
-                    ptr.getCellRef().setScale(0.5);
-                else if (ptr.getCellRef().getScale()>2)
-                    ptr.getCellRef().setScale(2);
-            }
+                clampScale(ptr);
 
             if (!ptr.getRefData().isDeleted() && ptr.getRefData().isEnabled())
             {
@@ -321,6 +328,8 @@ namespace MWWorld
             mPreloadTimer = 0.f;
         }
 
+        insertPendingObjects(mInsertionBudget);
+
         mRendering.update (duration, paused);
 
         mPreloader->updateCache(mRendering.getReferenceTime());
@@ -328,8 +337,16 @@ namespace MWWorld
 
     void Scene::unloadCell (CellStoreCollection::iterator iter)
     {
+        const Debug::TraceZone zone("Unload cell");
         Log(Debug::Info) << "Unloading cell " << (*iter)->getCell()->getDescription();
 
+        if (mPendingObjectCounts.erase(*iter))
+        {
+            CellStore* cell = *iter;
+            mPendingObjects.erase(std::remove_if(mPendingObjects.begin(), mPendingObjects.end(),
+                [cell] (const PendingObject& object) { return object.mCell == cell; }), mPendingObjects.end());
+        }
+
         const auto navigator = MWBase::Environment::get().getWorld()->getNavigator();
         ListAndResetObjectsVisitor visitor;
 
@@ -368,9 +385,6 @@ namespace MWWorld
         if ((*iter)->getCell()->hasWater())
             navigator->removeWater(osg::Vec2i(cellX, cellY));
 
-        const auto player = world->getPlayerPtr();
-        navigator->update(player.getRefData().getPosition().asVec3());
-
         MWBase::Environment::get().getMechanicsManager()->drop (*iter);
 
         mRendering.removeCell(*iter);
@@ -380,14 +394,17 @@ namespace MWWorld
 
         MWBase::Environment::get().getSoundManager()->stopSound (*iter);
         mActiveCells.erase(*iter);
+        ++mActiveCellsGeneration;
     }
 
     void Scene::loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn)
     {
+        const Debug::TraceZone zone("Load cell");
         std::pair<CellStoreCollection::iterator, bool> result = mActiveCells.insert(cell);
 
         if(result.second)
         {
+            ++mActiveCellsGeneration;
             Log(Debug::Info) << "Loading cell " << cell->getCell()->getDescription();
 
             float verts = ESM::Land::LAND_SIZE;
@@ -455,9 +472,6 @@ namespace MWWorld
             else
                 mPhysics->disableWater();
 
-            const auto player = MWBase::Environment::get().getWorld()->getPlayerPtr();
-            navigator->update(player.getRefData().getPosition().asVec3());
-
             if (!cell->isExterior() && !(cell->getCell()->mData.mFlags & ESM::Cell::QuasiEx))
                 mRendering.configureAmbient(cell->getCell());
         }
@@ -472,6 +486,9 @@ namespace MWWorld
             unloadCell (active++);
         assert(mActiveCells.empty());
         mCurrentCell = nullptr;
+        updateNavigator();
+        mRendering.getObjects().clearUnloadedCells();
+        mTeleportCounts.clear();
 
         mPreloader->clear();
     }
@@ -496,12 +513,15 @@ namespace MWWorld
         {
             int newX, newY;
             MWBase::Environment::get().getWorld()->positionToIndex(pos.x(), pos.y(), newX, newY);
+            mDeferInsertion = mInsertionBudget > 0.f;
             changeCellGrid(newX, newY);
+            mDeferInsertion = false;
         }
     }
 
     void Scene::changeCellGrid (int playerCellX, int playerCellY, bool changeEvent)
     {
+        const Debug::TraceZone zone("Change cell grid");
         Loading::Listener* loadingListener = MWBase::Environment::get().getWindowManager()->getLoadingScreen();
         Loading::ScopedLoad load(loadingListener);
 
@@ -525,6 +545,10 @@ namespace MWWorld
             unloadCell (active++);
         }
 
+        // A teleport within the grid needs the kept cells to be complete
+        if (!mDeferInsertion)
+            insertPendingObjects(0.f);
+
         std::size_t refsToLoad = 0;
         std::vector<std::pair<int, int>> cellsPositionsToLoad;
         // get the number of refs to load
@@ -597,6 +621,20 @@ namespace MWWorld
             }
         }
 
+        if (mDeferInsertion)
+        {
+            const osg::Vec3f playerPos = MWBase::Environment::get().getWorld()->getPlayerPtr().getRefData().getPosition().asVec3();
+            std::sort(mPendingObjects.begin(), mPendingObjects.end(),
+                [&] (const PendingObject& lhs, const PendingObject& rhs)
+                {
+                    return (lhs.mPtr.getRefData().getPosition().asVec3() - playerPos).length2()
+                        > (rhs.mPtr.getRefData().getPosition().asVec3() - playerPos).length2();
+                });
+        }
+
+        // One navmesh update for all changed cells, tiles at the borders between them are built once
+        updateNavigator();
+
         CellStore* current = MWBase::Environment::get().getWorld()->getExterior(playerCellX, playerCellY);
         MWBase::Environment::get().getWindowManager()->changeCell(current);
 
@@ -638,12 +676,16 @@ namespace MWWorld
 
         MWBase::Environment::get().getWorld()->adjustSky();
 
-        mLastPlayerPos = pos.asVec3();
+        // Teleporting doesn't count as movement for the prediction
+        mPlayerPositions.clear();
+        mPlayerPositions.emplace_back(mPreloadTime, pos.asVec3());
+        if (cell != old.getCell())
+            ++mTeleportCounts[cell];
     }
 
     Scene::Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics,
                   DetourNavigator::Navigator& navigator)
-    : mCurrentCell (0), mCellChanged (false), mPhysics(physics), mRendering(rendering), mNavigator(navigator)
+    : mCurrentCell (0), mActiveCellsGeneration (0), mCellChanged (false), mPhysics(physics), mRendering(rendering), mNavigator(navigator)
     , mPreloadTimer(0.f)
     , mHalfGridSize(Settings::Manager::getInt("exterior cell load distance", "Cells"))
     , mCellLoadingThreshold(1024.f)
@@ -653,6 +695,10 @@ namespace MWWorld
     , mPreloadDoors(Settings::Manager::getBool("preload doors", "Cells"))
     , mPreloadFastTravel(Settings::Manager::getBool("preload fast travel", "Cells"))
     , mPredictionTime(Settings::Manager::getFloat("prediction time", "Cells"))
+    , mPredictionHistory(std::max(0.f, Settings::Manager::getFloat("prediction history", "Cells")))
+    , mPreloadTime(0.0)
+    , mInsertionBudget(std::max(0.f, Settings::Manager::getFloat("object insertion budget", "Cells")) / 1000.f)
+    , mDeferInsertion(false)
     {
         mPreloader.reset(new CellPreloader(rendering.getResourceSystem(), physics->getShapeManager(), rendering.getTerrain(), rendering.getLandManager()));
         mPreloader->setWorkQueue(mRendering.getWorkQueue());
@@ -661,6 +707,8 @@ namespace MWWorld
         mPhysics->setUnrefQueue(rendering.getUnrefQueue());
 
         rendering.getResourceSystem()->setExpiryDelay(Settings::Manager::getFloat("cache expiry delay", "Cells"));
+        rendering.getResourceSystem()->setMemoryBudget(static_cast<std::size_t>(
+            std::max(0, Settings::Manager::getInt("cache memory budget", "Cells"))) * 1024 * 1024);
 
         mPreloader->setExpiryDelay(Settings::Manager::getFloat("preload cell expiry delay", "Cells"));
         mPreloader->setMinCacheSize(Settings::Manager::getInt("preload cell cache min", "Cells"));
@@ -682,8 +730,14 @@ namespace MWWorld
         return mActiveCells;
     }
 
+    unsigned int Scene::getActiveCellsGeneration() const
+    {
+        return mActiveCellsGeneration;
+    }
+
     void Scene::changeToInteriorCell (const std::string& cellName, const ESM::Position& position, bool adjustPlayerPos, bool changeEvent)
     {
+        const Debug::TraceZone zone("Change to interior cell");
         CellStore *cell = MWBase::Environment::get().getWorld()->getInterior(cellName);
         bool useFading = (mCurrentCell != nullptr);
         if (useFading)
@@ -722,6 +776,7 @@ namespace MWWorld
 
         // Load cell.
         loadCell (cell, loadingListener, changeEvent);
+        updateNavigator();
 
         changePlayerCell(cell, position, adjustPlayerPos);
 
@@ -773,6 +828,19 @@ namespace MWWorld
     {
         InsertVisitor insertVisitor (cell, rescale, *loadingListener);
         cell.forEach (insertVisitor);
+
+        if (mDeferInsertion && !insertVisitor.mToInsert.empty())
+        {
+            for (const MWWorld::Ptr& ptr : insertVisitor.mToInsert)
+            {
+                if (rescale)
+                    clampScale(ptr);
+                mPendingObjects.push_back(PendingObject {&cell, ptr});
+            }
+            mPendingObjectCounts[&cell] += insertVisitor.mToInsert.size();
+            return;
+        }
+
         insertVisitor.insert([&] (const MWWorld::Ptr& ptr) { addObject(ptr, *mPhysics, mRendering); });
         insertVisitor.insert([&] (const MWWorld::Ptr& ptr) { addObject(ptr, *mPhysics, mNavigator); });
 
@@ -781,6 +849,77 @@ namespace MWWorld
         cell.forEach (adjustPosVisitor);
     }
 
+    void Scene::insertPendingObjects(float budget)
+    {
+        if (mPendingObjects.empty())
+            return;
+
+        const auto start = std::chrono::steady_clock::now();
+        while (!mPendingObjects.empty())
+        {
+            const PendingObject object = mPendingObjects.back();
+            mPendingObjects.pop_back();
+            insertDeferredObject(object);
+
+            if (budget > 0.f && std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() >= budget)
+                break;
+        }
+
+        updateNavigator();
+    }
+
+    void Scene::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        mPreloader->reportStats(frameNumber, stats);
+    }
+
+    void Scene::updateNavigator()
+    {
+        const auto player = MWBase::Environment::get().getWorld()->getPlayerPtr();
+        mNavigator.update(player.getRefData().getPosition().asVec3());
+    }
+
+    void Scene::insertDeferredObject(const PendingObject& object)
+    {
+        const Ptr& ptr = object.mPtr;
+        // Enabling the object while it was pending added it already
+        if (!ptr.getRefData().getBaseNode() && !ptr.getRefData().isDeleted() && ptr.getRefData().isEnabled())
+        {
+            try
+            {
+                addObject(ptr, *mPhysics, mRendering);
+                addObject(ptr, *mPhysics, mNavigator);
+            }
+            catch (const std::exception& e)
+            {
+                Log(Debug::Error) << "failed to render '" << ptr.getCellRef().getRefId() << "': " << e.what();
+            }
+        }
+
+        const auto count = mPendingObjectCounts.find(object.mCell);
+        if (count != mPendingObjectCounts.end() && --count->second == 0)
+        {
+            mPendingObjectCounts.erase(count);
+            AdjustPositionVisitor adjustPosVisitor;
+            object.mCell->forEach (adjustPosVisitor);
+        }
+    }
+
+    void Scene::insertPendingObject (const Ptr& ptr)
+    {
+        if (mPendingObjectCounts.find(ptr.getCell()) == mPendingObjectCounts.end())
+            return;
+
+        const auto found = std::find_if(mPendingObjects.begin(), mPendingObjects.end(),
+            [&] (const PendingObject& object) { return object.mPtr == ptr; });
+        if (found == mPendingObjects.end())
+            return;
+
+        const PendingObject object = *found;
+        mPendingObjects.erase(found);
+        insertDeferredObject(object);
+    }
+
     void Scene::addObjectToScene (const Ptr& ptr)
     {
         try
@@ -876,18 +1015,26 @@ namespace MWWorld
 
     void Scene::preloadCells(float dt)
     {
+        const Debug::TraceZone zone("Preload cells");
         std::vector<osg::Vec3f> exteriorPositions;
 
         const MWWorld::ConstPtr player = MWBase::Environment::get().getWorld()->getPlayerPtr();
         osg::Vec3f playerPos = player.getRefData().getPosition().asVec3();
-        osg::Vec3f moved = playerPos - mLastPlayerPos;
-        osg::Vec3f predictedPos = playerPos + moved / dt * mPredictionTime;
+
+        // Average the velocity over the history, so short turns and stops don't move the prediction back and forth
+        mPreloadTime += dt;
+        mPlayerPositions.emplace_back(mPreloadTime, playerPos);
+        while (mPlayerPositions.size() > 2 && mPreloadTime - mPlayerPositions[1].first >= mPredictionHistory)
+            mPlayerPositions.pop_front();
+
+        osg::Vec3f predictedPos = playerPos;
+        const double duration = mPreloadTime - mPlayerPositions.front().first;
+        if (duration > 0.0)
+            predictedPos += (playerPos - mPlayerPositions.front().second) / duration * mPredictionTime;
 
         if (mCurrentCell->isExterior())
             exteriorPositions.push_back(predictedPos);
 
-        mLastPlayerPos = playerPos;
-
         if (mPreloadEnabled)
         {
             if (mPreloadDoors)
@@ -920,21 +1067,33 @@ namespace MWWorld
 
         for (const MWWorld::ConstPtr& door : teleportDoors)
         {
-            float sqrDistToPlayer = (playerPos - door.getRefData().getPosition().asVec3()).length2();
-            sqrDistToPlayer = std::min(sqrDistToPlayer, (predictedPos - door.getRefData().getPosition().asVec3()).length2());
+            const osg::Vec3f doorPos = door.getRefData().getPosition().asVec3();
+            float sqrDistToPlayer = (playerPos - doorPos).length2();
+            sqrDistToPlayer = std::min(sqrDistToPlayer, (predictedPos - doorPos).length2());
 
             if (sqrDistToPlayer < mPreloadDistance*mPreloadDistance)
             {
+                const float timeToReach = getTimeToReach(playerPos, predictedPos, doorPos);
+                // Destinations the player teleported to before are likely to be visited again
+                const auto getPriority = [&] (const CellStore* cell)
+                {
+                    const auto found = mTeleportCounts.find(cell);
+                    return found == mTeleportCounts.end() ? timeToReach : timeToReach / (1 + found->second);
+                };
                 try
                 {
                     if (!door.getCellRef().getDestCell().empty())
-                        preloadCell(MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell()));
+                    {
+                        CellStore* cell = MWBase::Environment::get().getWorld()->getInterior(door.getCellRef().getDestCell());
+                        preloadCell(cell, false, getPriority(cell));
+                    }
                     else
                     {
                         osg::Vec3f pos = door.getCellRef().getDoorDest().asVec3();
                         int x,y;
                         MWBase::Environment::get().getWorld()->positionToIndex (pos.x(), pos.y(), x, y);
-                        preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                        CellStore* cell = MWBase::Environment::get().getWorld()->getExterior(x,y);
+                        preloadCell(cell, true, getPriority(cell));
                         exteriorPositions.push_back(pos);
                     }
                 }
@@ -975,12 +1134,33 @@ namespace MWWorld
                 float loadDist = Constants::CellSizeInUnits / 2 + Constants::CellSizeInUnits - mCellLoadingThreshold + mPreloadDistance;
 
                 if (dist < loadDist)
-                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy));
+                {
+                    const osg::Vec3f cellCenter(thisCellCenterX, thisCellCenterY, playerPos.z());
+                    preloadCell(MWBase::Environment::get().getWorld()->getExterior(cellX+dx, cellY+dy), false,
+                                getTimeToReach(playerPos, predictedPos, cellCenter));
+                }
             }
         }
     }
 
-    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding)
+    float Scene::getTimeToReach(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, const osg::Vec3f& pos) const
+    {
+        osg::Vec3f direction = pos - playerPos;
+        direction.z() = 0.f;
+        const float distance = direction.normalize();
+        if (distance == 0.f)
+            return 0.f;
+
+        osg::Vec3f velocity;
+        if (mPredictionTime > 0.f)
+            velocity = (predictedPos - playerPos) / mPredictionTime;
+
+        // Positions the player doesn't move towards are ranked by distance, as if walking there
+        const float walkingSpeed = 100.f;
+        return distance / (walkingSpeed + std::max(0.f, velocity * direction));
+    }
+
+    void Scene::preloadCell(CellStore *cell, bool preloadSurrounding, float priority)
     {
         if (preloadSurrounding && cell->isExterior())
         {
@@ -991,14 +1171,14 @@ namespace MWWorld
             {
                 for (int dy = -mHalfGridSize; dy <= mHalfGridSize; ++dy)
                 {
-                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime());
+                    mPreloader->preload(MWBase::Environment::get().getWorld()->getExterior(x+dx, y+dy), mRendering.getReferenceTime(), priority);
                     if (++numpreloaded >= mPreloader->getMaxCacheSize())
                         break;
                 }
             }
         }
         else
-            mPreloader->preload(cell, mRendering.getReferenceTime());
+            mPreloader->preload(cell, mRendering.getReferenceTime(), priority);
     }
 
     void Scene::preloadTerrain(const osg::Vec3f &pos)
@@ -1049,16 +1229,19 @@ namespace MWWorld
             cellStore->forEachType<ESM::Creature>(listVisitor);
         }
 
+        // talking to the travel service takes a while
+        const float priority = mPredictionTime + 1.f;
+
         for (ESM::Transport::Dest& dest : listVisitor.mList)
         {
             if (!dest.mCellName.empty())
-                preloadCell(MWBase::Environment::get().getWorld()->getInterior(dest.mCellName));
+                preloadCell(MWBase::Environment::get().getWorld()->getInterior(dest.mCellName), false, priority);
             else
             {
                 osg::Vec3f pos = dest.mPos.asVec3();
                 int x,y;
                 MWBase::Environment::get().getWorld()->positionToIndex( pos.x(), pos.y(), x, y);
-                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true);
+                preloadCell(MWBase::Environment::get().getWorld()->getExterior(x,y), true, priority);
                 exteriorPositions.push_back(pos);
             }
         }
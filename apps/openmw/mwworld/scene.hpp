@@ -4,12 +4,16 @@
 #include "ptr.hpp"
 #include "globals.hpp"
 
+#include <deque>
+#include <map>
 #include <set>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace osg
 {
+    class Stats;
     class Vec3f;
 }
 
@@ -67,6 +71,7 @@ namespace MWWorld
 
             CellStore* mCurrentCell; // the cell the player is in
             CellStoreCollection mActiveCells;
+            unsigned int mActiveCellsGeneration;
             bool mCellChanged;
             MWPhysics::PhysicsSystem *mPhysics;
             MWRender::RenderingManager& mRendering;
@@ -82,11 +87,38 @@ namespace MWWorld
             bool mPreloadDoors;
             bool mPreloadFastTravel;
             float mPredictionTime;
-
-            osg::Vec3f mLastPlayerPos;
+            float mPredictionHistory;
+
+            // Player positions of the last mPredictionHistory seconds with their time, the oldest first
+            std::deque<std::pair<double, osg::Vec3f>> mPlayerPositions;
+            double mPreloadTime;
+            // How often the player arrived in a cell by teleporting, frequent destinations are preloaded first
+            std::map<const CellStore*, unsigned int> mTeleportCounts;
+
+            struct PendingObject
+            {
+                CellStore* mCell;
+                Ptr mPtr;
+            };
+
+            // Objects of active cells that are not inserted into the scene yet, the nearest to the player last
+            std::vector<PendingObject> mPendingObjects;
+            // Number of pending objects by cell, the cell's positions are adjusted when the last one is inserted
+            std::map<CellStore*, std::size_t> mPendingObjectCounts;
+            // Seconds per frame for inserting pending objects, 0 inserts the objects of new cells at once
+            float mInsertionBudget;
+            bool mDeferInsertion;
 
             void insertCell (CellStore &cell, bool rescale, Loading::Listener* loadingListener);
 
+            /// Insert pending objects, the nearest first, until \a budget seconds have passed. 0 inserts all.
+            void insertPendingObjects(float budget);
+
+            void insertDeferredObject(const PendingObject& object);
+
+            /// Post the navmesh tiles changed by loading and unloading cells.
+            void updateNavigator();
+
             // Load and unload cells as necessary to create a cell grid with "X" and "Y" in the center
             void changeCellGrid (int playerCellX, int playerCellY, bool changeEvent = true);
 
@@ -97,6 +129,9 @@ namespace MWWorld
             void preloadExteriorGrid(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos);
             void preloadFastTravelDestinations(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, std::vector<osg::Vec3f>& exteriorPositions);
 
+            /// Estimated time in seconds until the player reaches pos, based on the current movement. Used as preload priority.
+            float getTimeToReach(const osg::Vec3f& playerPos, const osg::Vec3f& predictedPos, const osg::Vec3f& pos) const;
+
         public:
 
             Scene (MWRender::RenderingManager& rendering, MWPhysics::PhysicsSystem *physics,
@@ -104,21 +139,29 @@ namespace MWWorld
 
             ~Scene();
 
-            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false);
+            /// @param priority Estimated time in seconds until the cell is needed, see CellPreloader::preload
+            void preloadCell(MWWorld::CellStore* cell, bool preloadSurrounding=false, float priority=0.f);
             void preloadTerrain(const osg::Vec3f& pos);
 
             void unloadCell (CellStoreCollection::iterator iter);
+            ///< @note Doesn't update the navigator, so that changes of several cells are posted together.
 
             void loadCell (CellStore *cell, Loading::Listener* loadingListener, bool respawn);
+            ///< @note Doesn't update the navigator, see unloadCell.
 
             void playerMoved (const osg::Vec3f& pos);
 
+            void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
+
             void changePlayerCell (CellStore* newCell, const ESM::Position& position, bool adjustPlayerPos);
 
             CellStore *getCurrentCell();
 
             const CellStoreCollection& getActiveCells () const;
 
+            unsigned int getActiveCellsGeneration() const;
+            ///< Changes whenever a cell is added to or removed from the active cells.
+
             bool hasCellChanged() const;
             ///< Has the set of active cells changed, since the last frame?
 
@@ -143,6 +186,9 @@ namespace MWWorld
             void removeObjectFromScene (const Ptr& ptr);
             ///< Remove an object from the scene, but not from the world model.
 
+            void insertPendingObject (const Ptr& ptr);
+            ///< Insert the object now if its insertion was deferred, e.g. before it is moved to another cell.
+
             void updateObjectRotation(const Ptr& ptr, RotationOrder order);
             void updateObjectScale(const Ptr& ptr);
 
@@ -8,6 +8,7 @@
 #include <components/loadinglistener/loadinglistener.hpp>
 #include <components/misc/rng.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace
@@ -30,6 +31,13 @@ namespace
         }
     };
 
+    template<typename T>
+    struct LoadedRecord : MWWorld::StoreBase::ParsedRecord
+    {
+        T mRecord;
+        bool mIsDeleted = false;
+    };
+
     struct Compare
     {
         bool operator()(const ESM::Land *x, const ESM::Land *y) {
@@ -136,14 +144,12 @@ namespace MWWorld
     template<typename T>
     const T *Store<T>::search(const std::string &id) const
     {
-        std::string idLower = Misc::StringUtils::lowerCase(id);
-
-        typename Dynamic::const_iterator dit = mDynamic.find(idLower);
+        typename Dynamic::const_iterator dit = mDynamic.find(id);
         if (dit != mDynamic.end()) {
             return &dit->second;
         }
 
-        typename std::map<std::string, T>::const_iterator it = mStatic.find(idLower);
+        typename Static::const_iterator it = mStatic.find(id);
 
         if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
             return &(it->second);
@@ -191,19 +197,50 @@ namespace MWWorld
     template<typename T>
     RecordId Store<T>::load(ESM::ESMReader &esm)
     {
-        T record;
-        bool isDeleted = false;
+        return apply(*parse(esm));
+    }
+    template<typename T>
+    std::unique_ptr<StoreBase::ParsedRecord> Store<T>::parse(ESM::ESMReader &esm) const
+    {
+        std::unique_ptr<LoadedRecord<T> > parsed(new LoadedRecord<T>);
 
-        record.load(esm, isDeleted);
-        Misc::StringUtils::lowerCaseInPlace(record.mId);
+        parsed->mRecord.load(esm, parsed->mIsDeleted);
+        Misc::StringUtils::lowerCaseInPlace(parsed->mRecord.mId);
 
-        std::pair<typename Static::iterator, bool> inserted = mStatic.insert(std::make_pair(record.mId, record));
-        if (inserted.second)
-            mShared.push_back(&inserted.first->second);
+        return std::move(parsed);
+    }
+    template<typename T>
+    RecordId Store<T>::apply(StoreBase::ParsedRecord &record)
+    {
+        LoadedRecord<T> &parsed = static_cast<LoadedRecord<T>&>(record);
+        const std::string id = parsed.mRecord.mId;
+
+        typename Static::iterator found = mStatic.find(id);
+        if (found == mStatic.end())
+        {
+            found = mStatic.insert(std::make_pair(id, std::move(parsed.mRecord))).first;
+            mShared.push_back(&found->second);
+        }
         else
-            inserted.first->second = record;
+            found->second = std::move(parsed.mRecord);
 
-        return RecordId(record.mId, isDeleted);
+        return RecordId(id, parsed.mIsDeleted);
+    }
+    template<typename T>
+    bool Store<T>::canParseAhead() const
+    {
+        return true;
+    }
+    template<typename T>
+    void Store<T>::writeStatic(ESM::ESMWriter& writer) const
+    {
+        // The static records come first in mShared
+        for (size_t i = 0; i < mStatic.size() && i < mShared.size(); ++i)
+        {
+            writer.startRecord (T::sRecordId);
+            mShared[i]->save (writer);
+            writer.endRecord (T::sRecordId);
+        }
     }
     template<typename T>
     void Store<T>::setUp()
@@ -274,7 +311,7 @@ namespace MWWorld
     {
         std::string idLower = Misc::StringUtils::lowerCase(id);
 
-        typename std::map<std::string, T>::iterator it = mStatic.find(idLower);
+        typename Static::iterator it = mStatic.find(idLower);
 
         if (it != mStatic.end() && Misc::StringUtils::ciEqual(it->second.mId, id)) {
             // delete from the static part of mShared
@@ -297,19 +334,19 @@ namespace MWWorld
     template<typename T>
     bool Store<T>::erase(const std::string &id)
     {
-        std::string key = Misc::StringUtils::lowerCase(id);
-        typename Dynamic::iterator it = mDynamic.find(key);
+        typename Dynamic::iterator it = mDynamic.find(id);
         if (it == mDynamic.end()) {
             return false;
         }
-        mDynamic.erase(it);
 
-        // have to reinit the whole shared part
+        // remove it from the dynamic part of mShared
         assert(mShared.size() >= mStatic.size());
-        mShared.erase(mShared.begin() + mStatic.size(), mShared.end());
-        for (it = mDynamic.begin(); it != mDynamic.end(); ++it) {
-            mShared.push_back(&it->second);
-        }
+        typename std::vector<T *>::iterator sharedIter =
+            std::find(mShared.begin() + mStatic.size(), mShared.end(), &it->second);
+        if (sharedIter != mShared.end())
+            mShared.erase(sharedIter);
+
+        mDynamic.erase(it);
         return true;
     }
     template<typename T>
@@ -320,11 +357,19 @@ namespace MWWorld
     template<typename T>
     void Store<T>::write (ESM::ESMWriter& writer, Loading::Listener& progress) const
     {
+        // Write in the order of the IDs, like the ordered map used before, so saves don't depend on the hashing
+        std::vector<const typename Dynamic::value_type*> records;
+        records.reserve(mDynamic.size());
         for (typename Dynamic::const_iterator iter (mDynamic.begin()); iter!=mDynamic.end();
              ++iter)
+            records.push_back(&*iter);
+        std::sort(records.begin(), records.end(),
+            [] (const typename Dynamic::value_type* left, const typename Dynamic::value_type* right) { return left->first < right->first; });
+
+        for (const typename Dynamic::value_type* record : records)
         {
             writer.startRecord (T::sRecordId);
-            iter->second.save (writer);
+            record->second.save (writer);
             writer.endRecord (T::sRecordId);
         }
     }
@@ -1061,10 +1106,29 @@ namespace MWWorld
 
         mShared.clear();
         mShared.reserve(mStatic.size());
-        std::map<std::string, ESM::Dialogue>::iterator it = mStatic.begin();
+        Static::iterator it = mStatic.begin();
         for (; it != mStatic.end(); ++it) {
             mShared.push_back(&(it->second));
         }
+
+        // Dialogues are listed in alphabetical order
+        std::sort(mShared.begin(), mShared.end(), [] (const ESM::Dialogue* left, const ESM::Dialogue* right)
+        {
+            return Misc::StringUtils::ciLess(left->mId, right->mId);
+        });
+    }
+
+    template <>
+    std::unique_ptr<StoreBase::ParsedRecord> Store<ESM::Dialogue>::parse(ESM::ESMReader &esm) const
+    {
+        // Dialogues are merged with previous definitions, and the following INFOs refer to them
+        return nullptr;
+    }
+
+    template <>
+    bool Store<ESM::Dialogue>::canParseAhead() const
+    {
+        return false;
     }
 
     template <>
@@ -1076,7 +1140,7 @@ namespace MWWorld
         dialogue.loadId(esm);
 
         std::string idLower = Misc::StringUtils::lowerCase(dialogue.mId);
-        std::map<std::string, ESM::Dialogue>::iterator found = mStatic.find(idLower);
+        Static::iterator found = mStatic.find(idLower);
         if (found == mStatic.end())
         {
             dialogue.loadData(esm, isDeleted);
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
+
+#include <components/misc/stringops.hpp>
 
 #include "recordcmp.hpp"
 
@@ -30,6 +34,12 @@ namespace MWWorld
     class StoreBase
     {
     public:
+        /// Record parsed ahead of loading, see ESMStore::parse()
+        struct ParsedRecord
+        {
+            virtual ~ParsedRecord() {}
+        };
+
         virtual ~StoreBase() {}
 
         virtual void setUp() {}
@@ -41,6 +51,20 @@ namespace MWWorld
         virtual int getDynamicSize() const { return 0; }
         virtual RecordId load(ESM::ESMReader &esm) = 0;
 
+        /// Parse the current record without modifying the store. Returns nullptr for record
+        /// types that depend on previously loaded records, which have to be loaded in order.
+        /// @note Must be thread safe.
+        virtual std::unique_ptr<ParsedRecord> parse(ESM::ESMReader &esm) const { return nullptr; }
+
+        /// Merge a record returned by parse() into the store, the same way load() would.
+        virtual RecordId apply(ParsedRecord &record) { return RecordId(); }
+
+        /// Are all records of this store independent of previously loaded records? See parse().
+        virtual bool canParseAhead() const { return false; }
+
+        /// Write the records loaded from content files in the order they were defined, see ESMStore::writeStatic()
+        virtual void writeStatic(ESM::ESMWriter& writer) const {}
+
         virtual bool eraseStatic(const std::string &id) {return false;}
         virtual void clearDynamic() {}
 
@@ -140,14 +164,15 @@ namespace MWWorld
     template <class T>
     class Store : public StoreBase
     {
-        std::map<std::string, T>      mStatic;
+        // Keys are lower case, but lookups are case insensitive and don't need to convert the ID
+        typedef std::unordered_map<std::string, T, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> Dynamic;
+        typedef std::unordered_map<std::string, T, Misc::StringUtils::CiHash, Misc::StringUtils::CiEqual> Static;
+
+        Static              mStatic;
         std::vector<T *>    mShared; // Preserves the record order as it came from the content files (this
                                      // is relevant for the spell autocalc code and selection order
                                      // for heads/hairs in the character creation)
-        std::map<std::string, T> mDynamic;
-
-        typedef std::map<std::string, T> Dynamic;
-        typedef std::map<std::string, T> Static;
+        Dynamic             mDynamic;
 
         friend class ESMStore;
 
@@ -194,10 +219,18 @@ namespace MWWorld
         bool erase(const T &item);
 
         RecordId load(ESM::ESMReader &esm);
+        std::unique_ptr<ParsedRecord> parse(ESM::ESMReader &esm) const;
+        RecordId apply(ParsedRecord &record);
+        bool canParseAhead() const;
+        void writeStatic(ESM::ESMWriter& writer) const;
         void write(ESM::ESMWriter& writer, Loading::Listener& progress) const;
         RecordId read(ESM::ESMReader& reader);
     };
 
+    /// Records of a content file parsed ahead of loading, indexed by their position in the file.
+    /// Null for records that have to be loaded in order.
+    typedef std::vector<std::unique_ptr<StoreBase::ParsedRecord> > ParsedRecords;
+
     template <>
     class Store<ESM::LandTexture> : public StoreBase
     {
@@ -1,12 +1,17 @@
 #include "worldimp.hpp"
 
+#include <fstream>
+#include <sstream>
+
 #include <osg/Group>
 #include <osg/ComputeBoundsVisitor>
+#include <osg/Stats>
 
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
 #include <BulletCollision/CollisionShapes/btCompoundShape.h>
 
 #include <components/debug/debuglog.hpp>
+#include <components/debug/trace.hpp>
 
 #include <components/esm/esmreader.hpp>
 #include <components/esm/esmwriter.hpp>
@@ -20,10 +25,13 @@
 #include <components/files/collections.hpp>
 
 #include <components/resource/bulletshape.hpp>
+#include <components/resource/bulletshapemanager.hpp>
 #include <components/resource/resourcesystem.hpp>
 
 #include <components/sceneutil/positionattitudetransform.hpp>
 
+#include <components/settings/settings.hpp>
+
 #include <components/detournavigator/debug.hpp>
 #include <components/detournavigator/navigatorimpl.hpp>
 #include <components/detournavigator/navigatorstub.hpp>
@@ -98,6 +106,20 @@ namespace MWWorld
             return mLoaders.insert(std::make_pair(extension, loader)).second;
         }
 
+        void prepare(const FileList& files)
+        {
+            std::map<ContentLoader*, FileList> filesPerLoader;
+            for (const auto& file : files)
+            {
+                LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(file.second.extension().string())));
+                if (it != mLoaders.end())
+                    filesPerLoader[it->second].push_back(file);
+            }
+
+            for (const auto& loaderFiles : filesPerLoader)
+                loaderFiles.first->prepare(loaderFiles.second);
+        }
+
         void load(const boost::filesystem::path& filepath, int& index)
         {
             LoadersContainer::iterator it(mLoaders.find(Misc::StringUtils::lowerCase(filepath.extension().string())));
@@ -159,7 +181,8 @@ namespace MWWorld
         const std::vector<std::string>& contentFiles,
         ToUTF8::Utf8Encoder* encoder, int activationDistanceOverride,
         const std::string& startCell, const std::string& startupScript,
-        const std::string& resourcePath, const std::string& userDataPath)
+        const std::string& resourcePath, const std::string& userDataPath,
+        const std::string& cachePath)
     : mResourceSystem(resourceSystem), mLocalScripts (mStore),
       mSky (true), mCells (mStore, mEsm),
       mGodMode(false), mScriptsEnabled(true), mContentFiles (contentFiles), mUserDataPath(userDataPath),
@@ -173,7 +196,11 @@ namespace MWWorld
         listener->loadingOn();
 
         GameContentLoader gameContentLoader(*listener);
-        EsmLoader esmLoader(mStore, mEsm, encoder, *listener);
+        boost::filesystem::path cacheFile;
+        if (Settings::Manager::getBool("content cache", "General"))
+            cacheFile = boost::filesystem::path(cachePath) / "content.cache";
+
+        EsmLoader esmLoader(mStore, mEsm, encoder, *listener, cacheFile);
 
         gameContentLoader.addLoader(".esm", &esmLoader);
         gameContentLoader.addLoader(".esp", &esmLoader);
@@ -182,6 +209,7 @@ namespace MWWorld
         gameContentLoader.addLoader(".project", &esmLoader);
 
         loadContentFiles(fileCollections, contentFiles, gameContentLoader);
+        esmLoader.writeCache();
 
         listener->loadingOff();
 
@@ -197,12 +225,15 @@ namespace MWWorld
         mSwimHeightScale = mStore.get<ESM::GameSetting>().find("fSwimHeightScale")->mValue.getFloat();
 
         mPhysics.reset(new MWPhysics::PhysicsSystem(resourceSystem, rootNode));
+        if (Settings::Manager::getBool("collision shape disk cache", "Physics"))
+            mPhysics->getShapeManager()->setBvhDiskCachePath(mUserDataPath + "/shapecache");
 
         if (auto navigatorSettings = DetourNavigator::makeSettingsFromSettingsManager())
         {
             navigatorSettings->mMaxClimb = MWPhysics::sStepSizeUp;
             navigatorSettings->mMaxSlope = MWPhysics::sMaxSlope;
             navigatorSettings->mSwimHeightScale = mSwimHeightScale;
+            navigatorSettings->mNavMeshDiskCachePath = mUserDataPath + "/navmeshcache";
             DetourNavigator::RecastGlobalAllocator::init();
             mNavigator.reset(new DetourNavigator::NavigatorImpl(*navigatorSettings));
         }
@@ -211,7 +242,7 @@ namespace MWWorld
             mNavigator.reset(new DetourNavigator::NavigatorStub());
         }
 
-        mRendering.reset(new MWRender::RenderingManager(viewer, rootNode, resourceSystem, workQueue, resourcePath, *mNavigator));
+        mRendering.reset(new MWRender::RenderingManager(viewer, rootNode, resourceSystem, workQueue, resourcePath, mUserDataPath, *mNavigator));
         mProjectileManager.reset(new ProjectileManager(mRendering->getLightRoot(), resourceSystem, mRendering.get(), mPhysics.get()));
         mRendering->preloadCommonAssets();
 
@@ -689,15 +720,28 @@ namespace MWWorld
             return mPlayer->getPlayer();
         }
 
+        updateSearchPtrCaches();
+
+        const auto cached = mSearchPtrCache.find(name);
+        if (cached != mSearchPtrCache.end())
+        {
+            // Deleted references stay in their cell, so the cached Ptr is still safe to check
+            if (CellStore::isAccessible(cached->second.getRefData(), cached->second.getCellRef()))
+                return cached->second;
+            mSearchPtrCache.erase(cached);
+        }
+
         std::string lowerCaseName = Misc::StringUtils::lowerCase(name);
 
         for (CellStore* cellstore : mWorldScene->getActiveCells())
         {
-            // TODO: caching still doesn't work efficiently here (only works for the one CellStore that the reference is in)
             Ptr ptr = mCells.getPtr (lowerCaseName, *cellstore, false);
 
             if (!ptr.isEmpty())
+            {
+                mSearchPtrCache.emplace(name, ptr);
                 return ptr;
+            }
         }
 
         if (!activeOnly)
@@ -736,8 +780,33 @@ namespace MWWorld
         // The player is not registered in any CellStore so must be checked manually
         if (actorId == getPlayerPtr().getClass().getCreatureStats(getPlayerPtr()).getActorId())
             return getPlayerPtr();
+
+        updateSearchPtrCaches();
+
+        const auto cached = mActorIdCache.find(actorId);
+        if (cached != mActorIdCache.end())
+        {
+            const Ptr& ptr = cached->second;
+            if (ptr.getRefData().getCount() > 0 && ptr.getClass().getCreatureStats(ptr).matchesActorId(actorId))
+                return ptr;
+            mActorIdCache.erase(cached);
+        }
+
         // Now search cells
-        return mWorldScene->searchPtrViaActorId (actorId);
+        Ptr ptr = mWorldScene->searchPtrViaActorId (actorId);
+        if (!ptr.isEmpty())
+            mActorIdCache.emplace(actorId, ptr);
+        return ptr;
+    }
+
+    void World::updateSearchPtrCaches()
+    {
+        if (mSearchPtrCacheGeneration != mWorldScene->getActiveCellsGeneration())
+        {
+            mSearchPtrCache.clear();
+            mActorIdCache.clear();
+            mSearchPtrCacheGeneration = mWorldScene->getActiveCellsGeneration();
+        }
     }
 
     struct FindContainerVisitor
@@ -1245,6 +1314,12 @@ namespace MWWorld
             }
             else
             {
+                // Cached Ptrs of the reference point to its old cell
+                mSearchPtrCache.clear();
+                mActorIdCache.clear();
+
+                mWorldScene->insertPendingObject(ptr);
+
                 bool currCellActive = mWorldScene->isCellActive(*currCell);
                 bool newCellActive = mWorldScene->isCellActive(*newCell);
                 if (!currCellActive && newCellActive)
@@ -1571,7 +1646,18 @@ namespace MWWorld
 
         mProjectileManager->update(duration);
 
-        const MWPhysics::PtrVelocityList &results = mPhysics->applyQueuedMovement(duration);
+        if (mPhysics->isAsyncMovementEnabled())
+        {
+            mAsyncPhysicsQueued = true;
+            mAsyncPhysicsDuration = duration;
+            return;
+        }
+
+        applyMovement(mPhysics->applyQueuedMovement(duration));
+    }
+
+    void World::applyMovement(const MWPhysics::PtrVelocityList& results)
+    {
         MWPhysics::PtrVelocityList::const_iterator player(results.end());
         for(MWPhysics::PtrVelocityList::const_iterator iter(results.begin());iter != results.end();++iter)
         {
@@ -1587,6 +1673,19 @@ namespace MWWorld
             moveObjectImp(player->first, player->second.x(), player->second.y(), player->second.z(), false);
     }
 
+    void World::startAsyncPhysics()
+    {
+        if (!mAsyncPhysicsQueued)
+            return;
+        mAsyncPhysicsQueued = false;
+        mPhysics->startQueuedMovement(mAsyncPhysicsDuration);
+    }
+
+    void World::finishAsyncPhysics()
+    {
+        applyMovement(mPhysics->finishQueuedMovement());
+    }
+
     void World::updateNavigator()
     {
         mPhysics->forEachAnimatedObject([&] (const MWPhysics::Object* object)
@@ -2101,10 +2200,8 @@ namespace MWWorld
 
         std::vector<World::DoorMarker>& mOut;
 
-        bool operator()(const MWWorld::Ptr& ptr)
+        bool operator()(const MWWorld::LiveCellRef<ESM::Door>& ref, const MWWorld::Ptr&)
         {
-            MWWorld::LiveCellRef<ESM::Door>& ref = *static_cast<MWWorld::LiveCellRef<ESM::Door>* >(ptr.getBase());
-
             if (!ref.mData.isEnabled() || ref.mData.isDeleted())
                 return true;
 
@@ -2145,7 +2242,7 @@ namespace MWWorld
     void World::getDoorMarkers (CellStore* cell, std::vector<World::DoorMarker>& out)
     {
         GetDoorMarkerVisitor visitor(out);
-        cell->forEachType<ESM::Door>(visitor);
+        cell->forEachLiveCellRef<ESM::Door>(visitor);
     }
 
     void World::setWaterHeight(const float height)
@@ -2241,6 +2338,10 @@ namespace MWWorld
         dropped.getCellRef().unsetRefNum();
 
         if (mWorldScene->isCellActive(*cell)) {
+            // Cached Ptrs may shadow the new reference if it has the same ID
+            mSearchPtrCache.clear();
+            mActorIdCache.clear();
+
             if (dropped.getRefData().isEnabled()) {
                 mWorldScene->addObjectToScene(dropped);
             }
@@ -2770,6 +2871,31 @@ namespace MWWorld
         return mPhysics->getLineOfSight(actor, targetActor);
     }
 
+    void World::getLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& actors, std::vector<bool>& out)
+    {
+        std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> > queries;
+        std::vector<size_t> queryIndices;
+        for (size_t i=0; i<actors.size(); ++i)
+        {
+            const MWWorld::ConstPtr& actor = actors[i].first;
+            const MWWorld::ConstPtr& targetActor = actors[i].second;
+            if (!targetActor.getRefData().isEnabled() || !actor.getRefData().isEnabled())
+                continue; // cannot get LOS unless both NPC's are enabled
+            if (!targetActor.getRefData().getBaseNode() || !actor.getRefData().getBaseNode())
+                continue; // not in active cell
+
+            queryIndices.push_back(i);
+            queries.push_back(actors[i]);
+        }
+
+        std::vector<bool> results;
+        mPhysics->getLinesOfSight(queries, results);
+
+        out.assign(actors.size(), false);
+        for (size_t i=0; i<queryIndices.size(); ++i)
+            out[queryIndices[i]] = results[i];
+    }
+
     float World::getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater)
     {
         osg::Vec3f to (dir);
@@ -2956,6 +3082,7 @@ namespace MWWorld
     void World::loadContentFiles(const Files::Collections& fileCollections,
         const std::vector<std::string>& content, ContentLoader& contentLoader)
     {
+        ContentLoader::FileList files;
         int idx = 0;
         for (const std::string &file : content)
         {
@@ -2963,7 +3090,7 @@ namespace MWWorld
             const Files::MultiDirCollection& col = fileCollections.getCollection(filename.extension().string());
             if (col.doesExist(file))
             {
-                contentLoader.load(col.getPath(file), idx);
+                files.emplace_back(idx, col.getPath(file));
             }
             else
             {
@@ -2972,6 +3099,14 @@ namespace MWWorld
             }
             idx++;
         }
+
+        contentLoader.prepare(files);
+
+        for (const auto& file : files)
+        {
+            idx = file.first;
+            contentLoader.load(file.second, idx);
+        }
     }
 
     bool World::startSpellCast(const Ptr &actor)
@@ -3627,6 +3762,51 @@ namespace MWWorld
         return file;
     }
 
+    std::string World::exportTrace()
+    {
+        std::string file = mUserDataPath + "/openmw-trace.json";
+        std::ofstream stream(file.c_str());
+        Debug::Trace::write(stream);
+        if (!stream)
+            throw std::runtime_error("Failed to write " + file);
+        return file;
+    }
+
+    std::string World::getMemoryStats()
+    {
+        std::ostringstream stream;
+
+        std::vector<std::pair<const char*, std::size_t> > cacheUsage;
+        mRendering->getResourceSystem()->getCacheMemoryUsage(cacheUsage);
+        std::size_t totalCacheUsage = 0;
+        for (const auto& usage : cacheUsage)
+        {
+            if (usage.second == 0)
+                continue;
+            stream << usage.first << " cache: " << usage.second / 1024 << " KiB\n";
+            totalCacheUsage += usage.second;
+        }
+        stream << "Total cache: " << totalCacheUsage / 1024 << " KiB\n";
+
+        std::size_t numTextures = 0;
+        const std::size_t textureMemory = mRendering->estimateTextureMemory(numTextures);
+        stream << "Scene textures: " << numTextures << ", " << textureMemory / 1024 << " KiB on the GPU\n";
+
+        // The navigator only reports its memory through osg::Stats
+        osg::ref_ptr<osg::Stats> stats (new osg::Stats("memstats"));
+        mNavigator->reportStats(0, *stats);
+        double navMeshCacheSize = 0;
+        stats->getAttribute(0, "NavMesh CacheSize", navMeshCacheSize);
+        stream << "NavMesh tiles cache: " << static_cast<std::size_t>(navMeshCacheSize) / 1024 << " KiB\n";
+
+        std::size_t loadedCells = 0;
+        std::size_t references = 0;
+        mCells.countLoadedReferences(loadedCells, references);
+        stream << "Loaded cells: " << loadedCells << ", " << references << " references";
+
+        return stream.str();
+    }
+
     void World::spawnRandomCreature(const std::string &creatureList)
     {
         const ESM::CreatureLevList* list = mStore.get<ESM::CreatureLevList>().find(creatureList);
@@ -3648,7 +3828,8 @@ namespace MWWorld
 
     void World::spawnBloodEffect(const Ptr &ptr, const osg::Vec3f &worldPosition)
     {
-        if (ptr == getPlayerPtr() && Settings::Manager::getBool("hit fader", "GUI"))
+        static const Settings::SettingValue<bool> hitFader("hit fader", "GUI");
+        if (ptr == getPlayerPtr() && hitFader.get())
             return;
 
         std::string texture = Fallback::Map::getString("Blood_Texture_" + std::to_string(ptr.getClass().getBloodTexture(ptr)));
@@ -3856,6 +4037,18 @@ namespace MWWorld
         return mNavigator.get();
     }
 
+    void World::reportStats(unsigned int frameNumber, osg::Stats& stats) const
+    {
+        mPhysics->reportStats(frameNumber, stats);
+        mWorldScene->reportStats(frameNumber, stats);
+
+        std::size_t loadedCells = 0;
+        std::size_t references = 0;
+        mCells.countLoadedReferences(loadedCells, references);
+        stats.setAttribute(frameNumber, "Cells Loaded", loadedCells);
+        stats.setAttribute(frameNumber, "Cell References", references);
+    }
+
     void World::updateActorPath(const MWWorld::ConstPtr& actor, const std::deque<osg::Vec3f>& path,
             const osg::Vec3f& halfExtents, const osg::Vec3f& start, const osg::Vec3f& end) const
     {
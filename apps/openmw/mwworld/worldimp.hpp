@@ -1,6 +1,8 @@
 #ifndef GAME_MWWORLD_WORLDIMP_H
 #define GAME_MWWORLD_WORLDIMP_H
 
+#include <unordered_map>
+
 #include <osg/ref_ptr>
 
 #include <components/settings/settings.hpp>
@@ -112,6 +114,10 @@ namespace MWWorld
             osg::Vec3f mDefaultHalfExtents;
             bool mShouldUpdateNavigator = false;
 
+            // Movement queued by the last doPhysics call, waiting for startAsyncPhysics
+            bool mAsyncPhysicsQueued = false;
+            float mAsyncPhysicsDuration = 0.f;
+
             // not implemented
             World (const World&);
             World& operator= (const World&);
@@ -121,6 +127,18 @@ namespace MWWorld
             std::map<MWWorld::Ptr, MWWorld::DoorState> mDoorStates;
             ///< only holds doors that are currently moving. 1 = opening, 2 = closing
 
+            // References found by searchPtr in the active cells, by the ID as passed in. Scripts look up the same
+            // IDs every frame. Cleared when the active cells change, a reference moves to another cell or a new one is
+            // placed in an active cell.
+            std::unordered_map<std::string, Ptr> mSearchPtrCache;
+            // Actors found by searchPtrViaActorId, for AI packages resolving their targets every frame. Cleared with
+            // mSearchPtrCache.
+            std::unordered_map<int, Ptr> mActorIdCache;
+            unsigned int mSearchPtrCacheGeneration = 0;
+
+            /// Clear the search caches if the active cells changed since they were filled.
+            void updateSearchPtrCaches();
+
             std::string mStartCell;
 
             void updateWeather(float duration, bool paused = false);
@@ -154,6 +172,9 @@ namespace MWWorld
             void doPhysics(float duration);
             ///< Run physics simulation and modify \a world accordingly.
 
+            void applyMovement(const MWPhysics::PtrVelocityList& results);
+            ///< Move the actors to the positions found by the physics simulation.
+
             void updateNavigator();
 
             bool updateNavigatorObject(const MWPhysics::Object* object);
@@ -200,7 +221,8 @@ namespace MWWorld
                 const std::vector<std::string>& contentFiles,
                 ToUTF8::Utf8Encoder* encoder, int activationDistanceOverride,
                 const std::string& startCell, const std::string& startupScript,
-                const std::string& resourcePath, const std::string& userDataPath);
+                const std::string& resourcePath, const std::string& userDataPath,
+                const std::string& cachePath);
 
             virtual ~World();
 
@@ -486,6 +508,10 @@ namespace MWWorld
             void update (float duration, bool paused) override;
             void updatePhysics (float duration, bool paused) override;
 
+            void startAsyncPhysics () override;
+
+            void finishAsyncPhysics () override;
+
             void updateWindowManager () override;
 
             MWWorld::Ptr placeObject (const MWWorld::ConstPtr& object, float cursorX, float cursorY, int amount) override;
@@ -567,6 +593,8 @@ namespace MWWorld
             bool getLOS(const MWWorld::ConstPtr& actor,const MWWorld::ConstPtr& targetActor) override;
             ///< get Line of Sight (morrowind stupid implementation)
 
+            void getLOS(const std::vector<std::pair<MWWorld::ConstPtr, MWWorld::ConstPtr> >& actors, std::vector<bool>& out) override;
+
             float getDistToNearestRayHit(const osg::Vec3f& from, const osg::Vec3f& dir, float maxDist, bool includeWater = false) override;
 
             void enableActorCollision(const MWWorld::Ptr& actor, bool enable) override;
@@ -707,11 +735,18 @@ namespace MWWorld
             /// \param ptr object to export scene graph for (if empty, export entire scene graph)
             std::string exportSceneGraph(const MWWorld::Ptr& ptr) override;
 
+            /// Write the zones recorded by Debug::Trace to a file and return the filename.
+            std::string exportTrace() override;
+
+            std::string getMemoryStats() override;
+
             /// Preload VFX associated with this effect list
             void preloadEffects(const ESM::EffectList* effectList) override;
 
             DetourNavigator::Navigator* getNavigator() const override;
 
+            void reportStats(unsigned int frameNumber, osg::Stats& stats) const override;
+
             void updateActorPath(const MWWorld::ConstPtr& actor, const std::deque<osg::Vec3f>& path,
                     const osg::Vec3f& halfExtents, const osg::Vec3f& start, const osg::Vec3f& end) const override;
 
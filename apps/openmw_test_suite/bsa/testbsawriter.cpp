@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <components/bsa/bsa_file.hpp>
+#include <components/bsa/bsa_writer.hpp>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace
+{
+    using namespace testing;
+    namespace bfs = boost::filesystem;
+
+    struct BSAWriterTest : Test
+    {
+        const bfs::path mDir = bfs::temp_directory_path() / bfs::unique_path("openmw-bsa-%%%%-%%%%");
+
+        BSAWriterTest()
+        {
+            bfs::create_directories(mDir);
+        }
+
+        ~BSAWriterTest()
+        {
+            bfs::remove_all(mDir);
+        }
+
+        bfs::path writeFile(const std::string& name, const std::string& content) const
+        {
+            const bfs::path path = mDir / name;
+            bfs::ofstream stream(path, std::ios::binary);
+            stream << content;
+            return path;
+        }
+
+        static std::string read(Bsa::BSAFile& bsa, const char* name)
+        {
+            std::ostringstream content;
+            const Files::IStreamPtr stream = bsa.getFile(name);
+            content << stream->rdbuf();
+            return content.str();
+        }
+    };
+
+    TEST_F(BSAWriterTest, saved_archive_should_be_readable_by_bsa_file)
+    {
+        Bsa::BSAWriter writer;
+        writer.addFile("Meshes/A.nif", writeFile("a", "mesh"));
+        writer.addFile("textures\\b.dds", writeFile("b", "texture"));
+        writer.addFile("c.txt", writeFile("c", ""));
+        writer.save(mDir / "test.bsa");
+
+        Bsa::BSAFile bsa;
+        bsa.open((mDir / "test.bsa").string());
+
+        ASSERT_EQ(bsa.getList().size(), 3u);
+        EXPECT_TRUE(bsa.exists("meshes\\a.nif"));
+        EXPECT_EQ(read(bsa, "MESHES/A.NIF"), "mesh");
+        EXPECT_EQ(read(bsa, "textures/b.dds"), "texture");
+        EXPECT_EQ(read(bsa, "c.txt"), "");
+    }
+
+    TEST_F(BSAWriterTest, data_should_be_stored_in_given_order_first)
+    {
+        Bsa::BSAWriter writer;
+        writer.addFile("a.txt", writeFile("a", "a"));
+        writer.addFile("b.txt", writeFile("b", "b"));
+        writer.addFile("c.txt", writeFile("c", "c"));
+        writer.setDataOrder({"C.TXT", "missing.txt", "a.txt"});
+        writer.save(mDir / "test.bsa");
+
+        Bsa::BSAFile bsa;
+        bsa.open((mDir / "test.bsa").string());
+
+        std::uint32_t offsets[3] = {};
+        for (const Bsa::BSAFile::FileStruct& file : bsa.getList())
+            offsets[file.name[0] - 'a'] = file.offset;
+
+        EXPECT_LT(offsets[2], offsets[0]);
+        EXPECT_LT(offsets[0], offsets[1]);
+    }
+
+    TEST_F(BSAWriterTest, bsa_file_should_find_files_with_wrong_stored_hashes)
+    {
+        Bsa::BSAWriter writer;
+        writer.addFile("a.txt", writeFile("a", "a"));
+        writer.addFile("b.txt", writeFile("b", "b"));
+        writer.save(mDir / "test.bsa");
+
+        {
+            bfs::fstream stream(mDir / "test.bsa", std::ios::binary | std::ios::in | std::ios::out);
+            std::uint32_t header[3] = {};
+            stream.read(reinterpret_cast<char*>(header), sizeof(header));
+            const std::string zeroHashes(8 * header[2], '\0');
+            stream.seekp(12 + header[1]);
+            stream.write(zeroHashes.data(), zeroHashes.size());
+            ASSERT_TRUE(stream.good());
+        }
+
+        Bsa::BSAFile bsa;
+        bsa.open((mDir / "test.bsa").string());
+
+        EXPECT_TRUE(bsa.exists("a.txt"));
+        EXPECT_EQ(read(bsa, "b.txt"), "b");
+    }
+
+    TEST_F(BSAWriterTest, save_should_throw_for_duplicate_names)
+    {
+        Bsa::BSAWriter writer;
+        writer.addFile("a.txt", writeFile("a", "a"));
+        writer.addFile("A.TXT", writeFile("b", "b"));
+        EXPECT_THROW(writer.save(mDir / "test.bsa"), std::runtime_error);
+    }
+}
@@ -58,6 +58,7 @@ namespace
             mSettings.mRegionMinSize = 8;
             mSettings.mTileSize = 64;
             mSettings.mAsyncNavMeshUpdaterThreads = 1;
+            mSettings.mAsyncPathFinderThreads = 1;
             mSettings.mMaxNavMeshTilesCacheSize = 1024 * 1024;
             mSettings.mMaxPolygonPathSize = 1024;
             mSettings.mMaxSmoothPathSize = 1024;
@@ -134,6 +135,37 @@ namespace
         })) << mPath;
     }
 
+    TEST_F(DetourNavigatorNavigatorTest, find_path_async_should_return_same_path_as_find_path)
+    {
+        const std::array<btScalar, 5 * 5> heightfieldData {{
+            0,   0,    0,    0,    0,
+            0, -25,  -25,  -25,  -25,
+            0, -25, -100, -100, -100,
+            0, -25, -100, -100, -100,
+            0, -25, -100, -100, -100,
+        }};
+        btHeightfieldTerrainShape shape(5, 5, heightfieldData.data(), 1, 0, 0, 2, PHY_FLOAT, false);
+        shape.setLocalScaling(btVector3(128, 128, 1));
+
+        mNavigator->addAgent(mAgentHalfExtents);
+        mNavigator->addObject(ObjectId(&shape), shape, btTransform::getIdentity());
+        mNavigator->update(mPlayerPosition);
+        mNavigator->wait();
+
+        mNavigator->findPath(mAgentHalfExtents, mStepSize, mStart, mEnd, Flag_walk, mOut);
+        const auto asyncPath = mNavigator->findPathAsync(mAgentHalfExtents, mStepSize, mStart, mEnd, Flag_walk);
+
+        EXPECT_FALSE(mPath.empty());
+        EXPECT_EQ(asyncPath.get(), mPath) << mPath;
+    }
+
+    TEST_F(DetourNavigatorNavigatorTest, find_path_async_for_existing_agent_with_no_navmesh_should_throw_exception)
+    {
+        mNavigator->addAgent(mAgentHalfExtents);
+        const auto asyncPath = mNavigator->findPathAsync(mAgentHalfExtents, mStepSize, mStart, mEnd, Flag_walk);
+        EXPECT_THROW(asyncPath.get(), NavigatorException);
+    }
+
     TEST_F(DetourNavigatorNavigatorTest, add_object_should_change_navmesh)
     {
         const std::array<btScalar, 5 * 5> heightfieldData {{
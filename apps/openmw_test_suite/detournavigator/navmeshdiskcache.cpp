@@ -0,0 +1,119 @@
+#include "operators.hpp"
+
+#include <components/detournavigator/navmeshdiskcache.hpp>
+#include <components/detournavigator/recastmesh.hpp>
+#include <components/detournavigator/settings.hpp>
+
+#include <LinearMath/btTransform.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace
+{
+    using namespace testing;
+    using namespace DetourNavigator;
+
+    struct DetourNavigatorNavMeshDiskCacheTest : Test
+    {
+        const osg::Vec3f mAgentHalfExtents {1, 2, 3};
+        const TilePosition mTilePosition {0, 0};
+        const std::vector<int> mIndices {{0, 1, 2}};
+        const std::vector<float> mVertices {{0, 0, 0, 1, 0, 0, 1, 1, 0}};
+        const std::vector<AreaType> mAreaTypes {1, AreaType_ground};
+        const std::vector<RecastMesh::Water> mWater {};
+        const std::size_t mTrianglesPerChunk {1};
+        const RecastMesh mRecastMesh {mIndices, mVertices, mAreaTypes, mWater, mTrianglesPerChunk};
+        const std::vector<OffMeshConnection> mOffMeshConnections {};
+        const boost::filesystem::path mPath = boost::filesystem::temp_directory_path()
+            / boost::filesystem::unique_path("openmw_navmeshdiskcache_%%%%-%%%%-%%%%");
+        const std::uint64_t mMaxSize = 1024 * 1024;
+        Settings mSettings;
+        NavMeshData mNavMeshData;
+
+        DetourNavigatorNavMeshDiskCacheTest()
+        {
+            mSettings.mTileSize = 64;
+            const auto data = reinterpret_cast<unsigned char*>(dtAlloc(3, DT_ALLOC_PERM));
+            data[0] = 1;
+            data[1] = 2;
+            data[2] = 3;
+            mNavMeshData = NavMeshData(data, 3);
+        }
+
+        ~DetourNavigatorNavMeshDiskCacheTest()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mPath, ec);
+        }
+    };
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, get_for_empty_cache_should_return_empty_value)
+    {
+        const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, get_after_set_should_return_same_data)
+    {
+        const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+        cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        const auto result = cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings);
+        ASSERT_TRUE(result.mValue);
+        ASSERT_EQ(result.mSize, mNavMeshData.mSize);
+        EXPECT_EQ(std::memcmp(result.mValue.get(), mNavMeshData.mValue.get(), 3), 0);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, get_for_other_settings_should_return_empty_value)
+    {
+        const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+        cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        mSettings.mTileSize = 128;
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, get_for_other_tile_should_return_empty_value)
+    {
+        const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+        cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, TilePosition(1, 0), mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, disabled_cache_should_not_store_data)
+    {
+        const NavMeshDiskCache cache(std::string(), mMaxSize);
+        EXPECT_FALSE(cache.isEnabled());
+        cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, set_to_full_cache_should_not_store_data)
+    {
+        const NavMeshDiskCache cache(mPath.string(), 1);
+        cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, cache_should_remove_files_over_max_size_on_start)
+    {
+        {
+            const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+            cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        }
+        const NavMeshDiskCache cache(mPath.string(), 1);
+        EXPECT_TRUE(boost::filesystem::is_empty(mPath));
+    }
+
+    TEST_F(DetourNavigatorNavMeshDiskCacheTest, get_for_other_water_should_return_empty_value)
+    {
+        const NavMeshDiskCache cache(mPath.string(), mMaxSize);
+        const std::vector<RecastMesh::Water> water {1, RecastMesh::Water {1, btTransform::getIdentity()}};
+        const RecastMesh recastMesh {mIndices, mVertices, mAreaTypes, water, mTrianglesPerChunk};
+        cache.set(mAgentHalfExtents, mTilePosition, recastMesh, mOffMeshConnections, mSettings, mNavMeshData);
+        EXPECT_TRUE(cache.get(mAgentHalfExtents, mTilePosition, recastMesh, mOffMeshConnections, mSettings).mValue);
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, mSettings).mValue);
+    }
+}
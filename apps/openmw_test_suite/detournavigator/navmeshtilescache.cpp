@@ -8,6 +8,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 namespace DetourNavigator
 {
     static inline bool operator ==(const NavMeshDataRef& lhs, const NavMeshDataRef& rhs)
@@ -341,4 +343,61 @@ namespace
                                std::move(anotherNavMeshData)));
         EXPECT_TRUE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections));
     }
+
+    TEST_F(DetourNavigatorNavMeshTilesCacheTest, get_from_compressing_cache_should_return_decompressed_value)
+    {
+        const std::size_t maxSize = 1024;
+        NavMeshTilesCache cache(maxSize, true);
+
+        const unsigned char bytes[] = {1, 2, 3, 4, 5, 6, 7, 8};
+        const auto data = reinterpret_cast<unsigned char*>(dtAlloc(sizeof(bytes), DT_ALLOC_PERM));
+        std::copy(std::begin(bytes), std::end(bytes), data);
+        NavMeshData navMeshData {data, sizeof(bytes)};
+
+        ASSERT_TRUE(cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections,
+                              std::move(navMeshData)));
+        const auto result = cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections);
+        ASSERT_TRUE(result);
+        ASSERT_EQ(result.get().mSize, static_cast<int>(sizeof(bytes)));
+        EXPECT_TRUE(std::equal(std::begin(bytes), std::end(bytes), result.get().mValue));
+    }
+
+    TEST_F(DetourNavigatorNavMeshTilesCacheTest, get_from_compressing_cache_for_another_key_should_return_empty_value)
+    {
+        const std::size_t maxSize = 1024;
+        NavMeshTilesCache cache(maxSize, true);
+
+        const std::vector<RecastMesh::Water> water {1, RecastMesh::Water {1, btTransform::getIdentity()}};
+        const RecastMesh anotherRecastMesh {mIndices, mVertices, mAreaTypes, water, mTrianglesPerChunk};
+
+        ASSERT_TRUE(cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections,
+                              std::move(mNavMeshData)));
+        EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, anotherRecastMesh, mOffMeshConnections));
+        EXPECT_TRUE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections));
+    }
+
+    TEST_F(DetourNavigatorNavMeshTilesCacheTest, get_from_compressing_cache_should_return_empty_value_when_decompressed_item_does_not_fit)
+    {
+        const std::size_t maxSize = 1024;
+        NavMeshTilesCache cache(maxSize, true);
+
+        const std::vector<RecastMesh::Water> water {1, RecastMesh::Water {1, btTransform::getIdentity()}};
+        const RecastMesh anotherRecastMesh {mIndices, mVertices, mAreaTypes, water, mTrianglesPerChunk};
+
+        const auto makeData = [] (int size)
+        {
+            const auto data = reinterpret_cast<unsigned char*>(dtAlloc(size, DT_ALLOC_PERM));
+            std::fill(data, data + size, 0);
+            return NavMeshData {data, size};
+        };
+
+        ASSERT_TRUE(cache.set(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections, makeData(800)));
+        {
+            const auto anotherValue = cache.set(mAgentHalfExtents, mTilePosition, anotherRecastMesh,
+                mOffMeshConnections, makeData(600));
+            ASSERT_TRUE(anotherValue);
+            EXPECT_FALSE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections));
+        }
+        EXPECT_TRUE(cache.get(mAgentHalfExtents, mTilePosition, mRecastMesh, mOffMeshConnections));
+    }
 }
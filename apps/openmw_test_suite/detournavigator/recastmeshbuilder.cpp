@@ -101,11 +101,9 @@ namespace
             -0.5, 0, -0.5,
             -0.5, 0, 0.5,
             0.5, 0, -0.5,
-            0.5, 0, -0.5,
-            -0.5, 0, 0.5,
             0.5, 0, 0.5,
         }));
-        EXPECT_EQ(recastMesh->getIndices(), std::vector<int>({0, 1, 2, 3, 4, 5}));
+        EXPECT_EQ(recastMesh->getIndices(), std::vector<int>({0, 1, 2, 2, 1, 3}));
         EXPECT_EQ(recastMesh->getAreaTypes(), std::vector<AreaType>({AreaType_ground, AreaType_ground}));
     }
 
@@ -174,8 +172,6 @@ namespace
             -1, -2, 1,
             1, -2, -1,
             -1, -2, -1,
-            1, 0, -1,
-            -1, 0, 1,
             1, 0, 1,
         }));
         EXPECT_EQ(recastMesh->getIndices(), std::vector<int>({
@@ -192,7 +188,7 @@ namespace
             5, 9, 10,
             10, 9, 7,
             7, 8, 10,
-            11, 12, 13,
+            0, 1, 11,
         }));
         EXPECT_EQ(recastMesh->getAreaTypes(), std::vector<AreaType>(14, AreaType_ground));
     }
@@ -401,6 +397,28 @@ namespace
         EXPECT_EQ(recastMesh->getAreaTypes(), std::vector<AreaType>({AreaType_ground, AreaType_null}));
     }
 
+    TEST_F(DetourNavigatorRecastMeshBuilderTest, create_should_merge_same_vertices_of_different_objects)
+    {
+        btTriangleMesh mesh1;
+        mesh1.addTriangle(btVector3(-1, -1, 0), btVector3(-1, 1, 0), btVector3(1, -1, 0));
+        btBvhTriangleMeshShape shape1(&mesh1, true);
+        btTriangleMesh mesh2;
+        mesh2.addTriangle(btVector3(1, 1, 0), btVector3(-1, 1, 0), btVector3(1, -1, 0));
+        btBvhTriangleMeshShape shape2(&mesh2, true);
+        RecastMeshBuilder builder(mSettings, mBounds);
+        builder.addObject(static_cast<const btCollisionShape&>(shape1), btTransform::getIdentity(), AreaType_ground);
+        builder.addObject(static_cast<const btCollisionShape&>(shape2), btTransform::getIdentity(), AreaType_null);
+        const auto recastMesh = builder.create();
+        EXPECT_EQ(recastMesh->getVertices(), std::vector<float>({
+            1, 0, -1,
+            -1, 0, 1,
+            -1, 0, -1,
+            1, 0, 1,
+        }));
+        EXPECT_EQ(recastMesh->getIndices(), std::vector<int>({0, 1, 2, 0, 1, 3}));
+        EXPECT_EQ(recastMesh->getAreaTypes(), std::vector<AreaType>({AreaType_ground, AreaType_null}));
+    }
+
     TEST_F(DetourNavigatorRecastMeshBuilderTest, add_water_then_get_water_should_return_it)
     {
         RecastMeshBuilder builder(mSettings, mBounds);
@@ -0,0 +1,34 @@
+#include <components/misc/poolallocator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <string>
+
+namespace
+{
+    TEST(MiscPoolAllocatorTest, list_elements_should_keep_their_address)
+    {
+        std::list<std::string, Misc::PoolAllocator<std::string>> list;
+        list.push_back("first");
+        const std::string* first = &list.front();
+        for (int i = 0; i < 1000; ++i)
+            list.push_back(std::to_string(i));
+
+        EXPECT_EQ(first, &list.front());
+        EXPECT_EQ(*first, "first");
+        EXPECT_EQ(list.size(), 1001u);
+        EXPECT_EQ(list.back(), "999");
+    }
+
+    TEST(MiscPoolAllocatorTest, freed_blocks_should_be_reused)
+    {
+        std::list<int, Misc::PoolAllocator<int>> list;
+        list.push_back(1);
+        const int* address = &list.front();
+        list.pop_front();
+        list.push_back(2);
+
+        EXPECT_EQ(address, &list.front());
+    }
+}
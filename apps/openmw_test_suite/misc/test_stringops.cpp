@@ -51,3 +51,62 @@ TEST_F (PartialBinarySearchTest, ci_test)
     std::string unicode1 = "\u04151 \u0418"; // CYRILLIC CAPITAL LETTER IE, CYRILLIC CAPITAL LETTER I
     EXPECT_TRUE( Misc::StringUtils::lowerCase(unicode1) == unicode1 );
 }
+
+struct CiHashTest : public ::testing::Test
+{
+  protected:
+    Misc::StringUtils::CiHash mHash;
+    Misc::StringUtils::CiEqual mEqual;
+};
+
+TEST_F (CiHashTest, ci_hash_test)
+{
+    EXPECT_EQ (mHash("Tri Head"), mHash("tri head"));
+    EXPECT_TRUE (mEqual("Tri Head", "TRI HEAD"));
+    EXPECT_FALSE (mEqual("Tri Head", "Tri Head 01"));
+}
+
+struct CaseConversionTest : public ::testing::Test
+{
+  protected:
+    std::string mAllChars;
+    const std::string mLower = "tri bip01 spine1 \xc3\xa4 neck";
+    const std::string mUpper = "TRI BIP01 SPINE1 \xc3\xa4 NECK";
+
+    virtual void SetUp()
+    {
+        for (int c = 0; c < 256; ++c)
+            mAllChars.push_back(static_cast<char>(c));
+    }
+};
+
+TEST_F (CaseConversionTest, lower_case_should_change_only_ascii_upper_case_letters_of_all_positions)
+{
+    std::string expected = mAllChars;
+    for (char& c : expected)
+        c = Misc::StringUtils::toLower(c);
+
+    for (std::size_t offset = 0; offset < 8; ++offset)
+        EXPECT_EQ (Misc::StringUtils::lowerCase(mAllChars.substr(offset)), expected.substr(offset));
+}
+
+TEST_F (CaseConversionTest, ci_compare_should_match_per_character_compare_for_any_length)
+{
+    for (std::size_t size = 0; size <= mLower.size(); ++size)
+    {
+        EXPECT_TRUE (Misc::StringUtils::ciEqual(mLower.substr(0, size), mUpper.substr(0, size)));
+        EXPECT_FALSE (Misc::StringUtils::ciLess(mLower.substr(0, size), mUpper.substr(0, size)));
+
+        for (std::size_t changed = 0; changed < size; ++changed)
+        {
+            std::string other = mUpper.substr(0, size);
+            other[changed] = '\xc4';
+            EXPECT_FALSE (Misc::StringUtils::ciEqual(mLower.substr(0, size), other));
+            EXPECT_EQ (Misc::StringUtils::ciLess(mLower.substr(0, size), other),
+                mLower[changed] < other[changed]);
+        }
+    }
+
+    EXPECT_TRUE (Misc::StringUtils::ciEqual(std::string("Misc_SoulGem_Azura"), "misc_soulgem_azura"));
+    EXPECT_FALSE (Misc::StringUtils::ciEqual(std::string("Misc_SoulGem_Azura"), "misc_soulgem"));
+}
@@ -65,3 +65,24 @@ TEST_F(KeywordSearchTest, keyword_test_conflict_resolution3)
     ASSERT_TRUE (matches.size() == 1);
     ASSERT_TRUE (std::string(matches.front().mBeg, matches.front().mEnd) == "bar lock");
 }
+
+TEST_F(KeywordSearchTest, keyword_test_overlapping_prefix)
+{
+    // "ash" only starts after a partial match of "ashlander" failed, and keywords are case insensitive
+    MWDialogue::KeywordSearch<std::string, int> search;
+    search.seed("ashlander", 0);
+    search.seed("ash", 1);
+    search.seed("Lander", 2);
+
+    std::string text = "ashland ash and lander";
+
+    std::vector<MWDialogue::KeywordSearch<std::string, int>::Match> matches;
+    search.highlightKeywords(text.begin(), text.end(), matches);
+
+    ASSERT_TRUE (matches.size() == 3);
+    ASSERT_TRUE (std::string(matches[0].mBeg, matches[0].mEnd) == "ash");
+    ASSERT_TRUE (matches[0].mBeg == text.begin());
+    ASSERT_TRUE (std::string(matches[1].mBeg, matches[1].mEnd) == "ash");
+    ASSERT_TRUE (std::string(matches[2].mBeg, matches[2].mEnd) == "lander");
+    ASSERT_TRUE (matches[2].mValue == 2);
+}
@@ -313,3 +313,87 @@ TEST_F(StoreTest, overwrite_test)
 
     ASSERT_TRUE (overwrittenRec && overwrittenRec->mModel == "the_new_model");
 }
+
+/// Tests that records parsed ahead of loading are merged the same way as loaded records.
+TEST_F(StoreTest, parsed_records_overwrite_test)
+{
+    const std::string recordId = "foobar";
+
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = recordId;
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    // master file inserts a record
+    Files::IStreamPtr file = getEsmFile(record, false);
+    reader.open(file, "filename");
+    mEsmStore.load(reader, &dummyListener);
+
+    // a plugin overwrites it, its records are parsed ahead of loading
+    record.mId = "Foobar";
+    record.mModel = "the_new_model";
+
+    MWWorld::ParsedRecords parsed;
+    reader.open(getEsmFile(record, false), "filename");
+    mEsmStore.parse(reader, parsed);
+
+    ASSERT_EQ (parsed.size(), 1u);
+    ASSERT_TRUE (parsed[0] != nullptr);
+    ASSERT_TRUE (mEsmStore.get<RecordType>().search(recordId)->mModel.empty());
+
+    reader.open(getEsmFile(record, false), "filename");
+    mEsmStore.load(reader, &dummyListener, &parsed);
+    mEsmStore.setUp();
+
+    const RecordType* overwrittenRec = mEsmStore.get<RecordType>().search(recordId);
+
+    ASSERT_EQ (mEsmStore.get<RecordType>().getSize(), 1u);
+    ASSERT_TRUE (overwrittenRec != nullptr);
+    ASSERT_EQ (overwrittenRec->mModel, "the_new_model");
+}
+
+/// Tests that records written by writeStatic() are read back, and skipped when loading the content file again.
+TEST_F(StoreTest, static_records_cache_test)
+{
+    typedef ESM::Apparatus RecordType;
+
+    RecordType record;
+    record.blank();
+    record.mId = "foobar";
+    record.mModel = "the_model";
+
+    ESM::ESMReader reader;
+    std::vector<ESM::ESMReader> readerList;
+    readerList.push_back(reader);
+    reader.setGlobalReaderList(&readerList);
+
+    reader.open(getEsmFile(record, false), "filename");
+    mEsmStore.load(reader, &dummyListener);
+
+    ESM::ESMWriter writer;
+    std::stringstream* stream = new std::stringstream;
+    writer.setFormat(0);
+    writer.save(*stream);
+    mEsmStore.writeStatic(writer);
+
+    MWWorld::ESMStore cachedStore;
+    reader.open(Files::IStreamPtr(stream), "cache");
+    cachedStore.loadStatic(reader);
+
+    record.mModel = "ignored_model";
+    reader.open(getEsmFile(record, false), "filename");
+    cachedStore.load(reader, &dummyListener, nullptr, true);
+    cachedStore.setUp();
+
+    const RecordType* cachedRec = cachedStore.get<RecordType>().search("foobar");
+
+    ASSERT_EQ (cachedStore.get<RecordType>().getSize(), 1u);
+    ASSERT_TRUE (cachedRec != nullptr);
+    ASSERT_EQ (cachedRec->mModel, "the_model");
+}
@@ -0,0 +1,61 @@
+#include <components/nif/niffile.hpp>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+namespace
+{
+    using namespace testing;
+
+    struct NifNIFFileTest : Test
+    {
+        std::string mData;
+
+        NifNIFFileTest()
+        {
+            mData = "NetImmerse File Format, Version 4.0.0.2\n";
+            writeUInt(0x04000002);
+        }
+
+        void writeUInt(unsigned int value)
+        {
+            mData.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        void writeString(const std::string& value)
+        {
+            writeUInt(static_cast<unsigned int>(value.size()));
+            mData += value;
+        }
+
+        Files::IStreamPtr makeStream() const
+        {
+            return Files::IStreamPtr(new std::istringstream(mData));
+        }
+    };
+
+    TEST_F(NifNIFFileTest, file_without_records_should_have_no_roots)
+    {
+        writeUInt(0);
+        writeUInt(0);
+        const Nif::NIFFile file(makeStream(), "test.nif");
+        EXPECT_EQ(file.numRecords(), 0u);
+        EXPECT_EQ(file.numRoots(), 0u);
+    }
+
+    TEST_F(NifNIFFileTest, truncated_file_should_throw)
+    {
+        writeUInt(1);
+        writeString("NiNode");
+        writeString("name");
+        EXPECT_THROW(Nif::NIFFile(makeStream(), "test.nif"), std::runtime_error);
+    }
+
+    TEST_F(NifNIFFileTest, unknown_record_type_should_throw)
+    {
+        writeUInt(1);
+        writeString("NiUnknownRecord");
+        EXPECT_THROW(Nif::NIFFile(makeStream(), "test.nif"), std::runtime_error);
+    }
+}
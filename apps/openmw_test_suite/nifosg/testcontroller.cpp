@@ -0,0 +1,62 @@
+#include <components/nifosg/controller.hpp>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    using namespace testing;
+    using namespace NifOsg;
+
+    std::shared_ptr<Nif::FloatKeyMap> makeFloatKeys(const std::vector<std::pair<float, float>>& keys)
+    {
+        auto result = std::make_shared<Nif::FloatKeyMap>();
+        for (const auto& key : keys)
+            result->mKeys[key.first].mValue = key.second;
+        return result;
+    }
+
+    TEST(NifOsgValueInterpolatorTest, without_keys_should_return_default_value)
+    {
+        const FloatInterpolator interpolator(std::make_shared<Nif::FloatKeyMap>(), 42.f);
+        EXPECT_TRUE(interpolator.empty());
+        EXPECT_EQ(interpolator.interpKey(1.f), 42.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, should_clamp_to_first_and_last_key)
+    {
+        const FloatInterpolator interpolator(makeFloatKeys({{1.f, 10.f}, {2.f, 20.f}}));
+        EXPECT_EQ(interpolator.interpKey(0.f), 10.f);
+        EXPECT_EQ(interpolator.interpKey(3.f), 20.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, sequential_and_random_sampling_should_give_same_values)
+    {
+        const auto keys = makeFloatKeys({{0.f, 0.f}, {1.f, 10.f}, {2.f, 30.f}, {4.f, 20.f}, {5.f, -10.f}});
+        const FloatInterpolator sequential(keys);
+        for (float time = -1.f; time < 6.f; time += 0.25f)
+        {
+            const FloatInterpolator fresh(keys);
+            EXPECT_FLOAT_EQ(sequential.interpKey(time), fresh.interpKey(time)) << time;
+        }
+        EXPECT_FLOAT_EQ(sequential.interpKey(1.5f), 20.f);
+        EXPECT_FLOAT_EQ(sequential.interpKey(0.5f), 5.f);
+        EXPECT_FLOAT_EQ(sequential.interpKey(3.f), 25.f);
+    }
+
+    TEST(NifOsgValueInterpolatorTest, quantized_rotations_should_be_close_to_original)
+    {
+        auto keys = std::make_shared<Nif::QuaternionKeyMap>();
+        const osg::Quat first(0.3, osg::Vec3f(0, 0, 1));
+        const osg::Quat second(1.2, osg::Vec3f(1, 0, 0));
+        keys->mKeys[0.f].mValue = first;
+        keys->mKeys[1.f].mValue = second;
+        const QuaternionInterpolator interpolator(keys);
+
+        osg::Quat expected;
+        expected.slerp(0.25, first, second);
+        const osg::Quat result = interpolator.interpKey(0.25f);
+        EXPECT_NEAR(result.length(), 1.0, 1e-6);
+        for (int i = 0; i < 4; ++i)
+            EXPECT_NEAR(result[i], expected[i], 1e-4);
+    }
+}
@@ -0,0 +1,46 @@
+#include <components/sceneutil/skeleton.hpp>
+
+#include <osg/MatrixTransform>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    using namespace testing;
+    using namespace SceneUtil;
+
+    struct SceneUtilSkeletonTest : Test
+    {
+        osg::ref_ptr<Skeleton> mSkeleton = new Skeleton;
+        osg::ref_ptr<osg::MatrixTransform> mParent = new osg::MatrixTransform;
+        osg::ref_ptr<osg::MatrixTransform> mChild = new osg::MatrixTransform;
+
+        SceneUtilSkeletonTest()
+        {
+            mParent->setName("Parent");
+            mChild->setName("Child");
+            mParent->addChild(mChild);
+            mSkeleton->addChild(mParent);
+        }
+    };
+
+    TEST_F(SceneUtilSkeletonTest, should_keep_version_while_bones_do_not_move)
+    {
+        ASSERT_NE(mSkeleton->getBone("child"), nullptr);
+        const unsigned int version = mSkeleton->updateBoneMatrices(1);
+        EXPECT_EQ(mSkeleton->updateBoneMatrices(2), version);
+    }
+
+    TEST_F(SceneUtilSkeletonTest, should_update_children_of_moved_bone)
+    {
+        Bone* child = mSkeleton->getBone("child");
+        ASSERT_NE(child, nullptr);
+        mChild->setMatrix(osg::Matrix::translate(0, 0, 1));
+        const unsigned int version = mSkeleton->updateBoneMatrices(1);
+        EXPECT_EQ(child->mMatrixInSkeletonSpace.getTrans(), osg::Vec3f(0, 0, 1));
+
+        mParent->setMatrix(osg::Matrix::translate(1, 0, 0));
+        EXPECT_NE(mSkeleton->updateBoneMatrices(2), version);
+        EXPECT_EQ(child->mMatrixInSkeletonSpace.getTrans(), osg::Vec3f(1, 0, 1));
+    }
+}
@@ -0,0 +1,44 @@
+#include <components/settings/settings.hpp>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    using namespace testing;
+    using namespace Settings;
+
+    struct SettingsSettingValueTest : Test
+    {
+        SettingsSettingValueTest()
+        {
+            Manager::clear();
+        }
+
+        ~SettingsSettingValueTest()
+        {
+            Manager::clear();
+        }
+    };
+
+    TEST_F(SettingsSettingValueTest, get_should_return_current_value)
+    {
+        Manager::setInt("setting", "Category", 13);
+        const SettingValue<int> value("setting", "Category");
+        EXPECT_EQ(value.get(), 13);
+    }
+
+    TEST_F(SettingsSettingValueTest, get_should_return_new_value_after_change)
+    {
+        Manager::setFloat("setting", "Category", 1.5f);
+        const SettingValue<float> value("setting", "Category");
+        EXPECT_EQ(value.get(), 1.5f);
+        Manager::setFloat("setting", "Category", 2.5f);
+        EXPECT_EQ(value.get(), 2.5f);
+    }
+
+    TEST_F(SettingsSettingValueTest, get_should_throw_for_missing_setting)
+    {
+        const SettingValue<bool> value("missing", "Category");
+        EXPECT_THROW(value.get(), std::runtime_error);
+    }
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <components/vfs/archive.hpp>
+#include <components/vfs/manager.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    using namespace testing;
+
+    struct TestFile : VFS::File
+    {
+        Files::IStreamPtr open() override
+        {
+            return Files::IStreamPtr();
+        }
+    };
+
+    struct TestArchive : VFS::Archive
+    {
+        std::vector<std::string> mNames;
+        std::vector<TestFile> mFiles;
+
+        TestArchive(const std::vector<std::string>& names)
+            : mNames(names)
+            , mFiles(names.size())
+        {
+        }
+
+        void listResources(std::map<std::string, VFS::File*>& out, char (*normalize_function) (char)) override
+        {
+            for (std::size_t i = 0; i < mNames.size(); ++i)
+            {
+                std::string name = mNames[i];
+                std::transform(name.begin(), name.end(), name.begin(), normalize_function);
+                out[name] = &mFiles[i];
+            }
+        }
+    };
+
+    struct ThrowingArchive : VFS::Archive
+    {
+        void listResources(std::map<std::string, VFS::File*>&, char (*) (char)) override
+        {
+            throw std::runtime_error("failed to list archive");
+        }
+    };
+
+    struct VFSManagerTest : Test
+    {
+        VFS::Manager mManager {false};
+
+        VFSManagerTest()
+        {
+            mManager.addArchive(new TestArchive({"Meshes\\a.nif", "meshes/b.nif", "Music/Explore/x.mp3", "textures/c.dds"}));
+            mManager.buildIndex();
+        }
+    };
+
+    TEST_F(VFSManagerTest, exists_should_normalize_name)
+    {
+        EXPECT_TRUE(mManager.exists("meshes/a.nif"));
+        EXPECT_TRUE(mManager.exists("MESHES\\B.NIF"));
+        EXPECT_FALSE(mManager.exists("meshes/c.nif"));
+        EXPECT_FALSE(mManager.exists("meshes"));
+    }
+
+    TEST_F(VFSManagerTest, exists_should_support_names_longer_than_lookup_buffer)
+    {
+        EXPECT_FALSE(mManager.exists(std::string(1000, 'a')));
+    }
+
+    TEST_F(VFSManagerTest, get_for_absent_file_should_throw)
+    {
+        EXPECT_THROW(mManager.get("meshes/c.nif"), std::runtime_error);
+        EXPECT_THROW(mManager.getNormalized("Meshes/a.nif"), std::runtime_error);
+    }
+
+    TEST_F(VFSManagerTest, index_should_be_sorted)
+    {
+        const VFS::Index& index = mManager.getIndex();
+        ASSERT_EQ(index.size(), 4u);
+        EXPECT_TRUE(std::is_sorted(index.begin(), index.end()));
+    }
+
+    TEST_F(VFSManagerTest, recursive_directory_iterator_should_list_files_below_path)
+    {
+        std::vector<std::string> names;
+        for (const std::string& name : mManager.getRecursiveDirectoryIterator("Meshes\\"))
+            names.push_back(name);
+        EXPECT_EQ(names, std::vector<std::string>({"meshes/a.nif", "meshes/b.nif"}));
+    }
+
+    TEST_F(VFSManagerTest, recursive_directory_iterator_for_empty_path_should_list_all_files)
+    {
+        std::size_t count = 0;
+        for (const std::string& name : mManager.getRecursiveDirectoryIterator(""))
+        {
+            static_cast<void>(name);
+            ++count;
+        }
+        EXPECT_EQ(count, 4u);
+    }
+
+    TEST(VFSManagerBuildIndexTest, should_rethrow_errors_of_archives)
+    {
+        VFS::Manager manager(false);
+        manager.addArchive(new TestArchive({"meshes/a.nif"}));
+        manager.addArchive(new ThrowingArchive);
+        manager.addArchive(new TestArchive({"meshes/b.nif"}));
+        EXPECT_THROW(manager.buildIndex(), std::runtime_error);
+    }
+}
@@ -0,0 +1,311 @@
+#include "compressor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <osg/Texture>
+#include <osg/Vec3f>
+#include <osg/Vec4ub>
+
+namespace
+{
+    /// Uncompressed RGBA texels of one mip level, in the row order of the source image.
+    struct Level
+    {
+        int mWidth;
+        int mHeight;
+        std::vector<osg::Vec4ub> mTexels;
+
+        const osg::Vec4ub& get(int x, int y) const
+        {
+            return mTexels[std::min(y, mHeight - 1) * mWidth + std::min(x, mWidth - 1)];
+        }
+    };
+
+    bool canRead(const osg::Image& image)
+    {
+        if (image.getDataType() != GL_UNSIGNED_BYTE)
+            return false;
+
+        switch (image.getPixelFormat())
+        {
+            case GL_RGB:
+            case GL_RGBA:
+            case GL_BGR:
+            case GL_BGRA:
+            case GL_LUMINANCE:
+            case GL_LUMINANCE_ALPHA:
+            case GL_ALPHA:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    Level readLevel(const osg::Image& image)
+    {
+        Level level;
+        level.mWidth = image.s();
+        level.mHeight = image.t();
+        level.mTexels.reserve(level.mWidth * level.mHeight);
+        for (int y = 0; y < level.mHeight; ++y)
+        {
+            for (int x = 0; x < level.mWidth; ++x)
+            {
+                const osg::Vec4f color = image.getColor(x, y);
+                level.mTexels.emplace_back(
+                    static_cast<unsigned char>(std::round(color.r() * 255.f)),
+                    static_cast<unsigned char>(std::round(color.g() * 255.f)),
+                    static_cast<unsigned char>(std::round(color.b() * 255.f)),
+                    static_cast<unsigned char>(std::round(color.a() * 255.f)));
+            }
+        }
+        return level;
+    }
+
+    /// Halve both dimensions, averaging each 2x2 texel group. Odd rows and columns at the edges are repeated.
+    Level downsample(const Level& source)
+    {
+        Level level;
+        level.mWidth = std::max(1, source.mWidth / 2);
+        level.mHeight = std::max(1, source.mHeight / 2);
+        level.mTexels.reserve(level.mWidth * level.mHeight);
+        for (int y = 0; y < level.mHeight; ++y)
+        {
+            for (int x = 0; x < level.mWidth; ++x)
+            {
+                unsigned int sum[4] = { 0, 0, 0, 0 };
+                for (int i = 0; i < 4; ++i)
+                {
+                    const osg::Vec4ub& texel = source.get(x * 2 + (i & 1), y * 2 + (i >> 1));
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += texel[c];
+                }
+                level.mTexels.emplace_back((sum[0] + 2) / 4, (sum[1] + 2) / 4, (sum[2] + 2) / 4, (sum[3] + 2) / 4);
+            }
+        }
+        return level;
+    }
+
+    std::uint16_t toRGB565(const osg::Vec3f& color)
+    {
+        const auto quantize = [] (float value, int max)
+        {
+            return static_cast<std::uint16_t>(std::round(std::min(std::max(value, 0.f), 255.f) * max / 255.f));
+        };
+        return static_cast<std::uint16_t>((quantize(color.x(), 31) << 11) | (quantize(color.y(), 63) << 5)
+            | quantize(color.z(), 31));
+    }
+
+    osg::Vec3f fromRGB565(std::uint16_t color)
+    {
+        const int r = (color >> 11) & 31;
+        const int g = (color >> 5) & 63;
+        const int b = color & 31;
+        return osg::Vec3f(static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)),
+                          static_cast<float>((b << 3) | (b >> 2)));
+    }
+
+    /// Fit the endpoints to the principal axis of the block's colors, found by power iteration.
+    void encodeColorBlock(const osg::Vec4ub (&texels)[16], unsigned char* out)
+    {
+        osg::Vec3f colors[16];
+        osg::Vec3f mean;
+        for (int i = 0; i < 16; ++i)
+        {
+            colors[i] = osg::Vec3f(texels[i].r(), texels[i].g(), texels[i].b());
+            mean += colors[i];
+        }
+        mean /= 16.f;
+
+        float covariance[6] = { 0, 0, 0, 0, 0, 0 };
+        for (const osg::Vec3f& color : colors)
+        {
+            const osg::Vec3f d = color - mean;
+            covariance[0] += d.x() * d.x();
+            covariance[1] += d.x() * d.y();
+            covariance[2] += d.x() * d.z();
+            covariance[3] += d.y() * d.y();
+            covariance[4] += d.y() * d.z();
+            covariance[5] += d.z() * d.z();
+        }
+
+        osg::Vec3f axis (1.f, 1.f, 1.f);
+        for (int i = 0; i < 8; ++i)
+        {
+            axis = osg::Vec3f(covariance[0] * axis.x() + covariance[1] * axis.y() + covariance[2] * axis.z(),
+                              covariance[1] * axis.x() + covariance[3] * axis.y() + covariance[4] * axis.z(),
+                              covariance[2] * axis.x() + covariance[4] * axis.y() + covariance[5] * axis.z());
+            if (axis.normalize() == 0.f)
+                break;
+        }
+
+        float minProjection = 0.f;
+        float maxProjection = 0.f;
+        for (const osg::Vec3f& color : colors)
+        {
+            const float projection = (color - mean) * axis;
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        std::uint16_t color0 = toRGB565(mean + axis * maxProjection);
+        std::uint16_t color1 = toRGB565(mean + axis * minProjection);
+        // The four color mode needs color0 > color1, equal endpoints only use index 0
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        std::uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            const osg::Vec3f endpoint0 = fromRGB565(color0);
+            const osg::Vec3f endpoint1 = fromRGB565(color1);
+            const osg::Vec3f palette[4] = {
+                endpoint0,
+                endpoint1,
+                (endpoint0 * 2.f + endpoint1) / 3.f,
+                (endpoint0 + endpoint1 * 2.f) / 3.f
+            };
+
+            for (int i = 0; i < 16; ++i)
+            {
+                std::uint32_t best = 0;
+                float bestDistance = (colors[i] - palette[0]).length2();
+                for (std::uint32_t j = 1; j < 4; ++j)
+                {
+                    const float distance = (colors[i] - palette[j]).length2();
+                    if (distance < bestDistance)
+                    {
+                        best = j;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= best << (i * 2);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(color0 & 0xff);
+        out[1] = static_cast<unsigned char>(color0 >> 8);
+        out[2] = static_cast<unsigned char>(color1 & 0xff);
+        out[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+    }
+
+    /// Eight value alpha block of DXT5, spanned by the smallest and largest alpha of the block.
+    void encodeAlphaBlock(const osg::Vec4ub (&texels)[16], unsigned char* out)
+    {
+        int alpha0 = 0;
+        int alpha1 = 255;
+        for (const osg::Vec4ub& texel : texels)
+        {
+            alpha0 = std::max(alpha0, static_cast<int>(texel.a()));
+            alpha1 = std::min(alpha1, static_cast<int>(texel.a()));
+        }
+
+        std::uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            int palette[8] = { alpha0, alpha1 };
+            for (int i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * alpha0 + (i - 1) * alpha1 + 3) / 7;
+
+            for (int i = 0; i < 16; ++i)
+            {
+                std::uint64_t best = 0;
+                int bestDistance = std::abs(texels[i].a() - palette[0]);
+                for (std::uint64_t j = 1; j < 8; ++j)
+                {
+                    const int distance = std::abs(texels[i].a() - palette[j]);
+                    if (distance < bestDistance)
+                    {
+                        best = j;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+
+        out[0] = static_cast<unsigned char>(alpha0);
+        out[1] = static_cast<unsigned char>(alpha1);
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+    }
+
+    void encodeLevel(const Level& level, bool alpha, unsigned char* out)
+    {
+        osg::Vec4ub texels[16];
+        for (int blockY = 0; blockY < level.mHeight; blockY += 4)
+        {
+            for (int blockX = 0; blockX < level.mWidth; blockX += 4)
+            {
+                // Blocks at the edges of levels smaller than 4 texels repeat the last row or column
+                for (int i = 0; i < 16; ++i)
+                    texels[i] = level.get(blockX + (i & 3), blockY + (i >> 2));
+
+                if (alpha)
+                {
+                    encodeAlphaBlock(texels, out);
+                    out += 8;
+                }
+                encodeColorBlock(texels, out);
+                out += 8;
+            }
+        }
+    }
+
+    std::size_t getCompressedSize(const Level& level, bool alpha)
+    {
+        return static_cast<std::size_t>((level.mWidth + 3) / 4) * ((level.mHeight + 3) / 4) * (alpha ? 16 : 8);
+    }
+}
+
+namespace TextureTool
+{
+
+    osg::ref_ptr<osg::Image> compressImage(const osg::Image& source)
+    {
+        if (source.isCompressed() || !canRead(source))
+            throw std::runtime_error("unsupported pixel format");
+
+        std::vector<Level> levels;
+        levels.push_back(readLevel(source));
+        while (levels.back().mWidth > 1 || levels.back().mHeight > 1)
+            levels.push_back(downsample(levels.back()));
+
+        const std::vector<osg::Vec4ub>& texels = levels.front().mTexels;
+        const bool alpha = std::any_of(texels.begin(), texels.end(),
+                                       [] (const osg::Vec4ub& texel) { return texel.a() != 255; });
+
+        std::size_t totalSize = 0;
+        osg::Image::MipmapDataType mipmapOffsets;
+        for (const Level& level : levels)
+        {
+            if (totalSize != 0)
+                mipmapOffsets.push_back(static_cast<unsigned int>(totalSize));
+            totalSize += getCompressedSize(level, alpha);
+        }
+
+        unsigned char* data = new unsigned char[totalSize];
+        unsigned char* out = data;
+        for (const Level& level : levels)
+        {
+            encodeLevel(level, alpha, out);
+            out += getCompressedSize(level, alpha);
+        }
+
+        const GLenum format = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        osg::ref_ptr<osg::Image> image (new osg::Image);
+        image->setImage(source.s(), source.t(), 1, format, format, GL_UNSIGNED_BYTE, data,
+                        osg::Image::USE_NEW_DELETE);
+        image->setMipmapLevels(mipmapOffsets);
+        image->setOrigin(source.getOrigin());
+        return image;
+    }
+
+}
@@ -0,0 +1,18 @@
+#ifndef OPENMW_TEXTURETOOL_COMPRESSOR_H
+#define OPENMW_TEXTURETOOL_COMPRESSOR_H
+
+#include <osg/Image>
+#include <osg/ref_ptr>
+
+namespace TextureTool
+{
+
+    /// Create a compressed copy of an uncompressed image, with a full chain of mip levels made by a box filter.
+    /// Opaque images are compressed to DXT1 (BC1), images with any translucent texel to DXT5 (BC3).
+    /// @note The rows are kept in the order of the source image, the origin is copied.
+    /// @throw std::runtime_error if the source pixel format can't be read.
+    osg::ref_ptr<osg::Image> compressImage(const osg::Image& source);
+
+}
+
+#endif
@@ -0,0 +1,199 @@
+///Program to compress the uncompressed textures of the game data ahead of time.
+///The result is a data directory of DXT compressed DDS files with mipmaps. As the engine prefers a DDS file over
+///the TGA or BMP file of the same name, adding it as the last data directory replaces the original textures.
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <osgDB/Registry>
+
+#include <components/vfs/manager.hpp>
+#include <components/vfs/bsaarchive.hpp>
+#include <components/vfs/filesystemarchive.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "compressor.hpp"
+
+#ifdef OSG_LIBRARY_STATIC
+USE_OSGPLUGIN(tga)
+USE_OSGPLUGIN(dds)
+USE_OSGPLUGIN(bmp)
+#endif
+
+// Create local aliases for brevity
+namespace bpo = boost::program_options;
+namespace bfs = boost::filesystem;
+
+struct Arguments
+{
+    std::vector<std::string> inputs;
+    std::string outdir;
+    bool force;
+};
+
+std::string getExtension(const std::string& filename)
+{
+    const std::size_t pos = filename.find_last_of('.');
+    if (pos == std::string::npos)
+        return std::string();
+    return filename.substr(pos + 1);
+}
+
+bool isBSA(const std::string& filename)
+{
+    std::string extension = getExtension(filename);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "bsa";
+}
+
+bool parseOptions (int argc, char** argv, Arguments& info)
+{
+    bpo::options_description desc("Compress the TGA and BMP textures of the game data to DDS files with mipmaps\n\n"
+        "Usages:\n"
+        "  openmw-texturetool [-f] -o output_directory <data directories or BSA files>\n"
+        "      Inputs are given in the order of the data= and fallback-archive= entries of openmw.cfg,\n"
+        "      later ones override earlier ones. Add the output directory as the last data= entry.\n\n"
+        "Allowed options");
+    desc.add_options()
+        ("help,h", "print help message.")
+        ("output,o", bpo::value<std::string>(), "directory to write the compressed textures to.")
+        ("force,f", "overwrite textures that were written before.")
+        ;
+
+    bpo::options_description hidden("Hidden Options");
+    hidden.add_options()
+        ("input-file", bpo::value< std::vector<std::string> >(), "input file")
+        ;
+
+    bpo::positional_options_description p;
+    p.add("input-file", -1);
+
+    bpo::options_description all;
+    all.add(desc).add(hidden);
+
+    bpo::variables_map variables;
+    try
+    {
+        bpo::parsed_options valid_opts = bpo::command_line_parser(argc, argv).
+            options(all).positional(p).run();
+        bpo::store(valid_opts, variables);
+        bpo::notify(variables);
+    }
+    catch(std::exception &e)
+    {
+        std::cout << "ERROR parsing arguments: " << e.what() << "\n\n"
+            << desc << std::endl;
+        return false;
+    }
+
+    if (variables.count ("help"))
+    {
+        std::cout << desc << std::endl;
+        return false;
+    }
+
+    if (!variables.count("input-file") || !variables.count("output"))
+    {
+        std::cout << "No input files or output directory specified!" << std::endl;
+        std::cout << desc << std::endl;
+        return false;
+    }
+
+    info.inputs = variables["input-file"].as< std::vector<std::string> >();
+    info.outdir = variables["output"].as<std::string>();
+    info.force = variables.count("force") != 0;
+    return true;
+}
+
+void compressTexture(const VFS::Manager& vfs, const std::string& name, const bfs::path& outputPath)
+{
+    osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(getExtension(name));
+    if (!reader)
+        throw std::runtime_error("no readerwriter for '" + getExtension(name) + "' found");
+
+    osgDB::ReaderWriter::ReadResult result = reader->readImage(*vfs.getNormalized(name));
+    if (!result.success())
+        throw std::runtime_error(result.message());
+
+    osg::ref_ptr<osg::Image> image = TextureTool::compressImage(*result.getImage());
+
+    osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension("dds");
+    if (!writer)
+        throw std::runtime_error("no readerwriter for 'dds' found");
+
+    bfs::create_directories(outputPath.parent_path());
+    bfs::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    // The writer flips images with a bottom left origin, so the files are read back the same as other DDS files
+    osgDB::ReaderWriter::WriteResult writeResult = writer->writeImage(*image, file);
+    if (!writeResult.success())
+        throw std::runtime_error(writeResult.message());
+    if (!file)
+        throw std::runtime_error("write error");
+}
+
+int main(int argc, char** argv)
+{
+    Arguments info;
+    if (!parseOptions(argc, argv, info))
+        return 1;
+
+    VFS::Manager vfs(false);
+    for (const std::string& input : info.inputs)
+    {
+        if (isBSA(input))
+            vfs.addArchive(new VFS::BsaArchive(input));
+        else if (bfs::is_directory(bfs::path(input)))
+            vfs.addArchive(new VFS::FileSystemArchive(input));
+        else
+        {
+            std::cerr << "ERROR:  \"" << input << "\" is not a bsa file or directory!" << std::endl;
+            return 1;
+        }
+    }
+    vfs.buildIndex();
+
+    int compressed = 0;
+    int skipped = 0;
+    int failed = 0;
+    for (const std::string& name : vfs.getRecursiveDirectoryIterator("textures/"))
+    {
+        const std::string extension = getExtension(name);
+        if (extension != "tga" && extension != "bmp")
+            continue;
+
+        // The engine already uses the DDS file of the same name
+        const std::string ddsName = name.substr(0, name.size() - extension.size()) + "dds";
+        if (vfs.exists(ddsName))
+            continue;
+
+        const bfs::path outputPath = bfs::path(info.outdir) / ddsName;
+        if (!info.force && bfs::exists(outputPath))
+        {
+            ++skipped;
+            continue;
+        }
+
+        try
+        {
+            compressTexture(vfs, name, outputPath);
+            ++compressed;
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "ERROR compressing \"" << name << "\": " << e.what() << std::endl;
+            boost::system::error_code ec;
+            bfs::remove(outputPath, ec);
+            ++failed;
+        }
+    }
+
+    std::cout << "Compressed " << compressed << " textures, skipped " << skipped << " written before, "
+        << failed << " failed." << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -23,14 +23,58 @@
 
 #include "bsa_file.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <components/debug/debuglog.hpp>
+#include <components/files/memorystream.hpp>
 
 using namespace std;
 using namespace Bsa;
 
+namespace
+{
+    /// Archive names are stored lower case with backslashes, fold lookups the same way
+    char foldChar(char c)
+    {
+        return c == '/' ? '\\' : Misc::StringUtils::toLower(c);
+    }
+
+    bool foldedEqual(const char *s1, const char *s2)
+    {
+        for (; *s1 != '\0' && *s2 != '\0'; ++s1, ++s2)
+            if (foldChar(*s1) != foldChar(*s2))
+                return false;
+        return *s1 == *s2;
+    }
+
+    /// A view into the archive mapping, keeping the mapping alive for as long as the stream exists
+    struct MappedRegionStream : virtual Files::MemBuf, Files::IMemStream
+    {
+        MappedRegionStream(std::shared_ptr<const boost::iostreams::mapped_file_source> mapping, size_t offset, size_t size)
+            : Files::MemBuf(mapping->data() + offset, size)
+            , Files::IMemStream(mapping->data() + offset, size)
+            , mMapping(std::move(mapping))
+        {
+        }
+
+        std::shared_ptr<const boost::iostreams::mapped_file_source> mMapping;
+    };
+
+    /// Spread the archive hash over the table slots, the TES3 hash itself is poorly distributed in its low bits
+    std::size_t getSlot(std::uint64_t hash, std::size_t mask)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return static_cast<std::size_t>(hash) & mask;
+    }
+}
+
 
 /// Error handling
 void BSAFile::fail(const string &msg)
@@ -62,7 +106,7 @@ void BSAFile::readHeader()
      *
      * ---------- end of directory block -------------
      *
-     * - 8*filenum - hash table block, we currently ignore this
+     * - 8*filenum - hash table block, two ints per file (see getHash)
      *
      * ----------- start of data buffer --------------
      *
@@ -123,13 +167,19 @@ void BSAFile::readHeader()
     // Check our position
     assert(input.tellg() == std::streampos(12+dirsize));
 
+    // Read the name hashes, they are checked against the names below
+    std::vector<uint32_t> hashes(2*filenum);
+    if (filenum > 0)
+        input.read(reinterpret_cast<char*>(&hashes[0]), 8*filenum);
+
     // Calculate the offset of the data buffer. All file offsets are
     // relative to this. 12 header bytes + directory + hash table
-    // (skipped)
     size_t fileDataOffset = 12 + dirsize + 8*filenum;
 
     // Set up the the FileStruct table
     mFiles.resize(filenum);
+    mHashes.resize(filenum);
+    size_t mismatchedHashes = 0;
     for(size_t i=0;i<filenum;i++)
     {
         FileStruct &fs = mFiles[i];
@@ -140,30 +190,132 @@ void BSAFile::readHeader()
         if(fs.offset + fs.fileSize > fsize)
             fail("Archive contains offsets outside itself");
 
-        // Add the file name to the lookup
-        mLookup[fs.name] = i;
+        // Lookups hash the requested name with getHash, so a stored hash written by a tool that computes
+        // it differently would make its file unreachable. Use the hash of the name in that case.
+        const std::uint64_t storedHash = (static_cast<std::uint64_t>(hashes[i*2+1]) << 32) | hashes[i*2];
+        mHashes[i] = getHash(fs.name);
+        if (mHashes[i] != storedHash)
+            ++mismatchedHashes;
     }
 
+    if (mismatchedHashes > 0)
+        Log(Debug::Warning) << "Archive " << mFilename << " has " << mismatchedHashes
+            << " file name hashes that do not match the names, using the hashes of the names";
+
+    buildLookup();
+
     mIsLoaded = true;
 }
 
+std::uint64_t BSAFile::getHash(const char *name)
+{
+    std::string folded = name;
+    std::transform(folded.begin(), folded.end(), folded.begin(), foldChar);
+
+    const size_t len = folded.size();
+    const size_t half = len / 2;
+    uint32_t low = 0;
+    uint32_t high = 0;
+    uint32_t off = 0;
+    size_t i = 0;
+
+    for (; i < half; ++i, off += 8)
+        low ^= static_cast<uint32_t>(static_cast<unsigned char>(folded[i])) << (off & 0x1F);
+
+    for (off = 0; i < len; ++i, off += 8)
+    {
+        uint32_t temp = static_cast<uint32_t>(static_cast<unsigned char>(folded[i])) << (off & 0x1F);
+        high ^= temp;
+        // Rotate right
+        uint32_t n = temp & 0x1F;
+        if (n != 0)
+            high = (high >> n) | (high << (32 - n));
+    }
+
+    return (static_cast<std::uint64_t>(high) << 32) | low;
+}
+
+void BSAFile::buildLookup()
+{
+    for (size_t i = mHashes.size(); i < mFiles.size(); ++i)
+        mHashes.push_back(getHash(mFiles[i].name));
+
+    // Keep the load factor at or below one half
+    size_t tableSize = 16;
+    while (tableSize < mFiles.size() * 2)
+        tableSize *= 2;
+
+    mHashTable.assign(tableSize, -1);
+    const size_t mask = tableSize - 1;
+    for (size_t i = 0; i < mFiles.size(); ++i)
+    {
+        size_t slot = getSlot(mHashes[i], mask);
+        while (mHashTable[slot] != -1)
+        {
+            // Later duplicates override earlier ones, the same way the old name map did
+            const int other = mHashTable[slot];
+            if (mHashes[other] == mHashes[i] && foldedEqual(mFiles[other].name, mFiles[i].name))
+                break;
+            slot = (slot + 1) & mask;
+        }
+        mHashTable[slot] = static_cast<int>(i);
+    }
+}
+
 /// Get the index of a given file name, or -1 if not found
 int BSAFile::getIndex(const char *str) const
 {
-    Lookup::const_iterator it = mLookup.find(str);
-    if(it == mLookup.end())
+    return getIndex(str, getHash(str));
+}
+
+int BSAFile::getIndex(const char *str, std::uint64_t hash) const
+{
+    if (mHashTable.empty())
         return -1;
 
-    int res = it->second;
-    assert(res >= 0 && (size_t)res < mFiles.size());
-    return res;
+    const size_t mask = mHashTable.size() - 1;
+    for (size_t slot = getSlot(hash, mask); mHashTable[slot] != -1; slot = (slot + 1) & mask)
+    {
+        int res = mHashTable[slot];
+        assert(res >= 0 && (size_t)res < mFiles.size());
+        if (mHashes[res] == hash && foldedEqual(mFiles[res].name, str))
+            return res;
+    }
+    return -1;
 }
 
 /// Open an archive file.
-void BSAFile::open(const string &file)
+void BSAFile::open(const string &file, bool memoryMapped)
 {
     mFilename = file;
+    mMapping.reset();
     readHeader();
+
+    if (!memoryMapped)
+        return;
+
+    try
+    {
+        auto mapping = std::make_shared<boost::iostreams::mapped_file_source>(mFilename);
+        if (mapping->is_open())
+            mMapping = std::move(mapping);
+    }
+    catch (const std::exception& e)
+    {
+        Log(Debug::Warning) << "Warning: failed to map BSA archive " << mFilename << " into memory, falling back to file reads: " << e.what();
+    }
+}
+
+Files::IStreamPtr BSAFile::openRegion(size_t offset, size_t size) const
+{
+    if (mMapping)
+    {
+        if (offset > mMapping->size() || size > mMapping->size() - offset)
+            throw std::runtime_error("BSA Error: Region outside of the archive\nArchive: " + mFilename);
+        return std::make_shared<MappedRegionStream>(mMapping, offset, size);
+    }
+
+    return Files::openConstrainedFileStream (mFilename.c_str (), offset, size);
 }
 
 Files::IStreamPtr BSAFile::getFile(const char *file)
@@ -175,10 +327,22 @@ Files::IStreamPtr BSAFile::getFile(const char *file)
 
     const FileStruct &fs = mFiles[i];
 
-    return Files::openConstrainedFileStream (mFilename.c_str (), fs.offset, fs.fileSize);
+    return openRegion(fs.offset, fs.fileSize);
+}
+
+Files::IStreamPtr BSAFile::getFile(const char *file, std::uint64_t hash)
+{
+    assert(file);
+    int i = getIndex(file, hash);
+    if(i == -1)
+        fail("File not found: " + string(file));
+
+    const FileStruct &fs = mFiles[i];
+
+    return openRegion(fs.offset, fs.fileSize);
 }
 
 Files::IStreamPtr BSAFile::getFile(const FileStruct *file)
 {
-    return Files::openConstrainedFileStream (mFilename.c_str (), file->offset, file->fileSize);
+    return openRegion(file->offset, file->fileSize);
 }
@@ -24,15 +24,21 @@
 #ifndef BSA_BSA_FILE_H
 #define BSA_BSA_FILE_H
 
-#include <stdint.h>
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <map>
 
 #include <components/misc/stringops.hpp>
 
 #include <components/files/constrainedfilestream.hpp>
 
+namespace boost
+{
+namespace iostreams
+{
+    class mapped_file_source;
+}
+}
 
 namespace Bsa
 {
@@ -69,19 +75,17 @@ protected:
     /// Used for error messages
     std::string mFilename;
 
-    /// Case insensitive string comparison
-    struct iltstr
-    {
-        bool operator()(const char *s1, const char *s2) const
-        { return Misc::StringUtils::ciLess(s1, s2); }
-    };
+    /// Read-only mapping of the whole archive, null unless opened memory mapped
+    std::shared_ptr<const boost::iostreams::mapped_file_source> mMapping;
+
+    /// Hashes of the file names, indexed like mFiles. See getHash().
+    std::vector<std::uint64_t> mHashes;
 
-    /** A map used for fast file name lookup. The value is the index into
-        the files[] vector above. The iltstr ensures that file name
-        checks are case insensitive.
+    /** Open addressing table used for fast file name lookup. Each slot holds
+        an index into the files[] vector above, or -1 when empty. The slot is
+        derived from the name hash, so the lookup is case insensitive.
     */
-    typedef std::map<const char*, int, iltstr> Lookup;
-    Lookup mLookup;
+    std::vector<int> mHashTable;
 
     /// Error handling
     void fail(const std::string &msg);
@@ -89,13 +93,21 @@ protected:
     /// Read header information from the input source
     virtual void readHeader();
 
-    /// Read header information from the input source
+    /// Open a region of the archive, as a view into the mapping when there is one
+    /// @note Thread safe.
+    Files::IStreamPtr openRegion(size_t offset, size_t size) const;
 
+    /// Build mHashTable from mFiles. Hashes missing from mHashes are computed from the file names.
+    void buildLookup();
 
     /// Get the index of a given file name, or -1 if not found
     /// @note Thread safe.
     int getIndex(const char *str) const;
 
+    /// Get the index of a given file name with a precomputed hash, or -1 if not found
+    /// @note Thread safe.
+    int getIndex(const char *str, std::uint64_t hash) const;
+
 public:
     /* -----------------------------------
      * BSA management methods
@@ -110,23 +122,43 @@ public:
     { }
 
     /// Open an archive file.
-    void open(const std::string &file);
+    /// @param memoryMapped Map the whole archive into memory, so that files are read
+    /// without any system calls. Falls back to regular reads if the mapping fails.
+    void open(const std::string &file, bool memoryMapped = false);
+
+    /// Is the archive mapped into memory?
+    bool isMemoryMapped() const
+    { return mMapping != nullptr; }
 
     /* -----------------------------------
      * Archive file routines
      * -----------------------------------
      */
 
+    /// Compute the hash of a file name the way TES3 archives store it in their header.
+    /// Case and slash direction are folded before hashing.
+    static std::uint64_t getHash(const char *name);
+
     /// Check if a file exists
     virtual bool exists(const char *file) const
     { return getIndex(file) != -1; }
 
+    /// Check if a file exists, using a hash precomputed with getHash()
+    bool exists(const char *file, std::uint64_t hash) const
+    { return getIndex(file, hash) != -1; }
+
     /** Open a file contained in the archive. Throws an exception if the
         file doesn't exist.
      * @note Thread safe.
     */
     virtual Files::IStreamPtr getFile(const char *file);
 
+    /** Open a file contained in the archive, using a hash precomputed with getHash().
+        Throws an exception if the file doesn't exist.
+     * @note Thread safe.
+    */
+    Files::IStreamPtr getFile(const char *file, std::uint64_t hash);
+
     /** Open a file contained in the archive.
      * @note Thread safe.
     */
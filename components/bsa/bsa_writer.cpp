@@ -0,0 +1,167 @@
+#include "bsa_writer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/misc/stringops.hpp>
+
+#include "bsa_file.hpp"
+
+namespace
+{
+    std::string foldName(const std::string& name)
+    {
+        std::string folded = name;
+        for (char& c : folded)
+            c = c == '/' ? '\\' : Misc::StringUtils::toLower(c);
+        return folded;
+    }
+
+    /// The hash table stores the low half of the hash first, and the game compares the halves in that order
+    bool hashLess(std::uint64_t left, std::uint64_t right)
+    {
+        const std::uint32_t leftLow = static_cast<std::uint32_t>(left);
+        const std::uint32_t rightLow = static_cast<std::uint32_t>(right);
+        if (leftLow != rightLow)
+            return leftLow < rightLow;
+        return (left >> 32) < (right >> 32);
+    }
+
+    void writeInt(std::ostream& stream, std::uint32_t value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    std::uint32_t checkedSize(std::uint64_t size)
+    {
+        if (size > std::numeric_limits<std::uint32_t>::max())
+            throw std::runtime_error("BSA Error: archive too large");
+        return static_cast<std::uint32_t>(size);
+    }
+}
+
+namespace Bsa
+{
+    void BSAWriter::addFile(const std::string& name, const boost::filesystem::path& source)
+    {
+        Entry entry;
+        entry.mName = foldName(name);
+        entry.mSource = source;
+        entry.mHash = BSAFile::getHash(entry.mName.c_str());
+        mEntries.push_back(entry);
+    }
+
+    void BSAWriter::setDataOrder(const std::vector<std::string>& names)
+    {
+        mDataOrder.clear();
+        for (const std::string& name : names)
+            mDataOrder.push_back(foldName(name));
+    }
+
+    void BSAWriter::save(const boost::filesystem::path& file) const
+    {
+        std::vector<const Entry*> entries;
+        entries.reserve(mEntries.size());
+        for (const Entry& entry : mEntries)
+            entries.push_back(&entry);
+
+        std::stable_sort(entries.begin(), entries.end(), [] (const Entry* left, const Entry* right)
+        {
+            if (left->mHash != right->mHash)
+                return hashLess(left->mHash, right->mHash);
+            return left->mName < right->mName;
+        });
+
+        std::unordered_map<std::string, std::size_t> indices;
+        for (std::size_t i = 0; i < entries.size(); ++i)
+            if (!indices.insert(std::make_pair(entries[i]->mName, i)).second)
+                throw std::runtime_error("BSA Error: file added twice: " + entries[i]->mName);
+
+        // Order of the file data, by index into the directory
+        std::vector<std::size_t> dataOrder;
+        std::vector<bool> ordered(entries.size(), false);
+        for (const std::string& name : mDataOrder)
+        {
+            auto found = indices.find(name);
+            if (found != indices.end() && !ordered[found->second])
+            {
+                ordered[found->second] = true;
+                dataOrder.push_back(found->second);
+            }
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i)
+            if (!ordered[i])
+                dataOrder.push_back(i);
+
+        std::vector<std::uint32_t> sizes(entries.size());
+        std::vector<std::uint32_t> offsets(entries.size());
+        std::uint64_t dataSize = 0;
+        for (std::size_t index : dataOrder)
+        {
+            sizes[index] = checkedSize(boost::filesystem::file_size(entries[index]->mSource));
+            offsets[index] = checkedSize(dataSize);
+            dataSize += sizes[index];
+        }
+
+        std::uint64_t namesSize = 0;
+        for (const Entry* entry : entries)
+            namesSize += entry->mName.size() + 1;
+
+        const std::uint32_t count = checkedSize(entries.size());
+        const std::uint32_t dirSize = checkedSize(12 * static_cast<std::uint64_t>(count) + namesSize);
+        checkedSize(12 + dirSize + 8 * static_cast<std::uint64_t>(count) + dataSize);
+
+        boost::filesystem::ofstream stream(file, std::ios::binary);
+        if (!stream.is_open())
+            throw std::runtime_error("BSA Error: failed to open " + file.string() + " for writing");
+
+        writeInt(stream, 0x100);
+        writeInt(stream, dirSize);
+        writeInt(stream, count);
+
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            writeInt(stream, sizes[i]);
+            writeInt(stream, offsets[i]);
+        }
+
+        std::uint32_t nameOffset = 0;
+        for (const Entry* entry : entries)
+        {
+            writeInt(stream, nameOffset);
+            nameOffset += static_cast<std::uint32_t>(entry->mName.size() + 1);
+        }
+
+        for (const Entry* entry : entries)
+            stream.write(entry->mName.c_str(), entry->mName.size() + 1);
+
+        for (const Entry* entry : entries)
+        {
+            writeInt(stream, static_cast<std::uint32_t>(entry->mHash));
+            writeInt(stream, static_cast<std::uint32_t>(entry->mHash >> 32));
+        }
+
+        for (std::size_t index : dataOrder)
+        {
+            boost::filesystem::ifstream source(entries[index]->mSource, std::ios::binary);
+            if (!source.is_open())
+                throw std::runtime_error("BSA Error: failed to open " + entries[index]->mSource.string());
+
+            if (sizes[index] > 0)
+                stream << source.rdbuf();
+
+            if (static_cast<std::uint64_t>(stream.tellp()) != 12 + dirSize + 8 * static_cast<std::uint64_t>(count)
+                + offsets[index] + sizes[index])
+                throw std::runtime_error("BSA Error: size of " + entries[index]->mSource.string() + " changed while saving");
+        }
+
+        stream.close();
+        if (!stream)
+            throw std::runtime_error("BSA Error: failed to write " + file.string());
+    }
+}
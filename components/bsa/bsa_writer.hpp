@@ -0,0 +1,45 @@
+#ifndef BSA_BSA_WRITER_H
+#define BSA_BSA_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+
+namespace Bsa
+{
+    /// @brief Writes TES3 archives, as read by BSAFile.
+    ///
+    /// The directory is sorted by the name hashes, like the archives of the original game, which look
+    /// files up by a binary search over the hashes. Unless an order is given, the file data is stored
+    /// in the same order.
+    class BSAWriter
+    {
+    public:
+        /// @param name Path of the file in the archive, it's stored lower case with backslashes
+        /// @param source File to read the data from when saving
+        void addFile(const std::string& name, const boost::filesystem::path& source);
+
+        /// Store the data of these files first and in the given order, e.g. so that the files used together
+        /// are next to each other. The data of the other files follows in the order of the directory.
+        /// @note Names that are not added to the archive are ignored.
+        void setDataOrder(const std::vector<std::string>& names);
+
+        /// @note Throws an exception if a name was added twice or the archive gets too large.
+        void save(const boost::filesystem::path& file) const;
+
+    private:
+        struct Entry
+        {
+            std::string mName;
+            boost::filesystem::path mSource;
+            std::uint64_t mHash;
+        };
+
+        std::vector<Entry> mEntries;
+        std::vector<std::string> mDataOrder;
+    };
+}
+
+#endif
@@ -267,7 +267,6 @@ void CompressedBSAFile::readHeader()
 
         mFiles[fileIndex].name = reinterpret_cast<char*>(mStringBuf.data() + mStringBuffOffset);
 
-        mLookup[reinterpret_cast<char*>(mStringBuf.data() + mStringBuffOffset)] = fileIndex;
         mStringBuffOffset += stringLength + 1u;
     }
 
@@ -275,6 +274,10 @@ void CompressedBSAFile::readHeader()
         fail("Could not resolve names of files in BSA file");
     }
 
+    // The TES4 name hashes use a different scheme, so the lookup computes its own hashes
+    mHashes.clear();
+    buildLookup();
+
     convertCompressedSizesToUncompressed();
     mIsLoaded = true;
 }
@@ -328,7 +331,7 @@ Files::IStreamPtr CompressedBSAFile::getFile(const char* file)
 Files::IStreamPtr CompressedBSAFile::getFile(const FileRecord& fileRecord)
 {
     if (fileRecord.isCompressed(mCompressedByDefault)) {
-        Files::IStreamPtr streamPtr = Files::openConstrainedFileStream(mFilename.c_str(), fileRecord.offset, fileRecord.getSizeWithoutCompressionFlag());
+        Files::IStreamPtr streamPtr = openRegion(fileRecord.offset, fileRecord.getSizeWithoutCompressionFlag());
 
         std::istream* fileStream = streamPtr.get();
 
@@ -352,7 +355,7 @@ Files::IStreamPtr CompressedBSAFile::getFile(const FileRecord& fileRecord)
         return std::shared_ptr<std::istream>(memoryStreamPtr, (std::istream*)memoryStreamPtr.get());
     }
 
-    return Files::openConstrainedFileStream(mFilename.c_str(), fileRecord.offset, fileRecord.size);
+    return openRegion(fileRecord.offset, fileRecord.size);
 }
 
 BsaVersion CompressedBSAFile::detectVersion(std::string filePath)
@@ -407,7 +410,7 @@ void CompressedBSAFile::convertCompressedSizesToUncompressed()
             continue;
         }
 
-        Files::IStreamPtr dataBegin = Files::openConstrainedFileStream(mFilename.c_str(), fileRecord.offset, fileRecord.getSizeWithoutCompressionFlag());
+        Files::IStreamPtr dataBegin = openRegion(fileRecord.offset, fileRecord.getSizeWithoutCompressionFlag());
 
         if (mEmbeddedFileNames)
         {
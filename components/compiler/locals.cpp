@@ -23,15 +23,25 @@ namespace Compiler
 
     int Locals::searchIndex (char type, const std::string& name) const
     {
+        std::unordered_map<std::string, std::pair<char, int> >::const_iterator iter =
+            mIndices.find (name);
+
+        if (iter==mIndices.end())
+            return -1;
+
+        if (iter->second.first==type)
+            return iter->second.second;
+
+        // The name is declared with several types, which is rare enough for a linear search
         const std::vector<std::string>& collection = get (type);
 
-        std::vector<std::string>::const_iterator iter =
+        std::vector<std::string>::const_iterator found =
             std::find (collection.begin(), collection.end(), name);
 
-        if (iter==collection.end())
+        if (found==collection.end())
             return -1;
 
-        return iter-collection.begin();
+        return found-collection.begin();
     }
 
     bool Locals::search (char type, const std::string& name) const
@@ -53,31 +63,24 @@ namespace Compiler
 
     char Locals::getType (const std::string& name) const
     {
-        if (search ('s', name))
-            return 's';
+        std::unordered_map<std::string, std::pair<char, int> >::const_iterator iter =
+            mIndices.find (name);
 
-        if (search ('l', name))
-            return 'l';
+        if (iter==mIndices.end())
+            return ' ';
 
-        if (search ('f', name))
-            return 'f';
-
-        return ' ';
+        return iter->second.first;
     }
 
     int Locals::getIndex (const std::string& name) const
     {
-        int index = searchIndex ('s', name);
-
-        if (index!=-1)
-            return index;
-
-        index = searchIndex ('l', name);
+        std::unordered_map<std::string, std::pair<char, int> >::const_iterator iter =
+            mIndices.find (name);
 
-        if (index!=-1)
-            return index;
+        if (iter==mIndices.end())
+            return -1;
 
-        return searchIndex ('f', name);
+        return iter->second.second;
     }
 
     void Locals::write (std::ostream& localFile) const
@@ -97,7 +100,22 @@ namespace Compiler
 
     void Locals::declare (char type, const std::string& name)
     {
-        get (type).push_back (Misc::StringUtils::lowerCase (name));
+        std::vector<std::string>& collection = get (type);
+        const std::string lowerCaseName = Misc::StringUtils::lowerCase (name);
+        const std::pair<char, int> index (type, static_cast<int> (collection.size()));
+
+        collection.push_back (lowerCaseName);
+
+        // Keep the first declaration of a name, preferring short over long over float like the lookups did
+        std::pair<std::unordered_map<std::string, std::pair<char, int> >::iterator, bool> inserted =
+            mIndices.insert (std::make_pair (lowerCaseName, index));
+
+        if (!inserted.second)
+        {
+            static const std::string order = "slf";
+            if (order.find (type) < order.find (inserted.first->second.first))
+                inserted.first->second = index;
+        }
     }
 
     void Locals::clear()
@@ -105,6 +123,7 @@ namespace Compiler
         get ('s').clear();
         get ('l').clear();
         get ('f').clear();
+        mIndices.clear();
     }
 }
 
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <iosfwd>
+#include <unordered_map>
+#include <utility>
 
 namespace Compiler
 {
@@ -14,6 +16,8 @@ namespace Compiler
             std::vector<std::string> mShorts;
             std::vector<std::string> mLongs;
             std::vector<std::string> mFloats;
+            std::unordered_map<std::string, std::pair<char, int> > mIndices;
+            ///< Type and index by name, so variables are found without comparing all names.
 
             std::vector<std::string>& get (char type);
 
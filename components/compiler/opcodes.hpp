@@ -302,6 +302,8 @@ namespace Compiler
         const int opcodeSetNavMeshNumberToRender = 0x200030a;
         const int opcodeRepairedOnMe = 0x200030c;
         const int opcodeRepairedOnMeExplicit = 0x200030d;
+        const int opcodeToggleTrace = 0x200030e;
+        const int opcodeMemStats = 0x200030f;
     }
 
     namespace Sky
@@ -30,7 +30,7 @@ namespace Compiler
         text << "line " << loc.mLine+1 << ", column " << loc.mColumn+1
              << " (" << loc.mLiteral << "): " << message;
 
-        Log(logLevel) << text.str();
+        log (logLevel, text.str());
     }
 
     // Report a file related error
@@ -53,7 +53,7 @@ namespace Compiler
 
         text << "file: " << message << std::endl;
 
-        Log(logLevel) << text.str();
+        log (logLevel, text.str());
     }
 
     void StreamErrorHandler::setContext(const std::string &context)
@@ -61,5 +61,25 @@ namespace Compiler
         mContext = context;
     }
 
-    StreamErrorHandler::StreamErrorHandler()  {}
+    void StreamErrorHandler::log (Debug::Level level, const std::string& message)
+    {
+        if (mBuffered)
+            mMessages.push_back (Message {level, message});
+        else
+            Log(level) << message;
+    }
+
+    void StreamErrorHandler::setBuffered (bool buffered)
+    {
+        mBuffered = buffered;
+    }
+
+    std::vector<StreamErrorHandler::Message> StreamErrorHandler::takeMessages()
+    {
+        std::vector<Message> messages;
+        messages.swap (mMessages);
+        return messages;
+    }
+
+    StreamErrorHandler::StreamErrorHandler() : mBuffered (false) {}
 }
@@ -2,6 +2,9 @@
 #define COMPILER_STREAMERRORHANDLER_H_INCLUDED
 
 #include <ostream>
+#include <vector>
+
+#include <components/debug/debuglog.hpp>
 
 #include "errorhandler.hpp"
 
@@ -11,7 +14,19 @@ namespace Compiler
 
     class StreamErrorHandler : public ErrorHandler
     {
+        public:
+
+            struct Message
+            {
+                Debug::Level mLevel;
+                std::string mText;
+            };
+
+        private:
+
             std::string mContext;
+            bool mBuffered;
+            std::vector<Message> mMessages;
 
         // not implemented
 
@@ -28,6 +43,16 @@ namespace Compiler
 
             void setContext(const std::string& context);
 
+            void log (Debug::Level level, const std::string& message);
+            ///< Write a message not related to a source location, e.g. about a failed script.
+
+            void setBuffered (bool buffered);
+            ///< Keep messages instead of writing them, so scripts compiled in parallel can be
+            /// reported in order.
+
+            std::vector<Message> takeMessages();
+            ///< Return messages kept since the last call.
+
         // constructors
 
             StreamErrorHandler ();
@@ -1,9 +1,14 @@
 #include "contentmodel.hpp"
 #include "esmfile.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <QDir>
+#include <QFileInfo>
 #include <QTextCodec>
 #include <QDebug>
 
@@ -417,6 +422,31 @@ void ContentSelectorModel::ContentModel::addFile(EsmFile *file)
     emit dataChanged (idx, idx);
 }
 
+ContentSelectorModel::ContentModel::FileHeader ContentSelectorModel::ContentModel::readHeader(const QFileInfo &info,
+    const QString &encoding)
+{
+    ESM::ESMReader fileReader;
+    ToUTF8::Utf8Encoder encoder =
+    ToUTF8::calculateEncoding(encoding.toStdString());
+    fileReader.setEncoder(&encoder);
+    fileReader.open(std::string(info.absoluteFilePath().toUtf8().constData()));
+
+    FileHeader header;
+    header.mSize = info.size();
+    header.mModified = info.lastModified();
+    header.mEncoding = encoding;
+
+    for (std::vector<ESM::Header::MasterData>::const_iterator itemIter = fileReader.getGameFiles().begin();
+        itemIter != fileReader.getGameFiles().end(); ++itemIter)
+        header.mGameFiles.append(QString::fromUtf8(itemIter->name.c_str()));
+
+    header.mAuthor = QString::fromUtf8(fileReader.getAuthor().c_str());
+    header.mFormat = fileReader.getFormat();
+    header.mDescription = QString::fromUtf8(fileReader.getDesc().c_str());
+
+    return header;
+}
+
 void ContentSelectorModel::ContentModel::addFiles(const QString &path)
 {
     QDir dir(path);
@@ -424,6 +454,7 @@ void ContentSelectorModel::ContentModel::addFiles(const QString &path)
     filters << "*.esp" << "*.esm" << "*.omwgame" << "*.omwaddon";
     dir.setNameFilters(filters);
 
+    std::vector<QFileInfo> infos;
     for (const QString &path2 : dir.entryList())
     {
         QFileInfo info(dir.absoluteFilePath(path2));
@@ -431,42 +462,82 @@ void ContentSelectorModel::ContentModel::addFiles(const QString &path)
         if (item(info.fileName()))
             continue;
 
-        try {
-            ESM::ESMReader fileReader;
-            ToUTF8::Utf8Encoder encoder =
-            ToUTF8::calculateEncoding(mEncoding.toStdString());
-            fileReader.setEncoder(&encoder);
-            fileReader.open(std::string(dir.absoluteFilePath(path2).toUtf8().constData()));
-
-            EsmFile *file = new EsmFile(path2);
-         
-            for (std::vector<ESM::Header::MasterData>::const_iterator itemIter = fileReader.getGameFiles().begin();
-                itemIter != fileReader.getGameFiles().end(); ++itemIter)
-                file->addGameFile(QString::fromUtf8(itemIter->name.c_str()));
-
-            file->setAuthor     (QString::fromUtf8(fileReader.getAuthor().c_str()));
-            file->setDate       (info.lastModified());
-            file->setFormat     (fileReader.getFormat());
-            file->setFilePath       (info.absoluteFilePath());
-            file->setDescription(QString::fromUtf8(fileReader.getDesc().c_str()));
-
-            // HACK
-            // Load order constraint of Bloodmoon.esm needing Tribunal.esm is missing
-            // from the file supplied by Bethesda, so we have to add it ourselves
-            if (file->fileName().compare("Bloodmoon.esm", Qt::CaseInsensitive) == 0)
-            {
-                file->addGameFile(QString::fromUtf8("Tribunal.esm"));
+        infos.push_back(info);
+    }
+
+    // Read the headers of new and changed files, each in its own reader since there can be thousands of them
+    std::vector<std::size_t> toRead;
+    for (std::size_t i = 0; i < infos.size(); ++i)
+    {
+        const auto cached = mHeaders.constFind(infos[i].absoluteFilePath());
+        if (cached == mHeaders.constEnd() || cached->mSize != infos[i].size()
+                || cached->mModified != infos[i].lastModified() || cached->mEncoding != mEncoding)
+            toRead.push_back(i);
+    }
+
+    std::vector<FileHeader> headers(toRead.size());
+    std::vector<std::string> errors(toRead.size());
+    std::atomic<std::size_t> next(0);
+    const auto readHeaders = [&]
+    {
+        for (std::size_t i = next++; i < toRead.size(); i = next++)
+        {
+            try {
+                headers[i] = readHeader(infos[toRead[i]], mEncoding);
+            } catch(std::runtime_error &e) {
+                errors[i] = e.what();
             }
+        }
+    };
 
-            // Put the file in the table
-            addFile(file);
+    const std::size_t threadsCount = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), toRead.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threadsCount; ++i)
+        threads.emplace_back(readHeaders);
+    readHeaders();
+    for (std::thread &thread : threads)
+        thread.join();
 
-        } catch(std::runtime_error &e) {
+    for (std::size_t i = 0; i < toRead.size(); ++i)
+    {
+        const QString filePath = infos[toRead[i]].absoluteFilePath();
+        if (errors[i].empty())
+            mHeaders.insert(filePath, headers[i]);
+        else
+        {
+            mHeaders.remove(filePath);
             // An error occurred while reading the .esp
-            qWarning() << "Error reading addon file: " << e.what();
+            qWarning() << "Error reading addon file: " << errors[i].c_str();
+        }
+    }
+
+    for (const QFileInfo &info : infos)
+    {
+        const auto header = mHeaders.constFind(info.absoluteFilePath());
+        if (header == mHeaders.constEnd())
             continue;
+
+        EsmFile *file = new EsmFile(info.fileName());
+
+        for (const QString &gameFile : header->mGameFiles)
+            file->addGameFile(gameFile);
+
+        file->setAuthor     (header->mAuthor);
+        file->setDate       (info.lastModified());
+        file->setFormat     (header->mFormat);
+        file->setFilePath       (info.absoluteFilePath());
+        file->setDescription(header->mDescription);
+
+        // HACK
+        // Load order constraint of Bloodmoon.esm needing Tribunal.esm is missing
+        // from the file supplied by Bethesda, so we have to add it ourselves
+        if (file->fileName().compare("Bloodmoon.esm", Qt::CaseInsensitive) == 0)
+        {
+            file->addGameFile(QString::fromUtf8("Tribunal.esm"));
         }
 
+        // Put the file in the table
+        addFile(file);
     }
 
     sortFiles();
@@ -2,11 +2,14 @@
 #define CONTENTMODEL_HPP
 
 #include <QAbstractTableModel>
+#include <QDateTime>
 #include <QStringList>
 #include <QSet>
 #include <QIcon>
 #include "loadordererror.hpp"
 
+class QFileInfo;
+
 namespace ContentSelectorModel
 {
     class EsmFile;
@@ -79,7 +82,24 @@ namespace ContentSelectorModel
 
         QString toolTip(const EsmFile *file) const;
 
+        /// Header of a content file as read by ESM::ESMReader
+        struct FileHeader
+        {
+            qint64 mSize;
+            QDateTime mModified;
+            QString mEncoding;
+            QStringList mGameFiles;
+            QString mAuthor;
+            int mFormat;
+            QString mDescription;
+        };
+
+        /// Reads the header of the given file, throws std::runtime_error when it can't be read
+        static FileHeader readHeader(const QFileInfo &info, const QString &encoding);
+
         ContentFileList mFiles;
+        /// Headers of all files read so far by absolute path, used again while the files are not changed
+        QHash<QString, FileHeader> mHeaders;
         QHash<QString, Qt::CheckState> mCheckStates;
         QSet<QString> mPluginsWithLoadOrderError;
         QString mEncoding;
@@ -243,6 +243,9 @@ static void crash_catcher(int signum, siginfo_t *siginfo, void *context)
         return;
     }
 
+    // The last messages before the crash may still wait for the log writer thread
+    Debug::flushLogOnCrash();
+
     safe_write(STDERR_FILENO, fatal_err, sizeof(fatal_err)-1);
     if(pipe(fd) == -1)
     {
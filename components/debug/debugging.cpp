@@ -109,6 +109,7 @@ int wrapApplication(int (*innerApplication)(int argc, char *argv[]), int argc, c
     const std::string logName = Misc::StringUtils::lowerCase(appName) + ".log";
     const std::string crashLogName = Misc::StringUtils::lowerCase(appName) + "-crash.log";
     boost::filesystem::ofstream logfile;
+    std::unique_ptr<Debug::AsyncLogWriter> logWriter;
 
     int ret = 0;
     try
@@ -131,6 +132,9 @@ int wrapApplication(int (*innerApplication)(int argc, char *argv[]), int argc, c
         std::cerr.rdbuf (&cerrsb);
 #endif
 
+        // Write the log from a background thread, so that logging doesn't wait for the file and the console
+        logWriter.reset(new Debug::AsyncLogWriter);
+
         // install the crash handler as soon as possible. note that the log path
         // does not depend on config being read.
         crashCatcherInstall(argc, argv, (cfgMgr.getLogPath() / crashLogName).string());
@@ -149,6 +153,9 @@ int wrapApplication(int (*innerApplication)(int argc, char *argv[]), int argc, c
         ret = 1;
     }
 
+    // Write the remaining messages while the streams are still redirected
+    logWriter.reset();
+
     // Restore cout and cerr
     std::cout.rdbuf(cout_rdbuf);
     std::cerr.rdbuf(cerr_rdbuf);
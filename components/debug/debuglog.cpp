@@ -1,8 +1,290 @@
 #include "debuglog.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <string>
+#include <thread>
+
 namespace Debug
 {
     Level CurrentDebugLevel = Level::NoLevel;
 }
 
-std::mutex Log::sLock;
+namespace
+{
+    // Enough for bursts of warnings while loading, later messages are dropped instead of using more memory
+    constexpr std::size_t sMaxPendingMessages = 1 << 16;
+
+    struct Message
+    {
+        std::string mText;
+        Message* mNext;
+    };
+
+    struct ThreadBuffer
+    {
+        std::ostringstream mStream;
+        std::ios_base::fmtflags mFlags;
+        bool mInUse;
+
+        ThreadBuffer()
+            : mFlags(mStream.flags())
+            , mInUse(false)
+        {
+        }
+
+        void reset()
+        {
+            mStream.str(std::string());
+            mStream.clear();
+            mStream.flags(mFlags);
+            mStream.precision(6);
+            mStream.fill(' ');
+            mStream.width(0);
+        }
+    };
+
+    struct State
+    {
+        // Serializes the output of the writer thread and of messages written without a writer
+        std::mutex mOutputMutex;
+
+        // Pushed by any thread without locking, in reverse order
+        std::atomic<Message*> mPending {nullptr};
+        std::atomic<std::size_t> mNumPending {0};
+        std::atomic<std::size_t> mNumDropped {0};
+        std::atomic<bool> mAsync {false};
+        std::atomic<unsigned int> mNumPushing {0};
+
+        std::mutex mWakeMutex;
+        std::condition_variable mWake;
+        bool mStop = false;
+        std::thread mThread;
+
+        // Only used by the writer thread
+        std::string mLastMessage;
+        std::size_t mNumRepeats = 0;
+    };
+
+    State& getState()
+    {
+        // Never destroyed, messages may be logged while static objects are destroyed
+        static State* const state = new State;
+        return *state;
+    }
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        thread_local ThreadBuffer buffer;
+        return buffer;
+    }
+
+    std::string getMarker(const std::string& message)
+    {
+        if (!message.empty() && static_cast<unsigned char>(message[0]) <= static_cast<unsigned char>(Debug::Marker))
+            return message.substr(0, 1);
+        return std::string();
+    }
+
+    bool push(State& state, std::string&& message)
+    {
+        // Counted so that the writer is only stopped once no thread is about to push a message
+        ++state.mNumPushing;
+        if (!state.mAsync)
+        {
+            --state.mNumPushing;
+            return false;
+        }
+
+        if (state.mNumPending.fetch_add(1) >= sMaxPendingMessages)
+        {
+            --state.mNumPending;
+            ++state.mNumDropped;
+        }
+        else
+        {
+            Message* pending = new Message {std::move(message), state.mPending.load(std::memory_order_relaxed)};
+            while (!state.mPending.compare_exchange_weak(pending->mNext, pending,
+                    std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        --state.mNumPushing;
+        state.mWake.notify_one();
+        return true;
+    }
+
+    void writeRepeats(State& state)
+    {
+        if (state.mNumRepeats == 0)
+            return;
+        std::cout << getMarker(state.mLastMessage) << "Last message repeated " << state.mNumRepeats << " times"
+            << std::endl;
+        state.mNumRepeats = 0;
+    }
+
+    // Requires the output mutex. Taking the pending messages with it keeps batches of different threads in order.
+    void writePendingUnsafe(State& state)
+    {
+        Message* pending = state.mPending.exchange(nullptr, std::memory_order_acquire);
+
+        Message* ordered = nullptr;
+        while (pending != nullptr)
+        {
+            Message* next = pending->mNext;
+            pending->mNext = ordered;
+            ordered = pending;
+            pending = next;
+        }
+
+        while (ordered != nullptr)
+        {
+            const std::unique_ptr<Message> message(ordered);
+            ordered = message->mNext;
+            --state.mNumPending;
+
+            if (message->mText == state.mLastMessage)
+            {
+                ++state.mNumRepeats;
+                continue;
+            }
+
+            writeRepeats(state);
+            // Each message is written separately, the output sinks expect the level marker at the start of a write
+            std::cout << message->mText << std::endl;
+            state.mLastMessage = std::move(message->mText);
+        }
+
+        // Repetitions are reported once per batch, so a message logged every frame is still visible
+        writeRepeats(state);
+
+        if (const std::size_t dropped = state.mNumDropped.exchange(0))
+        {
+            std::string marker;
+            if (Debug::CurrentDebugLevel != Debug::NoLevel)
+                marker = static_cast<char>(Debug::Warning);
+            std::cout << marker << "Too many pending log messages, " << dropped << " were dropped" << std::endl;
+        }
+    }
+
+    void writePending(State& state)
+    {
+        const std::lock_guard<std::mutex> lock(state.mOutputMutex);
+        writePendingUnsafe(state);
+    }
+
+    void run(State& state)
+    {
+        while (true)
+        {
+            bool stop = false;
+            {
+                std::unique_lock<std::mutex> lock(state.mWakeMutex);
+                // Messages are pushed without the lock, so a notification may come too early and be missed
+                state.mWake.wait_for(lock, std::chrono::milliseconds(100), [&] {
+                    return state.mStop || state.mPending.load(std::memory_order_relaxed) != nullptr;
+                });
+                stop = state.mStop;
+            }
+
+            writePending(state);
+
+            if (stop)
+                return;
+        }
+    }
+}
+
+namespace Debug
+{
+    AsyncLogWriter::AsyncLogWriter()
+    {
+        State& state = getState();
+        state.mStop = false;
+        state.mThread = std::thread([&state] { run(state); });
+        state.mAsync = true;
+    }
+
+    AsyncLogWriter::~AsyncLogWriter()
+    {
+        State& state = getState();
+        state.mAsync = false;
+        while (state.mNumPushing != 0)
+            std::this_thread::yield();
+
+        {
+            const std::lock_guard<std::mutex> lock(state.mWakeMutex);
+            state.mStop = true;
+        }
+        state.mWake.notify_one();
+        state.mThread.join();
+    }
+
+    void writeLog(Level level, std::string&& message)
+    {
+        State& state = getState();
+        if (level != Error && push(state, std::move(message)))
+            return;
+
+        const std::lock_guard<std::mutex> lock(state.mOutputMutex);
+        writePendingUnsafe(state);
+        std::cout << message << std::endl;
+    }
+
+    void flushLogOnCrash()
+    {
+        State& state = getState();
+        state.mAsync = false;
+
+        std::unique_lock<std::mutex> lock(state.mOutputMutex, std::defer_lock);
+        for (int i = 0; i < 100 && !lock.try_lock(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        writePendingUnsafe(state);
+        std::cout.flush();
+    }
+}
+
+Log::Log(Debug::Level level)
+    : mLevel(level)
+    , mStream(nullptr)
+{
+    if (level > Debug::CurrentDebugLevel)
+        return;
+
+    ThreadBuffer& buffer = getThreadBuffer();
+    if (buffer.mInUse)
+    {
+        mNestedStream.reset(new std::ostringstream);
+        mStream = mNestedStream.get();
+    }
+    else
+    {
+        buffer.mInUse = true;
+        mStream = &buffer.mStream;
+    }
+
+    // If the app has no logging system enabled, log level is not specified.
+    // Show all messages without marker - we just use the plain cout in this case.
+    if (Debug::CurrentDebugLevel != Debug::NoLevel)
+        *mStream << static_cast<unsigned char>(level);
+}
+
+Log::~Log()
+{
+    if (mStream == nullptr)
+        return;
+
+    std::string message = mStream->str();
+
+    if (!mNestedStream)
+    {
+        ThreadBuffer& buffer = getThreadBuffer();
+        buffer.reset();
+        buffer.mInUse = false;
+    }
+
+    Debug::writeLog(mLevel, std::move(message));
+}
@@ -1,8 +1,10 @@
 #ifndef DEBUG_LOG_H
 #define DEBUG_LOG_H
 
-#include <mutex>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 
 #include <osg/io_utils>
 
@@ -21,46 +23,62 @@ namespace Debug
     };
 
     extern Level CurrentDebugLevel;
+
+    /// @brief Writes the messages of Log to std::cout in a background thread while it exists, so that logging never
+    /// waits for the output streams or for other threads writing messages.
+    /// @par Consecutive repetitions of a message are written once, followed by their count. When too many messages
+    /// are pending, new ones are dropped and the number of dropped messages is written instead.
+    /// @par Errors are written immediately by the thread logging them, after the pending messages, so they are not
+    /// lost if the application terminates right after.
+    /// @note Without a writer messages are written immediately. At most one writer may exist at a time, it must be
+    /// destroyed before the stream buffer of std::cout.
+    class AsyncLogWriter
+    {
+    public:
+        AsyncLogWriter();
+
+        /// Write the pending messages and stop the thread.
+        ~AsyncLogWriter();
+
+    private:
+        AsyncLogWriter(const AsyncLogWriter&);
+        void operator=(const AsyncLogWriter&);
+    };
+
+    /// Write a complete message, starting with its level marker unless the level is NoLevel.
+    void writeLog(Level level, std::string&& message);
+
+    /// Write the pending messages of the AsyncLogWriter from a crash handler. Does not wait for other threads
+    /// longer than a short time, since the crashed one may hold the output lock.
+    void flushLogOnCrash();
 }
 
 class Log
 {
-    static std::mutex sLock;
-
-    std::unique_lock<std::mutex> mLock;
 public:
-    // Locks a global lock while the object is alive
-    Log(Debug::Level level) :
-    mLock(sLock),
-    mLevel(level)
-    {
-        // If the app has no logging system enabled, log level is not specified.
-        // Show all messages without marker - we just use the plain cout in this case.
-        if (Debug::CurrentDebugLevel == Debug::NoLevel)
-            return;
-
-        if (mLevel <= Debug::CurrentDebugLevel)
-            std::cout << static_cast<unsigned char>(mLevel);
-    }
+    // Formats the message into a buffer of the calling thread, it's written when the object is destroyed
+    Log(Debug::Level level);
 
-    // Perfect forwarding wrappers to give the chain of objects to cout
+    // Perfect forwarding wrappers to give the chain of objects to the buffer
     template<typename T>
     Log& operator<<(T&& rhs)
     {
-        if (mLevel <= Debug::CurrentDebugLevel)
-            std::cout << std::forward<T>(rhs);
+        if (mStream != nullptr)
+            *mStream << std::forward<T>(rhs);
 
         return *this;
     }
 
-    ~Log()
-    {
-        if (mLevel <= Debug::CurrentDebugLevel)
-            std::cout << std::endl;
-    }
+    ~Log();
 
 private:
     Debug::Level mLevel;
+    std::ostringstream* mStream;
+    // Used by a message that is logged while formatting another one in the same thread
+    std::unique_ptr<std::ostringstream> mNestedStream;
+
+    Log(const Log&);
+    void operator=(const Log&);
 };
 
 #endif
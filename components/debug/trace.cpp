@@ -0,0 +1,173 @@
+#include "trace.hpp"
+
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // Per thread, enough for a few seconds of zones
+    constexpr std::size_t sCapacity = 1 << 16;
+
+    struct Zone
+    {
+        const char* mName;
+        Debug::Trace::Clock::time_point mStart;
+        Debug::Trace::Clock::time_point mEnd;
+    };
+
+    /// Locked by its thread for each zone and by the writer, so hardly ever contended
+    struct ThreadBuffer
+    {
+        std::mutex mMutex;
+        std::size_t mId;
+        std::string mName;
+        std::vector<Zone> mZones;
+        std::size_t mNext = 0;
+        std::size_t mGeneration = 0;
+    };
+
+    struct State
+    {
+        std::mutex mMutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+        Debug::Trace::Clock::time_point mStart = Debug::Trace::Clock::now();
+        std::atomic<std::size_t> mGeneration {0};
+    };
+
+    State& getState()
+    {
+        // Never destroyed, threads may record zones while static objects are destroyed
+        static State* const state = new State;
+        return *state;
+    }
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        // Shared with the state, so the zones of finished threads can still be written
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer)
+        {
+            buffer = std::make_shared<ThreadBuffer>();
+            State& state = getState();
+            const std::lock_guard<std::mutex> lock(state.mMutex);
+            buffer->mId = state.mBuffers.size() + 1;
+            buffer->mName = "Thread " + std::to_string(buffer->mId);
+            buffer->mGeneration = state.mGeneration;
+            state.mBuffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void writeString(std::ostream& stream, const std::string& value)
+    {
+        stream << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                stream << '\\' << c;
+            else if (static_cast<unsigned char>(c) >= 0x20)
+                stream << c;
+        }
+        stream << '"';
+    }
+}
+
+namespace Debug
+{
+    std::atomic<bool> Trace::sEnabled(false);
+
+    void Trace::setEnabled(bool enabled)
+    {
+        State& state = getState();
+        const std::lock_guard<std::mutex> lock(state.mMutex);
+        if (enabled && !isEnabled())
+        {
+            // Buffers are cleared by their threads when they see the new generation
+            ++state.mGeneration;
+            state.mStart = Clock::now();
+        }
+        sEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void Trace::setThreadName(const std::string& name)
+    {
+        ThreadBuffer& buffer = getThreadBuffer();
+        const std::lock_guard<std::mutex> lock(buffer.mMutex);
+        buffer.mName = name;
+    }
+
+    void Trace::record(const char* name, Clock::time_point start, Clock::time_point end)
+    {
+        ThreadBuffer& buffer = getThreadBuffer();
+        const std::size_t generation = getState().mGeneration.load(std::memory_order_relaxed);
+        const std::lock_guard<std::mutex> lock(buffer.mMutex);
+        if (buffer.mGeneration != generation)
+        {
+            buffer.mZones.clear();
+            buffer.mNext = 0;
+            buffer.mGeneration = generation;
+        }
+        if (buffer.mZones.size() < sCapacity)
+            buffer.mZones.push_back(Zone {name, start, end});
+        else
+            buffer.mZones[buffer.mNext] = Zone {name, start, end};
+        buffer.mNext = (buffer.mNext + 1) % sCapacity;
+    }
+
+    void Trace::write(std::ostream& stream)
+    {
+        State& state = getState();
+        const std::lock_guard<std::mutex> lock(state.mMutex);
+
+        stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+        bool first = true;
+        for (const auto& buffer : state.mBuffers)
+        {
+            const std::lock_guard<std::mutex> bufferLock(buffer->mMutex);
+
+            if (!first)
+                stream << ',';
+            first = false;
+            stream << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->mId << ",\"args\":{\"name\":";
+            writeString(stream, buffer->mName);
+            stream << "}}";
+
+            if (buffer->mGeneration != state.mGeneration)
+                continue;
+
+            for (const Zone& zone : buffer->mZones)
+            {
+                if (zone.mStart < state.mStart)
+                    continue;
+                stream << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->mId << ",\"name\":";
+                writeString(stream, zone.mName);
+                stream << ",\"ts\":" << std::chrono::duration<double, std::micro>(zone.mStart - state.mStart).count()
+                       << ",\"dur\":" << std::chrono::duration<double, std::micro>(zone.mEnd - zone.mStart).count()
+                       << '}';
+            }
+        }
+        stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    void Trace::getZones(Clock::time_point begin, std::vector<RecordedZone>& zones)
+    {
+        State& state = getState();
+        const std::lock_guard<std::mutex> lock(state.mMutex);
+
+        for (const auto& buffer : state.mBuffers)
+        {
+            const std::lock_guard<std::mutex> bufferLock(buffer->mMutex);
+
+            if (buffer->mGeneration != state.mGeneration)
+                continue;
+
+            for (const Zone& zone : buffer->mZones)
+            {
+                if (zone.mEnd > begin && zone.mStart >= state.mStart)
+                    zones.push_back(RecordedZone {zone.mName, buffer->mName, zone.mStart, zone.mEnd});
+            }
+        }
+    }
+}
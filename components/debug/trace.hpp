@@ -0,0 +1,78 @@
+#ifndef DEBUG_TRACE_H
+#define DEBUG_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Debug
+{
+    ///
+    /// \brief Records zones of code run on all threads, to find what causes hitches
+    ///
+    /// Each thread writes its zones into its own ring buffer, keeping the last zones recorded. The result is written
+    /// in the Chrome trace event format, for chrome://tracing or Perfetto.
+    ///
+    class Trace
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        struct RecordedZone
+        {
+            const char* mName;
+            std::string mThread;
+            Clock::time_point mStart;
+            Clock::time_point mEnd;
+        };
+
+        static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+        /// Enabling discards the zones recorded before.
+        static void setEnabled(bool enabled);
+
+        /// Name the calling thread in the written trace.
+        static void setThreadName(const std::string& name);
+
+        static void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+        /// Write the recorded zones of all threads as JSON.
+        static void write(std::ostream& stream);
+
+        /// Append the recorded zones of all threads that ended after \a begin.
+        static void getZones(Clock::time_point begin, std::vector<RecordedZone>& zones);
+
+    private:
+        static std::atomic<bool> sEnabled;
+    };
+
+    /// Records the time spent in its scope while tracing is enabled.
+    /// @param name Name of the zone, must outlive the trace, i.e. a string literal.
+    class TraceZone
+    {
+    public:
+        explicit TraceZone(const char* name)
+            : mName(Trace::isEnabled() ? name : nullptr)
+        {
+            if (mName != nullptr)
+                mStart = Trace::Clock::now();
+        }
+
+        ~TraceZone()
+        {
+            if (mName != nullptr)
+                Trace::record(mName, mStart, Trace::Clock::now());
+        }
+
+    private:
+        const char* mName;
+        Trace::Clock::time_point mStart;
+
+        TraceZone(const TraceZone&);
+        void operator=(const TraceZone&);
+    };
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "settings.hpp"
 
 #include <components/debug/debuglog.hpp>
+#include <components/debug/trace.hpp>
 
 #include <osg/Stats>
 
@@ -12,6 +13,9 @@ namespace
     using DetourNavigator::ChangeType;
     using DetourNavigator::TilePosition;
 
+    // Jobs for all agents of a tile have the same priority so they are processed close to each other
+    const std::size_t sSolidHeightfieldCacheSize = 32;
+
     int getManhattanDistance(const TilePosition& lhs, const TilePosition& rhs)
     {
         return std::abs(lhs.x() - rhs.x()) + std::abs(lhs.y() - rhs.y());
@@ -46,7 +50,11 @@ namespace DetourNavigator
         , mRecastMeshManager(recastMeshManager)
         , mOffMeshConnectionsManager(offMeshConnectionsManager)
         , mShouldStop()
-        , mNavMeshTilesCache(settings.mMaxNavMeshTilesCacheSize)
+        , mNavMeshTilesCache(settings.mMaxNavMeshTilesCacheSize, settings.mCompressNavMeshTilesCache)
+        , mNavMeshDiskCache(settings.mEnableNavMeshDiskCache ? settings.mNavMeshDiskCachePath : std::string(),
+            settings.mMaxNavMeshDiskCacheSize)
+        , mSolidHeightfieldCache(sSolidHeightfieldCacheSize)
+        , mJobLatencies()
     {
         for (std::size_t i = 0; i < mSettings.get().mAsyncNavMeshUpdaterThreads; ++i)
             mThreads.emplace_back([&] { process(); });
@@ -67,13 +75,28 @@ namespace DetourNavigator
         const SharedNavMeshCacheItem& navMeshCacheItem, const TilePosition& playerTile,
         const std::map<TilePosition, ChangeType>& changedTiles)
     {
-        *mPlayerTile.lock() = playerTile;
+        bool playerTileChanged = false;
+        {
+            const auto locked = mPlayerTile.lock();
+            playerTileChanged = *locked != playerTile;
+            *locked = playerTile;
+        }
 
-        if (changedTiles.empty())
+        if (changedTiles.empty() && !playerTileChanged)
             return;
 
         const std::lock_guard<std::mutex> lock(mMutex);
 
+        // Queued jobs were prioritized by the distance to the old player tile
+        if (playerTileChanged)
+        {
+            updateJobsPriority(mJobs, playerTile);
+            for (auto& threadQueue : mThreadsQueues)
+                updateJobsPriority(threadQueue.second.mJobs, playerTile);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+
         for (const auto& changedTile : changedTiles)
         {
             if (mPushed[agentHalfExtents].insert(changedTile.first).second)
@@ -87,6 +110,7 @@ namespace DetourNavigator
                 job.mChangeType = changedTile.second;
                 job.mDistanceToPlayer = getManhattanDistance(changedTile.first, playerTile);
                 job.mDistanceToOrigin = getManhattanDistance(changedTile.first, TilePosition {0, 0});
+                job.mPostTime = now;
 
                 mJobs.push(std::move(job));
             }
@@ -107,13 +131,21 @@ namespace DetourNavigator
     void AsyncNavMeshUpdater::reportStats(unsigned int frameNumber, osg::Stats& stats) const
     {
         std::size_t jobs = 0;
+        std::array<std::size_t, 4> jobLatencies;
 
         {
             const std::lock_guard<std::mutex> lock(mMutex);
             jobs = mJobs.size();
+            for (const auto& threadQueue : mThreadsQueues)
+                jobs += threadQueue.second.mJobs.size();
+            jobLatencies = mJobLatencies;
         }
 
         stats.setAttribute(frameNumber, "NavMesh UpdateJobs", jobs);
+        stats.setAttribute(frameNumber, "NavMesh Jobs <10ms", jobLatencies[0]);
+        stats.setAttribute(frameNumber, "NavMesh Jobs <100ms", jobLatencies[1]);
+        stats.setAttribute(frameNumber, "NavMesh Jobs <1s", jobLatencies[2]);
+        stats.setAttribute(frameNumber, "NavMesh Jobs >=1s", jobLatencies[3]);
 
         mNavMeshTilesCache.reportStats(frameNumber, stats);
     }
@@ -121,12 +153,14 @@ namespace DetourNavigator
     void AsyncNavMeshUpdater::process() throw()
     {
         Log(Debug::Debug) << "Start process navigator jobs";
+        Debug::Trace::setThreadName("NavMesh");
         while (!mShouldStop)
         {
             try
             {
                 if (auto job = getNextJob())
                 {
+                    const Debug::TraceZone zone("NavMesh job");
                     const auto processed = processJob(*job);
                     unlockTile(job->mAgentHalfExtents, job->mChangedTile);
                     if (!processed)
@@ -154,17 +188,32 @@ namespace DetourNavigator
         if (!navMeshCacheItem)
             return true;
 
-        const auto recastMesh = mRecastMeshManager.get().getMesh(job.mChangedTile);
         const auto playerTile = *mPlayerTile.lockConst();
+
+        // The player may have moved away since the job was posted, so the tile is not needed anymore
+        const auto maxTiles = std::min(mSettings.get().mMaxTilesNumber, navMeshCacheItem->lockConst()->getImpl().getParams()->maxTiles);
+        if (!shouldAddTile(job.mChangedTile, playerTile, maxTiles))
+        {
+            Log(Debug::Debug) << "Ignore job: tile is too far from player";
+            navMeshCacheItem->lock()->removeTile(job.mChangedTile);
+            addJobLatency(std::chrono::steady_clock::now() - job.mPostTime);
+            return true;
+        }
+
+        const auto recastMesh = mRecastMeshManager.get().getMesh(job.mChangedTile);
         const auto offMeshConnections = mOffMeshConnectionsManager.get().get(job.mChangedTile);
 
-        const auto status = updateNavMesh(job.mAgentHalfExtents, recastMesh.get(), job.mChangedTile, playerTile,
-            offMeshConnections, mSettings, navMeshCacheItem, mNavMeshTilesCache);
+        const auto status = updateNavMesh(job.mAgentHalfExtents, recastMesh, job.mChangedTile, playerTile,
+            offMeshConnections, mSettings, navMeshCacheItem, mNavMeshTilesCache, mNavMeshDiskCache,
+            mSolidHeightfieldCache);
 
         const auto finish = std::chrono::steady_clock::now();
 
         writeDebugFiles(job, recastMesh.get());
 
+        if (isSuccess(status) || job.mTryNumber > 2)
+            addJobLatency(finish - job.mPostTime);
+
         using FloatMs = std::chrono::duration<float, std::milli>;
 
         const auto locked = navMeshCacheItem->lockConst();
@@ -226,6 +275,34 @@ namespace DetourNavigator
         return job;
     }
 
+    void AsyncNavMeshUpdater::updateJobsPriority(Jobs& jobs, const TilePosition& playerTile)
+    {
+        std::vector<Job> updated;
+        updated.reserve(jobs.size());
+        while (!jobs.empty())
+        {
+            updated.push_back(jobs.top());
+            jobs.pop();
+            updated.back().mDistanceToPlayer = getManhattanDistance(updated.back().mChangedTile, playerTile);
+        }
+        for (auto& job : updated)
+            jobs.push(std::move(job));
+    }
+
+    void AsyncNavMeshUpdater::addJobLatency(std::chrono::steady_clock::duration latency)
+    {
+        std::size_t bucket = 3;
+        if (latency < std::chrono::milliseconds(10))
+            bucket = 0;
+        else if (latency < std::chrono::milliseconds(100))
+            bucket = 1;
+        else if (latency < std::chrono::seconds(1))
+            bucket = 2;
+
+        const std::lock_guard<std::mutex> lock(mMutex);
+        ++mJobLatencies[bucket];
+    }
+
     void AsyncNavMeshUpdater::writeDebugFiles(const Job& job, const RecastMesh* recastMesh) const
     {
         std::string revision;
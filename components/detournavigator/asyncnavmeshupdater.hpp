@@ -6,11 +6,14 @@
 #include "tilecachedrecastmeshmanager.hpp"
 #include "tileposition.hpp"
 #include "navmeshtilescache.hpp"
+#include "navmeshdiskcache.hpp"
+#include "solidheightfieldcache.hpp"
 
 #include <osg/Vec3f>
 
 #include <boost/optional.hpp>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -56,6 +59,7 @@ namespace DetourNavigator
             ChangeType mChangeType;
             int mDistanceToPlayer;
             int mDistanceToOrigin;
+            std::chrono::steady_clock::time_point mPostTime;
 
             std::tuple<unsigned, ChangeType, int, int> getPriority() const
             {
@@ -91,9 +95,13 @@ namespace DetourNavigator
         Misc::ScopeGuarded<TilePosition> mPlayerTile;
         Misc::ScopeGuarded<boost::optional<std::chrono::steady_clock::time_point>> mFirstStart;
         NavMeshTilesCache mNavMeshTilesCache;
+        NavMeshDiskCache mNavMeshDiskCache;
+        SolidHeightfieldCache mSolidHeightfieldCache;
         Misc::ScopeGuarded<std::map<osg::Vec3f, std::map<TilePosition, std::thread::id>>> mProcessingTiles;
         std::map<std::thread::id, Queue> mThreadsQueues;
         std::vector<std::thread> mThreads;
+        // Number of finished jobs by time from posting to finishing: < 10ms, < 100ms, < 1s, >= 1s
+        std::array<std::size_t, 4> mJobLatencies;
 
         void process() throw();
 
@@ -103,6 +111,10 @@ namespace DetourNavigator
 
         static Job getJob(Jobs& jobs, Pushed& pushed);
 
+        static void updateJobsPriority(Jobs& jobs, const TilePosition& playerTile);
+
+        void addJobLatency(std::chrono::steady_clock::duration latency);
+
         void postThreadJob(Job&& job, Queue& queue);
 
         void writeDebugFiles(const Job& job, const RecastMesh* recastMesh) const;
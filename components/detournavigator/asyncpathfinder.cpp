@@ -0,0 +1,93 @@
+#include "asyncpathfinder.hpp"
+#include "findsmoothpath.hpp"
+#include "settingsutils.hpp"
+
+#include <components/debug/debuglog.hpp>
+
+#include <iterator>
+
+namespace
+{
+    using namespace DetourNavigator;
+
+    std::deque<osg::Vec3f> findPath(const SharedNavMeshCacheItem& navMeshCacheItem, const osg::Vec3f& agentHalfExtents,
+        const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end, const Flags includeFlags,
+        const Settings& settings)
+    {
+        std::deque<osg::Vec3f> result;
+        findSmoothPath(navMeshCacheItem->lockConst()->getImpl(), toNavMeshCoordinates(settings, agentHalfExtents),
+            toNavMeshCoordinates(settings, stepSize), toNavMeshCoordinates(settings, start),
+            toNavMeshCoordinates(settings, end), includeFlags, settings, std::back_inserter(result));
+        return result;
+    }
+}
+
+namespace DetourNavigator
+{
+    AsyncPathFinder::AsyncPathFinder(const Settings& settings)
+        : mSettings(settings)
+        , mShouldStop()
+    {
+        for (std::size_t i = 0; i < mSettings.get().mAsyncPathFinderThreads; ++i)
+            mThreads.emplace_back([&] { process(); });
+    }
+
+    AsyncPathFinder::~AsyncPathFinder()
+    {
+        mShouldStop = true;
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobs.clear();
+        mHasJob.notify_all();
+        lock.unlock();
+        for (auto& thread : mThreads)
+            thread.join();
+    }
+
+    std::shared_future<std::deque<osg::Vec3f>> AsyncPathFinder::post(const SharedNavMeshCacheItem& navMeshCacheItem,
+        const osg::Vec3f& agentHalfExtents, const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end,
+        const Flags includeFlags)
+    {
+        const Settings& settings = mSettings.get();
+        Job job([=, &settings] {
+            return findPath(navMeshCacheItem, agentHalfExtents, stepSize, start, end, includeFlags, settings);
+        });
+        std::shared_future<std::deque<osg::Vec3f>> result = job.get_future().share();
+
+        if (mThreads.empty())
+        {
+            job();
+            return result;
+        }
+
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+        mHasJob.notify_one();
+
+        return result;
+    }
+
+    void AsyncPathFinder::process() throw()
+    {
+        Log(Debug::Debug) << "Start process path finder jobs";
+        while (!mShouldStop)
+        {
+            try
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mHasJob.wait(lock, [&] { return mShouldStop || !mJobs.empty(); });
+                if (mJobs.empty())
+                    continue;
+                Job job = std::move(mJobs.front());
+                mJobs.pop_front();
+                lock.unlock();
+                // Exceptions thrown by the search are stored in the future
+                job();
+            }
+            catch (const std::exception& e)
+            {
+                Log(Debug::Error) << "AsyncPathFinder::process exception: " << e.what();
+            }
+        }
+        Log(Debug::Debug) << "Stop process path finder jobs";
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef OPENMW_COMPONENTS_DETOURNAVIGATOR_ASYNCPATHFINDER_H
+#define OPENMW_COMPONENTS_DETOURNAVIGATOR_ASYNCPATHFINDER_H
+
+#include "flags.hpp"
+#include "navmeshcacheitem.hpp"
+#include "settings.hpp"
+
+#include <osg/Vec3f>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DetourNavigator
+{
+    /**
+     * @brief AsyncPathFinder finds paths on navmesh in background threads. Each search uses its own dtNavMeshQuery
+     * and holds the navmesh read lock only while it runs.
+     */
+    class AsyncPathFinder
+    {
+    public:
+        AsyncPathFinder(const Settings& settings);
+        ~AsyncPathFinder();
+
+        /**
+         * @brief post queues a path search. If there are no background threads, the path is searched immediately.
+         * @return future getting the found path or an exception thrown while searching it. Path is empty if no path
+         * is found.
+         */
+        std::shared_future<std::deque<osg::Vec3f>> post(const SharedNavMeshCacheItem& navMeshCacheItem,
+            const osg::Vec3f& agentHalfExtents, const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end,
+            const Flags includeFlags);
+
+    private:
+        using Job = std::packaged_task<std::deque<osg::Vec3f>()>;
+
+        std::reference_wrapper<const Settings> mSettings;
+        std::atomic_bool mShouldStop;
+        std::mutex mMutex;
+        std::condition_variable mHasJob;
+        std::deque<Job> mJobs;
+        std::vector<std::thread> mThreads;
+
+        void process() throw();
+    };
+}
+
+#endif
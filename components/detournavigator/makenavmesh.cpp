@@ -9,6 +9,8 @@
 #include "sharednavmesh.hpp"
 #include "flags.hpp"
 #include "navmeshtilescache.hpp"
+#include "navmeshdiskcache.hpp"
+#include "solidheightfieldcache.hpp"
 
 #include <components/misc/convert.hpp>
 
@@ -258,15 +260,57 @@ namespace
         }
     }
 
-    bool rasterizeTriangles(rcContext& context, const osg::Vec3f& agentHalfExtents, const RecastMesh& recastMesh,
-        const rcConfig& config, const Settings& settings, rcHeightfield& solid)
+    std::shared_ptr<const SolidHeightfield> makeSolidHeightfield(rcContext& context, const RecastMesh& recastMesh,
+        const rcConfig& config)
     {
+        rcHeightfield solid;
+        createHeightfield(context, solid, config.width, config.height, config.bmin, config.bmax, config.cs, config.ch);
+
+        const auto result = std::make_shared<SolidHeightfield>();
+
         if (!rasterizeSolidObjectsTriangles(context, recastMesh, config, solid))
-            return false;
+            return result;
 
-        rasterizeWaterTriangles(context, agentHalfExtents, recastMesh, settings, config, solid);
+        result->mHasTriangles = true;
+        result->mColumns.reserve(static_cast<std::size_t>(solid.width * solid.height + 1));
 
-        return true;
+        for (int i = 0; i < solid.width * solid.height; ++i)
+        {
+            result->mColumns.push_back(result->mSpans.size());
+            for (const rcSpan* span = solid.spans[i]; span != nullptr; span = span->next)
+                result->mSpans.push_back(SolidHeightfield::Span {
+                    static_cast<unsigned short>(span->smin),
+                    static_cast<unsigned short>(span->smax),
+                    static_cast<unsigned char>(span->area)
+                });
+        }
+
+        result->mColumns.push_back(result->mSpans.size());
+
+        return result;
+    }
+
+    void addSolidSpans(rcContext& context, const SolidHeightfield& source, const int shift, const int flagMergeThr,
+        rcHeightfield& solid)
+    {
+        for (int y = 0; y < solid.height; ++y)
+        {
+            for (int x = 0; x < solid.width; ++x)
+            {
+                const auto column = static_cast<std::size_t>(x + y * solid.width);
+                const auto begin = source.mSpans.begin() + static_cast<std::ptrdiff_t>(source.mColumns[column]);
+                const auto end = source.mSpans.begin() + static_cast<std::ptrdiff_t>(source.mColumns[column + 1]);
+
+                for (auto span = begin; span != end; ++span)
+                {
+                    const auto smin = static_cast<unsigned short>(std::min(span->mMin + shift, RC_SPAN_MAX_HEIGHT));
+                    const auto smax = static_cast<unsigned short>(std::min(span->mMax + shift, RC_SPAN_MAX_HEIGHT));
+
+                    if (!rcAddSpan(&context, solid, x, y, smin, smax, span->mArea, flagMergeThr))
+                        throw NavigatorException("Failed to add solid object spans for navmesh");
+                }
+            }
+        }
     }
 
     void buildCompactHeightfield(rcContext& context, const int walkableHeight, const int walkableClimb,
@@ -368,18 +412,43 @@ namespace
         return true;
     }
 
-    NavMeshData makeNavMeshTileData(const osg::Vec3f& agentHalfExtents, const RecastMesh& recastMesh,
+    NavMeshData makeNavMeshTileData(const osg::Vec3f& agentHalfExtents, const std::shared_ptr<RecastMesh>& recastMesh,
         const std::vector<OffMeshConnection>& offMeshConnections, const TilePosition& tile,
-        const osg::Vec3f& boundsMin, const osg::Vec3f& boundsMax, const Settings& settings)
+        const Bounds& recastMeshBounds, const Settings& settings, SolidHeightfieldCache& solidHeightfieldCache)
     {
         rcContext context;
+
+        const auto tileBounds = makeTileBounds(settings, tile);
+        const osg::Vec3f solidBoundsMin(tileBounds.mMin.x(), recastMesh->getBounds().mMin.y() - 1, tileBounds.mMin.y());
+        const osg::Vec3f solidBoundsMax(tileBounds.mMax.x(), recastMesh->getBounds().mMax.y() + 1, tileBounds.mMax.y());
+
+        // Solid objects are rasterized once for all agents, only settings dependent parameters of config are used
+        auto solidHeightfield = solidHeightfieldCache.get(tile, recastMesh);
+        if (!solidHeightfield)
+        {
+            solidHeightfield = makeSolidHeightfield(context, *recastMesh,
+                makeConfig(agentHalfExtents, solidBoundsMin, solidBoundsMax, settings));
+            solidHeightfieldCache.set(tile, recastMesh, solidHeightfield);
+        }
+
+        if (!solidHeightfield->mHasTriangles)
+            return NavMeshData();
+
+        // Agent water level may be below solid objects, lower the heightfield by whole cells to keep spans heights
+        const int shift = static_cast<int>(std::ceil(std::max(0.0f,
+            solidBoundsMin.y() - (recastMeshBounds.mMin.y() - 1)) / settings.mCellHeight));
+        const osg::Vec3f boundsMin(solidBoundsMin.x(), solidBoundsMin.y() - shift * settings.mCellHeight,
+            solidBoundsMin.z());
+        const osg::Vec3f boundsMax(solidBoundsMax.x(), std::max(solidBoundsMax.y(), recastMeshBounds.mMax.y() + 1),
+            solidBoundsMax.z());
+
         const auto config = makeConfig(agentHalfExtents, boundsMin, boundsMax, settings);
 
         rcHeightfield solid;
         createHeightfield(context, solid, config.width, config.height, config.bmin, config.bmax, config.cs, config.ch);
 
-        if (!rasterizeTriangles(context, agentHalfExtents, recastMesh, config, settings, solid))
-            return NavMeshData();
+        addSolidSpans(context, *solidHeightfield, shift, config.walkableClimb, solid);
+        rasterizeWaterTriangles(context, agentHalfExtents, *recastMesh, settings, config, solid);
 
         rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, solid);
         rcFilterLedgeSpans(&context, config.walkableHeight, config.walkableClimb, solid);
@@ -483,10 +552,11 @@ namespace DetourNavigator
         return navMesh;
     }
 
-    UpdateNavMeshStatus updateNavMesh(const osg::Vec3f& agentHalfExtents, const RecastMesh* recastMesh,
+    UpdateNavMeshStatus updateNavMesh(const osg::Vec3f& agentHalfExtents, const std::shared_ptr<RecastMesh>& recastMesh,
         const TilePosition& changedTile, const TilePosition& playerTile,
         const std::vector<OffMeshConnection>& offMeshConnections, const Settings& settings,
-        const SharedNavMeshCacheItem& navMeshCacheItem, NavMeshTilesCache& navMeshTilesCache)
+        const SharedNavMeshCacheItem& navMeshCacheItem, NavMeshTilesCache& navMeshTilesCache,
+        const NavMeshDiskCache& navMeshDiskCache, SolidHeightfieldCache& solidHeightfieldCache)
     {
         Log(Debug::Debug) << std::fixed << std::setprecision(2) <<
             "Update NavMesh with multiple tiles:" <<
@@ -531,17 +601,22 @@ namespace DetourNavigator
 
         if (!cachedNavMeshData)
         {
-            const auto tileBounds = makeTileBounds(settings, changedTile);
-            const osg::Vec3f tileBorderMin(tileBounds.mMin.x(), recastMeshBounds.mMin.y() - 1, tileBounds.mMin.y());
-            const osg::Vec3f tileBorderMax(tileBounds.mMax.x(), recastMeshBounds.mMax.y() + 1, tileBounds.mMax.y());
-
-            auto navMeshData = makeNavMeshTileData(agentHalfExtents, *recastMesh, offMeshConnections, changedTile,
-                tileBorderMin, tileBorderMax, settings);
+            auto navMeshData = navMeshDiskCache.get(agentHalfExtents, changedTile, *recastMesh, offMeshConnections,
+                settings);
 
             if (!navMeshData.mValue)
             {
-                Log(Debug::Debug) << "Ignore add tile: NavMeshData is null";
-                return navMeshCacheItem->lock()->removeTile(changedTile);
+                navMeshData = makeNavMeshTileData(agentHalfExtents, recastMesh, offMeshConnections, changedTile,
+                    recastMeshBounds, settings, solidHeightfieldCache);
+
+                if (!navMeshData.mValue)
+                {
+                    Log(Debug::Debug) << "Ignore add tile: NavMeshData is null";
+                    return navMeshCacheItem->lock()->removeTile(changedTile);
+                }
+
+                navMeshDiskCache.set(agentHalfExtents, changedTile, *recastMesh, offMeshConnections, settings,
+                    navMeshData);
             }
 
             try
@@ -17,7 +17,9 @@ class dtNavMesh;
 
 namespace DetourNavigator
 {
+    class NavMeshDiskCache;
     class RecastMesh;
+    class SolidHeightfieldCache;
     struct Settings;
 
     inline float getLength(const osg::Vec2i& value)
@@ -38,10 +40,11 @@ namespace DetourNavigator
 
     NavMeshPtr makeEmptyNavMesh(const Settings& settings);
 
-    UpdateNavMeshStatus updateNavMesh(const osg::Vec3f& agentHalfExtents, const RecastMesh* recastMesh,
+    UpdateNavMeshStatus updateNavMesh(const osg::Vec3f& agentHalfExtents, const std::shared_ptr<RecastMesh>& recastMesh,
         const TilePosition& changedTile, const TilePosition& playerTile,
         const std::vector<OffMeshConnection>& offMeshConnections, const Settings& settings,
-        const SharedNavMeshCacheItem& navMeshCacheItem, NavMeshTilesCache& navMeshTilesCache);
+        const SharedNavMeshCacheItem& navMeshCacheItem, NavMeshTilesCache& navMeshTilesCache,
+        const NavMeshDiskCache& navMeshDiskCache, SolidHeightfieldCache& solidHeightfieldCache);
 }
 
 #endif
@@ -7,6 +7,9 @@
 #include "objectid.hpp"
 #include "navmeshcacheitem.hpp"
 
+#include <deque>
+#include <future>
+
 namespace DetourNavigator
 {
     struct ObjectShapes
@@ -179,6 +182,14 @@ namespace DetourNavigator
                 toNavMeshCoordinates(settings, end), includeFlags, settings, out);
         }
 
+        /**
+         * @brief findPathAsync is like findPath, but may search the path in a background thread.
+         * @return future getting the found path, empty if no path is found. Getting the path rethrows exceptions of
+         * the search, like NavigatorException if start or end point is not on navmesh.
+         */
+        virtual std::shared_future<std::deque<osg::Vec3f>> findPathAsync(const osg::Vec3f& agentHalfExtents,
+            const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end, const Flags includeFlags) const = 0;
+
         /**
          * @brief getNavMesh returns navmesh for specific agent half extents
          * @return navmesh
@@ -9,6 +9,7 @@ namespace DetourNavigator
     NavigatorImpl::NavigatorImpl(const Settings& settings)
         : mSettings(settings)
         , mNavMeshManager(mSettings)
+        , mAsyncPathFinder(mSettings)
     {
     }
 
@@ -123,6 +124,19 @@ namespace DetourNavigator
         mNavMeshManager.wait();
     }
 
+    std::shared_future<std::deque<osg::Vec3f>> NavigatorImpl::findPathAsync(const osg::Vec3f& agentHalfExtents,
+        const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end, const Flags includeFlags) const
+    {
+        const auto navMesh = getNavMesh(agentHalfExtents);
+        if (!navMesh)
+        {
+            std::promise<std::deque<osg::Vec3f>> empty;
+            empty.set_value(std::deque<osg::Vec3f>());
+            return empty.get_future().share();
+        }
+        return mAsyncPathFinder.post(navMesh, agentHalfExtents, stepSize, start, end, includeFlags);
+    }
+
     SharedNavMeshCacheItem NavigatorImpl::getNavMesh(const osg::Vec3f& agentHalfExtents) const
     {
         return mNavMeshManager.getNavMesh(agentHalfExtents);
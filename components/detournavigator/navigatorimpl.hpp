@@ -3,6 +3,7 @@
 
 #include "navigator.hpp"
 #include "navmeshmanager.hpp"
+#include "asyncpathfinder.hpp"
 
 namespace DetourNavigator
 {
@@ -42,6 +43,9 @@ namespace DetourNavigator
 
         void wait() override;
 
+        std::shared_future<std::deque<osg::Vec3f>> findPathAsync(const osg::Vec3f& agentHalfExtents,
+            const float stepSize, const osg::Vec3f& start, const osg::Vec3f& end, const Flags includeFlags) const override;
+
         SharedNavMeshCacheItem getNavMesh(const osg::Vec3f& agentHalfExtents) const override;
 
         std::map<osg::Vec3f, SharedNavMeshCacheItem> getNavMeshes() const override;
@@ -53,6 +57,7 @@ namespace DetourNavigator
     private:
         Settings mSettings;
         NavMeshManager mNavMeshManager;
+        mutable AsyncPathFinder mAsyncPathFinder;
         std::map<osg::Vec3f, std::size_t> mAgents;
         std::unordered_map<ObjectId, ObjectId> mAvoidIds;
         std::unordered_map<ObjectId, ObjectId> mWaterIds;
@@ -64,6 +64,15 @@ namespace DetourNavigator
 
         void wait() override {}
 
+        std::shared_future<std::deque<osg::Vec3f>> findPathAsync(const osg::Vec3f& /*agentHalfExtents*/,
+            const float /*stepSize*/, const osg::Vec3f& /*start*/, const osg::Vec3f& /*end*/,
+            const Flags /*includeFlags*/) const override
+        {
+            std::promise<std::deque<osg::Vec3f>> empty;
+            empty.set_value(std::deque<osg::Vec3f>());
+            return empty.get_future().share();
+        }
+
         SharedNavMeshCacheItem getNavMesh(const osg::Vec3f& /*agentHalfExtents*/) const override
         {
             return mEmptyNavMeshCacheItem;
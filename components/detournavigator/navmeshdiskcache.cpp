@@ -0,0 +1,266 @@
+#include "navmeshdiskcache.hpp"
+#include "recastmesh.hpp"
+#include "settings.hpp"
+
+#include <components/debug/debuglog.hpp>
+#include <components/misc/diskcache.hpp>
+
+#include <DetourAlloc.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace DetourNavigator
+{
+    namespace
+    {
+        constexpr char sMagic[] = {'O', 'M', 'W', 'N', 'A', 'V', 'T', 'L'};
+        constexpr std::uint32_t sVersion = 2;
+        constexpr char sExtension[] = ".navtile";
+
+        struct FileHeader
+        {
+            char mMagic[sizeof(sMagic)];
+            std::uint32_t mVersion;
+            std::int32_t mDataSize;
+            std::uint64_t mKeySize;
+            std::uint64_t mCheckHash;
+        };
+
+        /// Computes two independent FNV-1a hashes over the same data. First one names the file,
+        /// second one is stored inside to detect collisions.
+        class KeyHasher
+        {
+        public:
+            void add(const void* data, std::size_t size)
+            {
+                const auto bytes = static_cast<const unsigned char*>(data);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    mFileHash = (mFileHash ^ bytes[i]) * 1099511628211ull;
+                    mCheckHash = (mCheckHash ^ bytes[i]) * 1099511628211ull;
+                }
+                mSize += size;
+            }
+
+            template <class T>
+            void add(const T& value)
+            {
+                add(&value, sizeof(value));
+            }
+
+            template <class T>
+            void add(const std::vector<T>& values)
+            {
+                add(values.size());
+                add(values.data(), values.size() * sizeof(T));
+            }
+
+            void add(const btVector3& value)
+            {
+                add(value.x());
+                add(value.y());
+                add(value.z());
+            }
+
+            // Water and off mesh connections are added by field, their structures may have padding
+            void add(const std::vector<RecastMesh::Water>& values)
+            {
+                add(values.size());
+                for (const auto& water : values)
+                {
+                    add(water.mCellSize);
+                    for (int i = 0; i < 3; ++i)
+                        add(water.mTransform.getBasis()[i]);
+                    add(water.mTransform.getOrigin());
+                }
+            }
+
+            void add(const std::vector<OffMeshConnection>& values)
+            {
+                add(values.size());
+                for (const auto& connection : values)
+                {
+                    for (int i = 0; i < 3; ++i)
+                        add(connection.mStart[i]);
+                    for (int i = 0; i < 3; ++i)
+                        add(connection.mEnd[i]);
+                }
+            }
+
+            std::uint64_t getFileHash() const { return mFileHash; }
+
+            std::uint64_t getCheckHash() const { return mCheckHash; }
+
+            std::uint64_t getSize() const { return mSize; }
+
+        private:
+            std::uint64_t mFileHash = 14695981039346656037ull;
+            std::uint64_t mCheckHash = 7809847782465536322ull;
+            std::uint64_t mSize = 0;
+        };
+
+        KeyHasher makeKeyHash(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+            const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections,
+            const Settings& settings)
+        {
+            KeyHasher hasher;
+            hasher.add(sVersion);
+            hasher.add(settings.mCellHeight);
+            hasher.add(settings.mCellSize);
+            hasher.add(settings.mDetailSampleDist);
+            hasher.add(settings.mDetailSampleMaxError);
+            hasher.add(settings.mMaxClimb);
+            hasher.add(settings.mMaxSimplificationError);
+            hasher.add(settings.mMaxSlope);
+            hasher.add(settings.mRecastScaleFactor);
+            hasher.add(settings.mSwimHeightScale);
+            hasher.add(settings.mBorderSize);
+            hasher.add(settings.mMaxEdgeLen);
+            hasher.add(settings.mMaxPolys);
+            hasher.add(settings.mMaxVertsPerPoly);
+            hasher.add(settings.mRegionMergeSize);
+            hasher.add(settings.mRegionMinSize);
+            hasher.add(settings.mTileSize);
+            hasher.add(agentHalfExtents.x());
+            hasher.add(agentHalfExtents.y());
+            hasher.add(agentHalfExtents.z());
+            hasher.add(changedTile.x());
+            hasher.add(changedTile.y());
+            hasher.add(recastMesh.getIndices());
+            hasher.add(recastMesh.getVertices());
+            hasher.add(recastMesh.getAreaTypes());
+            hasher.add(recastMesh.getWater());
+            hasher.add(offMeshConnections);
+            return hasher;
+        }
+
+        std::string makeFileName(std::uint64_t hash)
+        {
+            std::ostringstream stream;
+            stream << std::hex << std::setw(16) << std::setfill('0') << hash << sExtension;
+            return stream.str();
+        }
+    }
+
+    NavMeshDiskCache::NavMeshDiskCache(const std::string& path, std::uint64_t maxSize)
+        : mMaxSize(maxSize)
+        , mSize(0)
+    {
+        if (path.empty())
+            return;
+
+        try
+        {
+            boost::filesystem::create_directories(path);
+            mPath = path;
+            // Leave room for the tiles generated in this session
+            mSize = Misc::pruneCacheDirectory(mPath, sExtension, mMaxSize / 2);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Nav mesh disk cache is disabled: failed to create directory \""
+                << path << "\": " << e.what();
+        }
+    }
+
+    NavMeshData NavMeshDiskCache::get(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+        const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections,
+        const Settings& settings) const
+    {
+        if (!isEnabled())
+            return NavMeshData();
+
+        const auto key = makeKeyHash(agentHalfExtents, changedTile, recastMesh, offMeshConnections, settings);
+        const auto filePath = mPath / makeFileName(key.getFileHash());
+
+        boost::filesystem::ifstream file(filePath, std::ios::binary);
+        if (!file)
+            return NavMeshData();
+
+        FileHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+                || std::memcmp(header.mMagic, sMagic, sizeof(sMagic)) != 0
+                || header.mVersion != sVersion
+                || header.mKeySize != key.getSize()
+                || header.mCheckHash != key.getCheckHash()
+                || header.mDataSize <= 0)
+        {
+            Log(Debug::Debug) << "Ignore nav mesh disk cache file " << filePath << ": key mismatch";
+            return NavMeshData();
+        }
+
+        const auto data = static_cast<unsigned char*>(dtAlloc(static_cast<std::size_t>(header.mDataSize), DT_ALLOC_PERM));
+        if (data == nullptr)
+            return NavMeshData();
+
+        NavMeshData result(data, header.mDataSize);
+
+        if (!file.read(reinterpret_cast<char*>(data), header.mDataSize))
+        {
+            Log(Debug::Warning) << "Failed to read nav mesh disk cache file " << filePath;
+            return NavMeshData();
+        }
+
+        Misc::touchCacheFile(filePath);
+
+        return result;
+    }
+
+    void NavMeshDiskCache::set(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+        const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections,
+        const Settings& settings, const NavMeshData& value) const
+    {
+        if (!isEnabled() || !value.mValue || value.mSize <= 0)
+            return;
+
+        const auto key = makeKeyHash(agentHalfExtents, changedTile, recastMesh, offMeshConnections, settings);
+        const auto fileName = makeFileName(key.getFileHash());
+        const auto filePath = mPath / fileName;
+
+        // Write to a temporary file first so another thread or process never reads a partially written tile
+        std::ostringstream tmpFileName;
+        tmpFileName << fileName << '.' << std::this_thread::get_id() << ".tmp";
+        const auto tmpFilePath = mPath / tmpFileName.str();
+
+        FileHeader header;
+        std::memcpy(header.mMagic, sMagic, sizeof(sMagic));
+        header.mVersion = sVersion;
+        header.mDataSize = value.mSize;
+        header.mKeySize = key.getSize();
+        header.mCheckHash = key.getCheckHash();
+
+        const std::uint64_t fileSize = sizeof(header) + static_cast<std::uint64_t>(value.mSize);
+        if (mSize.fetch_add(fileSize) + fileSize > mMaxSize)
+        {
+            mSize -= fileSize;
+            return;
+        }
+
+        try
+        {
+            {
+                boost::filesystem::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(value.mValue.get()), value.mSize);
+                if (!file)
+                    throw std::runtime_error("write error");
+            }
+            boost::filesystem::rename(tmpFilePath, filePath);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to write nav mesh disk cache file " << filePath << ": " << e.what();
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpFilePath, ec);
+            mSize -= fileSize;
+        }
+    }
+}
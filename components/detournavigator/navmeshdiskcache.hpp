@@ -0,0 +1,52 @@
+#ifndef OPENMW_COMPONENTS_DETOURNAVIGATOR_NAVMESHDISKCACHE_H
+#define OPENMW_COMPONENTS_DETOURNAVIGATOR_NAVMESHDISKCACHE_H
+
+#include "offmeshconnection.hpp"
+#include "navmeshdata.hpp"
+#include "tileposition.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DetourNavigator
+{
+    class RecastMesh;
+    struct Settings;
+
+    /// Stores generated nav mesh tiles in files to reuse them on next runs.
+    /// Each file is named by a hash of all input data used to generate a tile: recast mesh, off mesh connections,
+    /// agent half extents, tile position and nav mesh generation settings. So any change of the input gives another
+    /// file and stale files are never used. The least recently used files are removed on start when the cache grows
+    /// larger than its maximum size, and no new files are written while it is full.
+    class NavMeshDiskCache
+    {
+    public:
+        /// Empty path disables cache.
+        NavMeshDiskCache(const std::string& path, std::uint64_t maxSize);
+
+        bool isEnabled() const
+        {
+            return !mPath.empty();
+        }
+
+        /// Returns empty data when there is no valid file for given input.
+        NavMeshData get(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+            const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections,
+            const Settings& settings) const;
+
+        void set(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+            const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections,
+            const Settings& settings, const NavMeshData& value) const;
+
+    private:
+        boost::filesystem::path mPath;
+        std::uint64_t mMaxSize;
+        mutable std::atomic<std::uint64_t> mSize;
+    };
+}
+
+#endif
@@ -47,10 +47,8 @@ namespace DetourNavigator
     bool NavMeshManager::addObject(const ObjectId id, const btCollisionShape& shape, const btTransform& transform,
                                    const AreaType areaType)
     {
-        if (!mRecastMeshManager.addObject(id, shape, transform, areaType))
-            return false;
-        addChangedTiles(shape, transform, ChangeType::add);
-        return true;
+        return mRecastMeshManager.addObject(id, shape, transform, areaType,
+            [&] (const TilePosition& tile) { addChangedTile(tile, ChangeType::add); });
     }
 
     bool NavMeshManager::updateObject(const ObjectId id, const btCollisionShape& shape, const btTransform& transform,
@@ -111,6 +109,7 @@ namespace DetourNavigator
         mChangedTiles.erase(agentHalfExtents);
         mPlayerTile.erase(agentHalfExtents);
         mLastRecastMeshManagerRevision.erase(agentHalfExtents);
+        mLastTileUpdates.erase(agentHalfExtents);
         return true;
     }
 
@@ -147,8 +146,10 @@ namespace DetourNavigator
         const auto playerTile = getTilePosition(mSettings, toNavMeshCoordinates(mSettings, playerPosition));
         auto& lastRevision = mLastRecastMeshManagerRevision[agentHalfExtents];
         auto lastPlayerTile = mPlayerTile.find(agentHalfExtents);
+        const auto changedTiles = mChangedTiles.find(agentHalfExtents);
+        const bool hasDelayedTiles = changedTiles != mChangedTiles.end() && !changedTiles->second.empty();
         if (lastRevision >= mRecastMeshManager.getRevision() && lastPlayerTile != mPlayerTile.end()
-                && lastPlayerTile->second == playerTile)
+                && lastPlayerTile->second == playerTile && !hasDelayedTiles)
             return;
         lastRevision = mRecastMeshManager.getRevision();
         if (lastPlayerTile == mPlayerTile.end())
@@ -163,7 +164,16 @@ namespace DetourNavigator
             stream << "Agent with half extents is not found: " << agentHalfExtents;
             throw InvalidArgument(stream.str());
         }
-        const auto changedTiles = mChangedTiles.find(agentHalfExtents);
+        const auto now = std::chrono::steady_clock::now();
+        auto& lastTileUpdates = mLastTileUpdates[agentHalfExtents];
+        for (auto it = lastTileUpdates.begin(); it != lastTileUpdates.end();)
+        {
+            if (now - it->second >= mSettings.mMinUpdateInterval)
+                it = lastTileUpdates.erase(it);
+            else
+                ++it;
+        }
+        std::map<TilePosition, ChangeType> delayedTiles;
         {
             const auto locked = cached->lockConst();
             const auto& navMesh = locked->getImpl();
@@ -172,6 +182,15 @@ namespace DetourNavigator
                 for (const auto& tile : changedTiles->second)
                     if (navMesh.getTileAt(tile.first.x(), tile.first.y(), 0))
                     {
+                        // Moving objects like opening doors change the same tiles every frame,
+                        // updating them once per interval is enough to follow the movement
+                        if (tile.second == ChangeType::update && lastTileUpdates.count(tile.first))
+                        {
+                            delayedTiles.insert(tile);
+                            continue;
+                        }
+                        if (tile.second == ChangeType::update)
+                            lastTileUpdates.emplace(tile.first, now);
                         auto tileToPost = tilesToPost.find(tile.first);
                         if (tileToPost == tilesToPost.end())
                             tilesToPost.insert(tile);
@@ -194,7 +213,7 @@ namespace DetourNavigator
         }
         mAsyncNavMeshUpdater.post(agentHalfExtents, cached, playerTile, tilesToPost);
         if (changedTiles != mChangedTiles.end())
-            changedTiles->second.clear();
+            changedTiles->second = std::move(delayedTiles);
         Log(Debug::Debug) << "cache update posted for agent=" << agentHalfExtents <<
             " playerTile=" << lastPlayerTile->second <<
             " recastMeshManagerRevision=" << lastRevision;
@@ -10,6 +10,7 @@
 
 #include <osg/Vec3f>
 
+#include <chrono>
 #include <map>
 #include <memory>
 
@@ -62,6 +63,7 @@ namespace DetourNavigator
         std::size_t mGenerationCounter = 0;
         std::map<osg::Vec3f, TilePosition> mPlayerTile;
         std::map<osg::Vec3f, std::size_t> mLastRecastMeshManagerRevision;
+        std::map<osg::Vec3f, std::map<TilePosition, std::chrono::steady_clock::time_point>> mLastTileUpdates;
 
         void addChangedTiles(const btCollisionShape& shape, const btTransform& transform, const ChangeType changeType);
 
@@ -3,23 +3,37 @@
 
 #include <osg/Stats>
 
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+#include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
 
 namespace DetourNavigator
 {
     namespace
     {
-        inline std::string makeNavMeshKey(const RecastMesh& recastMesh,
+        inline std::size_t getNavMeshKeySize(const RecastMesh& recastMesh,
             const std::vector<OffMeshConnection>& offMeshConnections)
         {
-            std::string result;
-            result.reserve(
-                recastMesh.getIndices().size() * sizeof(int)
+            return recastMesh.getIndices().size() * sizeof(int)
                 + recastMesh.getVertices().size() * sizeof(float)
                 + recastMesh.getAreaTypes().size() * sizeof(AreaType)
                 + recastMesh.getWater().size() * sizeof(RecastMesh::Water)
-                + offMeshConnections.size() * sizeof(OffMeshConnection)
-            );
+                + offMeshConnections.size() * sizeof(OffMeshConnection);
+        }
+
+        inline std::string makeNavMeshKey(const RecastMesh& recastMesh,
+            const std::vector<OffMeshConnection>& offMeshConnections)
+        {
+            std::string result;
+            result.reserve(getNavMeshKeySize(recastMesh, offMeshConnections));
             std::copy(
                 reinterpret_cast<const char*>(recastMesh.getIndices().data()),
                 reinterpret_cast<const char*>(recastMesh.getIndices().data() + recastMesh.getIndices().size()),
@@ -47,15 +61,126 @@ namespace DetourNavigator
             );
             return result;
         }
+
+        // FNV-1a over the same bytes as makeNavMeshKey, without building the key
+        struct HashBytes
+        {
+            std::uint64_t mHash = 14695981039346656037ull;
+
+            template <class T>
+            void operator ()(const std::vector<T>& values)
+            {
+                const auto begin = reinterpret_cast<const unsigned char*>(values.data());
+                const auto end = reinterpret_cast<const unsigned char*>(values.data() + values.size());
+                for (auto it = begin; it != end; ++it)
+                    mHash = (mHash ^ *it) * 1099511628211ull;
+            }
+        };
+
+        inline std::uint64_t hashNavMeshKey(const RecastMesh& recastMesh,
+            const std::vector<OffMeshConnection>& offMeshConnections)
+        {
+            HashBytes hashBytes;
+            hashBytes(recastMesh.getIndices());
+            hashBytes(recastMesh.getVertices());
+            hashBytes(recastMesh.getAreaTypes());
+            hashBytes(recastMesh.getWater());
+            hashBytes(offMeshConnections);
+            return hashBytes.mHash;
+        }
+
+        struct CompareBytes
+        {
+            const char* mRhsIt;
+            const char* mRhsEnd;
+
+            template <class T>
+            int operator ()(const std::vector<T>& lhs)
+            {
+                const auto lhsBegin = reinterpret_cast<const char*>(lhs.data());
+                const auto lhsEnd = reinterpret_cast<const char*>(lhs.data() + lhs.size());
+                const auto lhsSize = static_cast<std::ptrdiff_t>(lhsEnd - lhsBegin);
+                const auto rhsSize = static_cast<std::ptrdiff_t>(mRhsEnd - mRhsIt);
+
+                if (lhsBegin == nullptr || mRhsIt == nullptr)
+                {
+                    if (lhsSize < rhsSize)
+                        return -1;
+                    else if (lhsSize > rhsSize)
+                        return 1;
+                    else
+                        return 0;
+                }
+
+                const auto size = std::min(lhsSize, rhsSize);
+
+                if (const auto result = std::memcmp(lhsBegin, mRhsIt, size))
+                    return result;
+
+                if (lhsSize > rhsSize)
+                    return 1;
+
+                mRhsIt += size;
+
+                return 0;
+            }
+        };
+
+        inline bool isNavMeshKey(const std::string& key, const RecastMesh& recastMesh,
+            const std::vector<OffMeshConnection>& offMeshConnections)
+        {
+            CompareBytes compareBytes {key.data(), key.data() + key.size()};
+
+            return compareBytes(recastMesh.getIndices()) == 0
+                && compareBytes(recastMesh.getVertices()) == 0
+                && compareBytes(recastMesh.getAreaTypes()) == 0
+                && compareBytes(recastMesh.getWater()) == 0
+                && compareBytes(offMeshConnections) == 0
+                && compareBytes.mRhsIt == compareBytes.mRhsEnd;
+        }
+
+        std::string compress(const char* data, std::size_t size)
+        {
+            std::string result;
+            boost::iostreams::filtering_ostream stream;
+            stream.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(boost::iostreams::zlib::best_speed)));
+            stream.push(boost::iostreams::back_inserter(result));
+            stream.write(data, static_cast<std::streamsize>(size));
+            // Flushes the remaining compressed data
+            stream.reset();
+            return result;
+        }
+
+        void decompress(const std::string& compressed, char* data, std::size_t size)
+        {
+            boost::iostreams::filtering_istreambuf streamBuf;
+            streamBuf.push(boost::iostreams::zlib_decompressor());
+            streamBuf.push(boost::iostreams::array_source(compressed.data(), compressed.size()));
+            if (streamBuf.sgetn(data, static_cast<std::streamsize>(size)) != static_cast<std::streamsize>(size))
+                throw std::runtime_error("Failed to decompress cached nav mesh tile");
+        }
     }
 
-    NavMeshTilesCache::NavMeshTilesCache(const std::size_t maxNavMeshDataSize)
-        : mMaxNavMeshDataSize(maxNavMeshDataSize), mUsedNavMeshDataSize(0), mFreeNavMeshDataSize(0) {}
+    NavMeshTilesCache::NavMeshTilesCache(const std::size_t maxNavMeshDataSize, bool compress)
+        : mMaxNavMeshDataSize(maxNavMeshDataSize), mUsedNavMeshDataSize(0), mFreeNavMeshDataSize(0), mCompress(compress) {}
 
     NavMeshTilesCache::Value NavMeshTilesCache::get(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
         const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections)
     {
-        const std::lock_guard<std::mutex> lock(mMutex);
+        const auto navMeshKeyHash = hashNavMeshKey(recastMesh, offMeshConnections);
+
+        // The compression is deterministic, so compressed keys are compared as they are. The key is only compressed
+        // when there is an item it may match.
+        std::string compressedNavMeshKey;
+        if (mCompress)
+        {
+            if (!hasCandidates(agentHalfExtents, changedTile, navMeshKeyHash))
+                return Value();
+            const auto navMeshKey = makeNavMeshKey(recastMesh, offMeshConnections);
+            compressedNavMeshKey = compress(navMeshKey.data(), navMeshKey.size());
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
 
         const auto agentValues = mValues.find(agentHalfExtents);
         if (agentValues == mValues.end())
@@ -65,13 +190,21 @@ namespace DetourNavigator
         if (tileValues == agentValues->second.end())
             return Value();
 
-        const auto tile = tileValues->second.mMap.find(RecastMeshKeyView(recastMesh, offMeshConnections));
-        if (tile == tileValues->second.mMap.end())
-            return Value();
+        const auto candidates = tileValues->second.mMap.equal_range(navMeshKeyHash);
+        for (auto tile = candidates.first; tile != candidates.second; ++tile)
+        {
+            if (!hasKey(*tile->second, compressedNavMeshKey, recastMesh, offMeshConnections))
+                continue;
+
+            const auto iterator = tile->second;
 
-        acquireItemUnsafe(tile->second);
+            if (!acquireItem(iterator, lock))
+                return Value();
 
-        return Value(*this, tile->second);
+            return Value(*this, iterator);
+        }
+
+        return Value();
     }
 
     NavMeshTilesCache::Value NavMeshTilesCache::set(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
@@ -80,37 +213,38 @@ namespace DetourNavigator
     {
         const auto navMeshSize = static_cast<std::size_t>(value.mSize);
 
-        const std::lock_guard<std::mutex> lock(mMutex);
-
         if (navMeshSize > mMaxNavMeshDataSize)
             return Value();
 
-        if (navMeshSize > mFreeNavMeshDataSize + (mMaxNavMeshDataSize - mUsedNavMeshDataSize))
-            return Value();
-
         auto navMeshKey = makeNavMeshKey(recastMesh, offMeshConnections);
+        if (mCompress)
+            navMeshKey = compress(navMeshKey.data(), navMeshKey.size());
+        const auto navMeshKeyHash = hashNavMeshKey(recastMesh, offMeshConnections);
         const auto itemSize = navMeshSize + 2 * navMeshKey.size();
 
+        std::unique_lock<std::mutex> lock(mMutex);
+
         if (itemSize > mFreeNavMeshDataSize + (mMaxNavMeshDataSize - mUsedNavMeshDataSize))
             return Value();
 
         while (!mFreeItems.empty() && mUsedNavMeshDataSize + itemSize > mMaxNavMeshDataSize)
             removeLeastRecentlyUsed();
 
-        const auto iterator = mFreeItems.emplace(mFreeItems.end(), agentHalfExtents, changedTile, std::move(navMeshKey));
-        const auto emplaced = mValues[agentHalfExtents][changedTile].mMap.emplace(iterator->mNavMeshKey, iterator);
+        auto& tileMap = mValues[agentHalfExtents][changedTile].mMap;
+        const auto candidates = tileMap.equal_range(navMeshKeyHash);
+        for (auto tile = candidates.first; tile != candidates.second; ++tile)
+            if (hasKey(*tile->second, navMeshKey, recastMesh, offMeshConnections))
+                throw InvalidArgument("Set existing cache value");
 
-        if (!emplaced.second)
-        {
-            mFreeItems.erase(iterator);
-            throw InvalidArgument("Set existing cache value");
-        }
+        const auto iterator = mFreeItems.emplace(mFreeItems.end(), agentHalfExtents, changedTile, navMeshKeyHash,
+            std::move(navMeshKey));
+        tileMap.emplace(navMeshKeyHash, iterator);
 
         iterator->mNavMeshData = std::move(value);
         mUsedNavMeshDataSize += itemSize;
         mFreeNavMeshDataSize += itemSize;
 
-        acquireItemUnsafe(iterator);
+        acquireItem(iterator, lock);
 
         return Value(*this, iterator);
     }
@@ -135,7 +269,8 @@ namespace DetourNavigator
 
     void NavMeshTilesCache::removeLeastRecentlyUsed()
     {
-        const auto& item = mFreeItems.back();
+        const auto iterator = std::prev(mFreeItems.end());
+        const auto& item = *iterator;
 
         const auto agentValues = mValues.find(item.mAgentHalfExtents);
         if (agentValues == mValues.end())
@@ -145,8 +280,10 @@ namespace DetourNavigator
         if (tileValues == agentValues->second.end())
             return;
 
-        const auto value = tileValues->second.mMap.find(item.mNavMeshKey);
-        if (value == tileValues->second.mMap.end())
+        const auto candidates = tileValues->second.mMap.equal_range(item.mNavMeshKeyHash);
+        const auto value = std::find_if(candidates.first, candidates.second,
+            [&] (const std::pair<const std::uint64_t, ItemIterator>& v) { return v.second == iterator; });
+        if (value == candidates.second)
             return;
 
         mUsedNavMeshDataSize -= getSize(item);
@@ -165,88 +302,149 @@ namespace DetourNavigator
         mValues.erase(agentValues);
     }
 
-    void NavMeshTilesCache::acquireItemUnsafe(ItemIterator iterator)
+    bool NavMeshTilesCache::hasCandidates(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+        std::uint64_t navMeshKeyHash) const
     {
-        if (++iterator->mUseCount > 1)
-            return;
-
-        mBusyItems.splice(mBusyItems.end(), mFreeItems, iterator);
-        mFreeNavMeshDataSize -= getSize(*iterator);
-    }
+        const std::lock_guard<std::mutex> lock(mMutex);
 
-    void NavMeshTilesCache::releaseItem(ItemIterator iterator)
-    {
-        if (--iterator->mUseCount > 0)
-            return;
+        const auto agentValues = mValues.find(agentHalfExtents);
+        if (agentValues == mValues.end())
+            return false;
 
-        const std::lock_guard<std::mutex> lock(mMutex);
+        const auto tileValues = agentValues->second.find(changedTile);
+        if (tileValues == agentValues->second.end())
+            return false;
 
-        mFreeItems.splice(mFreeItems.begin(), mBusyItems, iterator);
-        mFreeNavMeshDataSize += getSize(*iterator);
+        return tileValues->second.mMap.count(navMeshKeyHash) > 0;
     }
 
-    namespace
+    bool NavMeshTilesCache::acquireItem(ItemIterator iterator, std::unique_lock<std::mutex>& lock)
     {
-        struct CompareBytes
+        Item& item = *iterator;
+
+        // An item being compressed is still in the busy items
+        if (++item.mUseCount == 1 && !item.mCompressing)
         {
-            const char* mRhsIt;
-            const char* mRhsEnd;
+            mBusyItems.splice(mBusyItems.end(), mFreeItems, iterator);
+            mFreeNavMeshDataSize -= getSize(item);
+        }
 
-            template <class T>
-            int operator ()(const std::vector<T>& lhs)
-            {
-                const auto lhsBegin = reinterpret_cast<const char*>(lhs.data());
-                const auto lhsEnd = reinterpret_cast<const char*>(lhs.data() + lhs.size());
-                const auto lhsSize = static_cast<std::ptrdiff_t>(lhsEnd - lhsBegin);
-                const auto rhsSize = static_cast<std::ptrdiff_t>(mRhsEnd - mRhsIt);
+        mItemDecompressed.wait(lock, [&] { return !item.mDecompressing; });
 
-                if (lhsBegin == nullptr || mRhsIt == nullptr)
-                {
-                    if (lhsSize < rhsSize)
-                        return -1;
-                    else if (lhsSize > rhsSize)
-                        return 1;
-                    else
-                        return 0;
-                }
+        if (item.mCompressedNavMeshData.empty())
+            return true;
 
-                const auto size = std::min(lhsSize, rhsSize);
+        const auto compressedSize = getSize(item);
+        const auto decompressedSize = static_cast<std::size_t>(item.mNavMeshData.mSize) + 2 * item.mNavMeshKey.size();
 
-                if (const auto result = std::memcmp(lhsBegin, mRhsIt, size))
-                    return result;
+        while (!mFreeItems.empty() && mUsedNavMeshDataSize - compressedSize + decompressedSize > mMaxNavMeshDataSize)
+            removeLeastRecentlyUsed();
 
-                if (lhsSize > rhsSize)
-                    return 1;
+        if (mUsedNavMeshDataSize - compressedSize + decompressedSize > mMaxNavMeshDataSize)
+        {
+            unacquireCompressedItemUnsafe(iterator);
+            return false;
+        }
 
-                mRhsIt += size;
+        // The compressed data is not changed while the item is used, so it is read without the lock
+        item.mDecompressing = true;
+        mUsedNavMeshDataSize = mUsedNavMeshDataSize - compressedSize + decompressedSize;
+        lock.unlock();
 
-                return 0;
-            }
-        };
+        NavMeshDataValue value;
+        try
+        {
+            const auto size = static_cast<std::size_t>(item.mNavMeshData.mSize);
+            value.reset(reinterpret_cast<unsigned char*>(dtAlloc(static_cast<int>(size), DT_ALLOC_PERM)));
+            if (!value)
+                throw std::bad_alloc();
+            decompress(item.mCompressedNavMeshData, reinterpret_cast<char*>(value.get()), size);
+        }
+        catch (...)
+        {
+            lock.lock();
+            item.mDecompressing = false;
+            mUsedNavMeshDataSize = mUsedNavMeshDataSize - decompressedSize + compressedSize;
+            unacquireCompressedItemUnsafe(iterator);
+            mItemDecompressed.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        item.mNavMeshData.mValue = std::move(value);
+        item.mCompressedNavMeshData.clear();
+        item.mCompressedNavMeshData.shrink_to_fit();
+        item.mDecompressing = false;
+        mItemDecompressed.notify_all();
+
+        return true;
     }
 
-    int NavMeshTilesCache::RecastMeshKeyView::compare(const std::string& other) const
+    void NavMeshTilesCache::unacquireCompressedItemUnsafe(ItemIterator iterator)
     {
-        CompareBytes compareBytes {other.data(), other.data() + other.size()};
+        if (--iterator->mUseCount > 0)
+            return;
 
-        if (const auto result = compareBytes(mRecastMesh.get().getIndices()))
-            return result;
+        mFreeItems.splice(mFreeItems.begin(), mBusyItems, iterator);
+        mFreeNavMeshDataSize += getSize(*iterator);
+    }
 
-        if (const auto result = compareBytes(mRecastMesh.get().getVertices()))
-            return result;
+    void NavMeshTilesCache::releaseItem(ItemIterator iterator)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
 
-        if (const auto result = compareBytes(mRecastMesh.get().getAreaTypes()))
-            return result;
+        Item& item = *iterator;
 
-        if (const auto result = compareBytes(mRecastMesh.get().getWater()))
-            return result;
+        if (--item.mUseCount > 0)
+            return;
 
-        if (const auto result = compareBytes(mOffMeshConnections.get()))
-            return result;
+        // The thread compressing the item moves it to the free items when it is done
+        if (item.mCompressing)
+            return;
 
-        if (compareBytes.mRhsIt < compareBytes.mRhsEnd)
-            return -1;
+        if (mCompress && item.mNavMeshData.mValue)
+        {
+            // While mCompressing is set the data is neither changed nor freed by other threads, so it is read
+            // without the lock
+            item.mCompressing = true;
+            lock.unlock();
+
+            std::string compressed;
+            try
+            {
+                compressed = compress(reinterpret_cast<const char*>(item.mNavMeshData.mValue.get()),
+                    static_cast<std::size_t>(item.mNavMeshData.mSize));
+            }
+            catch (const std::exception&)
+            {
+                // Keep the item uncompressed
+            }
 
-        return 0;
+            lock.lock();
+            item.mCompressing = false;
+
+            // Used again meanwhile, it is compressed by its next release
+            if (item.mUseCount > 0)
+                return;
+
+            if (!compressed.empty())
+            {
+                mUsedNavMeshDataSize -= getSize(item);
+                item.mCompressedNavMeshData = std::move(compressed);
+                item.mNavMeshData.mValue.reset();
+                mUsedNavMeshDataSize += getSize(item);
+            }
+        }
+
+        mFreeItems.splice(mFreeItems.begin(), mBusyItems, iterator);
+        mFreeNavMeshDataSize += getSize(item);
+    }
+
+    bool NavMeshTilesCache::hasKey(const Item& item, const std::string& compressedNavMeshKey,
+        const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections) const
+    {
+        if (mCompress)
+            return item.mNavMeshKey == compressedNavMeshKey;
+        return isNavMeshKey(item.mNavMeshKey, recastMesh, offMeshConnections);
     }
 }
@@ -6,7 +6,8 @@
 #include "recastmesh.hpp"
 #include "tileposition.hpp"
 
-#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <map>
 #include <list>
 #include <mutex>
@@ -30,16 +31,24 @@ namespace DetourNavigator
     public:
         struct Item
         {
-            std::atomic<std::int64_t> mUseCount;
+            std::int64_t mUseCount;
+            bool mCompressing; // the data is compressed by a thread without the lock, the item stays busy
+            bool mDecompressing; // the data is decompressed by a thread without the lock
             osg::Vec3f mAgentHalfExtents;
             TilePosition mChangedTile;
-            std::string mNavMeshKey;
-            NavMeshData mNavMeshData;
+            std::uint64_t mNavMeshKeyHash;
+            std::string mNavMeshKey; // compressed when the cache compresses items
+            NavMeshData mNavMeshData; // keeps only the size while compressed
+            std::string mCompressedNavMeshData; // only for unused items when the cache compresses items
 
-            Item(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile, std::string navMeshKey)
+            Item(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile, std::uint64_t navMeshKeyHash,
+                    std::string navMeshKey)
                 : mUseCount(0)
+                , mCompressing(false)
+                , mDecompressing(false)
                 , mAgentHalfExtents(agentHalfExtents)
                 , mChangedTile(changedTile)
+                , mNavMeshKeyHash(navMeshKeyHash)
                 , mNavMeshKey(std::move(navMeshKey))
             {}
         };
@@ -101,7 +110,10 @@ namespace DetourNavigator
             ItemIterator mIterator;
         };
 
-        NavMeshTilesCache(const std::size_t maxNavMeshDataSize);
+        /// @param compress Compress the keys of all items and the data of unused items, so more of them fit into
+        /// the same size. Used items are decompressed, since Detour reads them in place. Compression runs
+        /// without holding the lock of the cache.
+        NavMeshTilesCache(const std::size_t maxNavMeshDataSize, bool compress = false);
 
         Value get(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
             const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections);
@@ -113,81 +125,42 @@ namespace DetourNavigator
         void reportStats(unsigned int frameNumber, osg::Stats& stats) const;
 
     private:
-        class KeyView
-        {
-        public:
-            KeyView() = default;
-
-            KeyView(const std::string& value)
-                : mValue(&value) {}
-
-            const std::string& getValue() const
-            {
-                assert(mValue);
-                return *mValue;
-            }
-
-            virtual int compare(const std::string& other) const
-            {
-                assert(mValue);
-                return mValue->compare(other);
-            }
-
-            virtual bool isLess(const KeyView& other) const
-            {
-                assert(mValue);
-                return other.compare(*mValue) > 0;
-            }
-
-            friend bool operator <(const KeyView& lhs, const KeyView& rhs)
-            {
-                return lhs.isLess(rhs);
-            }
-
-        private:
-            const std::string* mValue = nullptr;
-        };
-
-        class RecastMeshKeyView : public KeyView
-        {
-        public:
-            RecastMeshKeyView(const RecastMesh& recastMesh, const std::vector<OffMeshConnection>& offMeshConnections)
-                : mRecastMesh(recastMesh), mOffMeshConnections(offMeshConnections) {}
-
-            int compare(const std::string& other) const override;
-
-            bool isLess(const KeyView& other) const override
-            {
-                return compare(other.getValue()) < 0;
-            }
-
-        private:
-            std::reference_wrapper<const RecastMesh> mRecastMesh;
-            std::reference_wrapper<const std::vector<OffMeshConnection>> mOffMeshConnections;
-        };
-
         struct TileMap
         {
-            std::map<KeyView, ItemIterator> mMap;
+            // Items by hash of their key, the keys are compared on hash collision
+            std::multimap<std::uint64_t, ItemIterator> mMap;
         };
 
         mutable std::mutex mMutex;
+        std::condition_variable mItemDecompressed;
         std::size_t mMaxNavMeshDataSize;
         std::size_t mUsedNavMeshDataSize;
         std::size_t mFreeNavMeshDataSize;
+        const bool mCompress;
         std::list<Item> mBusyItems;
         std::list<Item> mFreeItems;
         std::map<osg::Vec3f, std::map<TilePosition, TileMap>> mValues;
 
         void removeLeastRecentlyUsed();
 
-        void acquireItemUnsafe(ItemIterator iterator);
+        bool hasCandidates(const osg::Vec3f& agentHalfExtents, const TilePosition& changedTile,
+            std::uint64_t navMeshKeyHash) const;
+
+        /// Returns false, and does not acquire the item, if its decompressed data does not fit into the cache.
+        /// @param lock locks mMutex, it is unlocked while decompressing
+        bool acquireItem(ItemIterator iterator, std::unique_lock<std::mutex>& lock);
+
+        void unacquireCompressedItemUnsafe(ItemIterator iterator);
 
         void releaseItem(ItemIterator iterator);
 
+        bool hasKey(const Item& item, const std::string& compressedNavMeshKey, const RecastMesh& recastMesh,
+            const std::vector<OffMeshConnection>& offMeshConnections) const;
+
         static std::size_t getSize(const Item& item)
         {
-            return static_cast<std::size_t>(item.mNavMeshData.mSize) + 2 * item.mNavMeshKey.size();
+            const std::size_t navMeshDataSize = item.mNavMeshData.mValue ? static_cast<std::size_t>(item.mNavMeshData.mSize) : 0;
+            return navMeshDataSize + item.mCompressedNavMeshData.size() + 2 * item.mNavMeshKey.size();
         }
     };
 }
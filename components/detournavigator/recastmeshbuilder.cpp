@@ -17,9 +17,55 @@
 #include <LinearMath/btAabbUtil2.h>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 namespace DetourNavigator
 {
+    namespace
+    {
+        using VertexKey = std::array<std::uint32_t, 3>;
+
+        struct VertexKeyHash
+        {
+            std::size_t operator ()(const VertexKey& value) const
+            {
+                std::size_t result = value[0];
+                result = result * 31 + value[1];
+                result = result * 31 + value[2];
+                return result;
+            }
+        };
+
+        /// Concave shapes produce separate vertices for each triangle so most of them are repeated multiple times.
+        /// Vertices are compared by binary representation to keep exactly the same coordinates.
+        void removeDuplicateVertices(const std::vector<int>& indices, const std::vector<float>& vertices,
+            std::vector<int>& uniqueIndices, std::vector<float>& uniqueVertices)
+        {
+            std::unordered_map<VertexKey, int, VertexKeyHash> vertexIndices;
+            vertexIndices.reserve(vertices.size() / 3);
+            std::vector<int> indicesMap(vertices.size() / 3);
+            uniqueVertices.reserve(vertices.size());
+
+            for (std::size_t i = 0; i < indicesMap.size(); ++i)
+            {
+                VertexKey key;
+                std::memcpy(key.data(), vertices.data() + i * 3, sizeof(key));
+                const auto newIndex = static_cast<int>(uniqueVertices.size() / 3);
+                const auto inserted = vertexIndices.emplace(key, newIndex);
+                if (inserted.second)
+                    uniqueVertices.insert(uniqueVertices.end(), vertices.begin() + i * 3, vertices.begin() + i * 3 + 3);
+                indicesMap[i] = inserted.first->second;
+            }
+
+            uniqueIndices.reserve(indices.size());
+            std::transform(indices.begin(), indices.end(), std::back_inserter(uniqueIndices),
+                [&] (int index) { return indicesMap[static_cast<std::size_t>(index)]; });
+        }
+    }
+
     using BulletHelpers::makeProcessTriangleCallback;
 
     RecastMeshBuilder::RecastMeshBuilder(const Settings& settings, const TileBounds& bounds)
@@ -112,9 +158,29 @@ namespace DetourNavigator
         mWater.push_back(RecastMesh::Water {cellSize, transform});
     }
 
+    void RecastMeshBuilder::addTriangles(const RecastMeshObjectTriangles& triangles)
+    {
+        const auto indexOffset = static_cast<int>(mVertices.size() / 3);
+        std::transform(triangles.mIndices.begin(), triangles.mIndices.end(), std::back_inserter(mIndices),
+            [&] (int index) { return index + indexOffset; });
+        mVertices.insert(mVertices.end(), triangles.mVertices.begin(), triangles.mVertices.end());
+        mAreaTypes.insert(mAreaTypes.end(), triangles.mAreaTypes.begin(), triangles.mAreaTypes.end());
+    }
+
+    RecastMeshObjectTriangles RecastMeshBuilder::releaseTriangles()
+    {
+        RecastMeshObjectTriangles result {std::move(mIndices), std::move(mVertices), std::move(mAreaTypes)};
+        reset();
+        return result;
+    }
+
     std::shared_ptr<RecastMesh> RecastMeshBuilder::create() const
     {
-        return std::make_shared<RecastMesh>(mIndices, mVertices, mAreaTypes, mWater, mSettings.get().mTrianglesPerChunk);
+        std::vector<int> indices;
+        std::vector<float> vertices;
+        removeDuplicateVertices(mIndices, mVertices, indices, vertices);
+        return std::make_shared<RecastMesh>(std::move(indices), std::move(vertices), mAreaTypes, mWater,
+            mSettings.get().mTrianglesPerChunk);
     }
 
     void RecastMeshBuilder::reset()
@@ -17,6 +17,14 @@ namespace DetourNavigator
 {
     struct Settings;
 
+    /// Geometry of a single object inside builder bounds.
+    struct RecastMeshObjectTriangles
+    {
+        std::vector<int> mIndices;
+        std::vector<float> mVertices;
+        std::vector<AreaType> mAreaTypes;
+    };
+
     class RecastMeshBuilder
     {
     public:
@@ -34,6 +42,12 @@ namespace DetourNavigator
 
         void addWater(const int mCellSize, const btTransform& transform);
 
+        /// Appends geometry built before by another builder with the same settings and bounds.
+        void addTriangles(const RecastMeshObjectTriangles& triangles);
+
+        /// Moves out all added objects geometry and resets builder.
+        RecastMeshObjectTriangles releaseTriangles();
+
         std::shared_ptr<RecastMesh> create() const;
 
         void reset();
@@ -7,13 +7,15 @@ namespace DetourNavigator
     RecastMeshManager::RecastMeshManager(const Settings& settings, const TileBounds& bounds)
         : mShouldRebuild(false)
         , mMeshBuilder(settings, bounds)
+        , mObjectMeshBuilder(settings, bounds)
     {
     }
 
     bool RecastMeshManager::addObject(const ObjectId id, const btCollisionShape& shape, const btTransform& transform,
                                       const AreaType areaType)
     {
-        const auto iterator = mObjectsOrder.emplace(mObjectsOrder.end(), RecastMeshObject(shape, transform, areaType));
+        const auto iterator = mObjectsOrder.emplace(mObjectsOrder.end(),
+            Object {RecastMeshObject(shape, transform, areaType), nullptr});
         if (!mObjects.emplace(id, iterator).second)
         {
             mObjectsOrder.erase(iterator);
@@ -28,8 +30,9 @@ namespace DetourNavigator
         const auto object = mObjects.find(id);
         if (object == mObjects.end())
             return false;
-        if (!object->second->update(transform, areaType))
+        if (!object->second->mObject.update(transform, areaType))
             return false;
+        object->second->mTriangles.reset();
         mShouldRebuild = true;
         return mShouldRebuild;
     }
@@ -39,7 +42,8 @@ namespace DetourNavigator
         const auto object = mObjects.find(id);
         if (object == mObjects.end())
             return boost::none;
-        const RemovedRecastMeshObject result {object->second->getShape(), object->second->getTransform()};
+        const RemovedRecastMeshObject result {object->second->mObject.getShape(),
+                                              object->second->mObject.getTransform()};
         mObjectsOrder.erase(object->second);
         mObjects.erase(object);
         mShouldRebuild = true;
@@ -89,8 +93,15 @@ namespace DetourNavigator
         mMeshBuilder.reset();
         for (const auto& v : mWaterOrder)
             mMeshBuilder.addWater(v.mCellSize, v.mTransform);
-        for (const auto& v : mObjectsOrder)
-            mMeshBuilder.addObject(v.getShape(), v.getTransform(), v.getAreaType());
+        for (auto& v : mObjectsOrder)
+        {
+            if (!v.mTriangles)
+            {
+                mObjectMeshBuilder.addObject(v.mObject.getShape(), v.mObject.getTransform(), v.mObject.getAreaType());
+                v.mTriangles.reset(new RecastMeshObjectTriangles(mObjectMeshBuilder.releaseTriangles()));
+            }
+            mMeshBuilder.addTriangles(*v.mTriangles);
+        }
         mShouldRebuild = false;
     }
 }
@@ -14,6 +14,7 @@
 #include <map>
 #include <unordered_map>
 #include <list>
+#include <memory>
 
 class btCollisionShape;
 
@@ -52,10 +53,18 @@ namespace DetourNavigator
         bool isEmpty() const;
 
     private:
+        struct Object
+        {
+            RecastMeshObject mObject;
+            // Object geometry is cached to avoid processing all objects triangles when only one is changed
+            std::unique_ptr<RecastMeshObjectTriangles> mTriangles;
+        };
+
         bool mShouldRebuild;
         RecastMeshBuilder mMeshBuilder;
-        std::list<RecastMeshObject> mObjectsOrder;
-        std::unordered_map<ObjectId, std::list<RecastMeshObject>::iterator> mObjects;
+        RecastMeshBuilder mObjectMeshBuilder;
+        std::list<Object> mObjectsOrder;
+        std::unordered_map<ObjectId, std::list<Object>::iterator> mObjects;
         std::list<Water> mWaterOrder;
         std::map<osg::Vec2i, std::list<Water>::iterator> mWater;
 
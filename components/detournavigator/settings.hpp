@@ -3,12 +3,15 @@
 
 #include <boost/optional.hpp>
 
+#include <chrono>
 #include <string>
 
 namespace DetourNavigator
 {
     struct Settings
     {
+        bool mEnableNavMeshDiskCache = false;
+        bool mCompressNavMeshTilesCache = false;
         bool mEnableWriteRecastMeshToFile = false;
         bool mEnableWriteNavMeshToFile = false;
         bool mEnableRecastMeshFileNameRevision = false;
@@ -32,12 +35,16 @@ namespace DetourNavigator
         int mRegionMinSize = 0;
         int mTileSize = 0;
         std::size_t mAsyncNavMeshUpdaterThreads = 0;
+        std::size_t mAsyncPathFinderThreads = 0;
         std::size_t mMaxNavMeshTilesCacheSize = 0;
+        std::size_t mMaxNavMeshDiskCacheSize = 0;
         std::size_t mMaxPolygonPathSize = 0;
         std::size_t mMaxSmoothPathSize = 0;
         std::size_t mTrianglesPerChunk = 0;
         std::string mRecastMeshPathPrefix;
+        std::chrono::milliseconds mMinUpdateInterval {0};
         std::string mNavMeshPathPrefix;
+        std::string mNavMeshDiskCachePath;
     };
 
     boost::optional<Settings> makeSettingsFromSettingsManager();
@@ -0,0 +1,51 @@
+#include "solidheightfieldcache.hpp"
+#include "recastmesh.hpp"
+
+namespace DetourNavigator
+{
+    SolidHeightfieldCache::SolidHeightfieldCache(std::size_t maxItems)
+        : mMaxItems(maxItems)
+    {
+    }
+
+    std::shared_ptr<const SolidHeightfield> SolidHeightfieldCache::get(const TilePosition& tile,
+        const std::shared_ptr<RecastMesh>& recastMesh) const
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+
+        const auto it = mItems.find(tile);
+        if (it == mItems.end())
+            return nullptr;
+
+        // Recast mesh is recreated on each change of the tile so the same instance means the same geometry
+        if (it->second.mRecastMesh.lock() != recastMesh)
+            return nullptr;
+
+        return it->second.mValue;
+    }
+
+    void SolidHeightfieldCache::set(const TilePosition& tile, const std::shared_ptr<RecastMesh>& recastMesh,
+        std::shared_ptr<const SolidHeightfield> value)
+    {
+        if (mMaxItems == 0)
+            return;
+
+        const std::lock_guard<std::mutex> lock(mMutex);
+
+        const auto emplaced = mItems.emplace(tile, Item {recastMesh, value});
+
+        if (!emplaced.second)
+        {
+            emplaced.first->second = Item {recastMesh, std::move(value)};
+            return;
+        }
+
+        mInsertionOrder.push_back(tile);
+
+        while (mItems.size() > mMaxItems)
+        {
+            mItems.erase(mInsertionOrder.front());
+            mInsertionOrder.pop_front();
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef OPENMW_COMPONENTS_DETOURNAVIGATOR_SOLIDHEIGHTFIELDCACHE_H
+#define OPENMW_COMPONENTS_DETOURNAVIGATOR_SOLIDHEIGHTFIELDCACHE_H
+
+#include "tileposition.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DetourNavigator
+{
+    class RecastMesh;
+
+    /// Spans of recast mesh solid objects rasterized for a tile. Rasterization doesn't depend on agent half extents,
+    /// so the same spans are used to generate the tile for each agent.
+    struct SolidHeightfield
+    {
+        struct Span
+        {
+            unsigned short mMin;
+            unsigned short mMax;
+            unsigned char mArea;
+        };
+
+        bool mHasTriangles = false;
+        // Begin of each heightfield column spans in mSpans and the end of the last one
+        std::vector<std::size_t> mColumns;
+        std::vector<Span> mSpans;
+    };
+
+    /// Keeps solid heightfields of recently generated tiles while their recast meshes are not changed.
+    class SolidHeightfieldCache
+    {
+    public:
+        explicit SolidHeightfieldCache(std::size_t maxItems);
+
+        std::shared_ptr<const SolidHeightfield> get(const TilePosition& tile,
+            const std::shared_ptr<RecastMesh>& recastMesh) const;
+
+        void set(const TilePosition& tile, const std::shared_ptr<RecastMesh>& recastMesh,
+            std::shared_ptr<const SolidHeightfield> value);
+
+    private:
+        struct Item
+        {
+            std::weak_ptr<const RecastMesh> mRecastMesh;
+            std::shared_ptr<const SolidHeightfield> mValue;
+        };
+
+        const std::size_t mMaxItems;
+        mutable std::mutex mMutex;
+        std::map<TilePosition, Item> mItems;
+        std::deque<TilePosition> mInsertionOrder;
+    };
+}
+
+#endif
@@ -9,28 +9,6 @@ namespace DetourNavigator
         : mSettings(settings)
     {}
 
-    bool TileCachedRecastMeshManager::addObject(const ObjectId id, const btCollisionShape& shape,
-                                                const btTransform& transform, const AreaType areaType)
-    {
-        bool result = false;
-        auto& tilesPositions = mObjectsTilesPositions[id];
-        const auto border = getBorderSize(mSettings);
-        {
-            auto tiles = mTiles.lock();
-            getTilesPositions(shape, transform, mSettings, [&] (const TilePosition& tilePosition)
-                {
-                    if (addTile(id, shape, transform, areaType, tilePosition, border, tiles.get()))
-                    {
-                        tilesPositions.insert(tilePosition);
-                        result = true;
-                    }
-                });
-        }
-        if (result)
-            ++mRevision;
-        return result;
-    }
-
     std::vector<TilePosition> TileCachedRecastMeshManager::updateObject(const ObjectId id, const btCollisionShape& shape,
         const btTransform& transform, const AreaType areaType)
     {
@@ -2,6 +2,8 @@
 #define OPENMW_COMPONENTS_DETOURNAVIGATOR_TILECACHEDRECASTMESHMANAGER_H
 
 #include "cachedrecastmeshmanager.hpp"
+#include "gettilespositions.hpp"
+#include "settingsutils.hpp"
 #include "tileposition.hpp"
 
 #include <components/misc/guarded.hpp>
@@ -18,7 +20,36 @@ namespace DetourNavigator
         TileCachedRecastMeshManager(const Settings& settings);
 
         bool addObject(const ObjectId id, const btCollisionShape& shape, const btTransform& transform,
-                       const AreaType areaType);
+                       const AreaType areaType)
+        {
+            return addObject(id, shape, transform, areaType, [] (const TilePosition&) {});
+        }
+
+        /// @param onChangedTile Called for each tile the object was added to, so the caller doesn't need to
+        ///  find the tiles of the shape again.
+        template <class OnChangedTile>
+        bool addObject(const ObjectId id, const btCollisionShape& shape, const btTransform& transform,
+                       const AreaType areaType, OnChangedTile&& onChangedTile)
+        {
+            bool result = false;
+            auto& tilesPositions = mObjectsTilesPositions[id];
+            const auto border = getBorderSize(mSettings);
+            {
+                auto tiles = mTiles.lock();
+                getTilesPositions(shape, transform, mSettings, [&] (const TilePosition& tilePosition)
+                    {
+                        if (addTile(id, shape, transform, areaType, tilePosition, border, tiles.get()))
+                        {
+                            tilesPositions.insert(tilePosition);
+                            onChangedTile(tilePosition);
+                            result = true;
+                        }
+                    });
+            }
+            if (result)
+                ++mRevision;
+            return result;
+        }
 
         std::vector<TilePosition> updateObject(const ObjectId id, const btCollisionShape& shape,
                                                const btTransform& transform, const AreaType areaType);
@@ -0,0 +1,78 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/iostreams/filter/zlib.hpp>
+
+namespace
+{
+    // Decompressing a few blocks at once is much faster than following every small read of the ESMReader
+    const std::size_t sReadAhead = 256 * 1024;
+
+    const std::size_t sBlockSize = 64 * 1024;
+}
+
+namespace ESM
+{
+    bool isCompressed(const char* data, std::size_t size)
+    {
+        return size >= sizeof(sCompressedSignature)
+            && std::memcmp(data, sCompressedSignature, sizeof(sCompressedSignature)) == 0;
+    }
+
+    void writeCompressed(std::ostream& stream, const char* data, std::size_t size, int level)
+    {
+        const std::uint64_t uncompressedSize = size;
+        stream.write(sCompressedSignature, sizeof(sCompressedSignature));
+        stream.write(reinterpret_cast<const char*>(&uncompressedSize), sizeof(uncompressedSize));
+
+        boost::iostreams::filtering_ostreambuf streamBuf;
+        streamBuf.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(level)));
+        streamBuf.push(stream);
+        for (std::size_t offset = 0; offset < size; offset += sBlockSize)
+        {
+            const std::size_t blockSize = std::min(sBlockSize, size - offset);
+            if (streamBuf.sputn(data + offset, blockSize) != static_cast<std::streamsize>(blockSize))
+                throw std::runtime_error("Failed to compress data");
+        }
+        // Flushes the remaining compressed data
+        streamBuf.reset();
+    }
+
+    Decompressor::Decompressor(std::shared_ptr<std::istream> stream)
+        : mStream(std::move(stream))
+        , mDecompressed(0)
+    {
+        char signature[sizeof(sCompressedSignature)];
+        std::uint64_t size = 0;
+        mStream->read(signature, sizeof(signature));
+        mStream->read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!*mStream || !isCompressed(signature, sizeof(signature)))
+            throw std::runtime_error("Not a compressed file");
+
+        mStreamBuf.push(boost::iostreams::zlib_decompressor());
+        mStreamBuf.push(*mStream);
+
+        // Never reallocated, so the decompressed data stays where it is
+        mData.resize(static_cast<std::size_t>(size));
+    }
+
+    std::size_t Decompressor::decompress(std::size_t end)
+    {
+        if (end <= mDecompressed)
+            return mDecompressed;
+
+        const std::size_t target = std::min(mData.size(), std::max(end, mDecompressed + sReadAhead));
+        while (mDecompressed < target)
+        {
+            const std::streamsize read = mStreamBuf.sgetn(mData.data() + mDecompressed, target - mDecompressed);
+            if (read <= 0)
+                break;
+            mDecompressed += static_cast<std::size_t>(read);
+        }
+        return mDecompressed;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef OPENMW_COMPONENTS_ESM_COMPRESSION_H
+#define OPENMW_COMPONENTS_ESM_COMPRESSION_H
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+namespace ESM
+{
+    /// Compressed files start with this signature and the uncompressed size as a 64 bit integer,
+    /// followed by the zlib stream of the regular file.
+    const char sCompressedSignature[4] = {'O', 'M', 'W', 'Z'};
+
+    bool isCompressed(const char* data, std::size_t size);
+
+    /// Write \a size bytes of \a data to \a stream as a compressed file, compressing one block after another.
+    /// @param level zlib compression level, 1 (fastest) to 9 (smallest)
+    void writeCompressed(std::ostream& stream, const char* data, std::size_t size, int level);
+
+    /// Decompresses a compressed file into memory, only as far as it is read.
+    class Decompressor
+    {
+        public:
+            /// @note Throws if \a stream does not contain a compressed file.
+            explicit Decompressor(std::shared_ptr<std::istream> stream);
+
+            std::size_t getSize() const { return mData.size(); }
+
+            const char* getData() const { return mData.data(); }
+
+            /// Decompress the data up to at least \a end, and some more to read ahead.
+            /// @return End of the data decompressed so far.
+            std::size_t decompress(std::size_t end);
+
+        private:
+            std::shared_ptr<std::istream> mStream;
+            boost::iostreams::filtering_istreambuf mStreamBuf;
+            std::vector<char> mData;
+            std::size_t mDecompressed;
+    };
+}
+
+#endif
@@ -1,7 +1,18 @@
 #include "esmreader.hpp"
 
+#include <cstring>
 #include <stdexcept>
 
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "compression.hpp"
+
+namespace
+{
+    // Keeping every content file mapped can exhaust the address space of 32-bit builds
+    const bool sMemoryMapFiles = sizeof(void*) >= 8;
+}
+
 namespace ESM
 {
 
@@ -15,7 +26,7 @@ using namespace Misc;
 ESM_Context ESMReader::getContext()
 {
     // Update the file position before returning
-    mCtx.filePos = mEsm->tellg();
+    mCtx.filePos = getFileOffset();
     return mCtx;
 }
 
@@ -23,6 +34,9 @@ ESMReader::ESMReader()
     : mIdx(0)
     , mRecordFlags(0)
     , mBuffer(50*1024)
+    , mMappedBegin(nullptr)
+    , mMappedPos(nullptr)
+    , mMappedEnd(nullptr)
     , mGlobalReaderList(nullptr)
     , mEncoder(nullptr)
     , mFileSize(0)
@@ -45,12 +59,24 @@ void ESMReader::restoreContext(const ESM_Context &rc)
     mCtx = rc;
 
     // Make sure we seek to the right place
-    mEsm->seekg(mCtx.filePos);
+    if (mMapping)
+    {
+        if (mCtx.filePos > mFileSize)
+            fail("Context position is outside of the file");
+        if (mDecompressor)
+            mMappedEnd = mMappedBegin + mDecompressor->decompress(mCtx.filePos);
+        mMappedPos = mMappedBegin + mCtx.filePos;
+    }
+    else
+        mEsm->seekg(mCtx.filePos);
 }
 
 void ESMReader::close()
 {
     mEsm.reset();
+    mMapping.reset();
+    mDecompressor.reset();
+    mMappedBegin = mMappedPos = mMappedEnd = nullptr;
     clearCtx();
     mHeader.blank();
 }
@@ -78,7 +104,60 @@ void ESMReader::openRaw(Files::IStreamPtr _esm, const std::string& name)
 
 void ESMReader::openRaw(const std::string& filename)
 {
-    openRaw(Files::openConstrainedFileStream(filename.c_str()), filename);
+    std::shared_ptr<boost::iostreams::mapped_file_source> mapping;
+    if (sMemoryMapFiles)
+    {
+        try
+        {
+            mapping = std::make_shared<boost::iostreams::mapped_file_source>(filename);
+        }
+        catch (const std::exception&)
+        {
+            // Empty files can't be mapped, and mapping may fail for other reasons too.
+            // Regular reads will report the actual problem, if there is one.
+            mapping.reset();
+        }
+    }
+
+    if (!mapping || !mapping->is_open())
+    {
+        Files::IStreamPtr stream = Files::openConstrainedFileStream(filename.c_str());
+        char signature[sizeof(sCompressedSignature)] = {};
+        stream->read(signature, sizeof(signature));
+        if (stream->gcount() == sizeof(signature) && isCompressed(signature, sizeof(signature)))
+        {
+            openCompressed(filename);
+            return;
+        }
+        stream->clear();
+        openRaw(stream, filename);
+        return;
+    }
+
+    if (isCompressed(mapping->data(), mapping->size()))
+    {
+        openCompressed(filename);
+        return;
+    }
+
+    close();
+    mMapping = mapping;
+    mMappedBegin = mMappedPos = mapping->data();
+    mMappedEnd = mMappedBegin + mapping->size();
+    mCtx.filename = filename;
+    mCtx.leftFile = mFileSize = mapping->size();
+}
+
+void ESMReader::openCompressed(const std::string& filename)
+{
+    std::shared_ptr<Decompressor> decompressor
+        = std::make_shared<Decompressor>(Files::openConstrainedFileStream(filename.c_str()));
+
+    close();
+    mMapping = mDecompressor = decompressor;
+    mMappedBegin = mMappedPos = mMappedEnd = decompressor->getData();
+    mCtx.filename = filename;
+    mCtx.leftFile = mFileSize = decompressor->getSize();
 }
 
 void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
@@ -95,7 +174,14 @@ void ESMReader::open(Files::IStreamPtr _esm, const std::string &name)
 
 void ESMReader::open(const std::string &file)
 {
-    open (Files::openConstrainedFileStream (file.c_str ()), file);
+    openRaw(file);
+
+    if (getRecName() != "TES3")
+        fail("Not a valid Morrowind file");
+
+    getRecHeader();
+
+    mHeader.load (*this);
 }
 
 int64_t ESMReader::getHNLong(const char *name)
@@ -127,7 +213,8 @@ std::string ESMReader::getHString()
     // them. For some reason, they break the rules, and contain a byte
     // (value 0) even if the header says there is no data. If
     // Morrowind accepts it, so should we.
-    if (mCtx.leftSub == 0 && !mEsm->peek())
+    const bool nextIsZero = mMapping ? (decompressMappedData(1) && *mMappedPos == 0) : !mEsm->peek();
+    if (mCtx.leftSub == 0 && nextIsZero)
     {
         // Skip the following zero byte
         mCtx.leftRec--;
@@ -158,6 +245,24 @@ void ESMReader::getHNExact(void*p, int size, const char* name)
     getHExact(p, size);
 }
 
+DataView ESMReader::getHView()
+{
+    getSubHeader();
+
+    DataView view;
+    view.mSize = mCtx.leftSub;
+    if (mMapping)
+        view.mData = getMappedData(view.mSize);
+    else
+    {
+        if (mBuffer.size() < view.mSize)
+            mBuffer.resize(view.mSize);
+        getExact(mBuffer.data(), view.mSize);
+        view.mData = mBuffer.data();
+    }
+    return view;
+}
+
 // Get the next subrecord name and check if it matches the parameter
 void ESMReader::getSubNameIs(const char* name)
 {
@@ -320,8 +425,33 @@ void ESMReader::getRecHeader(uint32_t &flags)
  *
  *************************************************************************/
 
+bool ESMReader::decompressMappedData(size_t size)
+{
+    if (size <= static_cast<size_t>(mMappedEnd - mMappedPos))
+        return true;
+    if (!mDecompressor)
+        return false;
+    mMappedEnd = mMappedBegin + mDecompressor->decompress(mMappedPos - mMappedBegin + size);
+    return size <= static_cast<size_t>(mMappedEnd - mMappedPos);
+}
+
+const char *ESMReader::getMappedData(size_t size)
+{
+    if (!decompressMappedData(size))
+        fail("Read error: unexpected end of file");
+    const char *data = mMappedPos;
+    mMappedPos += size;
+    return data;
+}
+
 void ESMReader::getExact(void*x, int size)
 {
+    if (mMapping)
+    {
+        std::memcpy(x, getMappedData(size), size);
+        return;
+    }
+
     try
     {
         mEsm->read((char*)x, size);
@@ -334,6 +464,24 @@ void ESMReader::getExact(void*x, int size)
 
 std::string ESMReader::getString(int size)
 {
+    if (mMapping)
+    {
+        const char *ptr = getMappedData(size);
+        const size_t length = strnlen(ptr, size);
+
+        // The encoder needs a zero terminated string, so only unterminated strings are copied into the buffer
+        if (!mEncoder)
+            return std::string (ptr, length);
+        if (length < static_cast<size_t>(size))
+            return mEncoder->getUtf8(ptr, length);
+
+        if (mBuffer.size() <= length)
+            mBuffer.resize(3*length);
+        std::memcpy(&mBuffer[0], ptr, length);
+        mBuffer[length] = 0;
+        return mEncoder->getUtf8(&mBuffer[0], length);
+    }
+
     size_t s = size;
     if (mBuffer.size() <= s)
         // Add some extra padding to reduce the chance of having to resize
@@ -366,8 +514,8 @@ void ESMReader::fail(const std::string &msg)
     ss << "\n  File: " << mCtx.filename;
     ss << "\n  Record: " << mCtx.recName.toString();
     ss << "\n  Subrecord: " << mCtx.subName.toString();
-    if (mEsm.get())
-        ss << "\n  Offset: 0x" << hex << mEsm->tellg();
+    if (mEsm.get() || mMapping)
+        ss << "\n  Offset: 0x" << hex << getFileOffset();
     throw std::runtime_error(ss.str());
 }
 
@@ -378,11 +526,18 @@ void ESMReader::setEncoder(ToUTF8::Utf8Encoder* encoder)
 
 size_t ESMReader::getFileOffset()
 {
+    if (mMapping)
+        return mMappedPos - mMappedBegin;
     return mEsm->tellg();
 }
 
 void ESMReader::skip(int bytes)
 {
+    if (mMapping)
+    {
+        getMappedData(bytes);
+        return;
+    }
     mEsm->seekg(getFileOffset()+bytes);
 }
 
@@ -17,6 +17,17 @@
 
 namespace ESM {
 
+class Decompressor;
+
+/// Read-only view of raw subrecord data
+struct DataView
+{
+  const char *mData;
+  size_t mSize;
+
+  std::string toString() const { return std::string(mData, mSize); }
+};
+
 class ESMReader
 {
 public:
@@ -68,10 +79,15 @@ public:
   /// currently open file first, if any.
   void open(Files::IStreamPtr _esm, const std::string &name);
 
+  /// Load ES file by name. On 64-bit builds the file is memory mapped,
+  /// so reads and skips within it don't need any system calls.
   void open(const std::string &file);
 
   void openRaw(const std::string &filename);
 
+  /// Is the current file memory mapped?
+  bool isMemoryMapped() const { return mMapping != nullptr; }
+
   /// Get the current position in the file. Make sure that the file has been opened!
   size_t getFileOffset();
 
@@ -166,6 +182,12 @@ public:
   // Read the given number of bytes from a named subrecord
   void getHNExact(void*p, int size, const char* name);
 
+  /// Read a subrecord, including the sub-record header (but not the name), without
+  /// converting it. When the file is memory mapped the view points straight into the
+  /// mapping and stays valid until the file is closed. Otherwise it points into an
+  /// internal buffer and is only valid until the next read.
+  DataView getHView();
+
   /*************************************************************************
    *
    *  Low level sub-record methods
@@ -270,8 +292,27 @@ public:
 private:
   void clearCtx();
 
+  /// Get a pointer to the next 'size' bytes of the mapping and advance past them
+  const char *getMappedData(size_t size);
+
+  /// Make sure the next 'size' bytes of a decompressed file are available
+  /// \return false if the file is shorter
+  bool decompressMappedData(size_t size);
+
+  /// Opens a compressed file, handled like a memory mapped file
+  void openCompressed(const std::string& filename);
+
   Files::IStreamPtr mEsm;
 
+  // Mapping of the whole file, with the current read position. Only set if the file is
+  // memory mapped, mEsm is unused then.
+  // Owner of the mapped data, either a mapped file or a Decompressor
+  std::shared_ptr<const void> mMapping;
+  std::shared_ptr<Decompressor> mDecompressor;
+  const char *mMappedBegin;
+  const char *mMappedPos;
+  const char *mMappedEnd;
+
   ESM_Context mCtx;
 
   unsigned int mRecordFlags;
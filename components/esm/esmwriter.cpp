@@ -1,6 +1,7 @@
 #include "esmwriter.hpp"
 
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 
@@ -11,10 +12,8 @@ namespace ESM
     ESMWriter::ESMWriter()
         : mRecords()
         , mStream(nullptr)
-        , mHeaderPos()
         , mEncoder(nullptr)
         , mRecordCount(0)
-        , mCounting(true)
         , mHeader()
     {}
 
@@ -70,7 +69,7 @@ namespace ESM
     {
         mRecordCount = 0;
         mRecords.clear();
-        mCounting = true;
+        mBuffer.clear();
         mStream = &file;
 
         startRecord("TES3", 0);
@@ -80,10 +79,27 @@ namespace ESM
         endRecord("TES3");
     }
 
+    void ESMWriter::saveRecords(std::ostream& file)
+    {
+        mRecordCount = 0;
+        mRecords.clear();
+        mBuffer.clear();
+        mStream = &file;
+    }
+
     void ESMWriter::close()
     {
         if (!mRecords.empty())
             throw std::runtime_error ("Unclosed record remaining");
+
+        flush();
+    }
+
+    void ESMWriter::flush()
+    {
+        if (!mBuffer.empty())
+            mStream->write(mBuffer.data(), mBuffer.size());
+        mBuffer.clear();
     }
 
     void ESMWriter::startRecord(const std::string& name, uint32_t flags)
@@ -93,14 +109,12 @@ namespace ESM
         writeName(name);
         RecordData rec;
         rec.name = name;
-        rec.position = mStream->tellp();
-        rec.size = 0;
+        rec.position = mBuffer.size();
         writeT<uint32_t>(0); // Size goes here
         writeT<uint32_t>(0); // Unused header?
         writeT(flags);
+        rec.start = mBuffer.size();
         mRecords.push_back(rec);
-
-        assert(mRecords.back().size == 0);
     }
 
     void ESMWriter::startRecord (uint32_t name, uint32_t flags)
@@ -121,12 +135,10 @@ namespace ESM
         writeName(name);
         RecordData rec;
         rec.name = name;
-        rec.position = mStream->tellp();
-        rec.size = 0;
+        rec.position = mBuffer.size();
         writeT<uint32_t>(0); // Size goes here
+        rec.start = mBuffer.size();
         mRecords.push_back(rec);
-
-        assert(mRecords.back().size == 0);
     }
 
     void ESMWriter::endRecord(const std::string& name)
@@ -135,14 +147,11 @@ namespace ESM
         assert(rec.name == name);
         mRecords.pop_back();
 
-        mStream->seekp(rec.position);
-
-        mCounting = false;
-        write (reinterpret_cast<const char*> (&rec.size), sizeof(uint32_t));
-        mCounting = true;
-
-        mStream->seekp(0, std::ios::end);
+        const uint32_t size = static_cast<uint32_t>(mBuffer.size() - rec.start);
+        std::memcpy(mBuffer.data() + rec.position, &size, sizeof(uint32_t));
 
+        if (mRecords.empty())
+            flush();
     }
 
     void ESMWriter::endRecord (uint32_t name)
@@ -214,13 +223,7 @@ namespace ESM
 
     void ESMWriter::write(const char* data, size_t size)
     {
-        if (mCounting && !mRecords.empty())
-        {
-            for (std::list<RecordData>::iterator it = mRecords.begin(); it != mRecords.end(); ++it)
-                it->size += size;
-        }
-
-        mStream->write(data, size);
+        mBuffer.insert(mBuffer.end(), data, data + size);
     }
 
     void ESMWriter::setEncoder(ToUTF8::Utf8Encoder* encoder)
@@ -3,6 +3,7 @@
 
 #include <iosfwd>
 #include <list>
+#include <vector>
 
 #include "esmcommon.hpp"
 #include "loadtes3.hpp"
@@ -19,8 +20,8 @@ class ESMWriter
         struct RecordData
         {
             std::string name;
-            std::streampos position;
-            uint32_t size;
+            std::size_t position; // of the size in mBuffer
+            std::size_t start; // of the data in mBuffer
         };
 
     public:
@@ -52,8 +53,12 @@ class ESMWriter
         void save(std::ostream& file);
         ///< Start saving a file by writing the TES3 header.
 
+        void saveRecords(std::ostream& file);
+        ///< Start saving records without the TES3 header, e.g. into a buffer that is appended to a file later.
+
         void close();
-        ///< \note Does not close the stream.
+        ///< Write the remaining buffered data to the stream.
+        /// \note Does not close the stream.
 
         void writeHNString(const std::string& name, const std::string& data);
         void writeHNString(const std::string& name, const std::string& data, size_t size);
@@ -127,12 +132,15 @@ public:
         void write(const char* data, size_t size);
 
     private:
+        void flush();
+
         std::list<RecordData> mRecords;
         std::ostream* mStream;
-        std::streampos mHeaderPos;
+        /// Records are assembled here while they are open and their sizes are patched in place,
+        /// then written to the stream at once.
+        std::vector<char> mBuffer;
         ToUTF8::Utf8Encoder* mEncoder;
         int mRecordCount;
-        bool mCounting;
 
         Header mHeader;
     };
@@ -145,35 +145,6 @@ namespace ESMTerrain
         normal.normalize();
     }
 
-    void Storage::fixColour (osg::Vec4ub& color, int cellX, int cellY, int col, int row, LandCache& cache)
-    {
-        if (col == ESM::Land::LAND_SIZE-1)
-        {
-            ++cellY;
-            col = 0;
-        }
-        if (row == ESM::Land::LAND_SIZE-1)
-        {
-            ++cellX;
-            row = 0;
-        }
-
-        const LandObject* land = getLand(cellX, cellY, cache);
-        const ESM::Land::LandData* data = land ? land->getData(ESM::Land::DATA_VCLR) : 0;
-        if (data)
-        {
-            color.r() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3];
-            color.g() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+1];
-            color.b() = data->mColours[col*ESM::Land::LAND_SIZE*3+row*3+2];
-        }
-        else
-        {
-            color.r() = 255;
-            color.g() = 255;
-            color.b() = 255;
-        }
-    }
-
     void Storage::fillVertexBuffers (int lodLevel, float size, const osg::Vec2f& center,
                                             osg::ref_ptr<osg::Vec3Array> positions,
                                             osg::ref_ptr<osg::Vec3Array> normals,
@@ -193,8 +164,8 @@ namespace ESMTerrain
         normals->resize(numVerts*numVerts);
         colours->resize(numVerts*numVerts);
 
-        osg::Vec3f normal;
-        osg::Vec4ub color;
+        const float vertScale = 1.f / float(numVerts - 1);
+        const float chunkWorldSize = size * Constants::CellSizeInUnits;
 
         float vertY = 0;
         float vertX = 0;
@@ -209,17 +180,6 @@ namespace ESMTerrain
             float vertX_ = 0; // of current cell corner
             for (int cellX = startCellX; cellX < startCellX + std::ceil(size); ++cellX)
             {
-                const LandObject* land = getLand(cellX, cellY, cache);
-                const ESM::Land::LandData *heightData = 0;
-                const ESM::Land::LandData *normalData = 0;
-                const ESM::Land::LandData *colourData = 0;
-                if (land)
-                {
-                    heightData = land->getData(ESM::Land::DATA_VHGT);
-                    normalData = land->getData(ESM::Land::DATA_VNML);
-                    colourData = land->getData(ESM::Land::DATA_VCLR);
-                }
-
                 int rowStart = 0;
                 int colStart = 0;
                 // Skip the first row / column unless we're at a chunk edge,
@@ -236,73 +196,84 @@ namespace ESMTerrain
                 int rowEnd = std::min(static_cast<int>(rowStart + std::min(1.f, size) * (ESM::Land::LAND_SIZE-1) + 1), static_cast<int>(ESM::Land::LAND_SIZE));
                 int colEnd = std::min(static_cast<int>(colStart + std::min(1.f, size) * (ESM::Land::LAND_SIZE-1) + 1), static_cast<int>(ESM::Land::LAND_SIZE));
 
+                // Fetch the land data once per cell.
+                // Normals and colours apparently don't connect seamlessly between cells, so the last row and column
+                // are taken from the first ones of the neighbour cells: [0] this cell, [1] next X, [2] next Y, [3] next X and Y
+                const ESM::Land::LandData* normalData[4] = {0, 0, 0, 0};
+                const ESM::Land::LandData* colourData[4] = {0, 0, 0, 0};
+                const bool lastRowUsed = rowEnd == ESM::Land::LAND_SIZE;
+                const bool lastColUsed = colEnd == ESM::Land::LAND_SIZE;
+                for (int i=0; i<4; ++i)
+                {
+                    if (((i & 1) && !lastRowUsed) || ((i & 2) && !lastColUsed))
+                        continue;
+                    const LandObject* land = getLand(cellX + (i & 1), cellY + (i >> 1), cache);
+                    normalData[i] = land ? land->getData(ESM::Land::DATA_VNML) : 0;
+                    colourData[i] = land ? land->getData(ESM::Land::DATA_VCLR) : 0;
+                }
+                const LandObject* land = getLand(cellX, cellY, cache);
+                const ESM::Land::LandData *heightData = land ? land->getData(ESM::Land::DATA_VHGT) : 0;
+
                 vertY = vertY_;
                 for (int col=colStart; col<colEnd; col += increment)
                 {
+                    assert(col >= 0 && col < ESM::Land::LAND_SIZE);
+                    assert (vertY < numVerts);
+
+                    // Everything that only depends on the row is set up once, so the loop over the row stays simple
+                    const bool lastCol = col == ESM::Land::LAND_SIZE-1;
+                    const int srcCol = lastCol ? 0 : col;
+                    const ESM::Land::LandData* rowNormalData = normalData[lastCol ? 2 : 0];
+                    const ESM::Land::LandData* rowColourData = colourData[lastCol ? 2 : 0];
+                    const ESM::Land::LandData* lastNormalData = normalData[lastCol ? 3 : 1];
+                    const ESM::Land::LandData* lastColourData = colourData[lastCol ? 3 : 1];
+                    const float* heights = heightData ? &heightData->mHeights[col*ESM::Land::LAND_SIZE] : 0;
+                    const float posY = (vertY * vertScale - 0.5f) * chunkWorldSize;
+                    const bool cornerCol = col == 0 || lastCol;
+
                     vertX = vertX_;
                     for (int row=rowStart; row<rowEnd; row += increment)
                     {
-                        int srcArrayIndex = col*ESM::Land::LAND_SIZE*3+row*3;
-
                         assert(row >= 0 && row < ESM::Land::LAND_SIZE);
-                        assert(col >= 0 && col < ESM::Land::LAND_SIZE);
-
                         assert (vertX < numVerts);
-                        assert (vertY < numVerts);
 
-                        float height = defaultHeight;
-                        if (heightData)
-                            height = heightData->mHeights[col*ESM::Land::LAND_SIZE + row];
+                        const unsigned int index = static_cast<unsigned int>(vertX*numVerts + vertY);
+
+                        float height = heights ? heights[row] : defaultHeight;
                         if (alteration)
                             height += getAlteredHeight(col, row);
-                        (*positions)[static_cast<unsigned int>(vertX*numVerts + vertY)]
-                            = osg::Vec3f((vertX / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
-                                         (vertY / float(numVerts - 1) - 0.5f) * size * Constants::CellSizeInUnits,
-                                         height);
+                        (*positions)[index] = osg::Vec3f((vertX * vertScale - 0.5f) * chunkWorldSize, posY, height);
 
-                        if (normalData)
-                        {
-                            for (int i=0; i<3; ++i)
-                                normal[i] = normalData->mNormals[srcArrayIndex+i];
+                        const bool lastRow = row == ESM::Land::LAND_SIZE-1;
+                        const int srcIndex = (srcCol*ESM::Land::LAND_SIZE + (lastRow ? 0 : row)) * 3;
 
+                        osg::Vec3f normal (0,0,1);
+                        if (const ESM::Land::LandData* data = lastRow ? lastNormalData : rowNormalData)
+                        {
+                            normal.set(data->mNormals[srcIndex], data->mNormals[srcIndex+1], data->mNormals[srcIndex+2]);
                             normal.normalize();
                         }
-                        else
-                            normal = osg::Vec3f(0,0,1);
-
-                        // Normals apparently don't connect seamlessly between cells
-                        if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixNormal(normal, cellX, cellY, col, row, cache);
 
                         // some corner normals appear to be complete garbage (z < 0)
-                        if ((row == 0 || row == ESM::Land::LAND_SIZE-1) && (col == 0 || col == ESM::Land::LAND_SIZE-1))
+                        if (cornerCol && (row == 0 || lastRow))
                             averageNormal(normal, cellX, cellY, col, row, cache);
 
                         assert(normal.z() > 0);
 
-                        (*normals)[static_cast<unsigned int>(vertX*numVerts + vertY)] = normal;
+                        (*normals)[index] = normal;
 
-                        if (colourData)
-                        {
-                            for (int i=0; i<3; ++i)
-                                color[i] = colourData->mColours[srcArrayIndex+i];
-                        }
-                        else
+                        osg::Vec4ub color (255,255,255,255);
+                        if (const ESM::Land::LandData* data = lastRow ? lastColourData : rowColourData)
+                            color.set(data->mColours[srcIndex], data->mColours[srcIndex+1], data->mColours[srcIndex+2], 255);
+
+                        // Colours of the last row and column come from the neighbour cells, which have their own adjustment
+                        if (alteration && !lastRow && !lastCol)
                         {
-                            color.r() = 255;
-                            color.g() = 255;
-                            color.b() = 255;
-                        }
-                        if (alteration)
                             adjustColor(col, row, heightData, color); //Does nothing by default, override in OpenMW-CS
+                            color.a() = 255;
+                        }
 
-                        // Unlike normals, colors mostly connect seamlessly between cells, but not always...
-                        if (col == ESM::Land::LAND_SIZE-1 || row == ESM::Land::LAND_SIZE-1)
-                            fixColour(color, cellX, cellY, col, row, cache);
-
-                        color.a() = 255;
-
-                        (*colours)[static_cast<unsigned int>(vertX*numVerts + vertY)] = color;
+                        (*colours)[index] = color;
 
                         ++vertX;
                     }
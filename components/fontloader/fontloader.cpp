@@ -177,24 +177,11 @@ namespace Gui
 
     void FontLoader::loadBitmapFonts(bool exportToFile)
     {
-        const std::map<std::string, VFS::File*>& index = mVFS->getIndex();
-
-        std::string pattern = "Fonts/";
-        mVFS->normalizeFilename(pattern);
-
-        std::map<std::string, VFS::File*>::const_iterator found = index.lower_bound(pattern);
-        while (found != index.end())
+        for (const std::string& name : mVFS->getRecursiveDirectoryIterator("Fonts/"))
         {
-            const std::string& name = found->first;
-            if (name.size() >= pattern.size() && name.substr(0, pattern.size()) == pattern)
-            {
-                size_t pos = name.find_last_of('.');
-                if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".fnt") == 0)
-                    loadFont(name, exportToFile);
-            }
-            else
-                break;
-            ++found;
+            size_t pos = name.find_last_of('.');
+            if (pos != std::string::npos && name.compare(pos, name.size()-pos, ".fnt") == 0)
+                loadFont(name, exportToFile);
         }
     }
 
@@ -349,6 +336,64 @@ namespace Gui
         source->addAttribute("value", std::string(bitmapFilename));
         MyGUI::xml::ElementPtr codes = root->createChild("Codes");
 
+        // Fall back from unavailable Windows-1252 encoding symbols to similar characters available in the game fonts
+        std::multimap<int, int> additional; // fallback glyph index, unicode
+        additional.insert(std::make_pair(156, 0x00A2)); // cent sign
+        additional.insert(std::make_pair(89, 0x00A5)); // yen sign
+        additional.insert(std::make_pair(221, 0x00A6)); // broken bar
+        additional.insert(std::make_pair(99, 0x00A9)); // copyright sign
+        additional.insert(std::make_pair(97, 0x00AA)); // prima ordinal indicator
+        additional.insert(std::make_pair(60, 0x00AB)); // double left-pointing angle quotation mark
+        additional.insert(std::make_pair(45, 0x00AD)); // soft hyphen
+        additional.insert(std::make_pair(114, 0x00AE)); // registered trademark symbol
+        additional.insert(std::make_pair(45, 0x00AF)); // macron
+        additional.insert(std::make_pair(241, 0x00B1)); // plus-minus sign
+        additional.insert(std::make_pair(50, 0x00B2)); // superscript two
+        additional.insert(std::make_pair(51, 0x00B3)); // superscript three
+        additional.insert(std::make_pair(44, 0x00B8)); // cedilla
+        additional.insert(std::make_pair(49, 0x00B9)); // superscript one
+        additional.insert(std::make_pair(111, 0x00BA)); // primo ordinal indicator
+        additional.insert(std::make_pair(62, 0x00BB)); // double right-pointing angle quotation mark
+        additional.insert(std::make_pair(63, 0x00BF)); // inverted question mark
+        additional.insert(std::make_pair(65, 0x00C6)); // latin capital ae ligature
+        additional.insert(std::make_pair(79, 0x00D8)); // latin capital o with stroke
+        additional.insert(std::make_pair(97, 0x00E6)); // latin small ae ligature
+        additional.insert(std::make_pair(111, 0x00F8)); // latin small o with stroke
+        additional.insert(std::make_pair(79, 0x0152)); // latin capital oe ligature
+        additional.insert(std::make_pair(111, 0x0153)); // latin small oe ligature
+        additional.insert(std::make_pair(83, 0x015A)); // latin capital s with caron
+        additional.insert(std::make_pair(115, 0x015B)); // latin small s with caron
+        additional.insert(std::make_pair(89, 0x0178)); // latin capital y with diaresis
+        additional.insert(std::make_pair(90, 0x017D)); // latin capital z with caron
+        additional.insert(std::make_pair(122, 0x017E)); // latin small z with caron
+        additional.insert(std::make_pair(102, 0x0192)); // latin small f with hook
+        additional.insert(std::make_pair(94, 0x02C6)); // circumflex modifier
+        additional.insert(std::make_pair(126, 0x02DC)); // small tilde
+        additional.insert(std::make_pair(69, 0x0401)); // cyrillic capital io (no diaeresis latin e is available)
+        additional.insert(std::make_pair(137, 0x0451)); // cyrillic small io
+        additional.insert(std::make_pair(45, 0x2012)); // figure dash
+        additional.insert(std::make_pair(45, 0x2013)); // en dash
+        additional.insert(std::make_pair(45, 0x2014)); // em dash
+        additional.insert(std::make_pair(39, 0x2018)); // left single quotation mark
+        additional.insert(std::make_pair(39, 0x2019)); // right single quotation mark
+        additional.insert(std::make_pair(44, 0x201A)); // single low quotation mark
+        additional.insert(std::make_pair(39, 0x201B)); // single high quotation mark (reversed)
+        additional.insert(std::make_pair(34, 0x201C)); // left double quotation mark
+        additional.insert(std::make_pair(34, 0x201D)); // right double quotation mark
+        additional.insert(std::make_pair(44, 0x201E)); // double low quotation mark
+        additional.insert(std::make_pair(34, 0x201F)); // double high quotation mark (reversed)
+        additional.insert(std::make_pair(43, 0x2020)); // dagger
+        additional.insert(std::make_pair(216, 0x2021)); // double dagger (note: this glyph is not available)
+        additional.insert(std::make_pair(46, 0x2026)); // ellipsis
+        additional.insert(std::make_pair(37, 0x2030)); // per mille sign
+        additional.insert(std::make_pair(60, 0x2039)); // single left-pointing angle quotation mark
+        additional.insert(std::make_pair(62, 0x203A)); // single right-pointing angle quotation mark
+        additional.insert(std::make_pair(101, 0x20AC)); // euro sign
+        additional.insert(std::make_pair(84, 0x2122)); // trademark sign
+        additional.insert(std::make_pair(45, 0x2212)); // minus sign
+
+        ToUTF8::Utf8Encoder encoder(mEncoding);
+
         for(int i = 0; i < 256; i++)
         {
             float x1 = data[i].top_left.x*width;
@@ -356,7 +401,6 @@ namespace Gui
             float w  = data[i].top_right.x*width - x1;
             float h  = data[i].bottom_left.y*height - y1;
 
-            ToUTF8::Utf8Encoder encoder(mEncoding);
             unsigned long unicodeVal = utf8ToUnicode(getUtf8(i, encoder, mEncoding));
 
             MyGUI::xml::ElementPtr code = codes->createChild("Code");
@@ -370,66 +414,9 @@ namespace Gui
                                + MyGUI::utility::toString((fontSize-data[i].ascent)));
             code->addAttribute("size", MyGUI::IntSize(static_cast<int>(data[i].width), static_cast<int>(data[i].height)));
 
-            // Fall back from unavailable Windows-1252 encoding symbols to similar characters available in the game fonts
-            std::multimap<int, int> additional; // fallback glyph index, unicode
-            additional.insert(std::make_pair(156, 0x00A2)); // cent sign
-            additional.insert(std::make_pair(89, 0x00A5)); // yen sign
-            additional.insert(std::make_pair(221, 0x00A6)); // broken bar
-            additional.insert(std::make_pair(99, 0x00A9)); // copyright sign
-            additional.insert(std::make_pair(97, 0x00AA)); // prima ordinal indicator
-            additional.insert(std::make_pair(60, 0x00AB)); // double left-pointing angle quotation mark
-            additional.insert(std::make_pair(45, 0x00AD)); // soft hyphen
-            additional.insert(std::make_pair(114, 0x00AE)); // registered trademark symbol
-            additional.insert(std::make_pair(45, 0x00AF)); // macron
-            additional.insert(std::make_pair(241, 0x00B1)); // plus-minus sign
-            additional.insert(std::make_pair(50, 0x00B2)); // superscript two
-            additional.insert(std::make_pair(51, 0x00B3)); // superscript three
-            additional.insert(std::make_pair(44, 0x00B8)); // cedilla
-            additional.insert(std::make_pair(49, 0x00B9)); // superscript one
-            additional.insert(std::make_pair(111, 0x00BA)); // primo ordinal indicator
-            additional.insert(std::make_pair(62, 0x00BB)); // double right-pointing angle quotation mark
-            additional.insert(std::make_pair(63, 0x00BF)); // inverted question mark
-            additional.insert(std::make_pair(65, 0x00C6)); // latin capital ae ligature
-            additional.insert(std::make_pair(79, 0x00D8)); // latin capital o with stroke
-            additional.insert(std::make_pair(97, 0x00E6)); // latin small ae ligature
-            additional.insert(std::make_pair(111, 0x00F8)); // latin small o with stroke
-            additional.insert(std::make_pair(79, 0x0152)); // latin capital oe ligature
-            additional.insert(std::make_pair(111, 0x0153)); // latin small oe ligature
-            additional.insert(std::make_pair(83, 0x015A)); // latin capital s with caron
-            additional.insert(std::make_pair(115, 0x015B)); // latin small s with caron
-            additional.insert(std::make_pair(89, 0x0178)); // latin capital y with diaresis
-            additional.insert(std::make_pair(90, 0x017D)); // latin capital z with caron
-            additional.insert(std::make_pair(122, 0x017E)); // latin small z with caron
-            additional.insert(std::make_pair(102, 0x0192)); // latin small f with hook
-            additional.insert(std::make_pair(94, 0x02C6)); // circumflex modifier
-            additional.insert(std::make_pair(126, 0x02DC)); // small tilde
-            additional.insert(std::make_pair(69, 0x0401)); // cyrillic capital io (no diaeresis latin e is available)
-            additional.insert(std::make_pair(137, 0x0451)); // cyrillic small io
-            additional.insert(std::make_pair(45, 0x2012)); // figure dash
-            additional.insert(std::make_pair(45, 0x2013)); // en dash
-            additional.insert(std::make_pair(45, 0x2014)); // em dash
-            additional.insert(std::make_pair(39, 0x2018)); // left single quotation mark
-            additional.insert(std::make_pair(39, 0x2019)); // right single quotation mark
-            additional.insert(std::make_pair(44, 0x201A)); // single low quotation mark
-            additional.insert(std::make_pair(39, 0x201B)); // single high quotation mark (reversed)
-            additional.insert(std::make_pair(34, 0x201C)); // left double quotation mark
-            additional.insert(std::make_pair(34, 0x201D)); // right double quotation mark
-            additional.insert(std::make_pair(44, 0x201E)); // double low quotation mark
-            additional.insert(std::make_pair(34, 0x201F)); // double high quotation mark (reversed)
-            additional.insert(std::make_pair(43, 0x2020)); // dagger
-            additional.insert(std::make_pair(216, 0x2021)); // double dagger (note: this glyph is not available)
-            additional.insert(std::make_pair(46, 0x2026)); // ellipsis
-            additional.insert(std::make_pair(37, 0x2030)); // per mille sign
-            additional.insert(std::make_pair(60, 0x2039)); // single left-pointing angle quotation mark
-            additional.insert(std::make_pair(62, 0x203A)); // single right-pointing angle quotation mark
-            additional.insert(std::make_pair(101, 0x20AC)); // euro sign
-            additional.insert(std::make_pair(84, 0x2122)); // trademark sign
-            additional.insert(std::make_pair(45, 0x2212)); // minus sign
-
-            for (std::multimap<int, int>::iterator it = additional.begin(); it != additional.end(); ++it)
+            const auto fallbacks = additional.equal_range(i);
+            for (std::multimap<int, int>::const_iterator it = fallbacks.first; it != fallbacks.second; ++it)
             {
-                if (it->first != i)
-                    continue;
                 code = codes->createChild("Code");
                 code->addAttribute("index", it->second);
                 code->addAttribute("coord", MyGUI::utility::toString(x1) + " "
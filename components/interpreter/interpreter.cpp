@@ -18,12 +18,16 @@ namespace Interpreter
                 int opcode = code>>24;
                 unsigned int arg0 = code & 0xffffff;
 
-                std::map<int, Opcode1 *>::iterator iter = mSegment0.find (opcode);
+                bool pure = false;
+                Opcode1 *op = mSegment0.find (opcode, pure);
 
-                if (iter==mSegment0.end())
+                if (!op)
                     abortUnknownCode (0, opcode);
 
-                iter->second->execute (mRuntime, arg0);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime, arg0);
 
                 return;
             }
@@ -34,12 +38,16 @@ namespace Interpreter
                 unsigned int arg0 = (code>>16) & 0xfff;
                 unsigned int arg1 = code & 0xfff;
 
-                std::map<int, Opcode2 *>::iterator iter = mSegment1.find (opcode);
+                bool pure = false;
+                Opcode2 *op = mSegment1.find (opcode, pure);
 
-                if (iter==mSegment1.end())
+                if (!op)
                     abortUnknownCode (1, opcode);
 
-                iter->second->execute (mRuntime, arg0, arg1);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime, arg0, arg1);
 
                 return;
             }
@@ -49,12 +57,16 @@ namespace Interpreter
                 int opcode = (code>>20) & 0x3ff;
                 unsigned int arg0 = code & 0xfffff;
 
-                std::map<int, Opcode1 *>::iterator iter = mSegment2.find (opcode);
+                bool pure = false;
+                Opcode1 *op = mSegment2.find (opcode, pure);
 
-                if (iter==mSegment2.end())
+                if (!op)
                     abortUnknownCode (2, opcode);
 
-                iter->second->execute (mRuntime, arg0);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime, arg0);
 
                 return;
             }
@@ -69,12 +81,16 @@ namespace Interpreter
                 int opcode = (code>>8) & 0x3ffff;
                 unsigned int arg0 = code & 0xff;
 
-                std::map<int, Opcode1 *>::iterator iter = mSegment3.find (opcode);
+                bool pure = false;
+                Opcode1 *op = mSegment3.find (opcode, pure);
 
-                if (iter==mSegment3.end())
+                if (!op)
                     abortUnknownCode (3, opcode);
 
-                iter->second->execute (mRuntime, arg0);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime, arg0);
 
                 return;
             }
@@ -85,12 +101,16 @@ namespace Interpreter
                 unsigned int arg0 = (code>>8) & 0xff;
                 unsigned int arg1 = code & 0xff;
 
-                std::map<int, Opcode2 *>::iterator iter = mSegment4.find (opcode);
+                bool pure = false;
+                Opcode2 *op = mSegment4.find (opcode, pure);
 
-                if (iter==mSegment4.end())
+                if (!op)
                     abortUnknownCode (4, opcode);
 
-                iter->second->execute (mRuntime, arg0, arg1);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime, arg0, arg1);
 
                 return;
             }
@@ -99,12 +119,16 @@ namespace Interpreter
             {
                 int opcode = code & 0x3ffffff;
 
-                std::map<int, Opcode0 *>::iterator iter = mSegment5.find (opcode);
+                bool pure = false;
+                Opcode0 *op = mSegment5.find (opcode, pure);
 
-                if (iter==mSegment5.end())
+                if (!op)
                     abortUnknownCode (5, opcode);
 
-                iter->second->execute (mRuntime);
+                if (!pure)
+                    mSideEffects = true;
+
+                op->execute (mRuntime);
 
                 return;
             }
@@ -152,76 +176,49 @@ namespace Interpreter
         }
     }
 
-    Interpreter::Interpreter() : mRunning (false)
+    Interpreter::Interpreter() : mRunning (false), mSideEffects (false)
     {}
 
-    Interpreter::~Interpreter()
-    {
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment0.begin());
-            iter!=mSegment0.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment1.begin());
-            iter!=mSegment1.end(); ++iter)
-            delete iter->second;
+    Interpreter::~Interpreter() {}
 
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment2.begin());
-            iter!=mSegment2.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode1 *>::iterator iter (mSegment3.begin());
-            iter!=mSegment3.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode2 *>::iterator iter (mSegment4.begin());
-            iter!=mSegment4.end(); ++iter)
-            delete iter->second;
-
-        for (std::map<int, Opcode0 *>::iterator iter (mSegment5.begin());
-            iter!=mSegment5.end(); ++iter)
-            delete iter->second;
-    }
-
-    void Interpreter::installSegment0 (int code, Opcode1 *opcode)
+    void Interpreter::installSegment0 (int code, Opcode1 *opcode, bool pure)
     {
-        assert(mSegment0.find(code) == mSegment0.end());
-        mSegment0.insert (std::make_pair (code, opcode));
+        mSegment0.install (code, opcode, pure);
     }
 
-    void Interpreter::installSegment1 (int code, Opcode2 *opcode)
+    void Interpreter::installSegment1 (int code, Opcode2 *opcode, bool pure)
     {
-        assert(mSegment1.find(code) == mSegment1.end());
-        mSegment1.insert (std::make_pair (code, opcode));
+        mSegment1.install (code, opcode, pure);
     }
 
-    void Interpreter::installSegment2 (int code, Opcode1 *opcode)
+    void Interpreter::installSegment2 (int code, Opcode1 *opcode, bool pure)
     {
-        assert(mSegment2.find(code) == mSegment2.end());
-        mSegment2.insert (std::make_pair (code, opcode));
+        mSegment2.install (code, opcode, pure);
     }
 
-    void Interpreter::installSegment3 (int code, Opcode1 *opcode)
+    void Interpreter::installSegment3 (int code, Opcode1 *opcode, bool pure)
     {
-        assert(mSegment3.find(code) == mSegment3.end());
-        mSegment3.insert (std::make_pair (code, opcode));
+        mSegment3.install (code, opcode, pure);
     }
 
-    void Interpreter::installSegment4 (int code, Opcode2 *opcode)
+    void Interpreter::installSegment4 (int code, Opcode2 *opcode, bool pure)
     {
-        assert(mSegment4.find(code) == mSegment4.end());
-        mSegment4.insert (std::make_pair (code, opcode));
+        mSegment4.install (code, opcode, pure);
     }
 
-    void Interpreter::installSegment5 (int code, Opcode0 *opcode)
+    void Interpreter::installSegment5 (int code, Opcode0 *opcode, bool pure)
     {
-        assert(mSegment5.find(code) == mSegment5.end());
-        mSegment5.insert (std::make_pair (code, opcode));
+        mSegment5.install (code, opcode, pure);
     }
 
-    void Interpreter::run (const Type_Code *code, int codeSize, Context& context)
+    bool Interpreter::run (const Type_Code *code, int codeSize, Context& context)
     {
         assert (codeSize>=4);
 
+        // code run from within other code is a side effect of the outer code
+        const bool outerSideEffects = mSideEffects;
+        mSideEffects = false;
+
         begin();
 
         try
@@ -242,9 +239,14 @@ namespace Interpreter
         catch (...)
         {
             end();
+            mSideEffects = true;
             throw;
         }
 
         end();
+
+        const bool pure = !mSideEffects;
+        mSideEffects = outerSideEffects || !pure;
+        return pure;
     }
 }
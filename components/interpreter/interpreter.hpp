@@ -1,8 +1,9 @@
 #ifndef INTERPRETER_INTERPRETER_H_INCLUDED
 #define INTERPRETER_INTERPRETER_H_INCLUDED
 
-#include <map>
+#include <cassert>
 #include <stack>
+#include <vector>
 
 #include "runtime.hpp"
 #include "types.hpp"
@@ -13,17 +14,75 @@ namespace Interpreter
     class Opcode1;
     class Opcode2;
 
+    /// Opcodes of one segment in a dense array, indexed by the code relative to the lowest installed code.
+    /// Codes are allocated in contiguous ranges per segment, so this is a bounds check and an index per lookup.
+    template<class T>
+    class OpcodeTable
+    {
+            std::vector<T *> mOpcodes;
+            std::vector<bool> mPure;
+            int mBase;
+
+            // not implemented
+            OpcodeTable (const OpcodeTable&);
+            OpcodeTable& operator= (const OpcodeTable&);
+
+        public:
+
+            OpcodeTable() : mBase (0) {}
+
+            ~OpcodeTable()
+            {
+                for (T *opcode : mOpcodes)
+                    delete opcode;
+            }
+
+            void install (int code, T *opcode, bool pure)
+            {
+                if (mOpcodes.empty())
+                    mBase = code;
+                else if (code<mBase)
+                {
+                    mOpcodes.insert (mOpcodes.begin(), static_cast<std::size_t> (mBase-code), nullptr);
+                    mPure.insert (mPure.begin(), static_cast<std::size_t> (mBase-code), false);
+                    mBase = code;
+                }
+
+                const std::size_t index = static_cast<std::size_t> (code-mBase);
+                if (index>=mOpcodes.size())
+                {
+                    mOpcodes.resize (index+1, nullptr);
+                    mPure.resize (index+1, false);
+                }
+
+                assert (!mOpcodes[index]);
+                mOpcodes[index] = opcode;
+                mPure[index] = pure;
+            }
+
+            /// \return nullptr if no opcode is installed for \a code.
+            T *find (int code, bool& pure) const
+            {
+                const std::size_t index = static_cast<std::size_t> (code-mBase);
+                if (index>=mOpcodes.size())
+                    return nullptr;
+                pure = mPure[index];
+                return mOpcodes[index];
+            }
+    };
+
     class Interpreter
     {
             std::stack<Runtime> mCallstack;
             bool mRunning;
+            bool mSideEffects;
             Runtime mRuntime;
-            std::map<int, Opcode1 *> mSegment0;
-            std::map<int, Opcode2 *> mSegment1;
-            std::map<int, Opcode1 *> mSegment2;
-            std::map<int, Opcode1 *> mSegment3;
-            std::map<int, Opcode2 *> mSegment4;
-            std::map<int, Opcode0 *> mSegment5;
+            OpcodeTable<Opcode1> mSegment0;
+            OpcodeTable<Opcode2> mSegment1;
+            OpcodeTable<Opcode1> mSegment2;
+            OpcodeTable<Opcode1> mSegment3;
+            OpcodeTable<Opcode2> mSegment4;
+            OpcodeTable<Opcode0> mSegment5;
 
             // not implemented
             Interpreter (const Interpreter&);
@@ -45,25 +104,27 @@ namespace Interpreter
 
             ~Interpreter();
 
-            void installSegment0 (int code, Opcode1 *opcode);
+            void installSegment0 (int code, Opcode1 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void installSegment1 (int code, Opcode2 *opcode);
+            void installSegment1 (int code, Opcode2 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void installSegment2 (int code, Opcode1 *opcode);
+            void installSegment2 (int code, Opcode1 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void installSegment3 (int code, Opcode1 *opcode);
+            void installSegment3 (int code, Opcode1 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void installSegment4 (int code, Opcode2 *opcode);
+            void installSegment4 (int code, Opcode2 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void installSegment5 (int code, Opcode0 *opcode);
+            void installSegment5 (int code, Opcode0 *opcode, bool pure = false);
             ///< ownership of \a opcode is transferred to *this.
 
-            void run (const Type_Code *code, int codeSize, Context& context);
+            bool run (const Type_Code *code, int codeSize, Context& context);
+            ///< \return Were only opcodes installed as pure executed? Pure opcodes only read the script's
+            /// own local variables, so running the code again gives the same result while these don't change.
     };
 }
 
@@ -0,0 +1,78 @@
+#include "diskcache.hpp"
+
+#include <components/debug/debuglog.hpp>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <tuple>
+#include <vector>
+
+namespace Misc
+{
+    std::uint64_t pruneCacheDirectory(const boost::filesystem::path& path, const std::string& extension,
+        std::uint64_t maxSize)
+    {
+        struct File
+        {
+            std::time_t mTime;
+            std::uint64_t mSize;
+            boost::filesystem::path mPath;
+        };
+
+        std::vector<File> files;
+        std::uint64_t totalSize = 0;
+
+        boost::system::error_code ec;
+        for (boost::filesystem::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec))
+        {
+            const boost::filesystem::path& filePath = it->path();
+            if (filePath.extension() != extension)
+                continue;
+            boost::system::error_code fileEc;
+            const std::uint64_t size = boost::filesystem::file_size(filePath, fileEc);
+            if (fileEc)
+                continue;
+            const std::time_t time = boost::filesystem::last_write_time(filePath, fileEc);
+            if (fileEc)
+                continue;
+            files.push_back(File {time, size, filePath});
+            totalSize += size;
+        }
+
+        if (ec)
+            Log(Debug::Warning) << "Failed to list cache directory " << path << ": " << ec.message();
+
+        if (totalSize <= maxSize)
+            return totalSize;
+
+        std::sort(files.begin(), files.end(),
+            [] (const File& lhs, const File& rhs) { return std::tie(lhs.mTime, lhs.mPath) < std::tie(rhs.mTime, rhs.mPath); });
+
+        std::size_t removed = 0;
+        for (const File& file : files)
+        {
+            if (totalSize <= maxSize)
+                break;
+            boost::filesystem::remove(file.mPath, ec);
+            if (ec)
+            {
+                Log(Debug::Warning) << "Failed to remove cache file " << file.mPath << ": " << ec.message();
+                continue;
+            }
+            totalSize -= file.mSize;
+            ++removed;
+        }
+
+        Log(Debug::Verbose) << "Removed " << removed << " least recently used files from cache directory " << path;
+
+        return totalSize;
+    }
+
+    void touchCacheFile(const boost::filesystem::path& path)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef MISC_DISKCACHE_H
+#define MISC_DISKCACHE_H
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace Misc
+{
+    /// Removes the least recently written files with the given extension from a cache directory, until the total
+    /// size of the remaining ones is at most maxSize. Errors are logged and skipped.
+    /// @return total size of the remaining files
+    std::uint64_t pruneCacheDirectory(const boost::filesystem::path& path, const std::string& extension,
+        std::uint64_t maxSize);
+
+    /// Marks a cache file as recently used, so it is pruned last.
+    void touchCacheFile(const boost::filesystem::path& path);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef MISC_KEYHASHER_H
+#define MISC_KEYHASHER_H
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace Misc
+{
+    /// Computes two independent FNV-1a hashes over the same data, both are used for the key.
+    /// Meant for naming cache files, so a collision needs both hashes to collide.
+    class KeyHasher
+    {
+    public:
+        void add(const void* data, std::size_t size)
+        {
+            const auto bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                mHash = (mHash ^ bytes[i]) * 1099511628211ull;
+                mCheckHash = (mCheckHash ^ bytes[i]) * 1099511628211ull;
+            }
+        }
+
+        template <class T>
+        void add(const T& value)
+        {
+            add(&value, sizeof(value));
+        }
+
+        void add(const std::string& value)
+        {
+            add(value.size());
+            add(value.data(), value.size());
+        }
+
+        std::string getKey() const
+        {
+            std::ostringstream stream;
+            stream << std::hex << std::setfill('0') << std::setw(16) << mHash << std::setw(16) << mCheckHash;
+            return stream.str();
+        }
+
+    private:
+        std::uint64_t mHash = 14695981039346656037ull;
+        std::uint64_t mCheckHash = 7809847782465536322ull;
+    };
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef OPENMW_COMPONENTS_MISC_POOLALLOCATOR_H
+#define OPENMW_COMPONENTS_MISC_POOLALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace Misc
+{
+    /// Free list of blocks of the given size, carved from chunks that grow with the number of blocks in use.
+    /// Blocks freed by one container are reused by the next, and blocks allocated one after another are next to
+    /// each other in memory.
+    template <std::size_t size, std::size_t alignment>
+    class BlockPool
+    {
+        public:
+            static void* allocate()
+            {
+                State& state = getState();
+                const std::lock_guard<std::mutex> lock(state.mMutex);
+                if (state.mFree == nullptr)
+                    grow(state);
+                Block* block = state.mFree;
+                state.mFree = block->mNext;
+                return block;
+            }
+
+            static void deallocate(void* pointer)
+            {
+                State& state = getState();
+                const std::lock_guard<std::mutex> lock(state.mMutex);
+                Block* block = static_cast<Block*>(pointer);
+                block->mNext = state.mFree;
+                state.mFree = block;
+            }
+
+        private:
+            union Block
+            {
+                Block* mNext;
+                typename std::aligned_storage<size, alignment>::type mData;
+            };
+
+            struct State
+            {
+                std::mutex mMutex;
+                Block* mFree = nullptr;
+                std::vector<std::unique_ptr<Block[]>> mChunks;
+                std::size_t mChunkSize = 64;
+            };
+
+            static State& getState()
+            {
+                // Never destroyed, containers with static storage duration may free their blocks after it would be
+                static State* const state = new State;
+                return *state;
+            }
+
+            static void grow(State& state)
+            {
+                std::unique_ptr<Block[]> chunk(new Block[state.mChunkSize]);
+                for (std::size_t i = 0; i < state.mChunkSize; ++i)
+                    chunk[i].mNext = i + 1 < state.mChunkSize ? &chunk[i + 1] : nullptr;
+                state.mFree = &chunk[0];
+                state.mChunks.push_back(std::move(chunk));
+                if (state.mChunkSize < 4096)
+                    state.mChunkSize *= 2;
+            }
+    };
+
+    /// Allocator for node based containers, taking single objects from a shared BlockPool of their size.
+    /// @note Thread safe. The memory is kept for reuse, it is not returned to the system.
+    template <class T>
+    class PoolAllocator
+    {
+        public:
+            typedef T value_type;
+
+            PoolAllocator() = default;
+
+            template <class U>
+            PoolAllocator(const PoolAllocator<U>&) {}
+
+            T* allocate(std::size_t n)
+            {
+                if (n != 1)
+                    return static_cast<T*>(::operator new(n * sizeof(T)));
+                return static_cast<T*>(Pool::allocate());
+            }
+
+            void deallocate(T* pointer, std::size_t n)
+            {
+                if (n != 1)
+                    ::operator delete(pointer);
+                else
+                    Pool::deallocate(pointer);
+            }
+
+        private:
+            typedef BlockPool<sizeof(T), alignof(T)> Pool;
+    };
+
+    template <class T, class U>
+    bool operator ==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    {
+        return true;
+    }
+
+    template <class T, class U>
+    bool operator !=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #include "utf8stream.hpp"
 
@@ -30,6 +32,58 @@ class StringUtils
         return value.c_str();
     }
 
+    /// Lower-cases 8 characters at once like toLower.
+    static std::uint64_t toLower8(std::uint64_t chars)
+    {
+        const std::uint64_t heptets = chars & 0x7f7f7f7f7f7f7f7fULL;
+        // High bit of each byte is set for values above 'Z' and for values from 'A'
+        const std::uint64_t aboveZ = heptets + 0x2525252525252525ULL;
+        const std::uint64_t fromA = heptets + 0x3f3f3f3f3f3f3f3fULL;
+        // Multibyte characters have the high bit set and are unchanged
+        const std::uint64_t upper = fromA & ~aboveZ & ~chars & 0x8080808080808080ULL;
+        return chars | (upper >> 2);
+    }
+
+    static std::uint64_t load8(const char* chars)
+    {
+        std::uint64_t result;
+        std::memcpy(&result, chars, sizeof(result));
+        return result;
+    }
+
+    static bool ciLessImpl(const char* x, std::size_t xSize, const char* y, std::size_t ySize)
+    {
+        const std::size_t size = std::min(xSize, ySize);
+        std::size_t i = 0;
+        // Skip equal blocks of 8 characters, the first different one is compared by characters
+        for (; i + 8 <= size; i += 8)
+        {
+            const std::uint64_t left = load8(x + i);
+            const std::uint64_t right = load8(y + i);
+            if (left != right && toLower8(left) != toLower8(right))
+                break;
+        }
+        return std::lexicographical_compare(x + i, x + xSize, y + i, y + ySize, ci());
+    }
+
+    static bool ciEqualImpl(const char* x, std::size_t xSize, const char* y, std::size_t ySize)
+    {
+        if (xSize != ySize)
+            return false;
+        std::size_t i = 0;
+        for (; i + 8 <= xSize; i += 8)
+        {
+            const std::uint64_t left = load8(x + i);
+            const std::uint64_t right = load8(y + i);
+            if (left != right && toLower8(left) != toLower8(right))
+                return false;
+        }
+        for (; i < xSize; ++i)
+            if (toLower(x[i]) != toLower(y[i]))
+                return false;
+        return true;
+    }
+
 public:
 
     /// Plain and simple locale-unaware toLower. Anything from A to Z is lower-cased, multibyte characters are unchanged.
@@ -105,21 +159,16 @@ public:
     }
 
     static bool ciLess(const std::string &x, const std::string &y) {
-        return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end(), ci());
+        return ciLessImpl(x.data(), x.size(), y.data(), y.size());
     }
 
     static bool ciEqual(const std::string &x, const std::string &y) {
-        if (x.size() != y.size()) {
-            return false;
-        }
-        std::string::const_iterator xit = x.begin();
-        std::string::const_iterator yit = y.begin();
-        for (; xit != x.end(); ++xit, ++yit) {
-            if (toLower(*xit) != toLower(*yit)) {
-                return false;
-            }
-        }
-        return true;
+        return ciEqualImpl(x.data(), x.size(), y.data(), y.size());
+    }
+
+    /// Compares with a C string without making a temporary std::string
+    static bool ciEqual(const std::string &x, const char* y) {
+        return ciEqualImpl(x.data(), x.size(), y, std::strlen(y));
     }
 
     static int ciCompareLen(const std::string &x, const std::string &y, size_t len)
@@ -151,8 +200,15 @@ public:
 
     /// Transforms input string to lower case w/o copy
     static void lowerCaseInPlace(std::string &inout) {
-        for (unsigned int i=0; i<inout.size(); ++i)
-            inout[i] = toLower(inout[i]);
+        char* const chars = &inout[0];
+        std::size_t i = 0;
+        for (; i + 8 <= inout.size(); i += 8)
+        {
+            const std::uint64_t lower = toLower8(load8(chars + i));
+            std::memcpy(chars + i, &lower, sizeof(lower));
+        }
+        for (; i < inout.size(); ++i)
+            chars[i] = toLower(chars[i]);
     }
 
     /// Returns lower case copy of input string
@@ -171,6 +227,30 @@ public:
         }
     };
 
+    /// Case insensitive hash, to be used together with CiEqual
+    struct CiHash
+    {
+        std::size_t operator()(const std::string& str) const
+        {
+            // FNV-1a
+            std::size_t hash = static_cast<std::size_t>(14695981039346656037ULL);
+            for (char c : str)
+            {
+                hash ^= static_cast<unsigned char>(toLower(c));
+                hash *= static_cast<std::size_t>(1099511628211ULL);
+            }
+            return hash;
+        }
+    };
+
+    struct CiEqual
+    {
+        bool operator()(const std::string& left, const std::string& right) const
+        {
+            return ciEqual(left, right);
+        }
+    };
+
 
     /// Performs a binary search on a sorted container for a string that 'key' starts with
     template<typename Iterator, typename T>
@@ -143,7 +143,7 @@ public:
                 glTexCoordPointer(2, GL_FLOAT, sizeof(MyGUI::Vertex), (char*)vbo->getArray(0)->getDataPointer() + 16);
             }
 
-            glDrawArrays(GL_TRIANGLES, 0, batch.mVertexCount);
+            glDrawArrays(GL_TRIANGLES, batch.mFirstVertex, batch.mVertexCount);
 
             if (batch.mStateSet)
             {
@@ -213,18 +213,32 @@ public:
         // optional
         osg::ref_ptr<osg::StateSet> mStateSet;
 
+        size_t mFirstVertex = 0;
         size_t mVertexCount;
     };
 
     void addBatch(const Batch& batch)
     {
-        mBatchVector[mWriteTo].push_back(batch);
+        if (!mergeBatch(batch))
+            mBatchVector[mWriteTo].push_back(batch);
     }
 
     void clear()
     {
         mWriteTo = (mWriteTo+1)%sNumBuffers;
         mBatchVector[mWriteTo].clear();
+        if (mMergedArray[mWriteTo])
+            mMergedArray[mWriteTo]->clear();
+    }
+
+    // Call after the last batch of the frame was added
+    void finish()
+    {
+        if (mMergedArray[mWriteTo] && !mMergedArray[mWriteTo]->empty())
+        {
+            mMergedArray[mWriteTo]->dirty();
+            mMergedBuffer[mWriteTo]->dirty();
+        }
     }
 
     META_Object(osgMyGUI, Drawable)
@@ -236,6 +250,49 @@ private:
     // double buffering approach, to avoid the need for synchronization with the draw thread
     std::vector<Batch> mBatchVector[sNumBuffers];
 
+    // vertices of batches drawn with a single call, because they follow each other with the same texture and state
+    osg::ref_ptr<osg::UByteArray> mMergedArray[sNumBuffers];
+    osg::ref_ptr<osg::VertexBufferObject> mMergedBuffer[sNumBuffers];
+
+    void appendVertices(const osg::Array& array, size_t count)
+    {
+        const unsigned char* data = static_cast<const unsigned char*>(array.getDataPointer());
+        mMergedArray[mWriteTo]->insert(mMergedArray[mWriteTo]->end(), data, data + count * sizeof(MyGUI::Vertex));
+    }
+
+    bool mergeBatch(const Batch& batch)
+    {
+        std::vector<Batch>& batches = mBatchVector[mWriteTo];
+        if (batches.empty())
+            return false;
+
+        Batch& last = batches.back();
+        if (last.mTexture != batch.mTexture || last.mStateSet != batch.mStateSet)
+            return false;
+
+        if (!mMergedArray[mWriteTo])
+        {
+            mMergedArray[mWriteTo] = new osg::UByteArray;
+            mMergedBuffer[mWriteTo] = new osg::VertexBufferObject;
+            mMergedBuffer[mWriteTo]->setDataVariance(osg::Object::DYNAMIC);
+            mMergedBuffer[mWriteTo]->setUsage(GL_DYNAMIC_DRAW);
+            // NB mMergedBuffer does not own the array
+            mMergedBuffer[mWriteTo]->setArray(0, mMergedArray[mWriteTo].get());
+        }
+
+        // The last batch is always at the end of the merged vertices, so the new ones can follow it
+        if (last.mArray != mMergedArray[mWriteTo])
+        {
+            last.mFirstVertex = mMergedArray[mWriteTo]->size() / sizeof(MyGUI::Vertex);
+            appendVertices(*last.mArray, last.mVertexCount);
+            last.mArray = mMergedArray[mWriteTo];
+            last.mVertexBuffer = mMergedBuffer[mWriteTo];
+        }
+        appendVertices(*batch.mArray, batch.mVertexCount);
+        last.mVertexCount += batch.mVertexCount;
+        return true;
+    }
+
     int mWriteTo;
     mutable int mReadFrom;
 };
@@ -457,6 +514,7 @@ void RenderManager::setInjectState(osg::StateSet* stateSet)
 
 void RenderManager::end()
 {
+    mDrawable->finish();
 }
 
 void RenderManager::update()
@@ -1,16 +1,69 @@
 #include "niffile.hpp"
 #include "effect.hpp"
 
+#include <cstddef>
 #include <map>
+#include <new>
 #include <sstream>
 
 namespace Nif
 {
 
+/// Bump allocator for the records of a file, records are destroyed together with the arena.
+class RecordArena
+{
+public:
+    RecordArena() = default;
+    RecordArena(const RecordArena&) = delete;
+    RecordArena& operator=(const RecordArena&) = delete;
+
+    ~RecordArena()
+    {
+        for (auto it = mRecords.rbegin(); it != mRecords.rend(); ++it)
+            (*it)->~Record();
+    }
+
+    template <class T>
+    Record* construct()
+    {
+        T* record = new (allocate(sizeof(T))) T;
+        mRecords.push_back(record);
+        return record;
+    }
+
+private:
+    static const std::size_t sBlockSize = 64 * 1024;
+    static const std::size_t sAlignment = alignof(std::max_align_t);
+
+    std::vector<std::unique_ptr<char[]>> mBlocks;
+    std::size_t mBlockUsed = sBlockSize;
+    std::vector<std::unique_ptr<char[]>> mLargeAllocations;
+    std::vector<Record*> mRecords;
+
+    void* allocate(std::size_t size)
+    {
+        size = (size + sAlignment - 1) / sAlignment * sAlignment;
+        if (size > sBlockSize)
+        {
+            mLargeAllocations.emplace_back(new char[size]);
+            return mLargeAllocations.back().get();
+        }
+        if (mBlockUsed + size > sBlockSize)
+        {
+            mBlocks.emplace_back(new char[sBlockSize]);
+            mBlockUsed = 0;
+        }
+        void* result = mBlocks.back().get() + mBlockUsed;
+        mBlockUsed += size;
+        return result;
+    }
+};
+
 /// Open a NIF stream. The name is used for error messages.
 NIFFile::NIFFile(Files::IStreamPtr stream, const std::string &name)
     : ver(0)
     , filename(name)
+    , mRecordArena(new RecordArena)
     , mUseSkinning(false)
 {
     parse(stream);
@@ -18,17 +71,13 @@ NIFFile::NIFFile(Files::IStreamPtr stream, const std::string &name)
 
 NIFFile::~NIFFile()
 {
-    for (std::vector<Record*>::iterator it = records.begin() ; it != records.end(); ++it)
-    {
-        delete *it;
-    }
 }
 
-template <typename NodeType> static Record* construct() { return new NodeType; }
+template <typename NodeType> static Record* construct(RecordArena& arena) { return arena.construct<NodeType>(); }
 
 struct RecordFactoryEntry {
 
-    typedef Record* (*create_t) ();
+    typedef Record* (*create_t) (RecordArena&);
 
     create_t        mCreate;
     RecordType      mType;
@@ -36,7 +85,7 @@ struct RecordFactoryEntry {
 };
 
 ///Helper function for adding records to the factory map
-static std::pair<std::string,RecordFactoryEntry> makeEntry(std::string recName, Record* (*create_t) (), RecordType type)
+static std::pair<std::string,RecordFactoryEntry> makeEntry(std::string recName, Record* (*create_t) (RecordArena&), RecordType type)
 {
     RecordFactoryEntry anEntry = {create_t,type};
     return std::make_pair(recName, anEntry);
@@ -134,7 +183,19 @@ std::string NIFFile::printVersion(unsigned int version)
 
 void NIFFile::parse(Files::IStreamPtr stream)
 {
-    NIFStream nif (this, stream);
+    // Read the whole file at once, records are parsed from memory
+    const std::streampos start = stream->tellg();
+    stream->seekg(0, std::ios::end);
+    const std::streamoff size = stream->tellg() - start;
+    stream->seekg(start);
+    if (start < 0 || size < 0)
+        fail("Failed to get the size of the file");
+
+    std::vector<char> data(static_cast<std::size_t>(size));
+    stream->read(data.data(), size);
+    data.resize(static_cast<std::size_t>(stream->gcount()));
+
+    NIFStream nif (this, data.data(), data.size());
 
     // Check the header string
     std::string head = nif.getVersionString();
@@ -176,7 +237,7 @@ void NIFFile::parse(Files::IStreamPtr stream)
 
         if (entry != factories.end())
         {
-            r = entry->second.mCreate ();
+            r = entry->second.mCreate (*mRecordArena);
             r->recType = entry->second.mType;
         }
         else
@@ -3,6 +3,7 @@
 #ifndef OPENMW_COMPONENTS_NIF_NIFFILE_HPP
 #define OPENMW_COMPONENTS_NIF_NIFFILE_HPP
 
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -14,6 +15,8 @@
 namespace Nif
 {
 
+class RecordArena;
+
 struct File
 {
     virtual ~File() = default;
@@ -45,6 +48,9 @@ class NIFFile final : public File
     /// File name, used for error messages and opening the file
     std::string filename;
 
+    /// Owns the records, which are allocated in a few large blocks instead of one allocation each
+    std::unique_ptr<RecordArena> mRecordArena;
+
     /// Record list
     std::vector<Record*> records;
 
@@ -67,7 +73,7 @@ class NIFFile final : public File
 
 public:
     /// Used if file parsing fails
-    void fail(const std::string &msg) const
+    [[noreturn]] void fail(const std::string &msg) const
     {
         std::string err = " NIFFile Error: " + msg;
         err += "\nFile: " + filename;
@@ -7,7 +7,7 @@ namespace Nif
     osg::Quat NIFStream::getQuaternion()
     {
         float f[4];
-        readLittleEndianBufferOfType<4, float,uint32_t>(inp, (float*)&f);
+        readLittleEndianBufferOfType<4, float,uint32_t>(read(4 * sizeof(float)), (float*)&f);
         osg::Quat quat;
         quat.w() = f[0];
         quat.x() = f[1];
@@ -16,6 +16,11 @@ namespace Nif
         return quat;
     }
 
+    void NIFStream::failEndOfFile() const
+    {
+        file->fail("Unexpected end of file");
+    }
+
     Transformation NIFStream::getTrafo()
     {
         Transformation t;
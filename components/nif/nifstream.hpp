@@ -3,13 +3,14 @@
 #ifndef OPENMW_COMPONENTS_NIF_NIFSTREAM_HPP
 #define OPENMW_COMPONENTS_NIF_NIFSTREAM_HPP
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <stdint.h>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
-#include <components/files/constrainedfilestream.hpp>
-
 #include <osg/Vec3f>
 #include <osg/Vec4f>
 #include <osg/Quat>
@@ -21,16 +22,23 @@ namespace Nif
 
 class NIFFile;
 
-/* 
+// Data can be copied as is on little-endian hosts
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386) || defined(_M_IX86) || defined(_M_ARM) || defined(_M_ARM64) \
+    || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define OPENMW_NIF_LITTLE_ENDIAN_HOST 1
+#else
+#define OPENMW_NIF_LITTLE_ENDIAN_HOST 0
+#endif
+
+/*
     readLittleEndianBufferOfType: This template should only be used with non POD data types
 */
-template <uint32_t numInstances, typename T, typename IntegerT> inline void readLittleEndianBufferOfType(Files::IStreamPtr &pIStream, T* dest)
+template <uint32_t numInstances, typename T, typename IntegerT> inline void readLittleEndianBufferOfType(const char* src, T* dest)
 {
-#if defined(__x86_64__) || defined(_M_X64) || defined(__i386) || defined(_M_IX86)
-    pIStream->read((char*)dest, numInstances * sizeof(T));
+#if OPENMW_NIF_LITTLE_ENDIAN_HOST
+    std::memcpy(dest, src, numInstances * sizeof(T));
 #else
-    uint8_t* destByteBuffer = (uint8_t*)dest;
-    pIStream->read((char*)dest, numInstances * sizeof(T));
+    const uint8_t* srcByteBuffer = (const uint8_t*)src;
     /*
         Due to the loop iterations being known at compile time,
         this nested loop will most likely be unrolled
@@ -44,7 +52,7 @@ template <uint32_t numInstances, typename T, typename IntegerT> inline void read
     {
         u = { 0 };
         for (uint32_t byte = 0; byte < sizeof(T); byte++)
-            u.i |= (((IntegerT)destByteBuffer[i * sizeof(T) + byte]) << (byte * 8));
+            u.i |= (((IntegerT)srcByteBuffer[i * sizeof(T) + byte]) << (byte * 8));
         dest[i] = u.t;
     }
 #endif
@@ -53,13 +61,12 @@ template <uint32_t numInstances, typename T, typename IntegerT> inline void read
 /*
     readLittleEndianDynamicBufferOfType: This template should only be used with non POD data types
 */
-template <typename T, typename IntegerT> inline void readLittleEndianDynamicBufferOfType(Files::IStreamPtr &pIStream, T* dest, uint32_t numInstances)
+template <typename T, typename IntegerT> inline void readLittleEndianDynamicBufferOfType(const char* src, T* dest, uint32_t numInstances)
 {
-#if defined(__x86_64__) || defined(_M_X64) || defined(__i386) || defined(_M_IX86)
-    pIStream->read((char*)dest, numInstances * sizeof(T));
+#if OPENMW_NIF_LITTLE_ENDIAN_HOST
+    std::memcpy(dest, src, numInstances * sizeof(T));
 #else
-    uint8_t* destByteBuffer = (uint8_t*)dest;
-    pIStream->read((char*)dest, numInstances * sizeof(T));
+    const uint8_t* srcByteBuffer = (const uint8_t*)src;
     union {
         IntegerT i;
         T t;
@@ -68,86 +75,101 @@ template <typename T, typename IntegerT> inline void readLittleEndianDynamicBuff
     {
         u.i = 0;
         for (uint32_t byte = 0; byte < sizeof(T); byte++)
-            u.i |= ((IntegerT)destByteBuffer[i * sizeof(T) + byte]) << (byte * 8);
+            u.i |= ((IntegerT)srcByteBuffer[i * sizeof(T) + byte]) << (byte * 8);
         dest[i] = u.t;
     }
 #endif
 }
-template<typename type, typename IntegerT> type inline readLittleEndianType(Files::IStreamPtr &pIStream)
+template<typename type, typename IntegerT> type inline readLittleEndianType(const char* src)
 {
     type val;
-    readLittleEndianBufferOfType<1,type,IntegerT>(pIStream, (type*)&val);
+    readLittleEndianBufferOfType<1,type,IntegerT>(src, (type*)&val);
     return val;
 }
 
 class NIFStream
 {
-    /// Input stream
-    Files::IStreamPtr inp;
+    /// Unread part of the file data
+    const char* mPos;
+    const char* mEnd;
+
+    /// @return Start of the next \a size bytes, which are consumed
+    const char* read(size_t size)
+    {
+        if (size > static_cast<size_t>(mEnd - mPos))
+            failEndOfFile();
+        const char* data = mPos;
+        mPos += size;
+        return data;
+    }
+
+    [[noreturn]] void failEndOfFile() const;
 
 public:
 
     NIFFile * const file;
 
-    NIFStream (NIFFile * file, Files::IStreamPtr inp): inp (inp), file (file) {}
+    /// @param data Content of the whole file, must outlive the stream. Reading from memory avoids the overhead of
+    /// many small stream reads.
+    NIFStream (NIFFile * file, const char* data, size_t size): mPos (data), mEnd (data + size), file (file) {}
 
-    void skip(size_t size) { inp->ignore(size); }
+    void skip(size_t size) { read(size); }
 
     char getChar()
     {
-        return readLittleEndianType<char,char>(inp);
+        return readLittleEndianType<char,char>(read(sizeof(char)));
     }
 
     short getShort()
     {
-        return readLittleEndianType<short,short>(inp);
+        return readLittleEndianType<short,short>(read(sizeof(short)));
     }
 
     unsigned short getUShort()
     {
-        return readLittleEndianType<unsigned short,unsigned short>(inp);
+        return readLittleEndianType<unsigned short,unsigned short>(read(sizeof(unsigned short)));
     }
 
     int getInt()
     {
-        return readLittleEndianType<int,int>(inp);
+        return readLittleEndianType<int,int>(read(sizeof(int)));
     }
 
     unsigned int getUInt()
     {
-        return readLittleEndianType<unsigned int,unsigned int>(inp);
+        return readLittleEndianType<unsigned int,unsigned int>(read(sizeof(unsigned int)));
     }
 
     float getFloat()
     {
-        return readLittleEndianType<float,uint32_t>(inp);
+        return readLittleEndianType<float,uint32_t>(read(sizeof(float)));
     }
 
     osg::Vec2f getVector2()
     {
         osg::Vec2f vec;
-        readLittleEndianBufferOfType<2,float,uint32_t>(inp, (float*)&vec._v[0]);
+        readLittleEndianBufferOfType<2,float,uint32_t>(read(2 * sizeof(float)), (float*)&vec._v[0]);
         return vec;
     }
 
     osg::Vec3f getVector3()
     {
         osg::Vec3f vec;
-        readLittleEndianBufferOfType<3, float,uint32_t>(inp, (float*)&vec._v[0]);
+        readLittleEndianBufferOfType<3, float,uint32_t>(read(3 * sizeof(float)), (float*)&vec._v[0]);
         return vec;
     }
 
     osg::Vec4f getVector4()
     {
         osg::Vec4f vec;
-        readLittleEndianBufferOfType<4, float,uint32_t>(inp, (float*)&vec._v[0]);
+        readLittleEndianBufferOfType<4, float,uint32_t>(read(4 * sizeof(float)), (float*)&vec._v[0]);
         return vec;
     }
 
     Matrix3 getMatrix3()
     {
         Matrix3 mat;
-        readLittleEndianBufferOfType<9, float,uint32_t>(inp, (float*)&mat.mValues);
+        readLittleEndianBufferOfType<9, float,uint32_t>(read(9 * sizeof(float)), (float*)&mat.mValues);
         return mat;
     }
 
@@ -158,64 +180,82 @@ public:
     ///Read in a string of the given length
     std::string getString(size_t length)
     {
-        std::vector<char> str(length + 1, 0);
-
-        inp->read(str.data(), length);
-
-        return str.data();
+        const char* str = read(length);
+        // The string ends at the first null character, if there is one
+        return std::string(str, std::find(str, str + length, '\0'));
     }
     ///Read in a string of the length specified in the file
     std::string getString()
     {
-        size_t size = readLittleEndianType<uint32_t,uint32_t>(inp);
+        size_t size = getUInt();
         return getString(size);
     }
     ///This is special since the version string doesn't start with a number, and ends with "\n"
     std::string getVersionString()
     {
-        std::string result;
-        std::getline(*inp, result);
+        const char* end = std::find(mPos, mEnd, '\n');
+        std::string result(mPos, end);
+        mPos = end == mEnd ? end : end + 1;
         return result;
     }
 
+    // Sizes are checked against the remaining data before allocating, so corrupt sizes don't cause huge allocations
+
     void getUShorts(std::vector<unsigned short> &vec, size_t size)
     {
+        const char* data = read(size * sizeof(unsigned short));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<unsigned short,unsigned short>(inp, vec.data(), size);
+        readLittleEndianDynamicBufferOfType<unsigned short,unsigned short>(data, vec.data(), size);
     }
 
     void getFloats(std::vector<float> &vec, size_t size)
     {
+        const char* data = read(size * sizeof(float));
         vec.resize(size);
-        readLittleEndianDynamicBufferOfType<float,uint32_t>(inp, vec.data(), size);
+        readLittleEndianDynamicBufferOfType<float,uint32_t>(data, vec.data(), size);
     }
 
     void getVector2s(std::vector<osg::Vec2f> &vec, size_t size)
     {
+        const char* data = read(size * 2 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec2f is 2 floats exactly */
-        readLittleEndianDynamicBufferOfType<float,uint32_t>(inp,(float*)vec.data(), size*2);
+        readLittleEndianDynamicBufferOfType<float,uint32_t>(data, (float*)vec.data(), size*2);
     }
 
     void getVector3s(std::vector<osg::Vec3f> &vec, size_t size)
     {
+        const char* data = read(size * 3 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec3f is 3 floats exactly */
-        readLittleEndianDynamicBufferOfType<float,uint32_t>(inp, (float*)vec.data(), size*3);
+        readLittleEndianDynamicBufferOfType<float,uint32_t>(data, (float*)vec.data(), size*3);
     }
 
     void getVector4s(std::vector<osg::Vec4f> &vec, size_t size)
     {
+        const char* data = read(size * 4 * sizeof(float));
         vec.resize(size);
         /* The packed storage of each Vec4f is 4 floats exactly */
-        readLittleEndianDynamicBufferOfType<float,uint32_t>(inp, (float*)vec.data(), size*4);
+        readLittleEndianDynamicBufferOfType<float,uint32_t>(data, (float*)vec.data(), size*4);
     }
 
     void getQuaternions(std::vector<osg::Quat> &quat, size_t size)
     {
+        const char* data = read(size * 4 * sizeof(float));
         quat.resize(size);
+        // osg::Quat stores doubles, so the floats can't be copied directly
+        float f[4];
         for (size_t i = 0;i < quat.size();i++)
-            quat[i] = getQuaternion();
+        {
+            readLittleEndianBufferOfType<4, float,uint32_t>(data + i * 4 * sizeof(float), f);
+            quat[i].set(f[1], f[2], f[3], f[0]);
+        }
+    }
+
+    void getUChars(std::vector<unsigned char> &vec, size_t size)
+    {
+        const char* data = read(size);
+        vec.assign(data, data + size);
     }
 };
 
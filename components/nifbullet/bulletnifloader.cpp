@@ -10,6 +10,8 @@
 
 #include <components/misc/stringops.hpp>
 
+#include <components/resource/bvhdiskcache.hpp>
+
 #include <components/nif/node.hpp>
 #include <components/nif/data.hpp>
 #include <components/nif/extra.hpp>
@@ -124,9 +126,10 @@ void fillTriangleMesh(btTriangleMesh& mesh, const Nif::Node* node)
 namespace NifBullet
 {
 
-osg::ref_ptr<Resource::BulletShape> BulletNifLoader::load(const Nif::File& nif)
+osg::ref_ptr<Resource::BulletShape> BulletNifLoader::load(const Nif::File& nif, const Resource::BvhDiskCache* bvhDiskCache)
 {
     mShape = new Resource::BulletShape;
+    mBvhDiskCache = bvhDiskCache;
 
     mCompoundShape.reset();
     mStaticMesh.reset();
@@ -178,23 +181,20 @@ osg::ref_ptr<Resource::BulletShape> BulletNifLoader::load(const Nif::File& nif)
             {
                 btTransform trans;
                 trans.setIdentity();
-                std::unique_ptr<btCollisionShape> child(new Resource::TriangleMeshShape(mStaticMesh.get(), true));
+                std::unique_ptr<btCollisionShape> child(createTriangleMeshShape(mStaticMesh, true));
                 mCompoundShape->addChildShape(trans, child.get());
                 child.release();
-                mStaticMesh.release();
             }
             mShape->mCollisionShape = mCompoundShape.release();
         }
         else if (mStaticMesh)
         {
-            mShape->mCollisionShape = new Resource::TriangleMeshShape(mStaticMesh.get(), true);
-            mStaticMesh.release();
+            mShape->mCollisionShape = createTriangleMeshShape(mStaticMesh, true);
         }
 
         if (mAvoidStaticMesh)
         {
-            mShape->mAvoidCollisionShape = new Resource::TriangleMeshShape(mAvoidStaticMesh.get(), false);
-            mAvoidStaticMesh.release();
+            mShape->mAvoidCollisionShape = createTriangleMeshShape(mAvoidStaticMesh, false);
         }
 
         return mShape;
@@ -393,4 +393,16 @@ void BulletNifLoader::handleNiTriShape(const Nif::Node *nifNode, int flags, cons
     }
 }
 
+Resource::TriangleMeshShape* BulletNifLoader::createTriangleMeshShape(std::unique_ptr<btTriangleMesh>& mesh,
+                                                                      bool useQuantizedAabbCompression) const
+{
+    if (!mBvhDiskCache)
+        return new Resource::TriangleMeshShape(mesh.release(), useQuantizedAabbCompression);
+
+    std::unique_ptr<Resource::TriangleMeshShape> shape(new Resource::TriangleMeshShape(mesh.get(), useQuantizedAabbCompression, false));
+    mesh.release();
+    mBvhDiskCache->buildBvh(*shape);
+    return shape.release();
+}
+
 } // namespace NifBullet
@@ -21,6 +21,11 @@ class btTriangleMesh;
 class btCompoundShape;
 class btCollisionShape;
 
+namespace Resource
+{
+    class BvhDiskCache;
+}
+
 namespace Nif
 {
     class Node;
@@ -49,7 +54,8 @@ public:
         abort();
     }
 
-    osg::ref_ptr<Resource::BulletShape> load(const Nif::File& file);
+    /// @param bvhDiskCache Reuse the BVHs of static triangle meshes stored on disk, may be null
+    osg::ref_ptr<Resource::BulletShape> load(const Nif::File& file, const Resource::BvhDiskCache* bvhDiskCache = nullptr);
 
 private:
     bool findBoundingBox(const Nif::Node* node);
@@ -61,6 +67,8 @@ private:
 
     void handleNiTriShape(const Nif::Node *nifNode, int flags, const osg::Matrixf& transform, bool isAnimated, bool avoid);
 
+    Resource::TriangleMeshShape* createTriangleMeshShape(std::unique_ptr<btTriangleMesh>& mesh, bool useQuantizedAabbCompression) const;
+
     std::unique_ptr<btCompoundShape> mCompoundShape;
 
     std::unique_ptr<btTriangleMesh> mStaticMesh;
@@ -68,6 +76,8 @@ private:
     std::unique_ptr<btTriangleMesh> mAvoidStaticMesh;
 
     osg::ref_ptr<Resource::BulletShape> mShape;
+
+    const Resource::BvhDiskCache* mBvhDiskCache = nullptr;
 };
 
 }
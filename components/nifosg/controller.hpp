@@ -9,7 +9,11 @@
 #include <components/sceneutil/controller.hpp>
 #include <components/sceneutil/statesetupdater.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <set> //UVController
+#include <vector>
 
 // FlipController
 #include <osg/Texture2D>
@@ -18,6 +22,8 @@
 #include <osg/StateSet>
 #include <osg/NodeCallback>
 #include <osg/Drawable>
+#include <osg/Quat>
+#include <osg/Vec4s>
 
 
 namespace osg
@@ -34,6 +40,49 @@ namespace osgParticle
 namespace NifOsg
 {
 
+    /// Converts keyframe values to the type they are stored as in a KeyframeTrack.
+    template <typename ValueT>
+    struct KeyframeStorage
+    {
+        typedef ValueT StoredT;
+
+        static const StoredT& encode(const ValueT& value) { return value; }
+        static const ValueT& decode(const StoredT& value) { return value; }
+    };
+
+    /// Rotations are stored with 16 bit fixed point components, a quarter of the memory of an osg::Quat.
+    template <>
+    struct KeyframeStorage<osg::Quat>
+    {
+        typedef osg::Vec4s StoredT;
+
+        static StoredT encode(const osg::Quat& value)
+        {
+            const auto quantize = [] (double component)
+            {
+                return static_cast<short>(std::round(std::min(std::max(component, -1.0), 1.0) * 32767.0));
+            };
+            return StoredT(quantize(value.x()), quantize(value.y()), quantize(value.z()), quantize(value.w()));
+        }
+
+        static osg::Quat decode(const StoredT& value)
+        {
+            osg::Quat result(value.x() / 32767.0, value.y() / 32767.0, value.z() / 32767.0, value.w() / 32767.0);
+            const double length = result.length();
+            if (length > 0.0)
+                result /= length;
+            return result;
+        }
+    };
+
+    /// Keyframe times and values in sorted arrays, shared by the copies of an interpolator.
+    template <typename ValueT>
+    struct KeyframeTrack
+    {
+        std::vector<float> mTimes;
+        std::vector<typename KeyframeStorage<ValueT>::StoredT> mValues;
+    };
+
     // interpolation of keyframes
     template <typename MapT, typename InterpolationFunc>
     class ValueInterpolator
@@ -42,18 +91,26 @@ namespace NifOsg
         typedef typename MapT::ValueType ValueT;
 
         ValueInterpolator()
-            : mDefaultVal(ValueT())
+            : mLastHighKey(0)
+            , mDefaultVal(ValueT())
         {
         }
 
         ValueInterpolator(std::shared_ptr<const MapT> keys, ValueT defaultVal = ValueT())
-            : mKeys(keys)
+            : mLastHighKey(0)
             , mDefaultVal(defaultVal)
         {
-            if (keys)
+            if (keys && !keys->mKeys.empty())
             {
-                mLastLowKey = mKeys->mKeys.end();
-                mLastHighKey = mKeys->mKeys.end();
+                std::shared_ptr<Track> track = std::make_shared<Track>();
+                track->mTimes.reserve(keys->mKeys.size());
+                track->mValues.reserve(keys->mKeys.size());
+                for (const auto& key : keys->mKeys)
+                {
+                    track->mTimes.push_back(key.first);
+                    track->mValues.push_back(Storage::encode(key.second.mValue));
+                }
+                mTrack = track;
             }
         }
 
@@ -62,61 +119,48 @@ namespace NifOsg
             if (empty())
                 return mDefaultVal;
 
-            const typename MapT::MapType & keys = mKeys->mKeys;
+            const std::vector<float>& times = mTrack->mTimes;
+            const auto& values = mTrack->mValues;
 
-            if(time <= keys.begin()->first)
-                return keys.begin()->second.mValue;
+            if(time <= times.front())
+                return Storage::decode(values.front());
+            if(time > times.back())
+                return Storage::decode(values.back());
 
-            // retrieve the current position in the map, optimized for the most common case
+            // find the first key at or after the time, optimized for the most common case
             // where time moves linearly along the keyframe track
-            typename MapT::MapType::const_iterator it = mLastHighKey;
-            if (mLastHighKey != keys.end())
+            std::size_t high = mLastHighKey;
+            if (high == 0 || high >= times.size() || time <= times[high - 1] || time > times[high])
             {
-                if (time > mLastHighKey->first)
-                {
-                    // try if we're there by incrementing one
-                    ++mLastLowKey;
-                    ++mLastHighKey;
-                    it = mLastHighKey;
-                }
-                if (mLastHighKey == keys.end() || (time < mLastLowKey->first || time > mLastHighKey->first))
-                    it = keys.lower_bound(time); // still not there, reorient by performing lower_bound check on the whole map
+                // try if we're there by incrementing one
+                if (high + 1 < times.size() && times[high] < time && time <= times[high + 1])
+                    ++high;
+                else
+                    high = std::lower_bound(times.begin(), times.end(), time) - times.begin();
             }
-            else
-                it = keys.lower_bound(time);
 
-            // now do the actual interpolation
-            if (it != keys.end())
-            {
-                float aTime = it->first;
-                const typename MapT::KeyType* aKey = &it->second;
-
-                // cache for next time
-                mLastHighKey = it;
-
-                typename MapT::MapType::const_iterator last = --it;
-                mLastLowKey = last;
-                float aLastTime = last->first;
-                const typename MapT::KeyType* aLastKey = &last->second;
+            // cache for next time
+            mLastHighKey = high;
 
-                float a = (time - aLastTime) / (aTime - aLastTime);
+            // now do the actual interpolation
+            const std::size_t low = high - 1;
+            float a = (time - times[low]) / (times[high] - times[low]);
 
-                return InterpolationFunc()(aLastKey->mValue, aKey->mValue, a);
-            }
-            else
-                return keys.rbegin()->second.mValue;
+            return InterpolationFunc()(Storage::decode(values[low]), Storage::decode(values[high]), a);
         }
 
         bool empty() const
         {
-            return !mKeys || mKeys->mKeys.empty();
+            return !mTrack;
         }
 
     private:
-        mutable typename MapT::MapType::const_iterator mLastLowKey;
-        mutable typename MapT::MapType::const_iterator mLastHighKey;
+        typedef KeyframeStorage<ValueT> Storage;
+        typedef KeyframeTrack<ValueT> Track;
+
+        mutable std::size_t mLastHighKey;
 
-        std::shared_ptr<const MapT> mKeys;
+        std::shared_ptr<const Track> mTrack;
 
         ValueT mDefaultVal;
     };
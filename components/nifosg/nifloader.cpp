@@ -1,5 +1,7 @@
 #include "nifloader.hpp"
 
+#include <algorithm>
+
 #include <osg/Matrixf>
 #include <osg/MatrixTransform>
 #include <osg/Geometry>
@@ -180,6 +182,18 @@ namespace NifOsg
         return sShowMarkers;
     }
 
+    bool Loader::sCompactVertexColors = false;
+
+    void Loader::setCompactVertexColors(bool compact)
+    {
+        sCompactVertexColors = compact;
+    }
+
+    bool Loader::getCompactVertexColors()
+    {
+        return sCompactVertexColors;
+    }
+
     class LoaderImpl
     {
     public:
@@ -358,7 +372,7 @@ namespace NifOsg
             else
             {
                 std::string filename = Misc::ResourceHelpers::correctTexturePath(st->filename, imageManager->getVFS());
-                image = imageManager->getImage(filename);
+                image = imageManager->getImage(filename, true);
             }
             return image;
         }
@@ -826,7 +840,7 @@ namespace NifOsg
 
         void handleParticlePrograms(Nif::NiParticleModifierPtr affectors, Nif::NiParticleModifierPtr colliders, osg::Group *attachTo, osgParticle::ParticleSystem* partsys, osgParticle::ParticleProcessor::ReferenceFrame rf)
         {
-            osgParticle::ModularProgram* program = new osgParticle::ModularProgram;
+            ParticleProgram* program = new ParticleProgram;
             attachTo->addChild(program);
             program->setParticleSystem(partsys);
             program->setReferenceFrame(rf);
@@ -1046,7 +1060,7 @@ namespace NifOsg
 
             // particle system updater (after the emitters and affectors in the scene graph)
             // I think for correct culling needs to be *before* the ParticleSystem, though osg examples do it the other way
-            osg::ref_ptr<osgParticle::ParticleSystemUpdater> updater = new osgParticle::ParticleSystemUpdater;
+            osg::ref_ptr<ParticleSystemUpdater> updater = new ParticleSystemUpdater;
             updater->addParticleSystem(partsys);
             parentNode->addChild(updater);
 
@@ -1070,7 +1084,21 @@ namespace NifOsg
             if (!normals.empty())
                 geometry->setNormalArray(new osg::Vec3Array(normals.size(), normals.data()), osg::Array::BIND_PER_VERTEX);
             if (!colors.empty())
-                geometry->setColorArray(new osg::Vec4Array(colors.size(), colors.data()), osg::Array::BIND_PER_VERTEX);
+            {
+                if (Loader::getCompactVertexColors())
+                {
+                    osg::ref_ptr<osg::Vec4ubArray> compactColors (new osg::Vec4ubArray(colors.size()));
+                    for (std::size_t i = 0; i < colors.size(); ++i)
+                    {
+                        for (int j = 0; j < 4; ++j)
+                            (*compactColors)[i][j] = static_cast<unsigned char>(std::min(1.f, std::max(0.f, colors[i][j])) * 255.f + 0.5f);
+                    }
+                    compactColors->setNormalize(true);
+                    geometry->setColorArray(compactColors, osg::Array::BIND_PER_VERTEX);
+                }
+                else
+                    geometry->setColorArray(new osg::Vec4Array(colors.size(), colors.data()), osg::Array::BIND_PER_VERTEX);
+            }
 
             int textureStage = 0;
             for (const unsigned int uvSet : boundTextures)
@@ -74,9 +74,17 @@ namespace NifOsg
 
         static bool getShowMarkers();
 
+        /// Set whether vertex colors should be stored as normalized unsigned bytes instead of floats.
+        /// Takes a quarter of the memory, but colors outside of [0, 1] are clamped.
+        /// Default: false.
+        static void setCompactVertexColors(bool compact);
+
+        static bool getCompactVertexColors();
+
     private:
 
         static bool sShowMarkers;
+        static bool sCompactVertexColors;
     };
 
 }
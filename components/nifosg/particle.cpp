@@ -1,17 +1,25 @@
 #include "particle.hpp"
 
+#include <algorithm>
 #include <limits>
 
 #include <osg/MatrixTransform>
 #include <osg/Geometry>
+#include <osg/FrameStamp>
 
 #include <components/debug/debuglog.hpp>
 #include <components/misc/rng.hpp>
 #include <components/nif/controlled.hpp>
 #include <components/nif/data.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "userdata.hpp"
 
+namespace
+{
+    thread_local NifOsg::ParallelParticleUpdater* sCurrentUpdater = nullptr;
+}
+
 namespace NifOsg
 {
 
@@ -24,6 +32,7 @@ ParticleSystem::ParticleSystem()
 ParticleSystem::ParticleSystem(const ParticleSystem &copy, const osg::CopyOp &copyop)
     : osgParticle::ParticleSystem(copy, copyop)
     , mQuota(copy.mQuota)
+    , mInitialState(copy.mInitialState ? copy.mInitialState : &copy)
 {
     // For some reason the osgParticle constructor doesn't copy the particles
     for (int i=0;i<copy.numParticles()-copy.numDeadParticles();++i)
@@ -35,6 +44,20 @@ void ParticleSystem::setQuota(int quota)
     mQuota = quota;
 }
 
+void ParticleSystem::resetParticles()
+{
+    ScopedWriteLock lock(*getReadWriteMutex());
+
+    _particles.clear();
+    _deadparts = Death_stack();
+
+    if (!mInitialState)
+        return;
+
+    for (int i=0;i<mInitialState->numParticles()-mInitialState->numDeadParticles();++i)
+        ParticleSystem::createParticle(mInitialState->getParticle(i));
+}
+
 osgParticle::Particle* ParticleSystem::createParticle(const osgParticle::Particle *ptemplate)
 {
     if (numParticles()-numDeadParticles() < mQuota)
@@ -42,6 +65,220 @@ osgParticle::Particle* ParticleSystem::createParticle(const osgParticle::Particl
     return nullptr;
 }
 
+ParticleProgram::ParticleProgram()
+    : osgParticle::ModularProgram()
+{
+}
+
+ParticleProgram::ParticleProgram(const ParticleProgram &copy, const osg::CopyOp &copyop)
+    : osgParticle::ModularProgram(copy, copyop)
+{
+    // The operators cache the program's transforms in beginOperate
+    for (int i=0; i<getNumOperators(); ++i)
+        setOperator(i, osg::clone(getOperator(i), osg::CopyOp::SHALLOW_COPY));
+}
+
+void ParticleProgram::run(double dt)
+{
+    osgParticle::ModularProgram::execute(dt);
+}
+
+void ParticleProgram::reset()
+{
+    _t0 = -1.0;
+    _currentTime = 0.0;
+}
+
+void ParticleProgram::execute(double dt)
+{
+    ParallelParticleUpdater* updater = ParallelParticleUpdater::getCurrent();
+    if (!updater)
+    {
+        run(dt);
+        return;
+    }
+
+    // The transforms are computed from the node path of the traversal, so compute them before it moves on
+    if (getReferenceFrame() == ABSOLUTE_RF)
+    {
+        getLocalToWorldMatrix();
+        getWorldToLocalMatrix();
+    }
+    updater->addProgram(this, dt);
+}
+
+ParticleSystemUpdater::ParticleSystemUpdater()
+    : osgParticle::ParticleSystemUpdater()
+    , mT0(-1.0)
+    , mFrameNumber(0)
+{
+}
+
+ParticleSystemUpdater::ParticleSystemUpdater(const ParticleSystemUpdater &copy, const osg::CopyOp &copyop)
+    : osgParticle::ParticleSystemUpdater(copy, copyop)
+    , mT0(-1.0)
+    , mFrameNumber(0)
+{
+}
+
+void ParticleSystemUpdater::traverse(osg::NodeVisitor &nv)
+{
+    // Same as osgParticle::ParticleSystemUpdater, which doesn't update the systems in the first frame either
+    const osg::FrameStamp* frameStamp = nv.getFrameStamp();
+    if (nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR && frameStamp && mFrameNumber < frameStamp->getFrameNumber())
+    {
+        mFrameNumber = frameStamp->getFrameNumber();
+        const double t = frameStamp->getSimulationTime();
+        if (mT0 != -1.0)
+        {
+            ParallelParticleUpdater* updater = ParallelParticleUpdater::getCurrent();
+            for (unsigned int i=0; i<getNumParticleSystems(); ++i)
+            {
+                osgParticle::ParticleSystem* partsys = getParticleSystem(i);
+                if (partsys->isFrozen() || (partsys->getFreezeOnCull() && partsys->getLastFrameNumber() + 1 < mFrameNumber))
+                    continue;
+
+                if (updater)
+                    updater->addUpdate(partsys, t - mT0);
+                else
+                {
+                    osgParticle::ParticleSystem::ScopedWriteLock lock(*partsys->getReadWriteMutex());
+                    partsys->update(t - mT0, nv);
+                }
+            }
+        }
+        mT0 = t;
+    }
+    osg::Node::traverse(nv);
+}
+
+void ParticleSystemUpdater::reset()
+{
+    mT0 = -1.0;
+}
+
+class ParallelParticleUpdater::RunTasksItem : public SceneUtil::WorkItem
+{
+public:
+    RunTasksItem(ParallelParticleUpdater* updater, std::size_t first, std::size_t stride, osg::NodeVisitor* nv)
+        : mUpdater(updater)
+        , mFirst(first)
+        , mStride(stride)
+        , mNodeVisitor(nv)
+    {
+    }
+
+    virtual void doWork()
+    {
+        mUpdater->runTasks(mFirst, mStride, *mNodeVisitor);
+    }
+
+private:
+    ParallelParticleUpdater* mUpdater;
+    std::size_t mFirst;
+    std::size_t mStride;
+    osg::NodeVisitor* mNodeVisitor;
+};
+
+ParallelParticleUpdater::ParallelParticleUpdater(int numThreads)
+    : mNumThreads(std::max(0, numThreads))
+{
+    if (mNumThreads > 0)
+        mWorkQueue = new SceneUtil::WorkQueue(mNumThreads);
+}
+
+ParallelParticleUpdater::~ParallelParticleUpdater()
+{
+}
+
+ParallelParticleUpdater* ParallelParticleUpdater::getCurrent()
+{
+    return sCurrentUpdater;
+}
+
+void ParallelParticleUpdater::operator()(osg::Node *node, osg::NodeVisitor *nv)
+{
+    if (sCurrentUpdater)
+    {
+        traverse(node, nv);
+        return;
+    }
+
+    sCurrentUpdater = this;
+    traverse(node, nv);
+    sCurrentUpdater = nullptr;
+
+    runTasks(*nv);
+}
+
+ParallelParticleUpdater::Task& ParallelParticleUpdater::getTask(osgParticle::ParticleSystem *partsys)
+{
+    auto found = mTaskIndices.emplace(partsys, mTasks.size());
+    if (found.second)
+    {
+        mTasks.emplace_back();
+        mTasks.back().mParticleSystem = partsys;
+        mTasks.back().mUpdate = false;
+        mTasks.back().mUpdateDt = 0.0;
+    }
+    return mTasks[found.first->second];
+}
+
+void ParallelParticleUpdater::addProgram(ParticleProgram *program, double dt)
+{
+    getTask(program->getParticleSystem()).mPrograms.emplace_back(program, dt);
+}
+
+void ParallelParticleUpdater::addUpdate(osgParticle::ParticleSystem *partsys, double dt)
+{
+    Task& task = getTask(partsys);
+    task.mUpdate = true;
+    task.mUpdateDt = dt;
+}
+
+void ParallelParticleUpdater::runTasks(osg::NodeVisitor &nv)
+{
+    if (mTasks.empty())
+        return;
+
+    // Updating a system dirties the bounds of its parents, which may be shared with other systems.
+    // Once the system's bound is dirty, the update doesn't touch the parents.
+    for (const Task& task : mTasks)
+    {
+        if (task.mUpdate)
+            task.mParticleSystem->dirtyBound();
+    }
+
+    const std::size_t stride = std::min(mTasks.size(), static_cast<std::size_t>(mNumThreads) + 1);
+    std::vector<osg::ref_ptr<RunTasksItem> > items;
+    for (std::size_t first=1; first<stride; ++first)
+    {
+        items.emplace_back(new RunTasksItem(this, first, stride, &nv));
+        mWorkQueue->addWorkItem(items.back(), true);
+    }
+
+    runTasks(0, stride, nv);
+
+    for (const osg::ref_ptr<RunTasksItem>& item : items)
+        item->waitTillDone();
+
+    mTasks.clear();
+    mTaskIndices.clear();
+}
+
+void ParallelParticleUpdater::runTasks(std::size_t first, std::size_t stride, osg::NodeVisitor &nv)
+{
+    for (std::size_t i=first; i<mTasks.size(); i+=stride)
+    {
+        Task& task = mTasks[i];
+        osgParticle::ParticleSystem::ScopedWriteLock lock(*task.mParticleSystem->getReadWriteMutex());
+        for (const auto& program : task.mPrograms)
+            program.first->run(program.second);
+        if (task.mUpdate)
+            task.mParticleSystem->update(task.mUpdateDt, nv);
+    }
+}
+
 void InverseWorldMatrix::operator()(osg::Node *node, osg::NodeVisitor *nv)
 {
     if (nv && nv->getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR)
@@ -248,6 +485,7 @@ Emitter::Emitter(const Emitter &copy, const osg::CopyOp &copyop)
     , mShooter(copy.mShooter)
     // need a deep copy because the remainder is stored in the object
     , mCounter(osg::clone(copy.mCounter.get(), osg::CopyOp::DEEP_COPY_ALL))
+    , mInitialCounter(copy.mInitialCounter ? copy.mInitialCounter : copy.mCounter)
 {
 }
 
@@ -271,6 +509,15 @@ void Emitter::setCounter(osgParticle::Counter *counter)
     mCounter = counter;
 }
 
+void Emitter::reset()
+{
+    _t0 = -1.0;
+    _currentTime = 0.0;
+
+    if (mInitialCounter)
+        mCounter = osg::clone(mInitialCounter.get(), osg::CopyOp::DEEP_COPY_ALL);
+}
+
 void Emitter::emitParticles(double dt)
 {
     int n = mCounter->numParticlesToCreate(dt);
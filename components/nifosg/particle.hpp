@@ -7,9 +7,15 @@
 #include <osgParticle/Emitter>
 #include <osgParticle/Placer>
 #include <osgParticle/Counter>
+#include <osgParticle/ModularProgram>
+#include <osgParticle/ParticleSystemUpdater>
 
 #include <osg/NodeCallback>
 
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "controller.hpp" // ValueInterpolator
 
 namespace Nif
@@ -20,6 +26,11 @@ namespace Nif
     class NiColorData;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace NifOsg
 {
 
@@ -36,8 +47,95 @@ namespace NifOsg
 
         void setQuota(int quota);
 
+        /// Replace the particles by those the system was copied from, to reuse it like a new copy.
+        void resetParticles();
+
     private:
         int mQuota;
+        // The system this one was copied from, holds the initial particles
+        osg::ref_ptr<const ParticleSystem> mInitialState;
+    };
+
+    // Subclass ModularProgram to run the operators deferred to a ParallelParticleUpdater.
+    // The operators are copied with the program, so the programs of separate instances can run in parallel.
+    class ParticleProgram : public osgParticle::ModularProgram
+    {
+    public:
+        ParticleProgram();
+        ParticleProgram(const ParticleProgram& copy, const osg::CopyOp& copyop);
+
+        META_Node(NifOsg, ParticleProgram)
+
+        /// Run the operators on the particle system.
+        void run(double dt);
+
+        /// Restart the time of the program, as if it was never traversed.
+        void reset();
+
+    protected:
+        virtual void execute(double dt);
+    };
+
+    // Subclass ParticleSystemUpdater to update the particle systems deferred to a ParallelParticleUpdater.
+    class ParticleSystemUpdater : public osgParticle::ParticleSystemUpdater
+    {
+    public:
+        ParticleSystemUpdater();
+        ParticleSystemUpdater(const ParticleSystemUpdater& copy, const osg::CopyOp& copyop);
+
+        META_Node(NifOsg, ParticleSystemUpdater)
+
+        virtual void traverse(osg::NodeVisitor& nv);
+
+        /// Restart the time of the updater, as if it was never traversed.
+        void reset();
+
+    private:
+        double mT0;
+        unsigned int mFrameNumber;
+    };
+
+    /// @brief Update callback that collects the work of the ParticlePrograms and ParticleSystemUpdaters of its subgraph,
+    /// and runs the work once the subgraph is traversed, that of separate particle systems in parallel.
+    /// @par Particle systems that were not drawn in the last frames stay frozen and are not updated.
+    class ParallelParticleUpdater : public osg::NodeCallback
+    {
+    public:
+        /// @param numThreads Worker threads in addition to the updating thread.
+        ParallelParticleUpdater(int numThreads);
+        ~ParallelParticleUpdater();
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+        /// Get the updater whose subgraph the calling thread is traversing, nullptr if none.
+        static ParallelParticleUpdater* getCurrent();
+
+        void addProgram(ParticleProgram* program, double dt);
+        void addUpdate(osgParticle::ParticleSystem* partsys, double dt);
+
+    private:
+        class RunTasksItem;
+
+        /// The work of one particle system, in the order of the traversal.
+        struct Task
+        {
+            osg::ref_ptr<osgParticle::ParticleSystem> mParticleSystem;
+            std::vector<std::pair<osg::ref_ptr<ParticleProgram>, double> > mPrograms;
+            bool mUpdate;
+            double mUpdateDt;
+        };
+
+        Task& getTask(osgParticle::ParticleSystem* partsys);
+
+        void runTasks(osg::NodeVisitor& nv);
+
+        /// Run every \a stride th task starting at \a first.
+        void runTasks(std::size_t first, std::size_t stride, osg::NodeVisitor& nv);
+
+        int mNumThreads;
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        std::vector<Task> mTasks;
+        std::map<const osgParticle::ParticleSystem*, std::size_t> mTaskIndices;
     };
 
     // HACK: Particle doesn't allow setting the initial age, but we need this for loading the particle system state
@@ -235,6 +333,9 @@ namespace NifOsg
         void setPlacer(osgParticle::Placer* placer);
         void setCounter(osgParticle::Counter* counter);
 
+        /// Restart the time and the counter of the emitter, as if it was never traversed.
+        void reset();
+
     private:
         // NIF Record indices
         std::vector<int> mTargets;
@@ -242,6 +343,8 @@ namespace NifOsg
         osg::ref_ptr<osgParticle::Placer> mPlacer;
         osg::ref_ptr<osgParticle::Shooter> mShooter;
         osg::ref_ptr<osgParticle::Counter> mCounter;
+        // The counter of the template emitter, that never emitted any particles
+        osg::ref_ptr<const osgParticle::Counter> mInitialCounter;
     };
 
 }
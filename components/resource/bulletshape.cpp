@@ -96,15 +96,70 @@ void BulletShape::setLocalScaling(const btVector3& scale)
         mAvoidCollisionShape->setLocalScaling(scale);
 }
 
+std::size_t BulletShape::estimateMemoryUsage() const
+{
+    return sizeof(*this) + estimateMemoryUsage(mCollisionShape) + estimateMemoryUsage(mAvoidCollisionShape);
+}
+
+std::size_t BulletShape::estimateMemoryUsage(const btCollisionShape* shape)
+{
+    if (shape == nullptr)
+        return 0;
+
+    if (shape->isCompound())
+    {
+        const btCompoundShape* compound = static_cast<const btCompoundShape*>(shape);
+        std::size_t size = sizeof(btCompoundShape);
+        for (int i = 0; i < compound->getNumChildShapes(); ++i)
+            size += estimateMemoryUsage(compound->getChildShape(i));
+        return size;
+    }
+
+    if (const btBvhTriangleMeshShape* trishape = dynamic_cast<const btBvhTriangleMeshShape*>(shape))
+    {
+        std::size_t size = sizeof(btBvhTriangleMeshShape);
+        const btStridingMeshInterface* mesh = trishape->getMeshInterface();
+        for (int part = 0; part < mesh->getNumSubParts(); ++part)
+        {
+            const unsigned char* vertices = nullptr;
+            const unsigned char* indices = nullptr;
+            int numVertices = 0;
+            int vertexStride = 0;
+            int numTriangles = 0;
+            int indexStride = 0;
+            PHY_ScalarType vertexType;
+            PHY_ScalarType indexType;
+            mesh->getLockedReadOnlyVertexIndexBase(&vertices, numVertices, vertexType, vertexStride,
+                &indices, indexStride, numTriangles, indexType, part);
+            size += static_cast<std::size_t>(numVertices) * vertexStride + static_cast<std::size_t>(numTriangles) * indexStride;
+            mesh->unLockReadOnlyVertexBase(part);
+        }
+        if (btOptimizedBvh* bvh = const_cast<btBvhTriangleMeshShape*>(trishape)->getOptimizedBvh())
+        {
+            size += bvh->getQuantizedNodeArray().size() * sizeof(btQuantizedBvhNode)
+                + bvh->getLeafNodeArray().size() * sizeof(btOptimizedBvhNode)
+                + bvh->getSubtreeInfoArray().size() * sizeof(btBvhSubtreeInfo);
+        }
+        return size;
+    }
+
+    // Scaled meshes of instances share the mesh of their source
+    if (dynamic_cast<const btScaledBvhTriangleMeshShape*>(shape))
+        return sizeof(btScaledBvhTriangleMeshShape);
+
+    return sizeof(btBoxShape);
+}
+
 osg::ref_ptr<BulletShapeInstance> BulletShape::makeInstance() const
 {
     osg::ref_ptr<BulletShapeInstance> instance (new BulletShapeInstance(this));
     return instance;
 }
 
-BulletShapeInstance::BulletShapeInstance(osg::ref_ptr<const BulletShape> source)
+BulletShapeInstance::BulletShapeInstance(osg::ref_ptr<const BulletShape> source, bool shared)
     : BulletShape()
     , mSource(source)
+    , mShared(shared)
 {
     mCollisionBoxHalfExtents = source->mCollisionBoxHalfExtents;
     mCollisionBoxTranslate = source->mCollisionBoxTranslate;
@@ -118,4 +173,34 @@ BulletShapeInstance::BulletShapeInstance(osg::ref_ptr<const BulletShape> source)
         mAvoidCollisionShape = duplicateCollisionShape(source->mAvoidCollisionShape);
 }
 
+TriangleMeshShape::~TriangleMeshShape()
+{
+    delete getTriangleInfoMap();
+    delete m_meshInterface;
+
+    if (mSerializedBvh)
+        mSerializedBvh->~btOptimizedBvh();
+    btAlignedFree(mSerializedBvhBuffer);
+}
+
+bool TriangleMeshShape::setSerializedBvh(void* buffer, unsigned int size)
+{
+    if (m_bvh != nullptr || mSerializedBvhBuffer != nullptr)
+        throw std::logic_error("TriangleMeshShape already has a BVH");
+
+    mSerializedBvhBuffer = buffer;
+
+    btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(buffer, size, false);
+    if (bvh == nullptr)
+        return false;
+
+    mSerializedBvh = bvh;
+    if (bvh->isQuantized() != usesQuantizedAabbCompression())
+        return false;
+
+    // Not owned by the base class, the nodes point into the buffer
+    setOptimizedBvh(bvh);
+    return true;
+}
+
 }
@@ -1,6 +1,7 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_BULLETSHAPE_H
 #define OPENMW_COMPONENTS_RESOURCE_BULLETSHAPE_H
 
+#include <cstddef>
 #include <map>
 
 #include <osg/Object>
@@ -48,9 +49,15 @@ namespace Resource
 
         void setLocalScaling(const btVector3& scale);
 
+        /// Estimate the memory used by the collision shapes, including their triangle meshes and bounding volume
+        /// hierarchies, in bytes.
+        std::size_t estimateMemoryUsage() const;
+
     private:
 
         void deleteShape(btCollisionShape* shape);
+
+        static std::size_t estimateMemoryUsage(const btCollisionShape* shape);
     };
 
 
@@ -59,10 +66,17 @@ namespace Resource
     class BulletShapeInstance : public BulletShape
     {
     public:
-        BulletShapeInstance(osg::ref_ptr<const BulletShape> source);
+        BulletShapeInstance(osg::ref_ptr<const BulletShape> source, bool shared=false);
+
+        /// Shared instances are used by all objects with the same shape and scale, and must not be changed. Objects that need
+        /// a different scale get an instance of their own from the source.
+        bool isShared() const { return mShared; }
+
+        const osg::ref_ptr<const BulletShape>& getSource() const { return mSource; }
 
     private:
         osg::ref_ptr<const BulletShape> mSource;
+        bool mShared;
     };
 
     // Subclass btBhvTriangleMeshShape to auto-delete the meshInterface
@@ -70,14 +84,21 @@ namespace Resource
     {
         TriangleMeshShape(btStridingMeshInterface* meshInterface, bool useQuantizedAabbCompression, bool buildBvh = true)
             : btBvhTriangleMeshShape(meshInterface, useQuantizedAabbCompression, buildBvh)
+            , mSerializedBvh(nullptr)
+            , mSerializedBvhBuffer(nullptr)
         {
         }
 
-        virtual ~TriangleMeshShape()
-        {
-            delete getTriangleInfoMap();
-            delete m_meshInterface;
-        }
+        virtual ~TriangleMeshShape();
+
+        /// Use a BVH serialized in place with btOptimizedBvh::serializeInPlace, for a shape created without a BVH.
+        /// @param buffer Allocated with btAlignedAlloc, the shape takes ownership of it even if it's not valid.
+        /// @return false if the buffer doesn't hold a valid BVH
+        bool setSerializedBvh(void* buffer, unsigned int size);
+
+    private:
+        btOptimizedBvh* mSerializedBvh;
+        void* mSerializedBvhBuffer;
     };
 
 
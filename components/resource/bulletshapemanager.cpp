@@ -13,6 +13,7 @@
 #include <components/nifbullet/bulletnifloader.hpp>
 
 #include "bulletshape.hpp"
+#include "bvhdiskcache.hpp"
 #include "scenemanager.hpp"
 #include "niffilemanager.hpp"
 #include "objectcache.hpp"
@@ -80,13 +81,21 @@ public:
         drawable.accept(functor);
     }
 
-    osg::ref_ptr<BulletShape> getShape()
+    osg::ref_ptr<BulletShape> getShape(const BvhDiskCache* bvhDiskCache)
     {
         if (!mTriangleMesh)
             return osg::ref_ptr<BulletShape>();
 
         osg::ref_ptr<BulletShape> shape (new BulletShape);
-        shape->mCollisionShape = new TriangleMeshShape(mTriangleMesh.release(), true);
+        if (bvhDiskCache)
+        {
+            std::unique_ptr<TriangleMeshShape> trishape (new TriangleMeshShape(mTriangleMesh.get(), true, false));
+            mTriangleMesh.release();
+            bvhDiskCache->buildBvh(*trishape);
+            shape->mCollisionShape = trishape.release();
+        }
+        else
+            shape->mCollisionShape = new TriangleMeshShape(mTriangleMesh.release(), true);
         return shape;
     }
 
@@ -108,6 +117,11 @@ BulletShapeManager::~BulletShapeManager()
 
 }
 
+void BulletShapeManager::setBvhDiskCachePath(const std::string &path)
+{
+    mBvhDiskCache = new BvhDiskCache(path);
+}
+
 osg::ref_ptr<const BulletShape> BulletShapeManager::getShape(const std::string &name)
 {
     std::string normalized = name;
@@ -127,7 +141,7 @@ osg::ref_ptr<const BulletShape> BulletShapeManager::getShape(const std::string &
         if (ext == "nif")
         {
             NifBullet::BulletNifLoader loader;
-            shape = loader.load(*mNifFileManager->get(normalized));
+            shape = loader.load(*mNifFileManager->get(normalized), mBvhDiskCache);
         }
         else
         {
@@ -137,12 +151,12 @@ osg::ref_ptr<const BulletShape> BulletShapeManager::getShape(const std::string &
             osg::ref_ptr<osg::Node> node (const_cast<osg::Node*>(constNode.get())); // const-trickery required because there is no const version of NodeVisitor
             NodeToShapeVisitor visitor;
             node->accept(visitor);
-            shape = visitor.getShape();
+            shape = visitor.getShape(mBvhDiskCache);
             if (!shape)
                 return osg::ref_ptr<BulletShape>();
         }
 
-        mCache->addEntryToObjectCache(normalized, shape);
+        mCache->addEntryToObjectCache(normalized, shape, 0.0, shape->estimateMemoryUsage());
     }
     return shape;
 }
@@ -152,6 +166,11 @@ osg::ref_ptr<BulletShapeInstance> BulletShapeManager::cacheInstance(const std::s
     std::string normalized = name;
     mVFS->normalizeFilename(normalized);
 
+    // Objects without animated collision nodes use shared instances, so only the shape needs to be loaded
+    osg::ref_ptr<const BulletShape> shape = getShape(normalized);
+    if (shape && shape->mAnimatedShapes.empty())
+        return getSharedInstance(normalized, 1.f);
+
     osg::ref_ptr<BulletShapeInstance> instance = createInstance(normalized);
     if (instance)
         mInstanceCache->addEntryToObjectCache(normalized, instance.get());
@@ -170,6 +189,36 @@ osg::ref_ptr<BulletShapeInstance> BulletShapeManager::getInstance(const std::str
         return createInstance(normalized);
 }
 
+osg::ref_ptr<BulletShapeInstance> BulletShapeManager::getSharedInstance(const std::string &name, float scale)
+{
+    std::string normalized = name;
+    mVFS->normalizeFilename(normalized);
+
+    osg::ref_ptr<const BulletShape> shape = getShape(normalized);
+    if (!shape)
+        return osg::ref_ptr<BulletShapeInstance>();
+
+    // Animated collision nodes move the child shapes of the instance
+    if (!shape->mAnimatedShapes.empty())
+    {
+        osg::ref_ptr<BulletShapeInstance> instance = getInstance(normalized);
+        if (instance)
+            instance->setLocalScaling(btVector3(scale, scale, scale));
+        return instance;
+    }
+
+    std::lock_guard<std::mutex> lock(mSharedInstancesMutex);
+    osg::observer_ptr<BulletShapeInstance>& shared = mSharedInstances[std::make_pair(normalized, scale)];
+    osg::ref_ptr<BulletShapeInstance> instance;
+    if (shared.lock(instance))
+        return instance;
+
+    instance = new BulletShapeInstance(shape, true);
+    instance->setLocalScaling(btVector3(scale, scale, scale));
+    shared = instance;
+    return instance;
+}
+
 osg::ref_ptr<BulletShapeInstance> BulletShapeManager::createInstance(const std::string &name)
 {
     osg::ref_ptr<const BulletShape> shape = getShape(name);
@@ -184,6 +233,15 @@ void BulletShapeManager::updateCache(double referenceTime)
     ResourceManager::updateCache(referenceTime);
 
     mInstanceCache->removeUnreferencedObjectsInCache();
+
+    std::lock_guard<std::mutex> lock(mSharedInstancesMutex);
+    for (auto it = mSharedInstances.begin(); it != mSharedInstances.end();)
+    {
+        if (!it->second.valid())
+            it = mSharedInstances.erase(it);
+        else
+            ++it;
+    }
 }
 
 void BulletShapeManager::clearCache()
@@ -197,6 +255,9 @@ void BulletShapeManager::reportStats(unsigned int frameNumber, osg::Stats *stats
 {
     stats->setAttribute(frameNumber, "Shape", mCache->getCacheSize());
     stats->setAttribute(frameNumber, "Shape Instance", mInstanceCache->getCacheSize());
+
+    std::lock_guard<std::mutex> lock(mSharedInstancesMutex);
+    stats->setAttribute(frameNumber, "Shared Shape Instance", mSharedInstances.size());
 }
 
 }
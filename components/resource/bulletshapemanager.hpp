@@ -2,8 +2,10 @@
 #define OPENMW_COMPONENTS_BULLETSHAPEMANAGER_H
 
 #include <map>
+#include <mutex>
 #include <string>
 
+#include <osg/observer_ptr>
 #include <osg/ref_ptr>
 
 #include "bulletshape.hpp"
@@ -18,6 +20,7 @@ namespace Resource
     class BulletShapeInstance;
 
     class MultiObjectCache;
+    class BvhDiskCache;
 
     /// Handles loading, caching and "instancing" of bullet shapes.
     /// A shape 'instance' is a clone of another shape, with the goal of setting a different scale on this instance.
@@ -28,6 +31,10 @@ namespace Resource
         BulletShapeManager(const VFS::Manager* vfs, SceneManager* sceneMgr, NifFileManager* nifFileManager);
         ~BulletShapeManager();
 
+        /// Store the BVHs of triangle mesh shapes in the given directory and reuse them on next runs, see BvhDiskCache.
+        /// @note Empty path disables the cache. Not thread safe, call before loading any shapes.
+        void setBvhDiskCachePath(const std::string& path);
+
         /// @note May return a null pointer if the object has no shape.
         osg::ref_ptr<const BulletShape> getShape(const std::string& name);
 
@@ -39,17 +46,30 @@ namespace Resource
         /// @note May return a null pointer if the object has no shape.
         osg::ref_ptr<BulletShapeInstance> getInstance(const std::string& name);
 
+        /// Get an instance of the given shape with the given scale. Instances of shapes without animated collision nodes are
+        /// shared by all callers requesting the same scale, see BulletShapeInstance::isShared().
+        /// @note May return a null pointer if the object has no shape.
+        osg::ref_ptr<BulletShapeInstance> getSharedInstance(const std::string& name, float scale);
+
         /// @see ResourceManager::updateCache
         virtual void updateCache(double referenceTime);
 
         virtual void clearCache();
 
+        const char* getName() const { return "Bullet Shape"; }
+
         void reportStats(unsigned int frameNumber, osg::Stats *stats) const;
 
     private:
         osg::ref_ptr<BulletShapeInstance> createInstance(const std::string& name);
 
         osg::ref_ptr<MultiObjectCache> mInstanceCache;
+
+        osg::ref_ptr<BvhDiskCache> mBvhDiskCache;
+
+        mutable std::mutex mSharedInstancesMutex;
+        std::map<std::pair<std::string, float>, osg::observer_ptr<BulletShapeInstance> > mSharedInstances;
+
         SceneManager* mSceneManager;
         NifFileManager* mNifFileManager;
     };
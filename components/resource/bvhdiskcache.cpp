@@ -0,0 +1,180 @@
+#include "bvhdiskcache.hpp"
+
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <LinearMath/btAlignedAllocator.h>
+#include <LinearMath/btScalar.h>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/debug/debuglog.hpp>
+#include <components/misc/keyhasher.hpp>
+
+#include "bulletshape.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    constexpr std::uint32_t sVersion = 1;
+
+    // Alignment of the nodes of btOptimizedBvh
+    constexpr int sAlignment = 16;
+
+    struct AlignedFree
+    {
+        void operator()(void* buffer) const
+        {
+            btAlignedFree(buffer);
+        }
+    };
+
+    typedef std::unique_ptr<void, AlignedFree> AlignedBuffer;
+}
+
+namespace Resource
+{
+
+    BvhDiskCache::BvhDiskCache(const std::string& path)
+    {
+        if (path.empty())
+            return;
+
+        try
+        {
+            boost::filesystem::create_directories(path);
+            mPath = path;
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Collision shape disk cache is disabled: failed to create directory \""
+                << path << "\": " << e.what();
+        }
+    }
+
+    std::string BvhDiskCache::makeKey(const btStridingMeshInterface& mesh, bool useQuantizedAabbCompression)
+    {
+        Misc::KeyHasher hasher;
+        hasher.add(sVersion);
+        hasher.add(static_cast<int>(BT_BULLET_VERSION));
+        hasher.add(sizeof(void*));
+        hasher.add(sizeof(btScalar));
+        hasher.add(useQuantizedAabbCompression);
+        hasher.add(mesh.getNumSubParts());
+        for (int part = 0; part < mesh.getNumSubParts(); ++part)
+        {
+            const unsigned char* vertices = nullptr;
+            const unsigned char* indices = nullptr;
+            int numVertices = 0;
+            int vertexStride = 0;
+            int numTriangles = 0;
+            int indexStride = 0;
+            PHY_ScalarType vertexType;
+            PHY_ScalarType indexType;
+            mesh.getLockedReadOnlyVertexIndexBase(&vertices, numVertices, vertexType, vertexStride,
+                &indices, indexStride, numTriangles, indexType, part);
+            hasher.add(numVertices);
+            hasher.add(vertexType);
+            hasher.add(vertexStride);
+            hasher.add(vertices, static_cast<std::size_t>(numVertices) * vertexStride);
+            hasher.add(numTriangles);
+            hasher.add(indexType);
+            hasher.add(indexStride);
+            hasher.add(indices, static_cast<std::size_t>(numTriangles) * indexStride);
+            mesh.unLockReadOnlyVertexBase(part);
+        }
+        return hasher.getKey();
+    }
+
+    void BvhDiskCache::buildBvh(TriangleMeshShape& shape) const
+    {
+        if (!isEnabled())
+        {
+            shape.buildOptimizedBvh();
+            return;
+        }
+
+        const std::string key = makeKey(*shape.getMeshInterface(), shape.usesQuantizedAabbCompression());
+        if (get(key, shape))
+            return;
+
+        shape.buildOptimizedBvh();
+        set(key, shape);
+    }
+
+    bool BvhDiskCache::get(const std::string& key, TriangleMeshShape& shape) const
+    {
+        const auto filePath = mPath / (key + ".bvh");
+
+        boost::filesystem::ifstream file(filePath, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+
+        const std::streamoff size = file.tellg();
+        if (size <= 0 || size > std::numeric_limits<unsigned int>::max())
+        {
+            Log(Debug::Warning) << "Invalid collision shape disk cache file " << filePath;
+            return false;
+        }
+
+        AlignedBuffer buffer(btAlignedAlloc(static_cast<std::size_t>(size), sAlignment));
+        file.seekg(0, std::ios::beg);
+        file.read(static_cast<char*>(buffer.get()), size);
+        if (!file)
+        {
+            Log(Debug::Warning) << "Failed to read collision shape disk cache file " << filePath;
+            return false;
+        }
+
+        if (!shape.setSerializedBvh(buffer.release(), static_cast<unsigned int>(size)))
+        {
+            Log(Debug::Warning) << "Invalid collision shape disk cache file " << filePath;
+            return false;
+        }
+
+        return true;
+    }
+
+    void BvhDiskCache::set(const std::string& key, TriangleMeshShape& shape) const
+    {
+        const btOptimizedBvh* bvh = shape.getOptimizedBvh();
+        if (bvh == nullptr)
+            return;
+
+        const std::string fileName = key + ".bvh";
+        const auto filePath = mPath / fileName;
+
+        // Write to a temporary file first so another thread or process never reads a partially written BVH
+        std::ostringstream tmpFileName;
+        tmpFileName << fileName << '.' << std::this_thread::get_id() << ".tmp";
+        const auto tmpFilePath = mPath / tmpFileName.str();
+
+        try
+        {
+            const unsigned int size = bvh->calculateSerializeBufferSize();
+            AlignedBuffer buffer(btAlignedAlloc(size, sAlignment));
+            if (!bvh->serializeInPlace(buffer.get(), size, false))
+                throw std::runtime_error("serialization error");
+
+            {
+                boost::filesystem::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+                file.write(static_cast<const char*>(buffer.get()), size);
+                if (!file)
+                    throw std::runtime_error("write error");
+            }
+            boost::filesystem::rename(tmpFilePath, filePath);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to write collision shape disk cache file " << filePath << ": " << e.what();
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpFilePath, ec);
+        }
+    }
+
+}
@@ -0,0 +1,47 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_BVHDISKCACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_BVHDISKCACHE_H
+
+#include <string>
+
+#include <osg/Referenced>
+
+#include <boost/filesystem/path.hpp>
+
+class btStridingMeshInterface;
+
+namespace Resource
+{
+    struct TriangleMeshShape;
+
+    /// @brief Stores the optimized BVHs of triangle mesh collision shapes to reuse them on next runs, so they don't have to
+    /// be built again for unchanged meshes.
+    /// @par Each file is named by a hash of the triangles of the mesh, the compression option, the Bullet version and the
+    /// pointer size, because the BVH is stored in the in-place format of btOptimizedBvh, which depends on all of them.
+    /// @note Thread safe.
+    class BvhDiskCache : public osg::Referenced
+    {
+    public:
+        /// Empty path disables cache.
+        explicit BvhDiskCache(const std::string& path);
+
+        bool isEnabled() const
+        {
+            return !mPath.empty();
+        }
+
+        static std::string makeKey(const btStridingMeshInterface& mesh, bool useQuantizedAabbCompression);
+
+        /// Set the BVH of a shape created without one, either read from the cache or built and then written to it.
+        void buildBvh(TriangleMeshShape& shape) const;
+
+    private:
+        boost::filesystem::path mPath;
+
+        bool get(const std::string& key, TriangleMeshShape& shape) const;
+
+        void set(const std::string& key, TriangleMeshShape& shape) const;
+    };
+
+}
+
+#endif
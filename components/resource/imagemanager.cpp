@@ -1,9 +1,13 @@
 #include "imagemanager.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+
 #include <osgDB/Registry>
 
 #include <components/debug/debuglog.hpp>
+#include <components/sceneutil/workqueue.hpp>
 #include <components/vfs/manager.hpp>
 
 #include "objectcache.hpp"
@@ -39,21 +43,190 @@ namespace
         return warningImage;
     }
 
+    osg::ref_ptr<osg::Image> createPlaceholderImage(const std::string& fileName)
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->allocateImage(1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        unsigned char* data = image->data();
+        data[0] = data[1] = data[2] = 128;
+        data[3] = 255;
+        image->setFileName(fileName);
+        // Keep the image referenced by its textures after the upload, its contents are replaced later
+        image->setDataVariance(osg::Object::DYNAMIC);
+        return image;
+    }
+
+    unsigned int getSize(const osg::Image& image)
+    {
+        return static_cast<unsigned int>(std::max(image.s(), image.t()));
+    }
+
+    /// Returns an image with the mip levels of \a source up to \a maxSize, or \a source itself if no level can be left out.
+    osg::ref_ptr<osg::Image> reduceImage(osg::Image& source, unsigned int maxSize)
+    {
+        const unsigned int numLevels = source.getNumMipmapLevels();
+        if (maxSize == 0 || numLevels <= 1 || source.r() != 1 || !source.isDataContiguous())
+            return &source;
+
+        unsigned int level = 0;
+        while (level + 1 < numLevels && (getSize(source) >> level) > maxSize)
+            ++level;
+        if (level == 0)
+            return &source;
+
+        const unsigned int offset = source.getMipmapOffset(level);
+        const std::size_t size = source.getTotalSizeInBytesIncludingMipmaps() - offset;
+        unsigned char* data = new unsigned char[size];
+        std::memcpy(data, source.data() + offset, size);
+
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        image->setFileName(source.getFileName());
+        image->setImage(std::max(source.s() >> level, 1), std::max(source.t() >> level, 1), 1, source.getInternalTextureFormat(),
+                        source.getPixelFormat(), source.getDataType(), data, osg::Image::USE_NEW_DELETE, source.getPacking());
+
+        osg::Image::MipmapDataType mipmaps;
+        for (unsigned int i = level + 1; i < numLevels; ++i)
+            mipmaps.push_back(source.getMipmapOffset(i) - offset);
+        image->setMipmapLevels(mipmaps);
+        image->setOrigin(source.getOrigin());
+        return image;
+    }
+
 }
 
 namespace Resource
 {
 
+    /// Worker thread item: decode an image requested asynchronously, or larger mip levels of a streamed image.
+    class ImageManager::DecodeImageItem : public SceneUtil::WorkItem
+    {
+    public:
+        DecodeImageItem(ImageManager& imageManager, const std::string& normalized, const std::string& filename, osg::Image* target, unsigned int maxSize)
+            : mImageManager(imageManager)
+            , mNormalized(normalized)
+            , mFilename(filename)
+            , mTarget(target)
+            , mMaxSize(maxSize)
+            , mFullSize(0)
+            , mAborted(false)
+        {
+        }
+
+        void doWork() override
+        {
+            if (!mAborted)
+                mImage = mImageManager.decodeImage(mNormalized, mFilename, mMaxSize, mFullSize);
+        }
+
+        void abort() override
+        {
+            mAborted = true;
+        }
+
+        /// Valid when the item is done and was not aborted.
+        osg::Image* getImage() const
+        {
+            return mImage.get();
+        }
+
+        unsigned int getFullSize() const
+        {
+            return mFullSize;
+        }
+
+        /// The image to replace the contents of.
+        osg::Image* getTarget() const
+        {
+            return mTarget.get();
+        }
+
+    private:
+        ImageManager& mImageManager;
+        std::string mNormalized;
+        std::string mFilename;
+        osg::ref_ptr<osg::Image> mTarget;
+        osg::ref_ptr<osg::Image> mImage;
+        unsigned int mMaxSize;
+        unsigned int mFullSize;
+        std::atomic<bool> mAborted;
+    };
+
     ImageManager::ImageManager(const VFS::Manager *vfs)
         : ResourceManager(vfs)
         , mWarningImage(createWarningImage())
         , mOptions(new osgDB::Options("dds_flip dds_dxt1_detect_rgba"))
+        , mAsyncDecoding(false)
+        , mAsyncDecodingSuspended(false)
+        , mNumPendingImages(0)
+        , mStreamingSize(0)
+        , mStreamingBudget(0)
+        , mStreamingFrame(0)
     {
     }
 
     ImageManager::~ImageManager()
     {
+        setWorkQueue(nullptr);
+    }
+
+    void ImageManager::setWorkQueue(SceneUtil::WorkQueue* workQueue)
+    {
+        std::map<std::string, osg::ref_ptr<DecodeImageItem> > pending;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingImagesMutex);
+            pending.swap(mPendingImages);
+            mNumPendingImages = 0;
+        }
+
+        std::vector<osg::ref_ptr<DecodeImageItem> > pendingStreamed;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStreamedImagesMutex);
+            for (auto& streamed : mStreamedImages)
+            {
+                if (streamed.second.mPending)
+                    pendingStreamed.push_back(streamed.second.mPending);
+                streamed.second.mPending = nullptr;
+            }
+        }
+
+        for (const auto& item : pending)
+            item.second->abort();
+        for (const auto& item : pendingStreamed)
+            item->abort();
+        if (mWorkQueue)
+        {
+            for (const auto& item : pending)
+                item.second->waitTillDone();
+            for (const auto& item : pendingStreamed)
+                item->waitTillDone();
+        }
+        // Placeholders of aborted items are never replaced, so decode these files again on the next request
+        for (const auto& item : pending)
+            mCache->removeFromObjectCache(item.first);
 
+        mWorkQueue = workQueue;
+    }
+
+    void ImageManager::setAsyncDecoding(bool enabled)
+    {
+        mAsyncDecoding = enabled;
+        mAsyncThread = std::this_thread::get_id();
+    }
+
+    void ImageManager::setAsyncDecodingSuspended(bool suspended)
+    {
+        mAsyncDecodingSuspended = suspended;
+    }
+
+    void ImageManager::setTextureStreaming(unsigned int initialSize, std::size_t budget)
+    {
+        mStreamingSize = initialSize;
+        mStreamingBudget = budget;
+    }
+
+    unsigned int ImageManager::getTextureStreamingSize() const
+    {
+        return mStreamingSize;
     }
 
     bool checkSupported(osg::Image* image, const std::string& filename)
@@ -81,77 +254,319 @@ namespace Resource
         return true;
     }
 
-    osg::ref_ptr<osg::Image> ImageManager::getImage(const std::string &filename)
+    osg::ref_ptr<osg::Image> ImageManager::getImage(const std::string &filename, bool async)
     {
         std::string normalized = filename;
         mVFS->normalizeFilename(normalized);
 
         osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(normalized);
         if (obj)
+        {
+            if (!async && mNumPendingImages > 0)
+            {
+                // the cached image may still be a placeholder, wait for the decoded contents
+                osg::ref_ptr<DecodeImageItem> item;
+                {
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingImagesMutex);
+                    auto found = mPendingImages.find(normalized);
+                    if (found != mPendingImages.end())
+                        item = found->second;
+                }
+                if (item)
+                {
+                    item->waitTillDone();
+                    if (item->getImage())
+                    {
+                        if (std::this_thread::get_id() != mAsyncThread)
+                            return item->getImage();
+
+                        // Fill the placeholder now, rather than returning a second image with the same contents,
+                        // this is the thread updateAsyncImages runs in
+                        bool isPending = false;
+                        {
+                            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingImagesMutex);
+                            isPending = mPendingImages.erase(normalized) > 0;
+                            mNumPendingImages = mPendingImages.size();
+                        }
+                        if (isPending)
+                            applyDecodedImage(*item);
+                    }
+                }
+            }
             return osg::ref_ptr<osg::Image>(static_cast<osg::Image*>(obj.get()));
-        else
+        }
+
+        const unsigned int maxSize = async && mWorkQueue ? mStreamingSize : 0;
+
+        if (async && mWorkQueue && mAsyncDecoding && !mAsyncDecodingSuspended && std::this_thread::get_id() == mAsyncThread)
         {
-            Files::IStreamPtr stream;
-            try
+            osg::ref_ptr<osg::Image> placeholder = createPlaceholderImage(normalized);
+            osg::ref_ptr<DecodeImageItem> item (new DecodeImageItem(*this, normalized, filename, placeholder, maxSize));
             {
-                stream = mVFS->get(normalized.c_str());
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingImagesMutex);
+                mPendingImages[normalized] = item;
+                mNumPendingImages = mPendingImages.size();
             }
-            catch (std::exception& e)
+            mCache->addEntryToObjectCache(normalized, placeholder);
+            mWorkQueue->addWorkItem(item, true);
+            return placeholder;
+        }
+
+        unsigned int fullSize = 0;
+        osg::ref_ptr<osg::Image> image = decodeImage(normalized, filename, maxSize, fullSize);
+        if (image != mWarningImage && fullSize > getSize(*image))
+            addStreamedImage(image, normalized, fullSize);
+        mCache->addEntryToObjectCache(normalized, image, 0.0, image != mWarningImage ? image->getTotalSizeInBytesIncludingMipmaps() : 0);
+        return image;
+    }
+
+    osg::ref_ptr<osg::Image> ImageManager::decodeImage(const std::string& normalized, const std::string& filename,
+                                                       unsigned int maxSize, unsigned int& fullSize)
+    {
+        Files::IStreamPtr stream;
+        try
+        {
+            stream = mVFS->get(normalized.c_str());
+        }
+        catch (std::exception& e)
+        {
+            Log(Debug::Error) << "Failed to open image: " << e.what();
+            return mWarningImage;
+        }
+
+        size_t extPos = normalized.find_last_of('.');
+        std::string ext;
+        if (extPos != std::string::npos && extPos+1 < normalized.size())
+            ext = normalized.substr(extPos+1);
+        osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
+        if (!reader)
+        {
+            Log(Debug::Error) << "Error loading " << filename << ": no readerwriter for '" << ext << "' found";
+            return mWarningImage;
+        }
+
+        osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, mOptions);
+        if (!result.success())
+        {
+            Log(Debug::Error) << "Error loading " << filename << ": " << result.message() << " code " << result.status();
+            return mWarningImage;
+        }
+
+        osg::ref_ptr<osg::Image> image = result.getImage();
+
+        image->setFileName(normalized);
+        if (!checkSupported(image, filename))
+        {
+            static bool uncompress = (getenv("OPENMW_DECOMPRESS_TEXTURES") != 0);
+            if (!uncompress)
             {
-                Log(Debug::Error) << "Failed to open image: " << e.what();
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
+                Log(Debug::Error) << "Error loading " << filename << ": no S3TC texture compression support installed";
                 return mWarningImage;
             }
+            else
+            {
+                // decompress texture in software if not supported by GPU
+                // requires update to getColor() to be released with OSG 3.6
+                osg::ref_ptr<osg::Image> newImage = new osg::Image;
+                newImage->setFileName(image->getFileName());
+                newImage->allocateImage(image->s(), image->t(), image->r(), image->isImageTranslucent() ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE);
+                for (int s=0; s<image->s(); ++s)
+                    for (int t=0; t<image->t(); ++t)
+                        for (int r=0; r<image->r(); ++r)
+                            newImage->setColor(image->getColor(s,t,r), s,t,r);
+                image = newImage;
+            }
+        }
+
+        fullSize = getSize(*image);
+        return reduceImage(*image, maxSize);
+    }
+
+    void ImageManager::replaceContents(osg::Image& target, osg::Image& source)
+    {
+        target.setImage(source.s(), source.t(), source.r(), source.getInternalTextureFormat(), source.getPixelFormat(),
+                        source.getDataType(), source.data(), osg::Image::NO_DELETE, source.getPacking(), source.getRowLength());
+        target.setMipmapLevels(source.getMipmapLevels());
+        target.setOrigin(source.getOrigin());
+        // The source keeps owning the data
+        target.setUserData(&source);
+        target.dirty();
+
+        if (mCache->getRefFromObjectCache(target.getFileName()).get() == &target)
+            mCache->addEntryToObjectCache(target.getFileName(), &target, 0.0,
+                                          &source != mWarningImage ? source.getTotalSizeInBytesIncludingMipmaps() : 0);
+    }
+
+    void ImageManager::addStreamedImage(osg::Image* image, const std::string& filename, unsigned int fullSize)
+    {
+        // Keep the image referenced by its textures after the upload, its contents are replaced later
+        image->setDataVariance(osg::Object::DYNAMIC);
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStreamedImagesMutex);
+        StreamedImage& streamed = mStreamedImages[image];
+        streamed.mImage = image;
+        streamed.mFilename = filename;
+        streamed.mFullSize = fullSize;
+        streamed.mLoadedSize = getSize(*image);
+        streamed.mRequestedSize = 0;
+        streamed.mLastRequestFrame = mStreamingFrame;
+        streamed.mPending = nullptr;
+    }
+
+    void ImageManager::requestImageSize(const std::vector<osg::ref_ptr<const osg::Image> >& images, unsigned int size)
+    {
+        if (mStreamingSize == 0 || size <= mStreamingSize)
+            return;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImageRequestsMutex);
+        for (const osg::ref_ptr<const osg::Image>& image : images)
+        {
+            unsigned int& requested = mImageRequests[image.get()];
+            requested = std::max(requested, size);
+        }
+    }
+
+    void ImageManager::updateStreaming(std::size_t maxBytes)
+    {
+        if (mStreamingSize == 0)
+            return;
+
+        // Images not requested for this many updates may be reduced again
+        const unsigned int keepFrames = 300;
+
+        std::map<const osg::Image*, unsigned int> requests;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mImageRequestsMutex);
+            requests.swap(mImageRequests);
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mStreamedImagesMutex);
+
+        ++mStreamingFrame;
+
+        for (const auto& request : requests)
+        {
+            auto found = mStreamedImages.find(request.first);
+            if (found == mStreamedImages.end())
+                continue;
+            found->second.mRequestedSize = request.second;
+            found->second.mLastRequestFrame = mStreamingFrame;
+        }
+
+        std::size_t changedBytes = 0;
+        std::size_t usedBytes = 0;
+        std::vector<std::pair<unsigned int, const osg::Image*> > unused;
+        for (auto it = mStreamedImages.begin(); it != mStreamedImages.end();)
+        {
+            StreamedImage& streamed = it->second;
+            osg::ref_ptr<osg::Image> image;
+            if (!streamed.mImage.lock(image) || image.get() != it->first)
+            {
+                if (streamed.mPending)
+                    streamed.mPending->abort();
+                mStreamedImages.erase(it++);
+                continue;
+            }
 
-            size_t extPos = normalized.find_last_of('.');
-            std::string ext;
-            if (extPos != std::string::npos && extPos+1 < normalized.size())
-                ext = normalized.substr(extPos+1);
-            osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
-            if (!reader)
+            if (streamed.mPending && streamed.mPending->isDone() && (changedBytes == 0 || changedBytes < maxBytes))
             {
-                Log(Debug::Error) << "Error loading " << filename << ": no readerwriter for '" << ext << "' found";
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
-                return mWarningImage;
+                osg::Image* loaded = streamed.mPending->getImage();
+                if (loaded && loaded != mWarningImage)
+                {
+                    changedBytes += loaded->getTotalSizeInBytesIncludingMipmaps();
+                    replaceContents(*image, *loaded);
+                    streamed.mLoadedSize = getSize(*image);
+                }
+                streamed.mPending = nullptr;
             }
 
-            osgDB::ReaderWriter::ReadResult result = reader->readImage(*stream, mOptions);
-            if (!result.success())
+            usedBytes += image->getTotalSizeInBytesIncludingMipmaps();
+            if (!streamed.mPending && streamed.mLoadedSize > mStreamingSize && streamed.mLastRequestFrame + keepFrames < mStreamingFrame)
+                unused.emplace_back(streamed.mLastRequestFrame, it->first);
+            ++it;
+        }
+
+        if (usedBytes > mStreamingBudget)
+        {
+            // reduce the images unused for the longest time first
+            std::sort(unused.begin(), unused.end());
+            for (const auto& entry : unused)
             {
-                Log(Debug::Error) << "Error loading " << filename << ": " << result.message() << " code " << result.status();
-                mCache->addEntryToObjectCache(normalized, mWarningImage);
-                return mWarningImage;
+                if (usedBytes <= mStreamingBudget)
+                    break;
+                StreamedImage& streamed = mStreamedImages[entry.second];
+                osg::ref_ptr<osg::Image> image;
+                streamed.mImage.lock(image);
+                osg::ref_ptr<osg::Image> reduced = reduceImage(*image, mStreamingSize);
+                if (reduced == image)
+                    continue;
+                usedBytes -= image->getTotalSizeInBytesIncludingMipmaps() - reduced->getTotalSizeInBytesIncludingMipmaps();
+                replaceContents(*image, *reduced);
+                streamed.mLoadedSize = getSize(*image);
             }
+        }
+
+        if (!mWorkQueue || usedBytes >= mStreamingBudget)
+            return;
+
+        for (auto& entry : mStreamedImages)
+        {
+            StreamedImage& streamed = entry.second;
+            if (streamed.mPending || streamed.mLastRequestFrame != mStreamingFrame
+                    || streamed.mRequestedSize <= streamed.mLoadedSize || streamed.mLoadedSize >= streamed.mFullSize)
+                continue;
+
+            unsigned int size = std::max(streamed.mLoadedSize, 1u);
+            while (size < streamed.mRequestedSize && size < streamed.mFullSize)
+                size *= 2;
 
-            osg::ref_ptr<osg::Image> image = result.getImage();
+            osg::ref_ptr<osg::Image> image;
+            streamed.mImage.lock(image);
+            streamed.mPending = new DecodeImageItem(*this, streamed.mFilename, streamed.mFilename, image, size);
+            // less urgent than loading what is missing entirely
+            streamed.mPending->setPriority(1.f);
+            mWorkQueue->addWorkItem(streamed.mPending);
+        }
+    }
+
+    void ImageManager::updateAsyncImages(std::size_t maxBytes)
+    {
+        if (mNumPendingImages == 0)
+            return;
 
-            image->setFileName(normalized);
-            if (!checkSupported(image, filename))
+        std::vector<osg::ref_ptr<DecodeImageItem> > decoded;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mPendingImagesMutex);
+            std::size_t bytes = 0;
+            for (auto it = mPendingImages.begin(); it != mPendingImages.end() && (decoded.empty() || bytes < maxBytes);)
             {
-                static bool uncompress = (getenv("OPENMW_DECOMPRESS_TEXTURES") != 0);
-                if (!uncompress)
+                if (it->second->isDone() && it->second->getImage())
                 {
-                    Log(Debug::Error) << "Error loading " << filename << ": no S3TC texture compression support installed";
-                    mCache->addEntryToObjectCache(normalized, mWarningImage);
-                    return mWarningImage;
+                    bytes += it->second->getImage()->getTotalSizeInBytesIncludingMipmaps();
+                    decoded.push_back(it->second);
+                    mPendingImages.erase(it++);
                 }
                 else
-                {
-                    // decompress texture in software if not supported by GPU
-                    // requires update to getColor() to be released with OSG 3.6
-                    osg::ref_ptr<osg::Image> newImage = new osg::Image;
-                    newImage->setFileName(image->getFileName());
-                    newImage->allocateImage(image->s(), image->t(), image->r(), image->isImageTranslucent() ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE);
-                    for (int s=0; s<image->s(); ++s)
-                        for (int t=0; t<image->t(); ++t)
-                            for (int r=0; r<image->r(); ++r)
-                                newImage->setColor(image->getColor(s,t,r), s,t,r);
-                    image = newImage;
-                }
+                    ++it;
             }
+            mNumPendingImages = mPendingImages.size();
+        }
 
-            mCache->addEntryToObjectCache(normalized, image);
-            return image;
+        for (const osg::ref_ptr<DecodeImageItem>& item : decoded)
+            applyDecodedImage(*item);
+    }
+
+    void ImageManager::applyDecodedImage(DecodeImageItem& item)
+    {
+        osg::Image* image = item.getImage();
+        osg::Image* placeholder = item.getTarget();
+        replaceContents(*placeholder, *image);
+        if (image != mWarningImage && item.getFullSize() > getSize(*image))
+            addStreamedImage(placeholder, placeholder->getFileName(), item.getFullSize());
+        else
+        {
+            // The contents are final, let textures release the image data after the upload like for other images
+            placeholder->setDataVariance(osg::Object::STATIC);
         }
     }
 
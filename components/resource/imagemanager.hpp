@@ -1,10 +1,16 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_IMAGEMANAGER_H
 #define OPENMW_COMPONENTS_RESOURCE_IMAGEMANAGER_H
 
+#include <atomic>
 #include <string>
 #include <map>
+#include <thread>
+#include <vector>
+
+#include <OpenThreads/Mutex>
 
 #include <osg/ref_ptr>
+#include <osg/observer_ptr>
 #include <osg/Image>
 #include <osg/Texture2D>
 
@@ -15,6 +21,11 @@ namespace osgDB
     class Options;
 }
 
+namespace SceneUtil
+{
+    class WorkQueue;
+}
+
 namespace Resource
 {
 
@@ -28,16 +39,100 @@ namespace Resource
 
         /// Create or retrieve an Image
         /// Returns the dummy image if the given image is not found.
-        osg::ref_ptr<osg::Image> getImage(const std::string& filename);
+        /// @param async The caller only uses the image for textures and doesn't read its contents, so it may be
+        ///  returned as a placeholder while the file is decoded in the background (see setAsyncDecoding), or with
+        ///  reduced mip levels (see setTextureStreaming).
+        osg::ref_ptr<osg::Image> getImage(const std::string& filename, bool async = false);
 
         osg::Image* getWarningImage();
 
+        /// Work queue for asynchronous decoding and texture streaming, nullptr disables both.
+        /// @note Pending work items are aborted.
+        void setWorkQueue(SceneUtil::WorkQueue* workQueue);
+
+        /// Decode asynchronous requests made from the calling thread in the work queue.
+        /// Such a request returns a 1x1 placeholder image, whose contents are replaced by updateAsyncImages once
+        /// the file is decoded. Requests from other threads are decoded immediately, they don't hold up drawing.
+        void setAsyncDecoding(bool enabled);
+
+        /// Decode all requests immediately while suspended, e.g. while a loading screen hides the scene.
+        void setAsyncDecodingSuspended(bool suspended);
+
+        /// Move the contents of decoded images into their placeholders, up to \a maxBytes per call so the texture
+        /// uploads are spread over several frames. At least one image is moved per call.
+        /// @note Call in the update traversal of the main thread, so no cull traversal reads an image while it is changed.
+        void updateAsyncImages(std::size_t maxBytes);
+
+        /// Load asynchronous requests for images larger than \a initialSize with the mip levels up to that size only,
+        /// and load larger levels in the work queue when requested by requestImageSize. 0 disables streaming.
+        /// @param budget Bytes that streamed images may use. When exceeded, images that were not requested recently
+        ///  are reduced to their initial size again.
+        void setTextureStreaming(unsigned int initialSize, std::size_t budget);
+        unsigned int getTextureStreamingSize() const;
+
+        /// Request the images to be loaded with at least the given width or height in texels.
+        /// @note Thread safe, meant to be called during the cull traversal.
+        void requestImageSize(const std::vector<osg::ref_ptr<const osg::Image> >& images, unsigned int size);
+
+        /// Load requested mip levels and reduce images that were not requested recently, up to \a maxBytes of
+        /// changed image data per call.
+        /// @note Call in the update traversal of the main thread, like updateAsyncImages.
+        void updateStreaming(std::size_t maxBytes);
+
+        const char* getName() const { return "Image"; }
+
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
 
     private:
+        class DecodeImageItem;
+
+        struct StreamedImage
+        {
+            osg::observer_ptr<osg::Image> mImage;
+            std::string mFilename;
+            // Larger dimension of the full image and of the loaded levels
+            unsigned int mFullSize;
+            unsigned int mLoadedSize;
+            unsigned int mRequestedSize;
+            unsigned int mLastRequestFrame;
+            osg::ref_ptr<DecodeImageItem> mPending;
+        };
+
+        /// @param maxSize Leave out mip levels larger than this, 0 keeps all levels.
+        /// @param fullSize Larger dimension of the image in the file.
+        osg::ref_ptr<osg::Image> decodeImage(const std::string& normalized, const std::string& filename,
+                                             unsigned int maxSize, unsigned int& fullSize);
+
+        /// Replace the contents of \a target with those of \a source, without copying the data.
+        void replaceContents(osg::Image& target, osg::Image& source);
+
+        void addStreamedImage(osg::Image* image, const std::string& filename, unsigned int fullSize);
+
+        /// Move the contents decoded by a finished item into its placeholder.
+        void applyDecodedImage(DecodeImageItem& item);
+
         osg::ref_ptr<osg::Image> mWarningImage;
         osg::ref_ptr<osgDB::Options> mOptions;
 
+        osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        bool mAsyncDecoding;
+        std::thread::id mAsyncThread;
+        std::atomic<bool> mAsyncDecodingSuspended;
+
+        // Images being decoded in the work queue, by normalized name
+        std::map<std::string, osg::ref_ptr<DecodeImageItem> > mPendingImages;
+        std::atomic<std::size_t> mNumPendingImages;
+        OpenThreads::Mutex mPendingImagesMutex;
+
+        unsigned int mStreamingSize;
+        std::size_t mStreamingBudget;
+        unsigned int mStreamingFrame;
+        std::map<const osg::Image*, StreamedImage> mStreamedImages;
+        OpenThreads::Mutex mStreamedImagesMutex;
+        // Largest size requested for each image since the last updateStreaming
+        std::map<const osg::Image*, unsigned int> mImageRequests;
+        OpenThreads::Mutex mImageRequestsMutex;
+
         ImageManager(const ImageManager&);
         void operator = (const ImageManager&);
     };
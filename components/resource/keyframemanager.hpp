@@ -23,6 +23,8 @@ namespace Resource
         /// @note Throws an exception if the resource is not found.
         osg::ref_ptr<const NifOsg::KeyframeHolder> get(const std::string& name);
 
+        const char* getName() const { return "Keyframe"; }
+
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
     };
 
@@ -23,6 +23,8 @@ namespace Resource
         /// to be done in advance by other managers accessing the NifFileManager.
         Nif::NIFFilePtr get(const std::string& name);
 
+        const char* getName() const { return "Nif"; }
+
         void reportStats(unsigned int frameNumber, osg::Stats *stats) const;
     };
 
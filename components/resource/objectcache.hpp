@@ -3,6 +3,9 @@
 // - removeExpiredObjectsInCache no longer keeps a lock while the unref happens.
 // - template allows customized KeyType.
 // - objects with uninitialized time stamp are not removed.
+// - entries are split into shards with their own mutex, so that threads looking up different keys rarely block each other.
+// - entries can have an estimated size in bytes, used to keep the caches within a memory budget.
+// - lookups that miss the cache are counted.
 
 /* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
  *
@@ -24,8 +27,11 @@
 #include <osg/ref_ptr>
 #include <osg/Node>
 
+#include <atomic>
+#include <functional>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace osg
 {
@@ -36,13 +42,29 @@ namespace osg
 
 namespace Resource {
 
+/// Selects the shard of the cache that holds a key, so that lookups of different keys rarely wait for each other.
+/// Key types without a specialization use a single shard.
+template <typename KeyType>
+struct ObjectCacheShard
+{
+    static const std::size_t sCount = 1;
+    static std::size_t get(const KeyType&) { return 0; }
+};
+
+template <>
+struct ObjectCacheShard<std::string>
+{
+    static const std::size_t sCount = 16;
+    static std::size_t get(const std::string& key) { return std::hash<std::string>()(key) % sCount; }
+};
+
 template <typename KeyType>
 class GenericObjectCache : public osg::Referenced
 {
     public:
 
         GenericObjectCache()
-            : osg::Referenced(true) {}
+            : osg::Referenced(true), _numMisses(0) {}
 
         /** For each object in the cache which has an reference count greater than 1
           * (and therefore referenced by elsewhere in the application) set the time stamp
@@ -53,13 +75,16 @@ class GenericObjectCache : public osg::Referenced
         void updateTimeStampOfObjectsInCacheWithExternalReferences(double referenceTime)
         {
             // look for objects with external references and update their time stamp.
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            for(typename ObjectCacheMap::iterator itr=_objectCache.begin(); itr!=_objectCache.end(); ++itr)
+            for (Shard& shard : _shards)
             {
-                // If ref count is greater than 1, the object has an external reference.
-                // If the timestamp is yet to be initialized, it needs to be updated too.
-                if (itr->second.first->referenceCount()>1 || itr->second.second == 0.0)
-                    itr->second.second = referenceTime;
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for(typename ObjectCacheMap::iterator itr=shard._objectCache.begin(); itr!=shard._objectCache.end(); ++itr)
+                {
+                    // If ref count is greater than 1, the object has an external reference.
+                    // If the timestamp is yet to be initialized, it needs to be updated too.
+                    if (itr->second._object->referenceCount()>1 || itr->second._timeStamp == 0.0)
+                        itr->second._timeStamp = referenceTime;
+                }
             }
         }
 
@@ -70,16 +95,17 @@ class GenericObjectCache : public osg::Referenced
         void removeExpiredObjectsInCache(double expiryTime)
         {
             std::vector<osg::ref_ptr<osg::Object> > objectsToRemove;
+            for (Shard& shard : _shards)
             {
-                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
                 // Remove expired entries from object cache
-                typename ObjectCacheMap::iterator oitr = _objectCache.begin();
-                while(oitr != _objectCache.end())
+                typename ObjectCacheMap::iterator oitr = shard._objectCache.begin();
+                while(oitr != shard._objectCache.end())
                 {
-                    if (oitr->second.second<=expiryTime)
+                    if (oitr->second._timeStamp<=expiryTime)
                     {
-                        objectsToRemove.push_back(oitr->second.first);
-                        _objectCache.erase(oitr++);
+                        objectsToRemove.push_back(oitr->second._object);
+                        shard._objectCache.erase(oitr++);
                     }
                     else
                         ++oitr;
@@ -92,43 +118,58 @@ class GenericObjectCache : public osg::Referenced
         /** Remove all objects in the cache regardless of having external references or expiry times.*/
         void clear()
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            _objectCache.clear();
+            for (Shard& shard : _shards)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                shard._objectCache.clear();
+            }
         }
 
-        /** Add a key,object,timestamp triple to the Registry::ObjectCache.*/
-        void addEntryToObjectCache(const KeyType& key, osg::Object* object, double timestamp = 0.0)
+        /** Add a key,object,timestamp triple to the Registry::ObjectCache.
+          * The size is an estimate of the memory used by the object in bytes, 0 if unknown.*/
+        void addEntryToObjectCache(const KeyType& key, osg::Object* object, double timestamp = 0.0, std::size_t size = 0)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            _objectCache[key]=ObjectTimeStampPair(object,timestamp);
+            Shard& shard = getShard(key);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+            shard._objectCache[key]=ObjectCacheEntry(object,timestamp,size);
         }
 
         /** Remove Object from cache.*/
         void removeFromObjectCache(const KeyType& key)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            typename ObjectCacheMap::iterator itr = _objectCache.find(key);
-            if (itr!=_objectCache.end()) _objectCache.erase(itr);
+            Shard& shard = getShard(key);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+            typename ObjectCacheMap::iterator itr = shard._objectCache.find(key);
+            if (itr!=shard._objectCache.end()) shard._objectCache.erase(itr);
         }
 
         /** Get an ref_ptr<Object> from the object cache*/
         osg::ref_ptr<osg::Object> getRefFromObjectCache(const KeyType& key)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            typename ObjectCacheMap::iterator itr = _objectCache.find(key);
-            if (itr!=_objectCache.end())
-                return itr->second.first;
-            else return 0;
+            Shard& shard = getShard(key);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+            typename ObjectCacheMap::iterator itr = shard._objectCache.find(key);
+            if (itr!=shard._objectCache.end())
+                return itr->second._object;
+            ++_numMisses;
+            return 0;
+        }
+
+        /** Get the number of getRefFromObjectCache calls that did not find the object since the cache was created. */
+        unsigned int getNumMisses() const
+        {
+            return _numMisses.load(std::memory_order_relaxed);
         }
 
         /** Check if an object is in the cache, and if it is, update its usage time stamp. */
         bool checkInObjectCache(const KeyType& key, double timeStamp)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            typename ObjectCacheMap::iterator itr = _objectCache.find(key);
-            if (itr!=_objectCache.end())
+            Shard& shard = getShard(key);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+            typename ObjectCacheMap::iterator itr = shard._objectCache.find(key);
+            if (itr!=shard._objectCache.end())
             {
-                itr->second.second = timeStamp;
+                itr->second._timeStamp = timeStamp;
                 return true;
             }
             else return false;
@@ -137,26 +178,32 @@ class GenericObjectCache : public osg::Referenced
         /** call releaseGLObjects on all objects attached to the object cache.*/
         void releaseGLObjects(osg::State* state)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            for(typename ObjectCacheMap::iterator itr = _objectCache.begin(); itr != _objectCache.end(); ++itr)
+            for (Shard& shard : _shards)
             {
-                osg::Object* object = itr->second.first.get();
-                object->releaseGLObjects(state);
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for(typename ObjectCacheMap::iterator itr = shard._objectCache.begin(); itr != shard._objectCache.end(); ++itr)
+                {
+                    osg::Object* object = itr->second._object.get();
+                    object->releaseGLObjects(state);
+                }
             }
         }
 
         /** call node->accept(nv); for all nodes in the objectCache. */
         void accept(osg::NodeVisitor& nv)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            for(typename ObjectCacheMap::iterator itr = _objectCache.begin(); itr != _objectCache.end(); ++itr)
+            for (Shard& shard : _shards)
             {
-                osg::Object* object = itr->second.first.get();
-                if (object)
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for(typename ObjectCacheMap::iterator itr = shard._objectCache.begin(); itr != shard._objectCache.end(); ++itr)
                 {
-                    osg::Node* node = dynamic_cast<osg::Node*>(object);
-                    if (node)
-                        node->accept(nv);
+                    osg::Object* object = itr->second._object.get();
+                    if (object)
+                    {
+                        osg::Node* node = dynamic_cast<osg::Node*>(object);
+                        if (node)
+                            node->accept(nv);
+                    }
                 }
             }
         }
@@ -165,27 +212,83 @@ class GenericObjectCache : public osg::Referenced
         template <class Functor>
         void call(Functor& f)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            for (typename ObjectCacheMap::iterator it = _objectCache.begin(); it != _objectCache.end(); ++it)
-                f(it->second.first.get());
+            for (Shard& shard : _shards)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for (typename ObjectCacheMap::iterator it = shard._objectCache.begin(); it != shard._objectCache.end(); ++it)
+                    f(it->second._object.get());
+            }
         }
 
         /** Get the number of objects in the cache. */
         unsigned int getCacheSize() const
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-            return _objectCache.size();
+            unsigned int size = 0;
+            for (const Shard& shard : _shards)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                size += shard._objectCache.size();
+            }
+            return size;
+        }
+
+        /** Get the estimated memory used by the objects in the cache, in bytes. */
+        std::size_t getCacheMemoryUsage() const
+        {
+            std::size_t usage = 0;
+            for (const Shard& shard : _shards)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for (typename ObjectCacheMap::const_iterator it = shard._objectCache.begin(); it != shard._objectCache.end(); ++it)
+                    usage += it->second._size;
+            }
+            return usage;
+        }
+
+        /** Append the time stamp and size of entries with a known size that are not referenced elsewhere in the application,
+          * i.e. whose memory would be released by removing them from the cache. */
+        void getUnreferencedEntries(std::vector<std::pair<double, std::size_t> >& entries) const
+        {
+            for (const Shard& shard : _shards)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+                for (typename ObjectCacheMap::const_iterator it = shard._objectCache.begin(); it != shard._objectCache.end(); ++it)
+                {
+                    if (it->second._size != 0 && it->second._object->referenceCount() == 1)
+                        entries.push_back(std::make_pair(it->second._timeStamp, it->second._size));
+                }
+            }
         }
 
     protected:
 
         virtual ~GenericObjectCache() {}
 
-        typedef std::pair<osg::ref_ptr<osg::Object>, double >           ObjectTimeStampPair;
-        typedef std::map<KeyType, ObjectTimeStampPair >             ObjectCacheMap;
+        struct ObjectCacheEntry
+        {
+            ObjectCacheEntry(osg::Object* object = nullptr, double timeStamp = 0.0, std::size_t size = 0)
+                : _object(object), _timeStamp(timeStamp), _size(size) {}
+
+            osg::ref_ptr<osg::Object>           _object;
+            double                              _timeStamp;
+            std::size_t                         _size;
+        };
+
+        typedef std::map<KeyType, ObjectCacheEntry >                ObjectCacheMap;
+
+        struct Shard
+        {
+            ObjectCacheMap                      _objectCache;
+            mutable OpenThreads::Mutex          _mutex;
+        };
+
+        Shard& getShard(const KeyType& key)
+        {
+            return _shards[ObjectCacheShard<KeyType>::get(key)];
+        }
 
-        ObjectCacheMap                          _objectCache;
-        mutable OpenThreads::Mutex              _objectCacheMutex;
+        Shard                                   _shards[ObjectCacheShard<KeyType>::sCount];
+        std::atomic<unsigned int>               _numMisses;
 
 };
 
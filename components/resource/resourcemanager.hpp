@@ -1,6 +1,9 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_MANAGER_H
 #define OPENMW_COMPONENTS_RESOURCE_MANAGER_H
 
+#include <utility>
+#include <vector>
+
 #include <osg/ref_ptr>
 
 #include "objectcache.hpp"
@@ -23,11 +26,22 @@ namespace Resource
     {
     public:
         virtual ~BaseResourceManager() {}
+        /// Name used in reports.
+        virtual const char* getName() const = 0;
         virtual void updateCache(double referenceTime) {}
         virtual void clearCache() {}
         virtual void setExpiryDelay(double expiryDelay) {}
         virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const {}
         virtual void releaseGLObjects(osg::State* state) {}
+
+        /// Estimated memory used by cached objects, in bytes.
+        virtual std::size_t getCacheMemoryUsage() const { return 0; }
+        /// Append the time stamp and size of cached objects that would be released when evicting them.
+        virtual void getUnreferencedCacheEntries(std::vector<std::pair<double, std::size_t> >& entries) const {}
+        /// Clear cache entries that were last referenced at or before the given time.
+        virtual void evictCache(double timeStamp) {}
+        /// Number of cache lookups that did not find the object since the manager was created.
+        virtual unsigned int getNumCacheMisses() const { return 0; }
     };
 
     /// @brief Base class for managers that require a virtual file system and object cache.
@@ -66,6 +80,17 @@ namespace Resource
 
         virtual void releaseGLObjects(osg::State* state) { mCache->releaseGLObjects(state); }
 
+        virtual std::size_t getCacheMemoryUsage() const { return mCache->getCacheMemoryUsage(); }
+
+        virtual void getUnreferencedCacheEntries(std::vector<std::pair<double, std::size_t> >& entries) const
+        {
+            mCache->getUnreferencedEntries(entries);
+        }
+
+        virtual void evictCache(double timeStamp) { mCache->removeExpiredObjectsInCache(timeStamp); }
+
+        virtual unsigned int getNumCacheMisses() const { return mCache->getNumMisses(); }
+
     protected:
         const VFS::Manager* mVFS;
         osg::ref_ptr<CacheType> mCache;
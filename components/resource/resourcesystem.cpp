@@ -1,6 +1,9 @@
 #include "resourcesystem.hpp"
 
 #include <algorithm>
+#include <string>
+
+#include <osg/Stats>
 
 #include "scenemanager.hpp"
 #include "imagemanager.hpp"
@@ -12,6 +15,7 @@ namespace Resource
 
     ResourceSystem::ResourceSystem(const VFS::Manager *vfs)
         : mVFS(vfs)
+        , mMemoryBudget(0)
     {
         mNifFileManager.reset(new NifFileManager(vfs));
         mKeyframeManager.reset(new KeyframeManager(vfs));
@@ -62,10 +66,50 @@ namespace Resource
         mNifFileManager->setExpiryDelay(0.0);
     }
 
+    void ResourceSystem::setMemoryBudget(std::size_t bytes)
+    {
+        mMemoryBudget = bytes;
+    }
+
     void ResourceSystem::updateCache(double referenceTime)
     {
         for (std::vector<BaseResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
             (*it)->updateCache(referenceTime);
+
+        if (mMemoryBudget == 0)
+            return;
+
+        std::size_t usage = 0;
+        for (std::vector<BaseResourceManager*>::const_iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            usage += (*it)->getCacheMemoryUsage();
+        if (usage <= mMemoryBudget)
+            return;
+
+        // Find the time stamp of the newest entry that has to be evicted so that the least recently used entries
+        // of all caches fit into the budget. Entries referenced in this frame are never evicted.
+        std::vector<std::pair<double, std::size_t> > entries;
+        for (std::vector<BaseResourceManager*>::const_iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            (*it)->getUnreferencedCacheEntries(entries);
+        std::sort(entries.begin(), entries.end());
+
+        bool evict = false;
+        double evictTime = 0.0;
+        for (const auto& entry : entries)
+        {
+            if (entry.first >= referenceTime)
+                break;
+            evict = true;
+            evictTime = entry.first;
+            usage -= std::min(usage, entry.second);
+            if (usage <= mMemoryBudget)
+                break;
+        }
+
+        if (!evict)
+            return;
+
+        for (std::vector<BaseResourceManager*>::iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+            (*it)->evictCache(evictTime);
     }
 
     void ResourceSystem::clearCache()
@@ -93,8 +137,28 @@ namespace Resource
 
     void ResourceSystem::reportStats(unsigned int frameNumber, osg::Stats *stats) const
     {
+        std::size_t usage = 0;
         for (std::vector<BaseResourceManager*>::const_iterator it = mResourceManagers.begin(); it != mResourceManagers.end(); ++it)
+        {
             (*it)->reportStats(frameNumber, stats);
+            const std::size_t managerUsage = (*it)->getCacheMemoryUsage();
+            if (managerUsage != 0)
+                stats->setAttribute(frameNumber, std::string((*it)->getName()) + " Memory", managerUsage);
+            usage += managerUsage;
+        }
+        stats->setAttribute(frameNumber, "Cache Memory", usage);
+    }
+
+    void ResourceSystem::getCacheMemoryUsage(std::vector<std::pair<const char*, std::size_t> >& usage) const
+    {
+        for (const BaseResourceManager* manager : mResourceManagers)
+            usage.emplace_back(manager->getName(), manager->getCacheMemoryUsage());
+    }
+
+    void ResourceSystem::getCacheMisses(std::vector<std::pair<const char*, unsigned int> >& misses) const
+    {
+        for (const BaseResourceManager* manager : mResourceManagers)
+            misses.emplace_back(manager->getName(), manager->getNumCacheMisses());
     }
 
     void ResourceSystem::releaseGLObjects(osg::State *state)
@@ -1,6 +1,7 @@
 #ifndef OPENMW_COMPONENTS_RESOURCE_RESOURCESYSTEM_H
 #define OPENMW_COMPONENTS_RESOURCE_RESOURCESYSTEM_H
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -56,11 +57,21 @@ namespace Resource
         /// How long to keep objects in cache after no longer being referenced.
         void setExpiryDelay(double expiryDelay);
 
+        /// Evict the least recently used objects in updateCache() once the estimated memory used by all caches exceeds
+        /// the budget, even if they have not expired yet. 0 to only evict by expiry delay.
+        void setMemoryBudget(std::size_t bytes);
+
         /// @note May be called from any thread.
         const VFS::Manager* getVFS() const;
 
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
 
+        /// Append the name and estimated memory used by the cache of each resource manager, in bytes.
+        void getCacheMemoryUsage(std::vector<std::pair<const char*, std::size_t> >& usage) const;
+
+        /// Append the name and number of cache misses of each resource manager.
+        void getCacheMisses(std::vector<std::pair<const char*, unsigned int> >& misses) const;
+
         /// Call releaseGLObjects for each resource manager.
         void releaseGLObjects(osg::State* state);
 
@@ -76,6 +87,8 @@ namespace Resource
 
         const VFS::Manager* mVFS;
 
+        std::size_t mMemoryBudget;
+
         ResourceSystem(const ResourceSystem&);
         void operator = (const ResourceSystem&);
     };
@@ -0,0 +1,232 @@
+#include "scenediskcache.hpp"
+
+#include <osg/Drawable>
+#include <osg/Image>
+#include <osg/Node>
+#include <osg/NodeVisitor>
+#include <osg/StateSet>
+#include <osg/Texture>
+#include <osg/UserDataContainer>
+#include <osg/Version>
+
+#include <osgDB/ObjectWrapper>
+#include <osgDB/Options>
+#include <osgDB/Registry>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/debug/debuglog.hpp>
+#include <components/misc/keyhasher.hpp>
+#include <components/nifosg/nifloader.hpp>
+#include <components/sceneutil/serialize.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    constexpr std::uint32_t sVersion = 1;
+
+    osgDB::ReaderWriter* getReaderWriter()
+    {
+        return osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    }
+
+    const osgDB::ObjectWrapper* getGeometryWrapper()
+    {
+        return osgDB::Registry::instance()->getObjectWrapperManager()->findWrapper("osg::Geometry");
+    }
+
+    bool isSerialized(const osg::Object& object)
+    {
+        return object.libraryName() == std::string("osg")
+            || (object.libraryName() == std::string("NifOsg") && object.className() == std::string("NodeUserData"));
+    }
+
+    /// Rejects everything the osgb format can't write and read back, i.e. callbacks and classes of other libraries.
+    class CanStoreVisitor : public osg::NodeVisitor
+    {
+    public:
+        CanStoreVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mCanStore(true)
+        {
+        }
+
+        void apply(osg::Node& node) override
+        {
+            if (!isSerialized(node) || node.getUpdateCallback() || node.getEventCallback() || node.getCullCallback()
+                    || node.getComputeBoundingSphereCallback())
+                mCanStore = false;
+
+            if (osg::Drawable* drawable = node.asDrawable())
+            {
+                if (drawable->getDrawCallback() || drawable->getComputeBoundingBoxCallback())
+                    mCanStore = false;
+            }
+
+            if (const osg::UserDataContainer* container = node.getUserDataContainer())
+            {
+                if (!isSerialized(*container) || container->getUserData())
+                    mCanStore = false;
+                for (unsigned int i = 0; i < container->getNumUserObjects(); ++i)
+                {
+                    if (!isSerialized(*container->getUserObject(i)))
+                        mCanStore = false;
+                }
+            }
+
+            if (const osg::StateSet* stateSet = node.getStateSet())
+                apply(*stateSet);
+
+            if (mCanStore)
+                traverse(node);
+        }
+
+        void apply(const osg::StateSet& stateSet)
+        {
+            if (stateSet.getUpdateCallback() || stateSet.getEventCallback())
+                mCanStore = false;
+
+            for (const auto& attribute : stateSet.getAttributeList())
+                apply(*attribute.second.first);
+            for (const auto& unit : stateSet.getTextureAttributeList())
+                for (const auto& attribute : unit)
+                    apply(*attribute.second.first);
+        }
+
+        void apply(const osg::StateAttribute& attribute)
+        {
+            if (!isSerialized(attribute) || attribute.getUpdateCallback() || attribute.getEventCallback())
+                mCanStore = false;
+
+            // Images are written as file names only and read again through the image manager
+            if (const osg::Texture* texture = attribute.asTexture())
+            {
+                for (unsigned int i = 0; i < texture->getNumImages(); ++i)
+                {
+                    const osg::Image* image = texture->getImage(i);
+                    if (image && image->getFileName().empty())
+                        mCanStore = false;
+                }
+            }
+        }
+
+        bool mCanStore;
+    };
+}
+
+namespace Resource
+{
+
+    SceneDiskCache::SceneDiskCache(const std::string& path)
+        : mGeometryWrapper(nullptr)
+    {
+        if (path.empty())
+            return;
+
+        if (!getReaderWriter())
+        {
+            Log(Debug::Warning) << "Scene disk cache is disabled: no osgb readerwriter found";
+            return;
+        }
+
+        try
+        {
+            boost::filesystem::create_directories(path);
+            mPath = path;
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Scene disk cache is disabled: failed to create directory \""
+                << path << "\": " << e.what();
+            return;
+        }
+
+        SceneUtil::registerSceneSerializers();
+        mGeometryWrapper = getGeometryWrapper();
+    }
+
+    bool SceneDiskCache::isEnabled() const
+    {
+        return !mPath.empty() && getGeometryWrapper() == mGeometryWrapper;
+    }
+
+    std::string SceneDiskCache::makeKey(const std::string& fileName, const std::string& fileContent)
+    {
+        Misc::KeyHasher hasher;
+        hasher.add(sVersion);
+        hasher.add(std::string(osgGetVersion()));
+        hasher.add(NifOsg::Loader::getShowMarkers());
+        hasher.add(fileName);
+        hasher.add(fileContent);
+        return hasher.getKey();
+    }
+
+    bool SceneDiskCache::canStore(osg::Node& node)
+    {
+        CanStoreVisitor visitor;
+        node.accept(visitor);
+        return visitor.mCanStore;
+    }
+
+    osg::ref_ptr<osg::Node> SceneDiskCache::get(const std::string& key, const osgDB::Options* options) const
+    {
+        if (!isEnabled())
+            return nullptr;
+
+        const auto filePath = mPath / (key + ".osgb");
+
+        boost::filesystem::ifstream file(filePath, std::ios::binary);
+        if (!file)
+            return nullptr;
+
+        osgDB::ReaderWriter::ReadResult result = getReaderWriter()->readNode(file, options);
+        if (!result.success())
+        {
+            Log(Debug::Warning) << "Failed to read scene disk cache file " << filePath << ": " << result.message();
+            return nullptr;
+        }
+
+        return result.getNode();
+    }
+
+    void SceneDiskCache::set(const std::string& key, const osg::Node& node) const
+    {
+        if (!isEnabled())
+            return;
+
+        const std::string fileName = key + ".osgb";
+        const auto filePath = mPath / fileName;
+
+        // Write to a temporary file first so another thread or process never reads a partially written scene
+        std::ostringstream tmpFileName;
+        tmpFileName << fileName << '.' << std::this_thread::get_id() << ".tmp";
+        const auto tmpFilePath = mPath / tmpFileName.str();
+
+        osg::ref_ptr<osgDB::Options> options (new osgDB::Options("WriteImageHint=UseExternal"));
+
+        try
+        {
+            {
+                boost::filesystem::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+                osgDB::ReaderWriter::WriteResult result = getReaderWriter()->writeNode(node, file, options);
+                if (!result.success())
+                    throw std::runtime_error(result.message());
+                if (!file)
+                    throw std::runtime_error("write error");
+            }
+            boost::filesystem::rename(tmpFilePath, filePath);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to write scene disk cache file " << filePath << ": " << e.what();
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpFilePath, ec);
+        }
+    }
+
+}
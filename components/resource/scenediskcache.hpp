@@ -0,0 +1,57 @@
+#ifndef OPENMW_COMPONENTS_RESOURCE_SCENEDISKCACHE_H
+#define OPENMW_COMPONENTS_RESOURCE_SCENEDISKCACHE_H
+
+#include <string>
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+
+#include <boost/filesystem/path.hpp>
+
+namespace osg
+{
+    class Node;
+}
+
+namespace osgDB
+{
+    class Options;
+    class ObjectWrapper;
+}
+
+namespace Resource
+{
+
+    /// @brief Stores scenes converted from NIF files in binary OSG files to reuse them on next runs, so unchanged
+    /// files don't have to be parsed and converted again.
+    /// @par Each file is named by a hash of the NIF file name and contents, the loader options and the OSG version.
+    /// Only graphs made of plain OSG classes without callbacks are stored, see canStore(). Textures are stored by
+    /// their file names and read back through the given options.
+    /// @note Thread safe.
+    class SceneDiskCache : public osg::Referenced
+    {
+    public:
+        /// Empty path disables cache.
+        explicit SceneDiskCache(const std::string& path);
+
+        bool isEnabled() const;
+
+        static std::string makeKey(const std::string& fileName, const std::string& fileContent);
+
+        /// Can the scene be written and read back without losing anything?
+        static bool canStore(osg::Node& node);
+
+        /// Returns nullptr when there is no valid file for the key.
+        osg::ref_ptr<osg::Node> get(const std::string& key, const osgDB::Options* options) const;
+
+        void set(const std::string& key, const osg::Node& node) const;
+
+    private:
+        boost::filesystem::path mPath;
+        // Replaced by SceneUtil::registerSerializers, which drops the geometry data
+        const osgDB::ObjectWrapper* mGeometryWrapper;
+    };
+
+}
+
+#endif
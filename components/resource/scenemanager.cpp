@@ -1,12 +1,18 @@
 #include "scenemanager.hpp"
 
 #include <cstdlib>
+#include <iterator>
+#include <set>
+#include <vector>
 
+#include <osg/Geometry>
 #include <osg/Node>
+#include <osg/Texture>
 #include <osg/UserDataContainer>
 
 #include <osgParticle/ParticleSystem>
 
+#include <osgUtil/CullVisitor>
 #include <osgUtil/IncrementalCompileOperation>
 
 #include <osgDB/SharedStateManager>
@@ -15,6 +21,7 @@
 #include <components/debug/debuglog.hpp>
 
 #include <components/nifosg/nifloader.hpp>
+#include <components/nifosg/particle.hpp>
 #include <components/nif/niffile.hpp>
 
 #include <components/misc/stringops.hpp>
@@ -25,6 +32,7 @@
 #include <components/sceneutil/util.hpp>
 #include <components/sceneutil/controller.hpp>
 #include <components/sceneutil/optimizer.hpp>
+#include <components/sceneutil/memoryusage.hpp>
 
 #include <components/shader/shadervisitor.hpp>
 #include <components/shader/shadermanager.hpp>
@@ -33,9 +41,12 @@
 #include "niffilemanager.hpp"
 #include "objectcache.hpp"
 #include "multiobjectcache.hpp"
+#include "scenediskcache.hpp"
 
 namespace
 {
+    // Instances kept per key by SceneManager::recycleInstance
+    const std::size_t sMaxRecycledInstances = 8;
 
     class InitWorldSpaceParticlesCallback : public osg::NodeCallback
     {
@@ -73,6 +84,14 @@ namespace
 
     };
 
+    bool isWorldSpaceParticleSystem(osgParticle::ParticleSystem* partsys)
+    {
+        // HACK: ParticleSystem has no getReferenceFrame()
+        return (partsys->getUserDataContainer()
+                && partsys->getUserDataContainer()->getNumDescriptions() > 0
+                && partsys->getUserDataContainer()->getDescriptions()[0] == "worldspace");
+    }
+
     class InitParticlesVisitor : public osg::NodeVisitor
     {
     public:
@@ -83,14 +102,6 @@ namespace
         {
         }
 
-        bool isWorldSpaceParticleSystem(osgParticle::ParticleSystem* partsys)
-        {
-            // HACK: ParticleSystem has no getReferenceFrame()
-            return (partsys->getUserDataContainer()
-                    && partsys->getUserDataContainer()->getNumDescriptions() > 0
-                    && partsys->getUserDataContainer()->getDescriptions()[0] == "worldspace");
-        }
-
         void apply(osg::Drawable& drw)
         {
             if (osgParticle::ParticleSystem* partsys = dynamic_cast<osgParticle::ParticleSystem*>(&drw))
@@ -106,11 +117,133 @@ namespace
     private:
         unsigned int mMask;
     };
+
+    /// Resets the particle systems, emitters and programs of a recycled instance to the state of a new one.
+    class ResetParticlesVisitor : public osg::NodeVisitor
+    {
+    public:
+        ResetParticlesVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
+
+        void apply(osg::Node& node)
+        {
+            // Otherwise the first update of the instance would run with the time elapsed since it was removed
+            if (NifOsg::Emitter* emitter = dynamic_cast<NifOsg::Emitter*>(&node))
+                emitter->reset();
+            else if (NifOsg::ParticleProgram* program = dynamic_cast<NifOsg::ParticleProgram*>(&node))
+                program->reset();
+            else if (NifOsg::ParticleSystemUpdater* updater = dynamic_cast<NifOsg::ParticleSystemUpdater*>(&node))
+                updater->reset();
+
+            traverse(node);
+        }
+
+        void apply(osg::Drawable& drw)
+        {
+            NifOsg::ParticleSystem* partsys = dynamic_cast<NifOsg::ParticleSystem*>(&drw);
+            if (!partsys)
+                return;
+
+            partsys->resetParticles();
+
+            // The initial particles need to be transformed again once the instance is attached
+            if (isWorldSpaceParticleSystem(partsys))
+            {
+                for (osg::Callback* callback = partsys->getUpdateCallback(); callback; callback = callback->getNestedCallback())
+                {
+                    if (dynamic_cast<InitWorldSpaceParticlesCallback*>(callback))
+                        return;
+                }
+                partsys->addUpdateCallback(new InitWorldSpaceParticlesCallback);
+            }
+        }
+    };
+
+    /// Collects the images of all textures in a scene graph.
+    class CollectImagesVisitor : public osg::NodeVisitor
+    {
+    public:
+        CollectImagesVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
+
+        void apply(osg::Node& node)
+        {
+            if (const osg::StateSet* stateSet = node.getStateSet())
+            {
+                for (const auto& unit : stateSet->getTextureAttributeList())
+                {
+                    for (const auto& attribute : unit)
+                    {
+                        const osg::Texture* texture = attribute.second.first->asTexture();
+                        if (!texture)
+                            continue;
+                        for (unsigned int i = 0; i < texture->getNumImages(); ++i)
+                        {
+                            const osg::Image* image = texture->getImage(i);
+                            if (image && !image->getFileName().empty())
+                                mImages.insert(image);
+                        }
+                    }
+                }
+            }
+            traverse(node);
+        }
+
+        std::set<osg::ref_ptr<const osg::Image> > mImages;
+    };
+
+    /// Requests the texture size needed for the projected size of the node, see ImageManager::setTextureStreaming.
+    /// @note Assumes the textures are mapped once over the whole node, so tiled textures may be requested too small.
+    class TextureStreamingCallback : public osg::NodeCallback
+    {
+    public:
+        TextureStreamingCallback()
+            : mImageManager(nullptr)
+        {
+        }
+
+        TextureStreamingCallback(Resource::ImageManager* imageManager, const std::set<osg::ref_ptr<const osg::Image> >& images)
+            : mImageManager(imageManager)
+            , mImages(images.begin(), images.end())
+        {
+        }
+
+        TextureStreamingCallback(const TextureStreamingCallback& copy, const osg::CopyOp& copyop)
+            : osg::NodeCallback(copy, copyop)
+            , mImageManager(copy.mImageManager)
+            , mImages(copy.mImages)
+        {
+        }
+
+        META_Object(Resource, TextureStreamingCallback)
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+            // clampedPixelSize gives the radius in pixels
+            const float size = 2.f * cv->clampedPixelSize(node->getBound());
+            if (size >= 1.f)
+                mImageManager->requestImageSize(mImages, static_cast<unsigned int>(size));
+            traverse(node, nv);
+        }
+
+    private:
+        Resource::ImageManager* mImageManager;
+        std::vector<osg::ref_ptr<const osg::Image> > mImages;
+    };
 }
 
 namespace Resource
 {
 
+    /// @brief Shares textures and state sets of equal contents between all templates, and also the other state
+    /// attributes and uniforms, which osgDB::SharedStateManager leaves alone.
+    /// @par OSG skips applying an attribute or uniform only if it is the same object as the last applied one,
+    /// so attributes of equal contents in separate objects cause redundant GL calls.
     class SharedStateManager : public osgDB::SharedStateManager
     {
     public:
@@ -124,14 +257,134 @@ namespace Resource
             return _sharedStateSetList.size();
         }
 
+        /// Replace the attributes and uniforms of the subgraph with shared ones of equal contents.
+        /// @note The subgraph must not be shared with state sets of other templates yet, call before share().
+        void shareAttributes(osg::Node* node);
+
+        void prune()
+        {
+            osgDB::SharedStateManager::prune();
+
+            // Only referenced by this manager
+            for (auto it = mSharedAttributes.begin(); it != mSharedAttributes.end();)
+                it = (*it)->referenceCount() <= 1 ? mSharedAttributes.erase(it) : std::next(it);
+            for (auto it = mSharedUniforms.begin(); it != mSharedUniforms.end();)
+                it = (*it)->referenceCount() <= 1 ? mSharedUniforms.erase(it) : std::next(it);
+        }
+
         void clearCache()
         {
             OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_listMutex);
             _sharedTextureList.clear();
             _sharedStateSetList.clear();
+            mSharedAttributes.clear();
+            mSharedUniforms.clear();
+        }
+
+    private:
+        friend class ShareAttributesVisitor;
+
+        template <class T>
+        struct LessContents
+        {
+            bool operator()(const osg::ref_ptr<T>& left, const osg::ref_ptr<T>& right) const
+            {
+                return left->compare(*right) < 0;
+            }
+        };
+
+        template <class T>
+        static bool canShare(const T& object)
+        {
+            return object.getDataVariance() != osg::Object::DYNAMIC && !object.getUpdateCallback() && !object.getEventCallback();
+        }
+
+        osg::StateAttribute* getShared(osg::StateAttribute* attribute)
+        {
+            return canShare(*attribute) ? mSharedAttributes.insert(attribute).first->get() : attribute;
         }
+
+        osg::Uniform* getShared(osg::Uniform* uniform)
+        {
+            // Arrays like bone matrices are updated per instance
+            if (!canShare(*uniform) || uniform->getNumElements() > 1)
+                return uniform;
+            return mSharedUniforms.insert(uniform).first->get();
+        }
+
+        std::set<osg::ref_ptr<osg::StateAttribute>, LessContents<osg::StateAttribute> > mSharedAttributes;
+        std::set<osg::ref_ptr<osg::Uniform>, LessContents<osg::Uniform> > mSharedUniforms;
+    };
+
+    class ShareAttributesVisitor : public osg::NodeVisitor
+    {
+    public:
+        ShareAttributesVisitor(SharedStateManager& manager)
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mManager(manager)
+        {
+        }
+
+        void apply(osg::Node& node) override
+        {
+            osg::StateSet* stateSet = node.getStateSet();
+            if (stateSet && SharedStateManager::canShare(*stateSet) && mVisited.insert(stateSet).second)
+                apply(*stateSet);
+            traverse(node);
+        }
+
+        void apply(osg::StateSet& stateSet)
+        {
+            // Collect first, replacing invalidates the iterators of the lists
+            std::vector<std::pair<osg::StateAttribute*, osg::StateAttribute::OverrideValue> > attributes;
+            for (const auto& attribute : stateSet.getAttributeList())
+                attributes.emplace_back(attribute.second.first.get(), attribute.second.second);
+            for (const auto& attribute : attributes)
+            {
+                osg::StateAttribute* shared = mManager.getShared(attribute.first);
+                if (shared != attribute.first)
+                    stateSet.setAttribute(shared, attribute.second);
+            }
+
+            // Textures are shared by osgDB::SharedStateManager
+            for (unsigned int unit = 0; unit < stateSet.getTextureAttributeList().size(); ++unit)
+            {
+                attributes.clear();
+                for (const auto& attribute : stateSet.getTextureAttributeList()[unit])
+                {
+                    if (!attribute.second.first->asTexture())
+                        attributes.emplace_back(attribute.second.first.get(), attribute.second.second);
+                }
+                for (const auto& attribute : attributes)
+                {
+                    osg::StateAttribute* shared = mManager.getShared(attribute.first);
+                    if (shared != attribute.first)
+                        stateSet.setTextureAttribute(unit, shared, attribute.second);
+                }
+            }
+
+            std::vector<std::pair<osg::Uniform*, osg::StateAttribute::OverrideValue> > uniforms;
+            for (const auto& uniform : stateSet.getUniformList())
+                uniforms.emplace_back(uniform.second.first.get(), uniform.second.second);
+            for (const auto& uniform : uniforms)
+            {
+                osg::Uniform* shared = mManager.getShared(uniform.first);
+                if (shared != uniform.first)
+                    stateSet.addUniform(shared, uniform.second);
+            }
+        }
+
+    private:
+        SharedStateManager& mManager;
+        std::set<const osg::StateSet*> mVisited;
     };
 
+    void SharedStateManager::shareAttributes(osg::Node* node)
+    {
+        ShareAttributesVisitor visitor(*this);
+        node->accept(visitor);
+    }
+
     /// Set texture filtering settings on textures contained in a FlipController.
     class SetFilterSettingsControllerVisitor : public SceneUtil::ControllerVisitor
     {
@@ -220,7 +473,11 @@ namespace Resource
         , mClampLighting(true)
         , mAutoUseNormalMaps(false)
         , mAutoUseSpecularMaps(false)
+        , mGpuSkinning(false)
+        , mGpuMorphing(false)
+        , mReducedShaderPermutations(false)
         , mInstanceCache(new MultiObjectCache)
+        , mRecycleTime(0.0)
         , mSharedStateManager(new SharedStateManager)
         , mImageManager(imageManager)
         , mNifFileManager(nifFileManager)
@@ -232,6 +489,11 @@ namespace Resource
     {
     }
 
+    void SceneManager::setDiskCachePath(const std::string& path)
+    {
+        mDiskCache = new SceneDiskCache(path);
+    }
+
     void SceneManager::setForceShaders(bool force)
     {
         mForceShaders = force;
@@ -284,6 +546,31 @@ namespace Resource
         mSpecularMapPattern = pattern;
     }
 
+    void SceneManager::setGpuSkinning(bool enabled)
+    {
+        mGpuSkinning = enabled;
+    }
+
+    bool SceneManager::getGpuSkinning() const
+    {
+        return mGpuSkinning;
+    }
+
+    void SceneManager::setGpuMorphing(bool enabled)
+    {
+        mGpuMorphing = enabled;
+    }
+
+    bool SceneManager::getGpuMorphing() const
+    {
+        return mGpuMorphing;
+    }
+
+    void SceneManager::setReducedShaderPermutations(bool enabled)
+    {
+        mReducedShaderPermutations = enabled;
+    }
+
     SceneManager::~SceneManager()
     {
         // this has to be defined in the .cpp file as we can't delete incomplete types
@@ -340,11 +627,48 @@ namespace Resource
         return std::string();
     }
 
-    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::ImageManager* imageManager, Resource::NifFileManager* nifFileManager)
+    std::string readFileContent(std::istream& file)
+    {
+        file.seekg(0, std::ios::end);
+        const std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        std::string content;
+        if (size > 0)
+        {
+            content.resize(static_cast<std::size_t>(size));
+            file.read(&content[0], size);
+        }
+        if (!file)
+            throw std::runtime_error("Failed to read file");
+        return content;
+    }
+
+    osg::ref_ptr<osg::Node> loadNif (std::istream& file, const std::string& normalizedFilename, Resource::ImageManager* imageManager,
+                                     Resource::NifFileManager* nifFileManager, Resource::SceneDiskCache* diskCache)
+    {
+        if (!diskCache || !diskCache->isEnabled())
+            return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+
+        const std::string key = SceneDiskCache::makeKey(normalizedFilename, readFileContent(file));
+
+        osg::ref_ptr<osgDB::Options> options (new osgDB::Options);
+        options->setReadFileCallback(new ImageReadCallback(imageManager));
+        osg::ref_ptr<osg::Node> cached = diskCache->get(key, options);
+        if (cached)
+            return cached;
+
+        osg::ref_ptr<osg::Node> loaded = NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+        if (SceneDiskCache::canStore(*loaded))
+            diskCache->set(key, *loaded);
+        return loaded;
+    }
+
+    osg::ref_ptr<osg::Node> load (Files::IStreamPtr file, const std::string& normalizedFilename, Resource::ImageManager* imageManager,
+                                  Resource::NifFileManager* nifFileManager, Resource::SceneDiskCache* diskCache = nullptr)
     {
         std::string ext = getFileExtension(normalizedFilename);
         if (ext == "nif")
-            return NifOsg::Loader::load(nifFileManager->get(normalizedFilename), imageManager);
+            return loadNif(*file, normalizedFilename, imageManager, nifFileManager, diskCache);
         else
         {
             osgDB::ReaderWriter* reader = osgDB::Registry::instance()->getReaderWriterForExtension(ext);
@@ -481,7 +805,7 @@ namespace Resource
             {
                 Files::IStreamPtr file = mVFS->get(normalized);
 
-                loaded = load(file, normalized, mImageManager, mNifFileManager);
+                loaded = load(file, normalized, mImageManager, mNifFileManager, mDiskCache);
             }
             catch (std::exception& e)
             {
@@ -516,6 +840,7 @@ namespace Resource
             // do this before optimizing so the optimizer will be able to combine nodes more aggressively
             // note, because StateSets will be shared at this point, StateSets can not be modified inside the optimizer
             mSharedStateMutex.lock();
+            mSharedStateManager->shareAttributes(loaded.get());
             mSharedStateManager->share(loaded.get());
             mSharedStateMutex.unlock();
 
@@ -529,12 +854,20 @@ namespace Resource
                 optimizer.optimize(loaded, options);
             }
 
+            if (mImageManager->getTextureStreamingSize() > 0)
+            {
+                CollectImagesVisitor collectImagesVisitor;
+                loaded->accept(collectImagesVisitor);
+                if (!collectImagesVisitor.mImages.empty())
+                    loaded->addCullCallback(new TextureStreamingCallback(mImageManager, collectImagesVisitor.mImages));
+            }
+
             if (mIncrementalCompileOperation)
                 mIncrementalCompileOperation->add(loaded);
             else
                 loaded->getBound();
 
-            mCache->addEntryToObjectCache(normalized, loaded);
+            mCache->addEntryToObjectCache(normalized, loaded, 0.0, SceneUtil::estimateGeometryMemory(*loaded));
             return loaded;
         }
     }
@@ -612,6 +945,28 @@ namespace Resource
         return cloned;
     }
 
+    void SceneManager::recycleInstance(const std::string &key, osg::ref_ptr<osg::Node> instance)
+    {
+        ResetParticlesVisitor visitor;
+        instance->accept(visitor);
+
+        std::lock_guard<std::mutex> lock(mRecycledInstancesMutex);
+        if (mRecycledInstances.count(key) >= sMaxRecycledInstances)
+            return;
+        mRecycledInstances.insert(std::make_pair(key, RecycledInstance {instance, mRecycleTime}));
+    }
+
+    osg::ref_ptr<osg::Node> SceneManager::takeRecycledInstance(const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(mRecycledInstancesMutex);
+        std::multimap<std::string, RecycledInstance>::iterator found = mRecycledInstances.find(key);
+        if (found == mRecycledInstances.end())
+            return nullptr;
+        osg::ref_ptr<osg::Node> instance = found->second.mNode;
+        mRecycledInstances.erase(found);
+        return instance;
+    }
+
     void SceneManager::attachTo(osg::Node *instance, osg::Group *parentNode) const
     {
         parentNode->addChild(instance);
@@ -710,6 +1065,18 @@ namespace Resource
 
         mInstanceCache->removeUnreferencedObjectsInCache();
 
+        {
+            std::lock_guard<std::mutex> lock(mRecycledInstancesMutex);
+            mRecycleTime = referenceTime;
+            for (std::multimap<std::string, RecycledInstance>::iterator it = mRecycledInstances.begin(); it != mRecycledInstances.end();)
+            {
+                if (it->second.mTime < referenceTime - mExpiryDelay)
+                    it = mRecycledInstances.erase(it);
+                else
+                    ++it;
+            }
+        }
+
         mSharedStateMutex.lock();
         mSharedStateManager->prune();
         mSharedStateMutex.unlock();
@@ -722,6 +1089,9 @@ namespace Resource
         OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mSharedStateMutex);
         mSharedStateManager->clearCache();
         mInstanceCache->clear();
+
+        std::lock_guard<std::mutex> recycledLock(mRecycledInstancesMutex);
+        mRecycledInstances.clear();
     }
 
     void SceneManager::reportStats(unsigned int frameNumber, osg::Stats *stats) const
@@ -740,6 +1110,9 @@ namespace Resource
 
         stats->setAttribute(frameNumber, "Node", mCache->getCacheSize());
         stats->setAttribute(frameNumber, "Node Instance", mInstanceCache->getCacheSize());
+
+        std::lock_guard<std::mutex> lock(mRecycledInstancesMutex);
+        stats->setAttribute(frameNumber, "Recycled Node Instance", mRecycledInstances.size());
     }
 
     Shader::ShaderVisitor *SceneManager::createShaderVisitor()
@@ -751,6 +1124,9 @@ namespace Resource
         shaderVisitor->setNormalHeightMapPattern(mNormalHeightMapPattern);
         shaderVisitor->setAutoUseSpecularMaps(mAutoUseSpecularMaps);
         shaderVisitor->setSpecularMapPattern(mSpecularMapPattern);
+        shaderVisitor->setGpuSkinning(mGpuSkinning);
+        shaderVisitor->setGpuMorphing(mGpuMorphing);
+        shaderVisitor->setReducedPermutations(mReducedShaderPermutations);
         return shaderVisitor;
     }
 
@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include <osg/ref_ptr>
 #include <osg/Node>
@@ -38,6 +39,7 @@ namespace Resource
 {
 
     class MultiObjectCache;
+    class SceneDiskCache;
 
     /// @brief Handles loading and caching of scenes, e.g. .nif files or .osg files
     /// @note Some methods of the scene manager can be used from any thread, see the methods documentation for more details.
@@ -72,8 +74,23 @@ namespace Resource
 
         void setSpecularMapPattern(const std::string& pattern);
 
+        /// @see ShaderVisitor::setGpuSkinning
+        void setGpuSkinning(bool enabled);
+        bool getGpuSkinning() const;
+
+        /// @see ShaderVisitor::setGpuMorphing
+        void setGpuMorphing(bool enabled);
+        bool getGpuMorphing() const;
+
+        /// @see ShaderVisitor::setReducedPermutations
+        void setReducedShaderPermutations(bool enabled);
+
         void setShaderPath(const std::string& path);
 
+        /// Store converted NIF files in the given directory and reuse them on next runs, see SceneDiskCache.
+        /// @note Empty path disables the cache. Not thread safe, call before loading any scenes.
+        void setDiskCachePath(const std::string& path);
+
         /// Check if a given scene is loaded and if so, update its usage timestamp to prevent it from being unloaded
         bool checkLoaded(const std::string& name, double referenceTime);
 
@@ -98,6 +115,17 @@ namespace Resource
         /// @note Thread safe.
         osg::ref_ptr<osg::Node> getInstance(const std::string& name);
 
+        /// Keep an instance that is no longer attached to any parent, to be returned by takeRecycledInstance() for the same key
+        /// instead of creating a new one. Its particle systems are reset to their initial particles, anything else the caller
+        /// changed is kept, so instances should only share a key if they were set up the same way.
+        /// @note Instances are dropped when they were not taken for longer than the expiry delay.
+        /// @note Thread safe.
+        void recycleInstance(const std::string& key, osg::ref_ptr<osg::Node> instance);
+
+        /// @return An instance given to recycleInstance() with the same key, nullptr if there is none.
+        /// @note Thread safe.
+        osg::ref_ptr<osg::Node> takeRecycledInstance(const std::string& key);
+
         /// Get an instance of the given scene template and immediately attach it to a parent node
         /// @see getTemplate
         /// @note Not thread safe, unless parentNode is not part of the main scene graph yet.
@@ -141,6 +169,8 @@ namespace Resource
 
         void clearCache() override;
 
+        const char* getName() const override { return "Scene"; }
+
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const override;
 
     private:
@@ -155,9 +185,24 @@ namespace Resource
         std::string mNormalHeightMapPattern;
         bool mAutoUseSpecularMaps;
         std::string mSpecularMapPattern;
+        bool mGpuSkinning;
+        bool mGpuMorphing;
+        bool mReducedShaderPermutations;
 
         osg::ref_ptr<MultiObjectCache> mInstanceCache;
 
+        struct RecycledInstance
+        {
+            osg::ref_ptr<osg::Node> mNode;
+            double mTime;
+        };
+
+        std::multimap<std::string, RecycledInstance> mRecycledInstances;
+        double mRecycleTime;
+        mutable std::mutex mRecycledInstancesMutex;
+
+        osg::ref_ptr<SceneDiskCache> mDiskCache;
+
         osg::ref_ptr<Resource::SharedStateManager> mSharedStateManager;
         mutable OpenThreads::Mutex mSharedStateMutex;
 
@@ -284,18 +284,52 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase *viewer)
             "Image",
             "Nif",
             "Keyframe",
+            "Cache Memory",
             "",
             "Terrain Chunk",
             "Terrain Texture",
             "Land",
             "Composite",
+            "Object Chunk",
+            "",
+            "Scene Memory",
+            "Image Memory",
+            "Bullet Shape Memory",
+            "Terrain Chunk Memory",
+            "Object Chunk Memory",
+            "Land Memory",
+            "Merged Objects Memory",
+            "",
+            "Cells Loaded",
+            "Cell References",
             "",
             "UnrefQueue",
             "",
+            "Preload Cells",
+            "Preload Hits",
+            "Preload Late",
+            "Preload Misses",
+            "",
             "NavMesh UpdateJobs",
+            "NavMesh Jobs <10ms",
+            "NavMesh Jobs <100ms",
+            "NavMesh Jobs <1s",
+            "NavMesh Jobs >=1s",
             "NavMesh CacheSize",
             "NavMesh UsedTiles",
             "NavMesh CachedTiles",
+            "",
+            "Physics Actors",
+            "Physics Objects",
+            "Physics Heightmaps",
+            "Physics Pairs",
+            "Physics Sweeps",
+            "Physics Rays",
+            "Physics Solved",
+            "Physics Iterations",
+            "Physics Avg Iter %",
+            "Physics Step us",
+            "Physics Move us",
         });
 
         static const auto longest = std::max_element(statNames.begin(), statNames.end(),
@@ -36,7 +36,7 @@ namespace SceneUtil
             return operator()(processor);
         if (const osgParticle::ParticleSystemUpdater* updater = dynamic_cast<const osgParticle::ParticleSystemUpdater*>(node))
         {
-            osgParticle::ParticleSystemUpdater* cloned = new osgParticle::ParticleSystemUpdater(*updater, osg::CopyOp::SHALLOW_COPY);
+            osgParticle::ParticleSystemUpdater* cloned = osg::clone(updater, osg::CopyOp::SHALLOW_COPY);
             mMap2[cloned] = updater->getParticleSystem(0);
             return cloned;
         }
@@ -1,5 +1,13 @@
 #include "lightmanager.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <osg/Texture2D>
+
+#include <OpenThreads/ScopedLock>
+
 #include <osgUtil/CullVisitor>
 
 #include <components/sceneutil/util.hpp>
@@ -160,9 +168,48 @@ namespace SceneUtil
         }
     };
 
+    // Set on a LightManager in clustered lighting mode. Binds the clustered lights of the current camera.
+    class ClusteredLightingCallback : public osg::NodeCallback
+    {
+    public:
+        ClusteredLightingCallback()
+            { }
+
+        ClusteredLightingCallback(const ClusteredLightingCallback& copy, const osg::CopyOp& copyop)
+            : osg::NodeCallback(copy, copyop)
+            { }
+
+        META_Object(SceneUtil, ClusteredLightingCallback)
+
+        virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+        {
+            osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+            LightManager* lightManager = static_cast<LightManager*>(node);
+
+            if (!(cv->getTraversalMask() & lightManager->getLightingMask()))
+            {
+                traverse(node, nv);
+                return;
+            }
+
+            cv->pushStateSet(lightManager->getClusteredLightingStateSet(cv));
+            traverse(node, nv);
+            cv->popStateSet();
+        }
+    };
+
+    const int LightManager::sMaxClusteredLights;
+    const int LightManager::sMaxClusterLights;
+    const int LightManager::sClusterGridX;
+    const int LightManager::sClusterGridY;
+    const int LightManager::sClusterGridZ;
+    const unsigned int LightManager::sLightDataTextureUnit;
+    const unsigned int LightManager::sClusterLightsTextureUnit;
+
     LightManager::LightManager()
         : mStartLight(0)
         , mLightingMask(~0u)
+        , mClusteredLighting(false)
     {
         setUpdateCallback(new LightManagerUpdateCallback);
         for (unsigned int i=0; i<8; ++i)
@@ -171,8 +218,10 @@ namespace SceneUtil
 
     LightManager::LightManager(const LightManager &copy, const osg::CopyOp &copyop)
         : osg::Group(copy, copyop)
+        , mClusteredLightingCallback(copy.mClusteredLightingCallback)
         , mStartLight(copy.mStartLight)
         , mLightingMask(copy.mLightingMask)
+        , mClusteredLighting(copy.mClusteredLighting)
     {
 
     }
@@ -189,9 +238,19 @@ namespace SceneUtil
 
     void LightManager::update()
     {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         mLights.clear();
         mLightsInViewSpace.clear();
 
+        for (auto it = mClusteredLightingData.begin(); it != mClusteredLightingData.end(); )
+        {
+            if (!it->first.valid())
+                it = mClusteredLightingData.erase(it);
+            else
+                ++it;
+        }
+
         // do an occasional cleanup for orphaned lights
         for (int i=0; i<2; ++i)
         {
@@ -226,6 +285,8 @@ namespace SceneUtil
         for (unsigned int i=0; i<lightList.size();++i)
             hash_combine(hash, lightList[i]->mLightSource->getId());
 
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         LightStateSetMap& stateSetCache = mStateSetCache[frameNum%2];
 
         LightStateSetMap::iterator found = stateSetCache.find(hash);
@@ -262,8 +323,22 @@ namespace SceneUtil
         return mLights;
     }
 
-    const std::vector<LightManager::LightSourceViewBound>& LightManager::getLightsInViewSpace(osg::Camera *camera, const osg::RefMatrix* viewMatrix)
+    namespace
+    {
+        // Light counts up to this are tested linearly, sorting them into the grid would cost more than it saves
+        const std::size_t sMinGridLights = 16;
+        const float sLightGridCellSize = 1024.f;
+
+        int getLightGridCell(float coord)
+        {
+            return static_cast<int>(std::floor(coord / sLightGridCellSize));
+        }
+    }
+
+    const LightManager::LightSourceViewBoundCollection& LightManager::getLightCollection(osg::Camera *camera, const osg::RefMatrix* viewMatrix)
     {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         osg::observer_ptr<osg::Camera> camPtr (camera);
         std::map<osg::observer_ptr<osg::Camera>, LightSourceViewBoundCollection>::iterator it = mLightsInViewSpace.find(camPtr);
 
@@ -271,6 +346,7 @@ namespace SceneUtil
         {
             it = mLightsInViewSpace.insert(std::make_pair(camPtr, LightSourceViewBoundCollection())).first;
 
+            std::vector<LightSourceViewBound>& viewLights = it->second.mLights;
             for (std::vector<LightSourceTransform>::iterator lightIt = mLights.begin(); lightIt != mLights.end(); ++lightIt)
             {
                 osg::Matrixf worldViewMat = lightIt->mWorldMatrix * (*viewMatrix);
@@ -280,12 +356,75 @@ namespace SceneUtil
                 LightSourceViewBound l;
                 l.mLightSource = lightIt->mLightSource;
                 l.mViewBound = viewBound;
-                it->second.push_back(l);
+                viewLights.push_back(l);
+            }
+
+            if (viewLights.size() > sMinGridLights)
+            {
+                for (unsigned int i=0; i<viewLights.size(); ++i)
+                {
+                    const osg::BoundingSphere& bound = viewLights[i].mViewBound;
+                    const int minX = getLightGridCell(bound.center().x() - bound.radius());
+                    const int maxX = getLightGridCell(bound.center().x() + bound.radius());
+                    const int minZ = getLightGridCell(bound.center().z() - bound.radius());
+                    const int maxZ = getLightGridCell(bound.center().z() + bound.radius());
+                    for (int x = minX; x <= maxX; ++x)
+                        for (int z = minZ; z <= maxZ; ++z)
+                            it->second.mGrid[LightGridIndex(x, z)].push_back(i);
+                }
             }
         }
         return it->second;
     }
 
+    const std::vector<LightManager::LightSourceViewBound>& LightManager::getLightsInViewSpace(osg::Camera *camera, const osg::RefMatrix* viewMatrix)
+    {
+        return getLightCollection(camera, viewMatrix).mLights;
+    }
+
+    void LightManager::getLightsIntersecting(osg::Camera* camera, const osg::RefMatrix* viewMatrix, const osg::BoundingSphere& viewBound, LightList& out)
+    {
+        const LightSourceViewBoundCollection& collection = getLightCollection(camera, viewMatrix);
+        const std::vector<LightSourceViewBound>& lights = collection.mLights;
+
+        const int minX = getLightGridCell(viewBound.center().x() - viewBound.radius());
+        const int maxX = getLightGridCell(viewBound.center().x() + viewBound.radius());
+        const int minZ = getLightGridCell(viewBound.center().z() - viewBound.radius());
+        const int maxZ = getLightGridCell(viewBound.center().z() + viewBound.radius());
+
+        // Large bounds would visit more cells than there are lights
+        if (collection.mGrid.empty() || static_cast<std::size_t>(maxX - minX + 1) * static_cast<std::size_t>(maxZ - minZ + 1) > lights.size())
+        {
+            for (const LightSourceViewBound& l : lights)
+            {
+                if (l.mViewBound.intersects(viewBound))
+                    out.push_back(&l);
+            }
+            return;
+        }
+
+        const std::size_t first = out.size();
+        for (int x = minX; x <= maxX; ++x)
+        {
+            for (int z = minZ; z <= maxZ; ++z)
+            {
+                std::map<LightGridIndex, std::vector<unsigned int>>::const_iterator cell = collection.mGrid.find(LightGridIndex(x, z));
+                if (cell == collection.mGrid.end())
+                    continue;
+                for (unsigned int index : cell->second)
+                {
+                    if (lights[index].mViewBound.intersects(viewBound))
+                        out.push_back(&lights[index]);
+                }
+            }
+        }
+
+        // Lights overlapping several cells are found once per cell. The lights are stored contiguously, so sorting
+        // the pointers restores their order.
+        std::sort(out.begin() + first, out.end());
+        out.erase(std::unique(out.begin() + first, out.end()), out.end());
+    }
+
     class DisableLight : public osg::StateAttribute
     {
     public:
@@ -353,6 +492,233 @@ namespace SceneUtil
         return mStartLight;
     }
 
+    bool sortLights (const LightManager::LightSourceViewBound* left, const LightManager::LightSourceViewBound* right)
+    {
+        return left->mViewBound.center().length2() - left->mViewBound.radius2()*81 < right->mViewBound.center().length2() - right->mViewBound.radius2()*81;
+    }
+
+    void LightManager::setClusteredLighting(bool enabled)
+    {
+        if (enabled == mClusteredLighting)
+            return;
+        mClusteredLighting = enabled;
+
+        if (enabled)
+        {
+            mClusteredLightingCallback = new ClusteredLightingCallback;
+            addCullCallback(mClusteredLightingCallback);
+        }
+        else
+        {
+            removeCullCallback(mClusteredLightingCallback);
+            mClusteredLightingCallback = nullptr;
+            mClusteredLightingData.clear();
+        }
+    }
+
+    bool LightManager::getClusteredLighting() const
+    {
+        return mClusteredLighting;
+    }
+
+    namespace
+    {
+        osg::ref_ptr<osg::Texture2D> createDataTexture(osg::Image* image)
+        {
+            osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(image));
+            texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+            texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+            texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+            texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+            texture->setResizeNonPowerOfTwoHint(false);
+            return texture;
+        }
+
+        struct ClusteredLight
+        {
+            const LightManager::LightSourceViewBound* mLight;
+            // Inclusive cluster bounds
+            int mMinX, mMinY, mMaxX, mMaxY;
+            float mMinDepth, mMaxDepth;
+        };
+
+        int getTile(float ndc, int gridSize)
+        {
+            return std::min(gridSize - 1, std::max(0, static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * gridSize))));
+        }
+    }
+
+    osg::StateSet* LightManager::getClusteredLightingStateSet(osgUtil::CullVisitor* cv)
+    {
+        osg::observer_ptr<osg::Camera> camPtr (cv->getCurrentCamera());
+        ClusteredLightingData* data = nullptr;
+        {
+            // Each camera is culled by one thread at a time, so only the lookup needs to be protected
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            data = &mClusteredLightingData[camPtr];
+        }
+        const unsigned int frameNum = cv->getTraversalNumber();
+        const unsigned int index = frameNum % 2;
+
+        if (!data->mStateSet[index])
+        {
+            // Light i uses column i: view space position and quadratic attenuation, diffuse color and constant attenuation,
+            // ambient color and linear attenuation
+            osg::ref_ptr<osg::Image> lightData (new osg::Image);
+            lightData->allocateImage(sMaxClusteredLights, 3, 1, GL_RGBA, GL_FLOAT);
+            lightData->setInternalTextureFormat(GL_RGBA32F_ARB);
+
+            // Column per screen tile, rows of depth slices each holding the light count followed by the light indices
+            osg::ref_ptr<osg::Image> clusterLights (new osg::Image);
+            clusterLights->allocateImage(sClusterGridX * sClusterGridY, sClusterGridZ * (sMaxClusterLights + 1), 1, GL_LUMINANCE, GL_FLOAT);
+            clusterLights->setInternalTextureFormat(GL_LUMINANCE32F_ARB);
+
+            osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
+            stateset->setTextureAttribute(sLightDataTextureUnit, createDataTexture(lightData));
+            stateset->setTextureAttribute(sClusterLightsTextureUnit, createDataTexture(clusterLights));
+            stateset->addUniform(new osg::Uniform("clusterLightData", static_cast<int>(sLightDataTextureUnit)));
+            stateset->addUniform(new osg::Uniform("clusterLights", static_cast<int>(sClusterLightsTextureUnit)));
+            stateset->addUniform(new osg::Uniform("clusterProjection", osg::Matrixf()));
+            stateset->addUniform(new osg::Uniform("clusterDepth", osg::Vec2f(1.f, 0.f)));
+
+            data->mStateSet[index] = stateset;
+            data->mLightData[index] = lightData;
+            data->mClusterLights[index] = clusterLights;
+        }
+
+        osg::StateSet* stateset = data->mStateSet[index];
+        // Only bin the lights once per frame for each camera
+        if (data->mLastFrameNumber == frameNum)
+            return stateset;
+        data->mLastFrameNumber = frameNum;
+
+        // Don't use Camera::getViewMatrix, that one might be relative to another camera!
+        const osg::RefMatrix* viewMatrix = cv->getCurrentRenderStage()->getInitialViewMatrix();
+        const std::vector<LightSourceViewBound>& lights = getLightsInViewSpace(cv->getCurrentCamera(), viewMatrix);
+        // Near and far planes don't matter, only the screen position of view space points is used
+        const osg::Matrixf projectionMatrix (*cv->getProjectionMatrix());
+
+        std::vector<ClusteredLight> visibleLights;
+        for (const LightSourceViewBound& light : lights)
+        {
+            const osg::BoundingSphere& bound = light.mViewBound;
+            ClusteredLight clustered;
+            clustered.mLight = &light;
+            clustered.mMinDepth = -bound.center().z() - bound.radius();
+            clustered.mMaxDepth = -bound.center().z() + bound.radius();
+            if (clustered.mMaxDepth <= 0.f)
+                continue;
+
+            // Screen bounds of the corners of the light's bounding box
+            osg::Vec2f minNdc (1.f, 1.f);
+            osg::Vec2f maxNdc (-1.f, -1.f);
+            bool intersectsEye = false;
+            for (int corner = 0; corner < 8 && !intersectsEye; ++corner)
+            {
+                const osg::Vec3f offset ((corner & 1) ? bound.radius() : -bound.radius(),
+                                         (corner & 2) ? bound.radius() : -bound.radius(),
+                                         (corner & 4) ? bound.radius() : -bound.radius());
+                const osg::Vec4f clip = osg::Vec4f(bound.center() + offset, 1.f) * projectionMatrix;
+                if (clip.w() <= std::numeric_limits<float>::epsilon())
+                {
+                    intersectsEye = true;
+                    break;
+                }
+                const osg::Vec2f ndc (clip.x() / clip.w(), clip.y() / clip.w());
+                minNdc = osg::Vec2f(std::min(minNdc.x(), ndc.x()), std::min(minNdc.y(), ndc.y()));
+                maxNdc = osg::Vec2f(std::max(maxNdc.x(), ndc.x()), std::max(maxNdc.y(), ndc.y()));
+            }
+            if (intersectsEye)
+            {
+                minNdc = osg::Vec2f(-1.f, -1.f);
+                maxNdc = osg::Vec2f(1.f, 1.f);
+            }
+            else if (minNdc.x() > 1.f || minNdc.y() > 1.f || maxNdc.x() < -1.f || maxNdc.y() < -1.f)
+                continue;
+
+            clustered.mMinX = getTile(minNdc.x(), sClusterGridX);
+            clustered.mMinY = getTile(minNdc.y(), sClusterGridY);
+            clustered.mMaxX = getTile(maxNdc.x(), sClusterGridX);
+            clustered.mMaxY = getTile(maxNdc.y(), sClusterGridY);
+            visibleLights.push_back(clustered);
+        }
+
+        // Prefer the lights closest to the camera when there are too many lights in view or in a cluster
+        std::sort(visibleLights.begin(), visibleLights.end(), [] (const ClusteredLight& left, const ClusteredLight& right)
+        {
+            return sortLights(left.mLight, right.mLight);
+        });
+        if (visibleLights.size() > static_cast<std::size_t>(sMaxClusteredLights))
+            visibleLights.resize(sMaxClusteredLights);
+
+        // Depth slices are distributed logarithmically between the nearest and farthest light bounds
+        float nearDepth = std::numeric_limits<float>::max();
+        float farDepth = 0.f;
+        for (const ClusteredLight& light : visibleLights)
+        {
+            nearDepth = std::min(nearDepth, light.mMinDepth);
+            farDepth = std::max(farDepth, light.mMaxDepth);
+        }
+        nearDepth = std::max(nearDepth, 1.f);
+        farDepth = std::max(farDepth, nearDepth * 2.f);
+        const float depthScale = sClusterGridZ / std::log(farDepth / nearDepth);
+        auto getSlice = [&] (float depth)
+        {
+            if (depth <= nearDepth)
+                return 0;
+            return std::min(sClusterGridZ - 1, static_cast<int>(std::floor(std::log(depth / nearDepth) * depthScale)));
+        };
+
+        osg::Image& lightData = *data->mLightData[index];
+        osg::Image& clusterLights = *data->mClusterLights[index];
+
+        for (int slice = 0; slice < sClusterGridZ; ++slice)
+        {
+            float* counts = reinterpret_cast<float*>(clusterLights.data(0, slice * (sMaxClusterLights + 1)));
+            std::fill(counts, counts + sClusterGridX * sClusterGridY, 0.f);
+        }
+
+        for (std::size_t i = 0; i < visibleLights.size(); ++i)
+        {
+            const ClusteredLight& clustered = visibleLights[i];
+            const osg::Light* light = clustered.mLight->mLightSource->getLight(frameNum);
+            const osg::Vec3f& position = clustered.mLight->mViewBound.center();
+            const int column = static_cast<int>(i);
+
+            *reinterpret_cast<osg::Vec4f*>(lightData.data(column, 0)) = osg::Vec4f(position, light->getQuadraticAttenuation());
+            *reinterpret_cast<osg::Vec4f*>(lightData.data(column, 1)) = osg::Vec4f(osg::Vec3f(light->getDiffuse().x(),
+                light->getDiffuse().y(), light->getDiffuse().z()), light->getConstantAttenuation());
+            *reinterpret_cast<osg::Vec4f*>(lightData.data(column, 2)) = osg::Vec4f(osg::Vec3f(light->getAmbient().x(),
+                light->getAmbient().y(), light->getAmbient().z()), light->getLinearAttenuation());
+
+            const int minSlice = getSlice(clustered.mMinDepth);
+            const int maxSlice = getSlice(clustered.mMaxDepth);
+            for (int slice = minSlice; slice <= maxSlice; ++slice)
+            {
+                const int row = slice * (sMaxClusterLights + 1);
+                for (int y = clustered.mMinY; y <= clustered.mMaxY; ++y)
+                {
+                    for (int x = clustered.mMinX; x <= clustered.mMaxX; ++x)
+                    {
+                        const int tile = y * sClusterGridX + x;
+                        float& count = *reinterpret_cast<float*>(clusterLights.data(tile, row));
+                        if (count >= sMaxClusterLights)
+                            continue;
+                        *reinterpret_cast<float*>(clusterLights.data(tile, row + 1 + static_cast<int>(count))) = static_cast<float>(i);
+                        count += 1.f;
+                    }
+                }
+            }
+        }
+
+        lightData.dirty();
+        clusterLights.dirty();
+        stateset->getUniform("clusterProjection")->set(projectionMatrix);
+        stateset->getUniform("clusterDepth")->set(osg::Vec2f(nearDepth, depthScale));
+
+        return stateset;
+    }
+
     static int sLightId = 0;
 
     LightSource::LightSource()
@@ -373,11 +739,6 @@ namespace SceneUtil
     }
 
 
-    bool sortLights (const LightManager::LightSourceViewBound* left, const LightManager::LightSourceViewBound* right)
-    {
-        return left->mViewBound.center().length2() - left->mViewBound.radius2()*81 < right->mViewBound.center().length2() - right->mViewBound.radius2()*81;
-    }
-
     void LightListCallback::operator()(osg::Node *node, osg::NodeVisitor *nv)
     {
         osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
@@ -400,9 +761,13 @@ namespace SceneUtil
         if (!(cv->getTraversalMask() & mLightManager->getLightingMask()))
             return false;
 
+        if (mLightManager->getClusteredLighting())
+            return false;
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
         // Possible optimizations:
         // - cull list of lights by the camera frustum
-        // - organize lights in a quad tree
 
 
         // update light list if necessary
@@ -413,7 +778,6 @@ namespace SceneUtil
 
             // Don't use Camera::getViewMatrix, that one might be relative to another camera!
             const osg::RefMatrix* viewMatrix = cv->getCurrentRenderStage()->getInitialViewMatrix();
-            const std::vector<LightManager::LightSourceViewBound>& lights = mLightManager->getLightsInViewSpace(cv->getCurrentCamera(), viewMatrix);
 
             // get the node bounds in view space
             // NB do not node->getBound() * modelView, that would apply the node's transformation twice
@@ -430,15 +794,12 @@ namespace SceneUtil
             transformBoundingSphere(mat, nodeBound);
 
             mLightList.clear();
-            for (unsigned int i=0; i<lights.size(); ++i)
+            mLightManager->getLightsIntersecting(cv->getCurrentCamera(), viewMatrix, nodeBound, mLightList);
+            if (!mIgnoredLightSources.empty())
             {
-                const LightManager::LightSourceViewBound& l = lights[i];
-
-                if (mIgnoredLightSources.count(l.mLightSource))
-                    continue;
-
-                if (l.mViewBound.intersects(nodeBound))
-                    mLightList.push_back(&l);
+                mLightList.erase(std::remove_if(mLightList.begin(), mLightList.end(),
+                    [this] (const LightManager::LightSourceViewBound* l) { return mIgnoredLightSources.count(l->mLightSource) != 0; }),
+                    mLightList.end());
             }
         }
         if (!mLightList.empty())
@@ -1,14 +1,18 @@
 #ifndef OPENMW_COMPONENTS_SCENEUTIL_LIGHTMANAGER_H
 #define OPENMW_COMPONENTS_SCENEUTIL_LIGHTMANAGER_H
 
+#include <map>
 #include <set>
 
+#include <osg/Image>
 #include <osg/Light>
 
 #include <osg/Group>
 #include <osg/NodeVisitor>
 #include <osg/observer_ptr>
 
+#include <OpenThreads/Mutex>
+
 namespace osgUtil
 {
     class CullVisitor;
@@ -103,6 +107,29 @@ namespace SceneUtil
 
         int getStartLight() const;
 
+        /// Maximum number of lights in view, lights per cluster and the cluster grid size of clustered lighting.
+        /// Must match lighting.glsl.
+        static const int sMaxClusteredLights = 256;
+        static const int sMaxClusterLights = 32;
+        static const int sClusterGridX = 16;
+        static const int sClusterGridY = 8;
+        static const int sClusterGridZ = 16;
+
+        /// Texture units of the light data and the cluster light lists, above the unit used by morph targets.
+        static const unsigned int sLightDataTextureUnit = 9;
+        static const unsigned int sClusterLightsTextureUnit = 10;
+
+        /// Bin the lights in view into view-space clusters once per frame and camera, and pass them to the shaders in
+        /// textures, instead of selecting up to 8 fixed-function lights for each LightListCallback.
+        /// @note Point lights are only applied by shaders compiled with the "clusteredLighting" define, see lighting.glsl.
+        /// Ignored light sources of LightListCallbacks are not supported in this mode.
+        void setClusteredLighting(bool enabled);
+
+        bool getClusteredLighting() const;
+
+        /// Internal use only, called automatically by the LightManager's cull callback in clustered lighting mode
+        osg::StateSet* getClusteredLightingStateSet(osgUtil::CullVisitor* cv);
+
         /// Internal use only, called automatically by the LightManager's UpdateCallback
         void update();
 
@@ -127,24 +154,54 @@ namespace SceneUtil
 
         typedef std::vector<const LightSourceViewBound*> LightList;
 
+        /// Add the lights of getLightsInViewSpace() whose bounds intersect \a viewBound to \a out, in the same order.
+        /// With many lights, only the lights sorted into the same cells of a grid are tested.
+        void getLightsIntersecting(osg::Camera* camera, const osg::RefMatrix* viewMatrix, const osg::BoundingSphere& viewBound, LightList& out);
+
         osg::ref_ptr<osg::StateSet> getLightListStateSet(const LightList& lightList, unsigned int frameNum);
 
     private:
         // Lights collected from the scene graph. Only valid during the cull traversal.
         std::vector<LightSourceTransform> mLights;
 
-        typedef std::vector<LightSourceViewBound> LightSourceViewBoundCollection;
+        typedef std::pair<int, int> LightGridIndex;
+
+        struct LightSourceViewBoundCollection
+        {
+            std::vector<LightSourceViewBound> mLights;
+            // Indices into mLights by cell of the view space x/z plane, which the lights overlap. Empty with few lights.
+            std::map<LightGridIndex, std::vector<unsigned int>> mGrid;
+        };
         std::map<osg::observer_ptr<osg::Camera>, LightSourceViewBoundCollection> mLightsInViewSpace;
 
+        const LightSourceViewBoundCollection& getLightCollection(osg::Camera* camera, const osg::RefMatrix* viewMatrix);
+
         // < Light list hash , StateSet >
         typedef std::map<size_t, osg::ref_ptr<osg::StateSet> > LightStateSetMap;
         LightStateSetMap mStateSetCache[2];
 
         std::vector<osg::ref_ptr<osg::StateAttribute>> mDummies;
 
+        // Double buffered, since one of them may be in use by the draw thread at any given time
+        struct ClusteredLightingData
+        {
+            osg::ref_ptr<osg::StateSet> mStateSet[2];
+            osg::ref_ptr<osg::Image> mLightData[2];
+            osg::ref_ptr<osg::Image> mClusterLights[2];
+            unsigned int mLastFrameNumber = ~0u;
+        };
+        std::map<osg::observer_ptr<osg::Camera>, ClusteredLightingData> mClusteredLightingData;
+
+        osg::ref_ptr<osg::NodeCallback> mClusteredLightingCallback;
+
+        // Protects the per camera data and the StateSet cache, cameras may be culled in parallel
+        OpenThreads::Mutex mMutex;
+
         int mStartLight;
 
         unsigned int mLightingMask;
+
+        bool mClusteredLighting;
     };
 
     /// To receive lighting, objects must be decorated by a LightListCallback. Light list callbacks must be added via
@@ -154,8 +211,8 @@ namespace SceneUtil
     /// light lists can result in degraded performance. Too coarse grained light lists can result in lights no longer
     /// rendering when the size of a light list exceeds the OpenGL limit on the number of concurrent lights (8). A good
     /// starting point is to attach a LightListCallback to each game object's base node.
-    /// @note Not thread safe for CullThreadPerCamera threading mode.
     /// @note Due to lack of OSG support, the callback does not work on Drawables.
+    /// @note Does nothing when the LightManager uses clustered lighting, the lights are then selected per cluster.
     class LightListCallback : public osg::NodeCallback
     {
     public:
@@ -183,6 +240,8 @@ namespace SceneUtil
         unsigned int mLastFrameNumber;
         LightManager::LightList mLightList;
         std::set<SceneUtil::LightSource*> mIgnoredLightSources;
+        // The light list is shared by all cameras, which may be culled in parallel
+        OpenThreads::Mutex mMutex;
     };
 
 }
@@ -0,0 +1,146 @@
+#include "memoryusage.hpp"
+
+#include <set>
+
+#include <osg/Geometry>
+#include <osg/Image>
+#include <osg/NodeVisitor>
+#include <osg/Texture2D>
+
+namespace
+{
+    class EstimateGeometryVisitor : public osg::NodeVisitor
+    {
+    public:
+        EstimateGeometryVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+            , mSize(0)
+        {
+        }
+
+        void apply(osg::Node& node) override
+        {
+            mSize += sizeof(node);
+            traverse(node);
+        }
+
+        void apply(osg::Drawable& drawable) override
+        {
+            mSize += sizeof(drawable);
+
+            osg::Geometry* geometry = drawable.asGeometry();
+            if (!geometry)
+                return;
+
+            add(geometry->getVertexArray());
+            add(geometry->getNormalArray());
+            add(geometry->getColorArray());
+            add(geometry->getSecondaryColorArray());
+            add(geometry->getFogCoordArray());
+            for (unsigned int i = 0; i < geometry->getNumTexCoordArrays(); ++i)
+                add(geometry->getTexCoordArray(i));
+            for (unsigned int i = 0; i < geometry->getNumVertexAttribArrays(); ++i)
+                add(geometry->getVertexAttribArray(i));
+            for (unsigned int i = 0; i < geometry->getNumPrimitiveSets(); ++i)
+            {
+                if (osg::DrawElements* elements = geometry->getPrimitiveSet(i)->getDrawElements())
+                    add(elements);
+            }
+        }
+
+        std::size_t mSize;
+
+    private:
+        void add(const osg::BufferData* data)
+        {
+            if (data)
+                mSize += data->getTotalDataSize();
+        }
+    };
+
+    class CollectTexturesVisitor : public osg::NodeVisitor
+    {
+    public:
+        CollectTexturesVisitor()
+            : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN)
+        {
+        }
+
+        void apply(osg::Node& node) override
+        {
+            if (const osg::StateSet* stateSet = node.getStateSet())
+            {
+                for (const auto& unit : stateSet->getTextureAttributeList())
+                {
+                    for (const auto& attribute : unit)
+                    {
+                        if (const osg::Texture* texture = attribute.second.first->asTexture())
+                            mTextures.insert(texture);
+                    }
+                }
+            }
+            traverse(node);
+        }
+
+        std::set<const osg::Texture*> mTextures;
+    };
+
+    bool usesMipmaps(const osg::Texture& texture)
+    {
+        const osg::Texture::FilterMode filter = texture.getFilter(osg::Texture::MIN_FILTER);
+        return filter != osg::Texture::LINEAR && filter != osg::Texture::NEAREST;
+    }
+}
+
+namespace SceneUtil
+{
+
+    std::size_t estimateGeometryMemory(osg::Node& node)
+    {
+        EstimateGeometryVisitor visitor;
+        node.accept(visitor);
+        return visitor.mSize;
+    }
+
+    std::size_t estimateTextureMemory(const osg::Texture& texture)
+    {
+        std::size_t size = 0;
+        bool hasImageData = false;
+        for (unsigned int i = 0; i < texture.getNumImages(); ++i)
+        {
+            const osg::Image* image = texture.getImage(i);
+            if (!image || !image->data())
+                continue;
+            hasImageData = true;
+            std::size_t imageSize = image->getTotalSizeInBytesIncludingMipmaps();
+            // The mipmaps are generated on the GPU, adding up to a third of the base level
+            if (!image->isMipmap() && usesMipmaps(texture))
+                imageSize += imageSize / 3;
+            size += imageSize;
+        }
+
+        if (hasImageData)
+            return size;
+
+        // Render targets and textures whose images were released after the upload
+        if (const osg::Texture2D* texture2D = dynamic_cast<const osg::Texture2D*>(&texture))
+        {
+            size = static_cast<std::size_t>(texture2D->getTextureWidth()) * texture2D->getTextureHeight() * 4;
+            if (usesMipmaps(texture))
+                size += size / 3;
+        }
+        return size;
+    }
+
+    std::size_t estimateTextureMemory(osg::Node& node, std::size_t& numTextures)
+    {
+        CollectTexturesVisitor visitor;
+        node.accept(visitor);
+        std::size_t size = 0;
+        for (const osg::Texture* texture : visitor.mTextures)
+            size += estimateTextureMemory(*texture);
+        numTextures = visitor.mTextures.size();
+        return size;
+    }
+
+}
@@ -0,0 +1,29 @@
+#ifndef OPENMW_COMPONENTS_SCENEUTIL_MEMORYUSAGE_H
+#define OPENMW_COMPONENTS_SCENEUTIL_MEMORYUSAGE_H
+
+#include <cstddef>
+
+namespace osg
+{
+    class Node;
+    class Texture;
+}
+
+namespace SceneUtil
+{
+
+    /// Estimate the memory used by the nodes and the vertex and index data of a scene graph, in bytes.
+    /// Textures are not included, their images are cached and accounted for by Resource::ImageManager.
+    std::size_t estimateGeometryMemory(osg::Node& node);
+
+    /// Estimate the memory used by a texture on the GPU, in bytes, including the mipmaps that are generated when
+    /// the texture is applied. Textures without image data are assumed to use 4 bytes per texel.
+    std::size_t estimateTextureMemory(const osg::Texture& texture);
+
+    /// Estimate the GPU memory used by all distinct textures of a scene graph, in bytes.
+    /// @param numTextures Set to the number of distinct textures.
+    std::size_t estimateTextureMemory(osg::Node& node, std::size_t& numTextures);
+
+}
+
+#endif
@@ -1,14 +1,20 @@
 #include "morphgeometry.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 #include <osg/Version>
 
+#include <OpenThreads/ScopedLock>
+
+#include <components/shader/shadermanager.hpp>
+
 namespace SceneUtil
 {
 
 MorphGeometry::MorphGeometry()
-    : mLastFrameNumber(0)
+    : mGpuMorphing(false)
+    , mLastFrameNumber(0)
     , mDirty(true)
     , mMorphedBoundingBox(false)
 {
@@ -18,6 +24,9 @@ MorphGeometry::MorphGeometry()
 MorphGeometry::MorphGeometry(const MorphGeometry &copy, const osg::CopyOp &copyop)
     : osg::Drawable(copy, copyop)
     , mMorphTargets(copy.mMorphTargets)
+    , mGpuMorphing(copy.mGpuMorphing)
+    , mMorphTexture(copy.mMorphTexture)
+    , mMorphVertexIndices(copy.mMorphVertexIndices)
     , mLastFrameNumber(0)
     , mDirty(true)
     , mMorphedBoundingBox(false)
@@ -29,6 +38,39 @@ void MorphGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeom)
 {
     mSourceGeometry = sourceGeom;
 
+    if (mGpuMorphing)
+    {
+        // Vertex data is not modified, so the source arrays and their VBO can be shared,
+        // separate geometries are only needed for double buffering of morph weights.
+        const osg::Image& image = *mMorphTexture->getImage();
+        for (unsigned int i=0; i<2; ++i)
+        {
+            mGeometry[i] = new osg::Geometry(*mSourceGeometry, osg::CopyOp::SHALLOW_COPY);
+
+            const osg::Geometry& from = *mSourceGeometry;
+            osg::Geometry& to = *mGeometry[i];
+            to.setSupportsDisplayList(false);
+            to.setUseVertexBufferObjects(true);
+            to.setCullingActive(false); // make sure to disable culling since that's handled by this class
+            to.setVertexAttribArray(Shader::ShaderManager::MorphVertexIndexAttribute, mMorphVertexIndices, osg::Array::BIND_PER_VERTEX);
+
+            osg::ref_ptr<osg::StateSet> stateset = from.getStateSet()
+                    ? new osg::StateSet(*from.getStateSet(), osg::CopyOp::SHALLOW_COPY) : new osg::StateSet;
+            // No texture mode, the texture is only sampled by the vertex shader
+            stateset->setTextureAttribute(sMorphTextureUnit, mMorphTexture);
+            stateset->addUniform(new osg::Uniform("morphOffsets", static_cast<int>(sMorphTextureUnit)));
+            stateset->addUniform(new osg::Uniform("morphOffsetsTexelSize", osg::Vec2f(1.f / image.s(), 1.f / image.t())));
+            stateset->addUniform(new osg::Uniform("morphTargetCount", static_cast<int>(mMorphTargets.size())));
+            stateset->addUniform(new osg::Uniform("morphingEnabled", true));
+            osg::ref_ptr<osg::Uniform> weights (new osg::Uniform(osg::Uniform::FLOAT, "morphWeights", mMorphTargets.size()));
+            for (unsigned int j=0; j<mMorphTargets.size(); ++j)
+                weights->setElement(j, mMorphTargets[j].getWeight());
+            stateset->addUniform(weights);
+            to.setStateSet(stateset);
+        }
+        return;
+    }
+
     for (unsigned int i=0; i<2; ++i)
     {
         mGeometry[i] = new osg::Geometry(*mSourceGeometry, osg::CopyOp::SHALLOW_COPY);
@@ -58,6 +100,16 @@ void MorphGeometry::addMorphTarget(osg::Vec3Array *offsets, float weight)
     mMorphTargets.push_back(MorphTarget(offsets, weight));
     mMorphedBoundingBox = false;
     dirty();
+
+    if (mGpuMorphing)
+    {
+        mGpuMorphing = false;
+        mMorphTexture = nullptr;
+        mMorphVertexIndices = nullptr;
+        setGpuMorphing(true);
+        if (!mGpuMorphing)
+            setSourceGeometry(mSourceGeometry);
+    }
 }
 
 void MorphGeometry::dirty()
@@ -72,6 +124,69 @@ osg::ref_ptr<osg::Geometry> MorphGeometry::getSourceGeometry() const
     return mSourceGeometry;
 }
 
+void MorphGeometry::setGpuMorphing(bool enabled)
+{
+    if (enabled == mGpuMorphing)
+        return;
+
+    if (enabled)
+    {
+        if (!mSourceGeometry || mMorphTargets.empty() || mMorphTargets.size() > sMaxGpuMorphTargets)
+            return;
+        if (!mMorphTexture && !createMorphTexture())
+            return;
+    }
+
+    mGpuMorphing = enabled;
+    mDirty = true;
+    setSourceGeometry(mSourceGeometry);
+}
+
+bool MorphGeometry::getGpuMorphing() const
+{
+    return mGpuMorphing;
+}
+
+bool MorphGeometry::createMorphTexture()
+{
+    const osg::Array* vertices = mSourceGeometry->getVertexArray();
+    if (!vertices || vertices->getNumElements() == 0 || vertices->getNumElements() > sMaxGpuMorphVertices)
+        return false;
+
+    const unsigned int numVertices = vertices->getNumElements();
+    const unsigned int numTargets = mMorphTargets.size();
+
+    osg::ref_ptr<osg::Image> image (new osg::Image);
+    image->allocateImage(numVertices, numTargets, 1, GL_RGB, GL_FLOAT);
+    image->setInternalTextureFormat(GL_RGB32F_ARB);
+    osg::Vec3f* data = reinterpret_cast<osg::Vec3f*>(image->data());
+    std::fill(data, data + numVertices * numTargets, osg::Vec3f());
+    for (unsigned int i=0; i<numTargets; ++i)
+    {
+        const osg::Vec3Array* offsets = mMorphTargets[i].getOffsets();
+        std::copy(offsets->begin(), offsets->begin() + std::min<std::size_t>(offsets->size(), numVertices), data + i * numVertices);
+    }
+
+    osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(image));
+    texture->setInternalFormat(GL_RGB32F_ARB);
+    texture->setSourceFormat(GL_RGB);
+    texture->setSourceType(GL_FLOAT);
+    texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+    texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+    texture->setResizeNonPowerOfTwoHint(false);
+    texture->setUnRefImageDataAfterApply(false);
+
+    osg::ref_ptr<osg::FloatArray> vertexIndices (new osg::FloatArray(numVertices));
+    for (unsigned int i=0; i<numVertices; ++i)
+        (*vertexIndices)[i] = static_cast<float>(i);
+
+    mMorphTexture = texture;
+    mMorphVertexIndices = vertexIndices;
+    return true;
+}
+
 void MorphGeometry::accept(osg::NodeVisitor &nv)
 {
     if (!nv.validNodeMask(*this))
@@ -147,6 +262,8 @@ osg::BoundingBox MorphGeometry::computeBoundingBox() const
 
 void MorphGeometry::cull(osg::NodeVisitor *nv)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCullMutex);
+
     if (mLastFrameNumber == nv->getTraversalNumber() || !mDirty)
     {
         osg::Geometry& geom = *getGeometry(mLastFrameNumber);
@@ -160,6 +277,17 @@ void MorphGeometry::cull(osg::NodeVisitor *nv)
     mLastFrameNumber = nv->getTraversalNumber();
     osg::Geometry& geom = *getGeometry(mLastFrameNumber);
 
+    if (mGpuMorphing)
+    {
+        osg::Uniform& weights = *geom.getStateSet()->getUniform("morphWeights");
+        for (unsigned int i=0; i<mMorphTargets.size(); ++i)
+            weights.setElement(i, mMorphTargets[i].getWeight());
+        nv->pushOntoNodePath(&geom);
+        nv->apply(geom);
+        nv->popFromNodePath();
+        return;
+    }
+
     const osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
     osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
     assert(positionSrc->size() == positionDst->size());
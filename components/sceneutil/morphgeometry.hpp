@@ -2,6 +2,9 @@
 #define OPENMW_COMPONENTS_MORPHGEOMETRY_H
 
 #include <osg/Geometry>
+#include <osg/Texture2D>
+
+#include <OpenThreads/Mutex>
 
 namespace SceneUtil
 {
@@ -59,6 +62,17 @@ namespace SceneUtil
 
         osg::ref_ptr<osg::Geometry> getSourceGeometry() const;
 
+        /// Limits of the morph targets to allow morphing in the vertex shader, must match morphing_vertex.glsl.
+        static const unsigned int sMaxGpuMorphTargets = 32;
+        static const unsigned int sMaxGpuMorphVertices = 4096;
+        /// Texture unit of the morph target offsets, above the units used by shadow maps.
+        static const unsigned int sMorphTextureUnit = 8;
+
+        /// Apply morph targets in the vertex shader instead of on the CPU. Ignored if the morph targets are not suitable for it.
+        /// @note The geometry has to be rendered by a program using morphing_vertex.glsl, otherwise it will show unmorphed.
+        void setGpuMorphing(bool enabled);
+        bool getGpuMorphing() const;
+
         virtual void accept(osg::NodeVisitor &nv);
         virtual bool supports(const osg::PrimitiveFunctor&) const { return true; }
         virtual void accept(osg::PrimitiveFunctor&) const;
@@ -67,6 +81,7 @@ namespace SceneUtil
 
     private:
         void cull(osg::NodeVisitor* nv);
+        bool createMorphTexture();
 
         MorphTargetList mMorphTargets;
 
@@ -75,9 +90,17 @@ namespace SceneUtil
         osg::ref_ptr<osg::Geometry> mGeometry[2];
         osg::Geometry* getGeometry(unsigned int frame) const;
 
+        bool mGpuMorphing;
+        // Offsets of all morph targets and the index of each vertex in them, shared between copies
+        osg::ref_ptr<osg::Texture2D> mMorphTexture;
+        osg::ref_ptr<osg::FloatArray> mMorphVertexIndices;
+
         unsigned int mLastFrameNumber;
         bool mDirty; // Have any morph targets changed?
 
+        // Cameras may be culled in parallel, but the geometry must only be morphed once per frame
+        OpenThreads::Mutex mCullMutex;
+
         mutable bool mMorphedBoundingBox;
     };
 
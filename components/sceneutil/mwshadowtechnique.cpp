@@ -23,6 +23,7 @@
 #include <osg/Geometry>
 #include <osg/io_utils>
 
+#include <cmath>
 #include <sstream>
 
 namespace {
@@ -514,7 +515,8 @@ void MWShadowTechnique::LightData::setLightData(osg::RefMatrix* lm, const osg::L
 //
 MWShadowTechnique::ShadowData::ShadowData(MWShadowTechnique::ViewDependentData* vdd):
     _viewDependentData(vdd),
-    _textureUnit(0)
+    _textureUnit(0),
+    _rendered(false)
 {
 
     const ShadowSettings* settings = vdd->getViewDependentShadowMap()->getShadowedScene()->getShadowSettings();
@@ -848,6 +850,16 @@ void SceneUtil::MWShadowTechnique::setShadowFadeStart(float shadowFadeStart)
     _shadowFadeStart = shadowFadeStart;
 }
 
+void SceneUtil::MWShadowTechnique::setDistantShadowMapUpdateInterval(unsigned int interval)
+{
+    _distantShadowMapUpdateInterval = interval;
+}
+
+void SceneUtil::MWShadowTechnique::setCasterSmallFeatureCullingPixelSize(float pixelSize)
+{
+    _casterSmallFeatureCullingPixelSize = pixelSize;
+}
+
 void SceneUtil::MWShadowTechnique::enableFrontFaceCulling()
 {
     _useFrontFaceCulling = true;
@@ -872,6 +884,7 @@ void SceneUtil::MWShadowTechnique::setupCastingShader(Shader::ShaderManager & sh
 
     _castingProgram->addShader(shaderManager.getShader("shadowcasting_vertex.glsl", Shader::ShaderManager::DefineMap(), osg::Shader::VERTEX));
     _castingProgram->addShader(shaderManager.getShader("shadowcasting_fragment.glsl", Shader::ShaderManager::DefineMap(), osg::Shader::FRAGMENT));
+    Shader::ShaderManager::bindVertexAttributes(*_castingProgram);
 }
 
 MWShadowTechnique::ViewDependentData* MWShadowTechnique::createViewDependentData(osgUtil::CullVisitor* /*cv*/)
@@ -1177,6 +1190,26 @@ void MWShadowTechnique::cull(osgUtil::CullVisitor& cv)
 
             osg::ref_ptr<osg::Camera> camera = sd->_camera;
 
+            // Keep the shadow map and camera matrices of a distant cascade from its last rendering if they are still good enough
+            if (sm_i > 0 && canReuseShadowMap(*sd, pl, frustum, cv.getTraversalNumber() + sm_i))
+            {
+                if (!orthographicViewFrustum && settings->getShadowMapProjectionHint()==ShadowSettings::PERSPECTIVE_SHADOW_MAP)
+                    setValidRegionMatrix(sm_i, cv.getCurrentCamera()->getInverseViewMatrix() * sd->_renderedValidRegionMatrix);
+
+                assignTexGenSettings(&cv, camera.get(), textureUnit, sd->_texgen.get());
+                pl.textureUnits.push_back(textureUnit);
+                sd->_textureUnit = textureUnit;
+                if (textureUnit < 8)
+                    sdl.push_back(sd);
+
+                ++textureUnit;
+                ++numValidShadows;
+
+                if (_debugHud)
+                    _debugHud->draw(sd->_texture, sm_i, camera->getViewMatrix() * camera->getProjectionMatrix(), cv);
+                continue;
+            }
+
             camera->setProjectionMatrix(projectionMatrix);
             camera->setViewMatrix(viewMatrix);
 
@@ -1316,6 +1349,15 @@ void MWShadowTechnique::cull(osgUtil::CullVisitor& cv)
             osg::ref_ptr<VDSMCameraCullCallback> vdsmCallback = new VDSMCameraCullCallback(this, local_polytope);
             camera->setCullCallback(vdsmCallback.get());
 
+            // The projected size of a caster is only meaningful for the orthographic shadow map projection
+            if (_casterSmallFeatureCullingPixelSize > 0 && (orthographicViewFrustum || settings->getShadowMapProjectionHint() != ShadowSettings::PERSPECTIVE_SHADOW_MAP))
+            {
+                camera->setCullingMode(camera->getCullingMode() | osg::CullSettings::SMALL_FEATURE_CULLING);
+                camera->setSmallFeatureCullingPixelSize(_casterSmallFeatureCullingPixelSize);
+            }
+            else
+                camera->setCullingMode(camera->getCullingMode() & ~osg::CullSettings::SMALL_FEATURE_CULLING);
+
             // 4.3 traverse RTT camera
             //
 
@@ -1327,28 +1369,8 @@ void MWShadowTechnique::cull(osgUtil::CullVisitor& cv)
 
             if (!orthographicViewFrustum && settings->getShadowMapProjectionHint()==ShadowSettings::PERSPECTIVE_SHADOW_MAP)
             {
-                {
-                    osg::Matrix validRegionMatrix = cv.getCurrentCamera()->getInverseViewMatrix() *  camera->getViewMatrix() * camera->getProjectionMatrix();
-
-                    std::string validRegionUniformName = "validRegionMatrix" + std::to_string(sm_i);
-                    osg::ref_ptr<osg::Uniform> validRegionUniform;
-
-                    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_accessUniformsAndProgramMutex);
-
-                    for (auto uniform : _uniforms)
-                    {
-                        if (uniform->getName() == validRegionUniformName)
-                            validRegionUniform = uniform;
-                    }
-
-                    if (!validRegionUniform)
-                    {
-                        validRegionUniform = new osg::Uniform(osg::Uniform::FLOAT_MAT4, validRegionUniformName);
-                        _uniforms.push_back(validRegionUniform);
-                    }
-
-                    validRegionUniform->set(validRegionMatrix);
-                }
+                sd->_renderedValidRegionMatrix = camera->getViewMatrix() * camera->getProjectionMatrix();
+                setValidRegionMatrix(sm_i, cv.getCurrentCamera()->getInverseViewMatrix() * sd->_renderedValidRegionMatrix);
 
                 if (settings->getMultipleShadowMapHint() == ShadowSettings::CASCADED)
                     adjustPerspectiveShadowMapCameraSettings(vdsmCallback->getRenderStage(), frustum, pl, camera.get(), cascaseNear, cascadeFar);
@@ -1360,6 +1382,11 @@ void MWShadowTechnique::cull(osgUtil::CullVisitor& cv)
                 }
             }
 
+            sd->_rendered = true;
+            sd->_renderedLightDir = pl.lightDir;
+            sd->_renderedEye = frustum.eye;
+            sd->_renderedViewDir = frustum.frustumCenterLine;
+
             // 4.4 compute main scene graph TexGen + uniform settings + setup state
             //
             assignTexGenSettings(&cv, camera.get(), textureUnit, sd->_texgen.get());
@@ -1396,6 +1423,50 @@ void MWShadowTechnique::cull(osgUtil::CullVisitor& cv)
     // OSG_NOTICE<<"End of shadow setup Projection matrix "<<*cv.getProjectionMatrix()<<std::endl;
 }
 
+bool MWShadowTechnique::canReuseShadowMap(const ShadowData& sd, const LightData& light, const Frustum& frustum, unsigned int frameNumber) const
+{
+    // Shadows are in world space, so a shadow map stays valid until the light moves, only its coverage follows the view
+    static const double maxAngleCos = std::cos(osg::DegreesToRadians(1.0));
+    static const double maxViewAngleCos = std::cos(osg::DegreesToRadians(5.0));
+    static const double maxEyeDistance = 128.0;
+
+    if (_distantShadowMapUpdateInterval == 1 || !sd._rendered)
+        return false;
+
+    // Stagger the updates of the cascades
+    if (_distantShadowMapUpdateInterval > 1 && frameNumber % _distantShadowMapUpdateInterval == 0)
+        return false;
+
+    if (!light.directionalLight)
+        return false;
+
+    return light.lightDir * sd._renderedLightDir >= maxAngleCos
+        && frustum.frustumCenterLine * sd._renderedViewDir >= maxViewAngleCos
+        && (frustum.eye - sd._renderedEye).length2() <= maxEyeDistance * maxEyeDistance;
+}
+
+void MWShadowTechnique::setValidRegionMatrix(unsigned int shadowMapNumber, const osg::Matrix& validRegionMatrix)
+{
+    std::string validRegionUniformName = "validRegionMatrix" + std::to_string(shadowMapNumber);
+    osg::ref_ptr<osg::Uniform> validRegionUniform;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_accessUniformsAndProgramMutex);
+
+    for (auto uniform : _uniforms)
+    {
+        if (uniform->getName() == validRegionUniformName)
+            validRegionUniform = uniform;
+    }
+
+    if (!validRegionUniform)
+    {
+        validRegionUniform = new osg::Uniform(osg::Uniform::FLOAT_MAT4, validRegionUniformName);
+        _uniforms.push_back(validRegionUniform);
+    }
+
+    validRegionUniform->set(validRegionMatrix);
+}
+
 bool MWShadowTechnique::selectActiveLights(osgUtil::CullVisitor* cv, ViewDependentData* vdd) const
 {
     OSG_INFO<<"selectActiveLights"<<std::endl;
@@ -78,6 +78,14 @@ namespace SceneUtil {
 
         virtual void setShadowFadeStart(float shadowFadeStart);
 
+        /// Render the shadow maps after the first one at most every \a interval frames, 0 to only render them when the
+        /// light or the camera moved noticeably. They are always rendered again when the light or the camera moved.
+        virtual void setDistantShadowMapUpdateInterval(unsigned int interval);
+
+        /// Skip shadow casters covering less than \a pixelSize pixels of a shadow map, 0 to render all of them.
+        /// Small objects cast few texels in the wide distant shadow maps, so their shadows are mostly lost anyway.
+        virtual void setCasterSmallFeatureCullingPixelSize(float pixelSize);
+
         virtual void enableFrontFaceCulling();
 
         virtual void disableFrontFaceCulling();
@@ -173,6 +181,13 @@ namespace SceneUtil {
             osg::ref_ptr<osg::Texture2D>        _texture;
             osg::ref_ptr<osg::TexGen>           _texgen;
             osg::ref_ptr<osg::Camera>           _camera;
+
+            // State of the last rendering of the shadow map, to reuse it in later frames
+            bool                                _rendered;
+            osg::Vec3d                          _renderedLightDir;
+            osg::Vec3d                          _renderedEye;
+            osg::Vec3d                          _renderedViewDir;
+            osg::Matrixd                        _renderedValidRegionMatrix;
         };
 
         typedef std::list< osg::ref_ptr<ShadowData> > ShadowDataList;
@@ -230,6 +245,10 @@ namespace SceneUtil {
 
         virtual osg::StateSet* selectStateSetForRenderingShadow(ViewDependentData& vdd) const;
 
+        bool canReuseShadowMap(const ShadowData& sd, const LightData& light, const Frustum& frustum, unsigned int frameNumber) const;
+
+        void setValidRegionMatrix(unsigned int shadowMapNumber, const osg::Matrix& validRegionMatrix);
+
     protected:
         virtual ~MWShadowTechnique();
 
@@ -261,6 +280,10 @@ namespace SceneUtil {
 
         float                                   _shadowFadeStart = 0.0;
 
+        unsigned int                            _distantShadowMapUpdateInterval = 1;
+
+        float                                   _casterSmallFeatureCullingPixelSize = 0.0;
+
         class DebugHUD final : public osg::Referenced
         {
         public:
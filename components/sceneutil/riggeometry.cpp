@@ -2,33 +2,51 @@
 
 #include <osg/Version>
 
+#include <OpenThreads/ScopedLock>
+
 #include <components/debug/debuglog.hpp>
+#include <components/shader/shadermanager.hpp>
 
 #include "skeleton.hpp"
 #include "util.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <map>
+
 namespace
 {
-    inline void accumulateMatrix(const osg::Matrixf& invBindMatrix, const osg::Matrixf& matrix, const float weight, osg::Matrixf& result)
+    // The kernels below work on raw floats of affine matrices in osg's row vector convention,
+    // the fixed trip counts and absence of divisions allow the compiler to vectorize them.
+
+    inline void blendMatrices(const osg::Matrixf* matrices, const unsigned short* bones, const float* weights,
+                              std::size_t count, osg::Matrixf& result)
     {
-        osg::Matrixf m = invBindMatrix * matrix;
-        float* ptr = m.ptr();
-        float* ptrresult = result.ptr();
-        ptrresult[0] += ptr[0] * weight;
-        ptrresult[1] += ptr[1] * weight;
-        ptrresult[2] += ptr[2] * weight;
-
-        ptrresult[4] += ptr[4] * weight;
-        ptrresult[5] += ptr[5] * weight;
-        ptrresult[6] += ptr[6] * weight;
-
-        ptrresult[8] += ptr[8] * weight;
-        ptrresult[9] += ptr[9] * weight;
-        ptrresult[10] += ptr[10] * weight;
-
-        ptrresult[12] += ptr[12] * weight;
-        ptrresult[13] += ptr[13] * weight;
-        ptrresult[14] += ptr[14] * weight;
+        float* dst = result.ptr();
+        std::fill(dst, dst + 16, 0.f);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float* src = matrices[bones[i]].ptr();
+            const float weight = weights[i];
+            for (std::size_t j = 0; j < 16; ++j)
+                dst[j] += src[j] * weight;
+        }
+        // Weights are not required to sum up to 1
+        dst[15] = 1.f;
+    }
+
+    inline osg::Vec3f transformPoint(const float* m, const osg::Vec3f& v)
+    {
+        return osg::Vec3f(v.x() * m[0] + v.y() * m[4] + v.z() * m[8] + m[12],
+                          v.x() * m[1] + v.y() * m[5] + v.z() * m[9] + m[13],
+                          v.x() * m[2] + v.y() * m[6] + v.z() * m[10] + m[14]);
+    }
+
+    inline osg::Vec3f transformVector(const float* m, const osg::Vec3f& v)
+    {
+        return osg::Vec3f(v.x() * m[0] + v.y() * m[4] + v.z() * m[8],
+                          v.x() * m[1] + v.y() * m[5] + v.z() * m[9],
+                          v.x() * m[2] + v.y() * m[6] + v.z() * m[10]);
     }
 }
 
@@ -37,8 +55,13 @@ namespace SceneUtil
 
 RigGeometry::RigGeometry()
     : mSkeleton(nullptr)
+    , mGpuSkinning(false)
     , mLastFrameNumber(0)
+    , mLastSkinnedUpdateNumber(0)
     , mBoundsFirstFrame(true)
+    , mSkinnedBoneVersion(0)
+    , mBoundsBoneVersion(0)
+    , mGeomToSkelMatrixChanged(false)
 {
     setNumChildrenRequiringUpdateTraversal(1);
     // update done in accept(NodeVisitor&)
@@ -48,10 +71,17 @@ RigGeometry::RigGeometry(const RigGeometry &copy, const osg::CopyOp &copyop)
     : Drawable(copy, copyop)
     , mSkeleton(nullptr)
     , mInfluenceMap(copy.mInfluenceMap)
-    , mBone2VertexVector(copy.mBone2VertexVector)
+    , mGpuSkinning(copy.mGpuSkinning)
+    , mBoneIndices(copy.mBoneIndices)
+    , mBoneWeights(copy.mBoneWeights)
+    , mVertexGroups(copy.mVertexGroups)
     , mBoneSphereVector(copy.mBoneSphereVector)
     , mLastFrameNumber(0)
+    , mLastSkinnedUpdateNumber(0)
     , mBoundsFirstFrame(true)
+    , mSkinnedBoneVersion(0)
+    , mBoundsBoneVersion(0)
+    , mGeomToSkelMatrixChanged(false)
 {
     setSourceGeometry(copy.mSourceGeometry);
     setNumChildrenRequiringUpdateTraversal(1);
@@ -61,6 +91,34 @@ void RigGeometry::setSourceGeometry(osg::ref_ptr<osg::Geometry> sourceGeometry)
 {
     mSourceGeometry = sourceGeometry;
 
+    if (mGpuSkinning)
+    {
+        // Vertex data is not modified, so the source arrays and their VBO can be shared,
+        // separate geometries are only needed for double buffering of bone matrices.
+        mSourceTangents = nullptr;
+        const unsigned int numBones = std::max<std::size_t>(mInfluenceMap->mData.size(), 1);
+        for (unsigned int i=0; i<2; ++i)
+        {
+            const osg::Geometry& from = *sourceGeometry;
+            mGeometry[i] = new osg::Geometry(from, osg::CopyOp::SHALLOW_COPY);
+            osg::Geometry& to = *mGeometry[i];
+            to.setSupportsDisplayList(false);
+            to.setUseVertexBufferObjects(true);
+            to.setCullingActive(false); // make sure to disable culling since that's handled by this class
+            to.setComputeBoundingBoxCallback(new CopyBoundingBoxCallback());
+            to.setComputeBoundingSphereCallback(new CopyBoundingSphereCallback());
+            to.setVertexAttribArray(Shader::ShaderManager::BoneIndicesAttribute, mBoneIndices, osg::Array::BIND_PER_VERTEX);
+            to.setVertexAttribArray(Shader::ShaderManager::BoneWeightsAttribute, mBoneWeights, osg::Array::BIND_PER_VERTEX);
+
+            osg::ref_ptr<osg::StateSet> stateset = from.getStateSet()
+                    ? new osg::StateSet(*from.getStateSet(), osg::CopyOp::SHALLOW_COPY) : new osg::StateSet;
+            stateset->addUniform(new osg::Uniform("skinningEnabled", true));
+            stateset->addUniform(new osg::Uniform(osg::Uniform::FLOAT_MAT4, "boneMatrices", numBones));
+            to.setStateSet(stateset);
+        }
+        return;
+    }
+
     for (unsigned int i=0; i<2; ++i)
     {
         const osg::Geometry& from = *sourceGeometry;
@@ -111,6 +169,80 @@ osg::ref_ptr<osg::Geometry> RigGeometry::getSourceGeometry()
     return mSourceGeometry;
 }
 
+void RigGeometry::setGpuSkinning(bool enabled)
+{
+    if (enabled == mGpuSkinning)
+        return;
+
+    if (enabled)
+    {
+        if (!mSourceGeometry || !mInfluenceMap || mInfluenceMap->mData.size() > sMaxGpuSkinningBones)
+            return;
+        if (!mBoneIndices && !createSkinningAttributes())
+            return;
+    }
+
+    mGpuSkinning = enabled;
+    setSourceGeometry(mSourceGeometry);
+}
+
+bool RigGeometry::getGpuSkinning() const
+{
+    return mGpuSkinning;
+}
+
+bool RigGeometry::createSkinningAttributes()
+{
+    const osg::Array* vertices = mSourceGeometry->getVertexArray();
+    if (!vertices)
+        return false;
+
+    const unsigned int numVertices = vertices->getNumElements();
+    // <weight, bone index>
+    std::vector<std::vector<std::pair<float, unsigned int>>> vertexWeights(numVertices);
+    for (unsigned int i = 0; i < mInfluenceMap->mData.size(); ++i)
+    {
+        for (const auto& weightPair : mInfluenceMap->mData[i].second.mWeights)
+        {
+            if (weightPair.first < numVertices)
+                vertexWeights[weightPair.first].emplace_back(weightPair.second, i);
+        }
+    }
+
+    osg::ref_ptr<osg::Vec4Array> boneIndices (new osg::Vec4Array(numVertices));
+    osg::ref_ptr<osg::Vec4Array> boneWeights (new osg::Vec4Array(numVertices));
+    for (unsigned int vertex = 0; vertex < numVertices; ++vertex)
+    {
+        std::vector<std::pair<float, unsigned int>>& weights = vertexWeights[vertex];
+        // The CPU path leaves vertices without any bone in place, which a bone palette can't express
+        if (weights.empty())
+            return false;
+
+        std::sort(weights.begin(), weights.end(), std::greater<std::pair<float, unsigned int>>());
+
+        float totalWeight = 0.f;
+        for (const auto& weight : weights)
+            totalWeight += weight.first;
+
+        const std::size_t count = std::min<std::size_t>(weights.size(), 4);
+        float usedWeight = 0.f;
+        for (std::size_t i = 0; i < count; ++i)
+            usedWeight += weights[i].first;
+        // Keep the total weight of dropped influences
+        const float scale = usedWeight > 0.f ? totalWeight / usedWeight : 1.f;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            (*boneIndices)[vertex][i] = static_cast<float>(weights[i].second);
+            (*boneWeights)[vertex][i] = weights[i].first * scale;
+        }
+    }
+
+    mBoneIndices = boneIndices;
+    mBoneWeights = boneWeights;
+    return true;
+}
+
 bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
 {
     const osg::NodePath& path = nv->getNodePath();
@@ -137,42 +269,44 @@ bool RigGeometry::initFromParentSkeleton(osg::NodeVisitor* nv)
     }
 
     mBoneNodesVector.clear();
-    for (auto& bonePair : mBoneSphereVector->mData)
+    mBoneNodesVector.reserve(mInfluenceMap->mData.size());
+    for (const auto& influence : mInfluenceMap->mData)
     {
-        const std::string& boneName = bonePair.first;
-        Bone* bone = mSkeleton->getBone(boneName);
+        Bone* bone = mSkeleton->getBone(influence.first);
         if (!bone)
-        {
-            mBoneNodesVector.push_back(nullptr);
-            Log(Debug::Error) << "Error: RigGeometry did not find bone " << boneName;
-            continue;
-        }
-
+            Log(Debug::Error) << "Error: RigGeometry did not find bone " << influence.first;
         mBoneNodesVector.push_back(bone);
     }
+    mBoneMatrices.resize(mBoneNodesVector.size());
 
-    for (auto& pair : mBone2VertexVector->mData)
+    mSkinnedBoneVersion = 0;
+    mBoundsBoneVersion = 0;
+
+    return true;
+}
+
+void RigGeometry::updateBoneMatrices()
+{
+    for (std::size_t i = 0; i < mBoneMatrices.size(); ++i)
     {
-        for (auto &weight : pair.first)
+        const Bone* bone = mBoneNodesVector[i];
+        osg::Matrixf& matrix = mBoneMatrices[i];
+        if (bone == nullptr)
         {
-            const std::string& boneName = weight.first.first;
-            Bone* bone = mSkeleton->getBone(boneName);
-            if (!bone)
-            {
-                mBoneNodesVector.push_back(nullptr);
-                Log(Debug::Error) << "Error: RigGeometry did not find bone " << boneName;
-                continue;
-            }
-
-            mBoneNodesVector.push_back(bone);
+            // Missing bones don't contribute to skinning
+            matrix.set(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            continue;
         }
+        matrix.mult(mInfluenceMap->mData[i].second.mInvBindMatrix, bone->mMatrixInSkeletonSpace);
+        if (mGeomToSkelMatrix)
+            matrix.postMult(*mGeomToSkelMatrix);
     }
-
-    return true;
 }
 
 void RigGeometry::cull(osg::NodeVisitor* nv)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mCullMutex);
+
     if (!mSkeleton)
     {
         Log(Debug::Error) << "Error: RigGeometry rendering with no skeleton, should have been initialized by UpdateVisitor";
@@ -182,7 +316,10 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
     }
 
     unsigned int traversalNumber = nv->getTraversalNumber();
-    if (mLastFrameNumber == traversalNumber || (mLastFrameNumber != 0 && !mSkeleton->getActive()))
+    // Skeletons updated at a reduced rate keep the same bones until their next update, so skinning results would not change
+    const bool skeletonUpdated = mSkeleton->getUpdateInterval() <= 1
+            || mSkeleton->getLastUpdateTraversalNumber() != mLastSkinnedUpdateNumber;
+    if (mLastFrameNumber == traversalNumber || (mLastFrameNumber != 0 && (!mSkeleton->getActive() || !skeletonUpdated)))
     {
         osg::Geometry& geom = *getGeometry(mLastFrameNumber);
         nv->pushOntoNodePath(&geom);
@@ -190,52 +327,81 @@ void RigGeometry::cull(osg::NodeVisitor* nv)
         nv->popFromNodePath();
         return;
     }
+    mLastSkinnedUpdateNumber = mSkeleton->getLastUpdateTraversalNumber();
+
+    // Keep drawing the last skinned geometry while none of the bones moved
+    const unsigned int boneVersion = mSkeleton->updateBoneMatrices(traversalNumber);
+    if (mLastFrameNumber != 0 && boneVersion == mSkinnedBoneVersion && !mGeomToSkelMatrixChanged)
+    {
+        osg::Geometry& geom = *getGeometry(mLastFrameNumber);
+        nv->pushOntoNodePath(&geom);
+        nv->apply(geom);
+        nv->popFromNodePath();
+        return;
+    }
+    mSkinnedBoneVersion = boneVersion;
+    mGeomToSkelMatrixChanged = false;
+
     mLastFrameNumber = traversalNumber;
     osg::Geometry& geom = *getGeometry(mLastFrameNumber);
 
-    mSkeleton->updateBoneMatrices(traversalNumber);
+    updateBoneMatrices();
+
+    if (mGpuSkinning)
+    {
+        osg::Uniform& uniform = *geom.getStateSet()->getUniform("boneMatrices");
+        for (std::size_t i = 0; i < mBoneMatrices.size(); ++i)
+            uniform.setElement(i, mBoneMatrices[i]);
+        nv->pushOntoNodePath(&geom);
+        nv->apply(geom);
+        nv->popFromNodePath();
+        return;
+    }
 
     // skinning
-    const osg::Vec3Array* positionSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getVertexArray());
-    const osg::Vec3Array* normalSrc = static_cast<osg::Vec3Array*>(mSourceGeometry->getNormalArray());
-    const osg::Vec4Array* tangentSrc = mSourceTangents;
+    const osg::Vec3f* positionSrc = static_cast<const osg::Vec3Array*>(mSourceGeometry->getVertexArray())->asVector().data();
+    const osg::Vec3Array* normalSrcArray = static_cast<const osg::Vec3Array*>(mSourceGeometry->getNormalArray());
+    const osg::Vec3f* normalSrc = normalSrcArray ? normalSrcArray->asVector().data() : nullptr;
+    const osg::Vec4f* tangentSrc = mSourceTangents ? mSourceTangents->asVector().data() : nullptr;
 
     osg::Vec3Array* positionDst = static_cast<osg::Vec3Array*>(geom.getVertexArray());
     osg::Vec3Array* normalDst = static_cast<osg::Vec3Array*>(geom.getNormalArray());
     osg::Vec4Array* tangentDst = static_cast<osg::Vec4Array*>(geom.getTexCoordArray(7));
 
-    int index = mBoneSphereVector->mData.size();
-    for (auto &pair : mBone2VertexVector->mData)
-    {
-        osg::Matrixf resultMat (0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 0,
-                                0, 0, 0, 1);
+    osg::Vec3f* positions = positionDst->asVector().data();
+    osg::Vec3f* normals = normalDst ? normalDst->asVector().data() : nullptr;
+    osg::Vec4f* tangents = tangentDst ? tangentDst->asVector().data() : nullptr;
 
-        for (auto &weight : pair.first)
-        {
-            Bone* bone = mBoneNodesVector[index];
-            if (bone == nullptr)
-                continue;
+    const VertexGroups& groups = *mVertexGroups;
+    const std::size_t numGroups = groups.mVertexOffsets.size() - 1;
+    osg::Matrixf resultMat;
+    for (std::size_t group = 0; group < numGroups; ++group)
+    {
+        const std::size_t bonesBegin = groups.mBoneOffsets[group];
+        blendMatrices(mBoneMatrices.data(), groups.mBones.data() + bonesBegin, groups.mWeights.data() + bonesBegin,
+                      groups.mBoneOffsets[group + 1] - bonesBegin, resultMat);
+        const float* m = resultMat.ptr();
 
-            accumulateMatrix(weight.first.second, bone->mMatrixInSkeletonSpace, weight.second, resultMat);
-            index++;
-        }
+        const unsigned short* vertex = groups.mVertices.data() + groups.mVertexOffsets[group];
+        const unsigned short* verticesEnd = groups.mVertices.data() + groups.mVertexOffsets[group + 1];
 
-        if (mGeomToSkelMatrix)
-            resultMat *= (*mGeomToSkelMatrix);
+        for (; vertex != verticesEnd; ++vertex)
+            positions[*vertex] = transformPoint(m, positionSrc[*vertex]);
 
-        for (auto &vertex : pair.second)
+        if (normals)
         {
-            (*positionDst)[vertex] = resultMat.preMult((*positionSrc)[vertex]);
-            if (normalDst)
-                (*normalDst)[vertex] = osg::Matrixf::transform3x3((*normalSrc)[vertex], resultMat);
+            vertex = groups.mVertices.data() + groups.mVertexOffsets[group];
+            for (; vertex != verticesEnd; ++vertex)
+                normals[*vertex] = transformVector(m, normalSrc[*vertex]);
+        }
 
-            if (tangentDst)
+        if (tangents)
+        {
+            vertex = groups.mVertices.data() + groups.mVertexOffsets[group];
+            for (; vertex != verticesEnd; ++vertex)
             {
-                const osg::Vec4f& srcTangent = (*tangentSrc)[vertex];
-                osg::Vec3f transformedTangent = osg::Matrixf::transform3x3(osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z()), resultMat);
-                (*tangentDst)[vertex] = osg::Vec4f(transformedTangent, srcTangent.w());
+                const osg::Vec4f& srcTangent = tangentSrc[*vertex];
+                tangents[*vertex] = osg::Vec4f(transformVector(m, osg::Vec3f(srcTangent.x(), srcTangent.y(), srcTangent.z())), srcTangent.w());
             }
         }
     }
@@ -267,21 +433,23 @@ void RigGeometry::updateBounds(osg::NodeVisitor *nv)
         return;
     mBoundsFirstFrame = false;
 
-    mSkeleton->updateBoneMatrices(nv->getTraversalNumber());
+    const unsigned int boneVersion = mSkeleton->updateBoneMatrices(nv->getTraversalNumber());
 
-    updateGeomToSkelMatrix(nv->getNodePath());
+    if (updateGeomToSkelMatrix(nv->getNodePath()))
+        mGeomToSkelMatrixChanged = true;
+    else if (boneVersion == mBoundsBoneVersion)
+        return;
+    mBoundsBoneVersion = boneVersion;
 
     osg::BoundingBox box;
 
-    int index = 0;
-    for (auto& boundPair : mBoneSphereVector->mData)
+    for (std::size_t index = 0; index < mBoneSphereVector->mData.size(); ++index)
     {
         Bone* bone = mBoneNodesVector[index];
         if (bone == nullptr)
             continue;
 
-        index++;
-        osg::BoundingSpheref bs = boundPair.second;
+        osg::BoundingSpheref bs = mBoneSphereVector->mData[index].second;
         if (mGeomToSkelMatrix)
             transformBoundingSphere(bone->mMatrixInSkeletonSpace * (*mGeomToSkelMatrix), bs);
         else
@@ -307,7 +475,7 @@ void RigGeometry::updateBounds(osg::NodeVisitor *nv)
     }
 }
 
-void RigGeometry::updateGeomToSkelMatrix(const osg::NodePath& nodePath)
+bool RigGeometry::updateGeomToSkelMatrix(const osg::NodePath& nodePath)
 {
     bool foundSkel = false;
     osg::ref_ptr<osg::RefMatrix> geomToSkelMatrix;
@@ -329,41 +497,69 @@ void RigGeometry::updateGeomToSkelMatrix(const osg::NodePath& nodePath)
             }
         }
     }
-    if (geomToSkelMatrix && !geomToSkelMatrix->isIdentity())
+    if (geomToSkelMatrix && !geomToSkelMatrix->isIdentity()
+            && (!mGeomToSkelMatrix || *mGeomToSkelMatrix != *geomToSkelMatrix))
+    {
         mGeomToSkelMatrix = geomToSkelMatrix;
+        return true;
+    }
+    return false;
 }
 
 void RigGeometry::setInfluenceMap(osg::ref_ptr<InfluenceMap> influenceMap)
 {
     mInfluenceMap = influenceMap;
+    mBoneIndices = nullptr;
+    mBoneWeights = nullptr;
 
-    typedef std::map<unsigned short, std::vector<BoneWeight> > Vertex2BoneMap;
+    // <bone index, weight>
+    typedef std::vector<std::pair<unsigned short, float>> BoneWeights;
+    typedef std::map<unsigned short, BoneWeights> Vertex2BoneMap;
     Vertex2BoneMap vertex2BoneMap;
     mBoneSphereVector = new BoneSphereVector;
     mBoneSphereVector->mData.reserve(mInfluenceMap->mData.size());
-    mBone2VertexVector = new Bone2VertexVector;
-    for (auto& influencePair : mInfluenceMap->mData)
+    for (std::size_t i = 0; i < mInfluenceMap->mData.size(); ++i)
     {
-        const std::string& boneName = influencePair.first;
-        const BoneInfluence& bi = influencePair.second;
+        const std::string& boneName = mInfluenceMap->mData[i].first;
+        const BoneInfluence& bi = mInfluenceMap->mData[i].second;
         mBoneSphereVector->mData.emplace_back(boneName, bi.mBoundSphere);
 
         for (auto& weightPair: bi.mWeights)
-        {
-            std::vector<BoneWeight>& vec = vertex2BoneMap[weightPair.first];
-
-            vec.emplace_back(std::make_pair(boneName, bi.mInvBindMatrix), weightPair.second);
-        }
+            vertex2BoneMap[weightPair.first].emplace_back(static_cast<unsigned short>(i), weightPair.second);
     }
 
+    typedef std::map<BoneWeights, std::vector<unsigned short>> Bone2VertexMap;
     Bone2VertexMap bone2VertexMap;
     for (auto& vertexPair : vertex2BoneMap)
     {
         bone2VertexMap[vertexPair.second].emplace_back(vertexPair.first);
     }
 
-    mBone2VertexVector->mData.reserve(bone2VertexMap.size());
-    mBone2VertexVector->mData.assign(bone2VertexMap.begin(), bone2VertexMap.end());
+    mVertexGroups = new VertexGroups;
+    mVertexGroups->mBoneOffsets.reserve(bone2VertexMap.size() + 1);
+    mVertexGroups->mVertexOffsets.reserve(bone2VertexMap.size() + 1);
+    mVertexGroups->mVertices.reserve(vertex2BoneMap.size());
+    for (auto& groupPair : bone2VertexMap)
+    {
+        mVertexGroups->mBoneOffsets.push_back(mVertexGroups->mBones.size());
+        for (auto& weight : groupPair.first)
+        {
+            mVertexGroups->mBones.push_back(weight.first);
+            mVertexGroups->mWeights.push_back(weight.second);
+        }
+        mVertexGroups->mVertexOffsets.push_back(mVertexGroups->mVertices.size());
+        mVertexGroups->mVertices.insert(mVertexGroups->mVertices.end(), groupPair.second.begin(), groupPair.second.end());
+    }
+    mVertexGroups->mBoneOffsets.push_back(mVertexGroups->mBones.size());
+    mVertexGroups->mVertexOffsets.push_back(mVertexGroups->mVertices.size());
+
+    if (mGpuSkinning)
+    {
+        mGpuSkinning = false;
+        setGpuSkinning(true);
+        if (!mGpuSkinning && mSourceGeometry)
+            setSourceGeometry(mSourceGeometry);
+    }
 }
 
 void RigGeometry::accept(osg::NodeVisitor &nv)
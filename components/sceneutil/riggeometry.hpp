@@ -4,6 +4,8 @@
 #include <osg/Geometry>
 #include <osg/Matrixf>
 
+#include <OpenThreads/Mutex>
+
 namespace SceneUtil
 {
     class Skeleton;
@@ -46,6 +48,14 @@ namespace SceneUtil
 
         osg::ref_ptr<osg::Geometry> getSourceGeometry();
 
+        /// Maximum number of bones in the influence map to allow skinning in the vertex shader, must match skinning_vertex.glsl.
+        static const unsigned int sMaxGpuSkinningBones = 64;
+
+        /// Skin in the vertex shader instead of on the CPU. Ignored if the influence map is not suitable for it.
+        /// @note The geometry has to be rendered by a program using skinning_vertex.glsl, otherwise it will show in bind pose.
+        void setGpuSkinning(bool enabled);
+        bool getGpuSkinning() const;
+
         virtual void accept(osg::NodeVisitor &nv);
         virtual bool supports(const osg::PrimitiveFunctor&) const { return true; }
         virtual void accept(osg::PrimitiveFunctor&) const;
@@ -67,6 +77,8 @@ namespace SceneUtil
     private:
         void cull(osg::NodeVisitor* nv);
         void updateBounds(osg::NodeVisitor* nv);
+        void updateBoneMatrices();
+        bool createSkinningAttributes();
 
         osg::ref_ptr<osg::Geometry> mGeometry[2];
         osg::Geometry* getGeometry(unsigned int frame) const;
@@ -79,19 +91,24 @@ namespace SceneUtil
 
         osg::ref_ptr<InfluenceMap> mInfluenceMap;
 
-        typedef std::pair<std::string, osg::Matrixf> BoneBindMatrixPair;
-
-        typedef std::pair<BoneBindMatrixPair, float> BoneWeight;
+        bool mGpuSkinning;
+        // Per vertex indices in mInfluenceMap and weights of up to 4 bones, shared between copies
+        osg::ref_ptr<osg::Vec4Array> mBoneIndices;
+        osg::ref_ptr<osg::Vec4Array> mBoneWeights;
 
-        typedef std::vector<unsigned short> VertexList;
-
-        typedef std::map<std::vector<BoneWeight>, VertexList> Bone2VertexMap;
-
-        struct Bone2VertexVector : public osg::Referenced
+        /// Vertices sharing the same bones and weights, stored in flat arrays to blend each set of bones only once.
+        struct VertexGroups : public osg::Referenced
         {
-            std::vector<std::pair<std::vector<BoneWeight>, VertexList>> mData;
+            // Bones and weights of group i are in range [mBoneOffsets[i], mBoneOffsets[i + 1])
+            std::vector<std::size_t> mBoneOffsets;
+            // Indices in InfluenceMap::mData
+            std::vector<unsigned short> mBones;
+            std::vector<float> mWeights;
+            // Vertices of group i are in range [mVertexOffsets[i], mVertexOffsets[i + 1])
+            std::vector<std::size_t> mVertexOffsets;
+            std::vector<unsigned short> mVertices;
         };
-        osg::ref_ptr<Bone2VertexVector> mBone2VertexVector;
+        osg::ref_ptr<VertexGroups> mVertexGroups;
 
         struct BoneSphereVector : public osg::Referenced
         {
@@ -99,13 +116,25 @@ namespace SceneUtil
         };
         osg::ref_ptr<BoneSphereVector> mBoneSphereVector;
         std::vector<Bone*> mBoneNodesVector;
+        // Inverse bind matrix * bone matrix * geometry to skeleton matrix for each bone of mInfluenceMap
+        std::vector<osg::Matrixf> mBoneMatrices;
 
         unsigned int mLastFrameNumber;
+        unsigned int mLastSkinnedUpdateNumber;
         bool mBoundsFirstFrame;
 
+        // Skeleton bone matrices versions used for the last skinning and bounds, 0 if not done yet
+        unsigned int mSkinnedBoneVersion;
+        unsigned int mBoundsBoneVersion;
+        bool mGeomToSkelMatrixChanged;
+
+        // Cameras may be culled in parallel, but the geometry must only be skinned once per frame
+        OpenThreads::Mutex mCullMutex;
+
         bool initFromParentSkeleton(osg::NodeVisitor* nv);
 
-        void updateGeomToSkelMatrix(const osg::NodePath& nodePath);
+        /// @return Whether the matrix changed.
+        bool updateGeomToSkelMatrix(const osg::NodePath& nodePath);
     };
 
 }
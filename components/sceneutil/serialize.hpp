@@ -7,6 +7,10 @@ namespace SceneUtil
     /// Register osg node serializers for certain SceneUtil classes if not already done so
     void registerSerializers();
 
+    /// Register serializers for the user data of loaded scenes if not already done so, so a scene can be written and
+    /// read back in full, e.g. by the scene disk cache. Unlike registerSerializers this keeps the osg::Geometry data.
+    void registerSceneSerializers();
+
 }
 
 #endif
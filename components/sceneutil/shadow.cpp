@@ -46,6 +46,8 @@ namespace SceneUtil
 
         mShadowTechnique->setSplitPointUniformLogarithmicRatio(Settings::Manager::getFloat("split point uniform logarithmic ratio", "Shadows"));
         mShadowTechnique->setSplitPointDeltaBias(Settings::Manager::getFloat("split point bias", "Shadows"));
+        mShadowTechnique->setDistantShadowMapUpdateInterval(std::max(0, Settings::Manager::getInt("distant shadow map update interval", "Shadows")));
+        mShadowTechnique->setCasterSmallFeatureCullingPixelSize(std::max(0.f, Settings::Manager::getFloat("caster small feature culling pixel size", "Shadows")));
 
         mShadowTechnique->setPolygonOffset(Settings::Manager::getFloat("polygon offset factor", "Shadows"), Settings::Manager::getFloat("polygon offset units", "Shadows"));
 
@@ -3,9 +3,25 @@
 #include <osg/Transform>
 #include <osg/MatrixTransform>
 
+#include <OpenThreads/ScopedLock>
+
 #include <components/debug/debuglog.hpp>
 #include <components/misc/stringops.hpp>
 
+#include <algorithm>
+
+namespace
+{
+    void collectBones(SceneUtil::Bone& bone, std::vector<SceneUtil::Bone*>& bones)
+    {
+        for (SceneUtil::Bone* child : bone.mChildren)
+        {
+            bones.push_back(child);
+            collectBones(*child, bones);
+        }
+    }
+}
+
 namespace SceneUtil
 {
 
@@ -34,10 +50,15 @@ private:
 
 Skeleton::Skeleton()
     : mBoneCacheInit(false)
+    , mBonesDirty(true)
+    , mBoneMatricesVersion(0)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(Active)
     , mLastFrameNumber(0)
     , mLastCullFrameNumber(0)
+    , mUpdateInterval(1)
+    , mUpdatePhase(0)
+    , mLastUpdateTraversalNumber(0)
 {
 
 }
@@ -45,10 +66,15 @@ Skeleton::Skeleton()
 Skeleton::Skeleton(const Skeleton &copy, const osg::CopyOp &copyop)
     : osg::Group(copy, copyop)
     , mBoneCacheInit(false)
+    , mBonesDirty(true)
+    , mBoneMatricesVersion(0)
     , mNeedToUpdateBoneMatrices(true)
     , mActive(copy.mActive)
     , mLastFrameNumber(0)
     , mLastCullFrameNumber(0)
+    , mUpdateInterval(1)
+    , mUpdatePhase(0)
+    , mLastUpdateTraversalNumber(0)
 {
 
 }
@@ -94,8 +120,11 @@ Bone* Skeleton::getBone(const std::string &name)
         if (!child)
         {
             child = new Bone;
+            if (bone != mRootBone.get())
+                child->mParent = bone;
             bone->mChildren.push_back(child);
             mNeedToUpdateBoneMatrices = true;
+            mBonesDirty = true;
         }
         bone = child;
 
@@ -105,8 +134,10 @@ Bone* Skeleton::getBone(const std::string &name)
     return bone;
 }
 
-void Skeleton::updateBoneMatrices(unsigned int traversalNumber)
+unsigned int Skeleton::updateBoneMatrices(unsigned int traversalNumber)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mBoneMatricesMutex);
+
     if (traversalNumber != mLastFrameNumber)
         mNeedToUpdateBoneMatrices = true;
 
@@ -114,14 +145,28 @@ void Skeleton::updateBoneMatrices(unsigned int traversalNumber)
 
     if (mNeedToUpdateBoneMatrices)
     {
-        if (mRootBone.get())
+        if (mBonesDirty)
         {
-            for (unsigned int i=0; i<mRootBone->mChildren.size(); ++i)
-                mRootBone->mChildren[i]->update(nullptr);
+            mBones.clear();
+            if (mRootBone.get())
+                collectBones(*mRootBone, mBones);
         }
 
+        // Most bones of idle or distant actors keep their matrices, comparing them is cheaper than recomputing
+        bool changed = mBonesDirty;
+        for (Bone* bone : mBones)
+        {
+            if (bone->update(mBonesDirty))
+                changed = true;
+        }
+        if (changed)
+            ++mBoneMatricesVersion;
+
+        mBonesDirty = false;
         mNeedToUpdateBoneMatrices = false;
     }
+
+    return mBoneMatricesVersion;
 }
 
 void Skeleton::setActive(ActiveType active)
@@ -134,11 +179,28 @@ bool Skeleton::getActive() const
     return mActive != Inactive;
 }
 
+void Skeleton::setUpdateInterval(unsigned int interval, unsigned int phase)
+{
+    mUpdateInterval = std::max(1u, interval);
+    mUpdatePhase = phase;
+}
+
+unsigned int Skeleton::getUpdateInterval() const
+{
+    return mUpdateInterval;
+}
+
+unsigned int Skeleton::getLastUpdateTraversalNumber() const
+{
+    return mLastUpdateTraversalNumber;
+}
+
 void Skeleton::markDirty()
 {
     mLastFrameNumber = 0;
     mBoneCache.clear();
     mBoneCacheInit = false;
+    mBonesDirty = true;
 }
 
 void Skeleton::traverse(osg::NodeVisitor& nv)
@@ -149,6 +211,10 @@ void Skeleton::traverse(osg::NodeVisitor& nv)
             return;
         if (mActive == SemiActive && mLastFrameNumber != 0 && mLastCullFrameNumber+3 <= nv.getTraversalNumber())
             return;
+        // The children are still traversed, attached parts and effects have update callbacks of their own.
+        // Only the skinned meshes wait for the next bone update.
+        if (mUpdateInterval <= 1 || mLastFrameNumber == 0 || (nv.getTraversalNumber() + mUpdatePhase) % mUpdateInterval == 0)
+            mLastUpdateTraversalNumber = nv.getTraversalNumber();
     }
     else if (nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR)
         mLastCullFrameNumber = nv.getTraversalNumber();
@@ -168,6 +234,8 @@ void Skeleton::childRemoved(unsigned int, unsigned int)
 
 Bone::Bone()
     : mNode(nullptr)
+    , mParent(nullptr)
+    , mChanged(true)
 {
 }
 
@@ -178,22 +246,26 @@ Bone::~Bone()
     mChildren.clear();
 }
 
-void Bone::update(const osg::Matrixf* parentMatrixInSkeletonSpace)
+bool Bone::update(bool force)
 {
+    mChanged = false;
     if (!mNode)
     {
         Log(Debug::Error) << "Error: Bone without node";
-        return;
+        return false;
     }
-    if (parentMatrixInSkeletonSpace)
-        mMatrixInSkeletonSpace = mNode->getMatrix() * (*parentMatrixInSkeletonSpace);
-    else
-        mMatrixInSkeletonSpace = mNode->getMatrix();
 
-    for (unsigned int i=0; i<mChildren.size(); ++i)
-    {
-        mChildren[i]->update(&mMatrixInSkeletonSpace);
-    }
+    const osg::Matrix& matrix = mNode->getMatrix();
+    if (!force && !(mParent && mParent->mChanged) && matrix == mLastMatrix)
+        return false;
+
+    mLastMatrix = matrix;
+    if (mParent)
+        mMatrixInSkeletonSpace = matrix * mParent->mMatrixInSkeletonSpace;
+    else
+        mMatrixInSkeletonSpace = matrix;
+    mChanged = true;
+    return true;
 }
 
 }
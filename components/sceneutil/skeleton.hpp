@@ -2,6 +2,9 @@
 #define OPENMW_COMPONENTS_NIFOSG_SKELETON_H
 
 #include <osg/Group>
+#include <osg/Matrix>
+
+#include <OpenThreads/Mutex>
 
 #include <memory>
 
@@ -20,12 +23,22 @@ namespace SceneUtil
 
         osg::MatrixTransform* mNode;
 
+        /// The parent bone, nullptr for the root bones of the skeleton.
+        Bone* mParent;
+
         std::vector<Bone*> mChildren;
 
-        /// Update the skeleton-space matrix of this bone and all its children.
-        void update(const osg::Matrixf* parentMatrixInSkeletonSpace);
+        /// Update the skeleton-space matrix of this bone if its node's matrix or the parent bone changed since the
+        /// last update. The parent must be updated first.
+        /// @param force Update regardless, e.g. after the hierarchy changed.
+        /// @return Whether the skeleton-space matrix was updated.
+        bool update(bool force);
 
     private:
+        // Matrix of mNode at the last update
+        osg::Matrix mLastMatrix;
+        bool mChanged;
+
         Bone(const Bone&);
         void operator=(const Bone&);
     };
@@ -45,7 +58,9 @@ namespace SceneUtil
         Bone* getBone(const std::string& name);
 
         /// Request an update of bone matrices. May be a no-op if already updated in this frame.
-        void updateBoneMatrices(unsigned int traversalNumber);
+        /// Only bones whose matrices or parent bones changed since the last update are recomputed.
+        /// @return Version of the bone matrices, which only changes when any bone matrix changed.
+        unsigned int updateBoneMatrices(unsigned int traversalNumber);
 
         enum ActiveType
         {
@@ -60,6 +75,16 @@ namespace SceneUtil
 
         bool getActive() const;
 
+        /// Update the bone matrices of the child rigs only once per \a interval frames, e.g. for distant actors.
+        /// The children are still traversed in every update traversal.
+        /// @param phase Offset added to the frame number to spread updates of different skeletons over frames.
+        void setUpdateInterval(unsigned int interval, unsigned int phase);
+
+        unsigned int getUpdateInterval() const;
+
+        /// Traversal number of the last update traversal in which the child rigs should update their bones.
+        unsigned int getLastUpdateTraversalNumber() const;
+
         void traverse(osg::NodeVisitor& nv);
 
         void markDirty();
@@ -76,12 +101,25 @@ namespace SceneUtil
         BoneCache mBoneCache;
         bool mBoneCacheInit;
 
+        // Bones of mRootBone in depth-first order, so a single pass updates parents before their children
+        std::vector<Bone*> mBones;
+        // The hierarchy changed, mBones needs to be rebuilt and all bones updated
+        bool mBonesDirty;
+        unsigned int mBoneMatricesVersion;
+
         bool mNeedToUpdateBoneMatrices;
 
         ActiveType mActive;
 
         unsigned int mLastFrameNumber;
         unsigned int mLastCullFrameNumber;
+
+        // Bone matrices are updated by the RigGeometries of the skeleton, which may be culled in parallel
+        OpenThreads::Mutex mBoneMatricesMutex;
+
+        unsigned int mUpdateInterval;
+        unsigned int mUpdatePhase;
+        unsigned int mLastUpdateTraversalNumber;
     };
 
 }
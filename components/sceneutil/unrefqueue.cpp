@@ -1,17 +1,41 @@
 #include "unrefqueue.hpp"
 
-//#include <osg/Timer>
+#include <osg/Timer>
 
-//#include <components/debug/debuglog.hpp>
+namespace
+{
+    // Time a work thread spends on unreferencing objects before it moves on to other items
+    const double sTimeBudget = 0.002;
+
+    // Fewer objects are kept in the queue for this many frames to be unreferenced together
+    const std::size_t sMinBatchSize = 32;
+    const unsigned int sMaxFramesKept = 4;
+}
 
 namespace SceneUtil
 {
     void UnrefWorkItem::doWork()
     {
-        mObjects.clear();
+        WorkThread* thread = WorkThread::getCurrent();
+        const osg::Timer_t start = osg::Timer::instance()->tick();
+
+        while (!mObjects.empty())
+        {
+            mObjects.pop_front();
+
+            if (thread && !mObjects.empty() && osg::Timer::instance()->delta_s(start, osg::Timer::instance()->tick()) >= sTimeBudget)
+            {
+                osg::ref_ptr<UnrefWorkItem> rest = new UnrefWorkItem;
+                rest->mObjects.swap(mObjects);
+                rest->setPriority(getPriority());
+                thread->getWorkQueue()->addWorkItem(rest);
+                return;
+            }
+        }
     }
 
     UnrefQueue::UnrefQueue()
+        : mNumFramesKept(0)
     {
         mWorkItem = new UnrefWorkItem;
     }
@@ -26,9 +50,13 @@ namespace SceneUtil
         if (mWorkItem->mObjects.empty())
             return;
 
+        if (mWorkItem->mObjects.size() < sMinBatchSize && ++mNumFramesKept < sMaxFramesKept)
+            return;
+
         workQueue->addWorkItem(mWorkItem, true);
 
         mWorkItem = new UnrefWorkItem;
+        mNumFramesKept = 0;
     }
 
     unsigned int UnrefQueue::getNumItems() const
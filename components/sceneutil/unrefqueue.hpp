@@ -16,11 +16,16 @@ namespace SceneUtil
     {
     public:
         std::deque<osg::ref_ptr<const osg::Referenced> > mObjects;
+
+        /// Unreferences objects until the time budget is used up, then queues the remaining ones in a new item
+        /// at the back of the queue, so other work isn't held up by unloading many objects at once.
         virtual void doWork();
     };
 
     /// @brief Handles unreferencing of objects through the WorkQueue. Typical use scenario
     /// would be the main thread pushing objects that are no longer needed, and the background thread deleting them.
+    /// @par Objects pushed over several frames are collected into one work item, unless there are many of them.
+    /// The GL objects of deleted drawables and textures are released by OSG in the draw thread within its own time budget.
     class UnrefQueue : public osg::Referenced
     {
     public:
@@ -30,13 +35,15 @@ namespace SceneUtil
         void push(const osg::Referenced* obj);
 
         /// Adds a WorkItem to the given WorkQueue that will clear the list of objects in a worker thread, thus unreferencing them.
-        /// Call from the main thread.
+        /// Objects may be kept for a few frames to be unreferenced along with the next ones. Call from the main thread once
+        /// per frame.
         void flush(SceneUtil::WorkQueue* workQueue);
 
         unsigned int getNumItems() const;
 
     private:
         osg::ref_ptr<UnrefWorkItem> mWorkItem;
+        unsigned int mNumFramesKept;
     };
 
 }
@@ -1,6 +1,9 @@
 #include "workqueue.hpp"
 
+#include <algorithm>
+
 #include <components/debug/debuglog.hpp>
+#include <components/debug/trace.hpp>
 
 namespace SceneUtil
 {
@@ -26,7 +29,31 @@ void WorkItem::signalDone()
     mCondition.broadcast();
 }
 
+void WorkItem::signalCancelled()
+{
+    mCancelled = true;
+    for (const osg::ref_ptr<WorkItem>& continuation : takeContinuations())
+        continuation->signalCancelled();
+    signalDone();
+}
+
+void WorkItem::addContinuation(osg::ref_ptr<WorkItem> item)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    mContinuations.push_back(item);
+}
+
+std::vector<osg::ref_ptr<WorkItem> > WorkItem::takeContinuations()
+{
+    std::vector<osg::ref_ptr<WorkItem> > continuations;
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+    continuations.swap(mContinuations);
+    return continuations;
+}
+
 WorkItem::WorkItem()
+    : mPriority(0.f)
+    , mCancelled(false)
 {
 }
 
@@ -39,12 +66,29 @@ bool WorkItem::isDone() const
     return (mDone > 0);
 }
 
+bool WorkItem::isCancelled() const
+{
+    return mCancelled;
+}
+
+void WorkItem::setPriority(float priority)
+{
+    mPriority = priority;
+}
+
+float WorkItem::getPriority() const
+{
+    return mPriority;
+}
+
 WorkQueue::WorkQueue(int workerThreads)
     : mIsReleased(false)
+    , mNumLocalItems(0)
+    , mNumAddedLocalItems(0)
 {
     for (int i=0; i<workerThreads; ++i)
     {
-        WorkThread* thread = new WorkThread(this);
+        WorkThread* thread = new WorkThread(this, i);
         mThreads.push_back(thread);
         thread->startThread();
     }
@@ -83,27 +127,175 @@ void WorkQueue::addWorkItem(osg::ref_ptr<WorkItem> item, bool front)
     mCondition.signal();
 }
 
-osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem()
+void WorkQueue::addSubtask(osg::ref_ptr<WorkItem> item)
 {
+    WorkThread* thread = WorkThread::getCurrent();
+    if (!thread || thread->getWorkQueue() != this)
+    {
+        addWorkItem(item);
+        return;
+    }
+
+    if (item->isDone())
+    {
+        Log(Debug::Error) << "Error: trying to add a work item that is already completed";
+        return;
+    }
+
+    // Counted before it is published, a thief taking it right away must not decrement the count below zero
+    ++mNumLocalItems;
+    thread->addLocalItem(item);
+
+    // Locked so that a thread about to wait can't miss the item
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    while (mQueue.empty() && !mIsReleased)
+    ++mNumAddedLocalItems;
+    mCondition.signal();
+}
+
+bool WorkQueue::cancelWorkItem(const osg::ref_ptr<WorkItem>& item)
+{
+    bool removed = false;
     {
-        mCondition.wait(&mMutex);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        std::deque<osg::ref_ptr<WorkItem> >::iterator it = std::find(mQueue.begin(), mQueue.end(), item);
+        if (it != mQueue.end())
+        {
+            mQueue.erase(it);
+            removed = true;
+        }
+    }
+
+    for (unsigned int i=0; i<mThreads.size() && !removed; ++i)
+    {
+        if (mThreads[i]->removeLocalItem(item.get()))
+        {
+            --mNumLocalItems;
+            removed = true;
+        }
     }
-    if (!mQueue.empty())
+
+    if (removed)
+        item->signalCancelled();
+    return removed;
+}
+
+void WorkQueue::waitTillDone(WorkItem& item)
+{
+    WorkThread* thread = WorkThread::getCurrent();
+    if (!thread || thread->getWorkQueue() != this)
     {
-        osg::ref_ptr<WorkItem> item = mQueue.front();
-        mQueue.pop_front();
-        return item;
+        item.waitTillDone();
+        return;
     }
-    else
+
+    // Only the queued subtasks are helped with, an item from the shared queue could take much longer than what we wait for
+    while (!item.isDone())
+    {
+        osg::ref_ptr<WorkItem> next = thread->takeLocalItem(false);
+        if (next)
+            --mNumLocalItems;
+        else
+            next = stealWorkItem(thread);
+
+        if (!next)
+        {
+            item.waitTillDone();
+            return;
+        }
+
+        thread->process(next);
+    }
+}
+
+osg::ref_ptr<WorkItem> WorkQueue::removeWorkItem(WorkThread* thread, bool wait)
+{
+    if (thread)
+    {
+        osg::ref_ptr<WorkItem> item = thread->takeLocalItem(false);
+        if (item)
+        {
+            --mNumLocalItems;
+            return item;
+        }
+    }
+
+    bool stealFailed = false;
+    // Value of mNumAddedLocalItems before stealing last failed
+    unsigned int stealFailedAt = 0;
+    while (true)
+    {
+        unsigned int numAddedLocalItems = 0;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            while (wait && mQueue.empty() && !mIsReleased
+                   && (mNumLocalItems == 0 || (stealFailed && mNumAddedLocalItems == stealFailedAt)))
+            {
+                mCondition.wait(&mMutex);
+            }
+            if (mIsReleased)
+                return nullptr;
+
+            if (!mQueue.empty())
+            {
+                // Priorities may change while items are queued, so the queue can't be kept sorted
+                std::deque<osg::ref_ptr<WorkItem> >::iterator next = mQueue.begin();
+                float nextPriority = (*next)->getPriority();
+                for (std::deque<osg::ref_ptr<WorkItem> >::iterator it = next + 1; it != mQueue.end(); ++it)
+                {
+                    const float priority = (*it)->getPriority();
+                    if (priority < nextPriority)
+                    {
+                        next = it;
+                        nextPriority = priority;
+                    }
+                }
+
+                osg::ref_ptr<WorkItem> item = *next;
+                mQueue.erase(next);
+                return item;
+            }
+
+            numAddedLocalItems = mNumAddedLocalItems;
+        }
+
+        osg::ref_ptr<WorkItem> item = stealWorkItem(thread);
+        if (item || !wait)
+            return item;
+
+        // The local items were taken by their own threads in the meantime, or are about to be published.
+        // Block until another one is added rather than polling the other threads.
+        stealFailed = true;
+        stealFailedAt = numAddedLocalItems;
+    }
+}
+
+osg::ref_ptr<WorkItem> WorkQueue::stealWorkItem(WorkThread* thread)
+{
+    if (mNumLocalItems == 0)
         return nullptr;
+
+    // Start with the next thread, so not all idle threads steal from the same one
+    const unsigned int start = thread ? thread->getIndex() + 1 : 0;
+    for (unsigned int i=0; i<mThreads.size(); ++i)
+    {
+        WorkThread* victim = mThreads[(start + i) % mThreads.size()];
+        if (victim == thread)
+            continue;
+
+        osg::ref_ptr<WorkItem> item = victim->takeLocalItem(true);
+        if (item)
+        {
+            --mNumLocalItems;
+            return item;
+        }
+    }
+    return nullptr;
 }
 
 unsigned int WorkQueue::getNumItems() const
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
-    return mQueue.size();
+    return mQueue.size() + mNumLocalItems;
 }
 
 unsigned int WorkQueue::getNumActiveThreads() const
@@ -117,24 +309,50 @@ unsigned int WorkQueue::getNumActiveThreads() const
     return count;
 }
 
-WorkThread::WorkThread(WorkQueue *workQueue)
+namespace
+{
+    thread_local WorkThread* sCurrentThread = nullptr;
+}
+
+WorkThread::WorkThread(WorkQueue *workQueue, unsigned int index)
     : mWorkQueue(workQueue)
+    , mIndex(index)
     , mActive(false)
 {
 }
 
 void WorkThread::run()
 {
+    Debug::Trace::setThreadName("WorkQueue");
+    sCurrentThread = this;
     while (true)
     {
-        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem();
+        osg::ref_ptr<WorkItem> item = mWorkQueue->removeWorkItem(this, true);
         if (!item)
             return;
-        mActive = true;
+        process(item);
+    }
+}
+
+WorkThread* WorkThread::getCurrent()
+{
+    return sCurrentThread;
+}
+
+void WorkThread::process(osg::ref_ptr<WorkItem> item)
+{
+    // May be nested when an item waits for its subtasks
+    const bool wasActive = mActive.exchange(true);
+    {
+        const Debug::TraceZone zone("WorkItem");
         item->doWork();
-        item->signalDone();
-        mActive = false;
     }
+
+    for (const osg::ref_ptr<WorkItem>& continuation : item->takeContinuations())
+        mWorkQueue->addSubtask(continuation);
+
+    item->signalDone();
+    mActive = wasActive;
 }
 
 bool WorkThread::isActive() const
@@ -142,4 +360,49 @@ bool WorkThread::isActive() const
     return mActive;
 }
 
+void WorkThread::addLocalItem(osg::ref_ptr<WorkItem> item)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLocalMutex);
+    mLocalQueue.push_back(item);
+}
+
+osg::ref_ptr<WorkItem> WorkThread::takeLocalItem(bool steal)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLocalMutex);
+    if (mLocalQueue.empty())
+        return nullptr;
+
+    // The owner takes the newest item, which is usually the subtask of the item it just processed,
+    // thieves take the oldest one
+    std::deque<osg::ref_ptr<WorkItem> >::iterator next = steal ? mLocalQueue.begin() : mLocalQueue.end() - 1;
+    float nextPriority = (*next)->getPriority();
+    for (std::deque<osg::ref_ptr<WorkItem> >::iterator it = mLocalQueue.begin(); it != mLocalQueue.end(); ++it)
+    {
+        const float priority = (*it)->getPriority();
+        if (priority < nextPriority || (!steal && priority == nextPriority && it > next))
+        {
+            next = it;
+            nextPriority = priority;
+        }
+    }
+
+    osg::ref_ptr<WorkItem> item = *next;
+    mLocalQueue.erase(next);
+    return item;
+}
+
+bool WorkThread::removeLocalItem(const WorkItem* item)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mLocalMutex);
+    for (std::deque<osg::ref_ptr<WorkItem> >::iterator it = mLocalQueue.begin(); it != mLocalQueue.end(); ++it)
+    {
+        if (it->get() == item)
+        {
+            mLocalQueue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
 }
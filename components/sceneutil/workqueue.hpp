@@ -11,6 +11,7 @@
 
 #include <atomic>
 #include <queue>
+#include <vector>
 
 namespace SceneUtil
 {
@@ -32,11 +33,34 @@ namespace SceneUtil
         /// Internal use by the WorkQueue.
         void signalDone();
 
+        /// Was the item removed from its queue by WorkQueue::cancelWorkItem() before it was processed?
+        /// Cancelled items are done, but doWork() was never called for them.
+        bool isCancelled() const;
+
+        /// Internal use by the WorkQueue.
+        void signalCancelled();
+
+        /// Add an item to be queued as a subtask on the thread that completes this item, once its doWork() returned.
+        /// Continuations of a cancelled item are cancelled as well.
+        /// @note Must be called before this item is added to a queue.
+        void addContinuation(osg::ref_ptr<WorkItem> item);
+
+        /// Internal use by the WorkQueue.
+        std::vector<osg::ref_ptr<WorkItem> > takeContinuations();
+
         /// Set abort flag in order to return from doWork() as soon as possible. May not be respected by all WorkItems.
         virtual void abort() {}
 
+        /// Items with a lower priority value are processed first, e.g. the estimated time in seconds until the result is needed.
+        /// Defaults to 0. May be changed at any time while the item is queued.
+        void setPriority(float priority);
+        float getPriority() const;
+
     protected:
+        std::atomic<float> mPriority;
         OpenThreads::Atomic mDone;
+        std::atomic<bool> mCancelled;
+        std::vector<osg::ref_ptr<WorkItem> > mContinuations;
         OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
     };
@@ -44,8 +68,11 @@ namespace SceneUtil
     class WorkThread;
 
     /// @brief A work queue that users can push work items onto, to be completed by one or more background threads.
-    /// @note Work items will be processed in the order that they were given in, however
+    /// @note Work items will be processed by priority, and in the order that they were given in for equal priorities, however
     /// if multiple work threads are involved then it is possible for a later item to complete before earlier items.
+    /// @par Besides the shared queue, each thread has its own queue for the subtasks and continuations added by the items it
+    /// processes. A thread works on its own queue before the shared one, and threads without work steal from the queues of
+    /// the others.
     class WorkQueue : public osg::Referenced
     {
     public:
@@ -57,10 +84,25 @@ namespace SceneUtil
         /// @param front If true, add item to the front of the queue. If false (default), add to the back.
         void addWorkItem(osg::ref_ptr<WorkItem> item, bool front=false);
 
-        /// Get the next work item from the front of the queue. If the queue is empty, waits until a new item is added.
+        /// Add a work item that the current work item depends on to the queue of the calling work thread, so it is processed
+        /// before any item of the shared queue. Idle threads may steal it. Same as addWorkItem() when not called by a work
+        /// thread of this queue.
+        void addSubtask(osg::ref_ptr<WorkItem> item);
+
+        /// Remove a work item that was not processed yet from the queue, and signal it as cancelled and done.
+        /// @return false if the item is not queued, e.g. because it is already being processed.
+        bool cancelWorkItem(const osg::ref_ptr<WorkItem>& item);
+
+        /// Wait until the work item is completed. When called by a work thread of this queue, e.g. to wait for the subtasks
+        /// of the current item, other queued items are processed in the meantime instead of blocking the thread.
+        void waitTillDone(WorkItem& item);
+
+        /// Get the next work item for the given thread: the thread's own queued item with the lowest priority value, else the
+        /// one of the shared queue closest to the front of the queue for equal priorities, else one stolen from another thread.
+        /// @param wait If nothing is queued, wait until a new item is added.
         /// If the workqueue is in the process of being destroyed, may return nullptr.
         /// @par Used internally by the WorkThread.
-        osg::ref_ptr<WorkItem> removeWorkItem();
+        osg::ref_ptr<WorkItem> removeWorkItem(WorkThread* thread, bool wait);
 
         unsigned int getNumItems() const;
 
@@ -69,6 +111,11 @@ namespace SceneUtil
     private:
         bool mIsReleased;
         std::deque<osg::ref_ptr<WorkItem> > mQueue;
+        std::atomic<unsigned int> mNumLocalItems;
+        /// Incremented for each item added to the queue of a thread, guarded by mMutex
+        unsigned int mNumAddedLocalItems;
+
+        osg::ref_ptr<WorkItem> stealWorkItem(WorkThread* thread);
 
         mutable OpenThreads::Mutex mMutex;
         OpenThreads::Condition mCondition;
@@ -80,15 +127,37 @@ namespace SceneUtil
     class WorkThread : public OpenThreads::Thread
     {
     public:
-        WorkThread(WorkQueue* workQueue);
+        WorkThread(WorkQueue* workQueue, unsigned int index);
 
         virtual void run();
 
         bool isActive() const;
 
+        /// @return the work thread running on the calling thread, nullptr if there is none.
+        static WorkThread* getCurrent();
+
+        WorkQueue* getWorkQueue() const { return mWorkQueue; }
+
+        unsigned int getIndex() const { return mIndex; }
+
+        /// Process one work item, including queueing its continuations.
+        void process(osg::ref_ptr<WorkItem> item);
+
+        void addLocalItem(osg::ref_ptr<WorkItem> item);
+
+        /// @param steal Taken by another thread, which prefers the oldest of the items with the lowest priority value
+        /// rather than the newest.
+        osg::ref_ptr<WorkItem> takeLocalItem(bool steal);
+
+        bool removeLocalItem(const WorkItem* item);
+
     private:
         WorkQueue* mWorkQueue;
+        unsigned int mIndex;
         std::atomic<bool> mActive;
+
+        mutable OpenThreads::Mutex mLocalMutex;
+        std::deque<osg::ref_ptr<WorkItem> > mLocalQueue;
     };
 
 
@@ -11,24 +11,28 @@ namespace Settings
 CategorySettingValueMap Manager::mDefaultSettings = CategorySettingValueMap();
 CategorySettingValueMap Manager::mUserSettings = CategorySettingValueMap();
 CategorySettingVector Manager::mChangedSettings = CategorySettingVector();
+unsigned int Manager::mRevision = 1;
 
 void Manager::clear()
 {
     mDefaultSettings.clear();
     mUserSettings.clear();
     mChangedSettings.clear();
+    ++mRevision;
 }
 
 void Manager::loadDefault(const std::string &file)
 {
     SettingsFileParser parser;
     parser.loadSettingsFile(file, mDefaultSettings);
+    ++mRevision;
 }
 
 void Manager::loadUser(const std::string &file)
 {
     SettingsFileParser parser;
     parser.loadSettingsFile(file, mUserSettings);
+    ++mRevision;
 }
 
 void Manager::saveUser(const std::string &file)
@@ -88,6 +92,7 @@ void Manager::setString(const std::string &setting, const std::string &category,
     }
 
     mUserSettings[key] = value;
+    ++mRevision;
 
     mChangedSettings.insert(key);
 }
@@ -49,6 +49,53 @@ namespace Settings
         static void setFloat (const std::string& setting, const std::string& category, const float value);
         static void setString (const std::string& setting, const std::string& category, const std::string& value);
         static void setBool (const std::string& setting, const std::string& category, const bool value);
+
+        static unsigned int getRevision() { return mRevision; }
+        ///< changes whenever a setting is loaded or changed
+
+    private:
+        static unsigned int mRevision;
+    };
+
+    ///
+    /// \brief Typed handle of a setting, for code that reads it often
+    ///
+    /// The value is parsed on first use and kept until any setting changes.
+    ///
+    template <class T>
+    class SettingValue
+    {
+    public:
+        SettingValue(const std::string& setting, const std::string& category)
+            : mSetting(setting)
+            , mCategory(category)
+            , mValue()
+            , mRevision(0)
+        {
+        }
+
+        const T& get() const
+        {
+            if (mRevision != Manager::getRevision())
+            {
+                read(mValue);
+                mRevision = Manager::getRevision();
+            }
+            return mValue;
+        }
+
+        operator const T&() const { return get(); }
+
+    private:
+        void read(int& value) const { value = Manager::getInt(mSetting, mCategory); }
+        void read(float& value) const { value = Manager::getFloat(mSetting, mCategory); }
+        void read(bool& value) const { value = Manager::getBool(mSetting, mCategory); }
+        void read(std::string& value) const { value = Manager::getString(mSetting, mCategory); }
+
+        std::string mSetting;
+        std::string mCategory;
+        mutable T mValue;
+        mutable unsigned int mRevision;
     };
 
 }
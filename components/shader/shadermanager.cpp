@@ -2,19 +2,47 @@
 
 #include <fstream>
 #include <algorithm>
+#include <cstdint>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 
+#include <osg/GLExtensions>
 #include <osg/Program>
+#include <osg/State>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <components/debug/debuglog.hpp>
+#include <components/misc/diskcache.hpp>
+#include <components/misc/keyhasher.hpp>
+
+namespace
+{
+    constexpr std::uint32_t sProgramBinaryVersion = 1;
+    const std::string sProgramBinaryExtension = ".bin";
+
+    std::string getGLString(GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? reinterpret_cast<const char*>(value) : std::string();
+    }
+}
 
 namespace Shader
 {
 
+    ShaderManager::ShaderManager()
+        : mProgramBinaryCacheMaxSize(0)
+        , mProgramBinaryCacheSize(0)
+        , mPrecompilePrograms(false)
+        , mDriverChecked(false)
+    {
+    }
+
     void ShaderManager::setShaderPath(const std::string &path)
     {
         mPath = path;
@@ -328,11 +356,26 @@ namespace Shader
             osg::ref_ptr<osg::Program> program (new osg::Program);
             program->addShader(vertexShader);
             program->addShader(fragmentShader);
+            bindVertexAttributes(*program);
             found = mPrograms.insert(std::make_pair(std::make_pair(vertexShader, fragmentShader), program)).first;
+            mNewPrograms.push_back(program);
         }
         return found->second;
     }
 
+    std::size_t ShaderManager::getNumPrograms()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        return mPrograms.size();
+    }
+
+    void ShaderManager::bindVertexAttributes(osg::Program& program)
+    {
+        program.addBindAttribLocation("boneIndices", BoneIndicesAttribute);
+        program.addBindAttribLocation("boneWeights", BoneWeightsAttribute);
+        program.addBindAttribLocation("morphVertexIndex", MorphVertexIndexAttribute);
+    }
+
     ShaderManager::DefineMap ShaderManager::getGlobalDefines()
     {
         return DefineMap(mGlobalDefines);
@@ -356,6 +399,192 @@ namespace Shader
                 continue;
             shader->setShaderSource(shaderSource);
         }
+
+        // Cached binaries were linked from the old sources, look them up again once the programs are linked anew
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        for (const auto& program : mPrograms)
+        {
+            program.second->setProgramBinary(nullptr);
+            mNewPrograms.push_back(program.second);
+        }
+    }
+
+    void ShaderManager::setProgramBinaryCachePath(const std::string& path, std::uint64_t maxSize)
+    {
+        mProgramBinaryCacheMaxSize = maxSize;
+
+        if (path.empty())
+        {
+            mProgramBinaryCachePath.clear();
+            return;
+        }
+
+        try
+        {
+            boost::filesystem::create_directories(path);
+            mProgramBinaryCachePath = path;
+            // Leave room for the programs linked in this session
+            mProgramBinaryCacheSize = Misc::pruneCacheDirectory(path, sProgramBinaryExtension, maxSize / 2);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Program binary cache is disabled: failed to create directory \""
+                << path << "\": " << e.what();
+        }
+    }
+
+    void ShaderManager::setPrecompilePrograms(bool enabled)
+    {
+        mPrecompilePrograms = enabled;
+    }
+
+    void ShaderManager::updatePrograms(osg::State& state)
+    {
+        if (!mDriverChecked)
+        {
+            mDriverChecked = true;
+            if (!mProgramBinaryCachePath.empty())
+            {
+                if (osg::GLExtensions::Get(state.getContextID(), true)->isGetProgramBinarySupported)
+                    mDriverKey = getGLString(GL_VENDOR) + '\n' + getGLString(GL_RENDERER) + '\n' + getGLString(GL_VERSION);
+                else
+                    Log(Debug::Info) << "Program binary cache is disabled: GL_ARB_get_program_binary is not supported";
+            }
+        }
+
+        std::vector<osg::ref_ptr<osg::Program> > newPrograms;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+            newPrograms.swap(mNewPrograms);
+        }
+
+        for (const auto& program : newPrograms)
+        {
+            // Binaries are stored even if one was loaded but the driver rejected it, so outdated files are replaced
+            const bool storeBinary = !mDriverKey.empty();
+            if (storeBinary && !program->getProgramBinary())
+            {
+                osg::ref_ptr<osg::Program::ProgramBinary> binary = readProgramBinary(makeProgramBinaryKey(*program));
+                if (binary)
+                    program->setProgramBinary(binary);
+            }
+            mTrackedPrograms.push_back({program, storeBinary, false});
+        }
+
+        const bool precompile = mPrecompilePrograms;
+        for (auto it = mTrackedPrograms.begin(); it != mTrackedPrograms.end();)
+        {
+            osg::Program::PerContextProgram* pcp = it->mProgram->getPCP(state);
+            if (!pcp->isLinked() && precompile && !it->mPrecompiled)
+            {
+                it->mProgram->compileGLObjects(state);
+                it->mPrecompiled = true;
+            }
+
+            // Not drawn yet, or failed to link
+            if (!pcp->isLinked())
+            {
+                ++it;
+                continue;
+            }
+
+            if (it->mStoreBinary && !pcp->loadedBinary())
+            {
+                osg::ref_ptr<osg::Program::ProgramBinary> binary = pcp->compileProgramBinary(state);
+                if (binary && binary->getSize() > 0)
+                    writeProgramBinary(makeProgramBinaryKey(*it->mProgram), *binary);
+            }
+            it = mTrackedPrograms.erase(it);
+        }
+    }
+
+    std::string ShaderManager::makeProgramBinaryKey(const osg::Program& program) const
+    {
+        Misc::KeyHasher hasher;
+        hasher.add(sProgramBinaryVersion);
+        hasher.add(mDriverKey);
+        for (unsigned int i = 0; i < program.getNumShaders(); ++i)
+        {
+            const osg::Shader* shader = program.getShader(i);
+            hasher.add(static_cast<int>(shader->getType()));
+            hasher.add(shader->getShaderSource());
+        }
+        for (const auto& binding : program.getAttribBindingList())
+        {
+            hasher.add(binding.first);
+            hasher.add(binding.second);
+        }
+        return hasher.getKey();
+    }
+
+    osg::ref_ptr<osg::Program::ProgramBinary> ShaderManager::readProgramBinary(const std::string& key) const
+    {
+        const boost::filesystem::path filePath = boost::filesystem::path(mProgramBinaryCachePath) / (key + sProgramBinaryExtension);
+        boost::filesystem::ifstream file(filePath, std::ios::binary);
+        if (!file)
+            return nullptr;
+
+        std::uint32_t format = 0;
+        file.read(reinterpret_cast<char*>(&format), sizeof(format));
+        const std::streamoff start = file.tellg();
+        file.seekg(0, std::ios::end);
+        const std::streamoff size = file.tellg() - start;
+        file.seekg(start);
+        if (!file || size <= 0)
+            return nullptr;
+
+        osg::ref_ptr<osg::Program::ProgramBinary> binary (new osg::Program::ProgramBinary);
+        binary->allocate(static_cast<unsigned int>(size));
+        binary->setFormat(format);
+        file.read(reinterpret_cast<char*>(binary->getData()), size);
+        if (!file)
+            return nullptr;
+        Misc::touchCacheFile(filePath);
+        return binary;
+    }
+
+    void ShaderManager::writeProgramBinary(const std::string& key, const osg::Program::ProgramBinary& binary) const
+    {
+        if (mProgramBinaryCacheSize >= mProgramBinaryCacheMaxSize)
+            return;
+
+        const boost::filesystem::path filePath = boost::filesystem::path(mProgramBinaryCachePath) / (key + sProgramBinaryExtension);
+
+        // Write to a temporary file first so another process never reads a partially written binary
+        std::ostringstream tmpFileName;
+        tmpFileName << key << sProgramBinaryExtension << '.' << std::this_thread::get_id() << ".tmp";
+        const boost::filesystem::path tmpFilePath = boost::filesystem::path(mProgramBinaryCachePath) / tmpFileName.str();
+
+        std::uint64_t fileSize = 0;
+        try
+        {
+            {
+                boost::filesystem::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+                const std::uint32_t format = binary.getFormat();
+                file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+                file.write(reinterpret_cast<const char*>(binary.getData()), binary.getSize());
+                if (!file)
+                    throw std::runtime_error("write error");
+            }
+
+            fileSize = boost::filesystem::file_size(tmpFilePath);
+            if (mProgramBinaryCacheSize.fetch_add(fileSize) + fileSize > mProgramBinaryCacheMaxSize)
+            {
+                mProgramBinaryCacheSize -= fileSize;
+                boost::system::error_code ec;
+                boost::filesystem::remove(tmpFilePath, ec);
+                return;
+            }
+
+            boost::filesystem::rename(tmpFilePath, filePath);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to write program binary " << filePath << ": " << e.what();
+            mProgramBinaryCacheSize -= fileSize;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpFilePath, ec);
+        }
     }
 
     void ShaderManager::releaseGLObjects(osg::State *state)
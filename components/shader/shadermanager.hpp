@@ -1,11 +1,15 @@
 #ifndef OPENMW_COMPONENTS_SHADERMANAGER_H
 #define OPENMW_COMPONENTS_SHADERMANAGER_H
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <map>
+#include <vector>
 
 #include <osg/ref_ptr>
 
+#include <osg/Program>
 #include <osg/Shader>
 
 #include <osgViewer/Viewer>
@@ -20,10 +24,24 @@ namespace Shader
     class ShaderManager
     {
     public:
+        ShaderManager();
+
         void setShaderPath(const std::string& path);
 
         typedef std::map<std::string, std::string> DefineMap;
 
+        /// Generic vertex attribute locations of the per vertex data used by skinning_vertex.glsl and morphing_vertex.glsl.
+        /// @note Locations 1, 6 and 7 are not aliased with fixed function attributes in use on any known driver.
+        enum VertexAttribute
+        {
+            MorphVertexIndexAttribute = 1,
+            BoneIndicesAttribute = 6,
+            BoneWeightsAttribute = 7
+        };
+
+        /// Bind the attributes of skinning_vertex.glsl and morphing_vertex.glsl to their locations.
+        static void bindVertexAttributes(osg::Program& program);
+
         /// Create or retrieve a shader instance.
         /// @param shaderTemplate The filename of the shader template.
         /// @param defines Define values that can be retrieved by the shader template.
@@ -42,9 +60,42 @@ namespace Shader
         /// @note This will change the source code for any shaders already created, potentially causing problems if they're being used to render a frame. It is recommended that any associated Viewers have their threading stopped while this function is running if any shaders are in use.
         void setGlobalDefines(DefineMap & globalDefines);
 
+        /// Store the binaries of linked programs in \a path and load them on next runs instead of linking the shaders
+        /// again, if the driver supports GL_ARB_get_program_binary. An empty path disables the cache.
+        /// @note Binaries are named by a hash of the shader sources and the driver version, so changed shaders or
+        ///  drivers only cause the affected programs to be linked again.
+        /// @param maxSize Limit of the total size of the stored binaries in bytes. The least recently used ones, e.g.
+        ///  those of old drivers, are removed until the rest take at most half of it; once the limit is reached no
+        ///  more binaries are stored.
+        void setProgramBinaryCachePath(const std::string& path, std::uint64_t maxSize);
+
+        /// Link all programs that were created but not drawn yet on the next calls to updatePrograms,
+        /// e.g. while a loading screen hides the scene.
+        void setPrecompilePrograms(bool enabled);
+
+        /// Load the cached binaries of new programs, store the binaries of newly linked programs and link programs
+        /// ahead of drawing if enabled by setPrecompilePrograms.
+        /// @note Call from the draw thread before drawing, with the graphics context current.
+        void updatePrograms(osg::State& state);
+
         void releaseGLObjects(osg::State* state);
 
+        /// Number of programs created since the manager was created.
+        /// @note Thread safe.
+        std::size_t getNumPrograms();
+
     private:
+        struct TrackedProgram
+        {
+            osg::ref_ptr<osg::Program> mProgram;
+            bool mStoreBinary;
+            bool mPrecompiled;
+        };
+
+        std::string makeProgramBinaryKey(const osg::Program& program) const;
+        osg::ref_ptr<osg::Program::ProgramBinary> readProgramBinary(const std::string& key) const;
+        void writeProgramBinary(const std::string& key, const osg::Program::ProgramBinary& binary) const;
+
         std::string mPath;
 
         DefineMap mGlobalDefines;
@@ -60,6 +111,19 @@ namespace Shader
         typedef std::map<std::pair<osg::ref_ptr<osg::Shader>, osg::ref_ptr<osg::Shader> >, osg::ref_ptr<osg::Program> > ProgramMap;
         ProgramMap mPrograms;
 
+        // Programs created since the last updatePrograms, guarded by mMutex
+        std::vector<osg::ref_ptr<osg::Program> > mNewPrograms;
+
+        std::string mProgramBinaryCachePath;
+        std::uint64_t mProgramBinaryCacheMaxSize;
+        mutable std::atomic<std::uint64_t> mProgramBinaryCacheSize;
+        std::atomic<bool> mPrecompilePrograms;
+
+        // Used by the draw thread only
+        std::vector<TrackedProgram> mTrackedPrograms;
+        std::string mDriverKey;
+        bool mDriverChecked;
+
         OpenThreads::Mutex mMutex;
     };
 
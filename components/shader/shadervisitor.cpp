@@ -40,6 +40,9 @@ namespace Shader
         , mAllowedToModifyStateSets(true)
         , mAutoUseNormalMaps(false)
         , mAutoUseSpecularMaps(false)
+        , mGpuSkinning(false)
+        , mGpuMorphing(false)
+        , mReducedPermutations(false)
         , mShaderManager(shaderManager)
         , mImageManager(imageManager)
         , mDefaultVsTemplate(defaultVsTemplate)
@@ -85,6 +88,16 @@ namespace Shader
         return false;
     }
 
+    // Maps selected by uniforms in every program with reduced permutations
+    const char* uniformTextures[] = { "emissiveMap", "darkMap", "detailMap", "decalMap" };
+    bool isUniformTexture(const std::string& name)
+    {
+        for (unsigned int i=0; i<sizeof(uniformTextures)/sizeof(uniformTextures[0]); ++i)
+            if (name == uniformTextures[i])
+                return true;
+        return false;
+    }
+
     void ShaderVisitor::applyStateSet(osg::ref_ptr<osg::StateSet> stateset, osg::Node& node)
     {
         osg::StateSet* writableStateSet = nullptr;
@@ -148,7 +161,7 @@ namespace Shader
                 boost::replace_last(normalHeightMap, ".", mNormalHeightMapPattern + ".");
                 if (mImageManager.getVFS()->exists(normalHeightMap))
                 {
-                    image = mImageManager.getImage(normalHeightMap);
+                    image = mImageManager.getImage(normalHeightMap, true);
                     normalHeight = true;
                 }
                 else
@@ -156,7 +169,7 @@ namespace Shader
                     boost::replace_last(normalMapFileName, ".", mNormalMapPattern + ".");
                     if (mImageManager.getVFS()->exists(normalMapFileName))
                     {
-                        image = mImageManager.getImage(normalMapFileName);
+                        image = mImageManager.getImage(normalMapFileName, true);
                     }
                 }
 
@@ -187,7 +200,7 @@ namespace Shader
                 boost::replace_last(specularMapFileName, ".", mSpecularMapPattern + ".");
                 if (mImageManager.getVFS()->exists(specularMapFileName))
                 {
-                    osg::ref_ptr<osg::Image> image (mImageManager.getImage(specularMapFileName));
+                    osg::ref_ptr<osg::Image> image (mImageManager.getImage(specularMapFileName, true));
                     osg::ref_ptr<osg::Texture2D> specularMapTex (new osg::Texture2D(image));
                     specularMapTex->setTextureSize(image->s(), image->t());
                     specularMapTex->setWrap(osg::Texture::WRAP_S, diffuseMap->getWrap(osg::Texture::WRAP_S));
@@ -288,6 +301,32 @@ namespace Shader
             defineMap[texIt->second + std::string("UV")] = std::to_string(texIt->first);
         }
 
+        if (mReducedPermutations)
+        {
+            std::map<std::string, int> texUnits;
+            for (std::map<int, std::string>::const_iterator texIt = reqs.mTextures.begin(); texIt != reqs.mTextures.end(); ++texIt)
+                texUnits[texIt->second] = texIt->first;
+
+            // The texture coordinate sets are read from uniforms named by the UV defines, -1 disables a map.
+            // Environment maps use generated coordinates.
+            for (unsigned int i=0; i<sizeof(defaultTextures)/sizeof(defaultTextures[0]); ++i)
+            {
+                const std::string name = defaultTextures[i];
+                if (name == "envMap")
+                    continue;
+                if (isUniformTexture(name))
+                    defineMap[name] = "1";
+                const std::string uvSet = name + "UVSet";
+                defineMap[name + "UV"] = uvSet;
+                if (defineMap[name] == "1")
+                {
+                    std::map<std::string, int>::const_iterator found = texUnits.find(name);
+                    writableStateSet->addUniform(new osg::Uniform(uvSet.c_str(), found != texUnits.end() ? found->second : -1));
+                }
+            }
+        }
+        defineMap["reducedPermutations"] = mReducedPermutations ? "1" : "0";
+
         defineMap["parallax"] = reqs.mNormalHeight ? "1" : "0";
 
         writableStateSet->addUniform(new osg::Uniform("colorMode", reqs.mColorMode));
@@ -379,12 +418,16 @@ namespace Shader
                 osg::ref_ptr<osg::Geometry> sourceGeometry = rig->getSourceGeometry();
                 if (sourceGeometry && adjustGeometry(*sourceGeometry, reqs))
                     rig->setSourceGeometry(sourceGeometry);
+                if (mGpuSkinning && mAllowedToModifyStateSets && (reqs.mShaderRequired || mForceShaders))
+                    rig->setGpuSkinning(true);
             }
             else if (auto morph = dynamic_cast<SceneUtil::MorphGeometry*>(&drawable))
             {
                 osg::ref_ptr<osg::Geometry> sourceGeometry = morph->getSourceGeometry();
                 if (sourceGeometry && adjustGeometry(*sourceGeometry, reqs))
                     morph->setSourceGeometry(sourceGeometry);
+                if (mGpuMorphing && mAllowedToModifyStateSets && (reqs.mShaderRequired || mForceShaders))
+                    morph->setGpuMorphing(true);
             }
         }
 
@@ -422,4 +465,19 @@ namespace Shader
         mSpecularMapPattern = pattern;
     }
 
+    void ShaderVisitor::setGpuSkinning(bool enabled)
+    {
+        mGpuSkinning = enabled;
+    }
+
+    void ShaderVisitor::setGpuMorphing(bool enabled)
+    {
+        mGpuMorphing = enabled;
+    }
+
+    void ShaderVisitor::setReducedPermutations(bool enabled)
+    {
+        mReducedPermutations = enabled;
+    }
+
 }
@@ -38,6 +38,19 @@ namespace Shader
 
         void setSpecularMapPattern(const std::string& pattern);
 
+        /// Let RigGeometry with shaders do skinning in the vertex shader instead of on the CPU.
+        void setGpuSkinning(bool enabled);
+
+        /// Let MorphGeometry with shaders do morphing in the vertex shader instead of on the CPU.
+        void setGpuMorphing(bool enabled);
+
+        /// Always compile the code of the rarely used dark, detail, decal and emissive maps into the object shaders,
+        /// and select the maps and the texture coordinate sets of all maps with uniforms instead of defines.
+        /// @par Gives a small set of programs that depends only on the presence of the diffuse, normal, specular
+        /// and environment maps, at the cost of a few uniform branches per fragment.
+        /// So fewer programs are linked and switched between while drawing.
+        void setReducedPermutations(bool enabled);
+
         virtual void apply(osg::Node& node);
 
         virtual void apply(osg::Drawable& drawable);
@@ -59,6 +72,10 @@ namespace Shader
         bool mAutoUseSpecularMaps;
         std::string mSpecularMapPattern;
 
+        bool mGpuSkinning;
+        bool mGpuMorphing;
+        bool mReducedPermutations;
+
         ShaderManager& mShaderManager;
         Resource::ImageManager& mImageManager;
 
@@ -1,5 +1,8 @@
 #include "chunkmanager.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
 #include <osg/Texture2D>
@@ -11,12 +14,137 @@
 
 #include <components/sceneutil/positionattitudetransform.hpp>
 #include <components/sceneutil/lightmanager.hpp>
+#include <components/sceneutil/memoryusage.hpp>
 
 #include "terraindrawable.hpp"
 #include "material.hpp"
 #include "storage.hpp"
 #include "texturemanager.hpp"
 #include "compositemaprenderer.hpp"
+#include "compositemapdiskcache.hpp"
+
+namespace
+{
+    /// Quantizes positions to 16 bit integers relative to the chunk. The scale is the same on all axes,
+    /// so normals are still transformed correctly, only their length changes.
+    /// @param offsetZ set to the height the quantized positions are relative to
+    /// @param scale set to the scale to apply to the quantized positions
+    osg::ref_ptr<osg::Vec4sArray> quantizePositions(const osg::Vec3Array& positions, float& offsetZ, float& scale)
+    {
+        osg::BoundingBox bounds;
+        for (const osg::Vec3f& position : positions)
+            bounds.expandBy(position);
+
+        offsetZ = bounds.center().z();
+        const float extent = std::max({bounds.xMax(), -bounds.xMin(), bounds.yMax(), -bounds.yMin(), bounds.zMax() - offsetZ});
+        scale = std::max(extent / std::numeric_limits<short>::max(), std::numeric_limits<float>::min());
+
+        osg::ref_ptr<osg::Vec4sArray> result (new osg::Vec4sArray(positions.size()));
+        for (std::size_t i = 0; i < positions.size(); ++i)
+        {
+            const osg::Vec3f& position = positions[i];
+            (*result)[i] = osg::Vec4s(static_cast<short>(std::round(position.x() / scale)),
+                                      static_cast<short>(std::round(position.y() / scale)),
+                                      static_cast<short>(std::round((position.z() - offsetZ) / scale)), 1);
+        }
+        return result;
+    }
+
+    osg::ref_ptr<osg::Vec3bArray> quantizeNormals(const osg::Vec3Array& normals)
+    {
+        osg::ref_ptr<osg::Vec3bArray> result (new osg::Vec3bArray(normals.size()));
+        for (std::size_t i = 0; i < normals.size(); ++i)
+        {
+            const osg::Vec3f& normal = normals[i];
+            (*result)[i] = osg::Vec3b(static_cast<signed char>(std::round(normal.x() * 127.f)),
+                                      static_cast<signed char>(std::round(normal.y() * 127.f)),
+                                      static_cast<signed char>(std::round(normal.z() * 127.f)));
+        }
+        result->setNormalize(true);
+        return result;
+    }
+
+    // Sampled by heightmap_vertex.glsl, after the units of shadows, GPU morphing and clustered lighting
+    const unsigned int sHeightmapTextureUnit = 11;
+
+    osg::ref_ptr<osg::Texture2D> createHeightmapTexture(osg::Image* image, bool unrefImageData)
+    {
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D(image));
+        texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::NEAREST);
+        texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::NEAREST);
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        // Texels have to match the vertex grid
+        texture->setResizeNonPowerOfTwoHint(false);
+        texture->setUnRefImageDataAfterApply(unrefImageData);
+        return texture;
+    }
+
+    /// Moves the vertex data of a chunk into textures for heightmap_vertex.glsl, in the layout of BufferCache::getUVBuffer.
+    /// @param heights Set to the heights, which are kept on the CPU for bounds and intersections
+    osg::ref_ptr<osg::StateSet> createHeightmapStateSet(const osg::Vec3Array& positions, const osg::Vec3Array& normals, const osg::Vec4ubArray& colors,
+                                                        unsigned int numVerts, float chunkWorldSize, osg::ref_ptr<osg::Image>& heights)
+    {
+        heights = new osg::Image;
+        heights->allocateImage(numVerts, numVerts, 1, GL_LUMINANCE, GL_FLOAT);
+        heights->setInternalTextureFormat(GL_LUMINANCE32F_ARB);
+        osg::ref_ptr<osg::Image> normalImage (new osg::Image);
+        normalImage->allocateImage(numVerts, numVerts, 1, GL_RGB, GL_UNSIGNED_BYTE);
+        osg::ref_ptr<osg::Image> colorImage (new osg::Image);
+        colorImage->allocateImage(numVerts, numVerts, 1, GL_RGB, GL_UNSIGNED_BYTE);
+
+        for (unsigned int col = 0; col < numVerts; ++col)
+        {
+            for (unsigned int row = 0; row < numVerts; ++row)
+            {
+                const unsigned int vertex = col * numVerts + row;
+                const unsigned int t = numVerts - 1 - row;
+
+                *reinterpret_cast<float*>(heights->data(col, t)) = positions[vertex].z();
+
+                unsigned char* normal = normalImage->data(col, t);
+                for (int i = 0; i < 3; ++i)
+                    normal[i] = static_cast<unsigned char>(std::round((normals[vertex][i] * 0.5f + 0.5f) * 255.f));
+
+                unsigned char* color = colorImage->data(col, t);
+                for (int i = 0; i < 3; ++i)
+                    color[i] = colors[vertex][i];
+            }
+        }
+
+        osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
+        // No texture modes, the textures are only sampled by the vertex shader
+        stateset->setTextureAttribute(sHeightmapTextureUnit, createHeightmapTexture(heights, false));
+        stateset->setTextureAttribute(sHeightmapTextureUnit + 1, createHeightmapTexture(normalImage, true));
+        stateset->setTextureAttribute(sHeightmapTextureUnit + 2, createHeightmapTexture(colorImage, true));
+        stateset->addUniform(new osg::Uniform("heightmap", static_cast<int>(sHeightmapTextureUnit)));
+        stateset->addUniform(new osg::Uniform("heightmapNormals", static_cast<int>(sHeightmapTextureUnit + 1)));
+        stateset->addUniform(new osg::Uniform("heightmapColors", static_cast<int>(sHeightmapTextureUnit + 2)));
+        stateset->addUniform(new osg::Uniform("heightmapChunkSize", chunkWorldSize));
+        stateset->addUniform(new osg::Uniform("heightmapCoordScale", osg::Vec2f((numVerts - 1.f) / numVerts, 0.5f / numVerts)));
+        stateset->addUniform(new osg::Uniform("heightmapEnabled", true));
+        return stateset;
+    }
+
+    class RescaleNormalStateSet
+    {
+    public:
+        static const osg::ref_ptr<osg::StateSet>& value()
+        {
+            static RescaleNormalStateSet instance;
+            return instance.mValue;
+        }
+
+    private:
+        osg::ref_ptr<osg::StateSet> mValue;
+
+        RescaleNormalStateSet()
+            : mValue(new osg::StateSet)
+        {
+            mValue->setMode(GL_RESCALE_NORMAL, osg::StateAttribute::ON);
+        }
+    };
+}
 
 namespace Terrain
 {
@@ -30,6 +158,9 @@ ChunkManager::ChunkManager(Storage *storage, Resource::SceneManager *sceneMgr, T
     , mCompositeMapSize(512)
     , mCompositeMapLevel(1.f)
     , mMaxCompGeometrySize(1.f)
+    , mPackBlendmaps(false)
+    , mCompactVertices(false)
+    , mGpuDisplacement(false)
 {
 
 }
@@ -43,11 +174,25 @@ osg::ref_ptr<osg::Node> ChunkManager::getChunk(float size, const osg::Vec2f &cen
     else
     {
         osg::ref_ptr<osg::Node> node = createChunk(size, center, lod, lodFlags);
-        mCache->addEntryToObjectCache(id, node.get());
+        // Includes the buffers shared between chunks, so this is an upper bound
+        mCache->addEntryToObjectCache(id, node.get(), 0.0, SceneUtil::estimateGeometryMemory(*node));
         return node;
     }
 }
 
+osg::ref_ptr<osg::Node> ChunkManager::getCachedChunk(const osg::Vec2f &center, unsigned char lod, unsigned int lodFlags)
+{
+    osg::ref_ptr<osg::Object> obj = mCache->getRefFromObjectCache(std::make_tuple(center, lod, lodFlags));
+    if (obj)
+        return obj->asNode();
+    return nullptr;
+}
+
+void ChunkManager::setCompositeMapDiskCache(CompositeMapDiskCache* diskCache)
+{
+    mCompositeMapDiskCache = diskCache;
+}
+
 void ChunkManager::reportStats(unsigned int frameNumber, osg::Stats *stats) const
 {
     stats->setAttribute(frameNumber, "Terrain Chunk", mCache->getCacheSize());
@@ -80,23 +225,60 @@ osg::ref_ptr<osg::Texture2D> ChunkManager::createCompositeMapRTT()
     return texture;
 }
 
-void ChunkManager::createCompositeMapGeometry(float chunkSize, const osg::Vec2f& chunkCenter, const osg::Vec4f& texCoords, CompositeMap& compositeMap)
+osg::ref_ptr<osg::Texture2D> ChunkManager::getCachedCompositeMap(float chunkSize, const osg::Vec2f& chunkCenter,
+                                                                 const std::vector<CompositeMapPart>& parts, std::string& key)
+{
+    if (!mCompositeMapDiskCache || !mCompositeMapDiskCache->isEnabled())
+        return nullptr;
+
+    key = CompositeMapDiskCache::makeKey(chunkSize, chunkCenter, mCompositeMapSize, parts);
+    osg::ref_ptr<osg::Image> image = mCompositeMapDiskCache->get(key);
+    if (!image || image->s() != static_cast<int>(mCompositeMapSize) || image->t() != static_cast<int>(mCompositeMapSize))
+        return nullptr;
+
+    key.clear();
+
+    osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image);
+    texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+    texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+    texture->setUnRefImageDataAfterApply(true);
+    return texture;
+}
+
+void ChunkManager::collectCompositeMapParts(float chunkSize, const osg::Vec2f& chunkCenter, const osg::Vec4f& texCoords,
+                                            std::vector<CompositeMapPart>& parts)
 {
     if (chunkSize > mMaxCompGeometrySize)
     {
-        createCompositeMapGeometry(chunkSize/2.f, chunkCenter + osg::Vec2f(chunkSize/4.f, chunkSize/4.f), osg::Vec4f(texCoords.x() + texCoords.z()/2.f, texCoords.y(), texCoords.z()/2.f, texCoords.w()/2.f), compositeMap);
-        createCompositeMapGeometry(chunkSize/2.f, chunkCenter + osg::Vec2f(-chunkSize/4.f, chunkSize/4.f), osg::Vec4f(texCoords.x(), texCoords.y(), texCoords.z()/2.f, texCoords.w()/2.f), compositeMap);
-        createCompositeMapGeometry(chunkSize/2.f, chunkCenter + osg::Vec2f(chunkSize/4.f, -chunkSize/4.f), osg::Vec4f(texCoords.x() + texCoords.z()/2.f, texCoords.y()+texCoords.w()/2.f, texCoords.z()/2.f, texCoords.w()/2.f), compositeMap);
-        createCompositeMapGeometry(chunkSize/2.f, chunkCenter + osg::Vec2f(-chunkSize/4.f, -chunkSize/4.f), osg::Vec4f(texCoords.x(), texCoords.y()+texCoords.w()/2.f, texCoords.z()/2.f, texCoords.w()/2.f), compositeMap);
+        collectCompositeMapParts(chunkSize/2.f, chunkCenter + osg::Vec2f(chunkSize/4.f, chunkSize/4.f), osg::Vec4f(texCoords.x() + texCoords.z()/2.f, texCoords.y(), texCoords.z()/2.f, texCoords.w()/2.f), parts);
+        collectCompositeMapParts(chunkSize/2.f, chunkCenter + osg::Vec2f(-chunkSize/4.f, chunkSize/4.f), osg::Vec4f(texCoords.x(), texCoords.y(), texCoords.z()/2.f, texCoords.w()/2.f), parts);
+        collectCompositeMapParts(chunkSize/2.f, chunkCenter + osg::Vec2f(chunkSize/4.f, -chunkSize/4.f), osg::Vec4f(texCoords.x() + texCoords.z()/2.f, texCoords.y()+texCoords.w()/2.f, texCoords.z()/2.f, texCoords.w()/2.f), parts);
+        collectCompositeMapParts(chunkSize/2.f, chunkCenter + osg::Vec2f(-chunkSize/4.f, -chunkSize/4.f), osg::Vec4f(texCoords.x(), texCoords.y()+texCoords.w()/2.f, texCoords.z()/2.f, texCoords.w()/2.f), parts);
     }
     else
     {
+        CompositeMapPart part;
+        part.mChunkSize = chunkSize;
+        part.mChunkCenter = chunkCenter;
+        part.mTexCoords = texCoords;
+        mStorage->getBlendmaps(chunkSize, chunkCenter, part.mBlendmaps, part.mLayers);
+        parts.push_back(std::move(part));
+    }
+}
+
+void ChunkManager::createCompositeMapGeometry(const std::vector<CompositeMapPart>& parts, CompositeMap& compositeMap)
+{
+    for (const CompositeMapPart& part : parts)
+    {
+        const osg::Vec4f& texCoords = part.mTexCoords;
         float left = texCoords.x()*2.f-1;
         float top = texCoords.y()*2.f-1;
         float width = texCoords.z()*2.f;
         float height = texCoords.w()*2.f;
 
-        std::vector<osg::ref_ptr<osg::StateSet> > passes = createPasses(chunkSize, chunkCenter, true);
+        std::vector<osg::ref_ptr<osg::StateSet> > passes = createPasses(part.mChunkSize, part.mLayers, part.mBlendmaps, true);
         for (std::vector<osg::ref_ptr<osg::StateSet> >::iterator it = passes.begin(); it != passes.end(); ++it)
         {
             osg::ref_ptr<osg::Geometry> geom = osg::createTexturedQuadGeometry(osg::Vec3(left,top,0), osg::Vec3(width,0,0), osg::Vec3(0,height,0));
@@ -111,12 +293,9 @@ void ChunkManager::createCompositeMapGeometry(float chunkSize, const osg::Vec2f&
     }
 }
 
-std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunkSize, const osg::Vec2f &chunkCenter, bool forCompositeMap)
+std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunkSize, const std::vector<LayerInfo>& layerList,
+                                                                     const std::vector<osg::ref_ptr<osg::Image> >& blendmaps, bool forCompositeMap)
 {
-    std::vector<LayerInfo> layerList;
-    std::vector<osg::ref_ptr<osg::Image> > blendmaps;
-    mStorage->getBlendmaps(chunkSize, chunkCenter, blendmaps, layerList);
-
     bool useShaders = mSceneManager->getForceShaders();
     if (!mSceneManager->getClampLighting())
         useShaders = true; // always use shaders when lighting is unclamped, this is to avoid lighting seams between a terrain chunk with normal maps and one without normal maps
@@ -141,21 +320,20 @@ std::vector<osg::ref_ptr<osg::StateSet> > ChunkManager::createPasses(float chunk
         }
     }
 
+    if (mGpuDisplacement)
+        useShaders = true;
+
     if (forCompositeMap)
         useShaders = false;
 
+    float blendmapScale = mStorage->getBlendmapScale(chunkSize);
+
+    if (useShaders && mPackBlendmaps && blendmaps.size() > 1)
+        return ::Terrain::createPackedPasses(&mSceneManager->getShaderManager(), layers, blendmaps, blendmapScale, blendmapScale);
+
     std::vector<osg::ref_ptr<osg::Texture2D> > blendmapTextures;
     for (std::vector<osg::ref_ptr<osg::Image> >::const_iterator it = blendmaps.begin(); it != blendmaps.end(); ++it)
-    {
-        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
-        texture->setImage(*it);
-        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
-        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
-        texture->setResizeNonPowerOfTwoHint(false);
-        blendmapTextures.push_back(texture);
-    }
-
-    float blendmapScale = mStorage->getBlendmapScale(chunkSize);
+        blendmapTextures.push_back(createBlendmapTexture(*it));
 
     return ::Terrain::createPasses(useShaders, &mSceneManager->getShaderManager(), layers, blendmapTextures, blendmapScale, blendmapScale);
 }
@@ -171,25 +349,54 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
     osg::ref_ptr<osg::Vec4ubArray> colors (new osg::Vec4ubArray);
     colors->setNormalize(true);
 
-    osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
-    positions->setVertexBufferObject(vbo);
-    normals->setVertexBufferObject(vbo);
-    colors->setVertexBufferObject(vbo);
-
     mStorage->fillVertexBuffers(lod, chunkSize, chunkCenter, positions, normals, colors);
 
+    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
+
     osg::ref_ptr<TerrainDrawable> geometry (new TerrainDrawable);
-    geometry->setVertexArray(positions);
-    geometry->setNormalArray(normals, osg::Array::BIND_PER_VERTEX);
-    geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+
+    if (mGpuDisplacement)
+    {
+        // The grid is shared by all chunks with the same number of vertices, vertex data only exists in textures
+        const float chunkWorldSize = chunkSize * mStorage->getCellWorldSize();
+        osg::ref_ptr<osg::Image> heights;
+        transform->setStateSet(createHeightmapStateSet(*positions, *normals, *colors, numVerts, chunkWorldSize, heights));
+        geometry->setVertexArray(mBufferCache.getUVBuffer(numVerts));
+        geometry->setHeightmap(heights, chunkWorldSize);
+    }
+    else
+    {
+        osg::ref_ptr<osg::Array> positionArray = positions;
+        osg::ref_ptr<osg::Array> normalArray = normals;
+        if (mCompactVertices)
+        {
+            // 8 bytes per position and 3 per normal instead of 12 each
+            float offsetZ = 0.f;
+            float scale = 1.f;
+            positionArray = quantizePositions(*positions, offsetZ, scale);
+            normalArray = quantizeNormals(*normals);
+
+            transform->setPosition(osg::Vec3f(worldCenter.x(), worldCenter.y(), offsetZ));
+            transform->setScale(osg::Vec3f(scale, scale, scale));
+            transform->setStateSet(RescaleNormalStateSet::value());
+        }
+
+        osg::ref_ptr<osg::VertexBufferObject> vbo (new osg::VertexBufferObject);
+        positionArray->setVertexBufferObject(vbo);
+        normalArray->setVertexBufferObject(vbo);
+        colors->setVertexBufferObject(vbo);
+
+        geometry->setVertexArray(positionArray);
+        geometry->setNormalArray(normalArray, osg::Array::BIND_PER_VERTEX);
+        geometry->setColorArray(colors, osg::Array::BIND_PER_VERTEX);
+    }
+
     geometry->setUseDisplayList(false);
     geometry->setUseVertexBufferObjects(true);
 
     if (chunkSize <= 1.f)
         geometry->setLightListCallback(new SceneUtil::LightListCallback);
 
-    unsigned int numVerts = (mStorage->getCellVertices()-1) * chunkSize / (1 << lod) + 1;
-
     geometry->addPrimitiveSet(mBufferCache.getIndexBuffer(numVerts, lodFlags));
 
     bool useCompositeMap = chunkSize >= mCompositeMapLevel;
@@ -200,25 +407,39 @@ osg::ref_ptr<osg::Node> ChunkManager::createChunk(float chunkSize, const osg::Ve
 
     if (useCompositeMap)
     {
-        osg::ref_ptr<CompositeMap> compositeMap = new CompositeMap;
-        compositeMap->mTexture = createCompositeMapRTT();
+        std::vector<CompositeMapPart> parts;
+        collectCompositeMapParts(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), parts);
+
+        std::string diskCacheKey;
+        osg::ref_ptr<osg::Texture2D> compositeMapTexture = getCachedCompositeMap(chunkSize, chunkCenter, parts, diskCacheKey);
+        if (!compositeMapTexture)
+        {
+            osg::ref_ptr<CompositeMap> compositeMap = new CompositeMap;
+            compositeMap->mTexture = createCompositeMapRTT();
+            compositeMap->mDiskCacheKey = diskCacheKey;
 
-        createCompositeMapGeometry(chunkSize, chunkCenter, osg::Vec4f(0,0,1,1), *compositeMap);
+            createCompositeMapGeometry(parts, *compositeMap);
 
-        mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
+            mCompositeMapRenderer->addCompositeMap(compositeMap.get(), false);
 
-        geometry->setCompositeMap(compositeMap);
-        geometry->setCompositeMapRenderer(mCompositeMapRenderer);
+            geometry->setCompositeMap(compositeMap);
+            geometry->setCompositeMapRenderer(mCompositeMapRenderer);
+
+            compositeMapTexture = compositeMap->mTexture;
+        }
 
         TextureLayer layer;
-        layer.mDiffuseMap = compositeMap->mTexture;
+        layer.mDiffuseMap = compositeMapTexture;
         layer.mParallax = false;
         layer.mSpecular = false;
-        geometry->setPasses(::Terrain::createPasses(mSceneManager->getForceShaders() || !mSceneManager->getClampLighting(), &mSceneManager->getShaderManager(), std::vector<TextureLayer>(1, layer), std::vector<osg::ref_ptr<osg::Texture2D> >(), 1.f, 1.f));
+        geometry->setPasses(::Terrain::createPasses(mSceneManager->getForceShaders() || !mSceneManager->getClampLighting() || mGpuDisplacement, &mSceneManager->getShaderManager(), std::vector<TextureLayer>(1, layer), std::vector<osg::ref_ptr<osg::Texture2D> >(), 1.f, 1.f));
     }
     else
     {
-        geometry->setPasses(createPasses(chunkSize, chunkCenter, false));
+        std::vector<LayerInfo> layerList;
+        std::vector<osg::ref_ptr<osg::Image> > blendmaps;
+        mStorage->getBlendmaps(chunkSize, chunkCenter, blendmaps, layerList);
+        geometry->setPasses(createPasses(chunkSize, layerList, blendmaps, false));
     }
 
     transform->addChild(geometry);
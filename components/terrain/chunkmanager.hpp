@@ -2,6 +2,9 @@
 #define OPENMW_COMPONENTS_TERRAIN_CHUNKMANAGER_H
 
 #include <tuple>
+#include <vector>
+
+#include <osg/Referenced>
 
 #include <components/resource/resourcemanager.hpp>
 
@@ -10,6 +13,7 @@
 namespace osg
 {
     class Group;
+    class Image;
     class Texture2D;
 }
 
@@ -25,20 +29,38 @@ namespace Terrain
     class CompositeMapRenderer;
     class Storage;
     class CompositeMap;
+    class CompositeMapDiskCache;
+    struct CompositeMapPart;
+    struct LayerInfo;
 
     typedef std::tuple<osg::Vec2f, unsigned char, unsigned int> ChunkId; // Center, Lod, Lod Flags
 
     /// @brief Handles loading and caching of terrain chunks
-    class ChunkManager : public Resource::GenericResourceManager<ChunkId>
+    class ChunkManager : public Resource::GenericResourceManager<ChunkId>, public osg::Referenced
     {
     public:
         ChunkManager(Storage* storage, Resource::SceneManager* sceneMgr, TextureManager* textureManager, CompositeMapRenderer* renderer);
 
         osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags);
 
+        /// @return The chunk if it is in the cache, nullptr otherwise. Never creates a chunk.
+        osg::ref_ptr<osg::Node> getCachedChunk(const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags);
+
         void setCompositeMapSize(unsigned int size) { mCompositeMapSize = size; }
         void setCompositeMapLevel(float level) { mCompositeMapLevel = level; }
         void setMaxCompositeGeometrySize(float maxCompGeometrySize) { mMaxCompGeometrySize = maxCompGeometrySize; }
+        /// Blend several layers in each pass when using shaders, see createPackedPasses().
+        void setPackBlendmaps(bool pack) { mPackBlendmaps = pack; }
+        /// Store positions as 16 bit integers with a scale in the chunk transform, and normals as bytes.
+        void setCompactVertices(bool compact) { mCompactVertices = compact; }
+        /// Draw a shared vertex grid displaced in the vertex shader by per chunk heightmap textures, see heightmap_vertex.glsl.
+        /// Takes precedence over compact vertices.
+        /// @note Requires shaders and the terrainHeightmap shader define, terrain always uses shaders with it.
+        void setGpuDisplacement(bool enabled) { mGpuDisplacement = enabled; }
+        /// Load composite maps from this cache and store newly rendered ones in it.
+        void setCompositeMapDiskCache(CompositeMapDiskCache* diskCache);
+
+        const char* getName() const override { return "Terrain Chunk"; }
 
         void reportStats(unsigned int frameNumber, osg::Stats* stats) const override;
 
@@ -51,19 +73,33 @@ namespace Terrain
 
         osg::ref_ptr<osg::Texture2D> createCompositeMapRTT();
 
-        void createCompositeMapGeometry(float chunkSize, const osg::Vec2f& chunkCenter, const osg::Vec4f& texCoords, CompositeMap& map);
+        /// @return Composite map texture from the disk cache, or nullptr. Sets the key to store a newly rendered map with.
+        osg::ref_ptr<osg::Texture2D> getCachedCompositeMap(float chunkSize, const osg::Vec2f& chunkCenter,
+                                                           const std::vector<CompositeMapPart>& parts, std::string& key);
+
+        /// Splits the composite map into parts no larger than the max composite geometry size and gets their blendmaps,
+        /// so they are generated once for both the disk cache key and the composite map geometry.
+        void collectCompositeMapParts(float chunkSize, const osg::Vec2f& chunkCenter, const osg::Vec4f& texCoords,
+                                      std::vector<CompositeMapPart>& parts);
+
+        void createCompositeMapGeometry(const std::vector<CompositeMapPart>& parts, CompositeMap& map);
 
-        std::vector<osg::ref_ptr<osg::StateSet> > createPasses(float chunkSize, const osg::Vec2f& chunkCenter, bool forCompositeMap);
+        std::vector<osg::ref_ptr<osg::StateSet> > createPasses(float chunkSize, const std::vector<LayerInfo>& layerList,
+                                                               const std::vector<osg::ref_ptr<osg::Image> >& blendmaps, bool forCompositeMap);
 
         Terrain::Storage* mStorage;
         Resource::SceneManager* mSceneManager;
         TextureManager* mTextureManager;
         CompositeMapRenderer* mCompositeMapRenderer;
+        osg::ref_ptr<CompositeMapDiskCache> mCompositeMapDiskCache;
         BufferCache mBufferCache;
 
         unsigned int mCompositeMapSize;
         float mCompositeMapLevel;
         float mMaxCompGeometrySize;
+        bool mPackBlendmaps;
+        bool mCompactVertices;
+        bool mGpuDisplacement;
     };
 
 }
@@ -0,0 +1,172 @@
+#include "compositemapdiskcache.hpp"
+
+#include <osg/Image>
+
+#include <osgDB/Options>
+#include <osgDB/Registry>
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <components/debug/debuglog.hpp>
+#include <components/misc/diskcache.hpp>
+#include <components/misc/keyhasher.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    constexpr std::uint32_t sVersion = 2;
+    constexpr char sExtension[] = ".dds";
+
+    osgDB::ReaderWriter* getReaderWriter()
+    {
+        return osgDB::Registry::instance()->getReaderWriterForExtension("dds");
+    }
+
+    // The rendered image has a bottom left origin, the dds writer would flip it otherwise and files would
+    // be read upside down. Keep rows as they are, so the texture gets the same data as the rendered one.
+    osgDB::Options* getWriteOptions()
+    {
+        static const osg::ref_ptr<osgDB::Options> options = new osgDB::Options("ddsNoAutoFlipWrite");
+        return options.get();
+    }
+}
+
+namespace Terrain
+{
+
+    CompositeMapDiskCache::CompositeMapDiskCache(const std::string& path, std::uint64_t maxSize)
+        : mMaxSize(maxSize)
+        , mSize(0)
+    {
+        if (path.empty())
+            return;
+
+        if (!getReaderWriter())
+        {
+            Log(Debug::Warning) << "Composite map disk cache is disabled: no dds readerwriter found";
+            return;
+        }
+
+        try
+        {
+            boost::filesystem::create_directories(path);
+            mPath = path;
+            // Leave room for the maps rendered in this session
+            mSize = Misc::pruneCacheDirectory(mPath, sExtension, mMaxSize / 2);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Composite map disk cache is disabled: failed to create directory \""
+                << path << "\": " << e.what();
+        }
+    }
+
+    std::string CompositeMapDiskCache::makeKey(float chunkSize, const osg::Vec2f& chunkCenter, unsigned int resolution,
+                                               const std::vector<CompositeMapPart>& parts)
+    {
+        Misc::KeyHasher hasher;
+        hasher.add(sVersion);
+        hasher.add(chunkSize);
+        hasher.add(chunkCenter.x());
+        hasher.add(chunkCenter.y());
+        hasher.add(resolution);
+        hasher.add(parts.size());
+        for (const CompositeMapPart& part : parts)
+        {
+            hasher.add(part.mChunkSize);
+            hasher.add(part.mChunkCenter.x());
+            hasher.add(part.mChunkCenter.y());
+            hasher.add(part.mLayers.size());
+            for (const LayerInfo& layer : part.mLayers)
+                hasher.add(layer.mDiffuseMap);
+            hasher.add(part.mBlendmaps.size());
+            for (const osg::ref_ptr<osg::Image>& blendmap : part.mBlendmaps)
+            {
+                hasher.add(blendmap->s());
+                hasher.add(blendmap->t());
+                hasher.add(blendmap->data(), blendmap->getTotalDataSize());
+            }
+        }
+        return hasher.getKey();
+    }
+
+    osg::ref_ptr<osg::Image> CompositeMapDiskCache::get(const std::string& key) const
+    {
+        if (!isEnabled())
+            return nullptr;
+
+        const auto filePath = mPath / (key + sExtension);
+
+        osgDB::ReaderWriter::ReadResult result;
+        {
+            boost::filesystem::ifstream file(filePath, std::ios::binary);
+            if (!file)
+                return nullptr;
+
+            // No dds_flip, rows are stored as rendered
+            result = getReaderWriter()->readImage(file);
+            if (!result.success())
+            {
+                Log(Debug::Warning) << "Failed to read composite map disk cache file " << filePath << ": " << result.message();
+                return nullptr;
+            }
+        }
+
+        Misc::touchCacheFile(filePath);
+
+        return result.getImage();
+    }
+
+    void CompositeMapDiskCache::set(const std::string& key, const osg::Image& image) const
+    {
+        if (!isEnabled())
+            return;
+
+        const std::string fileName = key + sExtension;
+        const auto filePath = mPath / fileName;
+
+        // Write to a temporary file first so another thread or process never reads a partially written map
+        std::ostringstream tmpFileName;
+        tmpFileName << fileName << '.' << std::this_thread::get_id() << ".tmp";
+        const auto tmpFilePath = mPath / tmpFileName.str();
+
+        if (mSize >= mMaxSize)
+            return;
+
+        std::uint64_t fileSize = 0;
+        try
+        {
+            {
+                boost::filesystem::ofstream file(tmpFilePath, std::ios::binary | std::ios::trunc);
+                osgDB::ReaderWriter::WriteResult result = getReaderWriter()->writeImage(image, file, getWriteOptions());
+                if (!result.success())
+                    throw std::runtime_error(result.message());
+                if (!file)
+                    throw std::runtime_error("write error");
+            }
+
+            fileSize = boost::filesystem::file_size(tmpFilePath);
+            if (mSize.fetch_add(fileSize) + fileSize > mMaxSize)
+            {
+                mSize -= fileSize;
+                boost::system::error_code ec;
+                boost::filesystem::remove(tmpFilePath, ec);
+                return;
+            }
+
+            boost::filesystem::rename(tmpFilePath, filePath);
+        }
+        catch (const std::exception& e)
+        {
+            Log(Debug::Warning) << "Failed to write composite map disk cache file " << filePath << ": " << e.what();
+            mSize -= fileSize;
+            boost::system::error_code ec;
+            boost::filesystem::remove(tmpFilePath, ec);
+        }
+    }
+
+}
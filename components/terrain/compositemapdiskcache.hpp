@@ -0,0 +1,67 @@
+#ifndef OPENMW_COMPONENTS_TERRAIN_COMPOSITEMAPDISKCACHE_H
+#define OPENMW_COMPONENTS_TERRAIN_COMPOSITEMAPDISKCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <osg/Image>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Vec2f>
+#include <osg/Vec4f>
+
+#include <boost/filesystem/path.hpp>
+
+#include "defs.hpp"
+
+namespace Terrain
+{
+
+    /// Terrain inputs of a rectangle of a composite map, rendered by one set of passes.
+    struct CompositeMapPart
+    {
+        float mChunkSize;
+        osg::Vec2f mChunkCenter;
+        osg::Vec4f mTexCoords;
+        std::vector<LayerInfo> mLayers;
+        std::vector<osg::ref_ptr<osg::Image> > mBlendmaps;
+    };
+
+    /// @brief Stores rendered composite maps in DDS files to reuse them on next runs, so the composite map renderer
+    /// does not have to render unchanged terrain again.
+    /// @par Each file is named by a hash of the chunk position and size, the composite map resolution and the terrain
+    /// inputs: blendmaps and layer texture names. So changed land data gives another file and stale files are never used.
+    /// Changing the contents of a texture file without renaming it is not detected.
+    /// @par The least recently used files are removed on start to keep the directory below half of the size limit,
+    /// new maps are not stored once the limit is reached.
+    /// @note Thread safe.
+    class CompositeMapDiskCache : public osg::Referenced
+    {
+    public:
+        /// Empty path disables cache.
+        CompositeMapDiskCache(const std::string& path, std::uint64_t maxSize);
+
+        bool isEnabled() const
+        {
+            return !mPath.empty();
+        }
+
+        static std::string makeKey(float chunkSize, const osg::Vec2f& chunkCenter, unsigned int resolution,
+                                   const std::vector<CompositeMapPart>& parts);
+
+        /// Returns nullptr when there is no valid file for the key.
+        osg::ref_ptr<osg::Image> get(const std::string& key) const;
+
+        void set(const std::string& key, const osg::Image& image) const;
+
+    private:
+        boost::filesystem::path mPath;
+        std::uint64_t mMaxSize;
+        mutable std::atomic<std::uint64_t> mSize;
+    };
+
+}
+
+#endif
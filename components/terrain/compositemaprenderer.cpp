@@ -5,12 +5,39 @@
 #include <osg/FrameBufferObject>
 #include <osg/Texture2D>
 #include <osg/RenderInfo>
+#include <osg/Image>
 
 #include <components/sceneutil/unrefqueue.hpp>
 #include <components/sceneutil/workqueue.hpp>
 
+#include "compositemapdiskcache.hpp"
+
 #include <algorithm>
 
+namespace
+{
+    class SaveCompositeMapWorkItem : public SceneUtil::WorkItem
+    {
+    public:
+        SaveCompositeMapWorkItem(Terrain::CompositeMapDiskCache* diskCache, const std::string& key, osg::Image* image)
+            : mDiskCache(diskCache)
+            , mKey(key)
+            , mImage(image)
+        {
+        }
+
+        virtual void doWork()
+        {
+            mDiskCache->set(mKey, *mImage);
+        }
+
+    private:
+        osg::ref_ptr<Terrain::CompositeMapDiskCache> mDiskCache;
+        std::string mKey;
+        osg::ref_ptr<osg::Image> mImage;
+    };
+}
+
 namespace Terrain
 {
 
@@ -37,6 +64,11 @@ void CompositeMapRenderer::setWorkQueue(SceneUtil::WorkQueue* workQueue)
     mWorkQueue = workQueue;
 }
 
+void CompositeMapRenderer::setDiskCache(CompositeMapDiskCache* diskCache)
+{
+    mDiskCache = diskCache;
+}
+
 void CompositeMapRenderer::drawImplementation(osg::RenderInfo &renderInfo) const
 {
     double dt = mTimer.time_s();
@@ -156,13 +188,63 @@ void CompositeMapRenderer::compile(CompositeMap &compositeMap, osg::RenderInfo &
                 break;
         }
     }
-    if (compositeMap.mCompiled == compositeMap.mDrawables.size())
+    bool finished = compositeMap.mCompiled == compositeMap.mDrawables.size();
+    if (finished)
         compositeMap.mDrawables = std::vector<osg::ref_ptr<osg::Drawable>>();
 
     state.haveAppliedAttribute(osg::StateAttribute::VIEWPORT);
 
     GLuint fboId = state.getGraphicsContext() ? state.getGraphicsContext()->getDefaultFboId() : 0;
     ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, fboId);
+
+    if (finished && !compositeMap.mDiskCacheKey.empty())
+    {
+        saveToDiskCache(compositeMap, state);
+
+        if (timeLeft)
+        {
+            *timeLeft -= timer.time_s();
+            timer.setStartTick();
+        }
+    }
+}
+
+void CompositeMapRenderer::saveToDiskCache(CompositeMap& compositeMap, osg::State& state) const
+{
+    const std::string key = compositeMap.mDiskCacheKey;
+    compositeMap.mDiskCacheKey.clear();
+
+    if (!mDiskCache || !mWorkQueue)
+        return;
+
+    const unsigned int contextID = state.getContextID();
+
+    // Read back the rendered map
+    compositeMap.mTexture->apply(state);
+    osg::ref_ptr<osg::Image> image (new osg::Image);
+    image->readImageFromCurrentTexture(contextID, false, GL_UNSIGNED_BYTE);
+
+    // Let the driver compress it by uploading it to a compressed texture, so it can be loaded without conversion later
+    static const bool compressionSupported = osg::isGLExtensionSupported(contextID, "GL_EXT_texture_compression_s3tc");
+    if (compressionSupported)
+    {
+        osg::ref_ptr<osg::Texture2D> compressedTexture (new osg::Texture2D(image));
+        compressedTexture->setInternalFormatMode(osg::Texture::USE_S3TC_DXT1_COMPRESSION);
+        compressedTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        compressedTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        compressedTexture->apply(state);
+
+        osg::ref_ptr<osg::Image> compressedImage (new osg::Image);
+        compressedImage->readImageFromCurrentTexture(contextID, false);
+        image = compressedImage;
+
+        compressedTexture->releaseGLObjects(&state);
+    }
+
+    // inform State that the texture binding has changed
+    state.haveAppliedTextureAttribute(state.getActiveTextureUnit(), osg::StateAttribute::TEXTURE);
+
+    mWorkQueue->addWorkItem(new SaveCompositeMapWorkItem(mDiskCache, key, image));
 }
 
 void CompositeMapRenderer::setMinimumTimeAvailableForCompile(double time)
@@ -6,11 +6,13 @@
 #include <OpenThreads/Mutex>
 
 #include <set>
+#include <string>
 
 namespace osg
 {
     class FrameBufferObject;
     class RenderInfo;
+    class State;
     class Texture2D;
 }
 
@@ -23,6 +25,8 @@ namespace SceneUtil
 namespace Terrain
 {
 
+    class CompositeMapDiskCache;
+
     class CompositeMap : public osg::Referenced
     {
     public:
@@ -31,6 +35,8 @@ namespace Terrain
         std::vector<osg::ref_ptr<osg::Drawable> > mDrawables;
         osg::ref_ptr<osg::Texture2D> mTexture;
         unsigned int mCompiled;
+        /// Key to store the rendered map with in the disk cache, empty to not store it
+        std::string mDiskCacheKey;
     };
 
     /**
@@ -49,6 +55,9 @@ namespace Terrain
         /// Set a WorkQueue to delete compiled composite map layers in the background thread
         void setWorkQueue(SceneUtil::WorkQueue* workQueue);
 
+        /// Set a cache to store finished composite maps in, they are written in the WorkQueue
+        void setDiskCache(CompositeMapDiskCache* diskCache);
+
         /// Set the available time in seconds for compiling (non-immediate) composite maps each frame
         void setMinimumTimeAvailableForCompile(double time);
 
@@ -64,12 +73,15 @@ namespace Terrain
         unsigned int getCompileSetSize() const;
 
     private:
+        void saveToDiskCache(CompositeMap& compositeMap, osg::State& state) const;
+
         float mTargetFrameRate;
         double mMinimumTimeAvailable;
         mutable osg::Timer mTimer;
 
         osg::ref_ptr<SceneUtil::UnrefQueue> mUnrefQueue;
         osg::ref_ptr<SceneUtil::WorkQueue> mWorkQueue;
+        osg::ref_ptr<CompositeMapDiskCache> mDiskCache;
 
         typedef std::set<osg::ref_ptr<CompositeMap> > CompileSet;
 
@@ -6,10 +6,13 @@
 #include <osg/Texture2D>
 #include <osg/TexMat>
 #include <osg/BlendFunc>
+#include <osg/Image>
 
 #include <components/shader/shadermanager.hpp>
 
+#include <cstring>
 #include <mutex>
+#include <string>
 
 namespace
 {
@@ -166,10 +169,55 @@ namespace
             mValue->setSource0_RGB(osg::TexEnvCombine::PREVIOUS);
         }
     };
+
+    void setPassBlending(osg::StateSet& stateset, bool firstLayer)
+    {
+        stateset.setMode(GL_BLEND, osg::StateAttribute::ON);
+
+        if (!firstLayer)
+        {
+            stateset.setAttributeAndModes(BlendFunc::value(), osg::StateAttribute::ON);
+            stateset.setAttributeAndModes(EqualDepth::value(), osg::StateAttribute::ON);
+        }
+        else
+        {
+            stateset.setAttributeAndModes(BlendFuncFirst::value(), osg::StateAttribute::ON);
+            stateset.setAttributeAndModes(LequalDepth::value(), osg::StateAttribute::ON);
+        }
+    }
+
+    /// Copy the alpha blendmaps of several layers into the channels of one RGBA image, unused channels are left empty.
+    osg::ref_ptr<osg::Image> packBlendmaps(const std::vector<osg::ref_ptr<osg::Image> >& blendmaps, std::size_t first, std::size_t count)
+    {
+        const osg::Image& source = *blendmaps[first];
+        osg::ref_ptr<osg::Image> image (new osg::Image);
+        image->allocateImage(source.s(), source.t(), 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        unsigned char* data = image->data();
+        memset(data, 0, image->getTotalDataSize());
+
+        const std::size_t numPixels = static_cast<std::size_t>(source.s()) * source.t();
+        for (std::size_t layer = 0; layer < count; ++layer)
+        {
+            const unsigned char* layerData = blendmaps[first + layer]->data();
+            for (std::size_t i = 0; i < numPixels; ++i)
+                data[i * 4 + layer] = layerData[i];
+        }
+        return image;
+    }
 }
 
 namespace Terrain
 {
+    osg::ref_ptr<osg::Texture2D> createBlendmapTexture(osg::Image* blendmap)
+    {
+        osg::ref_ptr<osg::Texture2D> texture (new osg::Texture2D);
+        texture->setImage(blendmap);
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        texture->setResizeNonPowerOfTwoHint(false);
+        return texture;
+    }
+
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, Shader::ShaderManager* shaderManager, const std::vector<TextureLayer> &layers,
                                                            const std::vector<osg::ref_ptr<osg::Texture2D> > &blendmaps, int blendmapScale, float layerTileSize)
     {
@@ -183,18 +231,7 @@ namespace Terrain
 
             osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
 
-            stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
-
-            if (!firstLayer)
-            {
-                stateset->setAttributeAndModes(BlendFunc::value(), osg::StateAttribute::ON);
-                stateset->setAttributeAndModes(EqualDepth::value(), osg::StateAttribute::ON);
-            }
-            else
-            {
-                stateset->setAttributeAndModes(BlendFuncFirst::value(), osg::StateAttribute::ON);
-                stateset->setAttributeAndModes(LequalDepth::value(), osg::StateAttribute::ON);
-            }
+            setPassBlending(*stateset, firstLayer);
 
             int texunit = 0;
 
@@ -227,6 +264,7 @@ namespace Terrain
                 Shader::ShaderManager::DefineMap defineMap;
                 defineMap["normalMap"] = (it->mNormalMap) ? "1" : "0";
                 defineMap["blendMap"] = (!blendmaps.empty()) ? "1" : "0";
+                defineMap["blendLayers"] = "1";
                 defineMap["specularMap"] = it->mSpecular ? "1" : "0";
                 defineMap["parallax"] = (it->mNormalMap && it->mParallax) ? "1" : "0";
 
@@ -275,4 +313,83 @@ namespace Terrain
         return passes;
     }
 
+    std::vector<osg::ref_ptr<osg::StateSet> > createPackedPasses(Shader::ShaderManager* shaderManager, const std::vector<TextureLayer>& layers,
+                                                                 const std::vector<osg::ref_ptr<osg::Image> >& blendmaps, int blendmapScale, float layerTileSize)
+    {
+        std::vector<osg::ref_ptr<osg::StateSet> > passes;
+
+        std::size_t first = 0;
+        while (first < layers.size())
+        {
+            // Group following layers that can share a shader, specular maps change how the diffuse alpha is used
+            std::size_t last = first + 1;
+            if (!layers[first].mNormalMap)
+            {
+                while (last < layers.size() && last - first < MaxLayersPerPass && !layers[last].mNormalMap
+                       && layers[last].mSpecular == layers[first].mSpecular)
+                    ++last;
+            }
+            const std::size_t numLayers = last - first;
+            const TextureLayer& layer = layers[first];
+
+            osg::ref_ptr<osg::StateSet> stateset (new osg::StateSet);
+
+            setPassBlending(*stateset, passes.empty());
+
+            // Keep the layer and the blendmap on units 0 and 1 like the other passes, so they use the same texture matrices
+            stateset->setTextureAttributeAndModes(0, layer.mDiffuseMap);
+            if (layerTileSize != 1.f)
+                stateset->setTextureAttributeAndModes(0, LayerTexMat::value(layerTileSize), osg::StateAttribute::ON);
+            stateset->addUniform(new osg::Uniform("diffuseMap", 0));
+
+            osg::ref_ptr<osg::Image> blendmap = numLayers == 1 ? blendmaps.at(first) : packBlendmaps(blendmaps, first, numLayers);
+            stateset->setTextureAttributeAndModes(1, createBlendmapTexture(blendmap));
+            stateset->setTextureAttributeAndModes(1, BlendmapTexMat::value(blendmapScale));
+            stateset->addUniform(new osg::Uniform("blendMap", 1));
+
+            int texunit = 1;
+            for (std::size_t i = 1; i < numLayers; ++i)
+            {
+                ++texunit;
+                stateset->setTextureAttributeAndModes(texunit, layers[first + i].mDiffuseMap);
+                stateset->addUniform(new osg::Uniform(("diffuseMap" + std::to_string(i)).c_str(), texunit));
+            }
+
+            if (layer.mNormalMap)
+            {
+                ++texunit;
+                stateset->setTextureAttributeAndModes(texunit, layer.mNormalMap);
+                stateset->addUniform(new osg::Uniform("normalMap", texunit));
+            }
+
+            Shader::ShaderManager::DefineMap defineMap;
+            defineMap["normalMap"] = (layer.mNormalMap) ? "1" : "0";
+            defineMap["blendMap"] = "1";
+            defineMap["blendLayers"] = std::to_string(numLayers);
+            defineMap["specularMap"] = layer.mSpecular ? "1" : "0";
+            defineMap["parallax"] = (layer.mNormalMap && layer.mParallax) ? "1" : "0";
+
+            osg::ref_ptr<osg::Shader> vertexShader = shaderManager->getShader("terrain_vertex.glsl", defineMap, osg::Shader::VERTEX);
+            osg::ref_ptr<osg::Shader> fragmentShader = shaderManager->getShader("terrain_fragment.glsl", defineMap, osg::Shader::FRAGMENT);
+            if (!vertexShader || !fragmentShader)
+            {
+                // Try again without shader. Error already logged by above
+                std::vector<osg::ref_ptr<osg::Texture2D> > blendmapTextures;
+                for (const auto& image : blendmaps)
+                    blendmapTextures.push_back(createBlendmapTexture(image));
+                return createPasses(false, shaderManager, layers, blendmapTextures, blendmapScale, layerTileSize);
+            }
+
+            stateset->setAttributeAndModes(shaderManager->getProgram(vertexShader, fragmentShader));
+            stateset->addUniform(new osg::Uniform("colorMode", 2));
+
+            stateset->setRenderBinDetails(static_cast<int>(passes.size()), "RenderBin");
+
+            passes.push_back(stateset);
+
+            first = last;
+        }
+        return passes;
+    }
+
 }
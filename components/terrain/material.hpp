@@ -7,6 +7,7 @@
 
 namespace osg
 {
+    class Image;
     class Texture2D;
 }
 
@@ -26,10 +27,23 @@ namespace Terrain
         bool mSpecular;
     };
 
+    /// Maximum number of layers blended in one pass by createPackedPasses.
+    const unsigned int MaxLayersPerPass = 4;
+
+    osg::ref_ptr<osg::Texture2D> createBlendmapTexture(osg::Image* blendmap);
+
     std::vector<osg::ref_ptr<osg::StateSet> > createPasses(bool useShaders, Shader::ShaderManager* shaderManager,
                                                            const std::vector<TextureLayer>& layers,
                                                            const std::vector<osg::ref_ptr<osg::Texture2D> >& blendmaps, int blendmapScale, float layerTileSize);
 
+    /// @brief Create shader passes that blend up to MaxLayersPerPass layers each, instead of one pass per layer.
+    /// @par The blendmaps of the layers in a pass are packed into the channels of a single RGBA texture.
+    /// Layers with a normal map need more texture units and are still given a pass of their own.
+    /// @param blendmaps One alpha blendmap per layer, as returned by Storage::getBlendmaps.
+    std::vector<osg::ref_ptr<osg::StateSet> > createPackedPasses(Shader::ShaderManager* shaderManager,
+                                                                 const std::vector<TextureLayer>& layers,
+                                                                 const std::vector<osg::ref_ptr<osg::Image> >& blendmaps, int blendmapScale, float layerTileSize);
+
 }
 
 #endif
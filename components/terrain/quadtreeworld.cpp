@@ -2,10 +2,14 @@
 
 #include <osgUtil/CullVisitor>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <sstream>
 
 #include <components/misc/constants.hpp>
 #include <components/sceneutil/mwshadowtechnique.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "quadtreenode.hpp"
 #include "storage.hpp"
@@ -217,6 +221,77 @@ private:
     osg::ref_ptr<LodCallback> mLodCallback;
 };
 
+/// Builds a terrain chunk in the background, so the cull traversal never has to.
+class CreateChunkWorkItem : public SceneUtil::WorkItem
+{
+public:
+    CreateChunkWorkItem(ChunkManager* chunkManager, const std::shared_ptr<PendingChunks>& pendingChunks, const std::shared_ptr<std::atomic<bool>>& aborted, float size, const osg::Vec2f& center, unsigned char lod, unsigned int lodFlags)
+        : mChunkManager(chunkManager)
+        , mPendingChunks(pendingChunks)
+        , mAborted(aborted)
+        , mSize(size)
+        , mCenter(center)
+        , mLod(lod)
+        , mLodFlags(lodFlags)
+    {
+    }
+
+    virtual void doWork();
+
+    /// Valid once the item is done
+    osg::ref_ptr<osg::Node> mResult;
+
+private:
+    osg::ref_ptr<ChunkManager> mChunkManager;
+    std::shared_ptr<PendingChunks> mPendingChunks;
+    std::shared_ptr<std::atomic<bool>> mAborted;
+    float mSize;
+    osg::Vec2f mCenter;
+    unsigned char mLod;
+    unsigned int mLodFlags;
+};
+
+/// Chunks being built in the background, shared by the views of all cameras so each chunk is queued once.
+class PendingChunks
+{
+public:
+    /// @return The item building the chunk, nullptr if none is queued.
+    osg::ref_ptr<CreateChunkWorkItem> get(const ChunkId& id)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const auto it = mItems.find(id);
+        if (it == mItems.end())
+            return nullptr;
+        return it->second;
+    }
+
+    void add(const ChunkId& id, CreateChunkWorkItem* item)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        mItems[id] = item;
+    }
+
+    void remove(const ChunkId& id, const CreateChunkWorkItem* item)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+        const auto it = mItems.find(id);
+        if (it != mItems.end() && it->second == item)
+            mItems.erase(it);
+    }
+
+private:
+    OpenThreads::Mutex mMutex;
+    std::map<ChunkId, osg::ref_ptr<CreateChunkWorkItem>> mItems;
+};
+
+void CreateChunkWorkItem::doWork()
+{
+    if (!*mAborted)
+        mResult = mChunkManager->getChunk(mSize, mCenter, mLod, mLodFlags);
+    // Later requests find the chunk in the chunk manager's cache
+    mPendingChunks->remove(ChunkId(mCenter, mLod, mLodFlags), this);
+}
+
 QuadTreeWorld::QuadTreeWorld(osg::Group *parent, osg::Group *compileRoot, Resource::ResourceSystem *resourceSystem, Storage *storage, int nodeMask, int preCompileMask, int borderMask, int compMapResolution, float compMapLevel, float lodFactor, int vertexLodMod, float maxCompGeometrySize)
     : TerrainGrid(parent, compileRoot, resourceSystem, storage, nodeMask, preCompileMask, borderMask)
     , mViewDataMap(new ViewDataMap)
@@ -224,6 +299,9 @@ QuadTreeWorld::QuadTreeWorld(osg::Group *parent, osg::Group *compileRoot, Resour
     , mLodFactor(lodFactor)
     , mVertexLodMod(vertexLodMod)
     , mViewDistance(std::numeric_limits<float>::max())
+    , mActiveGrid(0, 0, -1, -1)
+    , mPendingChunks(std::make_shared<PendingChunks>())
+    , mAbortLoading(std::make_shared<std::atomic<bool>>(false))
 {
     mChunkManager->setCompositeMapSize(compMapResolution);
     mChunkManager->setCompositeMapLevel(compMapLevel);
@@ -232,6 +310,8 @@ QuadTreeWorld::QuadTreeWorld(osg::Group *parent, osg::Group *compileRoot, Resour
 
 QuadTreeWorld::~QuadTreeWorld()
 {
+    // Queued chunks must not be built once the chunk managers are gone
+    *mAbortLoading = true;
     mViewDataMap->clear();
 }
 
@@ -286,9 +366,55 @@ unsigned int getLodFlags(QuadTreeNode* node, int ourLod, int vertexLodMod, ViewD
     return lodFlags;
 }
 
-void loadRenderingNode(ViewData::Entry& entry, ViewData* vd, int vertexLodMod, ChunkManager* chunkManager)
+/// Loads the content of QuadTreeChunkManagers for a quad tree node in the background.
+class LoadChunkNodesWorkItem : public SceneUtil::WorkItem
+{
+public:
+    LoadChunkNodesWorkItem(const std::vector<QuadTreeChunkManager*>& chunkManagers, const std::shared_ptr<std::atomic<bool>>& aborted, float size, const osg::Vec2f& center, const osg::Vec4i& grid)
+        : mGrid(grid)
+        , mChunkManagers(chunkManagers)
+        , mAborted(aborted)
+        , mSize(size)
+        , mCenter(center)
+    {
+    }
+
+    virtual void doWork()
+    {
+        for (QuadTreeChunkManager* chunkManager : mChunkManagers)
+        {
+            if (*mAborted)
+                return;
+            osg::ref_ptr<osg::Node> node = chunkManager->getChunk(mSize, mCenter, mGrid);
+            if (node)
+                mResult.push_back(node);
+        }
+    }
+
+    const osg::Vec4i mGrid;
+    /// Valid once the item is done
+    std::vector<osg::ref_ptr<osg::Node>> mResult;
+
+private:
+    std::vector<QuadTreeChunkManager*> mChunkManagers;
+    std::shared_ptr<std::atomic<bool>> mAborted;
+    float mSize;
+    osg::Vec2f mCenter;
+};
+
+/// Background loading for the cull traversal, see QuadTreeWorld::accept
+struct AsyncLoading
+{
+    SceneUtil::WorkQueue* mWorkQueue;
+    std::shared_ptr<PendingChunks> mPendingChunks;
+    std::shared_ptr<std::atomic<bool>> mAborted;
+};
+
+/// @param async If not nullptr, a missing chunk is built in the background. Until it is done, the entry keeps the chunk
+/// with its previous lod flags if it has one, and has no rendering node otherwise.
+void loadRenderingNode(ViewData::Entry& entry, ViewData* vd, int vertexLodMod, ChunkManager* chunkManager, const AsyncLoading* async = nullptr)
 {
-    if (!vd->hasChanged() && entry.mRenderingNode)
+    if (!vd->hasChanged() && entry.mRenderingNode && entry.mRenderingLodFlags == entry.mLodFlags)
         return;
 
     int ourLod = getVertexLod(entry.mNode, vertexLodMod);
@@ -299,13 +425,115 @@ void loadRenderingNode(ViewData::Entry& entry, ViewData* vd, int vertexLodMod, C
         unsigned int lodFlags = getLodFlags(entry.mNode, ourLod, vertexLodMod, vd);
         if (lodFlags != entry.mLodFlags)
         {
-            entry.mRenderingNode = nullptr;
+            if (!async)
+                entry.mRenderingNode = nullptr;
+            entry.mPendingRenderingNode = nullptr;
             entry.mLodFlags = lodFlags;
         }
     }
 
-    if (!entry.mRenderingNode)
+    if (entry.mRenderingNode && entry.mRenderingLodFlags == entry.mLodFlags)
+        return;
+
+    if (!async)
+    {
         entry.mRenderingNode = chunkManager->getChunk(entry.mNode->getSize(), entry.mNode->getCenter(), ourLod, entry.mLodFlags);
+        entry.mRenderingLodFlags = entry.mLodFlags;
+        entry.mPendingRenderingNode = nullptr;
+        return;
+    }
+
+    if (entry.mPendingRenderingNode)
+    {
+        if (entry.mPendingRenderingNode->isDone())
+        {
+            entry.mRenderingNode = static_cast<CreateChunkWorkItem*>(entry.mPendingRenderingNode.get())->mResult;
+            entry.mRenderingLodFlags = entry.mLodFlags;
+            entry.mPendingRenderingNode = nullptr;
+        }
+        return;
+    }
+
+    osg::ref_ptr<osg::Node> cached = chunkManager->getCachedChunk(entry.mNode->getCenter(), ourLod, entry.mLodFlags);
+    if (cached)
+    {
+        entry.mRenderingNode = cached;
+        entry.mRenderingLodFlags = entry.mLodFlags;
+        return;
+    }
+
+    const ChunkId id(entry.mNode->getCenter(), ourLod, entry.mLodFlags);
+    osg::ref_ptr<CreateChunkWorkItem> item = async->mPendingChunks->get(id);
+    if (!item)
+    {
+        item = new CreateChunkWorkItem(chunkManager, async->mPendingChunks, async->mAborted, entry.mNode->getSize(), entry.mNode->getCenter(), ourLod, entry.mLodFlags);
+        async->mPendingChunks->add(id, item);
+        async->mWorkQueue->addWorkItem(item, true);
+    }
+    entry.mPendingRenderingNode = item;
+}
+
+/// @return The part of the active grid relevant for the chunks of this node, an empty grid if the node doesn't overlap it.
+osg::Vec4i getChunksGrid(QuadTreeNode* node, const osg::Vec4i& activeGrid, bool& covered)
+{
+    const float halfSize = node->getSize()/2.f;
+    const osg::Vec2f min = node->getCenter() - osg::Vec2f(halfSize, halfSize);
+    const osg::Vec2f max = node->getCenter() + osg::Vec2f(halfSize, halfSize);
+
+    covered = min.x() >= activeGrid[0] && min.y() >= activeGrid[1] && max.x() <= activeGrid[2]+1 && max.y() <= activeGrid[3]+1;
+
+    if (min.x() >= activeGrid[2]+1 || max.x() <= activeGrid[0] || min.y() >= activeGrid[3]+1 || max.y() <= activeGrid[1])
+        return osg::Vec4i(0, 0, -1, -1);
+    return activeGrid;
+}
+
+/// @param async If not nullptr, the chunks are loaded in the background and the entry has no chunk nodes until they are done.
+void loadChunkNodes(ViewData::Entry& entry, const osg::Vec4i& activeGrid, const std::vector<QuadTreeChunkManager*>& chunkManagers, const AsyncLoading* async = nullptr)
+{
+    if (chunkManagers.empty())
+        return;
+
+    bool covered = false;
+    const osg::Vec4i grid = getChunksGrid(entry.mNode, activeGrid, covered);
+    if (entry.mChunksLoaded && entry.mChunksGrid == grid)
+        return;
+
+    if (entry.mPendingChunkNodes)
+    {
+        LoadChunkNodesWorkItem* item = static_cast<LoadChunkNodesWorkItem*>(entry.mPendingChunkNodes.get());
+        if (item->mGrid == grid)
+        {
+            if (!item->isDone())
+                return;
+            entry.mChunkNodes = item->mResult;
+            entry.mChunksGrid = grid;
+            entry.mChunksLoaded = true;
+            entry.mPendingChunkNodes = nullptr;
+            return;
+        }
+        entry.mPendingChunkNodes = nullptr;
+    }
+
+    entry.mChunkNodes.clear();
+    // Content of loaded cells is rendered by the cells themselves
+    if (!covered && async)
+    {
+        entry.mPendingChunkNodes = new LoadChunkNodesWorkItem(chunkManagers, async->mAborted, entry.mNode->getSize(), entry.mNode->getCenter(), grid);
+        async->mWorkQueue->addWorkItem(entry.mPendingChunkNodes, true);
+        entry.mChunksLoaded = false;
+        return;
+    }
+    if (!covered)
+    {
+        for (QuadTreeChunkManager* chunkManager : chunkManagers)
+        {
+            osg::ref_ptr<osg::Node> node = chunkManager->getChunk(entry.mNode->getSize(), entry.mNode->getCenter(), grid);
+            if (node)
+                entry.mChunkNodes.push_back(node);
+        }
+    }
+    entry.mChunksGrid = grid;
+    entry.mChunksLoaded = true;
 }
 
 void QuadTreeWorld::accept(osg::NodeVisitor &nv)
@@ -326,16 +554,23 @@ void QuadTreeWorld::accept(osg::NodeVisitor &nv)
         return;
     }
 
+    double referenceTime = nv.getFrameStamp() ? nv.getFrameStamp()->getReferenceTime() : 0.0;
+    if (referenceTime != 0.0)
+        mViewDataMap->clearUnusedViews(referenceTime);
+
     bool needsUpdate = true;
     ViewData* vd = nullptr;
     if (isCullVisitor)
-        vd = mViewDataMap->getViewData(static_cast<osgUtil::CullVisitor*>(&nv)->getCurrentCamera(), nv.getViewPoint(), needsUpdate);
+        vd = mViewDataMap->getViewData(static_cast<osgUtil::CullVisitor*>(&nv)->getCurrentCamera(), nv.getViewPoint(), referenceTime, needsUpdate);
     else
     {
         static ViewData sIntersectionViewData;
         vd = &sIntersectionViewData;
     }
 
+    // Cameras may be culled in parallel, and a view may be copied by other cameras in the meantime
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(vd->getMutex());
+
     if (needsUpdate)
     {
         vd->reset();
@@ -370,26 +605,89 @@ void QuadTreeWorld::accept(osg::NodeVisitor &nv)
         }
     }
 
+    osg::Vec4i activeGrid(0, 0, -1, -1);
+    if (isCullVisitor && !mChunkManagers.empty())
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mActiveGridMutex);
+        activeGrid = mActiveGrid;
+    }
+
+    // Chunks missing during the cull traversal are built in the background
+    AsyncLoading async { mWorkQueue, mPendingChunks, mAbortLoading };
+    const AsyncLoading* asyncLoading = isCullVisitor && mWorkQueue ? &async : nullptr;
+
+    // Fallbacks replace every entry they cover
+    Fallbacks fallbacks;
+
     for (unsigned int i=0; i<vd->getNumEntries(); ++i)
     {
         ViewData::Entry& entry = vd->getEntry(i);
 
-        loadRenderingNode(entry, vd, mVertexLodMod, mChunkManager.get());
+        loadRenderingNode(entry, vd, mVertexLodMod, mChunkManager.get(), asyncLoading);
+
+        if (!entry.mRenderingNode)
+            addFallback(entry.mNode, vd, fallbacks);
+
+        // Chunks are not meant to be hit by terrain intersections
+        if (isCullVisitor)
+        {
+            loadChunkNodes(entry, activeGrid, mChunkManagers, asyncLoading);
+            for (const auto& node : entry.mChunkNodes)
+                node->accept(nv);
+        }
+    }
 
-        entry.mRenderingNode->accept(nv);
+    for (unsigned int i=0; i<vd->getNumEntries(); ++i)
+    {
+        ViewData::Entry& entry = vd->getEntry(i);
+        if (entry.mRenderingNode && !isCoveredByFallback(entry.mNode, fallbacks))
+            entry.mRenderingNode->accept(nv);
     }
 
+    for (const auto& fallback : fallbacks)
+        fallback.second->accept(nv);
+
     if (!isCullVisitor)
         vd->clear(); // we can't reuse intersection views in the next frame because they only contain what is touched by the intersection ray.
 
     vd->markUnchanged();
+}
 
-    double referenceTime = nv.getFrameStamp() ? nv.getFrameStamp()->getReferenceTime() : 0.0;
-    if (referenceTime != 0.0)
+void QuadTreeWorld::addFallback(QuadTreeNode* node, ViewData* vd, Fallbacks& fallbacks)
+{
+    if (isCoveredByFallback(node, fallbacks))
+        return;
+
+    for (QuadTreeNode* parent = node->getParent(); parent; parent = parent->getParent())
     {
-        vd->setLastUsageTimeStamp(referenceTime);
-        mViewDataMap->clearUnusedViews(referenceTime);
+        // Only a chunk stitched to the less detailed neighbours in this view connects to them without holes
+        const int lod = getVertexLod(parent, mVertexLodMod);
+        osg::ref_ptr<osg::Node> chunk = mChunkManager->getCachedChunk(parent->getCenter(), lod, getLodFlags(parent, lod, mVertexLodMod, vd));
+        if (!chunk)
+            continue;
+
+        // Fallbacks must not overlap each other
+        fallbacks.erase(std::remove_if(fallbacks.begin(), fallbacks.end(),
+            [&] (const Fallbacks::value_type& fallback) { return isCoveredByFallback(fallback.first, Fallbacks(1, std::make_pair(parent, chunk))); }),
+            fallbacks.end());
+        fallbacks.emplace_back(parent, chunk);
+        return;
+    }
+}
+
+bool QuadTreeWorld::isCoveredByFallback(QuadTreeNode* node, const Fallbacks& fallbacks)
+{
+    if (fallbacks.empty())
+        return false;
+    for (QuadTreeNode* parent = node->getParent(); parent; parent = parent->getParent())
+    {
+        for (const auto& fallback : fallbacks)
+        {
+            if (fallback.first == parent)
+                return true;
+        }
     }
+    return false;
 }
 
 void QuadTreeWorld::ensureQuadTreeBuilt()
@@ -448,10 +746,27 @@ void QuadTreeWorld::preload(View *view, const osg::Vec3f &viewPoint, std::atomic
     vd->setViewPoint(viewPoint);
     mRootNode->traverseNodes(vd, viewPoint, mLodCallback, mViewDistance);
 
+    osg::Vec4i activeGrid;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mActiveGridMutex);
+        activeGrid = mActiveGrid;
+    }
+    // Expect the cells around the view point to be loaded by the time the view is used
+    if (activeGrid[0] <= activeGrid[2])
+    {
+        const float cellWorldSize = mStorage->getCellWorldSize();
+        const int cellX = static_cast<int>(std::floor(viewPoint.x() / cellWorldSize));
+        const int cellY = static_cast<int>(std::floor(viewPoint.y() / cellWorldSize));
+        const int halfSizeX = (activeGrid[2] - activeGrid[0]) / 2;
+        const int halfSizeY = (activeGrid[3] - activeGrid[1]) / 2;
+        activeGrid = osg::Vec4i(cellX - halfSizeX, cellY - halfSizeY, cellX + halfSizeX, cellY + halfSizeY);
+    }
+
     for (unsigned int i=0; i<vd->getNumEntries() && !abort; ++i)
     {
         ViewData::Entry& entry = vd->getEntry(i);
         loadRenderingNode(entry, vd, mVertexLodMod, mChunkManager.get());
+        loadChunkNodes(entry, activeGrid, mChunkManagers);
     }
     vd->markUnchanged();
 }
@@ -461,9 +776,9 @@ void QuadTreeWorld::storeView(const View* view, double referenceTime)
     osg::ref_ptr<osg::Object> dummy = new osg::DummyObject;
     const ViewData* vd = static_cast<const ViewData*>(view);
     bool needsUpdate = false;
-    ViewData* stored = mViewDataMap->getViewData(dummy, vd->getViewPoint(), needsUpdate);
+    ViewData* stored = mViewDataMap->getViewData(dummy, vd->getViewPoint(), referenceTime, needsUpdate);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(stored->getMutex());
     stored->copyFrom(*vd);
-    stored->setLastUsageTimeStamp(referenceTime);
 }
 
 void QuadTreeWorld::reportStats(unsigned int frameNumber, osg::Stats *stats)
@@ -471,6 +786,11 @@ void QuadTreeWorld::reportStats(unsigned int frameNumber, osg::Stats *stats)
     stats->setAttribute(frameNumber, "Composite", mCompositeMapRenderer->getCompileSetSize());
 }
 
+void QuadTreeWorld::addChunkManager(QuadTreeChunkManager* chunkManager)
+{
+    mChunkManagers.push_back(chunkManager);
+}
+
 void QuadTreeWorld::loadCell(int x, int y)
 {
     // fallback behavior only for undefined cells (every other is already handled in quadtree)
@@ -479,6 +799,8 @@ void QuadTreeWorld::loadCell(int x, int y)
         TerrainGrid::loadCell(x,y);
     else
         World::loadCell(x,y);
+
+    updateActiveGrid();
 }
 
 void QuadTreeWorld::unloadCell(int x, int y)
@@ -489,6 +811,24 @@ void QuadTreeWorld::unloadCell(int x, int y)
         TerrainGrid::unloadCell(x,y);
     else
         World::unloadCell(x,y);
+
+    updateActiveGrid();
+}
+
+void QuadTreeWorld::updateActiveGrid()
+{
+    osg::Vec4i grid(0, 0, -1, -1);
+    for (std::set<std::pair<int,int>>::const_iterator it = mLoadedCells.begin(); it != mLoadedCells.end(); ++it)
+    {
+        if (it == mLoadedCells.begin())
+            grid = osg::Vec4i(it->first, it->second, it->first, it->second);
+        else
+            grid = osg::Vec4i(std::min(grid[0], it->first), std::min(grid[1], it->second),
+                              std::max(grid[2], it->first), std::max(grid[3], it->second));
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mActiveGridMutex);
+    mActiveGrid = grid;
 }
 
 
@@ -6,8 +6,16 @@
 
 #include <OpenThreads/Mutex>
 
+#include <osg/Vec2f>
+#include <osg/Vec4i>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace osg
 {
+    class Node;
     class NodeVisitor;
 }
 
@@ -16,6 +24,22 @@ namespace Terrain
     class RootNode;
     class ViewDataMap;
     class LodCallback;
+    class QuadTreeNode;
+    class ViewData;
+    class PendingChunks;
+
+    /// @brief Provides content other than terrain that is paged along with the terrain quad tree, e.g. distant objects.
+    class QuadTreeChunkManager
+    {
+    public:
+        virtual ~QuadTreeChunkManager() {}
+
+        /// @param activeGrid Cells (min x, min y, max x, max y) whose content is rendered elsewhere and has to be left out.
+        /// An empty grid has min > max.
+        /// @return nullptr if there is nothing to render for this quad tree node.
+        /// @note Thread safe.
+        virtual osg::ref_ptr<osg::Node> getChunk(float size, const osg::Vec2f& center, const osg::Vec4i& activeGrid) = 0;
+    };
 
     /// @brief Terrain implementation that loads cells into a Quad Tree, with geometry LOD and texture LOD.
     class QuadTreeWorld : public TerrainGrid // note: derived from TerrainGrid is only to render default cells (see loadCell)
@@ -25,6 +49,8 @@ namespace Terrain
 
         ~QuadTreeWorld();
 
+        /// @note Chunks that are not cached yet are built in the WorkQueue, if one is set, while the cull traversal draws
+        /// the closest cached ancestor in their place.
         void accept(osg::NodeVisitor& nv);
 
         virtual void enable(bool enabled);
@@ -43,19 +69,39 @@ namespace Terrain
 
         void reportStats(unsigned int frameNumber, osg::Stats* stats);
 
+        /// Render content of the chunk manager for each quad tree node in view, the chunk manager must outlive this world.
+        /// @note Not thread safe, must be called before the world is rendered or preloaded.
+        void addChunkManager(QuadTreeChunkManager* chunkManager);
+
     private:
         void ensureQuadTreeBuilt();
+        void updateActiveGrid();
+
+        /// Nodes drawn in place of entries whose chunk is not built yet, with their chunks
+        typedef std::vector<std::pair<QuadTreeNode*, osg::ref_ptr<osg::Node>>> Fallbacks;
+
+        /// Find the closest ancestor with a cached chunk to draw instead of the node.
+        void addFallback(QuadTreeNode* node, ViewData* vd, Fallbacks& fallbacks);
+        static bool isCoveredByFallback(QuadTreeNode* node, const Fallbacks& fallbacks);
 
         osg::ref_ptr<RootNode> mRootNode;
 
         osg::ref_ptr<ViewDataMap> mViewDataMap;
         osg::ref_ptr<LodCallback> mLodCallback;
 
+        std::vector<QuadTreeChunkManager*> mChunkManagers;
+        /// Grid of the loaded cells, see QuadTreeChunkManager::getChunk
+        osg::Vec4i mActiveGrid;
+        OpenThreads::Mutex mActiveGridMutex;
+
         OpenThreads::Mutex mQuadTreeMutex;
         bool mQuadTreeBuilt;
         float mLodFactor;
         int mVertexLodMod;
         float mViewDistance;
+        /// Shared with queued work items, which may outlive this world
+        std::shared_ptr<PendingChunks> mPendingChunks;
+        std::shared_ptr<std::atomic<bool>> mAbortLoading;
     };
 
 }
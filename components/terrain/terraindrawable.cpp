@@ -1,5 +1,9 @@
 #include "terraindrawable.hpp"
 
+#include <cmath>
+
+#include <osg/Image>
+
 #include <osgUtil/CullVisitor>
 
 #include <components/sceneutil/lightmanager.hpp>
@@ -13,6 +17,8 @@ TerrainDrawable::TerrainDrawable(const TerrainDrawable &copy, const osg::CopyOp
     : osg::Geometry(copy, copyop)
     , mPasses(copy.mPasses)
     , mLightListCallback(copy.mLightListCallback)
+    , mHeightmap(copy.mHeightmap)
+    , mHeightmapSize(copy.mHeightmapSize)
 {
 
 }
@@ -31,6 +37,42 @@ void TerrainDrawable::accept(osg::NodeVisitor &nv)
     }
 }
 
+void TerrainDrawable::accept(osg::PrimitiveFunctor& functor) const
+{
+    // PrimitiveFunctors only support float vertex arrays, and don't know about the displacement in the vertex shader
+    std::vector<osg::Vec3f> vertices;
+    if (mHeightmap)
+    {
+        // Same as heightmap_vertex.glsl
+        const osg::Vec2Array& grid = static_cast<const osg::Vec2Array&>(*getVertexArray());
+        const int size = mHeightmap->s();
+        vertices.reserve(grid.size());
+        for (const osg::Vec2f& coord : grid)
+        {
+            const int s = static_cast<int>(std::round(coord.x() * (size - 1)));
+            const int t = static_cast<int>(std::round(coord.y() * (size - 1)));
+            const float height = *reinterpret_cast<const float*>(mHeightmap->data(s, t));
+            vertices.emplace_back((coord.x() - 0.5f) * mHeightmapSize, (0.5f - coord.y()) * mHeightmapSize, height);
+        }
+    }
+    else if (const osg::Vec4sArray* positions = dynamic_cast<const osg::Vec4sArray*>(getVertexArray()))
+    {
+        vertices.reserve(positions->size());
+        for (const osg::Vec4s& position : *positions)
+            vertices.emplace_back(position.x(), position.y(), position.z());
+    }
+    else
+    {
+        osg::Geometry::accept(functor);
+        return;
+    }
+
+    functor.setVertexArray(vertices.size(), vertices.data());
+
+    for (unsigned int i = 0; i < getNumPrimitiveSets(); ++i)
+        getPrimitiveSet(i)->accept(functor);
+}
+
 inline float distance(const osg::Vec3& coord,const osg::Matrix& matrix)
 {
     return -((float)coord[0]*(float)matrix(0,2)+(float)coord[1]*(float)matrix(1,2)+(float)coord[2]*(float)matrix(2,2)+matrix(3,2));
@@ -36,6 +36,10 @@ namespace Terrain
         TerrainDrawable(const TerrainDrawable& copy, const osg::CopyOp& copyop);
 
         virtual void accept(osg::NodeVisitor &nv);
+
+        /// Also supports the quantized positions of ChunkManager::setCompactVertices and the displaced grid of
+        /// ChunkManager::setGpuDisplacement, e.g. for bounds and intersections.
+        virtual void accept(osg::PrimitiveFunctor& functor) const;
         void cull(osgUtil::CullVisitor* cv);
 
         typedef std::vector<osg::ref_ptr<osg::StateSet> > PassVector;
@@ -48,12 +52,18 @@ namespace Terrain
         void setCompositeMap(CompositeMap* map) { mCompositeMap = map; }
         void setCompositeMapRenderer(CompositeMapRenderer* renderer) { mCompositeMapRenderer = renderer; }
 
+        /// The vertex array holds grid coordinates that are displaced by these heights, see ChunkManager::setGpuDisplacement.
+        /// @param size Size of the chunk in world units
+        void setHeightmap(osg::Image* heights, float size) { mHeightmap = heights; mHeightmapSize = size; }
+
     private:
         PassVector mPasses;
 
         osg::ref_ptr<SceneUtil::LightListCallback> mLightListCallback;
         osg::ref_ptr<CompositeMap> mCompositeMap;
         osg::ref_ptr<CompositeMapRenderer> mCompositeMapRenderer;
+        osg::ref_ptr<osg::Image> mHeightmap;
+        float mHeightmapSize = 0.f;
     };
 
 }
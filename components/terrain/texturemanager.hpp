@@ -27,6 +27,8 @@ namespace Terrain
 
         osg::ref_ptr<osg::Texture2D> getTexture(const std::string& name);
 
+        virtual const char* getName() const { return "Terrain Texture"; }
+
         virtual void reportStats(unsigned int frameNumber, osg::Stats* stats) const;
 
     private:
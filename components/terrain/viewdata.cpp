@@ -1,10 +1,15 @@
 #include "viewdata.hpp"
 
+#include <algorithm>
+
+#include <OpenThreads/ScopedLock>
+
 namespace Terrain
 {
 
 ViewData::ViewData()
     : mNumEntries(0)
+    , mSortedNodesValid(false)
     , mLastUsageTimeStamp(0.0)
     , mChanged(false)
     , mHasViewPoint(false)
@@ -21,6 +26,7 @@ void ViewData::copyFrom(const ViewData& other)
 {
     mNumEntries = other.mNumEntries;
     mEntries = other.mEntries;
+    mSortedNodesValid = false;
     mChanged = other.mChanged;
     mHasViewPoint = other.mHasViewPoint;
     mViewPoint = other.mViewPoint;
@@ -29,6 +35,7 @@ void ViewData::copyFrom(const ViewData& other)
 void ViewData::add(QuadTreeNode *node)
 {
     unsigned int index = mNumEntries++;
+    mSortedNodesValid = false;
 
     if (index+1 > mEntries.size())
         mEntries.resize(index+1);
@@ -77,6 +84,7 @@ void ViewData::reset()
 
     // reset index for next frame
     mNumEntries = 0;
+    mSortedNodesValid = false;
     mChanged = false;
 }
 
@@ -85,6 +93,7 @@ void ViewData::clear()
     for (unsigned int i=0; i<mEntries.size(); ++i)
         mEntries[i].set(nullptr);
     mNumEntries = 0;
+    mSortedNodesValid = false;
     mLastUsageTimeStamp = 0;
     mChanged = false;
     mHasViewPoint = false;
@@ -92,15 +101,23 @@ void ViewData::clear()
 
 bool ViewData::contains(QuadTreeNode *node)
 {
-    for (unsigned int i=0; i<mNumEntries; ++i)
-        if (mEntries[i].mNode == node)
-            return true;
-    return false;
+    // Called for the neighbours of every entry when the view changed, a linear search would be quadratic
+    if (!mSortedNodesValid)
+    {
+        mSortedNodes.clear();
+        for (unsigned int i=0; i<mNumEntries; ++i)
+            mSortedNodes.push_back(mEntries[i].mNode);
+        std::sort(mSortedNodes.begin(), mSortedNodes.end());
+        mSortedNodesValid = true;
+    }
+    return std::binary_search(mSortedNodes.begin(), mSortedNodes.end(), node);
 }
 
 ViewData::Entry::Entry()
     : mNode(nullptr)
     , mLodFlags(0)
+    , mRenderingLodFlags(0)
+    , mChunksLoaded(false)
 {
 
 }
@@ -114,6 +131,10 @@ bool ViewData::Entry::set(QuadTreeNode *node)
         mNode = node;
         // clear cached data
         mRenderingNode = nullptr;
+        mPendingRenderingNode = nullptr;
+        mChunkNodes.clear();
+        mChunksLoaded = false;
+        mPendingChunkNodes = nullptr;
         return true;
     }
 }
@@ -123,8 +144,10 @@ bool suitable(ViewData* vd, const osg::Vec3f& viewPoint, float& maxDist)
     return vd->hasViewPoint() && (vd->getViewPoint() - viewPoint).length2() < maxDist*maxDist;
 }
 
-ViewData *ViewDataMap::getViewData(osg::Object *viewer, const osg::Vec3f& viewPoint, bool& needsUpdate)
+ViewData *ViewDataMap::getViewData(osg::Object *viewer, const osg::Vec3f& viewPoint, double referenceTime, bool& needsUpdate)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
     Map::const_iterator found = mViews.find(viewer);
     ViewData* vd = nullptr;
     if (found == mViews.end())
@@ -135,10 +158,18 @@ ViewData *ViewDataMap::getViewData(osg::Object *viewer, const osg::Vec3f& viewPo
     else
         vd = found->second;
 
+    // Only changed with mMutex locked, so clearUnusedViews never expires a view that was just handed out
+    if (referenceTime != 0.0)
+        vd->setLastUsageTimeStamp(referenceTime);
+
     if (!suitable(vd, viewPoint, mReuseDistance))
     {
         for (Map::const_iterator other = mViews.begin(); other != mViews.end(); ++other)
         {
+            if (other->second == vd)
+                continue;
+            // The other view may be in use by a camera culled in parallel
+            OpenThreads::ScopedLock<OpenThreads::Mutex> otherLock(other->second->getMutex());
             if (suitable(other->second, viewPoint, mReuseDistance) && other->second->getNumEntries())
             {
                 vd->copyFrom(*other->second);
@@ -165,18 +196,21 @@ ViewData *ViewDataMap::createOrReuseView()
     }
     else
     {
-        mViewVector.push_back(ViewData());
+        mViewVector.emplace_back();
         return &mViewVector.back();
     }
 }
 
 void ViewDataMap::clearUnusedViews(double referenceTime)
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
     for (Map::iterator it = mViews.begin(); it != mViews.end(); )
     {
         ViewData* vd = it->second;
         if (vd->getLastUsageTimeStamp() + mExpiryDelay < referenceTime)
         {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> viewLock(vd->getMutex());
             vd->clear();
             mUnusedViews.push_back(vd);
             mViews.erase(it++);
@@ -188,6 +222,8 @@ void ViewDataMap::clearUnusedViews(double referenceTime)
 
 void ViewDataMap::clear()
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(mMutex);
+
     mViews.clear();
     mUnusedViews.clear();
     mViewVector.clear();
@@ -5,6 +5,11 @@
 #include <deque>
 
 #include <osg/Node>
+#include <osg/Vec4i>
+
+#include <OpenThreads/Mutex>
+
+#include <components/sceneutil/workqueue.hpp>
 
 #include "world.hpp"
 
@@ -25,6 +30,7 @@ namespace Terrain
 
         void clear();
 
+        /// Uses a sorted index of the entries, built on the first call after the entries changed.
         bool contains(QuadTreeNode* node);
 
         void copyFrom(const ViewData& other);
@@ -39,6 +45,18 @@ namespace Terrain
 
             unsigned int mLodFlags;
             osg::ref_ptr<osg::Node> mRenderingNode;
+            /// Lod flags mRenderingNode was built with. It is still drawn while the chunk for changed mLodFlags is built.
+            unsigned int mRenderingLodFlags;
+            /// Builds mRenderingNode in the background, see QuadTreeWorld::accept
+            osg::ref_ptr<SceneUtil::WorkItem> mPendingRenderingNode;
+
+            /// Content of QuadTreeChunkManagers, valid if mChunksLoaded
+            std::vector<osg::ref_ptr<osg::Node>> mChunkNodes;
+            /// Active grid the chunk nodes were loaded for
+            osg::Vec4i mChunksGrid;
+            bool mChunksLoaded;
+            /// Loads mChunkNodes in the background
+            osg::ref_ptr<SceneUtil::WorkItem> mPendingChunkNodes;
         };
 
         unsigned int getNumEntries() const;
@@ -57,13 +75,19 @@ namespace Terrain
         void setViewPoint(const osg::Vec3f& viewPoint);
         const osg::Vec3f& getViewPoint() const;
 
+        /// Lock while the view is used or changed, cameras may be culled in parallel.
+        OpenThreads::Mutex& getMutex() { return mMutex; }
+
     private:
         std::vector<Entry> mEntries;
         unsigned int mNumEntries;
+        std::vector<QuadTreeNode*> mSortedNodes; // nodes of the entries for contains(), valid if mSortedNodesValid
+        bool mSortedNodesValid;
         double mLastUsageTimeStamp;
         bool mChanged;
         osg::Vec3f mViewPoint;
         bool mHasViewPoint;
+        OpenThreads::Mutex mMutex;
     };
 
     class ViewDataMap : public osg::Referenced
@@ -75,15 +99,18 @@ namespace Terrain
             , mExpiryDelay(1.f)
         {}
 
-        ViewData* getViewData(osg::Object* viewer, const osg::Vec3f& viewPoint, bool& needsUpdate);
-
-        ViewData* createOrReuseView();
+        /// @param referenceTime Marks the view as used at this time, unless 0, so clearUnusedViews does not remove it
+        ///  while a camera culled in parallel uses it.
+        ViewData* getViewData(osg::Object* viewer, const osg::Vec3f& viewPoint, double referenceTime, bool& needsUpdate);
 
         void clearUnusedViews(double referenceTime);
 
         void clear();
 
     private:
+        ViewData* createOrReuseView();
+
+
         std::list<ViewData> mViewVector;
 
         typedef std::map<osg::ref_ptr<osg::Object>, ViewData*> Map;
@@ -93,6 +120,8 @@ namespace Terrain
         float mExpiryDelay; // time in seconds for unused view to be removed
 
         std::deque<ViewData*> mUnusedViews;
+
+        OpenThreads::Mutex mMutex;
     };
 
 }
@@ -5,11 +5,13 @@
 #include <osg/Camera>
 
 #include <components/resource/resourcesystem.hpp>
+#include <components/sceneutil/workqueue.hpp>
 
 #include "storage.hpp"
 #include "texturemanager.hpp"
 #include "chunkmanager.hpp"
 #include "compositemaprenderer.hpp"
+#include "compositemapdiskcache.hpp"
 
 namespace Terrain
 {
@@ -18,6 +20,7 @@ World::World(osg::Group* parent, osg::Group* compileRoot, Resource::ResourceSyst
     : mStorage(storage)
     , mParent(parent)
     , mResourceSystem(resourceSystem)
+    , mWorkQueue(nullptr)
     , mBorderVisible(false)
 {
     mTerrainRoot = new osg::Group;
@@ -46,7 +49,7 @@ World::World(osg::Group* parent, osg::Group* compileRoot, Resource::ResourceSyst
     mParent->addChild(mTerrainRoot);
 
     mTextureManager.reset(new TextureManager(mResourceSystem->getSceneManager()));
-    mChunkManager.reset(new ChunkManager(mStorage, mResourceSystem->getSceneManager(), mTextureManager.get(), mCompositeMapRenderer));
+    mChunkManager = new ChunkManager(mStorage, mResourceSystem->getSceneManager(), mTextureManager.get(), mCompositeMapRenderer);
     mCellBorder.reset(new CellBorder(this,mTerrainRoot.get(),borderMask));
 
     mResourceSystem->addResourceManager(mChunkManager.get());
@@ -68,6 +71,7 @@ World::~World()
 
 void World::setWorkQueue(SceneUtil::WorkQueue* workQueue)
 {
+    mWorkQueue = workQueue;
     mCompositeMapRenderer->setWorkQueue(workQueue);
 }
 
@@ -105,6 +109,28 @@ void World::setTargetFrameRate(float rate)
     mCompositeMapRenderer->setTargetFrameRate(rate);
 }
 
+void World::setPackBlendmaps(bool pack)
+{
+    mChunkManager->setPackBlendmaps(pack);
+}
+
+void World::setCompactVertices(bool compact)
+{
+    mChunkManager->setCompactVertices(compact);
+}
+
+void World::setGpuDisplacement(bool enabled)
+{
+    mChunkManager->setGpuDisplacement(enabled);
+}
+
+void World::setCompositeMapDiskCache(const std::string& path, std::uint64_t maxSize)
+{
+    osg::ref_ptr<CompositeMapDiskCache> diskCache = new CompositeMapDiskCache(path, maxSize);
+    mCompositeMapRenderer->setDiskCache(diskCache);
+    mChunkManager->setCompositeMapDiskCache(diskCache);
+}
+
 float World::getHeightAt(const osg::Vec3f &worldPos)
 {
     return mStorage->getHeightAt(worldPos);
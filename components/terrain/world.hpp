@@ -6,9 +6,11 @@
 #include <osg/Vec3f>
 
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <atomic>
+#include <string>
 
 #include "defs.hpp"
 #include "cellborder.hpp"
@@ -67,11 +69,29 @@ namespace Terrain
         virtual ~World();
 
         /// Set a WorkQueue to delete objects in the background thread.
+        /// @note The QuadTreeWorld also builds chunks that are missing during the cull traversal in it.
         void setWorkQueue(SceneUtil::WorkQueue* workQueue);
 
         /// See CompositeMapRenderer::setTargetFrameRate
         void setTargetFrameRate(float rate);
 
+        /// See ChunkManager::setPackBlendmaps
+        /// @note Only affects chunks created afterwards.
+        void setPackBlendmaps(bool pack);
+
+        /// See ChunkManager::setCompactVertices
+        /// @note Only affects chunks created afterwards.
+        void setCompactVertices(bool compact);
+
+        /// See ChunkManager::setGpuDisplacement
+        /// @note Only affects chunks created afterwards.
+        void setGpuDisplacement(bool enabled);
+
+        /// Store rendered composite maps in this directory and reuse them on next runs, see CompositeMapDiskCache.
+        /// @param maxSize limit of the total size of the stored files in bytes
+        /// @note Only affects chunks created afterwards.
+        void setCompositeMapDiskCache(const std::string& path, std::uint64_t maxSize);
+
         /// Apply the scene manager's texture filtering settings to all cached textures.
         /// @note Thread safe.
         void updateTextureFiltering();
@@ -127,8 +147,12 @@ namespace Terrain
 
         Resource::ResourceSystem* mResourceSystem;
 
+        /// Not owned, the owner destroys it to stop the background work before the world is destroyed
+        SceneUtil::WorkQueue* mWorkQueue;
+
         std::unique_ptr<TextureManager> mTextureManager;
-        std::unique_ptr<ChunkManager> mChunkManager;
+        /// Shared with the work items building chunks in the background
+        osg::ref_ptr<ChunkManager> mChunkManager;
 
         std::unique_ptr<CellBorder> mCellBorder;
 
@@ -2,6 +2,9 @@
 
 #include <vector>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
 #include <components/debug/debuglog.hpp>
@@ -44,8 +47,32 @@
 
 using namespace ToUTF8;
 
+namespace
+{
+    /// Length of the leading run of ASCII characters before the first non-ASCII character or zero, which must be
+    /// found at \a end at the latest. Checks 8 characters at a time, strings from content files are almost entirely
+    /// ASCII.
+    size_t getAsciiLength(const char* input, const char* end)
+    {
+        const char* ptr = input;
+        while (end - ptr >= static_cast<std::ptrdiff_t>(sizeof(std::uint64_t)))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            // Nonzero if any byte has its high bit set or is zero, may also flag bytes after a zero one
+            if (((word - 0x0101010101010101ull) | word) & 0x8080808080808080ull)
+                break;
+            ptr += sizeof(word);
+        }
+        while (*ptr && static_cast<unsigned char>(*ptr) < 128)
+            ++ptr;
+        return ptr - input;
+    }
+}
+
 Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
     mOutput(50*1024)
+    , mSourceEncoding(sourceEncoding)
 {
     switch (sourceEncoding)
     {
@@ -78,6 +105,13 @@ Utf8Encoder::Utf8Encoder(const FromType sourceEncoding):
 }
 
 std::string Utf8Encoder::getUtf8(const char* input, size_t size)
+{
+    std::string output;
+    getUtf8(input, size, output);
+    return output;
+}
+
+void Utf8Encoder::getUtf8(const char* input, size_t size, std::string& output)
 {
     // Double check that the input string stops at some point (it might
     // contain zero terminators before this, inside its own data, which
@@ -93,29 +127,31 @@ std::string Utf8Encoder::getUtf8(const char* input, size_t size)
     // Compute output length, and check for pure ascii input at the same
     // time.
     bool ascii;
-    size_t outlen = getLength(input, ascii);
+    size_t outlen = getLength(input, size, ascii);
 
     // If we're pure ascii, then don't bother converting anything.
     if(ascii)
-        return std::string(input, outlen);
-
-    // Make sure the output is large enough
-    resize(outlen);
-    char *out = &mOutput[0];
+    {
+        output.assign(input, outlen);
+        return;
+    }
 
-    // Translate
+    // Translate straight into the output string, reusing its capacity
+    output.resize(outlen);
+    char *out = &output[0];
+    const char* const end = input + size;
     while (*input)
-        copyFromArray(*(input++), out);
+    {
+        const size_t asciiLength = getAsciiLength(input, end);
+        std::memcpy(out, input, asciiLength);
+        out += asciiLength;
+        input += asciiLength;
+        if (*input)
+            copyFromArray(*(input++), out);
+    }
 
     // Make sure that we wrote the correct number of bytes
-    assert((out-&mOutput[0]) == (int)outlen);
-
-    // And make extra sure the output is null terminated
-    assert(mOutput.size() > outlen);
-    assert(mOutput[outlen] == 0);
-
-    // Return a string
-    return std::string(&mOutput[0], outlen);
+    assert((out-&output[0]) == (int)outlen);
 }
 
 std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
@@ -134,7 +170,7 @@ std::string Utf8Encoder::getLegacyEnc(const char *input, size_t size)
     // Compute output length, and check for pure ascii input at the same
     // time.
     bool ascii;
-    size_t outlen = getLength2(input, ascii);
+    size_t outlen = getLength2(input, size, ascii);
 
     // If we're pure ascii, then don't bother converting anything.
     if(ascii)
@@ -182,17 +218,15 @@ void Utf8Encoder::resize(size_t size)
   is the case, then the ascii parameter is set to true, and the
   caller can optimize for this case.
  */
-size_t Utf8Encoder::getLength(const char* input, bool &ascii)
+size_t Utf8Encoder::getLength(const char* input, size_t size, bool &ascii)
 {
     ascii = true;
     size_t len = 0;
-    const char* ptr = input;
-    unsigned char inp = *ptr;
 
     // Do away with the ascii part of the string first (this is almost
     // always the entire string.)
-    while (inp && inp < 128)
-        inp = *(++ptr);
+    const char* ptr = input + getAsciiLength(input, input + size);
+    unsigned char inp = *ptr;
     len += (ptr-input);
 
     // If we're not at the null terminator at this point, then there
@@ -229,17 +263,15 @@ void Utf8Encoder::copyFromArray(unsigned char ch, char* &out)
         *(out++) = *(in++);
 }
 
-size_t Utf8Encoder::getLength2(const char* input, bool &ascii)
+size_t Utf8Encoder::getLength2(const char* input, size_t size, bool &ascii)
 {
     ascii = true;
     size_t len = 0;
-    const char* ptr = input;
-    unsigned char inp = *ptr;
 
     // Do away with the ascii part of the string first (this is almost
     // always the entire string.)
-    while (inp && inp < 128)
-        inp = *(++ptr);
+    const char* ptr = input + getAsciiLength(input, input + size);
+    unsigned char inp = *ptr;
     len += (ptr-input);
 
     // If we're not at the null terminator at this point, then there
@@ -27,6 +27,10 @@ namespace ToUTF8
         public:
             Utf8Encoder(FromType sourceEncoding);
 
+            /// Code page this encoder converts from. Encoders are not thread safe,
+            /// so threads need their own encoder for the same code page.
+            FromType getSourceEncoding() const { return mSourceEncoding; }
+
             // Convert to UTF8 from the previously given code page.
             std::string getUtf8(const char *input, size_t size);
             inline std::string getUtf8(const std::string &str)
@@ -34,6 +38,9 @@ namespace ToUTF8
                 return getUtf8(str.c_str(), str.size());
             }
 
+            /// Convert to UTF8 into \a output, reusing its memory. \a input must be zero terminated at \a size.
+            void getUtf8(const char *input, size_t size, std::string &output);
+
             std::string getLegacyEnc(const char *input, size_t size);
             inline std::string getLegacyEnc(const std::string &str)
             {
@@ -42,13 +49,14 @@ namespace ToUTF8
 
         private:
             void resize(size_t size);
-            size_t getLength(const char* input, bool &ascii);
+            size_t getLength(const char* input, size_t size, bool &ascii);
             void copyFromArray(unsigned char chp, char* &out);
-            size_t getLength2(const char* input, bool &ascii);
+            size_t getLength2(const char* input, size_t size, bool &ascii);
             void copyFromArray2(const char*& chp, char* &out);
 
             std::vector<char> mOutput;
             signed char* translationArray;
+            FromType mSourceEncoding;
     };
 }
 
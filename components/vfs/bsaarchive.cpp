@@ -2,6 +2,12 @@
 #include <components/bsa/compressedbsafile.hpp>
 #include <memory>
 
+namespace
+{
+    // Mapping every archive can exhaust the address space of 32-bit builds
+    const bool sMemoryMapArchives = sizeof(void*) >= 8;
+}
+
 namespace VFS
 {
 
@@ -16,7 +22,7 @@ BsaArchive::BsaArchive(const std::string &filename)
         mFile = std::make_unique<Bsa::BSAFile>(Bsa::BSAFile());
     }
 
-    mFile->open(filename);
+    mFile->open(filename, sMemoryMapArchives);
 
     const Bsa::BSAFile::FileList &filelist = mFile->getList();
     for(Bsa::BSAFile::FileList::const_iterator it = filelist.begin();it != filelist.end();++it)
@@ -29,7 +29,8 @@ namespace VFS
 
             for (directory_iterator i (mPath); i != end; ++i)
             {
-                if(boost::filesystem::is_directory (*i))
+                // The entry keeps the status read with it, don't query the file system again
+                if (boost::filesystem::is_directory(i->status()))
                     continue;
 
                 std::string proper = i->path ().string ();
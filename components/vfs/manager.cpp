@@ -1,6 +1,13 @@
 #include "manager.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <map>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include <components/misc/stringops.hpp>
 
@@ -25,6 +32,31 @@ namespace
         std::transform(path.begin(), path.end(), path.begin(), normalize_char);
     }
 
+    /// Name lookup key, compared the same way as std::string
+    struct Key
+    {
+        const char* mData;
+        size_t mSize;
+    };
+
+    int compare(const std::string& left, const Key& right)
+    {
+        int res = std::memcmp(left.data(), right.mData, std::min(left.size(), right.mSize));
+        if (res != 0)
+            return res;
+        if (left.size() == right.mSize)
+            return 0;
+        return left.size() < right.mSize ? -1 : 1;
+    }
+
+    bool startsWith(const std::string& name, const std::string& prefix)
+    {
+        return name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    // Should fit all but the most deeply nested resource paths
+    const size_t sLookupBufferSize = 256;
+
 }
 
 namespace VFS
@@ -58,39 +90,109 @@ namespace VFS
     {
         mIndex.clear();
 
-        for (std::vector<Archive*>::const_iterator it = mArchives.begin(); it != mArchives.end(); ++it)
-            (*it)->listResources(mIndex, mStrict ? &strict_normalize_char : &nonstrict_normalize_char);
+        char (*normalize_function)(char) = mStrict ? &strict_normalize_char : &nonstrict_normalize_char;
+
+        // Listing data directories walks the file system, so list several archives at once
+        std::vector<std::map<std::string, File*>> listed(mArchives.size());
+        std::atomic<std::size_t> nextArchive(0);
+        const std::size_t numThreads = std::min<std::size_t>(mArchives.size(), std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<std::future<void>> workers;
+        workers.reserve(numThreads);
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            workers.push_back(std::async(std::launch::async, [&] {
+                for (std::size_t archive = nextArchive++; archive < mArchives.size(); archive = nextArchive++)
+                    mArchives[archive]->listResources(listed[archive], normalize_function);
+            }));
+        }
+        // All workers must be done with the lists before an error is rethrown
+        for (std::future<void>& worker : workers)
+            worker.wait();
+        for (std::future<void>& worker : workers)
+            worker.get();
+
+        // Later archives have the higher priority
+        std::map<std::string, File*> merged;
+        for (std::map<std::string, File*>& files : listed)
+        {
+            for (std::map<std::string, File*>::iterator it = files.begin(); it != files.end(); ++it)
+                merged[it->first] = it->second;
+            files.clear();
+        }
+
+        // The map is already sorted, flatten it for cache friendly lookups
+        mIndex.reserve(merged.size());
+        for (std::map<std::string, File*>::iterator it = merged.begin(); it != merged.end(); ++it)
+            mIndex.emplace_back(std::move(it->first), it->second);
     }
 
-    Files::IStreamPtr Manager::get(const std::string &name) const
+    File* Manager::find(const char* normalizedName, size_t size) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
+        const Key key {normalizedName, size};
+        Index::const_iterator found = std::lower_bound(mIndex.begin(), mIndex.end(), key,
+            [] (const Index::value_type& entry, const Key& key) { return compare(entry.first, key) < 0; });
+        if (found == mIndex.end() || compare(found->first, key) != 0)
+            return nullptr;
+        return found->second;
+    }
 
-        return getNormalized(normalized);
+    File* Manager::findNormalized(const std::string& name) const
+    {
+        if (name.size() > sLookupBufferSize)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            return find(normalized.data(), normalized.size());
+        }
+
+        char buffer[sLookupBufferSize];
+        char (*normalize_char)(char) = mStrict ? &strict_normalize_char : &nonstrict_normalize_char;
+        std::transform(name.begin(), name.end(), buffer, normalize_char);
+        return find(buffer, name.size());
+    }
+
+    Files::IStreamPtr Manager::get(const std::string &name) const
+    {
+        File* file = findNormalized(name);
+        if (!file)
+        {
+            std::string normalized = name;
+            normalize_path(normalized, mStrict);
+            throw std::runtime_error("Resource '" + normalized + "' not found");
+        }
+        return file->open();
     }
 
     Files::IStreamPtr Manager::getNormalized(const std::string &normalizedName) const
     {
-        std::map<std::string, File*>::const_iterator found = mIndex.find(normalizedName);
-        if (found == mIndex.end())
+        File* file = find(normalizedName.data(), normalizedName.size());
+        if (!file)
             throw std::runtime_error("Resource '" + normalizedName + "' not found");
-        return found->second->open();
+        return file->open();
     }
 
     bool Manager::exists(const std::string &name) const
     {
-        std::string normalized = name;
-        normalize_path(normalized, mStrict);
-
-        return mIndex.find(normalized) != mIndex.end();
+        return findNormalized(name) != nullptr;
     }
 
-    const std::map<std::string, File*>& Manager::getIndex() const
+    const Index& Manager::getIndex() const
     {
         return mIndex;
     }
 
+    RecursiveDirectoryRange Manager::getRecursiveDirectoryIterator(const std::string& path) const
+    {
+        std::string normalized = path;
+        normalize_path(normalized, mStrict);
+
+        Index::const_iterator begin = std::lower_bound(mIndex.begin(), mIndex.end(), normalized,
+            [] (const Index::value_type& entry, const std::string& prefix) { return entry.first < prefix; });
+        Index::const_iterator end = std::partition_point(begin, mIndex.end(),
+            [&] (const Index::value_type& entry) { return startsWith(entry.first, normalized); });
+        return RecursiveDirectoryRange(begin, end);
+    }
+
     void Manager::normalizeFilename(std::string &name) const
     {
         normalize_path(name, mStrict);
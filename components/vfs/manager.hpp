@@ -3,8 +3,9 @@
 
 #include <components/files/constrainedfilestream.hpp>
 
+#include <string>
+#include <utility>
 #include <vector>
-#include <map>
 
 namespace VFS
 {
@@ -12,6 +13,39 @@ namespace VFS
     class Archive;
     class File;
 
+    /// @brief Sorted, contiguous file index, mapping normalized file names to files.
+    typedef std::vector<std::pair<std::string, File*> > Index;
+
+    /// @brief Iterates over the normalized names of the files in a part of the index.
+    class RecursiveDirectoryIterator
+    {
+    public:
+        RecursiveDirectoryIterator(Index::const_iterator it) : mIt(it) {}
+
+        const std::string& operator*() const { return mIt->first; }
+        const std::string* operator->() const { return &mIt->first; }
+        bool operator==(const RecursiveDirectoryIterator& other) const { return mIt == other.mIt; }
+        bool operator!=(const RecursiveDirectoryIterator& other) const { return mIt != other.mIt; }
+        RecursiveDirectoryIterator& operator++() { ++mIt; return *this; }
+
+    private:
+        Index::const_iterator mIt;
+    };
+
+    /// @brief All files below a given path, in sorted order. Usable in range-based for loops.
+    class RecursiveDirectoryRange
+    {
+    public:
+        RecursiveDirectoryRange(Index::const_iterator begin, Index::const_iterator end) : mBegin(begin), mEnd(end) {}
+
+        RecursiveDirectoryIterator begin() const { return mBegin; }
+        RecursiveDirectoryIterator end() const { return mEnd; }
+
+    private:
+        Index::const_iterator mBegin;
+        Index::const_iterator mEnd;
+    };
+
     /// @brief The main class responsible for loading files from a virtual file system.
     /// @par Various archive types (e.g. directories on the filesystem, or compressed archives)
     /// can be registered, and will be merged into a single file tree. If the same filename is
@@ -40,9 +74,13 @@ namespace VFS
         /// @note May be called from any thread once the index has been built.
         bool exists(const std::string& name) const;
 
-        /// Get a complete list of files from all archives
+        /// Get a complete list of files from all archives, sorted by normalized name
         /// @note May be called from any thread once the index has been built.
-        const std::map<std::string, File*>& getIndex() const;
+        const Index& getIndex() const;
+
+        /// Get all files below the given path, which is normalized first. An empty path lists all files.
+        /// @note May be called from any thread once the index has been built.
+        RecursiveDirectoryRange getRecursiveDirectoryIterator(const std::string& path) const;
 
         /// Normalize the given filename, making slashes/backslashes consistent, and lower-casing if mStrict is false.
         /// @note May be called from any thread once the index has been built.
@@ -59,11 +97,19 @@ namespace VFS
         Files::IStreamPtr getNormalized(const std::string& normalizedName) const;
 
     private:
+        /// Find a file by its normalized name, or return nullptr if it isn't in the index.
+        /// @note Does not allocate.
+        File* find(const char* normalizedName, size_t size) const;
+
+        /// Normalize the name and look it up. Names that fit are normalized into a
+        /// stack buffer, so lookups of typical resource paths do not allocate.
+        File* findNormalized(const std::string& name) const;
+
         bool mStrict;
 
         std::vector<Archive*> mArchives;
 
-        std::map<std::string, File*> mIndex;
+        Index mIndex;
     };
 
 }
@@ -298,8 +298,9 @@ int VideoState::queue_picture(AVFrame *pFrame, double pts)
     {
         int w = this->video_ctx->width;
         int h = this->video_ctx->height;
+        // The size is not changed, the filter is only used to upsample chroma, so bilinear is good enough
         this->sws_context = sws_getContext(w, h, this->video_ctx->pix_fmt,
-                                           w, h, AV_PIX_FMT_RGBA, SWS_BICUBIC,
+                                           w, h, AV_PIX_FMT_RGBA, SWS_BILINEAR,
                                            NULL, NULL, NULL);
         if(this->sws_context == NULL)
             throw std::runtime_error("Cannot initialize the conversion context!\n");
@@ -610,6 +611,10 @@ int VideoState::stream_open(int stream_index, AVFormatContext *pFormatCtx)
         av_codec_set_pkt_timebase(this->video_ctx, pFormatCtx->streams[stream_index]->time_base);
 #endif
 
+        // Let the decoder pick the number of threads, high resolution videos are too slow to decode with one
+        this->video_ctx->thread_count = 0;
+        this->video_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
         if (avcodec_open2(this->video_ctx, codec, NULL) < 0)
         {
             fprintf(stderr, "Unsupported codec!\n");
@@ -0,0 +1,49 @@
+#define TERRAIN_HEIGHTMAP @terrainHeightmap
+
+#if TERRAIN_HEIGHTMAP
+// Set by Terrain::ChunkManager for chunks using GPU displacement, the vertex array then holds the grid coordinates of
+// Terrain::BufferCache::getUVBuffer
+uniform bool heightmapEnabled;
+uniform sampler2D heightmap;
+uniform sampler2D heightmapNormals;
+uniform sampler2D heightmapColors;
+// Size of the chunk in world units
+uniform float heightmapChunkSize;
+// Scale and offset from grid coordinates to texel centers
+uniform vec2 heightmapCoordScale;
+
+vec2 getHeightmapCoord()
+{
+    return gl_Vertex.xy * heightmapCoordScale.x + heightmapCoordScale.y;
+}
+#endif
+
+vec4 getHeightmapVertex(vec4 vertex)
+{
+#if TERRAIN_HEIGHTMAP
+    if (heightmapEnabled)
+    {
+        float height = texture2DLod(heightmap, getHeightmapCoord(), 0.0).r;
+        return vec4((gl_Vertex.x - 0.5) * heightmapChunkSize, (0.5 - gl_Vertex.y) * heightmapChunkSize, height, 1.0);
+    }
+#endif
+    return vertex;
+}
+
+vec3 getHeightmapNormal(vec3 normal)
+{
+#if TERRAIN_HEIGHTMAP
+    if (heightmapEnabled)
+        return texture2DLod(heightmapNormals, getHeightmapCoord(), 0.0).xyz * 2.0 - 1.0;
+#endif
+    return normal;
+}
+
+vec4 getHeightmapColor(vec4 color)
+{
+#if TERRAIN_HEIGHTMAP
+    if (heightmapEnabled)
+        return vec4(texture2DLod(heightmapColors, getHeightmapCoord(), 0.0).rgb, 1.0);
+#endif
+    return color;
+}
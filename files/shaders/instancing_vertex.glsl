@@ -0,0 +1,19 @@
+#define OBJECT_INSTANCING @objectInstancing
+
+#if OBJECT_INSTANCING
+// Must match MWRender::ObjectInstancing::sMaxInstances
+#define MAX_INSTANCES 64
+
+uniform bool instancingEnabled;
+// Transforms from instance space to the space of the batch
+uniform mat4 instanceMatrices[MAX_INSTANCES];
+#endif
+
+mat4 getInstanceMatrix()
+{
+#if OBJECT_INSTANCING
+    if (instancingEnabled)
+        return instanceMatrices[gl_InstanceIDARB];
+#endif
+    return mat4(1.0);
+}
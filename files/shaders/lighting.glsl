@@ -2,6 +2,63 @@
 
 uniform int colorMode;
 
+#if @clusteredLighting
+// Must match SceneUtil::LightManager
+#define MAX_CLUSTERED_LIGHTS 256
+#define MAX_CLUSTER_LIGHTS 32
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 8
+#define CLUSTER_GRID_Z 16
+
+uniform sampler2D clusterLightData;
+uniform sampler2D clusterLights;
+uniform mat4 clusterProjection;
+uniform vec2 clusterDepth; // depth of the first slice, slices per logarithmic depth unit
+
+void perClusteredLight(out vec3 ambientOut, out vec3 diffuseOut, float lightIndex, vec3 viewPos, vec3 viewNormal, vec4 diffuse, vec3 ambient)
+{
+    float u = (lightIndex + 0.5) / float(MAX_CLUSTERED_LIGHTS);
+    vec4 position = texture2D(clusterLightData, vec2(u, 0.5 / 3.0));
+    vec4 lightDiffuse = texture2D(clusterLightData, vec2(u, 1.5 / 3.0));
+    vec4 lightAmbient = texture2D(clusterLightData, vec2(u, 2.5 / 3.0));
+
+    vec3 lightDir = position.xyz - viewPos.xyz;
+    float lightDistance = length(lightDir);
+    lightDir = normalize(lightDir);
+    float illumination = clamp(1.0 / (lightDiffuse.w + lightAmbient.w * lightDistance + position.w * lightDistance * lightDistance), 0.0, 1.0);
+
+    ambientOut = ambient * lightAmbient.xyz * illumination;
+    diffuseOut = diffuse.xyz * lightDiffuse.xyz * max(dot(viewNormal.xyz, lightDir), 0.0) * illumination;
+}
+
+vec3 doClusteredLighting(vec3 viewPos, vec3 viewNormal, vec4 diffuse, vec3 ambient)
+{
+    vec3 result = vec3(0.0);
+
+    float slice = floor(log(max(-viewPos.z / clusterDepth.x, 1.0)) * clusterDepth.y);
+    if (slice >= float(CLUSTER_GRID_Z))
+        return result;
+
+    vec4 clip = clusterProjection * vec4(viewPos, 1.0);
+    vec2 tile = floor(clamp(clip.xy / max(clip.w, 1e-6) * 0.5 + 0.5, 0.0, 0.999) * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y));
+    float u = (tile.y * float(CLUSTER_GRID_X) + tile.x + 0.5) / float(CLUSTER_GRID_X * CLUSTER_GRID_Y);
+    float texelHeight = 1.0 / float(CLUSTER_GRID_Z * (MAX_CLUSTER_LIGHTS + 1));
+    float row = slice * float(MAX_CLUSTER_LIGHTS + 1);
+
+    int count = int(texture2D(clusterLights, vec2(u, (row + 0.5) * texelHeight)).r);
+    vec3 diffuseLight, ambientLight;
+    for (int i=0; i<MAX_CLUSTER_LIGHTS; ++i)
+    {
+        if (i >= count)
+            break;
+        float lightIndex = texture2D(clusterLights, vec2(u, (row + float(i) + 1.5) * texelHeight)).r;
+        perClusteredLight(ambientLight, diffuseLight, lightIndex, viewPos, viewNormal, diffuse, ambient);
+        result += ambientLight + diffuseLight;
+    }
+    return result;
+}
+#endif
+
 void perLight(out vec3 ambientOut, out vec3 diffuseOut, int lightIndex, vec3 viewPos, vec3 viewNormal, vec4 diffuse, vec3 ambient)
 {
     vec3 lightDir;
@@ -43,6 +100,16 @@ vec4 doLighting(vec3 viewPos, vec3 viewNormal, vec4 vertexColor, out vec3 shadow
 
     vec3 diffuseLight, ambientLight;
     perLight(ambientLight, diffuseLight, 0, viewPos, viewNormal, diffuse, ambient);
+#if @clusteredLighting
+    // Only the sun is a fixed-function light, point lights are read from the clusters
+#if PER_PIXEL_LIGHTING
+    lightResult.xyz += ambientLight + diffuseLight * shadowing;
+#else
+    shadowDiffuse = diffuseLight;
+    lightResult.xyz += ambientLight;
+#endif
+    lightResult.xyz += doClusteredLighting(viewPos, viewNormal, diffuse, ambient);
+#else
 #if PER_PIXEL_LIGHTING
     lightResult.xyz += diffuseLight * shadowing - diffuseLight; // This light gets added a second time in the loop to fix Mesa users' slowdown, so we need to negate its contribution here.
 #else
@@ -54,6 +121,7 @@ vec4 doLighting(vec3 viewPos, vec3 viewNormal, vec4 vertexColor, out vec3 shadow
         perLight(ambientLight, diffuseLight, i, viewPos, viewNormal, diffuse, ambient);
         lightResult.xyz += ambientLight + diffuseLight;
     }
+#endif
 
     lightResult.xyz += gl_LightModel.ambient.xyz * ambient;
 
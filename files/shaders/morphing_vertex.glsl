@@ -0,0 +1,36 @@
+#define GPU_MORPHING @gpuMorphing
+
+#if GPU_MORPHING
+// Must match SceneUtil::MorphGeometry::sMaxGpuMorphTargets
+#define MAX_MORPH_TARGETS 32
+
+uniform bool morphingEnabled;
+uniform int morphTargetCount;
+uniform float morphWeights[MAX_MORPH_TARGETS];
+// One row of vertex offsets per morph target
+uniform sampler2D morphOffsets;
+uniform vec2 morphOffsetsTexelSize;
+
+// Bound to Shader::ShaderManager::MorphVertexIndexAttribute
+attribute float morphVertexIndex;
+#endif
+
+vec4 getMorphedVertex()
+{
+#if GPU_MORPHING
+    if (morphingEnabled)
+    {
+        vec3 offset = vec3(0.0);
+        float u = (morphVertexIndex + 0.5) * morphOffsetsTexelSize.x;
+        for (int i = 0; i < MAX_MORPH_TARGETS; ++i)
+        {
+            if (i >= morphTargetCount)
+                break;
+            if (morphWeights[i] != 0.0)
+                offset += texture2DLod(morphOffsets, vec2(u, (float(i) + 0.5) * morphOffsetsTexelSize.y), 0.0).xyz * morphWeights[i];
+        }
+        return vec4(gl_Vertex.xyz + offset, gl_Vertex.w);
+    }
+#endif
+    return gl_Vertex;
+}
@@ -42,6 +42,14 @@ uniform sampler2D specularMap;
 varying vec2 specularMapUV;
 #endif
 
+#if @reducedPermutations
+// -1 for unused maps, see Shader::ShaderVisitor::setReducedPermutations
+uniform int darkMapUVSet;
+uniform int detailMapUVSet;
+uniform int decalMapUVSet;
+uniform int emissiveMapUVSet;
+#endif
+
 varying float depth;
 
 #define PER_PIXEL_LIGHTING (@normalMap || @forcePPL)
@@ -102,16 +110,21 @@ void main()
 #endif
 
 #if @detailMap
-    gl_FragData[0].xyz *= texture2D(detailMap, detailMapUV).xyz * 2.0;
+    if (@detailMapUV >= 0)
+        gl_FragData[0].xyz *= texture2D(detailMap, detailMapUV).xyz * 2.0;
 #endif
 
 #if @darkMap
-    gl_FragData[0].xyz *= texture2D(darkMap, darkMapUV).xyz;
+    if (@darkMapUV >= 0)
+        gl_FragData[0].xyz *= texture2D(darkMap, darkMapUV).xyz;
 #endif
 
 #if @decalMap
-    vec4 decalTex = texture2D(decalMap, decalMapUV);
-    gl_FragData[0].xyz = mix(gl_FragData[0].xyz, decalTex.xyz, decalTex.a);
+    if (@decalMapUV >= 0)
+    {
+        vec4 decalTex = texture2D(decalMap, decalMapUV);
+        gl_FragData[0].xyz = mix(gl_FragData[0].xyz, decalTex.xyz, decalTex.a);
+    }
 #endif
 
     float shadowing = unshadowedLightRatio(depth);
@@ -129,7 +142,8 @@ void main()
 #endif
 
 #if @emissiveMap
-    gl_FragData[0].xyz += texture2D(emissiveMap, emissiveMapUV).xyz;
+    if (@emissiveMapUV >= 0)
+        gl_FragData[0].xyz += texture2D(emissiveMap, emissiveMapUV).xyz;
 #endif
 
 
@@ -1,5 +1,9 @@
 #version 120
 
+#if @objectInstancing
+#extension GL_ARB_draw_instanced : require
+#endif
+
 #if @diffuseMap
 varying vec2 diffuseMapUV;
 #endif
@@ -33,6 +37,17 @@ varying vec2 envMapUV;
 varying vec2 specularMapUV;
 #endif
 
+#if @reducedPermutations
+// Texture coordinate sets of the maps, -1 for unused maps, see Shader::ShaderVisitor::setReducedPermutations
+uniform int diffuseMapUVSet;
+uniform int darkMapUVSet;
+uniform int detailMapUVSet;
+uniform int decalMapUVSet;
+uniform int emissiveMapUVSet;
+uniform int normalMapUVSet;
+uniform int specularMapUVSet;
+#endif
+
 varying float depth;
 
 #define PER_PIXEL_LIGHTING (@normalMap || @forcePPL)
@@ -48,16 +63,51 @@ varying vec3 passNormal;
 
 #include "shadows_vertex.glsl"
 
+#include "skinning_vertex.glsl"
+
+#include "morphing_vertex.glsl"
+
+#include "instancing_vertex.glsl"
+
 #include "lighting.glsl"
 
+// Constant sets are folded by the compiler, uniform sets select the attribute at runtime
+vec2 getTexCoord(int set)
+{
+    vec4 texCoord;
+    if (set == 0)
+        texCoord = gl_MultiTexCoord0;
+    else if (set == 1)
+        texCoord = gl_MultiTexCoord1;
+    else if (set == 2)
+        texCoord = gl_MultiTexCoord2;
+    else if (set == 3)
+        texCoord = gl_MultiTexCoord3;
+    else if (set == 4)
+        texCoord = gl_MultiTexCoord4;
+    else if (set == 5)
+        texCoord = gl_MultiTexCoord5;
+    else if (set == 6)
+        texCoord = gl_MultiTexCoord6;
+    else if (set == 7)
+        texCoord = gl_MultiTexCoord7;
+    else
+        return vec2(0.0);
+    return (gl_TextureMatrix[set] * texCoord).xy;
+}
+
 void main(void)
 {
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    mat4 vertexMatrix = getInstanceMatrix() * getSkinningMatrix();
+    vec4 vertex = vertexMatrix * getMorphedVertex();
+    vec3 normal = mat3(vertexMatrix) * gl_Normal;
+
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
     depth = gl_Position.z;
 
-    vec4 viewPos = (gl_ModelViewMatrix * gl_Vertex);
+    vec4 viewPos = (gl_ModelViewMatrix * vertex);
     gl_ClipVertex = viewPos;
-    vec3 viewNormal = normalize((gl_NormalMatrix * gl_Normal).xyz);
+    vec3 viewNormal = normalize((gl_NormalMatrix * normal).xyz);
 
 #if @envMap
     vec3 viewVec = normalize(viewPos.xyz);
@@ -67,32 +117,32 @@ void main(void)
 #endif
 
 #if @diffuseMap
-    diffuseMapUV = (gl_TextureMatrix[@diffuseMapUV] * gl_MultiTexCoord@diffuseMapUV).xy;
+    diffuseMapUV = getTexCoord(@diffuseMapUV);
 #endif
 
 #if @darkMap
-    darkMapUV = (gl_TextureMatrix[@darkMapUV] * gl_MultiTexCoord@darkMapUV).xy;
+    darkMapUV = getTexCoord(@darkMapUV);
 #endif
 
 #if @detailMap
-    detailMapUV = (gl_TextureMatrix[@detailMapUV] * gl_MultiTexCoord@detailMapUV).xy;
+    detailMapUV = getTexCoord(@detailMapUV);
 #endif
 
 #if @decalMap
-    decalMapUV = (gl_TextureMatrix[@decalMapUV] * gl_MultiTexCoord@decalMapUV).xy;
+    decalMapUV = getTexCoord(@decalMapUV);
 #endif
 
 #if @emissiveMap
-    emissiveMapUV = (gl_TextureMatrix[@emissiveMapUV] * gl_MultiTexCoord@emissiveMapUV).xy;
+    emissiveMapUV = getTexCoord(@emissiveMapUV);
 #endif
 
 #if @normalMap
-    normalMapUV = (gl_TextureMatrix[@normalMapUV] * gl_MultiTexCoord@normalMapUV).xy;
-    passTangent = gl_MultiTexCoord7.xyzw;
+    normalMapUV = getTexCoord(@normalMapUV);
+    passTangent = vec4(mat3(vertexMatrix) * gl_MultiTexCoord7.xyz, gl_MultiTexCoord7.w);
 #endif
 
 #if @specularMap
-    specularMapUV = (gl_TextureMatrix[@specularMapUV] * gl_MultiTexCoord@specularMapUV).xy;
+    specularMapUV = getTexCoord(@specularMapUV);
 #endif
 
 #if !PER_PIXEL_LIGHTING
@@ -101,7 +151,7 @@ void main(void)
     passColor = gl_Color;
 #endif
     passViewPos = viewPos.xyz;
-    passNormal = gl_Normal.xyz;
+    passNormal = normal;
 
     setupShadowCoords(viewPos, viewNormal);
 }
@@ -0,0 +1,11 @@
+#version 120
+
+uniform sampler2D diffuseMap;
+
+varying vec2 uv;
+
+void main(void)
+{
+    // Same as the fixed function lighting of the emissive rain material
+    gl_FragData[0] = texture2D(diffuseMap, uv) * vec4(gl_FrontMaterial.emission.rgb, gl_FrontMaterial.diffuse.a);
+}
@@ -0,0 +1,30 @@
+#version 120
+
+// Each raindrop is a quad whose four vertices share the same position in the unit box, its seed.
+// The drops move through a box of rainRange around the camera and wrap around at its sides, so the
+// positions only depend on the accumulated movement in rainOffset and need no state per drop.
+
+uniform vec3 rainRange;
+uniform vec3 rainOffset;
+uniform vec3 rainVelocity;
+
+varying vec2 uv;
+
+void main(void)
+{
+    // Camera relative position of the drop
+    vec3 center = mod(gl_Vertex.xyz * rainRange + rainOffset, rainRange) - rainRange * 0.5;
+
+    vec3 up = normalize(rainVelocity);
+    vec3 side = cross(up, center);
+    float sideLength = length(side);
+    side = sideLength > 0.001 ? side / sideLength : vec3(1.0, 0.0, 0.0);
+
+    // Corner of the quad in [0, 1] and the size of the drop
+    uv = gl_MultiTexCoord0.xy;
+    float size = gl_MultiTexCoord0.z;
+    vec3 position = center + side * ((uv.x - 0.5) * size * 0.1) + up * ((uv.y - 0.5) * size);
+
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 1.0);
+    gl_ClipVertex = gl_ModelViewMatrix * vec4(position, 1.0);
+}
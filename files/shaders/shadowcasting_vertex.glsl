@@ -1,5 +1,9 @@
 #version 120
 
+#if @objectInstancing
+#extension GL_ARB_draw_instanced : require
+#endif
+
 varying vec2 diffuseMapUV;
 
 varying float alphaPassthrough;
@@ -7,11 +11,20 @@ varying float alphaPassthrough;
 uniform int colorMode;
 uniform bool useDiffuseMapForShadowAlpha;
 
+#include "skinning_vertex.glsl"
+
+#include "morphing_vertex.glsl"
+
+#include "instancing_vertex.glsl"
+
+#include "heightmap_vertex.glsl"
+
 void main(void)
 {
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    vec4 vertex = getInstanceMatrix() * getSkinningMatrix() * getHeightmapVertex(getMorphedVertex());
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
 
-    vec4 viewPos = (gl_ModelViewMatrix * gl_Vertex);
+    vec4 viewPos = (gl_ModelViewMatrix * vertex);
     gl_ClipVertex = viewPos;
 
     if (useDiffuseMapForShadowAlpha)
@@ -0,0 +1,30 @@
+#define GPU_SKINNING @gpuSkinning
+
+#if GPU_SKINNING
+// Must match SceneUtil::RigGeometry::sMaxGpuSkinningBones
+#define MAX_SKINNING_BONES 64
+
+uniform bool skinningEnabled;
+uniform mat4 boneMatrices[MAX_SKINNING_BONES];
+
+// Bound to Shader::ShaderManager::BoneIndicesAttribute and BoneWeightsAttribute
+attribute vec4 boneIndices;
+attribute vec4 boneWeights;
+#endif
+
+mat4 getSkinningMatrix()
+{
+#if GPU_SKINNING
+    if (skinningEnabled)
+    {
+        mat4 skinningMatrix = boneMatrices[int(boneIndices.x)] * boneWeights.x
+            + boneMatrices[int(boneIndices.y)] * boneWeights.y
+            + boneMatrices[int(boneIndices.z)] * boneWeights.z
+            + boneMatrices[int(boneIndices.w)] * boneWeights.w;
+        // Weights are not required to sum up to 1, same as for CPU skinning
+        skinningMatrix[3][3] = 1.0;
+        return skinningMatrix;
+    }
+#endif
+    return mat4(1.0);
+}
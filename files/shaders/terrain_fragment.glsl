@@ -12,6 +12,17 @@ uniform sampler2D normalMap;
 uniform sampler2D blendMap;
 #endif
 
+// Further layers of a pass, their weights are in the g, b and a channels of the blendmap
+#if @blendLayers > 1
+uniform sampler2D diffuseMap1;
+#endif
+#if @blendLayers > 2
+uniform sampler2D diffuseMap2;
+#endif
+#if @blendLayers > 3
+uniform sampler2D diffuseMap3;
+#endif
+
 varying float depth;
 
 #define PER_PIXEL_LIGHTING (@normalMap || @forcePPL)
@@ -58,12 +69,29 @@ void main()
     viewNormal = normalize(gl_NormalMatrix * (tbnTranspose * (normalTex.xyz * 2.0 - 1.0)));
 #endif
 
+#if @blendLayers > 1
+    vec2 blendMapUV = (gl_TextureMatrix[1] * vec4(uv, 0.0, 1.0)).xy;
+    vec4 blendWeights = texture2D(blendMap, blendMapUV);
+    vec4 diffuseTex = texture2D(diffuseMap, adjustedUV) * blendWeights.r;
+    diffuseTex += texture2D(diffuseMap1, adjustedUV) * blendWeights.g;
+#if @blendLayers > 2
+    diffuseTex += texture2D(diffuseMap2, adjustedUV) * blendWeights.b;
+#endif
+#if @blendLayers > 3
+    diffuseTex += texture2D(diffuseMap3, adjustedUV) * blendWeights.a;
+#endif
+    // Unused channels are empty. Normalize, so the blending of the pass applies the weights like separate passes would.
+    float blendWeight = dot(blendWeights, vec4(1.0));
+    diffuseTex /= max(blendWeight, 0.001);
+    gl_FragData[0] = vec4(diffuseTex.xyz, blendWeight);
+#else
     vec4 diffuseTex = texture2D(diffuseMap, adjustedUV);
     gl_FragData[0] = vec4(diffuseTex.xyz, 1.0);
 
 #if @blendMap
     vec2 blendMapUV = (gl_TextureMatrix[1] * vec4(uv, 0.0, 1.0)).xy;
     gl_FragData[0].a *= texture2D(blendMap, blendMapUV).a;
+#endif
 #endif
 
     float shadowing = unshadowedLightRatio(depth);
@@ -18,22 +18,28 @@ varying vec3 passNormal;
 
 #include "lighting.glsl"
 
+#include "heightmap_vertex.glsl"
+
 void main(void)
 {
-    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    vec4 vertex = getHeightmapVertex(gl_Vertex);
+    vec3 normal = getHeightmapNormal(gl_Normal);
+    vec4 color = getHeightmapColor(gl_Color);
+
+    gl_Position = gl_ModelViewProjectionMatrix * vertex;
     depth = gl_Position.z;
 
-    vec4 viewPos = (gl_ModelViewMatrix * gl_Vertex);
+    vec4 viewPos = (gl_ModelViewMatrix * vertex);
     gl_ClipVertex = viewPos;
     
-    vec3 viewNormal = normalize((gl_NormalMatrix * gl_Normal).xyz);
+    vec3 viewNormal = normalize((gl_NormalMatrix * normal).xyz);
 
 #if !PER_PIXEL_LIGHTING
-    lighting = doLighting(viewPos.xyz, viewNormal, gl_Color, shadowDiffuseLighting);
+    lighting = doLighting(viewPos.xyz, viewNormal, color, shadowDiffuseLighting);
 #else
-    passColor = gl_Color;
+    passColor = color;
 #endif
-    passNormal = gl_Normal.xyz;
+    passNormal = normal;
     passViewPos = viewPos.xyz;
 
     uv = gl_MultiTexCoord0.xy;
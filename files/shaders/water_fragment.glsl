@@ -142,6 +142,14 @@ uniform vec3 nodePosition;
 
 uniform float rainIntensity;
 
+// x: fraction of the reflection and refraction textures that is rendered to, y: largest coordinate to sample
+uniform vec2 rttScale;
+
+vec2 rttCoords(vec2 coords)
+{
+    return min(coords * rttScale.x, vec2(rttScale.y));
+}
+
 #include "shadows_fragment.glsl"
 
 float frustumDepth;
@@ -205,14 +213,14 @@ void main(void)
 
     vec2 screenCoordsOffset = normal.xy * REFL_BUMP;
 #if REFRACTION
-    float depthSample = linearizeDepth(texture2D(refractionDepthMap,screenCoords).x);
-    float depthSampleDistorted = linearizeDepth(texture2D(refractionDepthMap,screenCoords-screenCoordsOffset).x);
+    float depthSample = linearizeDepth(texture2D(refractionDepthMap,rttCoords(screenCoords)).x);
+    float depthSampleDistorted = linearizeDepth(texture2D(refractionDepthMap,rttCoords(screenCoords-screenCoordsOffset)).x);
     float surfaceDepth = linearizeDepth(gl_FragCoord.z);
     float realWaterDepth = depthSample - surfaceDepth;  // undistorted water depth in view direction, independent of frustum
     screenCoordsOffset *= clamp(realWaterDepth / BUMP_SUPPRESS_DEPTH,0,1);
 #endif
     // reflection
-    vec3 reflection = texture2D(reflectionMap, screenCoords + screenCoordsOffset).rgb;
+    vec3 reflection = texture2D(reflectionMap, rttCoords(screenCoords + screenCoordsOffset)).rgb;
 
     // specular
     float specular = pow(max(dot(reflect(vVec, normal), lVec), 0.0),SPEC_HARDNESS) * shadow;
@@ -221,7 +229,7 @@ void main(void)
 
 #if REFRACTION
     // refraction
-    vec3 refraction = texture2D(refractionMap, screenCoords - screenCoordsOffset).rgb;
+    vec3 refraction = texture2D(refractionMap, rttCoords(screenCoords - screenCoordsOffset)).rgb;
 
     // brighten up the refraction underwater
     if (cameraPos.z < 0.0)